@@ -61,6 +61,22 @@ static WMMtype_Ellipsoid        Ellip;
 static WMMtype_MagneticModel    MagneticModel;
 static float                    decimal_date;
 
+// Main field coefficients moved to timed_date, with the Schmidt quasi-normalisation
+// folded in so WMM_MainField can use Gauss-normalised Legendre functions as they are
+// generated.  Rebuilt by WMM_TimeAdjustCoeffs only when the date changes.
+static float                    timed_g[NUMTERMS];
+static float                    timed_h[NUMTERMS];
+static float                    timed_date;
+
+static void WMM_TimeAdjustCoeffs();
+static int WMM_MainField(WMMtype_CoordSpherical * CoordSpherical, WMMtype_CoordGeodetic * CoordGeodetic, WMMtype_MagneticResults * MagneticResultsGeo);
+static void WMM_LocalOffset(const WMMtype_LocalField * Local, float Lat, float Lon, float AltEllipsoid, float NED[3]);
+
+// Called on every evaluation of the full model; the unit test counts them
+#ifndef WMM_COUNT_EVALUATION
+#define WMM_COUNT_EVALUATION()
+#endif
+
 /**************************************************************************************
 *   Example use - very simple - only two exposed functions
 *
@@ -70,6 +86,13 @@ static float                    decimal_date;
 *	e.g. Iceland in may of 2012 = WMM_GetMagVector(65.0, -20.0, 0.0, 5, 5, 2012, B);
 *	Alt is above the WGS-84 Ellipsoid
 *	B is the NED (XYZ) magnetic vector in nTesla
+*
+*	To follow the field as the vehicle travels, linearise it about a point once
+*
+*	WMM_InitLocalField(&Local, Lat, Lon, Alt, Month, Day, Year, Radius);
+*
+*	and then WMM_GetLocalMagVector(&Local, Lat, Lon, Alt, B) is a few multiplies
+*	while within Radius metres of that point, and moves the point when not.
 **************************************************************************************/
 
 int WMM_Initialize()
@@ -114,7 +137,7 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
 
     WMMtype_CoordSpherical CoordSpherical;
     WMMtype_CoordGeodetic CoordGeodetic;
-    WMMtype_GeoMagneticElements GeoMagneticElements;
+    WMMtype_MagneticResults MagneticResultsGeo;
 
 
     // ***********
@@ -145,14 +168,14 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
 
     if (returned >= 0)
     {
-        // Compute the geoMagnetic field elements and their time change
-        if (WMM_Geomag(&CoordSpherical, &CoordGeodetic, &GeoMagneticElements) < 0)
+        // Compute the main field, the time change of it isn't returned
+        if (WMM_MainField(&CoordSpherical, &CoordGeodetic, &MagneticResultsGeo) < 0)
             returned = -9;  // error
         else
         {   // set the returned values
-		B[0] = GeoMagneticElements.X * 1e-2f;
-		B[1] = GeoMagneticElements.Y * 1e-2f;
-		B[2] = GeoMagneticElements.Z * 1e-2f;
+		B[0] = MagneticResultsGeo.Bx * 1e-2f;
+		B[1] = MagneticResultsGeo.By * 1e-2f;
+		B[2] = MagneticResultsGeo.Bz * 1e-2f;
         }
     }
 
@@ -160,6 +183,345 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
     return returned;
 }
 
+int WMM_InitLocalField(WMMtype_LocalField * Local, float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float Radius)
+   /*
+      Linearises the main field about a point, for WMM_GetLocalMagVector to use within
+      Radius metres of it.  The gradient is the central difference of the full model
+      Radius away along north, east and down.  Those samples and one diagonal sample for
+      each pair of axes give the second derivatives, from which ErrorBound is how far
+      the linear field can be from the full model inside Radius, for a field that is
+      quadratic over that distance.  Over the tens of km this is meant for the higher
+      order terms are smaller again by about Radius / earth radius.
+
+      Within Radius of the poles, where a step north would go over the top, nothing is
+      linearised and WMM_GetLocalMagVector evaluates the full model each time instead.
+
+      Local is only changed if everything succeeds.
+
+      OUTPUT : Local
+      RETURNS : 0 if OK, < 0 from WMM_GetMagVector on error
+   */
+{
+    // Sample directions: +-north, +-east, +-down, then north-east, north-down, east-down
+#define S 0.70710678f
+    static const float Dir[9][3] = {
+        {  1.0f,  0.0f,  0.0f }, { -1.0f,  0.0f,  0.0f },
+        {  0.0f,  1.0f,  0.0f }, {  0.0f, -1.0f,  0.0f },
+        {  0.0f,  0.0f,  1.0f }, {  0.0f,  0.0f, -1.0f },
+        { S, S, 0.0f },
+        { S, 0.0f, S },
+        { 0.0f, S, S },
+    };
+#undef S
+    static const uint8_t DiagAxes[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+
+    WMMtype_LocalField Field;
+    float Sample[9][3];
+    float Hessian[3];   // second derivatives along each axis, one component at a time
+    float Offset, Mixed, Frobenius2, ErrorSq = 0, Magnitude = 0;
+    int returned;
+    uint16_t i, j, c;
+
+    memset(&Field, 0, sizeof(Field));
+
+    Field.Lat = Lat;
+    Field.Lon = Lon;
+    Field.AltEllipsoid = AltEllipsoid;
+    Field.Month = Month;
+    Field.Day = Day;
+    Field.Year = Year;
+    Field.Radius = Radius;
+
+    // Metres per degree, on a sphere, as WMM_LocalOffset measures displacements
+    Field.Scale[0] = (WGS84_RADIUS_EARTH_KM * 1000.0f + AltEllipsoid) * DEG2RAD;
+    Field.Scale[1] = Field.Scale[0] * cosf(Lat * DEG2RAD);
+
+    returned = WMM_GetMagVector(Lat, Lon, AltEllipsoid, Month, Day, Year, Field.B);
+    if (returned < 0)
+        return returned;
+
+    if (Radius > 0 && fabsf(Lat) + Radius / Field.Scale[0] < 90.0f)
+    {
+        for (i = 0; i < 9; i++)
+        {
+            float SampleLon = Lon + Dir[i][1] * Radius / Field.Scale[1];
+
+            if (SampleLon > 180)
+                SampleLon -= 360;
+            else if (SampleLon < -180)
+                SampleLon += 360;
+
+            returned = WMM_GetMagVector(Lat + Dir[i][0] * Radius / Field.Scale[0], SampleLon,
+                                        AltEllipsoid - Dir[i][2] * Radius, Month, Day, Year, Sample[i]);
+            if (returned < 0)
+                return returned;
+        }
+
+        for (c = 0; c < 3; c++)
+        {
+            Frobenius2 = 0;
+
+            for (j = 0; j < 3; j++)
+            {
+                Field.dB[c][j] = (Sample[2 * j][c] - Sample[2 * j + 1][c]) / (2 * Radius);
+                Hessian[j] = (Sample[2 * j][c] + Sample[2 * j + 1][c] - 2 * Field.B[c]) / (Radius * Radius);
+                Frobenius2 += Hessian[j] * Hessian[j];
+            }
+
+            // The diagonal sample is half of each axis' curvature plus the mixed term
+            for (j = 0; j < 3; j++)
+            {
+                const uint8_t a = DiagAxes[j][0];
+                const uint8_t b = DiagAxes[j][1];
+
+                Offset = Sample[6 + j][c] - Field.B[c] -
+                    Radius * Dir[6 + j][a] * (Field.dB[c][a] + Field.dB[c][b]);
+                Mixed = 2 * Offset / (Radius * Radius) - 0.5f * (Hessian[a] + Hessian[b]);
+                Frobenius2 += 2 * Mixed * Mixed;
+            }
+
+            ErrorSq += Frobenius2;
+            Magnitude += Field.B[c] * Field.B[c];
+        }
+
+        // Largest |d' H d| / 2 for |d| <= Radius, using the Frobenius norm as a bound on
+        // the largest eigenvalue, plus the single precision noise of the samples
+        // themselves, which is what the curvature estimate is made of at short range.
+        Field.ErrorBound = 0.5f * Radius * Radius * sqrtf(ErrorSq) + 1e-5f * sqrtf(Magnitude);
+        Field.Linearised = true;
+    }
+
+    *Local = Field;
+
+    return 0;   // OK
+}
+
+int WMM_GetLocalMagVector(WMMtype_LocalField * Local, float Lat, float Lon, float AltEllipsoid, float B[3])
+   /*
+      Field at a point from the linearisation made by WMM_InitLocalField, when the point
+      is within Local->Radius of it.  Farther away the field is linearised about the new
+      point, for the same date and radius, and its full model value returned.
+
+      RETURNS : 0 for a linearised value, 1 for a full evaluation, < 0 from
+      WMM_InitLocalField or WMM_GetMagVector on error
+   */
+{
+    float NED[3];
+    int returned;
+    uint16_t c;
+
+    WMM_LocalOffset(Local, Lat, Lon, AltEllipsoid, NED);
+
+    if (NED[0] * NED[0] + NED[1] * NED[1] + NED[2] * NED[2] > Local->Radius * Local->Radius)
+    {
+        returned = WMM_InitLocalField(Local, Lat, Lon, AltEllipsoid, Local->Month, Local->Day, Local->Year, Local->Radius);
+        if (returned < 0)
+            return returned;
+
+        memcpy(B, Local->B, sizeof(Local->B));
+
+        return 1;
+    }
+
+    if (!Local->Linearised)
+    {
+        returned = WMM_GetMagVector(Lat, Lon, AltEllipsoid, Local->Month, Local->Day, Local->Year, B);
+        if (returned < 0)
+            return returned;
+
+        return 1;
+    }
+
+    for (c = 0; c < 3; c++)
+        B[c] = Local->B[c] + Local->dB[c][0] * NED[0] + Local->dB[c][1] * NED[1] + Local->dB[c][2] * NED[2];
+
+    return 0;
+}
+
+int WMM_GetLinearMagVector(const WMMtype_LocalField * Local, float Lat, float Lon, float AltEllipsoid, float B[3])
+   /*
+      Field at a point from the linearisation made by WMM_InitLocalField, extrapolated
+      if the point is past Local->Radius, and never evaluating the full model, so it is
+      cheap enough for a fast loop to call every time.  The caller linearises afresh
+      somewhere less pressed for time when this returns 1.  Where nothing was
+      linearised B is the field at the reference.
+
+      RETURNS : 0 within Local->Radius, 1 beyond it
+   */
+{
+    float NED[3];
+    uint16_t c;
+
+    WMM_LocalOffset(Local, Lat, Lon, AltEllipsoid, NED);
+
+    for (c = 0; c < 3; c++)
+        B[c] = Local->B[c] + Local->dB[c][0] * NED[0] + Local->dB[c][1] * NED[1] + Local->dB[c][2] * NED[2];
+
+    if (NED[0] * NED[0] + NED[1] * NED[1] + NED[2] * NED[2] > Local->Radius * Local->Radius)
+        return 1;
+
+    return 0;
+}
+
+static void WMM_LocalOffset(const WMMtype_LocalField * Local, float Lat, float Lon, float AltEllipsoid, float NED[3])
+// North, east and down metres from the reference of a linearised field
+{
+	float dLon = Lon - Local->Lon;
+
+	if (dLon > 180)
+		dLon -= 360;
+	else if (dLon < -180)
+		dLon += 360;
+
+	NED[0] = (Lat - Local->Lat) * Local->Scale[0];
+	NED[1] = dLon * Local->Scale[1];
+	NED[2] = Local->AltEllipsoid - AltEllipsoid;
+}
+
+static int WMM_MainField(WMMtype_CoordSpherical * CoordSpherical, WMMtype_CoordGeodetic * CoordGeodetic, WMMtype_MagneticResults * MagneticResultsGeo)
+   /*
+      Computes the main field at a single point, as WMM_Geomag does but without the
+      secular variation.  The Gauss-normalised associated Legendre functions are
+      generated one order at a time alongside the summation, with the same recursion
+      as WMM_PcupLow, rather than into tables first, and the coefficients come from
+      the time adjusted table.  The geographic poles go through WMM_Geomag for the
+      special By summation there.
+
+      INPUT : CoordSpherical
+      CoordGeodetic
+      OUTPUT : MagneticResultsGeo
+
+      CALLS : WMM_TimeAdjustCoeffs
+      WMM_ComputeSphericalHarmonicVariables
+      WMM_RotateMagneticVector
+   */
+{
+	WMMtype_SphericalHarmonicVariables SphVariables;
+	WMMtype_MagneticResults MagneticResultsSph;
+	uint16_t m, n, index;
+	float x, z, k, cos_phi, rr, gc, gs;
+	float pmm, dpmm;		/* P(m,m) and its derivative */
+	float p, dp, p1, dp1, p2, dp2;	/* P(n,m), P(n-1,m), P(n-2,m) and derivatives */
+
+	WMM_COUNT_EVALUATION();
+
+	cos_phi = cosf(CoordSpherical->phig * DEG2RAD);
+	if (fabsf(cos_phi) <= 1.0e-10f)
+	{
+		WMMtype_GeoMagneticElements GeoMagneticElements;
+
+		if (WMM_Geomag(CoordSpherical, CoordGeodetic, &GeoMagneticElements) < 0)
+			return -1;  // error
+
+		MagneticResultsGeo->Bx = GeoMagneticElements.X;
+		MagneticResultsGeo->By = GeoMagneticElements.Y;
+		MagneticResultsGeo->Bz = GeoMagneticElements.Z;
+
+		return 0;   // OK
+	}
+
+	WMM_TimeAdjustCoeffs();
+
+	if (WMM_ComputeSphericalHarmonicVariables(CoordSpherical, MagneticModel.nMax, &SphVariables) < 0)
+		return -2;  // error
+
+	/* sin and cos of the geocentric latitude */
+	x = sinf(CoordSpherical->phig * DEG2RAD);
+	z = sqrtf((1.0f - x) * (1.0f + x));
+
+	MagneticResultsSph.Bz = 0.0;
+	MagneticResultsSph.By = 0.0;
+	MagneticResultsSph.Bx = 0.0;
+
+	pmm = 1.0;
+	dpmm = 0.0;
+
+	for (m = 0; m <= MagneticModel.nMax; m++)
+	{
+		if (m > 0)
+		{
+			dpmm = z * dpmm + x * pmm;
+			pmm = z * pmm;
+		}
+
+		p1 = pmm;
+		dp1 = dpmm;
+		p2 = 0.0;
+		dp2 = 0.0;
+
+		for (n = m; n <= MagneticModel.nMax; n++)
+		{
+			if (n > m)
+			{
+				k = 0.0;
+				if (n > m + 1)
+					k = (float)(((n - 1) * (n - 1)) - (m * m)) / (float)((2 * n - 1) * (2 * n - 3));
+
+				p = x * p1 - k * p2;
+				dp = x * dp1 - z * p1 - k * dp2;
+				p2 = p1;
+				dp2 = dp1;
+				p1 = p;
+				dp1 = dp;
+			}
+
+			if (n == 0)
+				continue;
+
+			index = (n * (n + 1) / 2 + m);
+			rr = SphVariables.RelativeRadiusPower[n];
+			gc = timed_g[index] * SphVariables.cos_mlambda[m] + timed_h[index] * SphVariables.sin_mlambda[m];
+			gs = timed_g[index] * SphVariables.sin_mlambda[m] - timed_h[index] * SphVariables.cos_mlambda[m];
+
+			/* Equations 10-12 in the WMM Technical report, as in WMM_Summation.  The
+			   derivative here is with respect to co-latitude, hence the sign of Bx. */
+			MagneticResultsSph.Bz -= rr * gc * (float)(n + 1) * p1;
+			MagneticResultsSph.By += rr * gs * (float)(m) * p1;
+			MagneticResultsSph.Bx += rr * gc * dp1;
+		}
+	}
+
+	MagneticResultsSph.By = MagneticResultsSph.By / cos_phi;
+
+	return WMM_RotateMagneticVector(CoordSpherical, CoordGeodetic, &MagneticResultsSph, MagneticResultsGeo);
+}
+
+static void WMM_TimeAdjustCoeffs()
+   /*
+      Fills timed_g and timed_h with the main field coefficients at decimal_date, times
+      the ratio between the Schmidt quasi-normalised and Gauss-normalised Legendre
+      functions, sqrt((m==0?1:2)*(n-m)!/(n+m!))*(2n-1)!!/(n-m)!, as WMM_PcupLow works
+      it out.  Does nothing if the date hasn't changed.
+   */
+{
+	uint16_t m, n, index;
+	float dt, norm, norm_m;
+
+	if (decimal_date == timed_date)
+		return;
+
+	dt = decimal_date - MagneticModel.epoch;
+
+	norm = 1.0;
+	for (n = 1; n <= MagneticModel.nMax; n++)
+	{
+		norm = norm * (float)(2 * n - 1) / (float)n;
+		norm_m = norm;
+
+		for (m = 0; m <= n; m++)
+		{
+			if (m > 0)
+				norm_m = norm_m * sqrtf((float)((n - m + 1) * (m == 1 ? 2 : 1)) / (float)(n + m));
+
+			index = (n * (n + 1) / 2 + m);
+			timed_g[index] = (CoeffFile[index][2] + dt * CoeffFile[index][4]) * norm_m;
+			timed_h[index] = (CoeffFile[index][3] + dt * CoeffFile[index][5]) * norm_m;
+		}
+	}
+
+	timed_date = decimal_date;
+}
+
 int WMM_Geomag(WMMtype_CoordSpherical * CoordSpherical, WMMtype_CoordGeodetic * CoordGeodetic, WMMtype_GeoMagneticElements * GeoMagneticElements)
    /*
       The main subroutine that calls a sequence of WMM sub-functions to calculate the magnetic field elements for a single point.
@@ -1008,66 +1370,25 @@ int WMM_SecVarSummationSpecial(WMMtype_SphericalHarmonicVariables *
 }
 
 /**
- * @brief Comput the MainFieldCoeffH accounting for the date
+ * @brief Compute the MainFieldCoeffG accounting for the date
  */
 float WMM_get_main_field_coeff_g(uint16_t index) 
 {	
 	if (index >= NUMTERMS)
 		return 0;
 
-    uint16_t n, m, sum_index, a, b;
-
-    float coeff = CoeffFile[index][2];
-	
-	a = MagneticModel.nMaxSecVar;
-	b = (a * (a + 1) / 2 + a);
-	for (n = 1; n <= MagneticModel.nMax; n++)
-	{
-		for (m = 0; m <= n; m++)
-		{
-			
-			sum_index = (n * (n + 1) / 2 + m);
-			
-			/* Hacky for now, will solve for which conditions need summing analytically */
-			if (sum_index != index)
-				continue;
-			
-			if (index <= b) 
-				coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_g(sum_index);
-			
-		}
-	}
-	
-	return coeff;
+	return CoeffFile[index][2] + (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_g(index);
 }
 
+/**
+ * @brief Compute the MainFieldCoeffH accounting for the date
+ */
 float WMM_get_main_field_coeff_h(uint16_t index) 
 {	
 	if (index >= NUMTERMS)
 		return 0;
-	
-    uint16_t n, m, sum_index, a, b;
-	float coeff = CoeffFile[index][3];
-	
-	a = MagneticModel.nMaxSecVar;
-	b = (a * (a + 1) / 2 + a);
-	for (n = 1; n <= MagneticModel.nMax; n++)
-	{
-		for (m = 0; m <= n; m++)
-		{
-			
-			sum_index = (n * (n + 1) / 2 + m);
-			
-			/* Hacky for now, will solve for which conditions need summing analytically */
-			if (sum_index != index)
-				continue;
-			
-			if (index <= b) 
-				coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_h(sum_index);
-		}
-	}
-	
-	return coeff;	
+
+	return CoeffFile[index][3] + (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_h(index);
 }
 
 float WMM_get_secular_var_coeff_g(uint16_t index) 
@@ -6,7 +6,7 @@
  * @file       alarms.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2010.
  * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
- * @author     dRonin, http://dronin.org Copyright (C) 2015-2016
+ * @author     dRonin, http://dronin.org Copyright (C) 2015-2017
  * @brief      Library for setting and clearing system alarms
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -32,7 +32,6 @@
 
 #include "openpilot.h"
 #include "alarms.h"
-#include "pios_mutex.h"
 #include "pios_reset.h"
 
 // Private constants
@@ -40,7 +39,24 @@
 // Private types
 
 // Private variables
-static struct pios_mutex *lock;
+
+/*
+ * Alarms are set from fast loops, so the severities are kept here and only
+ * copied into SystemAlarms by AlarmsPublish.  Setting one is a compare and
+ * swap; nothing takes a lock or touches the object manager.
+ */
+static uint8_t severities[SYSTEMALARMS_ALARM_NUMELEM];
+
+//! Number of alarms at each severity
+static int32_t severity_counts[SYSTEMALARMS_ALARM_GLOBAL_MAXOPTVAL + 1] = {
+	[SYSTEMALARMS_ALARM_UNINITIALISED] = SYSTEMALARMS_ALARM_NUMELEM,
+};
+
+//! Alarms changed since SystemAlarms was last published, one bit each
+static uint32_t dirty;
+
+DONT_BUILD_IF(SYSTEMALARMS_ALARM_NUMELEM > sizeof(dirty) * 8, AlarmDirtyBitsOverflow);
+DONT_BUILD_IF(SYSTEMALARMS_ALARM_UNINITIALISED != 0, AlarmSeverityDefaultNotZero);
 
 // Private functions
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity);
@@ -51,8 +67,6 @@ static int32_t hasSeverity(SystemAlarmsAlarmOptions severity);
 int32_t AlarmsInitialize(void)
 {
 	SystemAlarmsInitialize();
-	lock = PIOS_Mutex_Create();
-	PIOS_Assert(lock != NULL);
 
 	uint8_t reboot_reason = SYSTEMALARMS_REBOOTCAUSE_UNDEFINED;
 
@@ -89,36 +103,39 @@ int32_t AlarmsInitialize(void)
 }
 
 /**
- * Set an alarm
+ * Set an alarm.  Safe from any task or interrupt; SystemAlarms catches up
+ * at the next AlarmsPublish.
  * @param alarm The system alarm to be modified
  * @param severity The alarm severity
  * @return 0 if success, -1 if an error
  */
 int32_t AlarmsSet(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity)
 {
-	SystemAlarmsData alarms;
-
 	// Check that this is a valid alarm
-	if (alarm >= SYSTEMALARMS_ALARM_NUMELEM)
+	if (alarm >= SYSTEMALARMS_ALARM_NUMELEM ||
+			severity > SYSTEMALARMS_ALARM_GLOBAL_MAXOPTVAL)
 	{
 		return -1;
 	}
 
-	// Lock
-	PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
+	uint8_t old = __atomic_load_n(&severities[alarm], __ATOMIC_RELAXED);
 
-    // Read alarm and update its severity only if it was changed
-    SystemAlarmsGet(&alarms);
-    if ( alarms.Alarm[alarm] != severity )
-    {
-    	alarms.Alarm[alarm] = severity;
-    	SystemAlarmsSet(&alarms);
-    }
+	// Update its severity only if it was changed
+	do {
+		if (old == severity) {
+			return 0;
+		}
+	} while (!__atomic_compare_exchange_n(&severities[alarm], &old,
+				severity, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	/* Racing setters of one alarm can leave a count briefly off by one,
+	 * never for good */
+	__atomic_fetch_sub(&severity_counts[old], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&severity_counts[severity], 1, __ATOMIC_RELAXED);
 
-    // Release lock
-    PIOS_Mutex_Unlock(lock);
-    return 0;
+	__atomic_fetch_or(&dirty, 1u << alarm, __ATOMIC_RELEASE);
 
+	return 0;
 }
 
 /**
@@ -128,17 +145,33 @@ int32_t AlarmsSet(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity
  */
 SystemAlarmsAlarmOptions AlarmsGet(SystemAlarmsAlarmElem alarm)
 {
-	SystemAlarmsData alarms;
-
 	// Check that this is a valid alarm
 	if (alarm >= SYSTEMALARMS_ALARM_NUMELEM)
 	{
 		return 0;
 	}
 
-    // Read alarm
-    SystemAlarmsGet(&alarms);
-    return alarms.Alarm[alarm];
+	return __atomic_load_n(&severities[alarm], __ATOMIC_RELAXED);
+}
+
+/**
+ * Copy the alarms into SystemAlarms if any changed since the last time.
+ * The system module calls this periodically, which bounds how often
+ * SystemAlarms updates however often the alarms flap.
+ */
+void AlarmsPublish(void)
+{
+	if (!__atomic_exchange_n(&dirty, 0, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	uint8_t alarms[SYSTEMALARMS_ALARM_NUMELEM];
+
+	for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n) {
+		alarms[n] = __atomic_load_n(&severities[n], __ATOMIC_RELAXED);
+	}
+
+	SystemAlarmsAlarmSet(alarms);
 }
 
 /**
@@ -218,28 +251,15 @@ int32_t AlarmsHasCritical()
  */
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity)
 {
-	SystemAlarmsData alarms;
-	uint32_t n;
-
-	// Lock
-	PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t count = 0;
 
-    // Read alarms
-    SystemAlarmsGet(&alarms);
-
-    // Go through alarms and check if any are of the given severity or higher
-    for (n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n)
-    {
-    	if ( alarms.Alarm[n] >= severity)
-    	{
-    		PIOS_Mutex_Unlock(lock);
-    		return 1;
-    	}
-    }
+	// Count the alarms of the given severity or higher
+	for (uint32_t n = severity; n <= SYSTEMALARMS_ALARM_GLOBAL_MAXOPTVAL; ++n)
+	{
+		count += __atomic_load_n(&severity_counts[n], __ATOMIC_RELAXED);
+	}
 
-    // If this point is reached then no alarms found
-	PIOS_Mutex_Unlock(lock);
-    return 0;
+	return count > 0;
 }
 
 static const char alarm_names[][10] = {
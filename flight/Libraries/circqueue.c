@@ -65,6 +65,13 @@ circ_queue_t circ_queue_new(uint16_t elem_size, uint16_t num_elem) {
 	return ret;
 }
 
+/** Free a circular queue.  Nothing may be using it any longer.
+ * @param[in] q Handle to circular queue.
+ */
+void circ_queue_delete(circ_queue_t q) {
+	PIOS_free(q);
+}
+
 /** Get a pointer to the current queue write position.
  * This position is unavailable to the reader and may be filled in
  * with the desired data without respect to any synchronization.
@@ -0,0 +1,227 @@
+/**
+ ******************************************************************************
+ * @file       deadlineheap.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief Binary heap of periodic deadlines, for the event dispatcher
+ *
+ * Finding the next due event is constant time, and dispatching one or
+ * changing its period is logarithmic in the number of events.  The caller
+ * provides the locking.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include <pios.h>
+#include <deadlineheap.h>
+
+static inline struct deadline_entry **heap_slot(struct deadline_heap *heap,
+		uint16_t idx)
+{
+	return &heap->blocks[idx >> DEADLINE_HEAP_BLOCK_SHIFT]
+		[idx & (DEADLINE_HEAP_BLOCK_LEN - 1)];
+}
+
+/**
+ * Heap order: earliest deadline first, disabled entries (period 0) last.
+ * Deadlines are compared as a difference so the systime wrap is harmless.
+ */
+static inline bool due_before(const struct deadline_entry *a,
+		const struct deadline_entry *b)
+{
+	if (a->period_ms == 0)
+		return false;
+	if (b->period_ms == 0)
+		return true;
+
+	return (int32_t)(a->next_ms - b->next_ms) < 0;
+}
+
+static inline void heap_place(struct deadline_heap *heap, uint16_t idx,
+		struct deadline_entry *entry)
+{
+	*heap_slot(heap, idx) = entry;
+	entry->heap_index = idx;
+}
+
+static void heap_sift_up(struct deadline_heap *heap, uint16_t idx)
+{
+	struct deadline_entry *entry = *heap_slot(heap, idx);
+
+	while (idx > 0) {
+		uint16_t parent = (idx - 1) / 2;
+		struct deadline_entry *parent_entry = *heap_slot(heap, parent);
+
+		if (!due_before(entry, parent_entry))
+			break;
+
+		heap_place(heap, idx, parent_entry);
+		idx = parent;
+	}
+
+	heap_place(heap, idx, entry);
+}
+
+static void heap_sift_down(struct deadline_heap *heap, uint16_t idx)
+{
+	struct deadline_entry *entry = *heap_slot(heap, idx);
+
+	while (true) {
+		uint16_t child = 2 * idx + 1;
+
+		if (child >= heap->len)
+			break;
+
+		struct deadline_entry *child_entry = *heap_slot(heap, child);
+
+		if (child + 1 < heap->len &&
+				due_before(*heap_slot(heap, child + 1), child_entry)) {
+			child++;
+			child_entry = *heap_slot(heap, child);
+		}
+
+		if (!due_before(child_entry, entry))
+			break;
+
+		heap_place(heap, idx, child_entry);
+		idx = child;
+	}
+
+	heap_place(heap, idx, entry);
+}
+
+/**
+ * @brief Schedule the next deadline of an entry after its period changed
+ *
+ * Deadlines fall on multiples of the period plus a phase.  The phase is
+ * a fraction of the period taken from the golden ratio sequence, by the
+ * order entries were added.  Entries added one after the other are spread
+ * evenly over the period, and the same entries always get the same ticks.
+ *
+ * @param[in] heap The heap holding the entry
+ * @param[in] entry The entry, with its new period_ms set
+ * @param[in] now The current system time
+ */
+void deadline_heap_reschedule(struct deadline_heap *heap,
+		struct deadline_entry *entry, uint32_t now)
+{
+	uint16_t period_ms = entry->period_ms;
+
+	if (period_ms > 0) {
+		uint32_t fraction = entry->phase_seq * 2654435769u;
+		uint32_t phase = ((uint64_t) fraction * period_ms) >> 32;
+
+		entry->next_ms = now - now % period_ms + phase;
+
+		if ((int32_t)(entry->next_ms - now) <= 0)
+			entry->next_ms += period_ms;
+	}
+
+	heap_sift_up(heap, entry->heap_index);
+	heap_sift_down(heap, entry->heap_index);
+}
+
+/**
+ * @brief Add an entry and schedule its first deadline
+ * @param[in] heap The heap
+ * @param[in] entry The entry, with period_ms set
+ * @param[in] now The current system time
+ * @returns 0 on success, -1 if the heap is full or out of memory
+ */
+int deadline_heap_add(struct deadline_heap *heap,
+		struct deadline_entry *entry, uint32_t now)
+{
+	uint16_t block = heap->len >> DEADLINE_HEAP_BLOCK_SHIFT;
+
+	if (block >= DEADLINE_HEAP_MAX_BLOCKS)
+		return -1;
+
+	if (heap->blocks[block] == NULL) {
+		heap->blocks[block] = PIOS_malloc_no_dma(
+				DEADLINE_HEAP_BLOCK_LEN * sizeof(*heap->blocks[block]));
+
+		if (heap->blocks[block] == NULL)
+			return -1;
+	}
+
+	entry->phase_seq = heap->len;
+	entry->next_ms = 0;
+
+	heap_place(heap, heap->len++, entry);
+	deadline_heap_reschedule(heap, entry, now);
+
+	return 0;
+}
+
+/**
+ * @brief Take the earliest entry if it's due, and schedule its next deadline
+ *
+ * The phase is kept, so periods missed entirely are skipped rather than
+ * dispatched late one after the other.
+ *
+ * @param[in] heap The heap
+ * @param[in] now The current system time
+ * @param[out] lateness_ms How long past the deadline it is
+ * @param[out] missed Whole periods skipped
+ * @returns The entry, or NULL if none is due
+ */
+struct deadline_entry *deadline_heap_pop_due(struct deadline_heap *heap,
+		uint32_t now, uint32_t *lateness_ms, uint32_t *missed)
+{
+	if (heap->len == 0)
+		return NULL;
+
+	struct deadline_entry *entry = *heap_slot(heap, 0);
+
+	if (entry->period_ms == 0 || (int32_t)(now - entry->next_ms) < 0)
+		return NULL;
+
+	*lateness_ms = now - entry->next_ms;
+	*missed = *lateness_ms / entry->period_ms;
+
+	entry->next_ms += (*missed + 1) * entry->period_ms;
+	heap_sift_down(heap, 0);
+
+	return entry;
+}
+
+/**
+ * @brief Time until the earliest deadline
+ * @param[in] heap The heap
+ * @param[in] now The current system time
+ * @param[in] max_ms Most to return, including when nothing is scheduled
+ * @returns Milliseconds, 0 if something is already due
+ */
+uint32_t deadline_heap_time_to_next(const struct deadline_heap *heap,
+		uint32_t now, uint32_t max_ms)
+{
+	if (heap->len == 0)
+		return max_ms;
+
+	const struct deadline_entry *entry = deadline_heap_at(heap, 0);
+
+	if (entry->period_ms == 0)
+		return max_ms;
+
+	int32_t until_next = entry->next_ms - now;
+
+	if (until_next < 0)
+		return 0;
+
+	return ((uint32_t) until_next < max_ms) ? (uint32_t) until_next : max_ms;
+}
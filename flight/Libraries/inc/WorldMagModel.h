@@ -28,9 +28,31 @@
 #ifndef WORLDMAGMODEL_H_
 #define WORLDMAGMODEL_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
+	// Field linearised about a reference point, see WMM_InitLocalField()
+typedef struct {
+	float Lat;		// reference latitude (deg)
+	float Lon;		// reference longitude (deg)
+	float AltEllipsoid;	// reference altitude (m)
+	float Scale[2];		// metres per degree of latitude and of longitude there
+	float B[3];		// NED field at the reference, as from WMM_GetMagVector()
+	float dB[3][3];		// change in each component of B per metre north, east and down
+	float Radius;		// distance (m) from the reference the linear field is used within
+	float ErrorBound;	// furthest the linear field can be from the full model within Radius
+	uint16_t Month;		// date the field is for
+	uint16_t Day;
+	uint16_t Year;
+	bool Linearised;	// false near the poles, where the full model is used throughout
+} WMMtype_LocalField;
+
 	//  Exposed Function Prototypes
 int WMM_Initialize();
 int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3]);
+int WMM_InitLocalField(WMMtype_LocalField * Local, float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float Radius);
+int WMM_GetLocalMagVector(WMMtype_LocalField * Local, float Lat, float Lon, float AltEllipsoid, float B[3]);
+int WMM_GetLinearMagVector(const WMMtype_LocalField * Local, float Lat, float Lon, float AltEllipsoid, float B[3]);
 
 #endif /* WORLDMAGMODEL_H_ */
 
@@ -33,6 +33,7 @@
 int32_t AlarmsInitialize(void);
 int32_t AlarmsSet(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity);
 SystemAlarmsAlarmOptions AlarmsGet(SystemAlarmsAlarmElem alarm);
+void AlarmsPublish(void);
 int32_t AlarmsDefault(SystemAlarmsAlarmElem alarm);
 void AlarmsDefaultAll();
 int32_t AlarmsClear(SystemAlarmsAlarmElem alarm);
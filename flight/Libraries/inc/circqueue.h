@@ -33,6 +33,8 @@ typedef struct circ_queue *circ_queue_t;
 
 circ_queue_t circ_queue_new(uint16_t elem_size, uint16_t num_elem);
 
+void circ_queue_delete(circ_queue_t q);
+
 void *circ_queue_write_pos(circ_queue_t q, uint16_t *contig,
 		uint16_t *avail);
 
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @file       deadlineheap.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief Public header for the deadline heap of periodic events
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef _DEADLINEHEAP_H
+#define _DEADLINEHEAP_H
+
+#include <stdint.h>
+
+/* The heap is kept in fixed blocks, allocated as it grows, as the number
+ * of periodic events is only known at runtime. */
+#define DEADLINE_HEAP_BLOCK_SHIFT 4
+#define DEADLINE_HEAP_BLOCK_LEN (1 << DEADLINE_HEAP_BLOCK_SHIFT)
+#define DEADLINE_HEAP_MAX_BLOCKS 16
+#define DEADLINE_HEAP_MAX_LEN (DEADLINE_HEAP_BLOCK_LEN * DEADLINE_HEAP_MAX_BLOCKS)
+
+/**
+ * A periodic deadline.  Embed it in whatever is being scheduled.
+ */
+struct deadline_entry {
+	uint32_t next_ms;	/**< System time of the next deadline */
+	uint16_t period_ms;	/**< Period, or 0 while disabled */
+	uint16_t phase_seq;	/**< Order of adding, which sets the phase */
+	uint16_t heap_index;	/**< Position in the heap */
+};
+
+/**
+ * Deadlines, earliest first.  Zero it to start empty.
+ */
+struct deadline_heap {
+	struct deadline_entry **blocks[DEADLINE_HEAP_MAX_BLOCKS];
+	uint16_t len;
+};
+
+int deadline_heap_add(struct deadline_heap *heap,
+		struct deadline_entry *entry, uint32_t now);
+
+void deadline_heap_reschedule(struct deadline_heap *heap,
+		struct deadline_entry *entry, uint32_t now);
+
+struct deadline_entry *deadline_heap_pop_due(struct deadline_heap *heap,
+		uint32_t now, uint32_t *lateness_ms, uint32_t *missed);
+
+uint32_t deadline_heap_time_to_next(const struct deadline_heap *heap,
+		uint32_t now, uint32_t max_ms);
+
+/**
+ * @brief Get an entry by position, for walking all of them
+ * @param[in] heap The heap
+ * @param[in] idx Position, less than heap->len
+ * @returns The entry
+ */
+static inline struct deadline_entry *deadline_heap_at(
+		const struct deadline_heap *heap, uint16_t idx)
+{
+	return heap->blocks[idx >> DEADLINE_HEAP_BLOCK_SHIFT]
+		[idx & (DEADLINE_HEAP_BLOCK_LEN - 1)];
+}
+
+#endif /* _DEADLINEHEAP_H */
@@ -0,0 +1,139 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       telemetryview.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Low rate snapshot of the flight state for telemetry bridges
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+#ifndef TELEMETRYVIEW_H
+#define TELEMETRYVIEW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * The view is split into sections, each refreshed from its objects on its
+ * own period by the event dispatcher, and only once some bridge has
+ * subscribed to it.  Every refresh advances the section's version, whether
+ * or not the values moved, so streams keep going on a vehicle sitting still.
+ * Version 0 means the section hasn't been refreshed yet.
+ *
+ * Units are those of the objects the fields come from.
+ */
+enum telemetryview_section {
+	TELEMETRYVIEW_ATTITUDE,
+	TELEMETRYVIEW_STATUS,
+	TELEMETRYVIEW_BATTERY,
+	TELEMETRYVIEW_GPS,
+	TELEMETRYVIEW_NAVIGATION,
+	TELEMETRYVIEW_NUM_SECTIONS
+};
+
+#define TELEMETRYVIEW_CHANNELS 8
+
+/* AttitudeActual */
+struct telemetryview_attitude {
+	float roll;
+	float pitch;
+	float yaw;
+};
+
+/* FlightStatus, SystemStats, ManualControlCommand and ActuatorDesired */
+struct telemetryview_status {
+	uint32_t flight_time;
+	float thrust;
+	float cycle_time;
+	int16_t rssi;
+	uint16_t channels[TELEMETRYVIEW_CHANNELS];
+	uint8_t cpu_load;
+	uint8_t armed;
+	uint8_t flight_mode;
+	uint8_t control_source;
+};
+
+/* FlightBatteryState and FlightBatterySettings */
+struct telemetryview_battery {
+	float voltage;
+	float current;
+	float consumed_energy;
+	uint32_t capacity;
+	bool present;		/**< FlightBatteryState exists */
+	bool has_settings;	/**< FlightBatterySettings exists */
+	bool has_voltage;	/**< A voltage pin is configured */
+	bool has_current;	/**< A current pin is configured */
+};
+
+/* GPSPosition */
+struct telemetryview_gps {
+	int32_t latitude;
+	int32_t longitude;
+	float altitude;
+	float groundspeed;
+	float heading;
+	float hdop;
+	float vdop;
+	uint8_t status;
+	uint8_t satellites;
+	bool present;
+};
+
+/* HomeLocation, BaroAltitude, PositionActual and AirspeedActual */
+struct telemetryview_navigation {
+	int32_t home_latitude;
+	int32_t home_longitude;
+	float home_altitude;
+	float baro_altitude;
+	float down;
+	float true_airspeed;
+	bool has_home;
+	bool home_set;
+	bool has_baro;
+	bool has_position;
+	bool has_airspeed;
+};
+
+/**
+ * A reader's copy of the view.  Zero it before the first read.
+ */
+struct telemetryview {
+	struct telemetryview_attitude attitude;
+	struct telemetryview_status status;
+	struct telemetryview_battery battery;
+	struct telemetryview_gps gps;
+	struct telemetryview_navigation navigation;
+
+	uint16_t version[TELEMETRYVIEW_NUM_SECTIONS];
+};
+
+int32_t TelemetryViewSubscribe(enum telemetryview_section section);
+bool TelemetryViewRead(struct telemetryview *copy,
+		enum telemetryview_section section);
+void TelemetryViewRefresh(enum telemetryview_section section);
+
+#endif // TELEMETRYVIEW_H
+
+/**
+ * @}
+ */
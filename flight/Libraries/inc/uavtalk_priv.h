@@ -33,6 +33,7 @@
 #include "uavobjectsinit.h"
 #include "pios_semaphore.h"
 #include "pios_mutex.h"
+#include "uavtalk_codec.h"
 
 // Private types and constants
 
@@ -106,9 +107,9 @@ typedef struct {
 #define UAVTALK_CANARI         0xCA
 #define UAVTALK_WAITFOREVER     -1
 #define UAVTALK_NOWAIT          0
-#define UAVTALK_SYNC_VAL       0x3C
-#define UAVTALK_TYPE_MASK      0x70
-#define UAVTALK_TYPE_VER       0x20
+#define UAVTALK_SYNC_VAL       UAVTALK_CODEC_SYNC_VAL
+#define UAVTALK_TYPE_MASK      UAVTALK_CODEC_VER_MASK
+#define UAVTALK_TYPE_VER       UAVTALK_CODEC_TYPE_VER
 #define UAVTALK_TIMESTAMPED    0x80
 #define UAVTALK_TYPE_OBJ       (UAVTALK_TYPE_VER | 0x00)
 #define UAVTALK_TYPE_OBJ_REQ   (UAVTALK_TYPE_VER | 0x01)
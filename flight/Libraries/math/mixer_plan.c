@@ -0,0 +1,159 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath math support libraries
+ * @{
+ *
+ * @file       mixer_plan.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Precompiled actuator mixer and output range mapping
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <string.h>
+
+#include "misc_math.h"
+#include "mixer_plan.h"
+
+/**
+ * Build a packed mixer plan from a full row-major mixer matrix.
+ *
+ * Rows (outputs) that are entirely zero and columns (inputs) that no
+ * active row uses are dropped, so the per-cycle multiply only touches
+ * coefficients that can contribute to the result.
+ *
+ * @param[out] plan the plan to fill in
+ * @param[in] mixer rows x cols row-major mixer matrix
+ * @param[in] rows number of outputs
+ * @param[in] cols number of inputs
+ * @returns true on success, false if the matrix is too large
+ */
+bool mixer_plan_compile(struct mixer_plan *plan, const float *mixer,
+		int rows, int cols)
+{
+	memset(plan, 0, sizeof(*plan));
+
+	if ((rows > MIXER_PLAN_MAX_ROWS) || (cols > MIXER_PLAN_MAX_COLS)) {
+		return false;
+	}
+
+	plan->out_rows = rows;
+
+	for (int c = 0; c < cols; c++) {
+		for (int r = 0; r < rows; r++) {
+			if (mixer[r * cols + c] != 0.0f) {
+				plan->col_idx[plan->cols++] = c;
+				break;
+			}
+		}
+	}
+
+	for (int r = 0; r < rows; r++) {
+		bool used = false;
+
+		for (int c = 0; c < cols; c++) {
+			if (mixer[r * cols + c] != 0.0f) {
+				used = true;
+				break;
+			}
+		}
+
+		if (!used) {
+			continue;
+		}
+
+		float *packed = plan->matrix + plan->rows * plan->cols;
+
+		for (int c = 0; c < plan->cols; c++) {
+			packed[c] = mixer[r * cols + plan->col_idx[c]];
+		}
+
+		plan->row_idx[plan->rows++] = r;
+	}
+
+	return true;
+}
+
+/**
+ * Run a mixer plan.
+ * @param[in] plan a plan built by mixer_plan_compile
+ * @param[in] in the full-width input (desired) vector
+ * @param[out] out the full-height output vector; inactive rows are zeroed
+ */
+void mixer_plan_execute(const struct mixer_plan *plan, const float *in,
+		float *out)
+{
+	float packed_in[MIXER_PLAN_MAX_COLS];
+	float packed_out[MIXER_PLAN_MAX_ROWS];
+
+	for (int c = 0; c < plan->cols; c++) {
+		packed_in[c] = in[plan->col_idx[c]];
+	}
+
+	matrix_mul(plan->matrix, packed_in, packed_out,
+			plan->rows, plan->cols, 1);
+
+	for (int r = 0; r < plan->out_rows; r++) {
+		out[r] = 0.0f;
+	}
+
+	for (int r = 0; r < plan->rows; r++) {
+		out[plan->row_idx[r]] = packed_out[r];
+	}
+}
+
+/**
+ * Precompute the output mapping of one channel.
+ *
+ * Matches the classic behaviour: [0,1] maps onto [neutral+deadband/2, max]
+ * and [-1,0) onto [min, neutral-deadband/2], everything is clamped to the
+ * range spanned by min and max (which may be reversed), and non-finite
+ * commands produce neutral for 3D channels and min otherwise.
+ *
+ * @param[out] scale the mapping to fill in
+ * @param[in] min output at -1
+ * @param[in] neutral output at 0
+ * @param[in] max output at 1
+ * @param[in] deadband total width of the 3D deadband, 0 if not 3D
+ */
+void channel_scale_compute(struct channel_scale *scale, float min,
+		float neutral, float max, float deadband)
+{
+	float half_db = deadband / 2.0f;
+
+	if (min > max) {
+		half_db = -half_db;
+	}
+
+	scale->gain[0] = max - neutral - half_db;
+	scale->offset[0] = neutral + half_db;
+	scale->gain[1] = neutral - min - half_db;
+	scale->offset[1] = neutral - half_db;
+
+	scale->lo = fminf(min, max);
+	scale->hi = fmaxf(min, max);
+
+	scale->idle = deadband ? neutral : min;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,101 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath math support libraries
+ * @{
+ *
+ * @file       mixer_plan.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Precompiled actuator mixer and output range mapping
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef MIXER_PLAN_H
+#define MIXER_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define MIXER_PLAN_MAX_ROWS 10
+#define MIXER_PLAN_MAX_COLS 8
+
+/**
+ * A mixer matrix with all-zero rows and columns removed.  Built once when
+ * the mixer settings change, then executed every actuator cycle.
+ */
+struct mixer_plan {
+	uint8_t rows;		/**< Number of packed (active) output rows */
+	uint8_t cols;		/**< Number of packed (used) input columns */
+	uint8_t out_rows;	/**< Row count of the original matrix */
+
+	uint8_t row_idx[MIXER_PLAN_MAX_ROWS];	/**< Output index per packed row */
+	uint8_t col_idx[MIXER_PLAN_MAX_COLS];	/**< Input index per packed col */
+
+	float matrix[MIXER_PLAN_MAX_ROWS * MIXER_PLAN_MAX_COLS];
+};
+
+/**
+ * Linear mapping of one output channel from [-1,1] to its output range.
+ * seg[0] is used for non-negative commands and seg[1] for negative ones,
+ * so applying it is a table lookup rather than a chain of branches.
+ */
+struct channel_scale {
+	float gain[2];
+	float offset[2];
+	float lo;		/**< Lower clamp of the output range */
+	float hi;		/**< Upper clamp of the output range */
+	float idle;		/**< Output for a non-finite ("don't spin") command */
+};
+
+bool mixer_plan_compile(struct mixer_plan *plan, const float *mixer,
+		int rows, int cols);
+void mixer_plan_execute(const struct mixer_plan *plan, const float *in,
+		float *out);
+
+void channel_scale_compute(struct channel_scale *scale, float min,
+		float neutral, float max, float deadband);
+
+/**
+ * Map a [-1,1] command into the output range of a channel.
+ * @param[in] scale the precomputed channel mapping
+ * @param[in] value the command; non-finite values mean "idle"
+ * @returns the scaled and clamped output value
+ */
+static inline float channel_scale_apply(const struct channel_scale *scale,
+		float value)
+{
+	if (!isfinite(value)) {
+		return scale->idle;
+	}
+
+	int seg = value < 0.0f;
+
+	float scaled = value * scale->gain[seg] + scale->offset[seg];
+
+	return fminf(fmaxf(scaled, scale->lo), scale->hi);
+}
+
+#endif /* MIXER_PLAN_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,287 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath math support libraries
+ * @{
+ *
+ * @file       sysident.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Recursive identification of per-axis rate dynamics
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+	The plant is the one the rtkf in lqg.c assumes:
+
+	  a' = (u - bias - a) / tau        (actuator lag)
+	  w' = Beta * a                    (rate, Beta = e^beta)
+
+	Sampled with a zero-order hold on u and e = e^(-Ts/tau), the rate step
+	dw[k] = w[k] - w[k-1] obeys exactly
+
+	  dw[k+1] = e*dw[k] + b0*u[k] + b1*u[k-1] + c
+
+	  b0 = Beta*(Ts - tau*(1-e))
+	  b1 = Beta*tau*(1-e)^2 - e*b0
+	  c  = -(b0 + b1) * bias,   b0 + b1 = Beta*Ts*(1-e)
+
+	For tau well above Ts, b0 and b1 are equal to within a few percent,
+	and the wiggle is a square wave that carries almost no information
+	to tell them apart, so they are fit as one gain g = b0 + b1 on the
+	average of the two inputs:
+
+	  dw[k+1] = e*dw[k] + g*(u[k] + u[k-1])/2 + c
+
+	which is linear in its parameters.  Plain least squares on it is
+	badly biased by gyro noise, since dw[k] appears on both sides and the
+	noise of the two steps is correlated.  So it is fit with recursive
+	instrumental variables: the measured dw[k] regressor is paired with
+	the model's own noise-free simulation of it.  The rate loop is
+	closed, so u carries gyro noise too; the instruments are taken
+	SYSIDENT_IV_LAG samples further back than the regressors, past where
+	that noise is correlated with the equation error.
+
+	Dead time shifts the input by d samples; one fit runs for each
+	candidate d and the one whose simulated output tracks the gyro best
+	wins.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "sysident.h"
+
+/* Initial parameter covariance; large means "no prior knowledge" */
+#define SYSIDENT_P_INIT 100.0f
+
+/* Covariance stops growing once its trace passes this, so a quiet
+ * stretch without excitation cannot wind it up. */
+#define SYSIDENT_P_MAX 1e4f
+
+/* Smoothing of the simulation error power used to pick the delay */
+#define SYSIDENT_ERR_ALPHA 0.998f
+
+/* Largest pole used to propagate the instrument model */
+#define SYSIDENT_POLE_MAX 0.999f
+
+/* Samples before an estimate is trusted at all */
+#define SYSIDENT_MIN_SAMPLES 200
+
+static void model_init(struct sysident_model *m)
+{
+	memset(m, 0, sizeof(*m));
+
+	for (int i = 0; i < SYSIDENT_PARAMS; i++) {
+		m->P[i][i] = SYSIDENT_P_INIT;
+	}
+}
+
+static void model_update(struct sysident_model *m,
+		const float phi[SYSIDENT_PARAMS], float z_u, float y,
+		float lambda)
+{
+	float z[SYSIDENT_PARAMS] = {
+		m->x_hat[SYSIDENT_IV_LAG], z_u, 1.0f
+	};
+
+	float Pz[SYSIDENT_PARAMS];
+	float phiP[SYSIDENT_PARAMS];
+	float denom = lambda;
+	float pred = 0;
+
+	for (int i = 0; i < SYSIDENT_PARAMS; i++) {
+		Pz[i] = 0;
+		phiP[i] = 0;
+
+		for (int j = 0; j < SYSIDENT_PARAMS; j++) {
+			Pz[i] += m->P[i][j] * z[j];
+			phiP[i] += phi[j] * m->P[j][i];
+		}
+
+		pred += m->theta[i] * phi[i];
+	}
+
+	for (int i = 0; i < SYSIDENT_PARAMS; i++) {
+		denom += phi[i] * Pz[i];
+	}
+
+	float err = y - pred;
+
+	float trace = 0;
+
+	for (int i = 0; i < SYSIDENT_PARAMS; i++) {
+		trace += m->P[i][i];
+	}
+
+	/* Only forget when there is something to forget */
+	float scale = (trace < SYSIDENT_P_MAX) ? (1 / lambda) : 1;
+
+	for (int i = 0; i < SYSIDENT_PARAMS; i++) {
+		float k = Pz[i] / denom;
+
+		m->theta[i] += k * err;
+
+		for (int j = 0; j < SYSIDENT_PARAMS; j++) {
+			m->P[i][j] = (m->P[i][j] - k * phiP[j]) * scale;
+		}
+	}
+
+	/* Advance the noise-free model output, kept stable even while the
+	 * fit is still wild. */
+	float pole = fminf(fmaxf(m->theta[0], 0), SYSIDENT_POLE_MAX);
+
+	for (int i = SYSIDENT_IV_LAG; i > 0; i--) {
+		m->x_hat[i] = m->x_hat[i - 1];
+	}
+
+	m->x_hat[0] = pole * m->x_hat[0] + m->theta[1] * phi[1] +
+		m->theta[2];
+
+	/* The equation error says little about the delay; noise dominates
+	 * it equally for every candidate.  Errors of the simulated output
+	 * build up when the input is misaligned, so rank by those. */
+	float sim_err = y - m->x_hat[0];
+
+	m->err_var = SYSIDENT_ERR_ALPHA * m->err_var +
+		(1 - SYSIDENT_ERR_ALPHA) * sim_err * sim_err;
+}
+
+/**
+ * Reset the identification state of an axis.
+ * @param[out] axis the state to reset
+ */
+void sysident_axis_init(struct sysident_axis *axis)
+{
+	memset(axis, 0, sizeof(*axis));
+
+	for (int d = 0; d < SYSIDENT_DELAYS; d++) {
+		model_init(&axis->model[d]);
+	}
+}
+
+/**
+ * Feed one control cycle into the identification.  Runs in constant time
+ * and memory.
+ *
+ * @param[in,out] axis identification state
+ * @param[in] y measured rate this cycle (deg/s)
+ * @param[in] u actuator command computed from y
+ * @param[in] lambda forgetting factor, e.g. 0.9995 for a memory of about
+ * 2000 samples
+ */
+void sysident_axis_update(struct sysident_axis *axis, float y, float u,
+		float lambda)
+{
+	float dy = y - axis->last_y;
+
+	/* Need two rate steps and a full input history for a regression */
+	if (axis->samples > SYSIDENT_DELAYS + SYSIDENT_IV_LAG + 1) {
+		for (int d = 0; d < SYSIDENT_DELAYS; d++) {
+			const float *u_d = &axis->u_hist[d];
+			const float *u_iv = &axis->u_hist[d + SYSIDENT_IV_LAG];
+
+			float phi[SYSIDENT_PARAMS] = {
+				axis->last_dy,
+				(u_d[0] + u_d[1]) / 2,
+				1.0f
+			};
+
+			model_update(&axis->model[d], phi,
+					(u_iv[0] + u_iv[1]) / 2, dy, lambda);
+		}
+	}
+
+	for (int i = SYSIDENT_DELAYS + SYSIDENT_IV_LAG; i > 0; i--) {
+		axis->u_hist[i] = axis->u_hist[i - 1];
+	}
+
+	axis->u_hist[0] = u;
+	axis->last_dy = dy;
+	axis->last_y = y;
+	axis->samples++;
+}
+
+/**
+ * Convert the best current fit into physical parameters.
+ *
+ * @param[in] axis identification state
+ * @param[in] Ts sample period in seconds
+ * @param[out] est the estimate
+ * @returns true if the fit describes a plausible plant, false if there is
+ * not enough data yet or the fit is not a stable, positive-gain lag
+ */
+bool sysident_axis_estimate(const struct sysident_axis *axis, float Ts,
+		struct sysident_estimate *est)
+{
+	if (axis->samples < SYSIDENT_MIN_SAMPLES) {
+		return false;
+	}
+
+	int best = 0;
+
+	for (int d = 1; d < SYSIDENT_DELAYS; d++) {
+		if (axis->model[d].err_var < axis->model[best].err_var) {
+			best = d;
+		}
+	}
+
+	const struct sysident_model *m = &axis->model[best];
+
+	float e = m->theta[0];
+	float g = m->theta[1];
+	float h = 1 - e;
+
+	if (!(e > 0 && e < 1) || !(g > 0)) {
+		return false;
+	}
+
+	est->tau = -Ts / logf(e);
+	est->beta = logf(g / (Ts * h));
+	est->bias = -m->theta[2] / g;
+	est->delay = best * Ts;
+
+	/*
+	 * Relative standard errors of the time constant and of the gain,
+	 * from the parameter covariance (P scaled by the residual power),
+	 * to first order:
+	 *   dtau/tau   = de / (e ln e)
+	 *   dBeta/Beta = dg/g + de/h
+	 */
+	float s2 = m->err_var;
+	float var_e = m->P[0][0] * s2;
+	float var_g = m->P[1][1] * s2;
+	float cov_ge = (m->P[0][1] + m->P[1][0]) / 2 * s2;
+
+	float rel_tau = sqrtf(var_e) / fabsf(e * logf(e));
+	float rel_beta2 = var_g / (g * g) + var_e / (h * h) +
+		2 * cov_ge / (g * h);
+	float rel_beta = sqrtf(fmaxf(rel_beta2, 0));
+
+	float rel = fmaxf(rel_tau, rel_beta);
+
+	est->confidence = (rel < 1) ? (1 - rel) : 0;
+
+	return true;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,91 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath math support libraries
+ * @{
+ *
+ * @file       sysident.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Recursive identification of per-axis rate dynamics
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SYSIDENT_H
+#define SYSIDENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Number of actuator delays (in samples) that are tried in parallel */
+#define SYSIDENT_DELAYS 4
+
+/* Regressors: [ previous rate step, (u[k-d] + u[k-d-1]) / 2, 1 ] */
+#define SYSIDENT_PARAMS 3
+
+/* How much older than the regressors the instruments are, in samples */
+#define SYSIDENT_IV_LAG 2
+
+/**
+ * Recursive instrumental variable fit of one candidate delay.
+ */
+struct sysident_model {
+	float theta[SYSIDENT_PARAMS];	/**< [ e^(-Ts/tau), gain, offset ] */
+	float P[SYSIDENT_PARAMS][SYSIDENT_PARAMS];
+	float x_hat[SYSIDENT_IV_LAG + 1];	/**< Simulated rate steps, newest first */
+	float err_var;			/**< Smoothed simulation error power */
+};
+
+/**
+ * Identification state of one axis.  The memory used does not depend on
+ * how long the identification runs.
+ */
+struct sysident_axis {
+	struct sysident_model model[SYSIDENT_DELAYS];
+
+	float u_hist[SYSIDENT_DELAYS + SYSIDENT_IV_LAG + 1];	/**< u[k-1], u[k-2], ... */
+	float last_y;
+	float last_dy;
+
+	uint32_t samples;
+};
+
+/**
+ * Parameters in the form used by the LQG rate controller and the GCS.
+ */
+struct sysident_estimate {
+	float tau;		/**< Actuator time constant, seconds */
+	float beta;		/**< ln of the torque gain, (deg/s^2) / actuator unit */
+	float bias;		/**< Actuator offset needed to hold rate */
+	float delay;		/**< Dead time beyond one sample, seconds */
+	float confidence;	/**< 0 (no idea) to 1 (no parameter uncertainty) */
+};
+
+void sysident_axis_init(struct sysident_axis *axis);
+void sysident_axis_update(struct sysident_axis *axis, float y, float u,
+		float lambda);
+bool sysident_axis_estimate(const struct sysident_axis *axis, float Ts,
+		struct sysident_estimate *est);
+
+#endif /* SYSIDENT_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -239,17 +239,21 @@ int32_t msp_send_com(struct msp_parser *parser, struct pios_com_dev *com, enum m
 
 	uint8_t dir = (parser->type == MSP_PARSER_SERVER) ? '>' : '<';
 	uint8_t hdr[] = {'$', 'M', dir, len, msg_id};
-	/* TODO: not assume success */
-	/* TODO: fix PIOS_COM to take a pointer */
-	int32_t written = PIOS_COM_SendBuffer((uintptr_t)com, hdr, NELEMENTS(hdr));
-	if (len)
-		written += PIOS_COM_SendBuffer((uintptr_t)com, payload, len);
 	uint8_t checksum = len ^ (uint8_t)msg_id;
 	for (unsigned i = 0; i < len; i++)
 		checksum ^= ((uint8_t *)payload)[i];
-	written += PIOS_COM_SendBuffer((uintptr_t)com, &checksum, 1);
 
-	return written;
+	const struct pios_com_iovec frame[] = {
+		{ .base = hdr, .len = NELEMENTS(hdr) },
+		{ .base = payload, .len = len },
+		{ .base = &checksum, .len = 1 },
+	};
+
+	int32_t sent = PIOS_COM_SendVector((uintptr_t)com, frame, NELEMENTS(frame));
+	if (sent != (int32_t)(NELEMENTS(hdr) + len + 1))
+		return -1;
+
+	return 0;
 }
 
 int32_t msp_register_handler(struct msp_parser *parser, msp_handler_t handler, void *context)
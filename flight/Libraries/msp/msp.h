@@ -81,7 +81,7 @@ int32_t msp_process_com(struct msp_parser *parser, struct pios_com_dev *com);
  * @param[in] msg_id Message ID/Command
  * @param[in] payload Buffer containing payload, or NULL if none
  * @param[in] len Length of payload (bytes)
- * @return Number of bytes read from com (all available), or -1 on failure
+ * @return 0 once the whole message is sent, or -1 on failure
  */
 int32_t msp_send_com(struct msp_parser *parser, struct pios_com_dev *com, enum msp_message_id msg_id, void *payload, uint8_t len);
 /** 
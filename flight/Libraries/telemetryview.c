@@ -0,0 +1,339 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       telemetryview.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Low rate snapshot of the flight state for telemetry bridges
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "openpilot.h"
+#include "telemetryview.h"
+#include <eventdispatcher.h>
+
+#include "actuatordesired.h"
+#include "airspeedactual.h"
+#include "attitudeactual.h"
+#include "baroaltitude.h"
+#include "flightbatterysettings.h"
+#include "flightbatterystate.h"
+#include "flightstatus.h"
+#include "gpsposition.h"
+#include "homelocation.h"
+#include "manualcontrolcommand.h"
+#include "positionactual.h"
+#include "systemstats.h"
+
+// Private types
+
+struct section {
+	uint16_t offset;
+	uint16_t size;
+	uint16_t period_ms;
+	void (*fill)(void *data);
+};
+
+// Private functions
+static void fill_attitude(void *data);
+static void fill_status(void *data);
+static void fill_battery(void *data);
+static void fill_gps(void *data);
+static void fill_navigation(void *data);
+static void refresh_cb(const UAVObjEvent *ev, void *ctx, void *obj_data,
+		int len);
+
+// Private constants
+
+#define SECTION(member, period, fn) { \
+	.offset = offsetof(struct telemetryview, member), \
+	.size = sizeof(((struct telemetryview *)0)->member), \
+	.period_ms = period, \
+	.fill = fn, \
+}
+
+/*
+ * Rates are what the fastest bridge streams each section at; bridges
+ * polling faster than this skip the encode until the next refresh.
+ */
+static const struct section sections[TELEMETRYVIEW_NUM_SECTIONS] = {
+	[TELEMETRYVIEW_ATTITUDE] = SECTION(attitude, 50, fill_attitude),
+	[TELEMETRYVIEW_STATUS] = SECTION(status, 100, fill_status),
+	[TELEMETRYVIEW_BATTERY] = SECTION(battery, 500, fill_battery),
+	[TELEMETRYVIEW_GPS] = SECTION(gps, 200, fill_gps),
+	[TELEMETRYVIEW_NAVIGATION] = SECTION(navigation, 200, fill_navigation),
+};
+
+// Private variables
+
+/*
+ * The view is written by the system task, which runs the event dispatcher
+ * above the priority of any bridge, and read by the bridges.  Each section
+ * has a sequence count that is odd while it is being written; readers copy
+ * and retry if the count was odd or moved.  A reader can't preempt the
+ * writer halfway, so the retry only happens when the writer preempted the
+ * reader, and nobody waits on anybody.
+ */
+static struct telemetryview view;
+static uint32_t seq[TELEMETRYVIEW_NUM_SECTIONS];
+
+//! Sections with a periodic refresh registered, one bit each
+static uint32_t subscribed;
+
+DONT_BUILD_IF(TELEMETRYVIEW_NUM_SECTIONS > sizeof(subscribed) * 8, TelemetryViewSubscribedOverflow);
+DONT_BUILD_IF(MANUALCONTROLCOMMAND_CHANNEL_NUMELEM < TELEMETRYVIEW_CHANNELS, TelemetryViewChannelsOverflow);
+
+/**
+ * Have a section of the view kept up to date.  Bridges call this for each
+ * section they use from their start function.
+ * \param[in] section The section
+ * \return 0 on success, -1 if the refresh couldn't be scheduled
+ */
+int32_t TelemetryViewSubscribe(enum telemetryview_section section)
+{
+	PIOS_Assert(section < TELEMETRYVIEW_NUM_SECTIONS);
+
+	if (subscribed & (1 << section))
+		return 0;
+
+	/* The first refresh is a period away; fill it in now so readers
+	 * don't start out with nothing. */
+	TelemetryViewRefresh(section);
+
+	UAVObjEvent ev = {
+		.obj = NULL,
+		.instId = section,
+		.event = 0,
+	};
+
+	if (EventPeriodicCallbackCreate(&ev, refresh_cb,
+				sections[section].period_ms) != 0)
+		return -1;
+
+	subscribed |= 1 << section;
+
+	return 0;
+}
+
+/**
+ * Update a reader's copy of a section, if the view has a newer one.
+ * \param[in,out] copy The reader's copy, with the versions it holds
+ * \param[in] section The section to update
+ * \return true if the section was copied, false if it's unchanged
+ */
+bool TelemetryViewRead(struct telemetryview *copy,
+		enum telemetryview_section section)
+{
+	PIOS_Assert(section < TELEMETRYVIEW_NUM_SECTIONS);
+
+	const struct section *s = &sections[section];
+	uint32_t count;
+
+	do {
+		count = __atomic_load_n(&seq[section], __ATOMIC_ACQUIRE);
+		if (count & 1)
+			continue;
+
+		if (view.version[section] == copy->version[section])
+			return false;
+
+		memcpy((uint8_t *)copy + s->offset,
+				(const uint8_t *)&view + s->offset, s->size);
+		copy->version[section] = view.version[section];
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((count & 1) ||
+			count != __atomic_load_n(&seq[section], __ATOMIC_RELAXED));
+
+	return true;
+}
+
+/**
+ * Refresh a section of the view from its objects and advance its version.
+ * Runs from the event dispatcher for subscribed sections.
+ * \param[in] section The section to refresh
+ */
+void TelemetryViewRefresh(enum telemetryview_section section)
+{
+	PIOS_Assert(section < TELEMETRYVIEW_NUM_SECTIONS);
+
+	const struct section *s = &sections[section];
+	union {
+		struct telemetryview_attitude attitude;
+		struct telemetryview_status status;
+		struct telemetryview_battery battery;
+		struct telemetryview_gps gps;
+		struct telemetryview_navigation navigation;
+	} data;
+
+	/* Gather everything before the write, so the objects' locks aren't
+	 * taken with readers locked out. */
+	memset(&data, 0, sizeof(data));
+	s->fill(&data);
+
+	uint32_t count = seq[section];
+
+	__atomic_store_n(&seq[section], count + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	memcpy((uint8_t *)&view + s->offset, &data, s->size);
+
+	if (++view.version[section] == 0)
+		view.version[section] = 1;
+
+	__atomic_store_n(&seq[section], count + 2, __ATOMIC_RELEASE);
+}
+
+static void refresh_cb(const UAVObjEvent *ev, void *ctx, void *obj_data,
+		int len)
+{
+	(void) ctx; (void) obj_data; (void) len;
+
+	TelemetryViewRefresh(ev->instId);
+}
+
+static void fill_attitude(void *data)
+{
+	struct telemetryview_attitude *attitude = data;
+	AttitudeActualData att;
+
+	AttitudeActualGet(&att);
+
+	attitude->roll = att.Roll;
+	attitude->pitch = att.Pitch;
+	attitude->yaw = att.Yaw;
+}
+
+static void fill_status(void *data)
+{
+	struct telemetryview_status *status = data;
+
+	FlightStatusData flight_status;
+	FlightStatusGet(&flight_status);
+
+	status->armed = flight_status.Armed;
+	status->flight_mode = flight_status.FlightMode;
+	status->control_source = flight_status.ControlSource;
+
+	SystemStatsData stats;
+	SystemStatsGet(&stats);
+
+	status->flight_time = stats.FlightTime;
+	status->cpu_load = stats.CPULoad;
+
+	ManualControlCommandData cmd;
+	ManualControlCommandGet(&cmd);
+
+	status->rssi = cmd.Rssi;
+	memcpy(status->channels, cmd.Channel, sizeof(status->channels));
+
+	ActuatorDesiredData desired;
+	ActuatorDesiredGet(&desired);
+
+	status->thrust = desired.Thrust;
+	status->cycle_time = desired.UpdateTime;
+}
+
+static void fill_battery(void *data)
+{
+	struct telemetryview_battery *battery = data;
+
+	if (FlightBatteryStateHandle() != NULL) {
+		FlightBatteryStateData state;
+		FlightBatteryStateGet(&state);
+
+		battery->present = true;
+		battery->voltage = state.Voltage;
+		battery->current = state.Current;
+		battery->consumed_energy = state.ConsumedEnergy;
+	}
+
+	if (FlightBatterySettingsHandle() != NULL) {
+		FlightBatterySettingsData settings;
+		FlightBatterySettingsGet(&settings);
+
+		battery->has_settings = true;
+		battery->capacity = settings.Capacity;
+		battery->has_voltage =
+			settings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE;
+		battery->has_current =
+			settings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE;
+	}
+}
+
+static void fill_gps(void *data)
+{
+	struct telemetryview_gps *gps = data;
+
+	if (GPSPositionHandle() == NULL)
+		return;
+
+	GPSPositionData pos;
+	GPSPositionGet(&pos);
+
+	gps->present = true;
+	gps->status = pos.Status;
+	gps->latitude = pos.Latitude;
+	gps->longitude = pos.Longitude;
+	gps->altitude = pos.Altitude;
+	gps->groundspeed = pos.Groundspeed;
+	gps->heading = pos.Heading;
+	gps->hdop = pos.HDOP;
+	gps->vdop = pos.VDOP;
+	gps->satellites = pos.Satellites;
+}
+
+static void fill_navigation(void *data)
+{
+	struct telemetryview_navigation *nav = data;
+
+	if (HomeLocationHandle() != NULL) {
+		HomeLocationData home;
+		HomeLocationGet(&home);
+
+		nav->has_home = true;
+		nav->home_set = home.Set == HOMELOCATION_SET_TRUE;
+		nav->home_latitude = home.Latitude;
+		nav->home_longitude = home.Longitude;
+		nav->home_altitude = home.Altitude;
+	}
+
+	if (BaroAltitudeHandle() != NULL) {
+		nav->has_baro = true;
+		BaroAltitudeAltitudeGet(&nav->baro_altitude);
+	}
+
+	if (PositionActualHandle() != NULL) {
+		nav->has_position = true;
+		PositionActualDownGet(&nav->down);
+	}
+
+	if (AirspeedActualHandle() != NULL) {
+		nav->has_airspeed = true;
+		AirspeedActualTrueAirspeedGet(&nav->true_airspeed);
+	}
+}
+
+/**
+ * @}
+ */
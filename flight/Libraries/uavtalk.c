@@ -40,6 +40,8 @@
 #include "pios_mutex.h"
 #include "pios_thread.h"
 
+#define MIN(x,y) ((x) < (y) ? (x) : (y))
+
 // Private functions
 static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle objectId, uint16_t instId, uint8_t type);
 static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
@@ -427,10 +429,47 @@ void UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uint8_t *rxby
 
 	CHECKCONHANDLE(connectionHandle,connection,return);
 
-	for (int i = 0; i < numbytes; i++) {
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+	int i = 0;
+
+	while (i < numbytes) {
+		if (iproc->state == UAVTALK_STATE_SYNC) {
+			/* Nothing but a sync byte can change the state, so skip
+			 * straight to the next one. */
+			const uint8_t *sync = memchr(rxbytes + i, UAVTALK_SYNC_VAL,
+					numbytes - i);
+			int skip = sync ? sync - (rxbytes + i) : numbytes - i;
+
+			connection->stats.rxBytes += skip;
+			i += skip;
+
+			if (i >= numbytes) {
+				break;
+			}
+		} else if (iproc->state == UAVTALK_STATE_DATA &&
+				iproc->rxCount + 1 < (int) iproc->length) {
+			/* Copy and checksum the payload a block at a time.  The
+			 * last byte goes through the state machine, which moves
+			 * on to the checksum. */
+			int count = MIN((int) iproc->length - 1 - iproc->rxCount,
+					numbytes - i);
+
+			memcpy(connection->rxBuffer + iproc->rxCount, rxbytes + i,
+					count);
+			iproc->cs = PIOS_CRC_updateCRC(iproc->cs, rxbytes + i,
+					count);
+
+			iproc->rxCount += count;
+			iproc->rxPacketLength += count;
+			connection->stats.rxBytes += count;
+			i += count;
+
+			continue;
+		}
+
 		UAVTalkRxState state =
 			UAVTalkProcessInputStreamQuiet(connectionHandle,
-					rxbytes[i]);
+					rxbytes[i++]);
 
 		if (state == UAVTALK_STATE_COMPLETE) {
 			receiveObject(connection);
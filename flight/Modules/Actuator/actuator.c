@@ -52,6 +52,7 @@
 #include "pios_thread.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "mixer_plan.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -72,6 +73,8 @@
 DONT_BUILD_IF(ACTUATORSETTINGS_TIMERUPDATEFREQ_NUMELEM > PIOS_SERVO_MAX_BANKS, TooManyServoBanks);
 DONT_BUILD_IF(MAX_MIX_ACTUATORS > ACTUATORCOMMAND_CHANNEL_NUMELEM, TooManyMixers);
 DONT_BUILD_IF((MIXERSETTINGS_MIXER1VECTOR_NUMELEM - MIXERSETTINGS_MIXER1VECTOR_ACCESSORY0) < MANUALCONTROLCOMMAND_ACCESSORY_NUMELEM, AccessoryMismatch);
+DONT_BUILD_IF(MAX_MIX_ACTUATORS > MIXER_PLAN_MAX_ROWS, MixerPlanTooFewRows);
+DONT_BUILD_IF(MIXERSETTINGS_MIXER1VECTOR_NUMELEM > MIXER_PLAN_MAX_COLS, MixerPlanTooFewCols);
 
 #define MIXER_SCALE 128
 #define ACTUATOR_EPSILON 0.00001f
@@ -98,6 +101,14 @@ static MixerSettingsMixer1TypeOptions types_mixer[MAX_MIX_ACTUATORS];
 
 static float motor_mixer[MAX_MIX_ACTUATORS * MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
 
+/* motor_mixer with the unused rows and columns packed away; this is what
+ * actually gets multiplied each cycle.
+ */
+static struct mixer_plan mixer_plan;
+
+/* Output range mapping of each (non-dshot) channel */
+static struct channel_scale channel_scales[MAX_MIX_ACTUATORS];
+
 /* These are various settings objects used throughout the actuator code */
 static ActuatorSettingsData actuatorSettings;
 static SystemSettingsAirframeTypeOptions airframe_type;
@@ -408,6 +419,9 @@ static void compute_mixer()
 #if MAX_MIX_ACTUATORS > 9
 	compute_one_token_paste(10);
 #endif
+
+	mixer_plan_compile(&mixer_plan, motor_mixer, MAX_MIX_ACTUATORS,
+			MIXERSETTINGS_MIXER1VECTOR_NUMELEM);
 }
 
 static void fill_desired_vector(
@@ -753,6 +767,12 @@ static void actuator_settings_update()
 		if (actuatorSettings.ChannelDeadband[i]) {
 			desired_3d_mask |= (1 << i);
 		}
+
+		channel_scale_compute(&channel_scales[i],
+				actuatorSettings.ChannelMin[i],
+				actuatorSettings.ChannelNeutral[i],
+				actuatorSettings.ChannelMax[i],
+				actuatorSettings.ChannelDeadband[i]);
 	}
 
 	hangtime_leakybucket_timeconstant = actuatorSettings.LowPowerStabilizationTimeConstant;
@@ -884,11 +904,9 @@ static void actuator_task(void* parameters)
 				&flip_over_mode);
 
 		/* Multiply the actuators x desired matrix by the
-		 * desired x 1 column vector. */
-		matrix_mul_check(motor_mixer, desired_vect, motor_vect,
-				MAX_MIX_ACTUATORS,
-				MIXERSETTINGS_MIXER1VECTOR_NUMELEM,
-				1);
+		 * desired x 1 column vector, skipping the parts of the
+		 * mixer that are known to be zero. */
+		mixer_plan_execute(&mixer_plan, desired_vect, motor_vect);
 
 		/* At arming time, knock all 3d actuators into 3D mode.
 		 * Note we never "take them out" of 3d mode.
@@ -1037,47 +1055,7 @@ static float scale_channel(float value, int idx, bool active_cmd)
 		return scale_channel_dshot(value, idx, active_cmd);
 	}
 
-	float max = actuatorSettings.ChannelMax[idx];
-	float min = actuatorSettings.ChannelMin[idx];
-	float neutral = actuatorSettings.ChannelNeutral[idx];
-	float deadband = actuatorSettings.ChannelDeadband[idx] / 2.0f;
-
-	float valueScaled;
-
-	if (!isfinite(value)) {
-		if (deadband) {
-			/* 3D motor mode */
-			/* NaN signals us to not spin-- e.g. neutral value */
-
-			return neutral;
-		} else {
-			/* Non-3D motor mode. */
-			/* NaN signals us to not spin-- e.g. minimum value */
-			return min;
-		}
-	}
-
-	if (min > max) {
-		deadband = -deadband;
-	}
-
-	if (value >= 0.0f) {
-		valueScaled = value * (max - neutral - deadband)
-			+ neutral + deadband;
-	} else {
-		valueScaled = value * (neutral - min - deadband)
-			+ neutral - deadband;
-	}
-
-	if (max > min) {
-		if (valueScaled > max) valueScaled = max;
-		if (valueScaled < min) valueScaled = min;
-	} else {
-		if (valueScaled < max) valueScaled = max;
-		if (valueScaled > min) valueScaled = min;
-	}
-
-	return valueScaled;
+	return channel_scale_apply(&channel_scales[idx], value);
 }
 
 static float channel_failsafe_value(int idx)
@@ -50,6 +50,8 @@
 #include "pios.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "pios_mutex.h"
+#include "eventdispatcher.h"
 #include "misc_math.h"
 #include "physical_constants.h"
 #include "coordinate_conversions.h"
@@ -84,8 +86,31 @@
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGH
 #define FAILSAFE_TIMEOUT_MS 10
 
+//! Distance travelled before the magnetic field is linearised afresh
+#define MAG_FIELD_RADIUS_M 20000.0f
+//! How often the system task looks for a magnetic field to linearise
+#define MAG_FIELD_PERIOD_MS 1000
+
 // Private types
 
+//! Hand over of a new linearisation between the attitude and system tasks
+enum mag_field_state {
+	MAG_FIELD_IDLE,		//!< Attitude task owns the request and next field
+	MAG_FIELD_REQUESTED,	//!< System task owns them, linearising
+	MAG_FIELD_READY,	//!< Attitude task owns them, next field to swap in
+};
+
+//! Where and when to linearise the magnetic field next
+struct mag_field_request {
+	float lat;
+	float lon;
+	float alt;
+	uint16_t month;
+	uint16_t day;
+	uint16_t year;
+	uint8_t generation;	//!< magFieldGeneration when asked for
+};
+
 // Track the initialization state of the complementary filter
 enum complementary_filter_status {
 	CF_POWERON,
@@ -158,6 +183,20 @@ static const float zeros[3] = {0.0f, 0.0f, 0.0f};
 static struct complementary_filter_state complementary_filter_state;
 static struct cfvert cfvert; //!< State information for vertical filter
 
+//! Model field linearised about where the vehicle is, for the INS to follow
+static WMMtype_LocalField magField;
+//! Model field at home, what the INS field is offset from as the model moves
+static float magFieldHome[3];
+static bool magFieldValid;
+//! Where to linearise next, and the field made there
+static struct mag_field_request magFieldRequest;
+static WMMtype_LocalField magFieldNext;
+static uint8_t magFieldState = MAG_FIELD_IDLE;
+//! Changed by init_mag_field(), so a linearisation started before is dropped
+static uint8_t magFieldGeneration;
+//! The model keeps its working in statics, so one full evaluation at a time
+static struct pios_mutex *wmmLock;
+
 static float dT_expected = 0.001f;	// assume 1KHz if we don't know.
 
 // Private functions
@@ -206,6 +245,12 @@ static void set_state_estimation_error(SystemAlarmsStateEstimationOptions error_
 //! Determine if it is safe to set the home location then do it
 static void check_home_location();
 
+//! Start the INS magnetic field at home, then follow it as the vehicle travels
+static void init_mag_field();
+static void update_mag_field(GPSPositionData *gps);
+static void linearise_mag_field(const UAVObjEvent *ev,
+		void *ctx, void *obj, int len);
+
 //! Scales used in NED transform (local tangent plane approx).
 static float T[3];
 
@@ -244,6 +289,11 @@ int32_t AttitudeInitialize(void)
 		return -1;		
 	}
 
+	wmmLock = PIOS_Mutex_Create();
+	if (wmmLock == NULL) {
+		return -1;
+	}
+
 	INSSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_flag);
 	AttitudeSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_flag);
 	StateEstimationConnectCallbackCtx(UAVObjCbSetFlag, &settings_flag);
@@ -295,6 +345,15 @@ int32_t AttitudeStart(void)
 	if (GPSVelocityHandle())
 		GPSVelocityConnectQueue(gpsVelQueue);
 
+	// Linearising the magnetic field takes ten full model evaluations,
+	// too long for this task's loop, so it is done in the system task
+	UAVObjEvent ev = {
+		.obj = HomeLocationHandle(),
+		.instId = 0,
+		.event = 0,
+	};
+	EventPeriodicCallbackCreate(&ev, linearise_mag_field, MAG_FIELD_PERIOD_MS);
+
 	// Watchdog must be registered before starting task
 	PIOS_WDG_RegisterFlag(PIOS_WDG_ATTITUDE);
 
@@ -1086,6 +1145,10 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	static uint32_t ins_last_time = 0;
 	static uint32_t ins_init_time = 0;
 
+	//! Time and samples accumulated since the last covariance prediction
+	static float cov_dT;
+	static uint8_t cov_samples;
+
 	static enum {INS_INIT, INS_WARMUP, INS_RUNNING} ins_state;
 
 	float NED[3] = {0.0f, 0.0f, 0.0f};
@@ -1110,6 +1173,9 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 
 		ins_last_time = PIOS_DELAY_GetRaw();
 
+		cov_dT = 0;
+		cov_samples = 0;
+
 		return 0;
 	}
 
@@ -1225,7 +1291,7 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		} else {
 			float NED[3];
 
-			INSSetMagNorth(homeLocation.Be);
+			init_mag_field();
 
 			// Initialize the gyro bias from the settings
 			float gyro_bias[3] = {gyrosBias.x * DEG2RAD, gyrosBias.y * DEG2RAD, gyrosBias.z * DEG2RAD};
@@ -1295,93 +1361,112 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		gyros[2] = gyrosData.z * DEG2RAD;
 	}
 
-	// Advance the state estimate
+	// Advance the state estimate.  This always runs at the full gyro rate.
 	INSStatePrediction(gyros, &accelsData.x, dT);
 
-	// Advance the covariance estimate
-	INSCovariancePrediction(dT);
+	// The covariance prediction and the measurement corrections are the
+	// expensive part of the filter.  Optionally only run them once every
+	// CovariancePredictionDivider samples, integrating over the time
+	// elapsed since the last covariance step.  Pending sensor updates
+	// stay flagged until then.
+	cov_dT += dT;
+	cov_samples++;
 
-	if(mag_updated) {
-		sensors |= MAG_SENSORS;
-		mag_updated = false;
-	}
+	uint8_t cov_divider = insSettings.CovariancePredictionDivider;
+	if (cov_divider < 1)
+		cov_divider = 1;
+
+	if (cov_samples >= cov_divider) {
+		// Advance the covariance estimate
+		INSCovariancePrediction(cov_dT);
+
+		cov_dT = 0;
+		cov_samples = 0;
+
+		if(mag_updated) {
+			sensors |= MAG_SENSORS;
+			mag_updated = false;
+		}
 	
-	if(baro_updated) {
-		sensors |= BARO_SENSOR;
-		baro_updated = false;
-	}
+		if(baro_updated) {
+			sensors |= BARO_SENSOR;
+			baro_updated = false;
+		}
 
-	// GPS Position update
-	if (gps_updated) { // only sets during outdoor mode
-		sensors |= HORIZ_POS_SENSORS;
+		// GPS Position update
+		if (gps_updated) { // only sets during outdoor mode
+			sensors |= HORIZ_POS_SENSORS;
 
-		// Transform the GPS position into NED coordinates
-		getNED(&gpsData, NED);
+			// Transform the GPS position into NED coordinates
+			getNED(&gpsData, NED);
 
-		// Store this for inspecting offline
-		NEDPositionData nedPos;
-		nedPos.North = NED[0];
-		nedPos.East = NED[1];
-		nedPos.Down = NED[2];
-		NEDPositionSet(&nedPos);
+			update_mag_field(&gpsData);
 
-		gps_updated = false;
-	}
+			// Store this for inspecting offline
+			NEDPositionData nedPos;
+			nedPos.North = NED[0];
+			nedPos.East = NED[1];
+			nedPos.Down = NED[2];
+			NEDPositionSet(&nedPos);
 
-	// GPS Velocity update
-	if (gps_vel_updated) { // only sets during outdoor mode
-		sensors |= HORIZ_VEL_SENSORS | VERT_VEL_SENSORS;
+			gps_updated = false;
+		}
 
-		vel[0] = gpsVelData.North;
-		vel[1] = gpsVelData.East;
-		vel[2] = gpsVelData.Down;
+		// GPS Velocity update
+		if (gps_vel_updated) { // only sets during outdoor mode
+			sensors |= HORIZ_VEL_SENSORS | VERT_VEL_SENSORS;
 
-		gps_vel_updated = false;
-	}
+			vel[0] = gpsVelData.North;
+			vel[1] = gpsVelData.East;
+			vel[2] = gpsVelData.Down;
 
-	// If either vel or pos is updated, update the variances.
-	if (gps_updated || gps_vel_updated) {
-		// Typical good pos 'accuracy' values are 2.5-3.5.  Early
-		// flight is near 4.0.
-		// Typical bad pos 'accuracy' values are 10+
-		// The values here are fudged.  Basically, when GPS is
-		// "good" we'll have a lower variance than the nominal
-		// setting.  But from there it will increase really quickly.
-		// sqrt(.5) / 3.5 =~ 0.181f 
-		float pos_var = insSettings.GpsVar[INSSETTINGS_GPSVAR_POS] * 
-			(0.6f + powf(gpsData.Accuracy * 0.180f, 2));
-
-		// A good value of speed accuracy in flight is 0.35-0.5. 
-		// sqrt(.5) / .5 =~ 1.414
-		float speed_var = insSettings.GpsVar[INSSETTINGS_GPSVAR_VEL] *
-			(0.5f + powf(gpsVelData.Accuracy * 1.414f, 2));
-
-		float v_pos_var = insSettings.GpsVar[INSSETTINGS_GPSVAR_VERTPOS] +
-			(0.7f + powf(gpsData.Accuracy * 0.167f, 3.0));
-
-		// We trust the vertical much less as accuracy gets worse.
-		// cuberoot(.3)/4.0 =~ .167
-
-		INSSetPosVelVar(pos_var, speed_var, v_pos_var);
-	}
+			gps_vel_updated = false;
+		}
 
-	// Update fake position at 10 hz
-	static uint32_t indoor_pos_time;
-	if (!outdoor_mode && PIOS_DELAY_DiffuS(indoor_pos_time) > 100000) {
-		sensors |= HORIZ_VEL_SENSORS | HORIZ_POS_SENSORS;
+		// If either vel or pos is updated, update the variances.
+		if (gps_updated || gps_vel_updated) {
+			// Typical good pos 'accuracy' values are 2.5-3.5.  Early
+			// flight is near 4.0.
+			// Typical bad pos 'accuracy' values are 10+
+			// The values here are fudged.  Basically, when GPS is
+			// "good" we'll have a lower variance than the nominal
+			// setting.  But from there it will increase really quickly.
+			// sqrt(.5) / 3.5 =~ 0.181f 
+			float pos_var = insSettings.GpsVar[INSSETTINGS_GPSVAR_POS] * 
+				(0.6f + powf(gpsData.Accuracy * 0.180f, 2));
+
+			// A good value of speed accuracy in flight is 0.35-0.5. 
+			// sqrt(.5) / .5 =~ 1.414
+			float speed_var = insSettings.GpsVar[INSSETTINGS_GPSVAR_VEL] *
+				(0.5f + powf(gpsVelData.Accuracy * 1.414f, 2));
+
+			float v_pos_var = insSettings.GpsVar[INSSETTINGS_GPSVAR_VERTPOS] +
+				(0.7f + powf(gpsData.Accuracy * 0.167f, 3.0));
+
+			// We trust the vertical much less as accuracy gets worse.
+			// cuberoot(.3)/4.0 =~ .167
+
+			INSSetPosVelVar(pos_var, speed_var, v_pos_var);
+		}
 
-		indoor_pos_time = PIOS_DELAY_GetRaw();
-		vel[0] = vel[1] = vel[2] = 0;
-		NED[0] = NED[1] = 0;
-		NED[2] = -(baroData.Altitude + baro_offset);
-	}
+		// Update fake position at 10 hz
+		static uint32_t indoor_pos_time;
+		if (!outdoor_mode && PIOS_DELAY_DiffuS(indoor_pos_time) > 100000) {
+			sensors |= HORIZ_VEL_SENSORS | HORIZ_POS_SENSORS;
 
-	/*
-	 * TODO: Need to add a general sanity check for all the inputs to make sure their kosher
-	 * although probably should occur within INS itself
-	 */
-	if (sensors)
-		INSCorrection(&magData.x, NED, vel, ( baroData.Altitude + baro_offset ), sensors);
+			indoor_pos_time = PIOS_DELAY_GetRaw();
+			vel[0] = vel[1] = vel[2] = 0;
+			NED[0] = NED[1] = 0;
+			NED[2] = -(baroData.Altitude + baro_offset);
+		}
+
+		/*
+		 * TODO: Need to add a general sanity check for all the inputs to make sure their kosher
+		 * although probably should occur within INS itself
+		 */
+		if (sensors)
+			INSCorrection(&magData.x, NED, vel, ( baroData.Altitude + baro_offset ), sensors);
+	}
 
 	// Export the state and variance for monitoring the EKF
 	INSStateData state;
@@ -1552,7 +1637,11 @@ static void check_home_location()
 		float LLA[3] = { homeLocation.Latitude / 10e6f, homeLocation.Longitude / 10e6f, homeLocation.Altitude };
 
 		// Compute magnetic flux direction at home location
-		if (WMM_GetMagVector(LLA[0], LLA[1], LLA[2], gpsTime.Month, gpsTime.Day, gpsTime.Year, &homeLocation.Be[0]) >= 0)
+		PIOS_Mutex_Lock(wmmLock, PIOS_MUTEX_TIMEOUT_MAX);
+		int32_t wmm_ret = WMM_GetMagVector(LLA[0], LLA[1], LLA[2], gpsTime.Month, gpsTime.Day, gpsTime.Year, &homeLocation.Be[0]);
+		PIOS_Mutex_Unlock(wmmLock);
+
+		if (wmm_ret >= 0)
 		{   // calculations appeared to go OK
 
 			// Compute local acceleration due to gravity.  Vehicles that span a very large
@@ -1564,6 +1653,112 @@ static void check_home_location()
 	}
 }
 
+/**
+ * Set the INS magnetic field to the home location's and linearise the model
+ * field about home, so update_mag_field() can follow it from there
+ */
+static void init_mag_field()
+{
+	INSSetMagNorth(homeLocation.Be);
+
+	GPSTimeData gpsTime;
+	GPSTimeGet(&gpsTime);
+
+	PIOS_Mutex_Lock(wmmLock, PIOS_MUTEX_TIMEOUT_MAX);
+	magFieldValid = gpsTime.Year >= 2000 &&
+		WMM_InitLocalField(&magField, homeLocation.Latitude / 10e6f,
+			homeLocation.Longitude / 10e6f, homeLocation.Altitude,
+			gpsTime.Month, gpsTime.Day, gpsTime.Year, MAG_FIELD_RADIUS_M) >= 0;
+	PIOS_Mutex_Unlock(wmmLock);
+
+	if (magFieldValid)
+		memcpy(magFieldHome, magField.B, sizeof(magFieldHome));
+
+	magFieldGeneration++;
+}
+
+/**
+ * Move the INS magnetic field by however much the model field differs
+ * between home and here.  The home location's field, which may have been
+ * set by hand, stays the baseline.  Only ever a few multiplies: once the
+ * vehicle has gone MAG_FIELD_RADIUS_M the field is extrapolated while
+ * linearise_mag_field() makes a new one about here, and then swapped for it.
+ * @param[in] gps The current position
+ */
+static void update_mag_field(GPSPositionData *gps)
+{
+	if (!magFieldValid)
+		return;
+
+	float lat = gps->Latitude / 10e6f;
+	float lon = gps->Longitude / 10e6f;
+	uint8_t state = __atomic_load_n(&magFieldState, __ATOMIC_ACQUIRE);
+
+	if (state == MAG_FIELD_READY) {
+		// Unless init_mag_field() has moved everything since it was asked for
+		if (magFieldRequest.generation == magFieldGeneration)
+			magField = magFieldNext;
+
+		state = MAG_FIELD_IDLE;
+		__atomic_store_n(&magFieldState, state, __ATOMIC_RELEASE);
+	}
+
+	float B[3];
+	if (WMM_GetLinearMagVector(&magField, lat, lon, gps->Altitude, B) > 0 &&
+			state == MAG_FIELD_IDLE &&
+			fabsf(lat) + MAG_FIELD_RADIUS_M / magField.Scale[0] < 90.0f) {
+		// Nearer the poles than that the last field is kept, as
+		// nothing could be linearised there anyway
+		magFieldRequest = (struct mag_field_request) {
+			.lat = lat,
+			.lon = lon,
+			.alt = gps->Altitude,
+			.month = magField.Month,
+			.day = magField.Day,
+			.year = magField.Year,
+			.generation = magFieldGeneration,
+		};
+
+		__atomic_store_n(&magFieldState, MAG_FIELD_REQUESTED, __ATOMIC_RELEASE);
+	}
+
+	float Be[3] = {
+		homeLocation.Be[0] + B[0] - magFieldHome[0],
+		homeLocation.Be[1] + B[1] - magFieldHome[1],
+		homeLocation.Be[2] + B[2] - magFieldHome[2],
+	};
+
+	INSSetMagNorth(Be);
+}
+
+/**
+ * Linearise the magnetic field where update_mag_field() asked for it, in
+ * the system task
+ */
+static void linearise_mag_field(const UAVObjEvent *ev,
+		void *ctx, void *obj, int len)
+{
+	(void) ev; (void) ctx; (void) obj; (void) len;
+
+	if (__atomic_load_n(&magFieldState, __ATOMIC_ACQUIRE) != MAG_FIELD_REQUESTED)
+		return;
+
+	PIOS_Mutex_Lock(wmmLock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t ret = WMM_InitLocalField(&magFieldNext, magFieldRequest.lat,
+			magFieldRequest.lon, magFieldRequest.alt,
+			magFieldRequest.month, magFieldRequest.day,
+			magFieldRequest.year, MAG_FIELD_RADIUS_M);
+	PIOS_Mutex_Unlock(wmmLock);
+
+	if (ret < 0) {
+		// Ask again from wherever the vehicle is next
+		__atomic_store_n(&magFieldState, MAG_FIELD_IDLE, __ATOMIC_RELEASE);
+		return;
+	}
+
+	__atomic_store_n(&magFieldState, MAG_FIELD_READY, __ATOMIC_RELEASE);
+}
+
 /**
  * Set the error code and alarm state
  * @param[in] error code
@@ -51,10 +51,15 @@
 #include "systemsettings.h"
 
 #include "misc_math.h"
+#include "sysident.h"
 
 // Private constants
 #define AUTOTUNE_STATE_PERIOD_MS 100
 
+/* Forgetting factor of the online identification: remembers ~5000
+ * samples, 10 seconds at 500Hz. */
+#define AUTOTUNE_IDENT_LAMBDA 0.9998f
+
 #ifndef AUTOTUNE_AVERAGING_DECIMATION
 #define AUTOTUNE_AVERAGING_DECIMATION 1
 #endif
@@ -80,6 +85,14 @@ struct at_measurement {
 
 static struct at_measurement *at_averages;
 
+/* Updated from the actuator callback and read by the periodic step, so
+ * the step estimates from a copy.  The callback runs in the control loop
+ * and must never wait, so at_ident_seq is odd while it updates and the
+ * step copies again if the count moved meanwhile. */
+static struct sysident_axis *at_ident;
+static struct sysident_axis *at_ident_snapshot;
+static uint32_t at_ident_seq;
+
 // Private variables
 static bool module_enabled;
 
@@ -165,6 +178,11 @@ static void at_new_actuators(const UAVObjEvent *ev,
 		return;		// No data
 	}
 
+	uint32_t seq = at_ident_seq;
+
+	__atomic_store_n(&at_ident_seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
 	/* Simple state machine.
 	 * !running !first_cycle -> running first_cycle -> running !first_cycle
 	 */
@@ -173,6 +191,10 @@ static void at_new_actuators(const UAVObjEvent *ev,
 			if (!tune_running) {
 				update_counter = 0;
 				throttle_accumulator = 0;
+
+				for (int i = 0; i < 3; i++) {
+					sysident_axis_init(&at_ident[i]);
+				}
 			}
 
 			tune_running = true;
@@ -180,19 +202,30 @@ static void at_new_actuators(const UAVObjEvent *ev,
 		}
 	}
 
-	struct at_measurement *avg_point = &at_averages[actuators.SystemIdentCycle / AUTOTUNE_AVERAGING_DECIMATION];
+	sysident_axis_update(&at_ident[0], g.x, actuators.Roll,
+			AUTOTUNE_IDENT_LAMBDA);
+	sysident_axis_update(&at_ident[1], g.y, actuators.Pitch,
+			AUTOTUNE_IDENT_LAMBDA);
+	sysident_axis_update(&at_ident[2], g.z, actuators.Yaw,
+			AUTOTUNE_IDENT_LAMBDA);
 
-	if (first_cycle) {
-		*avg_point = (struct at_measurement) { { 0 } };
-	}
+	__atomic_store_n(&at_ident_seq, seq + 2, __ATOMIC_RELEASE);
+
+	if (at_averages) {
+		struct at_measurement *avg_point = &at_averages[actuators.SystemIdentCycle / AUTOTUNE_AVERAGING_DECIMATION];
 
-	avg_point->y[0] += g.x;
-	avg_point->y[1] += g.y;
-	avg_point->y[2] += g.z;
+		if (first_cycle) {
+			*avg_point = (struct at_measurement) { { 0 } };
+		}
+
+		avg_point->y[0] += g.x;
+		avg_point->y[1] += g.y;
+		avg_point->y[2] += g.z;
 
-	avg_point->u[0] += actuators.Roll;
-	avg_point->u[1] += actuators.Pitch;
-	avg_point->u[2] += actuators.Yaw;
+		avg_point->u[0] += actuators.Roll;
+		avg_point->u[1] += actuators.Pitch;
+		avg_point->u[2] += actuators.Yaw;
+	}
 
 	update_counter++;
 	throttle_accumulator += 10000 * actuators.Thrust;
@@ -202,11 +235,49 @@ static void UpdateSystemIdent(uint32_t predicts, float hover_throttle,
 		bool new_tune) {
 	SystemIdentData system_ident;
 
+	SystemIdentGet(&system_ident);
+
 	system_ident.NewTune = new_tune;
 	system_ident.NumAfPredicts = predicts;
 
 	system_ident.HoverThrottle = hover_throttle;
 
+	float Ts = 1.0f / PIOS_SENSORS_GetSampleRate(PIOS_SENSOR_GYRO);
+
+	for (int i = 0; i < 3; i++) {
+		struct sysident_estimate est;
+
+		uint32_t seq;
+
+		/* The callback preempts this task, so never stays mid
+		 * update while we spin */
+		do {
+			seq = __atomic_load_n(&at_ident_seq, __ATOMIC_ACQUIRE);
+			if (seq & 1) {
+				continue;
+			}
+
+			*at_ident_snapshot = at_ident[i];
+
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		} while ((seq & 1) ||
+				seq != __atomic_load_n(&at_ident_seq, __ATOMIC_RELAXED));
+
+		/* Leave the previous values alone until there is a
+		 * plausible fit for this axis, but show that they are
+		 * not from this one. */
+		if (!sysident_axis_estimate(at_ident_snapshot, Ts, &est)) {
+			system_ident.Confidence[i] = 0;
+			continue;
+		}
+
+		system_ident.Tau[i] = est.tau;
+		system_ident.Beta[i] = est.beta;
+		system_ident.Bias[i] = est.bias;
+		system_ident.Delay[i] = est.delay;
+		system_ident.Confidence[i] = est.confidence * 100;
+	}
+
 	SystemIdentSet(&system_ident);
 }
 
@@ -275,16 +346,38 @@ static void autotune_step(const UAVObjEvent *ev,
 		decim_wiggle_points =
 			ident_wiggle_points / AUTOTUNE_AVERAGING_DECIMATION;
 
+		at_ident = PIOS_malloc(sizeof(*at_ident) * 3);
+		at_ident_snapshot = PIOS_malloc(sizeof(*at_ident_snapshot));
+
+		if (!at_ident || !at_ident_snapshot) {
+			if (at_ident) {
+				PIOS_free(at_ident);
+			}
+
+			if (at_ident_snapshot) {
+				PIOS_free(at_ident_snapshot);
+			}
+
+			at_ident = NULL;
+			at_ident_snapshot = NULL;
+		}
+
+		/* The averages are only needed for offline analysis; the
+		 * online estimates work without them. */
 		uint16_t buf_size = sizeof(*at_averages) * decim_wiggle_points;
 		at_averages = PIOS_malloc(buf_size);
 
-		if (at_averages) {
+		if (at_ident) {
+			for (int i = 0; i < 3; i++) {
+				sysident_axis_init(&at_ident[i]);
+			}
+
 			ActuatorDesiredConnectCallback(at_new_actuators);
 			PIOS_Modules_Enable(PIOS_MODULE_AUTOTUNE);
 		}
 	}
 
-	if (!at_averages) {
+	if (!at_ident) {
 		/* Do nothing because we couldn't get our buffer */
 		/* Assert alarm XXX? */
 		return;
@@ -296,7 +389,7 @@ static void autotune_step(const UAVObjEvent *ev,
 
 	if (save_needed) {
 		if (armed == FLIGHTSTATUS_ARMED_DISARMED) {
-			if (autotune_save_averaging()) {
+			if (at_averages && autotune_save_averaging()) {
 				// Try again next time, I guess.
 				return;
 			}
@@ -192,6 +192,7 @@ static void program_characters(charosd_state_t state, uint8_t font)
 	if (changed) {
 		PIOS_MAX7456_puts(state->dev, MAX7456_FMT_H_CENTER,
 				  6, loaded_txt, 0);
+		PIOS_MAX7456_flush(state->dev);
 		PIOS_Thread_Sleep(1000);
 	}
 	state->prev_font = font;
@@ -268,6 +269,7 @@ static void splash_screen(charosd_state_t state)
 	const char *boot_reason = AlarmBootReason(alarm.RebootCause);
 	PIOS_MAX7456_puts(state->dev, MAX7456_FMT_H_CENTER, 4, welcome_msg, 0);
 	PIOS_MAX7456_puts(state->dev, MAX7456_FMT_H_CENTER, 6, boot_reason, 0);
+	PIOS_MAX7456_flush(state->dev);
 
 	PIOS_Thread_Sleep(SPLASH_TIME_MS);
 }
@@ -316,6 +318,7 @@ static void CharOnScreenDisplayTask(void *parameters)
 
 		if (PIOS_MAX7456_stall_detect(state->dev)) {
 			PIOS_MAX7456_puts(state->dev, MAX7456_FMT_H_CENTER, 6, "... STALLED ...", 0);
+			PIOS_MAX7456_flush(state->dev);
 			PIOS_Thread_Sleep(10000);
 		}
 
@@ -69,6 +69,8 @@ static void updateSettings();
 
 #define GPS_TIMEOUT_MS                  750
 #define GPS_COM_TIMEOUT_MS              100
+#define GPS_RX_CHUNK_LEN                64
+#define GPS_RX_BATCH_MS                 2
 #define STACK_SIZE_BYTES                850
 
 #define TASK_PRIORITY                   PIOS_THREAD_PRIO_LOW
@@ -82,6 +84,7 @@ static bool module_enabled = false;
 static struct pios_thread *gpsTaskHandle;
 
 static char* gps_rx_buffer;
+static uint8_t gps_rx_chunk[GPS_RX_CHUNK_LEN];
 
 static struct GPS_RX_STATS gpsRxStats;
 
@@ -258,21 +261,22 @@ static void gpsTask(void *parameters)
 			continue;
 		}
 
-		uint8_t c;
+		uint16_t received;
 
 		// This blocks the task until there is something on the buffer
-		while (PIOS_COM_ReceiveBuffer(gpsPort, &c, 1, xDelay) > 0)
+		while ((received = PIOS_COM_ReceiveBuffer(gpsPort, gps_rx_chunk,
+				sizeof(gps_rx_chunk), xDelay)) > 0)
 		{
 			int res;
 			switch (gpsProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
-					res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_nmea_stream (gps_rx_chunk, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
-					res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_ubx_stream (gps_rx_chunk, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 				default:
@@ -286,6 +290,12 @@ static void gpsTask(void *parameters)
 
 			xDelay = 0;	// For now on, don't block / wait,
 					// but consume what we can from the fifo
+
+			// The rest of the message is still arriving; let it
+			// collect in the fifo instead of waking for every byte
+			if (res == PARSER_INCOMPLETE && received < sizeof(gps_rx_chunk)) {
+				PIOS_Thread_Sleep(GPS_RX_BATCH_MS);
+			}
 		}
 
 		// Check for GPS timeout
@@ -101,86 +101,87 @@ const static struct nmea_parser nmea_parsers[] = {
 	},
 };
 
-int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+//! Check and process one complete sentence held in gps_rx_buffer
+static int nmea_process_sentence(char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
+	// Validate the checksum over the sentence
+	if (!NMEA_checksum(&gps_rx_buffer[1]))
+	{	// Invalid checksum.  May indicate dropped characters on Rx.
+		gpsRxStats->gpsRxChkSumError++;
+		return PARSER_ERROR;
+	}
+
+	// Valid checksum, use this packet to update the GPS position
+	if (!NMEA_update_position(&gps_rx_buffer[1], GpsData))
+		gpsRxStats->gpsRxParserError++;
+	else
+		gpsRxStats->gpsRxReceived++;
+
+	return PARSER_COMPLETE;
+}
+
+int parse_nmea_stream (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
 	static uint8_t rx_count = 0;
 	static bool start_flag = false;
-	static bool found_cr = false;
+	int ret = PARSER_ERROR;
+	uint16_t i = 0;
 
-	// detect start while acquiring stream
-	if (!start_flag && (c == '$')) // NMEA identifier found
-	{
-		start_flag = true;
-		found_cr = false;
-		rx_count = 0;
-	}
-	else
-	if (!start_flag)
-		return PARSER_ERROR;
+	while (i < len) {
+		// detect start while acquiring stream
+		if (!start_flag) {
+			const uint8_t *start = memchr(&rx[i], '$', len - i);
 
-	if (rx_count >= NMEA_MAX_PACKET_LENGTH)
-	{
-		// The buffer is already full and we haven't found a valid NMEA sentence.
-		// Flush the buffer and note the overflow event.
-		gpsRxStats->gpsRxOverflow++;
-		start_flag = false;
-		found_cr = false;
-		rx_count = 0;
-		return PARSER_OVERRUN;
-	}
-	else
-	{
-		gps_rx_buffer[rx_count] = c;
-		rx_count++;
-	}
+			if (!start)
+				break;
+
+			i = start - rx;
+			start_flag = true;
+			rx_count = 0;
+		}
+
+		// Copy up to and including the next line feed
+		const uint8_t *lf = memchr(&rx[i], '\n', len - i);
+		uint16_t n = lf ? (lf - &rx[i]) + 1 : len - i;
+
+		if (rx_count + n > NMEA_MAX_PACKET_LENGTH) {
+			// The buffer is full and we haven't found a valid NMEA sentence.
+			// Flush the buffer and note the overflow event.
+			gpsRxStats->gpsRxOverflow++;
+			i += NMEA_MAX_PACKET_LENGTH - rx_count + 1;
+			start_flag = false;
+			if (ret != PARSER_COMPLETE)
+				ret = PARSER_OVERRUN;
+			continue;
+		}
+
+		memcpy(&gps_rx_buffer[rx_count], &rx[i], n);
+		rx_count += n;
+		i += n;
+
+		// look for ending '\r\n' sequence
+		if (!lf || rx_count < 2 || gps_rx_buffer[rx_count - 2] != '\r')
+			continue;
 
-	// look for ending '\r\n' sequence
-	if (!found_cr && (c == '\r') )
-		found_cr = true;
-	else
-	if (found_cr && (c != '\n') )
-		found_cr = false;  // false end flag
-	else
-	if (found_cr && (c == '\n') )
-	{
 		// The NMEA functions require a zero-terminated string
 		// As we detected \r\n, the string as for sure 2 bytes long, we will also strip the \r\n
-		gps_rx_buffer[rx_count-2] = 0;
+		gps_rx_buffer[rx_count - 2] = 0;
 
 		// prepare to parse next sentence
 		start_flag = false;
-		found_cr = false;
 		rx_count = 0;
+
 		// Our rxBuffer must look like this now:
 		//   [0]           = '$'
 		//   ...           = zero or more bytes of sentence payload
-		//   [end_pos - 1] = '\r'
-		//   [end_pos]     = '\n'
-		//
-		// Prepare to consume the sentence from the buffer
-
-		// Validate the checksum over the sentence
-		if (!NMEA_checksum(&gps_rx_buffer[1]))
-		{	// Invalid checksum.  May indicate dropped characters on Rx.
-			//PIOS_DEBUG_PinHigh(2);
-			gpsRxStats->gpsRxChkSumError++;
-			//PIOS_DEBUG_PinLow(2);
-			return PARSER_ERROR;
-		}
-		else
-		{	// Valid checksum, use this packet to update the GPS position
-			if (!NMEA_update_position(&gps_rx_buffer[1], GpsData)) {
-				//PIOS_DEBUG_PinHigh(2);
-				gpsRxStats->gpsRxParserError++;
-				//PIOS_DEBUG_PinLow(2);
-			}
-			else
-				gpsRxStats->gpsRxReceived++;;
-
-			return PARSER_COMPLETE;
-		}
+		if (nmea_process_sentence(gps_rx_buffer, GpsData, gpsRxStats) == PARSER_COMPLETE)
+			ret = PARSER_COMPLETE;
 	}
-	return PARSER_INCOMPLETE;
+
+	if (ret == PARSER_ERROR && start_flag)
+		return PARSER_INCOMPLETE; // sentence not (yet) complete
+
+	return ret;
 }
 
 const static struct nmea_parser *NMEA_find_parser_by_prefix(const char *prefix)
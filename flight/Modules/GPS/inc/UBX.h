@@ -47,6 +47,7 @@
 #define UBX_ID_STATUS	0x03
 #define UBX_ID_DOP		0x04
 #define UBX_ID_SOL		0x06
+#define UBX_ID_PVT		0x07
 #define	UBX_ID_VELNED	0x12
 #define UBX_ID_TIMEUTC	0x21
 #define UBX_ID_SVINFO	0x30
@@ -125,6 +126,52 @@ struct UBX_NAV_SOL {
 	uint32_t	reserved2;  // Reserved
 };
 
+// Position, velocity and time solution (u-blox 7 and later)
+
+#define PVT_VALID_DATE			(1 << 0)
+#define PVT_VALID_TIME			(1 << 1)
+
+#define PVT_FLAGS_GNSSFIX_OK	(1 << 0)
+#define PVT_FLAGS_DIFFSOLN		(1 << 1)
+
+// The u-blox 7 version of the message ends at headVeh
+#define UBX_NAV_PVT_MIN_LEN		84
+
+struct UBX_NAV_PVT {
+	uint32_t	iTOW;      // GPS Millisecond Time of Week (ms)
+	uint16_t	year;      // Year (UTC)
+	uint8_t		month;     // Month (UTC)
+	uint8_t		day;       // Day of month (UTC)
+	uint8_t		hour;      // Hour of day (UTC)
+	uint8_t		min;       // Minute of hour (UTC)
+	uint8_t		sec;       // Seconds of minute (UTC)
+	uint8_t		valid;     // Validity Flags
+	uint32_t	tAcc;      // Time Accuracy Estimate (ns)
+	int32_t		nano;      // Fraction of second (ns)
+	uint8_t		fixType;   // GNSS fix type
+	uint8_t		flags;     // Fix status flags
+	uint8_t		flags2;    // Additional flags
+	uint8_t		numSV;     // Number of SVs used in Nav Solution
+	int32_t		lon;       // Longitude (deg*1e-7)
+	int32_t		lat;       // Latitude (deg*1e-7)
+	int32_t		height;    // Height above Ellipsoid (mm)
+	int32_t		hMSL;      // Height above mean sea level (mm)
+	uint32_t	hAcc;      // Horizontal Accuracy Estimate (mm)
+	uint32_t	vAcc;      // Vertical Accuracy Estimate (mm)
+	int32_t		velN;      // mm/s NED north velocity
+	int32_t		velE;      // mm/s NED east velocity
+	int32_t		velD;      // mm/s NED down velocity
+	int32_t		gSpeed;    // mm/s Ground Speed (2-D)
+	int32_t		headMot;   // 1e-5 *deg Heading of motion 2-D
+	uint32_t	sAcc;      // mm/s Speed Accuracy Estimate
+	uint32_t	headAcc;   // 1e-5 *deg Heading Accuracy Estimate
+	uint16_t	pDOP;      // Position DOP
+	uint8_t		reserved1[6];
+	int32_t		headVeh;   // 1e-5 *deg Heading of vehicle (u-blox 8)
+	int16_t		magDec;    // 1e-2 *deg Magnetic declination (u-blox 8)
+	uint16_t	magAcc;    // 1e-2 *deg Declination accuracy (u-blox 8)
+};
+
 // North/East/Down velocity
 
 struct UBX_NAV_VELNED {
@@ -205,6 +252,7 @@ typedef union {
 	struct UBX_NAV_STATUS	nav_status;
 	struct UBX_NAV_DOP		nav_dop;
 	struct UBX_NAV_SOL		nav_sol;
+	struct UBX_NAV_PVT		nav_pvt;
 	struct UBX_NAV_VELNED	nav_velned;
 	struct UBX_NAV_TIMEUTC	nav_timeutc;
 	struct UBX_NAV_SVINFO	nav_svinfo;
@@ -224,7 +272,7 @@ struct UBXPacket {
 	UBXPayload	payload;
 };
 
-int  parse_ubx_stream(uint8_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+int  parse_ubx_stream(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
 
 #endif /* UBX_H */
 
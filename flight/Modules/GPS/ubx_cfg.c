@@ -71,6 +71,7 @@
 #define UBLOX_NAV_STATUS    0x03
 #define UBLOX_NAV_DOP       0x04
 #define UBLOX_NAV_SOL       0x06
+#define UBLOX_NAV_PVT       0x07
 #define UBLOX_NAV_VELNED    0x12
 #define UBLOX_NAV_TIMEUTC   0x21
 #define UBLOX_NAV_SBAS      0x32
@@ -406,6 +407,31 @@ static void ubx_cfg_set_constellation(uintptr_t gps_port,
     ubx_cfg_send_checksummed(gps_port, msg, sizeof(msg));
 }
 
+//! Enable the navigation messages, picking NAV-PVT where it is supported
+static void ubx_cfg_enable_nav_messages(uintptr_t gps_port, uint8_t ver) {
+    if (ver >= 7) {
+        // A single NAV-PVT carries the position, velocity and time of
+        // a solution, so a fix can be used as soon as it arrives.
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_PVT, 1);       // NAV-PVT
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 5);       // NAV-DOP
+
+        // Make sure the messages it replaces aren't still enabled from
+        // a saved configuration
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 0);
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 0);
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 0);
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 0);
+    } else {
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 1);    // NAV-VELNED
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 1);    // NAV-POSLLH
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 1);       // NAV-SOL
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 5);   // NAV-TIMEUTC
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 1);       // NAV-DOP
+    }
+
+    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SVINFO, 5);    // NAV-SVINFO
+}
+
 //! Apply firmware version specific configuration tweaks
 static void ubx_cfg_version_specific(uintptr_t gps_port, uint8_t ver,
         ModuleSettingsGPSConstellationOptions constellation,
@@ -442,13 +468,13 @@ static void ubx_cfg_pause_parse(uintptr_t gps_port, uint32_t delay_ticks)
     struct GPS_RX_STATS gpsRxStats;
     GPSPositionData     gpsPosition;
 
-    uint8_t c;
+    uint8_t rx[16];
     uint32_t enterTime = PIOS_Thread_Systime();
     while ((PIOS_Thread_Systime() - enterTime) < delay_ticks)
     {
-        int32_t received = PIOS_COM_ReceiveBuffer(gps_port, &c, 1, 1);
+        uint16_t received = PIOS_COM_ReceiveBuffer(gps_port, rx, sizeof(rx), 1);
         if (received > 0)
-            parse_ubx_stream (c, gps_rx_buffer, &gpsPosition, &gpsRxStats);
+            parse_ubx_stream (rx, received, gps_rx_buffer, &gpsPosition, &gpsRxStats);
     }
 }
 
@@ -500,23 +526,16 @@ void ubx_cfg_send_configuration(uintptr_t gps_port, char *buffer,
         UBloxInfoGet(&ublox);
     } while (ublox.swVersion == 0 && i++ < 10);
 
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 1);    // NAV-VELNED
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 1);    // NAV-POSLLH
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 1);       // NAV-SOL
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 5);   // NAV-TIMEUTC
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 1);       // NAV-DOP
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SVINFO, 5);    // NAV-SVINFO
+    // Hardcoded version if the poll didn't get an answer.
+    uint8_t ver = 6;
+    if (ublox.hwVersion > 0)
+        ver = ublox.hwVersion;
+
+    ubx_cfg_enable_nav_messages(gps_port, ver);
 
     ubx_cfg_set_mode(gps_port, dyn_mode);
 
-    // Hardcoded version. The poll version method should fetch the
-    // data but we need to link to that.
-    if (ublox.hwVersion > 0)
-        ubx_cfg_version_specific(gps_port, floorf(ublox.hwVersion),
-                constellation, sbas_const);
-    else
-        ubx_cfg_version_specific(gps_port, 6,
-                constellation, sbas_const);
+    ubx_cfg_version_specific(gps_port, ver, constellation, sbas_const);
 }
 
 //! Make sure the GPS is set to the same baud
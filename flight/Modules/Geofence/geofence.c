@@ -7,7 +7,7 @@
  *
  * @file       geofence.c
  * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
- * @author     dRonin, http://dronin.org Copyright (C) 2015
+ * @author     dRonin, http://dronin.org Copyright (C) 2015-2017
  * @brief      Check the UAV is within the geofence boundaries
  *
  * @see        The GNU Public License (GPL) Version 3
@@ -33,8 +33,11 @@
 #include <eventdispatcher.h>
 #include "misc_math.h"
 #include "physical_constants.h"
+#include "geofence_index.h"
 
 #include "geofencesettings.h"
+#include "geofencestatus.h"
+#include "geofencevertex.h"
 #include "positionactual.h"
 #include "modulesettings.h"
 
@@ -46,16 +49,30 @@
 
 // Private types
 
-// Private variables
+/**
+ * The polygon fence and its index.  The heap never frees, so the index
+ * storage is only reallocated when a fence needs more than it has.
+ */
+struct polygon_fence {
+	struct geofence_index index;
+	void *mem;
+	size_t mem_len;
+	bool valid;
+	uint8_t error;
+};
 
 // Private functions
 static void settingsUpdated(const UAVObjEvent *ev,
 		void *ctx, void *obj, int len);
 static void checkPosition(const UAVObjEvent *ev,
 		void *ctx, void *obj, int len);
+static void rebuildFence(GeoFenceStatusData *status);
 
 // Private variables
 static GeoFenceSettingsData *geofenceSettings;
+static struct polygon_fence *fence;
+static float warningRadius2;
+static volatile uint8_t fenceUpdated;
 
 /**
  * Initialise the module, called on startup
@@ -77,7 +94,9 @@ int32_t GeofenceInitialize(void)
 	}
 #endif
 
-	if (GeoFenceSettingsInitialize() == -1) {
+	if (GeoFenceSettingsInitialize() == -1 ||
+			GeoFenceVertexInitialize() == -1 ||
+			GeoFenceStatusInitialize() == -1) {
 		module_enabled = false;
 		return -1;
 	}
@@ -85,14 +104,21 @@ int32_t GeofenceInitialize(void)
 	if (module_enabled) {
 		// allocate and initialize the static data storage only if module is enabled
 		geofenceSettings = (GeoFenceSettingsData *) PIOS_malloc(sizeof(GeoFenceSettingsData));
-		if (geofenceSettings == NULL) {
+		fence = (struct polygon_fence *) PIOS_malloc(sizeof(struct polygon_fence));
+		if (geofenceSettings == NULL || fence == NULL) {
 			module_enabled = false;
 			return -1;
 		}
 
+		memset(fence, 0, sizeof(*fence));
+
 		GeoFenceSettingsConnectCallback(settingsUpdated);
 		settingsUpdated(NULL, NULL, NULL, 0);
 
+		// Index the polygons on the next check, after uploads settle
+		GeoFenceVertexConnectCallbackCtx(UAVObjCbSetFlag, &fenceUpdated);
+		fenceUpdated = 1;
+
 		return 0;
 	}
 
@@ -119,6 +145,74 @@ int32_t GeofenceStart(void)
 
 MODULE_INITCALL(GeofenceInitialize, GeofenceStart);
 
+static void getVertex(uint16_t idx, struct geofence_vertex *vertex, void *ctx)
+{
+	(void) ctx;
+	GeoFenceVertexData data;
+	GeoFenceVertexInstGet(idx, &data);
+
+	vertex->north = data.Position[GEOFENCEVERTEX_POSITION_NORTH];
+	vertex->east = data.Position[GEOFENCEVERTEX_POSITION_EAST];
+	vertex->polygon = data.Polygon;
+	vertex->type = (data.Type == GEOFENCEVERTEX_TYPE_EXCLUSION) ?
+		GEOFENCE_EXCLUSION : GEOFENCE_INCLUSION;
+}
+
+/**
+ * Index the polygon fence.  It runs up to the first vertex of polygon 0,
+ * so the default instance alone means there is no polygon fence.
+ */
+static void rebuildFence(GeoFenceStatusData *status)
+{
+	uint16_t numInstances = UAVObjGetNumInstances(GeoFenceVertexHandle());
+	uint16_t numVertices = 0;
+
+	fence->valid = false;
+	fence->error = GEOFENCESTATUS_ERROR_NONE;
+
+	while (numVertices < numInstances) {
+		GeoFenceVertexData vertex;
+		GeoFenceVertexInstGet(numVertices, &vertex);
+		if (vertex.Polygon == 0)
+			break;
+		numVertices++;
+	}
+
+	status->Vertices = numVertices;
+	status->Polygons = 0;
+	status->IndexCells = 0;
+
+	if (numVertices == 0)
+		return;
+
+	if (geofence_index_layout(&fence->index, numVertices, getVertex, NULL) != 0) {
+		fence->error = GEOFENCESTATUS_ERROR_INVALIDPOLYGON;
+		return;
+	}
+
+	if (fence->index.mem_needed > fence->mem_len) {
+		void *mem = PIOS_malloc(fence->index.mem_needed);
+
+		if (mem == NULL) {
+			fence->error = GEOFENCESTATUS_ERROR_OUTOFMEMORY;
+			return;
+		}
+
+		fence->mem = mem;
+		fence->mem_len = fence->index.mem_needed;
+	}
+
+	if (geofence_index_build(&fence->index, getVertex, NULL, fence->mem) != 0) {
+		// Changed while we were indexing it; try again next time
+		fenceUpdated = 1;
+		return;
+	}
+
+	fence->valid = true;
+	status->Polygons = fence->index.num_polygons;
+	status->IndexCells = fence->index.rows * fence->index.cols;
+}
+
 /**
  * Periodic callback that processes changes in position and
  * sets the alarm.
@@ -127,21 +221,61 @@ static void checkPosition(const UAVObjEvent *ev,
 		void *ctx, void *obj, int len)
 {
 	(void) ev; (void) ctx; (void) obj; (void) len;
+
+	GeoFenceStatusData status;
+	GeoFenceStatusGet(&status);
+
+	if (fenceUpdated) {
+		fenceUpdated = 0;
+		rebuildFence(&status);
+	}
+
+	status.Error = fence->error;
+
 	if (PositionActualHandle()) {
 		PositionActualData positionActual;
 		PositionActualGet(&positionActual);
 
 		const float distance2 = powf(positionActual.North, 2) + powf(positionActual.East, 2);
+		const float altitude = -positionActual.Down;
+
+		// Distance inside the nearest polygon edge, floor or ceiling,
+		// negative when outside
+		float margin = INFINITY;
+
+		if (fence->valid) {
+			float d = geofence_index_distance(&fence->index,
+					positionActual.North, positionActual.East);
+
+			if (!geofence_index_allowed(&fence->index,
+					positionActual.North, positionActual.East))
+				d = -d;
+
+			margin = MIN(margin, d);
+		}
+
+		if (geofenceSettings->Ceiling != 0)
+			margin = MIN(margin, geofenceSettings->Ceiling - altitude);
+		if (geofenceSettings->Floor != 0)
+			margin = MIN(margin, altitude - geofenceSettings->Floor);
+
+		// The radius has its own warning threshold, WarningRadius
+		float radiusMargin = geofenceSettings->ErrorRadius - sqrtf(distance2);
 
-		// ErrorRadius is squared when it is fetched, so this is correct
-		if (distance2 > geofenceSettings->ErrorRadius) {
+		status.DistanceToBoundary = MIN(margin, radiusMargin);
+
+		if (status.DistanceToBoundary < 0) {
 			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_ERROR);
-		} else if (distance2 > geofenceSettings->WarningRadius) {
+		} else if (distance2 > warningRadius2 ||
+				margin < geofenceSettings->WarningDistance ||
+				fence->error != GEOFENCESTATUS_ERROR_NONE) {
 			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_WARNING);
 		} else {
 			AlarmsClear(SYSTEMALARMS_ALARM_GEOFENCE);
 		}
 	}
+
+	GeoFenceStatusSet(&status);
 }
 
 /**
@@ -153,9 +287,8 @@ static void settingsUpdated(const UAVObjEvent *ev,
 	(void) ev; (void) ctx; (void) obj; (void) len;
 	GeoFenceSettingsGet(geofenceSettings);
 
-	// Cache squared distances to save computations
-	geofenceSettings->WarningRadius = powf(geofenceSettings->WarningRadius, 2);
-	geofenceSettings->ErrorRadius = powf(geofenceSettings->ErrorRadius, 2);
+	// Cache the squared distance to save computations
+	warningRadius2 = powf(geofenceSettings->WarningRadius, 2);
 }
 
 /**
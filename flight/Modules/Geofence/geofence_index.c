@@ -0,0 +1,561 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup GeoFence GeoFence Module
+ * @{
+ *
+ * @file       geofence_index.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Uniform grid index for testing positions against polygon
+ *             geofences, and finding the distance to their boundary.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <math.h>
+#include <float.h>
+#include <string.h>
+
+#include "geofence_index.h"
+
+//! Margin around the fence, so the grid corner is outside every polygon
+#define GRID_MARGIN_M 1.0f
+
+enum raster_op {
+	RASTER_COUNT,	//!< Count cell references only
+	RASTER_TALLY,	//!< Count references per cell
+	RASTER_FILL,	//!< Store the edge in each cell
+};
+
+static inline float orient(float an, float ae, float bn, float be,
+		float cn, float ce)
+{
+	return (bn - an) * (ce - ae) - (be - ae) * (cn - an);
+}
+
+/**
+ * Whether the segment p-q crosses an edge.  Endpoints lying exactly on a
+ * line count as being on its negative side, so a walk across a vertex
+ * shared by two edges crosses exactly one of them or neither.
+ */
+static bool crosses_edge(const struct geofence_index *idx, uint16_t edge,
+		float pn, float pe, float qn, float qe)
+{
+	float an = idx->north[edge], ae = idx->east[edge];
+	float bn = idx->north[idx->next[edge]], be = idx->east[idx->next[edge]];
+
+	bool sa = orient(pn, pe, qn, qe, an, ae) > 0;
+	bool sb = orient(pn, pe, qn, qe, bn, be) > 0;
+
+	if (sa == sb)
+		return false;
+
+	bool sp = orient(an, ae, bn, be, pn, pe) > 0;
+	bool sq = orient(an, ae, bn, be, qn, qe) > 0;
+
+	return sp != sq;
+}
+
+static inline int clamp_cell(float pos, float origin, float cell_size, uint16_t num)
+{
+	int cell = floorf((pos - origin) / cell_size);
+
+	if (cell < 0)
+		return 0;
+	if (cell >= num)
+		return num - 1;
+
+	return cell;
+}
+
+static inline void cell_center(const struct geofence_index *idx, int row, int col,
+		float *north, float *east)
+{
+	*north = idx->north0 + (row + 0.5f) * idx->cell_size;
+	*east = idx->east0 + (col + 0.5f) * idx->cell_size;
+}
+
+/**
+ * Liang-Barsky clip of a segment against a rectangle
+ * \return true if any part of the segment is within the rectangle
+ */
+static bool segment_hits_rect(float n0, float e0, float n1, float e1,
+		float nmin, float emin, float nmax, float emax)
+{
+	const float p[4] = { -(n1 - n0), n1 - n0, -(e1 - e0), e1 - e0 };
+	const float q[4] = { n0 - nmin, nmax - n0, e0 - emin, emax - e0 };
+	float t0 = 0, t1 = 1;
+
+	for (int i = 0; i < 4; i++) {
+		if (p[i] == 0) {
+			if (q[i] < 0)
+				return false;
+			continue;
+		}
+
+		float t = q[i] / p[i];
+
+		if (p[i] < 0) {
+			if (t > t1)
+				return false;
+			if (t > t0)
+				t0 = t;
+		} else {
+			if (t < t0)
+				return false;
+			if (t < t1)
+				t1 = t;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Find the cells an edge passes through.  The cells are grown a little so
+ * an edge along a cell border is listed on both sides.
+ * \return The number of cells
+ */
+static uint32_t rasterize_edge(struct geofence_index *idx, enum raster_op op,
+		float n0, float e0, float n1, float e1, uint16_t edge)
+{
+	const float cs = idx->cell_size;
+	const float eps = cs * 1e-3f;
+
+	int row0 = clamp_cell(fminf(n0, n1) - eps, idx->north0, cs, idx->rows);
+	int row1 = clamp_cell(fmaxf(n0, n1) + eps, idx->north0, cs, idx->rows);
+	int col0 = clamp_cell(fminf(e0, e1) - eps, idx->east0, cs, idx->cols);
+	int col1 = clamp_cell(fmaxf(e0, e1) + eps, idx->east0, cs, idx->cols);
+
+	uint32_t hits = 0;
+
+	for (int row = row0; row <= row1; row++) {
+		for (int col = col0; col <= col1; col++) {
+			float nmin = idx->north0 + row * cs;
+			float emin = idx->east0 + col * cs;
+
+			if (!segment_hits_rect(n0, e0, n1, e1, nmin - eps, emin - eps,
+					nmin + cs + eps, emin + cs + eps))
+				continue;
+
+			uint32_t cell = row * idx->cols + col;
+
+			switch (op) {
+			case RASTER_COUNT:
+				break;
+			case RASTER_TALLY:
+				idx->cell_start[cell + 1]++;
+				break;
+			case RASTER_FILL:
+				idx->cell_edges[idx->cell_start[cell]++] = edge;
+				break;
+			}
+
+			hits++;
+		}
+	}
+
+	return hits;
+}
+
+static inline size_t align4(size_t len)
+{
+	return (len + 3) & ~3;
+}
+
+/**
+ * Validate the fence and size the index for it.
+ * \param[out] idx Index to lay out; idx->mem_needed is the storage to
+ * pass to geofence_index_build()
+ * \param[in] num_vertices Number of vertices in the fence
+ * \param[in] get_vertex Fetches each vertex
+ * \return 0 on success, -1 if the fence can't be indexed
+ */
+int32_t geofence_index_layout(struct geofence_index *idx, uint16_t num_vertices,
+		geofence_vertex_fn get_vertex, void *ctx)
+{
+	struct geofence_vertex v;
+	uint32_t seen[256 / 32] = { 0 };
+	float nmin = FLT_MAX, nmax = -FLT_MAX, emin = FLT_MAX, emax = -FLT_MAX;
+	uint8_t last_polygon = 0;
+	uint16_t poly_len = 0;
+
+	memset(idx, 0, sizeof(*idx));
+
+	if (num_vertices < 3)
+		return -1;
+
+	// Check each polygon is contiguous and closed, and find the extent
+	for (uint16_t i = 0; i < num_vertices; i++) {
+		get_vertex(i, &v, ctx);
+
+		if (!isfinite(v.north) || !isfinite(v.east))
+			return -1;
+
+		if (i == 0 || v.polygon != last_polygon) {
+			if (i > 0 && poly_len < 3)
+				return -1;
+			if (seen[v.polygon / 32] & (1u << (v.polygon % 32)))
+				return -1;
+			if (idx->num_polygons == GEOFENCE_MAX_POLYGONS)
+				return -1;
+
+			seen[v.polygon / 32] |= 1u << (v.polygon % 32);
+
+			if (v.type == GEOFENCE_EXCLUSION)
+				idx->exclusion_mask |= 1u << idx->num_polygons;
+			else
+				idx->inclusion_mask |= 1u << idx->num_polygons;
+
+			idx->num_polygons++;
+			last_polygon = v.polygon;
+			poly_len = 0;
+		}
+
+		poly_len++;
+
+		nmin = fminf(nmin, v.north);
+		nmax = fmaxf(nmax, v.north);
+		emin = fminf(emin, v.east);
+		emax = fmaxf(emax, v.east);
+	}
+
+	if (poly_len < 3)
+		return -1;
+
+	// Square cells, about one per vertex
+	float height = nmax - nmin + 2 * GRID_MARGIN_M;
+	float width = emax - emin + 2 * GRID_MARGIN_M;
+	uint32_t target = num_vertices < GEOFENCE_MAX_CELLS ? num_vertices : GEOFENCE_MAX_CELLS;
+	float cs = sqrtf(height * width / target);
+
+	while (true) {
+		idx->rows = ceilf(height / cs);
+		idx->cols = ceilf(width / cs);
+
+		if (idx->rows < 1)
+			idx->rows = 1;
+		if (idx->cols < 1)
+			idx->cols = 1;
+
+		if ((uint32_t) idx->rows * idx->cols <= GEOFENCE_MAX_CELLS)
+			break;
+
+		cs *= 1.1f;
+	}
+
+	idx->num_vertices = num_vertices;
+	idx->cell_size = cs;
+	idx->north0 = nmin - GRID_MARGIN_M;
+	idx->east0 = emin - GRID_MARGIN_M;
+
+	// Count the cell references of every edge
+	struct geofence_vertex first, prev;
+
+	for (uint16_t i = 0; i <= num_vertices; i++) {
+		if (i < num_vertices)
+			get_vertex(i, &v, ctx);
+
+		if (i > 0 && (i == num_vertices || v.polygon != prev.polygon)) {
+			idx->num_refs += rasterize_edge(idx, RASTER_COUNT,
+					prev.north, prev.east, first.north, first.east, 0);
+		} else if (i > 0) {
+			idx->num_refs += rasterize_edge(idx, RASTER_COUNT,
+					prev.north, prev.east, v.north, v.east, 0);
+		}
+
+		if (i == 0 || v.polygon != prev.polygon)
+			first = v;
+		prev = v;
+	}
+
+	if (idx->num_refs > UINT16_MAX)
+		return -1;
+
+	uint32_t cells = (uint32_t) idx->rows * idx->cols;
+
+	idx->mem_needed = align4(2 * num_vertices * sizeof(float)) +
+		align4(cells * sizeof(uint32_t)) +
+		align4(num_vertices * sizeof(uint16_t)) +
+		align4((cells + 1) * sizeof(uint16_t)) +
+		align4(idx->num_refs * sizeof(uint16_t)) +
+		align4(num_vertices * sizeof(uint8_t));
+
+	return 0;
+}
+
+//! Whether an edge is in a cell's list
+static bool cell_has_edge(const struct geofence_index *idx, uint32_t cell, uint16_t edge)
+{
+	for (uint16_t i = idx->cell_start[cell]; i < idx->cell_start[cell + 1]; i++) {
+		if (idx->cell_edges[i] == edge)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * Polygons containing the center of a cell, from those containing the
+ * center of its neighbor.  The walk between the centers stays within the
+ * two cells, so only their edges can cross it.
+ */
+static uint32_t step_mask(const struct geofence_index *idx, uint32_t mask,
+		int row0, int col0, int row1, int col1)
+{
+	uint32_t cell0 = row0 * idx->cols + col0;
+	uint32_t cell1 = row1 * idx->cols + col1;
+	float pn, pe, qn, qe;
+
+	cell_center(idx, row0, col0, &pn, &pe);
+	cell_center(idx, row1, col1, &qn, &qe);
+
+	for (uint16_t i = idx->cell_start[cell0]; i < idx->cell_start[cell0 + 1]; i++) {
+		uint16_t edge = idx->cell_edges[i];
+
+		if (crosses_edge(idx, edge, pn, pe, qn, qe))
+			mask ^= 1u << idx->polygon[edge];
+	}
+
+	for (uint16_t i = idx->cell_start[cell1]; i < idx->cell_start[cell1 + 1]; i++) {
+		uint16_t edge = idx->cell_edges[i];
+
+		if (!cell_has_edge(idx, cell0, edge) &&
+				crosses_edge(idx, edge, pn, pe, qn, qe))
+			mask ^= 1u << idx->polygon[edge];
+	}
+
+	return mask;
+}
+
+/**
+ * Build the index laid out by geofence_index_layout().
+ * \param[in,out] idx Index returned by geofence_index_layout()
+ * \param[in] get_vertex Fetches each vertex
+ * \param[in] mem Storage of idx->mem_needed bytes, 4 byte aligned
+ * \return 0 on success, -1 if the fence changed since the layout
+ */
+int32_t geofence_index_build(struct geofence_index *idx,
+		geofence_vertex_fn get_vertex, void *ctx, void *mem)
+{
+	const uint16_t n = idx->num_vertices;
+	const uint32_t cells = (uint32_t) idx->rows * idx->cols;
+	uint8_t *p = mem;
+
+	idx->north = (float *) p;
+	idx->east = idx->north + n;
+	p += align4(2 * n * sizeof(float));
+	idx->cell_mask = (uint32_t *) p;
+	p += align4(cells * sizeof(uint32_t));
+	idx->next = (uint16_t *) p;
+	p += align4(n * sizeof(uint16_t));
+	idx->cell_start = (uint16_t *) p;
+	p += align4((cells + 1) * sizeof(uint16_t));
+	idx->cell_edges = (uint16_t *) p;
+	p += align4(idx->num_refs * sizeof(uint16_t));
+	idx->polygon = p;
+
+	// Copy the vertices and link each to the next one around its polygon
+	struct geofence_vertex v;
+	uint8_t last_polygon = 0;
+	uint8_t bit = 0;
+	uint16_t first = 0;
+
+	for (uint16_t i = 0; i < n; i++) {
+		get_vertex(i, &v, ctx);
+
+		if (i > 0 && v.polygon != last_polygon) {
+			idx->next[i - 1] = first;
+			first = i;
+
+			if (++bit == idx->num_polygons)
+				return -1;
+		}
+
+		idx->north[i] = v.north;
+		idx->east[i] = v.east;
+		idx->next[i] = i + 1;
+		idx->polygon[i] = bit;
+		last_polygon = v.polygon;
+	}
+
+	idx->next[n - 1] = first;
+
+	if (bit + 1 != idx->num_polygons)
+		return -1;
+
+	// Bucket the edges by cell
+	uint32_t num_refs = 0;
+
+	memset(idx->cell_start, 0, (cells + 1) * sizeof(uint16_t));
+
+	for (uint16_t i = 0; i < n; i++) {
+		num_refs += rasterize_edge(idx, RASTER_TALLY, idx->north[i], idx->east[i],
+				idx->north[idx->next[i]], idx->east[idx->next[i]], i);
+	}
+
+	if (num_refs != idx->num_refs)
+		return -1;
+
+	for (uint32_t c = 0; c < cells; c++)
+		idx->cell_start[c + 1] += idx->cell_start[c];
+
+	for (uint16_t i = 0; i < n; i++) {
+		rasterize_edge(idx, RASTER_FILL, idx->north[i], idx->east[i],
+				idx->north[idx->next[i]], idx->east[idx->next[i]], i);
+	}
+
+	// Filling advanced each start to the next cell's; shift them back
+	for (uint32_t c = cells; c > 0; c--)
+		idx->cell_start[c] = idx->cell_start[c - 1];
+	idx->cell_start[0] = 0;
+
+	// The grid corner is outside every polygon; walk from there into
+	// the first cell, then along the rows
+	float cn, ce;
+	uint32_t mask = 0;
+
+	cell_center(idx, 0, 0, &cn, &ce);
+
+	for (uint16_t i = 0; i < n; i++) {
+		if (crosses_edge(idx, i, idx->north0, idx->east0, cn, ce))
+			mask ^= 1u << idx->polygon[i];
+	}
+
+	for (int row = 0; row < idx->rows; row++) {
+		if (row > 0)
+			mask = step_mask(idx, idx->cell_mask[(row - 1) * idx->cols],
+					row - 1, 0, row, 0);
+
+		idx->cell_mask[row * idx->cols] = mask;
+
+		for (int col = 1; col < idx->cols; col++) {
+			mask = step_mask(idx, mask, row, col - 1, row, col);
+			idx->cell_mask[row * idx->cols + col] = mask;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Test a position against the fence.
+ * \return true if the position is inside an inclusion polygon (or there
+ * are none) and outside every exclusion polygon
+ */
+bool geofence_index_allowed(const struct geofence_index *idx, float north, float east)
+{
+	float rel_n = north - idx->north0;
+	float rel_e = east - idx->east0;
+	uint32_t mask = 0;
+
+	// Off the grid is outside all polygons
+	if (rel_n >= 0 && rel_e >= 0 &&
+			rel_n < idx->rows * idx->cell_size &&
+			rel_e < idx->cols * idx->cell_size) {
+		int row = clamp_cell(north, idx->north0, idx->cell_size, idx->rows);
+		int col = clamp_cell(east, idx->east0, idx->cell_size, idx->cols);
+		uint32_t cell = row * idx->cols + col;
+		float cn, ce;
+
+		cell_center(idx, row, col, &cn, &ce);
+		mask = idx->cell_mask[cell];
+
+		for (uint16_t i = idx->cell_start[cell]; i < idx->cell_start[cell + 1]; i++) {
+			uint16_t edge = idx->cell_edges[i];
+
+			if (crosses_edge(idx, edge, cn, ce, north, east))
+				mask ^= 1u << idx->polygon[edge];
+		}
+	}
+
+	if (idx->inclusion_mask && !(mask & idx->inclusion_mask))
+		return false;
+
+	return !(mask & idx->exclusion_mask);
+}
+
+static float edge_distance2(const struct geofence_index *idx, uint16_t edge,
+		float pn, float pe)
+{
+	float an = idx->north[edge], ae = idx->east[edge];
+	float dn = idx->north[idx->next[edge]] - an;
+	float de = idx->east[idx->next[edge]] - ae;
+	float len2 = dn * dn + de * de;
+	float t = 0;
+
+	if (len2 > 0) {
+		t = ((pn - an) * dn + (pe - ae) * de) / len2;
+		t = fminf(fmaxf(t, 0), 1);
+	}
+
+	float rn = an + t * dn - pn;
+	float re = ae + t * de - pe;
+
+	return rn * rn + re * re;
+}
+
+/**
+ * Distance from a position to the nearest polygon edge.  Cells are
+ * searched in rings around the position until no closer edge can remain.
+ */
+float geofence_index_distance(const struct geofence_index *idx, float north, float east)
+{
+	const int row0 = clamp_cell(north, idx->north0, idx->cell_size, idx->rows);
+	const int col0 = clamp_cell(east, idx->east0, idx->cell_size, idx->cols);
+	const int max_ring = idx->rows > idx->cols ? idx->rows : idx->cols;
+	float best2 = FLT_MAX;
+
+	for (int ring = 0; ring < max_ring; ring++) {
+		// Cells in this ring are at least ring - 1 cells away
+		float bound = (ring - 1) * idx->cell_size;
+
+		if (ring > 1 && bound * bound >= best2)
+			break;
+
+		for (int row = row0 - ring; row <= row0 + ring; row++) {
+			if (row < 0 || row >= idx->rows)
+				continue;
+
+			// Only the ring's perimeter, except on its top and bottom rows
+			int step = (row == row0 - ring || row == row0 + ring) ? 1 : 2 * ring;
+
+			for (int col = col0 - ring; col <= col0 + ring; col += step ? step : 1) {
+				if (col < 0 || col >= idx->cols)
+					continue;
+
+				uint32_t cell = row * idx->cols + col;
+
+				for (uint16_t i = idx->cell_start[cell]; i < idx->cell_start[cell + 1]; i++) {
+					float d2 = edge_distance2(idx, idx->cell_edges[i], north, east);
+
+					if (d2 < best2)
+						best2 = d2;
+				}
+			}
+		}
+	}
+
+	return sqrtf(best2);
+}
+
+/**
+ * @}
+ * @}
+ */
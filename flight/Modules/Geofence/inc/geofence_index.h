@@ -0,0 +1,98 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup GeoFence GeoFence Module
+ * @{
+ *
+ * @brief Spatial index for polygon geofences
+ * @file       geofence_index.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef GEOFENCE_INDEX_H
+#define GEOFENCE_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The fence is a set of polygons in north/east coordinates.  The vehicle
+ * must be inside one of the inclusion polygons (if there are any) and
+ * outside all of the exclusion polygons.
+ *
+ * The polygons are indexed with a uniform grid.  Each cell lists the edges
+ * that pass through it, and records which polygons contain its center.
+ * A query walks from the center of its cell to the point, so only the
+ * edges of that one cell are tested, however many vertices the fence has.
+ */
+
+#define GEOFENCE_MAX_POLYGONS	32
+#define GEOFENCE_MAX_CELLS	1024
+
+enum geofence_polygon_type {
+	GEOFENCE_INCLUSION,
+	GEOFENCE_EXCLUSION,
+};
+
+struct geofence_vertex {
+	float north;
+	float east;
+	uint8_t polygon;	//!< Vertices of a polygon are consecutive
+	uint8_t type;		//!< enum geofence_polygon_type, from a polygon's first vertex
+};
+
+//! Fetch vertex idx of the fence
+typedef void (*geofence_vertex_fn)(uint16_t idx, struct geofence_vertex *vertex, void *ctx);
+
+struct geofence_index {
+	uint16_t num_vertices;
+	uint8_t num_polygons;
+	uint16_t cols, rows;
+	uint32_t num_refs;
+	size_t mem_needed;
+
+	float north0, east0;	//!< Corner of the grid
+	float cell_size;
+	uint32_t inclusion_mask, exclusion_mask;
+
+	/* Storage handed to geofence_index_build() */
+	float *north, *east;
+	uint32_t *cell_mask;	//!< Polygons containing each cell center
+	uint16_t *next;		//!< Other end of the edge starting at each vertex
+	uint16_t *cell_start;
+	uint16_t *cell_edges;
+	uint8_t *polygon;	//!< Bit of each vertex's polygon in the masks
+};
+
+int32_t geofence_index_layout(struct geofence_index *idx, uint16_t num_vertices,
+		geofence_vertex_fn get_vertex, void *ctx);
+int32_t geofence_index_build(struct geofence_index *idx,
+		geofence_vertex_fn get_vertex, void *ctx, void *mem);
+
+bool geofence_index_allowed(const struct geofence_index *idx, float north, float east);
+float geofence_index_distance(const struct geofence_index *idx, float north, float east);
+
+#endif /* GEOFENCE_INDEX_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -61,6 +61,7 @@
 #include "magnetometer.h"
 #include "manualcontrolcommand.h"
 #include "positionactual.h"
+#include "profilesamples.h"
 #include "stabilizationdesired.h"
 #include "systemalarms.h"
 #include "systemident.h"
@@ -604,6 +605,11 @@ static void register_default_profile()
 		UAVObjConnectCallbackThrottled(SystemIdentHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10);
 	}
 
+	// Every batch of profiler samples, when the profiler is built in
+	if (ProfileSamplesHandle()) {
+		UAVObjConnectCallback(ProfileSamplesHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED);
+	}
+
 	// Log fast
 	UAVObjConnectCallbackThrottled(AccelsHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, min_period);
 	UAVObjConnectCallbackThrottled(GyrosHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, min_period);
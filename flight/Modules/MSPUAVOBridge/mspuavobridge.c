@@ -230,7 +230,9 @@ static void mspUavoBridge_Task(void *parameters)
 		while (!(msp->expected = get_next_message()))
 			PIOS_Thread_Sleep(1);
 
-		msp_send_com(msp->parser, msp->com, msp->expected, NULL, 0);
+		// No reply to wait for if the request never went out
+		if (msp_send_com(msp->parser, msp->com, msp->expected, NULL, 0) < 0)
+			continue;
 
 		int time = 0;
 		while (!msp->done && time < MSP_TIMEOUT) {
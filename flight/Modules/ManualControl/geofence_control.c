@@ -109,11 +109,10 @@ bool geofence_control_activate()
 {
 	// Check if the module is running
 	if (GeoFenceSettingsHandle()) {
-		uint8_t alarm_status[SYSTEMALARMS_ALARM_NUMELEM];
-		SystemAlarmsAlarmGet(alarm_status);
+		uint8_t alarm_status = AlarmsGet(SYSTEMALARMS_ALARM_GEOFENCE);
 
-		if (alarm_status[SYSTEMALARMS_ALARM_GEOFENCE] == SYSTEMALARMS_ALARM_ERROR ||
-			alarm_status[SYSTEMALARMS_ALARM_GEOFENCE] == SYSTEMALARMS_ALARM_CRITICAL) {
+		if (alarm_status == SYSTEMALARMS_ALARM_ERROR ||
+			alarm_status == SYSTEMALARMS_ALARM_CRITICAL) {
 			return true;
 		}
 	}
@@ -378,14 +378,11 @@ static FlightStatusControlSourceOptions control_source_select()
  */
 bool ok_to_arm(void)
 {
-	// read alarms
-	SystemAlarmsData alarms;
-	SystemAlarmsGet(&alarms);
-
-	// Check each alarm
+	// Check each alarm; straight from the alarms library, as SystemAlarms
+	// lags a little behind
 	for (int i = 0; i < SYSTEMALARMS_ALARM_NUMELEM; i++)
 	{
-		if (alarms.Alarm[i] >= SYSTEMALARMS_ALARM_ERROR &&
+		if (AlarmsGet(i) >= SYSTEMALARMS_ALARM_ERROR &&
 			i != SYSTEMALARMS_ALARM_GPS &&
 			i != SYSTEMALARMS_ALARM_TELEMETRY)
 		{
@@ -112,6 +112,7 @@ static uint32_t timeDifferenceMs(uint32_t start_time, uint32_t end_time);
 static void resetRcvrActivity(struct rcvr_activity_fsm * fsm);
 static bool updateRcvrActivity(struct rcvr_activity_fsm * fsm);
 static void set_loiter_command(ManualControlCommandData *cmd);
+static uint32_t read_channel_groups(uint16_t channels[]);
 
 // Exposed from manualcontrol to prevent attempts to arm when unsafe
 extern bool ok_to_arm();
@@ -370,16 +371,15 @@ int32_t transmitter_control_update()
 	bool valid_input_detected = true;
 
 	// Read channel values in us
+	uint32_t frame_age = read_channel_groups(cmd.Channel);
+	cmd.FrameAge = MIN(frame_age, UINT16_MAX);
+
 	for (uint8_t n = 0;
 	     n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM && n < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM;
 	     ++n) {
 
 		if (settings.ChannelGroups[n] >= MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
-			cmd.Channel[n] = PIOS_RCVR_INVALID;
 			validChannel[n] = false;
-		} else {
-			cmd.Channel[n] = PIOS_RCVR_Read(pios_rcvr_group_map[settings.ChannelGroups[n]],
-							settings.ChannelNumber[n]);
 		}
 
 		// If a channel has timed out this is not valid data and we shouldn't update anything
@@ -533,6 +533,71 @@ int32_t transmitter_control_update()
 	return 0;
 }
 
+/**
+ * Read the channels of the command, taking one frame from each receiver
+ * group in use so that channels from a group all come from the same frame.
+ * @param [out] channels values of the channels in ManualControlCommand order
+ * @returns how long ago, in us, the oldest timestamped frame was decoded
+ */
+static uint32_t read_channel_groups(uint16_t channels[])
+{
+	struct pios_rcvr_frame frame;
+	uint32_t groups_read = 0;
+	uint32_t frame_age = 0;
+
+	DONT_BUILD_IF(MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE > 32, GroupsFitBitmask);
+
+	for (uint8_t n = 0;
+	     n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM && n < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM;
+	     ++n) {
+		uint8_t group = settings.ChannelGroups[n];
+
+		if (group >= MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
+			channels[n] = PIOS_RCVR_INVALID;
+			continue;
+		}
+
+		if (groups_read & (1 << group))
+			continue;
+
+		groups_read |= 1 << group;
+
+		// Receivers read channel by channel only need those in use
+		uint8_t max_channel = 0;
+
+		for (uint8_t m = n;
+		     m < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM && m < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM;
+		     ++m) {
+			if (settings.ChannelGroups[m] == group)
+				max_channel = MAX(max_channel, settings.ChannelNumber[m]);
+		}
+
+		int32_t status = PIOS_RCVR_ReadFrame(pios_rcvr_group_map[group],
+				max_channel, &frame);
+
+		if (status == 0 && frame.sequence)
+			frame_age = MAX(frame_age, PIOS_DELAY_DiffuS(frame.timestamp));
+
+		for (uint8_t m = n;
+		     m < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM && m < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM;
+		     ++m) {
+			if (settings.ChannelGroups[m] != group)
+				continue;
+
+			uint8_t channel = settings.ChannelNumber[m];
+
+			if (status < 0)
+				channels[m] = status;
+			else if (channel == 0 || channel > frame.num_channels)
+				channels[m] = PIOS_RCVR_INVALID;
+			else
+				channels[m] = frame.channels[channel - 1];
+		}
+	}
+
+	return frame_age;
+}
+
 /**
  * Select and use transmitter control
  * @param [in] reset_controller True if previously another controller was used
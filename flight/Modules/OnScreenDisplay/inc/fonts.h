@@ -37,7 +37,7 @@
 #ifndef FONTS_H
 #define FONTS_H
 
-#include <openpilot.h>
+#include <pios.h>
 
 
 struct FontEntry {
@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup OnScreenDisplay Pixel OSD
+ * @{
+ *
+ * @brief Retained-mode rendering for the pixel OSD
+ * @file       osd_retained.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef OSD_RETAINED_H
+#define OSD_RETAINED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * A page is split into widgets by calling osd_widget() before each one is
+ * drawn.  osd_retained_render() runs the page's draw function once, with
+ * the drawing primitives only recording their calls (and the area they
+ * touch) into a signature per widget and a list of operations.  It then
+ * replays the recorded calls of the widgets whose signature differs from
+ * what the draw buffer already holds.  Everything else is left in place,
+ * so there's no full-frame clear.
+ *
+ * Should the operation list fill up, the widgets that didn't fit are drawn
+ * by running the draw function a second time.  Draw code must not keep
+ * state that changes each time it runs; use osd_retained_first_pass() to
+ * guard such updates.
+ */
+
+//! Drawing done before the first osd_widget() call goes here
+#define OSD_WIDGET_NONE 0
+
+#define OSD_RETAINED_MAX_WIDGETS 40
+
+struct osd_retained_stats {
+	uint16_t rendered;	//!< Widgets rasterized in the last frame
+	uint16_t copied;	//!< Widgets copied from the display buffer
+	uint16_t retained;	//!< Widgets left untouched
+};
+
+extern bool osd_retained_active;
+
+void osd_retained_render(void (*draw)(void *ctx), void *ctx);
+void osd_retained_invalidate(void);
+void osd_retained_get_stats(struct osd_retained_stats *stats);
+
+void osd_widget(uint8_t id);
+bool osd_retained_first_pass(void);
+
+/* Hooks for the drawing primitives in osd_utils.c */
+bool osd_retained_op(uint8_t op, const intptr_t *args, int num_args,
+		const char *str, int x0, int y0, int x1, int y1);
+void osd_replay_op(uint8_t op, const intptr_t *a, char *str);
+
+#define OSD_CALL_ARGS(...) (const intptr_t[]) { __VA_ARGS__ }, \
+		sizeof((const intptr_t[]) { __VA_ARGS__ }) / sizeof(intptr_t)
+
+//! A drawing call, with the arguments needed to repeat it
+#define OSD_CALL(op, ...) op, OSD_CALL_ARGS(__VA_ARGS__), NULL
+#define OSD_CALL_STR(op, str, ...) op, OSD_CALL_ARGS(__VA_ARGS__), str
+
+/**
+ * Evaluates true when a primitive must not touch the draw buffer.  The call
+ * and the bounds are only evaluated while retained rendering is active.
+ */
+#define OSD_RETAINED_SKIP(call, x0, y0, x1, y1) \
+	(osd_retained_active && !osd_retained_op(call, x0, y0, x1, y1))
+
+#endif /* OSD_RETAINED_H */
+
+/**
+ * @}
+ * @}
+ */
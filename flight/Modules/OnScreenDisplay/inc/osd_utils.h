@@ -31,7 +31,7 @@
 #ifndef OSDUTILS_H
 #define OSDUTILS_H
 
-#include "openpilot.h"
+#include <pios.h>
 #include "fonts.h"
 #include "images.h"
 #include "misc_math.h"
@@ -190,7 +190,6 @@ const struct FontEntry* get_font_info(int font);
 void calc_text_dimensions(char *str, const struct FontEntry *font, int xs, int ys, struct FontDimensions *dim);
 void write_string(char *str, int x, int y, int xs, int ys, int va, int ha, int flags, int font);
 void draw_polygon(int16_t x, int16_t y, float angle, const point_t * points, uint8_t n_points, int mode, int mmode);
-void lla_to_ned(int32_t lat, int32_t lon, float alt, float *NED);
 #endif /* OSDUTILS_H */
 
 /**
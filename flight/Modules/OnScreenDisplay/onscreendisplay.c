@@ -104,6 +104,7 @@
 #include "waypointactive.h"
 
 #include "osd_utils.h"
+#include "osd_retained.h"
 #include "osd_menu.h"
 #include "fonts.h"
 #include "WMMInternal.h"
@@ -126,6 +127,39 @@ static void onScreenDisplayTask(void *parameters);
 #define BOOT_DISPLAY_TIME_MS (10*1000)
 #define STATS_DELAY_MS 1500
 
+// Widgets of a user page, tracked separately by the retained renderer
+enum osd_page_widget {
+	OSD_WIDGET_MAP = 1,
+	OSD_WIDGET_ALARMS,
+	OSD_WIDGET_ALTITUDE_SCALE,
+	OSD_WIDGET_ALTITUDE_NUMERIC,
+	OSD_WIDGET_ARM_STATUS,
+	OSD_WIDGET_HORIZON,
+	OSD_WIDGET_BATTERY_VOLT,
+	OSD_WIDGET_BATTERY_CURRENT,
+	OSD_WIDGET_BATTERY_CONSUMED,
+	OSD_WIDGET_BATTERY_CHARGE,
+	OSD_WIDGET_CLIMB_RATE,
+	OSD_WIDGET_COMPASS,
+	OSD_WIDGET_CUSTOM_TEXT,
+	OSD_WIDGET_HOME_ARROW,
+	OSD_WIDGET_CPU,
+	OSD_WIDGET_FLIGHT_MODE,
+	OSD_WIDGET_GFORCE,
+	OSD_WIDGET_GPS_STATUS,
+	OSD_WIDGET_GPS_LAT,
+	OSD_WIDGET_GPS_LON,
+	OSD_WIDGET_GPS_MGRS,
+	OSD_WIDGET_HOME_DISTANCE,
+	OSD_WIDGET_RSSI,
+	OSD_WIDGET_SPEED_SCALE,
+	OSD_WIDGET_SPEED_NUMERIC,
+	OSD_WIDGET_TIME,
+	OSD_WIDGET_THROTTLE,
+	OSD_WIDGET_VTX_FREQ,
+	OSD_WIDGET_VTX_POWER,
+};
+
 const char METRIC_DIST_UNIT_LONG[] = "km";
 const char METRIC_DIST_UNIT_SHORT[] = "m";
 const char METRIC_SPEED_UNIT[] = "km/h";
@@ -765,6 +799,41 @@ void draw_alarms(int x, int y, int xs, int ys, int va, int ha, int flags, int fo
 	}
 }
 
+/**
+ * Convert LLA to NED coordinates
+ *
+ * @param  latitude
+ * @param  longitude
+ * @param  altitude
+ * @param output
+ */
+static void lla_to_ned(int32_t lattitude, int32_t longitude, float altitude, float *NED)
+{
+	// TODO: Abstract out this code and also precompute the part based
+	// on home location.
+
+	HomeLocationData homeLocation;
+	HomeLocationGet(&homeLocation);
+
+	GPSPositionData gpsPosition;
+	GPSPositionGet(&gpsPosition);
+
+	float lat = lattitude / 10.0e6f * DEG2RAD;
+
+	float T[3];
+	T[0] = altitude + 6.378137E6f;
+	T[1] = cosf(lat) * (altitude + 6.378137E6f);
+	T[2] = -1.0f;
+
+	float dL[3] = {(lattitude - homeLocation.Latitude) / 10.0e6f * DEG2RAD,
+				   (longitude - homeLocation.Longitude) / 10.0e6f * DEG2RAD,
+				   (altitude + gpsPosition.GeoidSeparation - homeLocation.Altitude)};
+
+	NED[0] = T[0] * dL[0];
+	NED[1] = T[1] * dL[1];
+	NED[2] = T[2] * dL[2];
+}
+
 // map with home at center
 void draw_map_home_center(int width_px, int height_px, int width_m, int height_m, bool show_wp, bool show_home, bool show_tablet)
 {
@@ -1112,6 +1181,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Draw Map
+	osd_widget(OSD_WIDGET_MAP);
 	if (has_nav && page->Map && PositionActualHandle() ) {
 		if (page->MapCenterMode == ONSCREENDISPLAYPAGESETTINGS_MAPCENTERMODE_UAV) {
 			draw_map_uav_center(page->MapWidthPixels, page->MapHeightPixels,
@@ -1128,12 +1198,14 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Alarms
+	osd_widget(OSD_WIDGET_ALARMS);
 	if (page->Alarm) {
 		draw_alarms((int)page->AlarmPosX, (int)page->AlarmPosY, 0, 0, TEXT_VA_TOP, (int)page->AlarmAlign, 0,
 				page->AlarmFont);
 	}
 
 	// Altitude Scale
+	osd_widget(OSD_WIDGET_ALTITUDE_SCALE);
 	if (page->AltitudeScale) {
 		bool valid_altitude = false;
 		if (page->AltitudeScaleSource == ONSCREENDISPLAYPAGESETTINGS_ALTITUDESCALESOURCE_BARO) {
@@ -1158,6 +1230,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Altitude Numeric
+	osd_widget(OSD_WIDGET_ALTITUDE_NUMERIC);
 	if (page->AltitudeNumeric) {
 		bool valid_altitude = false;
 		if (page->AltitudeNumericSource == ONSCREENDISPLAYPAGESETTINGS_ALTITUDENUMERICSOURCE_BARO) {
@@ -1179,6 +1252,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Arming Status
+	osd_widget(OSD_WIDGET_ARM_STATUS);
 	if (page->ArmStatus) {
 		FlightStatusArmedGet(&tmp_uint8);
 		if (tmp_uint8 == FLIGHTSTATUS_ARMED_ARMED)
@@ -1190,6 +1264,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Artificial Horizon (and centermark)
+	osd_widget(OSD_WIDGET_HORIZON);
 	if (page->ArtificialHorizon || page->CenterMark) {
 		AttitudeActualRollGet(&tmp);
 		AttitudeActualPitchGet(&tmp1);
@@ -1199,18 +1274,21 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 
 	// Battery
 	if (has_battery && FlightBatteryStateHandle()) {
+		osd_widget(OSD_WIDGET_BATTERY_VOLT);
 		if (page->BatteryVolt) {
 			FlightBatteryStateVoltageGet(&tmp);
 			sprintf(tmp_str, "%0.1fV", (double)tmp);
 			write_string(tmp_str, page->BatteryVoltPosX, page->BatteryVoltPosY, 0, 0, TEXT_VA_TOP, (int)page->BatteryVoltAlign, 0,
 					page->BatteryVoltFont);
 		}
+		osd_widget(OSD_WIDGET_BATTERY_CURRENT);
 		if (page->BatteryCurrent) {
 			FlightBatteryStateCurrentGet(&tmp);
 			sprintf(tmp_str, "%0.1fA", (double)tmp);
 			write_string(tmp_str, page->BatteryCurrentPosX, page->BatteryCurrentPosY, 0, 0, TEXT_VA_TOP,
 					(int)page->BatteryCurrentAlign, 0, page->BatteryCurrentFont);
 		}
+		osd_widget(OSD_WIDGET_BATTERY_CONSUMED);
 		if (page->BatteryConsumed) {
 			FlightBatteryStateConsumedEnergyGet(&tmp);
 			sprintf(tmp_str, "%0.0fmAh", (double)tmp);
@@ -1218,6 +1296,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 					(int)page->BatteryConsumedAlign, 0, page->BatteryConsumedFont);
 		}
 
+		osd_widget(OSD_WIDGET_BATTERY_CHARGE);
 		if (page->BatteryChargeState) {
 			FlightBatteryStateConsumedEnergyGet(&tmp);
 			FlightBatterySettingsCapacityGet(&tmp_uint32);
@@ -1226,6 +1305,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Climb rate
+	osd_widget(OSD_WIDGET_CLIMB_RATE);
 	if (page->ClimbRate && VelocityActualHandle() && has_baro) {
 		VelocityActualDownGet(&tmp);
 		sprintf(tmp_str, "%0.1f", (double)(-1.f * convert_distance * tmp));
@@ -1234,6 +1314,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Compass
+	osd_widget(OSD_WIDGET_COMPASS);
 	if (page->Compass) {
 		bool do_compass = has_mag;
 
@@ -1258,6 +1339,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Custom text
+	osd_widget(OSD_WIDGET_CUSTOM_TEXT);
 	if (page->CustomText) {
 		memcpy((void *)tmp_str, (void *)(osd_settings.CustomText), ONSCREENDISPLAYSETTINGS_CUSTOMTEXT_NUMELEM);
 		tmp_str[ONSCREENDISPLAYSETTINGS_CUSTOMTEXT_NUMELEM] = 0;
@@ -1266,6 +1348,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Home arrow
+	osd_widget(OSD_WIDGET_HOME_ARROW);
 	if (has_nav && page->HomeArrow) {
 		if (!page->Compass) {
 			AttitudeActualYawGet(&tmp);
@@ -1275,6 +1358,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// CPU utilization
+	osd_widget(OSD_WIDGET_CPU);
 	if (page->Cpu) {
 		SystemStatsCPULoadGet(&tmp_uint8);
 		sprintf(tmp_str, "CPU:%2d", tmp_uint8);
@@ -1282,21 +1366,25 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Flight mode
+	osd_widget(OSD_WIDGET_FLIGHT_MODE);
 	if (page->FlightMode) {
 		draw_flight_mode(page->FlightModePosX, page->FlightModePosY, 0, 0, TEXT_VA_TOP, (int)page->FlightModeAlign, 0,
 				page->FlightModeFont);
 	}
 
 	// G Force
+	osd_widget(OSD_WIDGET_GFORCE);
 	if (page->GForce) {
 		AccelsData accelsData;
 		AccelsGet(&accelsData);
 		// apply low pass filter to reduce noise bias
 		static AccelsData accelsDataAcc = { 0 };
 
-		accelsDataAcc.x = 0.8f * accelsDataAcc.x + 0.2f * accelsData.x;
-		accelsDataAcc.y = 0.8f * accelsDataAcc.y + 0.2f * accelsData.y;
-		accelsDataAcc.z = 0.8f * accelsDataAcc.z + 0.2f * accelsData.z;
+		if (osd_retained_first_pass()) {
+			accelsDataAcc.x = 0.8f * accelsDataAcc.x + 0.2f * accelsData.x;
+			accelsDataAcc.y = 0.8f * accelsDataAcc.y + 0.2f * accelsData.y;
+			accelsDataAcc.z = 0.8f * accelsDataAcc.z + 0.2f * accelsData.z;
+		}
 
 		tmp = sqrtf(powf(accelsDataAcc.x, 2.f) + powf(accelsDataAcc.y, 2.f) + powf(accelsDataAcc.z, 2.f)) / 9.81f;
 		sprintf(tmp_str, "%0.1fG", (double)tmp);
@@ -1309,6 +1397,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 		GPSPositionData gps_data;
 		GPSPositionGet(&gps_data);
 
+		osd_widget(OSD_WIDGET_GPS_STATUS);
 		draw_image(page->GpsStatusPosX, page->GpsStatusPosY - image_gps.height / 2, &image_gps);
 
 		uint8_t pdop_1 = gps_data.PDOP;
@@ -1336,12 +1425,14 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 					0, page->GpsStatusFont);
 		}
 
+		osd_widget(OSD_WIDGET_GPS_LAT);
 		if (page->GpsLat) {
 			sprintf(tmp_str, "%0.5f", (double)gps_data.Latitude / 10000000.0);
 			write_string(tmp_str, page->GpsLatPosX, page->GpsLatPosY, 0, 0, TEXT_VA_TOP, (int)page->GpsLatAlign, 0,
 					page->GpsLatFont);
 		}
 
+		osd_widget(OSD_WIDGET_GPS_LON);
 		if (page->GpsLon) {
 			sprintf(tmp_str, "%0.5f", (double)gps_data.Longitude / 10000000.0);
 			write_string(tmp_str, page->GpsLonPosX, page->GpsLonPosY, 0, 0, TEXT_VA_TOP, (int)page->GpsLonAlign, 0,
@@ -1349,10 +1440,11 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 		}
 
 		// MGRS location
+		osd_widget(OSD_WIDGET_GPS_MGRS);
 		if (page->GpsMgrs) {
 			static char mgrs_str[20] = {0};
 
-			if (frame_counter % 5 == 0) {
+			if (frame_counter % 5 == 0 && osd_retained_first_pass()) {
 				// the conversion to MGRS is computationally expensive, so we update it a bit slower
 				tmp_int1 = Convert_Geodetic_To_MGRS((double)gps_data.Latitude * (double)DEG2RAD / 10000000.0,
 								(double)gps_data.Longitude * (double)DEG2RAD / 10000000.0, 5, mgrs_str);
@@ -1365,6 +1457,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Home distance (will be -1 if enabled but GPS is not enabled)
+	osd_widget(OSD_WIDGET_HOME_DISTANCE);
 	if (home_dist >= 0) {
 		if (home_dist < convert_distance_divider)
 			sprintf(tmp_str, "%d%s", (int) home_dist, dist_unit_short);
@@ -1379,6 +1472,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// RSSI
+	osd_widget(OSD_WIDGET_RSSI);
 	if (page->Rssi) {
 		ManualControlCommandRssiGet(&tmp_int16);
 		if (tmp_int16 > osd_settings.RssiWarnThreshold || blink) {
@@ -1392,6 +1486,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Speed Scale
+	osd_widget(OSD_WIDGET_SPEED_SCALE);
 	if (page->SpeedScale) {
 		tmp = 0.f;
 		bool speed_valid = false;
@@ -1436,6 +1531,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Speed Numeric
+	osd_widget(OSD_WIDGET_SPEED_NUMERIC);
 	if (page->SpeedNumeric) {
 		tmp = 0.f;
 		bool speed_valid = false;
@@ -1471,6 +1567,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Time
+	osd_widget(OSD_WIDGET_TIME);
 	if (page->Time) {
 		uint32_t time;
 		SystemStatsFlightTimeGet(&time);
@@ -1489,6 +1586,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Throttle
+	osd_widget(OSD_WIDGET_THROTTLE);
 	if (page->Throttle) {
 		StabilizationDesiredThrustGet(&tmp);
 
@@ -1506,6 +1604,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Video Transmitter Frequency
+	osd_widget(OSD_WIDGET_VTX_FREQ);
 	if (page->VTXFreq && VTXInfoHandle()) {
 		uint16_t freq;
 		VTXInfoFrequencyGet(&freq);
@@ -1520,6 +1619,7 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 	}
 
 	// Video Transmitter Power
+	osd_widget(OSD_WIDGET_VTX_POWER);
 	if (page->VTXPower && VTXInfoHandle()) {
 		uint16_t power;
 		VTXInfoPowerGet(&power);
@@ -1724,6 +1824,11 @@ static float get_accessorydesired(int idx) {
 	return accessories[idx];
 }
 
+static void draw_user_page(void *ctx)
+{
+	render_user_page((OnScreenDisplayPageSettingsData *)ctx);
+}
+
 /**
  * Main osd task. It does not return.
  */
@@ -1852,11 +1957,13 @@ static void onScreenDisplayTask(__attribute__((unused)) void *parameters)
 				}
 
 				osd_settings_updated = false;
+				osd_retained_invalidate();
 			}
 
 			// update settings when video type changes
 			if (video_system_act != video_system_last) {
 				set_ntsc_pal_settings(video_system_act);
+				osd_retained_invalidate();
 			}
 
 			// decide whether to show blinking elements
@@ -1921,28 +2028,35 @@ static void onScreenDisplayTask(__attribute__((unused)) void *parameters)
 				}
 			}
 
-			clearGraphics();
 			switch (current_page) {
-			case ONSCREENDISPLAYSETTINGS_PAGECONFIG_OFF:
-				break;
-			case ONSCREENDISPLAYSETTINGS_PAGECONFIG_STATISTICS:
-				render_stats();
-				break;
-			case ONSCREENDISPLAYSETTINGS_PAGECONFIG_MENU:
-#ifdef OSD_USE_MENU
-				if ((arm_status == FLIGHTSTATUS_ARMED_DISARMED) ||
-						(osd_settings.DisableMenuWhenArmed == ONSCREENDISPLAYSETTINGS_DISABLEMENUWHENARMED_DISABLED)) {
-					render_osd_menu();
-					break;
-				}
-#endif
-				write_string("MENU DISABLED", GRAPHICS_X_MIDDLE, 50, 0, 0, TEXT_VA_TOP, TEXT_HA_CENTER, 0, 3);
 			case ONSCREENDISPLAYSETTINGS_PAGECONFIG_CUSTOM1:
 			case ONSCREENDISPLAYSETTINGS_PAGECONFIG_CUSTOM2:
 			case ONSCREENDISPLAYSETTINGS_PAGECONFIG_CUSTOM3:
 			case ONSCREENDISPLAYSETTINGS_PAGECONFIG_CUSTOM4:
-				render_user_page(&osd_page_settings);
-
+				// only redraws the widgets that changed
+				osd_retained_render(draw_user_page, &osd_page_settings);
+				break;
+			default:
+				osd_retained_invalidate();
+				clearGraphics();
+				switch (current_page) {
+				case ONSCREENDISPLAYSETTINGS_PAGECONFIG_OFF:
+					break;
+				case ONSCREENDISPLAYSETTINGS_PAGECONFIG_STATISTICS:
+					render_stats();
+					break;
+				case ONSCREENDISPLAYSETTINGS_PAGECONFIG_MENU:
+#ifdef OSD_USE_MENU
+					if ((arm_status == FLIGHTSTATUS_ARMED_DISARMED) ||
+							(osd_settings.DisableMenuWhenArmed == ONSCREENDISPLAYSETTINGS_DISABLEMENUWHENARMED_DISABLED)) {
+						render_osd_menu();
+						break;
+					}
+#endif
+					write_string("MENU DISABLED", GRAPHICS_X_MIDDLE, 50, 0, 0, TEXT_VA_TOP, TEXT_HA_CENTER, 0, 3);
+					render_user_page(&osd_page_settings);
+					break;
+				}
 				break;
 			}
 
@@ -1958,6 +2072,8 @@ static void onScreenDisplayTask(__attribute__((unused)) void *parameters)
 			char tmp_str[50];
 			sprintf(tmp_str, "%03d %03d", (int)in_time, (int)out_time);
 			write_string(tmp_str, GRAPHICS_X_MIDDLE, GRAPHICS_Y_MIDDLE - 20, 0, 0, TEXT_VA_TOP, TEXT_HA_CENTER, 0, FONT8X10);
+			// drawn outside the retained pages, so clear it next frame
+			osd_retained_invalidate();
 #endif
 		} else {
 			video_active = false;
@@ -0,0 +1,555 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup OnScreenDisplay Pixel OSD
+ * @{
+ *
+ * @brief Retained-mode rendering for the pixel OSD
+ * @file       osd_retained.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <pios.h>
+#include "pios_video.h"
+#include "osd_utils.h"
+#include "osd_retained.h"
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+extern uint8_t *draw_buffer_level;
+extern uint8_t *draw_buffer_mask;
+extern uint8_t *disp_buffer_level;
+extern uint8_t *disp_buffer_mask;
+#define DRAW_BUFFER_ID draw_buffer_level
+#define DISP_BUFFER_ID disp_buffer_level
+#else
+extern uint8_t *draw_buffer;
+extern uint8_t *disp_buffer;
+#define DRAW_BUFFER_ID draw_buffer
+#define DISP_BUFFER_ID disp_buffer
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
+/* Outlines, endcaps and the like reach a pixel or two past the
+ * coordinates a primitive is called with. */
+#define RECT_MARGIN 2
+
+#define SIG_EMPTY 2166136261u	/* FNV-1a offset basis */
+#define SIG_PRIME 16777619u
+
+/* Room for the drawing calls of one frame; a string takes its arguments
+ * plus its text, a line about eight words. */
+#define OP_LIST_WORDS 2048
+
+//! Inclusive pixel bounds; x0 > x1 when empty
+struct osd_rect {
+	int16_t x0, y0, x1, y1;
+};
+
+static const struct osd_rect rect_empty = { 1, 1, 0, 0 };
+
+enum widget_action {
+	WIDGET_RETAIN,
+	WIDGET_RENDER,
+	WIDGET_COPY,
+};
+
+struct osd_widget_state {
+	/* What the record pass of this frame saw */
+	uint32_t sig;
+	struct osd_rect rect;
+	bool overflowed;	/* Some calls didn't fit in op_list */
+
+	/* Area rasterized by the render pass of this frame */
+	struct osd_rect rendered;
+
+	/* Area to clear (or copy) before rendering */
+	struct osd_rect clear;
+	uint8_t action;
+
+	/* What each of the two video buffers holds */
+	uint32_t drawn_sig[2];
+	struct osd_rect drawn_rect[2];
+};
+
+enum render_pass {
+	PASS_RECORD,
+	PASS_REPLAY,
+	PASS_RENDER,	/* Draw function run again for overflowed widgets */
+};
+
+bool osd_retained_active;
+
+static struct osd_widget_state widgets[OSD_RETAINED_MAX_WIDGETS];
+
+/* Each recorded call is a header word (see op_header()), its arguments and
+ * then its text, if any, padded to a whole word. */
+static uintptr_t op_list[OP_LIST_WORDS];
+static uint16_t op_list_len;
+
+/* The video buffer each slot describes, NULL when unknown */
+static const uint8_t *slot_buffer[2];
+
+static uint8_t cur_widget;
+static uint8_t num_widgets = 1;	/* One past the highest id seen */
+static uint8_t pass;
+static struct osd_retained_stats last_stats;
+
+static inline bool rect_is_empty(const struct osd_rect *r)
+{
+	return r->x0 > r->x1;
+}
+
+static inline void rect_union(struct osd_rect *r, const struct osd_rect *o)
+{
+	if (rect_is_empty(o)) {
+		return;
+	}
+
+	if (rect_is_empty(r)) {
+		*r = *o;
+		return;
+	}
+
+	r->x0 = MIN(r->x0, o->x0);
+	r->y0 = MIN(r->y0, o->y0);
+	r->x1 = MAX(r->x1, o->x1);
+	r->y1 = MAX(r->y1, o->y1);
+}
+
+static inline bool rect_intersects(const struct osd_rect *a,
+		const struct osd_rect *b)
+{
+	if (rect_is_empty(a) || rect_is_empty(b)) {
+		return false;
+	}
+
+	return a->x0 <= b->x1 && b->x0 <= a->x1 &&
+		a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+static uint32_t call_sig(uint8_t op, const intptr_t *args, int num_args,
+		const char *str)
+{
+	uint32_t sig = (SIG_EMPTY ^ op) * SIG_PRIME;
+
+	for (int i = 0; i < num_args; i++) {
+		sig = (sig ^ (uint32_t) args[i]) * SIG_PRIME;
+	}
+
+	if (str) {
+		while (*str) {
+			sig = (sig ^ (uint8_t) *str++) * SIG_PRIME;
+		}
+	}
+
+	return sig;
+}
+
+static inline uintptr_t op_header(uint8_t op, uint8_t widget,
+		uint8_t num_args, uint8_t num_words)
+{
+	return op | (widget << 8) | (num_args << 16) |
+		((uintptr_t) num_words << 24);
+}
+
+/* Append a call to op_list, returning false when there's no room */
+static bool record_call(uint8_t op, const intptr_t *args, int num_args,
+		const char *str)
+{
+	int str_words = 0;
+	int str_len = 0;
+
+	if (str) {
+		str_len = strlen(str) + 1;
+		str_words = (str_len + sizeof(intptr_t) - 1) / sizeof(intptr_t);
+	}
+
+	int num_words = num_args + str_words;
+
+	if (num_words > UINT8_MAX ||
+			op_list_len + 1 + num_words > OP_LIST_WORDS) {
+		return false;
+	}
+
+	uintptr_t *rec = &op_list[op_list_len];
+
+	rec[0] = op_header(op, cur_widget, num_args, num_words);
+	memcpy(&rec[1], args, num_args * sizeof(intptr_t));
+	if (str) {
+		memcpy(&rec[1 + num_args], str, str_len);
+	}
+
+	op_list_len += 1 + num_words;
+
+	return true;
+}
+
+/**
+ * Note a drawing operation for the current widget.
+ * @param[in] op Operation code
+ * @param[in] args Arguments needed to repeat the operation
+ * @param[in] num_args Number of arguments
+ * @param[in] str Text drawn by the operation, or NULL
+ * @param[in] x0,y0,x1,y1 Corners of the area it may touch
+ * @return true if the operation should draw into the buffer
+ */
+bool osd_retained_op(uint8_t op, const intptr_t *args, int num_args,
+		const char *str, int x0, int y0, int x1, int y1)
+{
+	struct osd_widget_state *w = &widgets[cur_widget];
+
+	if (pass == PASS_RENDER &&
+			(w->action != WIDGET_RENDER || !w->overflowed)) {
+		return false;
+	}
+
+	struct osd_rect r = {
+		.x0 = MAX(MIN(x0, x1) - RECT_MARGIN, 0),
+		.y0 = MAX(MIN(y0, y1) - RECT_MARGIN, 0),
+		.x1 = MIN(MAX(x0, x1) + RECT_MARGIN,
+				BUFFER_WIDTH * PIXELS_PER_BIT - 1),
+		.y1 = MIN(MAX(y0, y1) + RECT_MARGIN, BUFFER_HEIGHT - 1),
+	};
+
+	if (r.x0 <= r.x1 && r.y0 <= r.y1) {
+		/* Whole bytes, so that clears and copies can be done
+		 * bytewise without disturbing neighbours. */
+		r.x0 &= ~(PIXELS_PER_BIT - 1);
+		r.x1 |= PIXELS_PER_BIT - 1;
+	} else {
+		r = rect_empty;
+	}
+
+	if (pass == PASS_RECORD) {
+		w->sig = (w->sig ^ call_sig(op, args, num_args, str)) *
+			SIG_PRIME;
+		rect_union(&w->rect, &r);
+
+		if (!record_call(op, args, num_args, str)) {
+			w->overflowed = true;
+		}
+
+		return false;
+	}
+
+	/* Replayed calls, and the primitives they are built from */
+
+	rect_union(&w->rendered, &r);
+
+	return true;
+}
+
+static void widget_new_frame(struct osd_widget_state *w)
+{
+	w->sig = SIG_EMPTY;
+	w->rect = rect_empty;
+	w->overflowed = false;
+	w->rendered = rect_empty;
+}
+
+void osd_widget(uint8_t id)
+{
+	PIOS_Assert(id < OSD_RETAINED_MAX_WIDGETS);
+
+	cur_widget = id;
+
+	/* First seen part way through this frame */
+	while (id >= num_widgets) {
+		widget_new_frame(&widgets[num_widgets++]);
+	}
+}
+
+bool osd_retained_first_pass(void)
+{
+	return !osd_retained_active || pass == PASS_RECORD;
+}
+
+void osd_retained_invalidate(void)
+{
+	slot_buffer[0] = NULL;
+	slot_buffer[1] = NULL;
+}
+
+void osd_retained_get_stats(struct osd_retained_stats *stats)
+{
+	*stats = last_stats;
+}
+
+static void clear_rect(const struct osd_rect *r)
+{
+	int start = r->x0 / PIXELS_PER_BIT;
+	int len = (r->x1 + 1) / PIXELS_PER_BIT - start;
+
+	for (int y = r->y0; y <= r->y1; y++) {
+		int addr = y * BUFFER_WIDTH + start;
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+		memset(&draw_buffer_mask[addr], 0, len);
+		memset(&draw_buffer_level[addr], 0, len);
+#else
+		memset(&draw_buffer[addr], 0, len);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+	}
+}
+
+static void copy_rect(const struct osd_rect *r)
+{
+	int start = r->x0 / PIXELS_PER_BIT;
+	int len = (r->x1 + 1) / PIXELS_PER_BIT - start;
+
+	for (int y = r->y0; y <= r->y1; y++) {
+		int addr = y * BUFFER_WIDTH + start;
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+		memcpy(&draw_buffer_mask[addr], &disp_buffer_mask[addr], len);
+		memcpy(&draw_buffer_level[addr], &disp_buffer_level[addr], len);
+#else
+		memcpy(&draw_buffer[addr], &disp_buffer[addr], len);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+	}
+}
+
+/* Work out which slot describes the draw buffer, starting it afresh if
+ * neither does. */
+static uint8_t select_slot(void)
+{
+	for (uint8_t s = 0; s < 2; s++) {
+		if (slot_buffer[s] == DRAW_BUFFER_ID) {
+			return s;
+		}
+	}
+
+	uint8_t s = (slot_buffer[0] == DISP_BUFFER_ID) ? 1 : 0;
+
+	clearGraphics();
+
+	slot_buffer[s] = DRAW_BUFFER_ID;
+
+	for (int i = 0; i < OSD_RETAINED_MAX_WIDGETS; i++) {
+		widgets[i].drawn_sig[s] = SIG_EMPTY;
+		widgets[i].drawn_rect[s] = rect_empty;
+	}
+
+	return s;
+}
+
+/* A widget can be copied from the display buffer when that holds the same
+ * content for it and nothing else is drawn anywhere near. */
+static bool can_copy(int idx, uint8_t s, uint8_t o)
+{
+	struct osd_widget_state *w = &widgets[idx];
+
+	if (slot_buffer[o] != DISP_BUFFER_ID || w->sig != w->drawn_sig[o]) {
+		return false;
+	}
+
+	struct osd_rect area = w->clear;
+	rect_union(&area, &w->drawn_rect[o]);
+
+	for (int i = 0; i < num_widgets; i++) {
+		const struct osd_widget_state *v = &widgets[i];
+
+		if (i == idx) {
+			continue;
+		}
+
+		if (rect_intersects(&area, &v->rect) ||
+				rect_intersects(&area, &v->drawn_rect[s]) ||
+				rect_intersects(&area, &v->drawn_rect[o])) {
+			return false;
+		}
+	}
+
+	w->clear = area;
+
+	return true;
+}
+
+static void resolve(uint8_t s, uint8_t o)
+{
+	for (int i = 0; i < num_widgets; i++) {
+		struct osd_widget_state *w = &widgets[i];
+
+		/* The same drawing calls touch the same pixels */
+		if (w->sig == w->drawn_sig[s]) {
+			w->action = WIDGET_RETAIN;
+			w->clear = rect_empty;
+		} else {
+			w->action = WIDGET_RENDER;
+			w->clear = w->drawn_rect[s];
+			rect_union(&w->clear, &w->rect);
+		}
+	}
+
+	/* Clearing a widget wipes out whatever overlaps it, which then has
+	 * to be drawn again too. */
+	bool changed;
+
+	do {
+		changed = false;
+
+		for (int i = 0; i < num_widgets; i++) {
+			struct osd_widget_state *w = &widgets[i];
+
+			if (w->action != WIDGET_RETAIN) {
+				continue;
+			}
+
+			for (int j = 0; j < num_widgets; j++) {
+				if (widgets[j].action == WIDGET_RENDER &&
+						rect_intersects(&w->drawn_rect[s],
+							&widgets[j].clear)) {
+					w->action = WIDGET_RENDER;
+					w->clear = w->drawn_rect[s];
+					changed = true;
+					break;
+				}
+			}
+		}
+	} while (changed);
+
+	for (int i = 0; i < num_widgets; i++) {
+		struct osd_widget_state *w = &widgets[i];
+
+		if (w->action == WIDGET_RENDER && !rect_is_empty(&w->clear) &&
+				can_copy(i, s, o)) {
+			w->action = WIDGET_COPY;
+		}
+	}
+
+	for (int i = 0; i < num_widgets; i++) {
+		struct osd_widget_state *w = &widgets[i];
+
+		if (rect_is_empty(&w->clear)) {
+			continue;
+		}
+
+		if (w->action == WIDGET_COPY) {
+			copy_rect(&w->clear);
+		} else if (w->action == WIDGET_RENDER) {
+			clear_rect(&w->clear);
+		}
+	}
+}
+
+/* Repeat the recorded calls of the widgets being rendered */
+static void replay(void)
+{
+	for (int pos = 0; pos < op_list_len; ) {
+		uintptr_t hdr = op_list[pos];
+		uint8_t op = hdr & 0xff;
+		uint8_t num_args = (hdr >> 16) & 0xff;
+		uint8_t num_words = (hdr >> 24) & 0xff;
+		struct osd_widget_state *w;
+
+		cur_widget = (hdr >> 8) & 0xff;
+		w = &widgets[cur_widget];
+
+		if (w->action == WIDGET_RENDER && !w->overflowed) {
+			osd_replay_op(op, (const intptr_t *) &op_list[pos + 1],
+					(char *) &op_list[pos + 1 + num_args]);
+		}
+
+		pos += 1 + num_words;
+	}
+}
+
+/**
+ * Bring the draw buffer up to date with what draw() produces, redrawing
+ * only the widgets that changed since that buffer was last drawn.
+ * @param[in] draw Draws the page, marking each widget with osd_widget()
+ * @param[in] ctx Passed to draw
+ */
+void osd_retained_render(void (*draw)(void *ctx), void *ctx)
+{
+	uint8_t s = select_slot();
+	uint8_t o = !s;
+	bool overflowed = false;
+
+	for (int i = 0; i < num_widgets; i++) {
+		widget_new_frame(&widgets[i]);
+	}
+
+	op_list_len = 0;
+
+	osd_retained_active = true;
+
+	pass = PASS_RECORD;
+	cur_widget = OSD_WIDGET_NONE;
+	draw(ctx);
+
+	resolve(s, o);
+
+	pass = PASS_REPLAY;
+	replay();
+
+	for (int i = 0; i < num_widgets; i++) {
+		if (widgets[i].action == WIDGET_RENDER &&
+				widgets[i].overflowed) {
+			overflowed = true;
+		}
+	}
+
+	if (overflowed) {
+		pass = PASS_RENDER;
+		cur_widget = OSD_WIDGET_NONE;
+		draw(ctx);
+	}
+
+	osd_retained_active = false;
+
+	memset(&last_stats, 0, sizeof(last_stats));
+
+	for (int i = 0; i < num_widgets; i++) {
+		struct osd_widget_state *w = &widgets[i];
+
+		switch (w->action) {
+		case WIDGET_RENDER:
+			/* A replay draws exactly the calls the signature
+			 * covers.  Values may have moved on by the time an
+			 * overflowed widget is drawn again, so mark those as
+			 * matching no signature, which redraws them next time.
+			 * Anything drawn outside the recorded area still gets
+			 * cleared.
+			 */
+			w->drawn_sig[s] = w->overflowed ? ~w->sig : w->sig;
+			w->drawn_rect[s] = w->rect;
+			rect_union(&w->drawn_rect[s], &w->rendered);
+			if (!rect_is_empty(&w->drawn_rect[s])) {
+				last_stats.rendered++;
+			}
+			break;
+		case WIDGET_COPY:
+			w->drawn_sig[s] = w->drawn_sig[o];
+			w->drawn_rect[s] = w->drawn_rect[o];
+			last_stats.copied++;
+			break;
+		default:
+			if (!rect_is_empty(&w->rect)) {
+				last_stats.retained++;
+			}
+			break;
+		}
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
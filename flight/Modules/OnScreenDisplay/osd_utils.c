@@ -33,19 +33,34 @@
  * of this source file; otherwise redistribution is prohibited.
  */
 
-#include <openpilot.h>
+#include <pios.h>
 #include "pios_video.h"
 #include "fonts.h"
 #include "osd_utils.h"
+#include "osd_retained.h"
 #include "physical_constants.h"
 #include "math.h"
 #include "misc_math.h"
 
-#include "gpsposition.h"
-#include "homelocation.h"
-
 extern struct FontEntry* fonts[NUM_FONTS];
 
+// Operation codes for the calls recorded by the retained renderer
+enum osd_op {
+	OSD_OP_IMAGE = 1,
+	OSD_OP_PIXEL,
+	OSD_OP_HLINE,
+	OSD_OP_HLINE_OUTLINED,
+	OSD_OP_VLINE,
+	OSD_OP_VLINE_OUTLINED,
+	OSD_OP_FILLED_RECT,
+	OSD_OP_RECT_OUTLINED,
+	OSD_OP_CIRCLE_OUTLINED,
+	OSD_OP_LINE,
+	OSD_OP_LINE_OUTLINED,
+	OSD_OP_LINE_OUTLINED_DASHED,
+	OSD_OP_STRING,
+};
+
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 extern uint8_t *draw_buffer_level;
 extern uint8_t *draw_buffer_mask;
@@ -69,6 +84,11 @@ void clearGraphics()
 
 void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_IMAGE, x, y, (intptr_t)image),
+			x, y, x + image->width, y + image->height)) {
+		return;
+	}
+
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 	CHECK_COORDS(x + image->width, y + image->height);
 	uint8_t byte_width = image->width / 8;
@@ -260,6 +280,11 @@ void write_pixel(int x, int y, uint8_t value)
  */
 void write_pixel_lm(int x, int y, int mmode, int lmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_PIXEL, x, y, mmode, lmode),
+			x, y, x, y)) {
+		return;
+	}
+
 	CHECK_COORDS(x, y);
 	// Determine the bit in the word to be set and the word
 	// index to set it in.
@@ -371,6 +396,11 @@ void write_hline(int x0, int x1, int y, uint8_t value)
  */
 void write_hline_lm(int x0, int x1, int y, int lmode, int mmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_HLINE, x0, x1, y, lmode, mmode),
+			x0, y, x1, y)) {
+		return;
+	}
+
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 	// TODO: an optimisation would compute the masks and apply to
 	// both buffers simultaneously.
@@ -396,6 +426,12 @@ void write_hline_lm(int x0, int x1, int y, int lmode, int mmode)
  */
 void write_hline_outlined(int x0, int x1, int y, int endcap0, int endcap1, int mode, int mmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_HLINE_OUTLINED, x0, x1, y,
+				endcap0, endcap1, mode, mmode),
+			x0, y, x1, y)) {
+		return;
+	}
+
 	int stroke, fill;
 
 	SETUP_STROKE_FILL(stroke, fill, mode);
@@ -482,6 +518,11 @@ void write_vline(int x, int y0, int y1, uint8_t value)
  */
 void write_vline_lm(int x, int y0, int y1, int lmode, int mmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_VLINE, x, y0, y1, lmode, mmode),
+			x, y0, x, y1)) {
+		return;
+	}
+
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 	// TODO: an optimisation would compute the masks and apply to
 	// both buffers simultaneously.
@@ -507,6 +548,12 @@ void write_vline_lm(int x, int y0, int y1, int lmode, int mmode)
  */
 void write_vline_outlined(int x, int y0, int y1, int endcap0, int endcap1, int mode, int mmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_VLINE_OUTLINED, x, y0, y1,
+				endcap0, endcap1, mode, mmode),
+			x, y0, x, y1)) {
+		return;
+	}
+
 	int stroke, fill;
 
 	if (y0 > y1) {
@@ -658,6 +705,12 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
  */
 void write_filled_rectangle_lm(int x, int y, int width, int height, int lmode, int mmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_FILLED_RECT, x, y, width, height,
+				lmode, mmode),
+			x, y, x + width, y + height)) {
+		return;
+	}
+
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 	write_filled_rectangle(draw_buffer_mask, x, y, width, height, mmode);
 	write_filled_rectangle(draw_buffer_level, x, y, width, height, lmode);
@@ -680,6 +733,12 @@ void write_filled_rectangle_lm(int x, int y, int width, int height, int lmode, i
  */
 void write_rectangle_outlined(int x, int y, int width, int height, int mode, int mmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_RECT_OUTLINED, x, y, width, height,
+				mode, mmode),
+			x, y, x + width, y + height)) {
+		return;
+	}
+
 	write_hline_outlined(x, x + width, y, ENDCAP_ROUND, ENDCAP_ROUND, mode, mmode);
 	write_hline_outlined(x, x + width, y + height, ENDCAP_ROUND, ENDCAP_ROUND, mode, mmode);
 	write_vline_outlined(x, y, y + height, ENDCAP_ROUND, ENDCAP_ROUND, mode, mmode);
@@ -728,6 +787,12 @@ void write_circle(uint8_t *buff, int cx, int cy, int r, int dashp, int mode)
  */
 void write_circle_outlined(int cx, int cy, int r, int dashp, int bmode, int mode, int mmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_CIRCLE_OUTLINED, cx, cy, r, dashp,
+				bmode, mode, mmode),
+			cx - r - 1, cy - r - 1, cx + r + 1, cy + r + 1)) {
+		return;
+	}
+
 	int stroke, fill;
 
 	CHECK_COORDS(cx, cy);
@@ -921,6 +986,11 @@ void write_line(int x0, int y0, int x1, int y1, uint8_t value)
  */
 void write_line_lm(int x0, int y0, int x1, int y1, int mmode, int lmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_LINE, x0, y0, x1, y1, mmode, lmode),
+			x0, y0, x1, y1)) {
+		return;
+	}
+
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 	write_line(draw_buffer_mask, x0, y0, x1, y1, mmode);
 	write_line(draw_buffer_level, x0, y0, x1, y1, lmode);
@@ -946,6 +1016,12 @@ void write_line_outlined(int x0, int y0, int x1, int y1,
 						 __attribute__((unused)) int endcap0, __attribute__((unused)) int endcap1,
 						 int mode, int mmode)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_LINE_OUTLINED, x0, y0, x1, y1,
+				endcap0, endcap1, mode, mmode),
+			x0, y0, x1, y1)) {
+		return;
+	}
+
 	// Based on http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
 	// This could be improved for speed.
 	int omode, imode;
@@ -1030,6 +1106,12 @@ void write_line_outlined_dashed(int x0, int y0, int x1, int y1,
 								__attribute__((unused)) int endcap0, __attribute__((unused)) int endcap1,
 								int mode, int mmode, int dots)
 {
+	if (OSD_RETAINED_SKIP(OSD_CALL(OSD_OP_LINE_OUTLINED_DASHED, x0, y0, x1, y1,
+				endcap0, endcap1, mode, mmode, dots),
+			x0, y0, x1, y1)) {
+		return;
+	}
+
 	// Based on http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
 	// This could be improved for speed.
 	int omode, imode;
@@ -1373,6 +1455,12 @@ void write_string(char *str, int x, int y, int xs, int ys, int va, int ha, int f
 		xx = x - dim.width;
 		break;
 	}
+	if (OSD_RETAINED_SKIP(OSD_CALL_STR(OSD_OP_STRING, str, x, y, xs, ys,
+					va, ha, flags, font),
+			xx, yy, xx + dim.width, yy + dim.height)) {
+		return;
+	}
+
 	// Then write each character.
 	xx_original = xx;
 	while (*str != 0) {
@@ -1437,38 +1525,57 @@ void draw_polygon(int16_t x, int16_t y, float angle, const point_t * points, uin
 }
 
 /**
- * Convert LLA to NED coordinates
- *
- * @param  latitude
- * @param  longitude
- * @param  altitude
- * @param output
+ * Repeat a drawing call recorded by the retained renderer.
+ * @param[in] op Operation code
+ * @param[in] a Arguments, in the order the primitive takes them
+ * @param[in] str Text for OSD_OP_STRING
  */
-void lla_to_ned(int32_t lattitude, int32_t longitude, float altitude, float *NED)
+void osd_replay_op(uint8_t op, const intptr_t *a, char *str)
 {
-	// TODO: Abstract out this code and also precompute the part based
-	// on home location.
-
-	HomeLocationData homeLocation;
-	HomeLocationGet(&homeLocation);
-
-	GPSPositionData gpsPosition;
-	GPSPositionGet(&gpsPosition);
-
-	float lat = lattitude / 10.0e6f * DEG2RAD;
-
-	float T[3];
-	T[0] = altitude + 6.378137E6f;
-	T[1] = cosf(lat) * (altitude + 6.378137E6f);
-	T[2] = -1.0f;
-
-	float dL[3] = {(lattitude - homeLocation.Latitude) / 10.0e6f * DEG2RAD,
-				   (longitude - homeLocation.Longitude) / 10.0e6f * DEG2RAD,
-				   (altitude + gpsPosition.GeoidSeparation - homeLocation.Altitude)};
-
-	NED[0] = T[0] * dL[0];
-	NED[1] = T[1] * dL[1];
-	NED[2] = T[2] * dL[2];
+	switch (op) {
+	case OSD_OP_IMAGE:
+		draw_image(a[0], a[1], (const struct Image *) a[2]);
+		break;
+	case OSD_OP_PIXEL:
+		write_pixel_lm(a[0], a[1], a[2], a[3]);
+		break;
+	case OSD_OP_HLINE:
+		write_hline_lm(a[0], a[1], a[2], a[3], a[4]);
+		break;
+	case OSD_OP_HLINE_OUTLINED:
+		write_hline_outlined(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+		break;
+	case OSD_OP_VLINE:
+		write_vline_lm(a[0], a[1], a[2], a[3], a[4]);
+		break;
+	case OSD_OP_VLINE_OUTLINED:
+		write_vline_outlined(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+		break;
+	case OSD_OP_FILLED_RECT:
+		write_filled_rectangle_lm(a[0], a[1], a[2], a[3], a[4], a[5]);
+		break;
+	case OSD_OP_RECT_OUTLINED:
+		write_rectangle_outlined(a[0], a[1], a[2], a[3], a[4], a[5]);
+		break;
+	case OSD_OP_CIRCLE_OUTLINED:
+		write_circle_outlined(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+		break;
+	case OSD_OP_LINE:
+		write_line_lm(a[0], a[1], a[2], a[3], a[4], a[5]);
+		break;
+	case OSD_OP_LINE_OUTLINED:
+		write_line_outlined(a[0], a[1], a[2], a[3], a[4], a[5], a[6],
+				a[7]);
+		break;
+	case OSD_OP_LINE_OUTLINED_DASHED:
+		write_line_outlined_dashed(a[0], a[1], a[2], a[3], a[4], a[5],
+				a[6], a[7], a[8]);
+		break;
+	case OSD_OP_STRING:
+		write_string(str, a[0], a[1], a[2], a[3], a[4], a[5], a[6],
+				a[7]);
+		break;
+	}
 }
 
 /**
@@ -31,12 +31,15 @@
 
 #include "openpilot.h"
 #include <eventdispatcher.h>
-#include <utlist.h>
+#include <deadlineheap.h>
 
 #include "systemmod.h"
 #include "sanitycheck.h"
 #include "taskinfo.h"
 #include "taskmonitor.h"
+#include "threadstats.h"
+#include "queuestats.h"
+#include "periodiceventstats.h"
 #include "pios_thread.h"
 #include "pios_mutex.h"
 #include "pios_queue.h"
@@ -45,6 +48,7 @@
 
 #include "annunciatorsettings.h"
 #include "flightstatus.h"
+#include "heapstats.h"
 #include "manualcontrolcommand.h"
 #include "manualcontrolsettings.h"
 #include "objectpersistence.h"
@@ -54,6 +58,11 @@
 #include "systemstats.h"
 #include "watchdogstatus.h"
 
+#if defined(PIOS_INCLUDE_PROFILER)
+#include "pios_profiler.h"
+#include "profilesamples.h"
+#endif
+
 #ifdef SYSTEMMOD_RGBLED_SUPPORT
 #include "rgbledsettings.h"
 #include "rgbleds.h"
@@ -85,6 +94,10 @@ extern annuncdac_dev_t pios_dac_annunciator_id;
 
 #define TASK_PRIORITY PIOS_THREAD_PRIO_NORMAL
 
+#if !defined(PIOS_PROFILER_RATE)
+#define PIOS_PROFILER_RATE 100	/* Hz */
+#endif
+
 /* When we're blinking morse code, this works out to 10.6 WPM.  It's also
  * nice and relatively prime to most other rates of things, so we don't get
  * bad beat frequencies. */
@@ -114,20 +127,24 @@ typedef struct {
 } EventCallbackInfo;
 
 /**
- * List of object properties that are needed for the periodic updates.
+ * Object properties that are needed for the periodic updates.
  */
-struct PeriodicObjectListStruct {
+typedef struct {
+	struct deadline_entry deadline; /** Period and next update; first, as the heap hands it back */
 	EventCallbackInfo evInfo; /** Event callback information */
-	uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
-	int32_t timeToNextUpdateMs; /** Time delay to the next update */
-	struct PeriodicObjectListStruct* next; /** Needed by linked list library (utlist.h) */
-};
-typedef struct PeriodicObjectListStruct PeriodicObjectList;
+#if defined(DIAG_TASKS)
+	/* Since the stats were last published */
+	uint16_t dispatched; /** Times the event was dispatched */
+	uint16_t missedPeriods; /** Whole periods skipped */
+	uint16_t latenessMaxMs; /** Worst lateness */
+	uint32_t latenessTotalMs; /** Sum of the lateness */
+#endif
+} PeriodicObject;
 
 // Private types
 
 // Private variables
-static PeriodicObjectList* objList;
+static struct deadline_heap periodicHeap;
 static struct pios_recursive_mutex *mutex;
 static EventStats stats;
 
@@ -160,10 +177,17 @@ static void configurationUpdatedCb(const UAVObjEvent *ev,
 void system_task();
 
 static inline void updateStats();
+static void updateHeapStats();
 static inline void updateSystemAlarms();
+#if defined(DIAG_TASKS)
+static void updatePeriodicEventStats();
+#endif
 #if defined(WDG_STATS_DIAGNOSTICS)
 static inline void updateWDGstats();
 #endif
+#if defined(PIOS_INCLUDE_PROFILER)
+static void updateProfileSamples();
+#endif
 
 /**
  * Create the module task.
@@ -194,6 +218,7 @@ int32_t SystemModInitialize(void)
 
 	if (SystemSettingsInitialize() == -1
 			|| SystemStatsInitialize() == -1
+			|| HeapStatsInitialize() == -1
 			|| FlightStatusInitialize() == -1
 			|| ObjectPersistenceInitialize() == -1
 			|| AnnunciatorSettingsInitialize() == -1
@@ -204,13 +229,20 @@ int32_t SystemModInitialize(void)
 		return -1;
 	}
 #if defined(DIAG_TASKS)
-	if (TaskInfoInitialize() == -1)
+	if (TaskInfoInitialize() == -1
+			|| ThreadStatsInitialize() == -1
+			|| QueueStatsInitialize() == -1
+			|| PeriodicEventStatsInitialize() == -1)
 		return -1;
 #endif
 #if defined(WDG_STATS_DIAGNOSTICS)
 	if (WatchdogStatusInitialize() == -1)
 		return -1;
 #endif
+#if defined(PIOS_INCLUDE_PROFILER)
+	if (ProfileSamplesInitialize() == -1)
+		return -1;
+#endif
 
 	objectPersistenceQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	if (objectPersistenceQueue == NULL)
@@ -240,6 +272,10 @@ void system_task()
 
 	TaskMonitorAdd(TASKINFO_RUNNING_SYSTEM, systemTaskHandle);
 
+#if defined(PIOS_INCLUDE_PROFILER)
+	PIOS_Profiler_Start(PIOS_PROFILER_RATE);
+#endif
+
 	// Listen for SettingPersistance object updates, connect a callback function
 	ObjectPersistenceConnectQueue(objectPersistenceQueue);
 
@@ -428,6 +464,9 @@ static void systemPeriodicCb(const UAVObjEvent *ev,
 
 	counter++;
 
+	// Pass alarm changes on to SystemAlarms
+	AlarmsPublish();
+
 #ifndef NO_SENSORS
 	if (config_check_needed) {
 		configuration_check();
@@ -444,6 +483,7 @@ static void systemPeriodicCb(const UAVObjEvent *ev,
 	if (fourth) {
 		// Update the system statistics
 		updateStats();
+		updateHeapStats();
 
 #ifndef PIPXTREME
 		// Update the system alarms
@@ -457,9 +497,14 @@ static void systemPeriodicCb(const UAVObjEvent *ev,
 #if defined(DIAG_TASKS)
 		// Update the task status object
 		TaskMonitorUpdateAll();
+		updatePeriodicEventStats();
 #endif
 	}
 
+#if defined(PIOS_INCLUDE_PROFILER)
+	updateProfileSamples();
+#endif
+
 #if defined(PIOS_INCLUDE_ANNUNC)
 	// Figure out what we should be doing.
 
@@ -729,6 +774,87 @@ static void updateWDGstats()
 }
 #endif
 
+#if defined(PIOS_INCLUDE_PROFILER)
+/* ProfileSamples Task values past the TaskInfo elements */
+#define PROFILE_TASK_INTERRUPT 0xfe
+#define PROFILE_TASK_UNKNOWN 0xff
+
+DONT_BUILD_IF(TASKINFO_RUNNING_NUMELEM > PROFILE_TASK_INTERRUPT,
+		ProfileSamplesTooManyTasks);
+
+/**
+ * Called periodically to hand the profiler samples on to telemetry and the
+ * log
+ */
+static void updateProfileSamples()
+{
+	struct pios_profiler_sample samples[PROFILESAMPLES_PC_NUMELEM];
+
+	uint16_t count = PIOS_Profiler_Read(samples, PROFILESAMPLES_PC_NUMELEM);
+
+	if (count == 0)
+		return;
+
+	ProfileSamplesData data;
+	ProfileSamplesGet(&data);
+
+	data.Sequence++;
+	data.Dropped = PIOS_Profiler_GetDropped();
+	data.Count = count;
+
+	for (uint16_t i = 0; i < PROFILESAMPLES_PC_NUMELEM; i++) {
+		if (i >= count) {
+			data.PC[i] = 0;
+			data.Task[i] = PROFILE_TASK_UNKNOWN;
+		} else if (samples[i].thread == 0) {
+			data.PC[i] = samples[i].pc;
+			data.Task[i] = PROFILE_TASK_INTERRUPT;
+		} else {
+			uint8_t task = TaskMonitorLookupThread(samples[i].thread);
+
+			data.PC[i] = samples[i].pc;
+			data.Task[i] = (task < TASKINFO_RUNNING_NUMELEM) ?
+				task : PROFILE_TASK_UNKNOWN;
+		}
+	}
+
+	ProfileSamplesSet(&data);
+}
+#endif
+
+/**
+ * Fill one element of each HeapStats field
+ */
+static void setHeapStats(HeapStatsData *data, int heap,
+		const struct pios_heap_stats *stats)
+{
+	data->Size[heap] = stats->total_bytes;
+	data->Free[heap] = stats->free_bytes;
+	data->MinFree[heap] = stats->min_free_bytes;
+	data->LargestFree[heap] = stats->largest_free;
+	data->Allocations[heap] = stats->allocations;
+	data->Failures[heap] = stats->failures;
+	data->Fragmentation[heap] = stats->free_bytes ?
+		100 - stats->largest_free * 100 / stats->free_bytes : 0;
+}
+
+/**
+ * Called periodically to update the heap stats
+ */
+static void updateHeapStats()
+{
+	struct pios_heap_stats stats;
+	HeapStatsData data;
+
+	PIOS_heap_get_stats(&stats);
+	setHeapStats(&data, HEAPSTATS_SIZE_STANDARD, &stats);
+
+	PIOS_fastheap_get_stats(&stats);
+	setHeapStats(&data, HEAPSTATS_SIZE_FAST, &stats);
+
+	HeapStatsSet(&data);
+}
+
 /**
  * Called periodically to update the system stats
  */
@@ -827,14 +953,19 @@ static void updateSystemAlarms()
 		AlarmsClear(SYSTEMALARMS_ALARM_EVENTSYSTEM);
 	}
 
+	SystemStatsData sysStats;
+	SystemStatsGet(&sysStats);
 	if (objStats.lastCallbackErrorID || objStats.lastQueueErrorID || evStats.lastErrorID) {
-		SystemStatsData sysStats;
-		SystemStatsGet(&sysStats);
 		sysStats.EventSystemWarningID = evStats.lastErrorID;
 		sysStats.ObjectManagerCallbackID = objStats.lastCallbackErrorID;
 		sysStats.ObjectManagerQueueID = objStats.lastQueueErrorID;
-		SystemStatsSet(&sysStats);
 	}
+	sysStats.EventMissedPeriods = evStats.missedPeriods;
+	sysStats.EventLatenessAverage = evStats.dispatched ?
+		(float)evStats.latenessTotalMs / evStats.dispatched : 0;
+	sysStats.EventLatenessMax = evStats.latenessMaxMs;
+	sysStats.EventLatenessMaxID = evStats.latenessMaxID;
+	SystemStatsSet(&sysStats);
 #endif
 }
 
@@ -922,6 +1053,31 @@ int32_t EventPeriodicQueueUpdate(UAVObjEvent* ev, struct pios_queue *queue, uint
 	return eventPeriodicUpdate(ev, 0, queue, periodMs);
 }
 
+static inline PeriodicObject *periodicObjectAt(uint16_t idx)
+{
+	return (PeriodicObject *) deadline_heap_at(&periodicHeap, idx);
+}
+
+/**
+ * Find a registered periodic event.
+ * \return The entry or NULL if there is none
+ */
+static PeriodicObject *findPeriodicObject(UAVObjEvent *ev, UAVObjEventCallback cb, struct pios_queue *queue)
+{
+	for (uint16_t i = 0; i < periodicHeap.len; i++) {
+		PeriodicObject *objEntry = periodicObjectAt(i);
+
+		if (objEntry->evInfo.cb == cb &&
+				objEntry->evInfo.queue == queue &&
+				objEntry->evInfo.ev.obj == ev->obj &&
+				objEntry->evInfo.ev.instId == ev->instId &&
+				objEntry->evInfo.ev.event == ev->event)
+			return objEntry;
+	}
+
+	return NULL;
+}
+
 /**
  * Dispatch an event through a callback at periodic intervals.
  * \param[in] ev The event to be dispatched
@@ -932,36 +1088,34 @@ int32_t EventPeriodicQueueUpdate(UAVObjEvent* ev, struct pios_queue *queue, uint
  */
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs)
 {
-	PeriodicObjectList* objEntry;
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	// Check that the object is not already connected
-	LL_FOREACH(objList, objEntry)
-	{
-		if (objEntry->evInfo.cb == cb &&
-				objEntry->evInfo.queue == queue &&
-				objEntry->evInfo.ev.obj == ev->obj &&
-				objEntry->evInfo.ev.instId == ev->instId &&
-				objEntry->evInfo.ev.event == ev->event)
-		{
-			// Already registered, do nothing
-			PIOS_Recursive_Mutex_Unlock(mutex);
-			return -1;
-		}
-	}
-	// Create handle
-	objEntry = (PeriodicObjectList*)PIOS_malloc_no_dma(sizeof(PeriodicObjectList));
-	if (objEntry == NULL) return -1;
+	PeriodicObject* objEntry;
+	// Create handle, before taking the lock
+	objEntry = (PeriodicObject*)PIOS_malloc_no_dma(sizeof(PeriodicObject));
+	if (objEntry == NULL)
+		return -1;
 	objEntry->evInfo.ev.obj = ev->obj;
 	objEntry->evInfo.ev.instId = ev->instId;
 	objEntry->evInfo.ev.event = ev->event;
 	objEntry->evInfo.ev.throttle = NULL;
 	objEntry->evInfo.cb = cb;
 	objEntry->evInfo.queue = queue;
-	objEntry->updatePeriodMs = periodMs;
-	objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
-	// Add to list
-	LL_APPEND(objList, objEntry);
+	objEntry->deadline.period_ms = periodMs;
+#if defined(DIAG_TASKS)
+	objEntry->dispatched = 0;
+	objEntry->missedPeriods = 0;
+	objEntry->latenessMaxMs = 0;
+	objEntry->latenessTotalMs = 0;
+#endif
+	// Get lock
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	// Check that the object is not already connected, and add to heap
+	if (findPeriodicObject(ev, cb, queue) != NULL ||
+			deadline_heap_add(&periodicHeap, &objEntry->deadline,
+				PIOS_Thread_Systime()) != 0) {
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		PIOS_free(objEntry);
+		return -1;
+	}
 	// Release lock
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return 0;
@@ -977,29 +1131,23 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
  */
 static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs)
 {
-	PeriodicObjectList* objEntry;
+	PeriodicObject* objEntry;
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	// Find object
-	LL_FOREACH(objList, objEntry)
-	{
-		if (objEntry->evInfo.cb == cb &&
-				objEntry->evInfo.queue == queue &&
-				objEntry->evInfo.ev.obj == ev->obj &&
-				objEntry->evInfo.ev.instId == ev->instId &&
-				objEntry->evInfo.ev.event == ev->event)
-		{
-			// Object found, update period
-			objEntry->updatePeriodMs = periodMs;
-			objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
-			// Release lock
-			PIOS_Recursive_Mutex_Unlock(mutex);
-			return 0;
-		}
+	objEntry = findPeriodicObject(ev, cb, queue);
+	if (objEntry == NULL) {
+		// The object was not found
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
 	}
-	// If this point is reached the object was not found
+	// Object found, update period
+	objEntry->deadline.period_ms = periodMs;
+	deadline_heap_reschedule(&periodicHeap, &objEntry->deadline,
+			PIOS_Thread_Systime());
+	// Release lock
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return -1;
+	return 0;
 }
 
 /* It can take this long before a "first callback" on a registration,
@@ -1008,62 +1156,152 @@ static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 #define MAX_UPDATE_PERIOD_MS 350
 
 /**
- * Handle periodic updates for all objects.
- * \return The system time until the next update (in ms) or -1 if failed
+ * Handle periodic updates for all objects that are due.
+ * \return The time until the next update (in ms)
  */
 static uint32_t processPeriodicUpdates()
 {
-	PeriodicObjectList* objEntry;
-	int32_t timeNow;
-	int32_t offset;
-
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	// Iterate through each object and update its timer, if zero then transmit object.
-	// Also calculate smallest delay to next update.
 	uint32_t now = PIOS_Thread_Systime();
-	uint32_t timeToNextUpdate = PIOS_Thread_Systime() + MAX_UPDATE_PERIOD_MS;
-	LL_FOREACH(objList, objEntry)
-	{
-		// If object is configured for periodic updates
-		if (objEntry->updatePeriodMs > 0)
+
+	// Pop due events off the heap, each at most once per call
+	for (uint16_t n = periodicHeap.len; n > 0; n--) {
+		uint32_t latenessMs, missed;
+		PeriodicObject *objEntry = (PeriodicObject *)
+			deadline_heap_pop_due(&periodicHeap, now, &latenessMs, &missed);
+
+		if (objEntry == NULL)
+			break;
+
+		++stats.dispatched;
+		stats.missedPeriods += missed;
+		stats.latenessTotalMs += latenessMs;
+		if (latenessMs > stats.latenessMaxMs) {
+			stats.latenessMaxMs = latenessMs;
+			stats.latenessMaxID = objEntry->evInfo.ev.obj ?
+				UAVObjGetID(objEntry->evInfo.ev.obj) : 0;
+		}
+
+#if defined(DIAG_TASKS)
+		if (objEntry->dispatched < UINT16_MAX)
+			++objEntry->dispatched;
+		if (objEntry->missedPeriods + missed < UINT16_MAX)
+			objEntry->missedPeriods += missed;
+		else
+			objEntry->missedPeriods = UINT16_MAX;
+		if (latenessMs > objEntry->latenessMaxMs)
+			objEntry->latenessMaxMs = (latenessMs < UINT16_MAX) ? latenessMs : UINT16_MAX;
+		objEntry->latenessTotalMs += latenessMs;
+#endif
+
+		// Invoke callback, if one
+		if ( objEntry->evInfo.cb != 0)
 		{
-			// Check if time for the next update
-			timeNow = PIOS_Thread_Systime();
-			if (objEntry->timeToNextUpdateMs <= timeNow)
-			{
-				// Reset timer
-				offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
-				objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-				// Invoke callback, if one
-				if ( objEntry->evInfo.cb != 0)
-				{
-					objEntry->evInfo.cb(&objEntry->evInfo.ev, NULL, NULL, 0); // the function is expected to copy the event information
-				}
-				// Push event to queue, if one
-				if ( objEntry->evInfo.queue != 0)
-				{
-					if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
-					{
-						if (objEntry->evInfo.ev.obj != NULL)
-							stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-						++stats.eventErrors;
-					}
-				}
-			}
-			// Update minimum delay
-			if (objEntry->timeToNextUpdateMs < timeToNextUpdate)
+			objEntry->evInfo.cb(&objEntry->evInfo.ev, NULL, NULL, 0); // the function is expected to copy the event information
+		}
+		// Push event to queue, if one
+		if ( objEntry->evInfo.queue != 0)
+		{
+			if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
 			{
-				timeToNextUpdate = objEntry->timeToNextUpdateMs;
+				if (objEntry->evInfo.ev.obj != NULL)
+					stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
+				++stats.eventErrors;
 			}
 		}
+
+		// Callbacks take time; measure the next event against the clock
+		now = PIOS_Thread_Systime();
 	}
 
+	uint32_t timeToNextUpdate = deadline_heap_time_to_next(&periodicHeap,
+			now, MAX_UPDATE_PERIOD_MS);
+
 	// Done
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return timeToNextUpdate - now;
+	return timeToNextUpdate;
+}
+
+#if defined(DIAG_TASKS)
+/**
+ * Publish the timing of the periodic events that ran latest, worst first,
+ * and restart the counts of all of them.  The events are ranked into a
+ * fixed buffer under the dispatcher lock; the object is set after it is
+ * released.
+ */
+static void updatePeriodicEventStats()
+{
+	struct {
+		uint32_t objectId;
+		uint32_t latenessTotalMs;
+		uint16_t period;
+		uint16_t dispatched;
+		uint16_t missedPeriods;
+		uint16_t latenessMaxMs;
+	} worst[PERIODICEVENTSTATS_PERIOD_NUMELEM];
+	uint16_t listed = 0;
+	uint16_t eventCount;
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	eventCount = periodicHeap.len;
+
+	for (uint16_t i = 0; i < periodicHeap.len; i++) {
+		PeriodicObject *objEntry = periodicObjectAt(i);
+
+		// Rank by worst lateness, then by periods missed
+		uint16_t pos = listed;
+
+		while (pos > 0 &&
+				(objEntry->latenessMaxMs > worst[pos - 1].latenessMaxMs ||
+				 (objEntry->latenessMaxMs == worst[pos - 1].latenessMaxMs &&
+				  objEntry->missedPeriods > worst[pos - 1].missedPeriods))) {
+			if (pos < NELEMENTS(worst))
+				worst[pos] = worst[pos - 1];
+			pos--;
+		}
+
+		if (pos < NELEMENTS(worst)) {
+			worst[pos].objectId = objEntry->evInfo.ev.obj ?
+				UAVObjGetID(objEntry->evInfo.ev.obj) : 0;
+			worst[pos].latenessTotalMs = objEntry->latenessTotalMs;
+			worst[pos].period = objEntry->deadline.period_ms;
+			worst[pos].dispatched = objEntry->dispatched;
+			worst[pos].missedPeriods = objEntry->missedPeriods;
+			worst[pos].latenessMaxMs = objEntry->latenessMaxMs;
+
+			if (listed < NELEMENTS(worst))
+				listed++;
+		}
+
+		objEntry->dispatched = 0;
+		objEntry->missedPeriods = 0;
+		objEntry->latenessMaxMs = 0;
+		objEntry->latenessTotalMs = 0;
+	}
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	PeriodicEventStatsData data;
+
+	memset(&data, 0, sizeof(data));
+	data.EventCount = eventCount;
+
+	for (uint16_t i = 0; i < listed; i++) {
+		data.ObjectID[i] = worst[i].objectId;
+		data.Period[i] = worst[i].period;
+		data.Dispatched[i] = worst[i].dispatched;
+		data.MissedPeriods[i] = worst[i].missedPeriods;
+		data.LatenessMax[i] = worst[i].latenessMaxMs;
+		data.LatenessAverage[i] = worst[i].dispatched ?
+			(float)worst[i].latenessTotalMs / worst[i].dispatched : 0;
+	}
+
+	PeriodicEventStatsSet(&data);
 }
+#endif /* DIAG_TASKS */
 
 DONT_BUILD_IF(ANNUNCIATORSETTINGS_MANUALBUZZER_MAXOPTVAL >
 	MANUALCONTROLCOMMAND_ACCESSORY_NUMELEM, TooManyManualBuzzers);
@@ -37,6 +37,7 @@
 #include "flighttelemetrystats.h"
 #include "gcstelemetrystats.h"
 #include "modulesettings.h"
+#include "objectmanifest.h"
 #include "pios_thread.h"
 #include "pios_mutex.h"
 #include "pios_queue.h"
@@ -102,6 +103,10 @@ struct telemetry_state {
 
 	struct pios_mutex *reqack_mutex;
 
+	/* Next manifest entry to send; only touched by the TX task */
+	uint16_t manifest_next;
+	bool manifest_active;
+
 	struct pios_semaphore *access_sem;
 	volatile bool request_inhibit, tx_inhibited, rx_inhibited;
 
@@ -131,6 +136,7 @@ static void updateSettings();
 static uintptr_t getComPort();
 static void update_object_instances(uint32_t obj_id, uint32_t inst_id);
 static bool processUsbActivity(bool seen_active);
+static void sendManifestChunk(telem_t telem);
 
 static int32_t fileReqCallback(void *ctx, uint8_t *buf,
                 uint32_t file_id, uint32_t offset, uint32_t len);
@@ -181,7 +187,8 @@ int32_t TelemetryStart(void)
 int32_t TelemetryInitialize(void)
 {
 	if (FlightTelemetryStatsInitialize() == -1 ||
-			GCSTelemetryStatsInitialize() == -1) {
+			GCSTelemetryStatsInitialize() == -1 ||
+			ObjectManifestInitialize() == -1) {
 		return -1;
 	}
 
@@ -630,7 +637,11 @@ static bool sendRequestedObjs(telem_t telem)
 	UAVObjHandle obj = UAVObjGetByID(preq.obj_id);
 
 	// Send requested object if message is of type OBJ_REQ
-	if (!obj) {
+	if (obj && (obj == ObjectManifestHandle())) {
+		/* (Re)start streaming the manifest from the beginning */
+		telem->manifest_next = 0;
+		telem->manifest_active = true;
+	} else if (!obj) {
 		UAVTalkSendNack(telem->uavTalkCon, preq.obj_id,
 				preq.inst_id);
 	} else {
@@ -677,8 +688,10 @@ static void telemetryTxTask(void *parameters)
 
 		telem->tx_inhibited = false;
 
-		// Wait for queue message or short timeout
-		retval = PIOS_Queue_Receive(telem->queue, &ev, 10);
+		// Wait for queue message or short timeout; don't wait while
+		// the manifest is streaming.
+		retval = PIOS_Queue_Receive(telem->queue, &ev,
+				telem->manifest_active ? 0 : 10);
 
 		PIOS_Mutex_Lock(telem->reqack_mutex,
 				PIOS_MUTEX_TIMEOUT_MAX);
@@ -693,6 +706,62 @@ static void telemetryTxTask(void *parameters)
 			processObjEvent(telem, &ev);
 		}
 
+		if (telem->manifest_active) {
+			sendManifestChunk(telem);
+		}
+	}
+}
+
+/**
+ * Sends the next few entries of the object manifest.  Every data object is
+ * listed followed by its metaobject, with a checksum of the contents so
+ * that the GCS can tell which objects it needs to fetch.
+ *
+ * \param[in] telem Telemetry subsystem handle
+ */
+static void sendManifestChunk(telem_t telem)
+{
+	/* Kept off the TX task's small stack; only the TX task gets here */
+	static ObjectManifestData manifest;
+
+	memset(&manifest, 0, sizeof(manifest));
+
+	manifest.Start = telem->manifest_next;
+	manifest.Total = UAVObjCount() * 2;
+
+	for (int i = 0; i < OBJECTMANIFEST_OBJID_NUMELEM; i++) {
+		uint16_t entry = telem->manifest_next;
+
+		if (entry >= manifest.Total) {
+			break;
+		}
+
+		telem->manifest_next++;
+
+		UAVObjHandle obj = UAVObjGetByID(UAVObjIDByIndex(entry / 2));
+
+		if (!obj) {
+			continue;
+		}
+
+		if (entry & 1) {
+			obj = UAVObjGetLinkedObj(obj);
+		}
+
+		manifest.ObjID[i] = UAVObjGetID(obj);
+		manifest.Instances[i] = UAVObjGetNumInstances(obj);
+		manifest.CRC[i] = UAVObjGetContentCRC(obj);
+	}
+
+	if (telem->manifest_next >= manifest.Total) {
+		telem->manifest_active = false;
+	}
+
+	ObjectManifestSet(&manifest);
+
+	if (UAVTalkSendObject(telem->uavTalkCon, ObjectManifestHandle(), 0,
+				false) == -1) {
+		telem->tx_errors++;
 	}
 }
 
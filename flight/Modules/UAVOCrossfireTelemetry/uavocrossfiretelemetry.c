@@ -40,11 +40,9 @@
 #include "uavocrossfiretelemetry.h"
 
 #include "modulesettings.h"
-#include "flightbatterystate.h"
-#include "flightbatterysettings.h"
 #include "gpsposition.h"
-#include "attitudeactual.h"
 #include "manualcontrolsettings.h"
+#include "telemetryview.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 600		// Reevaluate.
@@ -59,6 +57,13 @@ static bool module_enabled;
 // Crossfire receiver device
 static uintptr_t crsf_telem_dev_id;
 
+static struct telemetryview *view;
+
+//! Version of the view section each frame was last sent from
+static uint16_t attitude_version;
+static uint16_t battery_version;
+static uint16_t gps_version;
+
 static void uavoCrossfireTelemetryTask(void *parameters);
 
 /**
@@ -75,6 +80,10 @@ static int32_t uavoCrossfireTelemetryStart(void)
 	if(rcvr) {
 		crsf_telem_dev_id = PIOS_RCVR_GetLowerDevice(rcvr);
 		if (module_enabled && (PIOS_Crossfire_InitTelemetry(crsf_telem_dev_id) == 0)) {
+			TelemetryViewSubscribe(TELEMETRYVIEW_ATTITUDE);
+			TelemetryViewSubscribe(TELEMETRYVIEW_BATTERY);
+			TelemetryViewSubscribe(TELEMETRYVIEW_GPS);
+
 			// Start task
 			uavoCrossfireTelemetryTaskHandle = PIOS_Thread_Create(
 					uavoCrossfireTelemetryTask, "uavoCrossfireTelemetry",
@@ -91,6 +100,17 @@ static int32_t uavoCrossfireTelemetryStart(void)
 static int32_t uavoCrossfireTelemetryInitialize(void)
 {
 	module_enabled = PIOS_Modules_IsEnabled(PIOS_MODULE_UAVOCROSSFIRETELEMETRY); 
+
+	if (module_enabled) {
+		view = PIOS_malloc_no_dma(sizeof(*view));
+		if (view == NULL) {
+			module_enabled = false;
+			return -1;
+		}
+
+		memset(view, 0, sizeof(*view));
+	}
+
 	return 0;
 }
 MODULE_INITCALL(uavoCrossfireTelemetryInitialize, uavoCrossfireTelemetryStart)
@@ -104,17 +124,18 @@ static int crsftelem_create_attitude(uint8_t *buf)
 {
 	int pos = 0;
 
-	if(AttitudeActualHandle()) {
-		AttitudeActualData attitudeData;
-		AttitudeActualGet(&attitudeData);
+	if(attitude_version != view->version[TELEMETRYVIEW_ATTITUDE]) {
+		const struct telemetryview_attitude *attitudeData = &view->attitude;
+
+		attitude_version = view->version[TELEMETRYVIEW_ATTITUDE];
 
 		buf[pos++] = 0;
 		buf[pos++] = CRSF_PAYLOAD_LEN(CRSF_PAYLOAD_ATTITUDE);
 		buf[pos++] = CRSF_FRAME_ATTITUDE;
 
-		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(attitudeData.Pitch)*10000.0f));
-		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(attitudeData.Roll)*10000.0f));
-		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(attitudeData.Yaw)*10000.0f));
+		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(attitudeData->pitch)*10000.0f));
+		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(attitudeData->roll)*10000.0f));
+		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(attitudeData->yaw)*10000.0f));
 
 		buf[pos++] = PIOS_CRC_updateCRC_TBS(0, buf+2, buf[1] - CRSF_CRC_LEN);
 	}
@@ -126,26 +147,25 @@ static int crsftelem_create_battery(uint8_t *buf)
 {
 	int pos = 0;
 
-	if(FlightBatteryStateHandle() && FlightBatterySettingsHandle()) {
-		FlightBatteryStateData batteryData;
-		FlightBatterySettingsData batterySettings;
+	const struct telemetryview_battery *batteryData = &view->battery;
 
-		FlightBatteryStateGet(&batteryData);
-		FlightBatterySettingsGet(&batterySettings);
+	if(batteryData->present && batteryData->has_settings &&
+			battery_version != view->version[TELEMETRYVIEW_BATTERY]) {
+		battery_version = view->version[TELEMETRYVIEW_BATTERY];
 
 		buf[pos++] = 0;
 		buf[pos++] = CRSF_PAYLOAD_LEN(CRSF_PAYLOAD_BATTERY);
 		buf[pos++] = CRSF_FRAME_BATTERY;
 
-		WRITE_VAL16(buf, pos, (uint16_t)(batteryData.Voltage * 10.0f))
-		WRITE_VAL16(buf, pos, (uint16_t)(batteryData.Current * 10.0f))
+		WRITE_VAL16(buf, pos, (uint16_t)(batteryData->voltage * 10.0f))
+		WRITE_VAL16(buf, pos, (uint16_t)(batteryData->current * 10.0f))
 
 		// Should apparently be capacity used?
-		buf[pos++] = (uint8_t)((batterySettings.Capacity & 0x00FF0000) >> 16);
-		buf[pos++] = (uint8_t)((batterySettings.Capacity & 0x0000FF00) >> 8);
-		buf[pos++] = (uint8_t)(batterySettings.Capacity & 0x000000FF);
+		buf[pos++] = (uint8_t)((batteryData->capacity & 0x00FF0000) >> 16);
+		buf[pos++] = (uint8_t)((batteryData->capacity & 0x0000FF00) >> 8);
+		buf[pos++] = (uint8_t)(batteryData->capacity & 0x000000FF);
 
-		float charge_state = batterySettings.Capacity == 0 ? 100.0f : (batteryData.ConsumedEnergy / batterySettings.Capacity);
+		float charge_state = batteryData->capacity == 0 ? 100.0f : (batteryData->consumed_energy / batteryData->capacity);
 		if(charge_state < 0) charge_state = 0;
 		else if(charge_state > 100) charge_state = 100;
 		buf[pos++] = (uint8_t)charge_state;
@@ -160,28 +180,29 @@ static int crsftelem_create_gps(uint8_t *buf)
 {
 	int pos = 0;
 
-	if(GPSPositionHandle()) {
-		GPSPositionData gpsData;
-		GPSPositionGet(&gpsData);
+	if(view->gps.present && gps_version != view->version[TELEMETRYVIEW_GPS]) {
+		const struct telemetryview_gps *gpsData = &view->gps;
+
+		gps_version = view->version[TELEMETRYVIEW_GPS];
 
-		if(gpsData.Status >= GPSPOSITION_STATUS_FIX2D) {
+		if(gpsData->status >= GPSPOSITION_STATUS_FIX2D) {
 			buf[pos++] = 0;
 			buf[pos++] = CRSF_PAYLOAD_LEN(CRSF_PAYLOAD_GPS);
 			buf[pos++] = CRSF_FRAME_GPS;
 
 			// Latitude (x10^7, as dRonin)
-			WRITE_VAL32(buf, pos, (int32_t)gpsData.Latitude);
+			WRITE_VAL32(buf, pos, (int32_t)gpsData->latitude);
 			// Longitude (x10^7, as dRonin)
-			WRITE_VAL32(buf, pos, (int32_t)gpsData.Longitude);
+			WRITE_VAL32(buf, pos, (int32_t)gpsData->longitude);
 			// Groundspeed (apparently tenth of km/h)
-			WRITE_VAL16(buf, pos, (uint16_t)(gpsData.Groundspeed*10.0f));
+			WRITE_VAL16(buf, pos, (uint16_t)(gpsData->groundspeed*10.0f));
 			// Heading (apparently hundreth of a degree)
-			WRITE_VAL16(buf, pos, (uint16_t)(gpsData.Heading*100.0f));
+			WRITE_VAL16(buf, pos, (uint16_t)(gpsData->heading*100.0f));
 			// Altitude 1000 = 0m
 			WRITE_VAL16(buf, pos, (uint16_t)(1000.0f+
-				(gpsData.Status >= GPSPOSITION_STATUS_FIX3D ? gpsData.Altitude : 0.0f)));
+				(gpsData->status >= GPSPOSITION_STATUS_FIX3D ? gpsData->altitude : 0.0f)));
 			// Satellites
-			buf[pos++] = gpsData.Satellites;
+			buf[pos++] = gpsData->satellites;
 
 			buf[pos++] = PIOS_CRC_updateCRC_TBS(0, buf+2, buf[1] - CRSF_CRC_LEN);
 		}
@@ -204,6 +225,9 @@ static void uavoCrossfireTelemetryTask(void *parameters)
 		uint8_t len = 0;
 
 		if(!PIOS_Crossfire_IsFailsafed(crsf_telem_dev_id)) {
+			TelemetryViewRead(view, TELEMETRYVIEW_ATTITUDE);
+			TelemetryViewRead(view, TELEMETRYVIEW_BATTERY);
+			TelemetryViewRead(view, TELEMETRYVIEW_GPS);
 
 			switch(counter++ % 3) {
 				default:
@@ -54,16 +54,9 @@
 #include "openpilot.h"
 #include "modulesettings.h"
 
-#include "accels.h"
-#include "airspeedactual.h"
-#include "attitudeactual.h"
-#include "baroaltitude.h"
 #include "flightstatus.h"
 #include "gpsposition.h"
-#include "flightbatterysettings.h"
-#include "flightbatterystate.h"
-#include "manualcontrolcommand.h"
-#include "positionactual.h"
+#include "telemetryview.h"
 
 #include "pios_thread.h"
 #include "pios_modules.h"
@@ -93,6 +86,12 @@ static struct pios_thread *taskHandle;
 static uint32_t lighttelemetryPort;
 static uint8_t ltm_scheduler;
 static uint8_t ltm_slowrate;
+static struct telemetryview *view;
+
+//! Version of the view section each frame was last sent from
+static uint16_t gframe_version;
+static uint16_t aframe_version;
+static uint16_t sframe_version;
 
 // Private functions
 static void uavoLighttelemetryBridgeTask(void *parameters);
@@ -113,6 +112,12 @@ int32_t uavoLighttelemetryBridgeInitialize()
 	lighttelemetryPort = PIOS_COM_LIGHTTELEMETRY;
 
 	if (lighttelemetryPort && PIOS_Modules_IsEnabled(PIOS_MODULE_UAVOLIGHTTELEMETRYBRIDGE)) {
+		view = PIOS_malloc_no_dma(sizeof(*view));
+		if (view == NULL)
+			return -1;
+
+		memset(view, 0, sizeof(*view));
+
 		// Update telemetry settings
 		module_enabled = true;
 		return 0;
@@ -129,6 +134,12 @@ int32_t uavoLighttelemetryBridgeStart()
 {
 	if ( module_enabled )
 	{
+		TelemetryViewSubscribe(TELEMETRYVIEW_ATTITUDE);
+		TelemetryViewSubscribe(TELEMETRYVIEW_STATUS);
+		TelemetryViewSubscribe(TELEMETRYVIEW_BATTERY);
+		TelemetryViewSubscribe(TELEMETRYVIEW_GPS);
+		TelemetryViewSubscribe(TELEMETRYVIEW_NAVIGATION);
+
 		taskHandle = PIOS_Thread_Create(uavoLighttelemetryBridgeTask, "uavoLighttelemetryBridge", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 		TaskMonitorAdd(TASKINFO_RUNNING_UAVOLIGHTTELEMETRYBRIDGE, taskHandle);
 		return 0;
@@ -154,6 +165,9 @@ static void uavoLighttelemetryBridgeTask(void *parameters)
 	{
 		int ret = 0;
 
+		for (int i = 0; i < TELEMETRYVIEW_NUM_SECTIONS; i++)
+			TelemetryViewRead(view, i);
+
 		if (!ret) {
 			switch (ltm_scheduler) {
 				case 0:
@@ -210,35 +224,28 @@ static void uavoLighttelemetryBridgeTask(void *parameters)
 //GPS packet
 static int send_LTM_Gframe()
 {
-	GPSPositionData pdata = { };	/* Set to all 0's */
-
-	bool have_gps = false;
+	const struct telemetryview_gps *pdata = &view->gps;
+	const struct telemetryview_navigation *nav = &view->navigation;
 
-	if (GPSPositionHandle() != NULL) {
-		have_gps = true;
-		GPSPositionGet(&pdata);
-	}
+	if (gframe_version == view->version[TELEMETRYVIEW_GPS])
+		return 0;	/* Nothing new since the last one */
 
-	int32_t lt_latitude = pdata.Latitude;
-	int32_t lt_longitude = pdata.Longitude;
-	uint8_t lt_groundspeed = (uint8_t)roundf(pdata.Groundspeed); //rounded m/s .
+	int32_t lt_latitude = pdata->latitude;
+	int32_t lt_longitude = pdata->longitude;
+	uint8_t lt_groundspeed = (uint8_t)roundf(pdata->groundspeed); //rounded m/s .
 	int32_t lt_altitude = 0;
-	if (PositionActualHandle() != NULL) {
-		float altitude;
-		PositionActualDownGet(&altitude);
-		lt_altitude = (int32_t)roundf(altitude * -100.0f);
-	} else if (BaroAltitudeHandle() != NULL) {
-		float altitude;
-		BaroAltitudeAltitudeGet(&altitude);
-		lt_altitude = (int32_t)roundf(altitude * 100.0f); //Baro alt in cm.
-	} else if (have_gps) {
-		lt_altitude = (int32_t)roundf(pdata.Altitude * 100.0f); //GPS alt in cm.
+	if (nav->has_position) {
+		lt_altitude = (int32_t)roundf(nav->down * -100.0f);
+	} else if (nav->has_baro) {
+		lt_altitude = (int32_t)roundf(nav->baro_altitude * 100.0f); //Baro alt in cm.
+	} else if (pdata->present) {
+		lt_altitude = (int32_t)roundf(pdata->altitude * 100.0f); //GPS alt in cm.
 	} else {
 		return 0;	/* Don't even bother, no data for this frame! */
 	}
 	
 	uint8_t lt_gpsfix;
-	switch (pdata.Status) {
+	switch (pdata->status) {
 	case GPSPOSITION_STATUS_NOGPS:
 		lt_gpsfix = 0;
 		break;
@@ -256,7 +263,7 @@ static int send_LTM_Gframe()
 		break;
 	}
 	
-	uint8_t lt_gpssats = (int8_t)pdata.Satellites;
+	uint8_t lt_gpssats = (int8_t)pdata->satellites;
 	//pack G frame	
 	uint8_t LTBuff[LTM_GFRAME_SIZE];
 	//G Frame: $T(2 bytes)G(1byte)LAT(cm,4 bytes)LON(cm,4bytes)SPEED(m/s,1bytes)ALT(cm,4bytes)SATS(6bits)FIX(2bits)CRC(xor,1byte)
@@ -281,18 +288,26 @@ static int send_LTM_Gframe()
 	LTBuff[15] = (lt_altitude >> 8*3) & 0xFF;
 	LTBuff[16] = ((lt_gpssats << 2)& 0xFF ) | (lt_gpsfix & 0b00000011) ; // last 6 bits: sats number, first 2:fix type (0,1,2,3)
 
-	return send_LTM_Packet(LTBuff,LTM_GFRAME_SIZE);
+	if (send_LTM_Packet(LTBuff, LTM_GFRAME_SIZE))
+		return -1;
+
+	gframe_version = view->version[TELEMETRYVIEW_GPS];
+
+	return 0;
 }
 
 //Attitude packet
 static int send_LTM_Aframe()
 {
+	const struct telemetryview_attitude *adata = &view->attitude;
+
+	if (aframe_version == view->version[TELEMETRYVIEW_ATTITUDE])
+		return 0;	/* Nothing new since the last one */
+
 	//prepare data
-	AttitudeActualData adata;
-	AttitudeActualGet(&adata);
-	int16_t lt_pitch   = (int16_t)(roundf(adata.Pitch));	//-180/180°
-	int16_t lt_roll	   = (int16_t)(roundf(adata.Roll));		//-180/180°
-	int16_t lt_heading = (int16_t)(roundf(adata.Yaw));		//-180/180°
+	int16_t lt_pitch   = (int16_t)(roundf(adata->pitch));	//-180/180°
+	int16_t lt_roll	   = (int16_t)(roundf(adata->roll));		//-180/180°
+	int16_t lt_heading = (int16_t)(roundf(adata->yaw));		//-180/180°
 	//pack A frame	
 	uint8_t LTBuff[LTM_AFRAME_SIZE];
 	
@@ -310,12 +325,22 @@ static int send_LTM_Aframe()
 	LTBuff[7] = (lt_heading >> 8*0) & 0xFF;
 	LTBuff[8] = (lt_heading >> 8*1) & 0xFF;
 
-	return send_LTM_Packet(LTBuff,LTM_AFRAME_SIZE);
+	if (send_LTM_Packet(LTBuff, LTM_AFRAME_SIZE))
+		return -1;
+
+	aframe_version = view->version[TELEMETRYVIEW_ATTITUDE];
+
+	return 0;
 }
 
 //Sensors packet
 static int send_LTM_Sframe()
 {
+	const struct telemetryview_status *fdata = &view->status;
+
+	if (sframe_version == view->version[TELEMETRYVIEW_STATUS])
+		return 0;	/* Nothing new since the last one */
+
 	//prepare data
 	uint16_t lt_vbat = 0;
 	uint16_t lt_amp = 0;
@@ -326,35 +351,23 @@ static int send_LTM_Sframe()
 	uint8_t	 lt_flightmode = 0;
 	
 	
-	if (FlightBatteryStateHandle() != NULL) {
-		FlightBatteryStateData sdata;
-		FlightBatteryStateGet(&sdata);
-		lt_vbat = (uint16_t)roundf(sdata.Voltage*1000);	  //Battery voltage in mv
-		lt_amp = (uint16_t)roundf(sdata.ConsumedEnergy);	  //mA consumed
-	}
-	if (ManualControlCommandHandle() != NULL) {
-		ManualControlCommandData mdata;
-		ManualControlCommandGet(&mdata);
-		lt_rssi = (uint8_t)mdata.Rssi;					  //RSSI in %
+	if (view->battery.present) {
+		lt_vbat = (uint16_t)roundf(view->battery.voltage*1000);	  //Battery voltage in mv
+		lt_amp = (uint16_t)roundf(view->battery.consumed_energy);	  //mA consumed
 	}
-	if (AirspeedActualHandle() != NULL) {
-		AirspeedActualData adata;
-		AirspeedActualGet (&adata);
-		lt_airspeed = (uint8_t)roundf(adata.TrueAirspeed);	  //Airspeed in m/s
-	} else if (GPSPositionHandle() != NULL) {
-		float groundspeed;
-		GPSPositionGroundspeedGet(&groundspeed);
-		lt_airspeed = (uint8_t)roundf(groundspeed);
+	lt_rssi = (uint8_t)fdata->rssi;					  //RSSI in %
+	if (view->navigation.has_airspeed) {
+		lt_airspeed = (uint8_t)roundf(view->navigation.true_airspeed);	  //Airspeed in m/s
+	} else if (view->gps.present) {
+		lt_airspeed = (uint8_t)roundf(view->gps.groundspeed);
 	}
 
-	FlightStatusData fdata;
-	FlightStatusGet(&fdata);
-	lt_arm = fdata.Armed;									  //Armed status
+	lt_arm = fdata->armed;									  //Armed status
 	if (lt_arm == 1)		//arming , we don't use this one
 		lt_arm = 0;		
 	else if (lt_arm == 2)  // armed
 		lt_arm = 1;
-	if (fdata.ControlSource == FLIGHTSTATUS_CONTROLSOURCE_FAILSAFE)
+	if (fdata->control_source == FLIGHTSTATUS_CONTROLSOURCE_FAILSAFE)
 		lt_failsafe = 1;
 	else
 		lt_failsafe = 0;
@@ -363,7 +376,7 @@ static int send_LTM_Sframe()
 	// 8: Altitude Hold, 9: Loiter/GPS Hold, 10: Auto/Waypoints, 11: Heading Hold / headFree,
 	// 12: Circle, 13: RTH, 14: FollowMe, 15: LAND, 16:FlybyWireA, 17: FlybywireB, 18: Cruise, 19: Unknown
 
-	switch (fdata.FlightMode) {
+	switch (fdata->flight_mode) {
 	case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
 		lt_flightmode = 0; break;
 	case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
@@ -401,7 +414,12 @@ static int send_LTM_Sframe()
 	LTBuff[8] = (lt_airspeed >> 8*0) & 0xFF;
 	LTBuff[9] = ((lt_flightmode << 2)& 0xFF ) | ((lt_failsafe << 1)& 0b00000010 ) | (lt_arm & 0b00000001) ; // last 6 bits: flight mode, 2nd bit: failsafe, 1st bit: Arm status.
 
-	return send_LTM_Packet(LTBuff,LTM_SFRAME_SIZE);
+	if (send_LTM_Packet(LTBuff, LTM_SFRAME_SIZE))
+		return -1;
+
+	sframe_version = view->version[TELEMETRYVIEW_STATUS];
+
+	return 0;
 }
 
 static int send_LTM_Packet(uint8_t *LTPacket, uint8_t LTPacket_size)
@@ -41,22 +41,14 @@
 #include <pios_hal.h>
 
 #include "actuatorsettings.h"
-#include "actuatordesired.h"
-#include "airspeedactual.h"
-#include "attitudeactual.h"
-#include "baroaltitude.h"
-#include "flightbatterysettings.h"
-#include "flightbatterystate.h"
 #include "flightstatus.h"
 #include "gpsposition.h"
-#include "homelocation.h"
 #include "manualcontrolcommand.h"
 #include "modulesettings.h"
-#include "positionactual.h"
 #include "stabilizationsettings.h"
 #include "systemalarms.h"
 #include "systemsettings.h"
-#include "systemstats.h"
+#include "telemetryview.h"
 
 
 #if defined(PIOS_INCLUDE_MSP_BRIDGE)
@@ -208,6 +200,8 @@ struct msp_bridge {
 		// Specific packed data structures go here.
 		struct msp_cmddata_escserial escserial;
 	} cmd_data;
+
+	struct telemetryview view;
 };
 
 #if defined(PIOS_MSP_STACK_SIZE)
@@ -254,16 +248,18 @@ static void msp_send(struct msp_bridge *m, uint8_t cmd, const uint8_t *data, siz
 	buf[3] = (uint8_t)(len);
 	buf[4] = cmd;
 
-	PIOS_COM_SendBuffer(m->com, buf, sizeof(buf));
-	PIOS_COM_SendBuffer(m->com, data, len);
-
 	for (int i = 0; i < len; i++) {
 		cs ^= data[i];
 	}
-	cs ^= 0;
 
-	buf[0] = cs;
-	PIOS_COM_SendBuffer(m->com, buf, 1);
+	/* Header, payload and checksum go into the fifo together */
+	const struct pios_com_iovec frame[] = {
+		{ .base = buf, .len = sizeof(buf) },
+		{ .base = data, .len = len },
+		{ .base = &cs, .len = 1 },
+	};
+
+	PIOS_COM_SendVector(m->com, frame, NELEMENTS(frame));
 }
 
 static msp_state msp_state_size(struct msp_bridge *m, uint8_t b)
@@ -514,15 +510,15 @@ static void msp_send_attitude(struct msp_bridge *m)
 			int16_t h;
 		} att;
 	} data;
-	AttitudeActualData attActual;
+	const struct telemetryview_attitude *attActual = &m->view.attitude;
 
-	AttitudeActualGet(&attActual);
+	TelemetryViewRead(&m->view, TELEMETRYVIEW_ATTITUDE);
 
 	// Roll and Pitch are in 10ths of a degree.
-	data.att.x = attActual.Roll * 10;
-	data.att.y = attActual.Pitch * -10;
+	data.att.x = attActual->roll * 10;
+	data.att.y = attActual->pitch * -10;
 	// Yaw is just -180 -> 180
-	data.att.h = attActual.Yaw;
+	data.att.h = attActual->yaw;
 
 	msp_send(m, MSP_ATTITUDE, data.buf, sizeof(data));
 }
@@ -724,35 +720,28 @@ static void msp_send_status(struct msp_bridge *m)
 		} __attribute__((packed)) status;
 	} data;
 
-	float cycle_time;
-	ActuatorDesiredUpdateTimeGet(&cycle_time);
-	data.status.cycleTime = cycle_time * 1000;
+	const struct telemetryview_status *status = &m->view.status;
+	const struct telemetryview_gps *gpsData = &m->view.gps;
+
+	TelemetryViewRead(&m->view, TELEMETRYVIEW_STATUS);
+	TelemetryViewRead(&m->view, TELEMETRYVIEW_GPS);
+
+	data.status.cycleTime = status->cycle_time * 1000;
 
 	data.status.i2cErrors = 0;
-	
-	GPSPositionData gpsData = {};
-	
-	if (GPSPositionHandle() != NULL)
-		GPSPositionGet(&gpsData);
 
 	data.status.sensors = (PIOS_SENSORS_IsRegistered(PIOS_SENSOR_ACCEL) ? MSP_SENSOR_ACC  : 0) |
 		(PIOS_SENSORS_IsRegistered(PIOS_SENSOR_BARO) ? MSP_SENSOR_BARO : 0) |
 		(PIOS_SENSORS_IsRegistered(PIOS_SENSOR_MAG) ? MSP_SENSOR_MAG : 0) |
-		(gpsData.Status != GPSPOSITION_STATUS_NOGPS ? MSP_SENSOR_GPS : 0);
+		(gpsData->status != GPSPOSITION_STATUS_NOGPS ? MSP_SENSOR_GPS : 0);
 
-	data.status.flags = 0;
 	data.status.setting = 0;
 
-	if (FlightStatusHandle() != NULL) {
-		FlightStatusData flight_status;
-		FlightStatusGet(&flight_status);
+	data.status.flags = status->armed == FLIGHTSTATUS_ARMED_ARMED;
 
-		data.status.flags = flight_status.Armed == FLIGHTSTATUS_ARMED_ARMED;
-
-		for (int i = 1; msp_boxes[i].mode != MSP_BOX_LAST; i++) {
-			if (flight_status.FlightMode == msp_boxes[i].tlmode) {
-				data.status.flags |= (1 << i);
-			}
+	for (int i = 1; msp_boxes[i].mode != MSP_BOX_LAST; i++) {
+		if (status->flight_mode == msp_boxes[i].tlmode) {
+			data.status.flags |= (1 << i);
 		}
 	}
 
@@ -770,35 +759,31 @@ static void msp_send_analog(struct msp_bridge *m)
 			uint16_t current;
 		} __attribute__((packed)) status;
 	} data;
+	data.status.vbat = 0;
+	data.status.current = 0;
 	data.status.powerMeterSum = 0;
 
-	FlightBatterySettingsData batSettings = {};
-	FlightBatteryStateData batState = {};
+	const struct telemetryview_battery *battery = &m->view.battery;
+	const struct telemetryview_status *status = &m->view.status;
 
-	if (FlightBatteryStateHandle() != NULL)
-		FlightBatteryStateGet(&batState);
-	if (FlightBatterySettingsHandle() != NULL) {
-		FlightBatterySettingsGet(&batSettings);
-	}
+	TelemetryViewRead(&m->view, TELEMETRYVIEW_BATTERY);
+	TelemetryViewRead(&m->view, TELEMETRYVIEW_STATUS);
 
-	if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
-		data.status.vbat = (uint8_t)lroundf(batState.Voltage * 10);
+	if (battery->has_voltage)
+		data.status.vbat = (uint8_t)lroundf(battery->voltage * 10);
 
-	if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE) {
-		data.status.current = lroundf(batState.Current * 100);
-		data.status.powerMeterSum = lroundf(batState.ConsumedEnergy);
+	if (battery->has_current) {
+		data.status.current = lroundf(battery->current * 100);
+		data.status.powerMeterSum = lroundf(battery->consumed_energy);
 	}
 
-	ManualControlCommandData manualState;
-	ManualControlCommandGet(&manualState);
-
 	// MSP RSSI's range is 0-1023
-	if (manualState.Rssi <= 0) {
+	if (status->rssi <= 0) {
 		data.status.rssi = 0;
-	} else if (manualState.Rssi >= 100) {
+	} else if (status->rssi >= 100) {
 		data.status.rssi = 1023;
 	} else {
-		data.status.rssi = manualState.Rssi * 10;
+		data.status.rssi = status->rssi * 10;
 	}
 
 	msp_send(m, MSP_ANALOG, data.buf, sizeof(data));
@@ -819,18 +804,19 @@ static void msp_send_raw_gps(struct msp_bridge *m)
 		} __attribute__((packed)) raw_gps;
 	} data;
 	
-	GPSPositionData gps_data = {};
-	
-	if (GPSPositionHandle() != NULL)
+	const struct telemetryview_gps *gps_data = &m->view.gps;
+
+	TelemetryViewRead(&m->view, TELEMETRYVIEW_GPS);
+
+	if (gps_data->present)
 	{
-		GPSPositionGet(&gps_data);
-		data.raw_gps.fix           = (gps_data.Status >= GPSPOSITION_STATUS_FIX2D ? 1 : 0);  // Data will display on OSD if 2D fix or better
-		data.raw_gps.num_sat       = gps_data.Satellites;
-		data.raw_gps.lat           = gps_data.Latitude;
-		data.raw_gps.lon           = gps_data.Longitude;
-		data.raw_gps.alt           = (uint16_t)gps_data.Altitude;
-		data.raw_gps.speed         = (uint16_t)(gps_data.Groundspeed * 100.0f);
-		data.raw_gps.ground_course = (int16_t)(gps_data.Heading * 10.0f);
+		data.raw_gps.fix           = (gps_data->status >= GPSPOSITION_STATUS_FIX2D ? 1 : 0);  // Data will display on OSD if 2D fix or better
+		data.raw_gps.num_sat       = gps_data->satellites;
+		data.raw_gps.lat           = gps_data->latitude;
+		data.raw_gps.lon           = gps_data->longitude;
+		data.raw_gps.alt           = (uint16_t)gps_data->altitude;
+		data.raw_gps.speed         = (uint16_t)(gps_data->groundspeed * 100.0f);
+		data.raw_gps.ground_course = (int16_t)(gps_data->heading * 10.0f);
 	}
 	else
 	{
@@ -857,10 +843,13 @@ static void msp_send_comp_gps(struct msp_bridge *m)
 		} __attribute__((packed)) comp_gps;
 	} data;
 	
-	GPSPositionData gps_data   = {};
-	HomeLocationData home_data = {};
-	
-	if ((GPSPositionHandle() == NULL) || (HomeLocationHandle() == NULL))
+	const struct telemetryview_gps *gps_data = &m->view.gps;
+	const struct telemetryview_navigation *home_data = &m->view.navigation;
+
+	TelemetryViewRead(&m->view, TELEMETRYVIEW_GPS);
+	TelemetryViewRead(&m->view, TELEMETRYVIEW_NAVIGATION);
+
+	if (!gps_data->present || !home_data->has_home)
 	{
 		data.comp_gps.distance_to_home    = 0;
 		data.comp_gps.direction_to_home   = 0;
@@ -868,10 +857,7 @@ static void msp_send_comp_gps(struct msp_bridge *m)
 	}
 	else
 	{
-		GPSPositionGet(&gps_data);
-		HomeLocationGet(&home_data);
-		
-		if((gps_data.Status < GPSPOSITION_STATUS_FIX2D) || (home_data.Set == HOMELOCATION_SET_FALSE))
+		if((gps_data->status < GPSPOSITION_STATUS_FIX2D) || !home_data->home_set)
 		{
 			data.comp_gps.distance_to_home    = 0;
 			data.comp_gps.direction_to_home   = 0;
@@ -881,13 +867,13 @@ static void msp_send_comp_gps(struct msp_bridge *m)
 		{
 			data.comp_gps.home_position_valid = 1;  // Home distance and direction will display on OSD
 			
-			int32_t delta_lon = (home_data.Longitude - gps_data.Longitude);  // degrees * 1e7
-			int32_t delta_lat = (home_data.Latitude  - gps_data.Latitude );  // degrees * 1e7
+			int32_t delta_lon = (home_data->home_longitude - gps_data->longitude);  // degrees * 1e7
+			int32_t delta_lat = (home_data->home_latitude  - gps_data->latitude );  // degrees * 1e7
 	
 			float delta_y = (float)delta_lon * WGS84_RADIUS_EARTH_KM * DEG2RAD;  // KM * 1e7
 			float delta_x = (float)delta_lat * WGS84_RADIUS_EARTH_KM * DEG2RAD;  // KM * 1e7
 	
-			delta_y *= cosf((float)home_data.Latitude * 1e-7f * (float)DEG2RAD);  // Latitude compression correction
+			delta_y *= cosf((float)home_data->home_latitude * 1e-7f * (float)DEG2RAD);  // Latitude compression correction
 	
 			data.comp_gps.distance_to_home  = (uint16_t)(sqrtf(delta_x * delta_x + delta_y * delta_y) * 1e-4f);  // meters
 	
@@ -911,16 +897,15 @@ static void msp_send_altitude(struct msp_bridge *m)
 		} __attribute__((packed)) baro;
 	} data;
 	
-	float tmp;
+	const struct telemetryview_navigation *nav = &m->view.navigation;
 
-	if (PositionActualHandle() != NULL) {
-		PositionActualDownGet(&tmp);
-		tmp = -tmp;
-	} else {
+	TelemetryViewRead(&m->view, TELEMETRYVIEW_NAVIGATION);
+
+	if (!nav->has_position) {
 		return;
 	}
 
-	data.baro.alt = (int32_t)roundf(tmp * 100.0f);
+	data.baro.alt = (int32_t)roundf(-nav->down * 100.0f);
 
 	msp_send(m, MSP_ALTITUDE, data.buf, sizeof(data));
 }
@@ -1239,6 +1224,12 @@ static int32_t uavoMSPBridgeStart(void)
 		return -1;
 	}
 
+	TelemetryViewSubscribe(TELEMETRYVIEW_ATTITUDE);
+	TelemetryViewSubscribe(TELEMETRYVIEW_STATUS);
+	TelemetryViewSubscribe(TELEMETRYVIEW_BATTERY);
+	TelemetryViewSubscribe(TELEMETRYVIEW_GPS);
+	TelemetryViewSubscribe(TELEMETRYVIEW_NAVIGATION);
+
 	struct pios_thread *task = PIOS_Thread_Create(
 		uavoMSPBridgeTask, "uavoMSPBridge",
 		STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
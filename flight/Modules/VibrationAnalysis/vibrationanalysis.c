@@ -65,14 +65,9 @@
 #define FLOAT_TO_FIXED (32768/(MAX_ACCEL_RANGE*2)-1) // This is the scaling constant that scales input floats
 #define VIBRATION_ELEMENTS_COUNT 16  // Number of elements per object Instance
 
-#define MAX_WINDOW_SIZE 1024
-
-// Comment for larger smaller buffers and much better accuracy. The maximum window size will be allocated.
+// Comment for larger buffers and much better accuracy. Buffers of the whole window will be allocated.
 #define USE_SINGLE_INSTANCE_BUFFERS 1
 
-// Uncomment to enable freeing buffer memory if the PIOS_free method does something useful
-// #define PIOS_FREE_IMPLEMENTED 1
-
 // Private variables
 static struct pios_thread *taskHandle;
 static TaskInfoRunningElem task;
@@ -118,29 +113,15 @@ static void VibrationAnalysisCleanup(void) {
         taskHandle = NULL;
     }
 
-#ifdef PIOS_FREE_IMPLEMENTED
     // Cleanup
     if (vtd != NULL) {
-        PIOS_free(vtd);
-        vtd = NULL;        
-    }
-
-    if (vtd->accel_buffer_x != NULL){
         PIOS_free(vtd->accel_buffer_x);
-        vtd->accel_buffer_x = NULL;
-    }
-    
-    if (vtd->accel_buffer_y != NULL) {
         PIOS_free(vtd->accel_buffer_y);
-        vtd->accel_buffer_y = NULL;
-
-    }
-
-    if (vtd->accel_buffer_z != NULL) {
         PIOS_free(vtd->accel_buffer_z);
-        vtd->accel_buffer_z = NULL;
+
+        PIOS_free(vtd);
+        vtd = NULL;
     }
-#endif
 
 }
 
@@ -220,15 +201,10 @@ static int32_t VibrationAnalysisStart(void)
         }
 #endif
 
-#ifdef PIOS_FREE_IMPLEMENTED        
         // Delete existing buffers
-        if (vtd->accel_buffer_x != NULL)
-            PIOS_free(vtd->accel_buffer_x);
-        if (vtd->accel_buffer_y != NULL)
-            PIOS_free(vtd->accel_buffer_y);
-        if (vtd->accel_buffer_z != NULL)
-            PIOS_free(vtd->accel_buffer_z);
-#endif
+        PIOS_free(vtd->accel_buffer_x);
+        PIOS_free(vtd->accel_buffer_y);
+        PIOS_free(vtd->accel_buffer_z);
 
         // Clear buffers
         memset(vtd, 0, sizeof(struct VibrationAnalysis_data));
@@ -241,14 +217,7 @@ static int32_t VibrationAnalysisStart(void)
 #ifdef USE_SINGLE_INSTANCE_BUFFERS
         vtd->buffers_size = VIBRATION_ELEMENTS_COUNT; 
 #else
-
-    #ifdef PIOS_FREE_IMPLEMENTED        
         vtd->buffers_size = window_size;
-    #else
-        vtd->buffers_size = MAX_WINDOW_SIZE; 
-
-    #endif
-
 #endif
 
 
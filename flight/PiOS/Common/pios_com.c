@@ -58,10 +58,17 @@ struct pios_com_dev {
 	struct pios_semaphore *rx_sem;
 #if defined(PIOS_INCLUDE_RTOS)
 	struct pios_mutex *sendbuffer_mtx;
+	//! Held by the writer waiting on tx_sem, so there is only ever one
+	struct pios_mutex *tx_wait_mtx;
 #endif
 
 	circ_queue_t rx;
 	circ_queue_t tx;
+
+	//! Free space in the tx fifo when it's empty
+	uint16_t tx_size;
+	//! Free space a blocked writer is waiting for, or 0 if none is
+	volatile uint16_t tx_wanted;
 };
 
 static bool PIOS_COM_validate(struct pios_com_dev *com_dev)
@@ -130,8 +137,10 @@ int32_t PIOS_COM_Init(uintptr_t * com_id, const struct pios_com_driver * driver,
 	if (tx_buffer_len) {
 		com_dev->tx = circ_queue_new(1, tx_buffer_len);
 		if (!com_dev->tx) goto out_fail;
+		circ_queue_write_pos(com_dev->tx, NULL, &com_dev->tx_size);
 #if defined(PIOS_INCLUDE_RTOS)
 		com_dev->tx_sem = PIOS_Semaphore_Create();
+		com_dev->tx_wait_mtx = PIOS_Mutex_Create();
 #endif	/* PIOS_INCLUDE_RTOS */
 		(com_dev->driver->bind_tx_cb)(lower_id, PIOS_COM_TxOutCallback, (uintptr_t)com_dev);
 	}
@@ -202,9 +211,21 @@ static uint16_t PIOS_COM_TxOutCallback(uintptr_t context, uint8_t * buf, uint16_
 	uint16_t bytes_from_fifo = circ_queue_read_data(com_dev->tx,
 			buf, buf_len);
 
-	if (bytes_from_fifo > 0) {
-		/* More space has been made in the buffer */
-		PIOS_COM_UnblockTx(com_dev, need_yield);
+	uint16_t wanted = com_dev->tx_wanted;
+
+	if (bytes_from_fifo > 0 && wanted) {
+		uint16_t tx_space;
+
+		circ_queue_write_pos(com_dev->tx, NULL, &tx_space);
+
+		if (tx_space >= wanted) {
+			/* Enough space has been made for the blocked writer.
+			 * Nobody is woken while nobody waits, so a uart
+			 * pulling a byte an interrupt doesn't give the
+			 * semaphore for each one. */
+			com_dev->tx_wanted = 0;
+			PIOS_COM_UnblockTx(com_dev, need_yield);
+		}
 	}
 
 	if (headroom) {
@@ -238,19 +259,21 @@ int32_t PIOS_COM_ChangeBaud(uintptr_t com_id, uint32_t baud)
 	return 0;
 }
 
-static int32_t SendBufferNonBlockingImpl(uintptr_t com_id, const uint8_t *buffer, uint16_t len, bool all_or_nothing)
+static int32_t SendVectorNonBlockingImpl(struct pios_com_dev *com_dev,
+		const struct pios_com_iovec *iov, uint8_t iovcnt, uint32_t skip,
+		bool all_or_nothing, uint32_t lock_ms)
 {
-	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+	uint32_t len = 0;
 
-	if (!PIOS_COM_validate(com_dev)) {
-		/* Undefined COM port for this board (see pios_board.c) */
-		return -1;
+	for (uint8_t i = 0; i < iovcnt; i++) {
+		len += iov[i].len;
 	}
 
-	PIOS_Assert(com_dev->tx);
+	PIOS_Assert(skip <= len);
+	len -= skip;
 
 #if defined(PIOS_INCLUDE_RTOS)
-	if (PIOS_Mutex_Lock(com_dev->sendbuffer_mtx, 0) != true) {
+	if (PIOS_Mutex_Lock(com_dev->sendbuffer_mtx, lock_ms) != true) {
 		return -3;
 	}
 #endif /* defined(PIOS_INCLUDE_RTOS) */
@@ -287,8 +310,33 @@ static int32_t SendBufferNonBlockingImpl(uintptr_t com_id, const uint8_t *buffer
 		}
 	}
 
-	uint16_t bytes_into_fifo = circ_queue_write_data(com_dev->tx,
-			buffer, len);
+	/* Each fragment goes straight from the caller into the fifo; the
+	 * transmitter is only kicked once the lot is in. */
+	uint32_t bytes_into_fifo = 0;
+
+	for (uint8_t i = 0; i < iovcnt; i++) {
+		uint16_t frag_len = iov[i].len;
+		const uint8_t *frag = iov[i].base;
+
+		if (skip >= frag_len) {
+			skip -= frag_len;
+			continue;
+		}
+
+		frag += skip;
+		frag_len -= skip;
+		skip = 0;
+
+		uint16_t put = circ_queue_write_data(com_dev->tx, frag,
+				frag_len);
+
+		bytes_into_fifo += put;
+
+		if (put < frag_len) {
+			/* Fifo is full */
+			break;
+		}
+	}
 
 	/* Make sure the tx is actually started */
 	if (com_dev->driver->tx_start) {
@@ -305,6 +353,106 @@ static int32_t SendBufferNonBlockingImpl(uintptr_t com_id, const uint8_t *buffer
 	return (bytes_into_fifo);
 }
 
+/**
+ * Blocks until the tx fifo has some free space, or max_ms elapses.
+ * The tx callback gives the semaphore once it has drained enough.
+ */
+static bool PIOS_COM_WaitTxSpace(struct pios_com_dev *com_dev, uint16_t wanted, uint32_t max_ms)
+{
+	uint16_t tx_space;
+
+#if defined(PIOS_INCLUDE_RTOS)
+	/* The callback wakes one writer, for the space one asked for;
+	 * any others queue here. */
+	if (PIOS_Mutex_Lock(com_dev->tx_wait_mtx, max_ms) != true) {
+		return false;
+	}
+#endif /* PIOS_INCLUDE_RTOS */
+
+	com_dev->tx_wanted = wanted;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	/* Space freed before the callback could see tx_wanted doesn't wake
+	 * anybody, so look again now that it can. */
+	circ_queue_write_pos(com_dev->tx, NULL, &tx_space);
+
+	bool ok = (tx_space >= wanted) ||
+		PIOS_Semaphore_Take(com_dev->tx_sem, max_ms);
+
+	com_dev->tx_wanted = 0;
+
+#if defined(PIOS_INCLUDE_RTOS)
+	PIOS_Mutex_Unlock(com_dev->tx_wait_mtx);
+#endif /* PIOS_INCLUDE_RTOS */
+
+	return ok;
+}
+
+static int32_t SendVectorStallTimeoutImpl(uintptr_t com_id,
+		const struct pios_com_iovec *iov, uint8_t iovcnt,
+		uint32_t max_ms, bool whole, uint32_t lock_ms)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return -1;
+	}
+
+	PIOS_Assert(com_dev->tx);
+
+	uint32_t len = 0;
+
+	for (uint8_t i = 0; i < iovcnt; i++) {
+		len += iov[i].len;
+	}
+
+	/* What doesn't fit in the fifo even when it's empty has to go a
+	 * piece at a time */
+	if (len > com_dev->tx_size) {
+		whole = false;
+	}
+
+	uint32_t sent = 0;
+	while (sent < len) {
+		int32_t rc = SendVectorNonBlockingImpl(com_dev, iov, iovcnt,
+				sent, whole, lock_ms);
+		if (rc > 0) {
+			sent += rc;
+		} else if (rc == 0 || rc == -2) {
+			/* Wait for half the fifo so the writer isn't woken for
+			 * every few bytes.  A frame that has to go at once
+			 * needs its own room on top of that, or a frame that
+			 * doesn't divide the half would leave the writer
+			 * waking for less. */
+			uint32_t wanted = len - sent;
+			uint16_t half = (com_dev->tx_size + 1) / 2;
+
+			if (whole) {
+				wanted += half;
+
+				if (wanted > com_dev->tx_size) {
+					wanted = com_dev->tx_size;
+				}
+			} else if (wanted > half) {
+				wanted = half;
+			}
+
+			if (!PIOS_COM_WaitTxSpace(com_dev, wanted, max_ms)) {
+				return -3;
+			}
+		} else {
+			// If we succeeded some, report that back.
+			if (sent) break;
+
+			/* -3: another thread is already sending */
+			return rc;
+		}
+	}
+
+	return sent;
+}
+
 /**
 * Sends a package over given port
 * \param[in] port COM port
@@ -319,7 +467,9 @@ static int32_t SendBufferNonBlockingImpl(uintptr_t com_id, const uint8_t *buffer
 */
 int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer, uint16_t len)
 {
-	return SendBufferNonBlockingImpl(com_id, buffer, len, true);
+	const struct pios_com_iovec iov = { .base = buffer, .len = len };
+
+	return PIOS_COM_SendVectorNonBlocking(com_id, &iov, 1);
 }
 
 /**
@@ -333,6 +483,41 @@ int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer,
 * \return number of bytes transmitted on success
 */
 int32_t PIOS_COM_SendBufferStallTimeout(uintptr_t com_id, const uint8_t *buffer, uint16_t len, uint32_t max_ms)
+{
+	const struct pios_com_iovec iov = { .base = buffer, .len = len };
+
+	return SendVectorStallTimeoutImpl(com_id, &iov, 1, max_ms, false, 0);
+}
+
+/**
+* Sends a package over given port
+* (blocking function)
+* \param[in] port COM port
+* \param[in] buffer character buffer
+* \param[in] len buffer length
+* \return -1 if port not available
+* \return number of bytes transmitted on success
+*/
+int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len)
+{
+	/* Allow 5s with no progress by default */
+	return PIOS_COM_SendBufferStallTimeout(com_id, buffer, len, 5000);
+}
+
+/**
+* Sends a frame gathered from several fragments over given port, without
+* assembling it first.  The whole frame goes into the fifo or none of it.
+* \param[in] port COM port
+* \param[in] iov fragments, in order
+* \param[in] iovcnt number of fragments
+* \return -1 if port not available
+* \return -2 buffer is full
+*            caller should retry until buffer is free again
+* \return -3 another thread is already sending, caller should
+*            retry until com is available again
+* \return number of bytes transmitted on success
+*/
+int32_t PIOS_COM_SendVectorNonBlocking(uintptr_t com_id, const struct pios_com_iovec *iov, uint8_t iovcnt)
 {
 	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
 
@@ -343,52 +528,45 @@ int32_t PIOS_COM_SendBufferStallTimeout(uintptr_t com_id, const uint8_t *buffer,
 
 	PIOS_Assert(com_dev->tx);
 
-	uint16_t sent = 0;
-	while (sent < len) {
-		int32_t rc = SendBufferNonBlockingImpl(com_id, buffer,
-				len - sent, false);
-		if (rc > 0) {
-			buffer += rc;
-			sent += rc;
-		} else if (rc == 0) {
-			/* Block... for 5 seconds? */
-			if (PIOS_Semaphore_Take(com_dev->tx_sem, max_ms) != true) {
-				return -3;
-			}
-		} else {
-			// If we succeeded some, report that back.
-			if (sent) break;
-
-			switch (rc) {
-			case -1:
-				/* Device is invalid, this will never work */
-				return -1;
-			case -2:
-				PIOS_Assert(0);
-				continue;
-			default:
-				/* Unhandled return code */
-				return rc;
-			}
-		}
-	}
+	return SendVectorNonBlockingImpl(com_dev, iov, iovcnt, 0, true, 0);
+}
 
-	return sent;
+/**
+* Sends a frame gathered from several fragments over given port
+* (blocking function)
+* Waits for a sender on another thread to finish, and for the fifo to take
+* the frame whole, so frames from different threads are never interleaved.
+* Frames larger than the fifo go as room is made.
+* Unlike PIOS_COM_SendBufferStallTimeout, which gives up at once with -3
+* when another thread is sending, this waits up to max_ms for it too.
+* \param[in] port COM port
+* \param[in] iov fragments, in order
+* \param[in] iovcnt number of fragments
+* \param[in] max_ms Maximum num of milliseconds without progress to block.
+* \return -1 if port not available
+* \return -3 timed out
+* \return number of bytes transmitted on success
+*/
+int32_t PIOS_COM_SendVectorStallTimeout(uintptr_t com_id, const struct pios_com_iovec *iov, uint8_t iovcnt, uint32_t max_ms)
+{
+	return SendVectorStallTimeoutImpl(com_id, iov, iovcnt, max_ms, true, max_ms);
 }
 
 /**
-* Sends a package over given port
+* Sends a frame gathered from several fragments over given port
 * (blocking function)
+* Waits up to 5s for a sender on another thread; see
+* PIOS_COM_SendVectorStallTimeout.
 * \param[in] port COM port
-* \param[in] buffer character buffer
-* \param[in] len buffer length
+* \param[in] iov fragments, in order
+* \param[in] iovcnt number of fragments
 * \return -1 if port not available
 * \return number of bytes transmitted on success
 */
-int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len)
+int32_t PIOS_COM_SendVector(uintptr_t com_id, const struct pios_com_iovec *iov, uint8_t iovcnt)
 {
 	/* Allow 5s with no progress by default */
-	return PIOS_COM_SendBufferStallTimeout(com_id, buffer, len, 5000);
+	return PIOS_COM_SendVectorStallTimeout(com_id, iov, iovcnt, 5000);
 }
 
 /**
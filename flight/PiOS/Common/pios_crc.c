@@ -10,26 +10,31 @@
 #include <pios_crc.h>
 
 #include <stdbool.h>
+#include <string.h>
 
-// CRC lookup table
-static const uint8_t crc_table[256] = {
-	0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
-	0x70, 0x77, 0x7e, 0x79, 0x6c, 0x6b, 0x62, 0x65, 0x48, 0x4f, 0x46, 0x41, 0x54, 0x53, 0x5a, 0x5d,
-	0xe0, 0xe7, 0xee, 0xe9, 0xfc, 0xfb, 0xf2, 0xf5, 0xd8, 0xdf, 0xd6, 0xd1, 0xc4, 0xc3, 0xca, 0xcd,
-	0x90, 0x97, 0x9e, 0x99, 0x8c, 0x8b, 0x82, 0x85, 0xa8, 0xaf, 0xa6, 0xa1, 0xb4, 0xb3, 0xba, 0xbd,
-	0xc7, 0xc0, 0xc9, 0xce, 0xdb, 0xdc, 0xd5, 0xd2, 0xff, 0xf8, 0xf1, 0xf6, 0xe3, 0xe4, 0xed, 0xea,
-	0xb7, 0xb0, 0xb9, 0xbe, 0xab, 0xac, 0xa5, 0xa2, 0x8f, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9d, 0x9a,
-	0x27, 0x20, 0x29, 0x2e, 0x3b, 0x3c, 0x35, 0x32, 0x1f, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0d, 0x0a,
-	0x57, 0x50, 0x59, 0x5e, 0x4b, 0x4c, 0x45, 0x42, 0x6f, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7d, 0x7a,
-	0x89, 0x8e, 0x87, 0x80, 0x95, 0x92, 0x9b, 0x9c, 0xb1, 0xb6, 0xbf, 0xb8, 0xad, 0xaa, 0xa3, 0xa4,
-	0xf9, 0xfe, 0xf7, 0xf0, 0xe5, 0xe2, 0xeb, 0xec, 0xc1, 0xc6, 0xcf, 0xc8, 0xdd, 0xda, 0xd3, 0xd4,
-	0x69, 0x6e, 0x67, 0x60, 0x75, 0x72, 0x7b, 0x7c, 0x51, 0x56, 0x5f, 0x58, 0x4d, 0x4a, 0x43, 0x44,
-	0x19, 0x1e, 0x17, 0x10, 0x05, 0x02, 0x0b, 0x0c, 0x21, 0x26, 0x2f, 0x28, 0x3d, 0x3a, 0x33, 0x34,
-	0x4e, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5c, 0x5b, 0x76, 0x71, 0x78, 0x7f, 0x6a, 0x6d, 0x64, 0x63,
-	0x3e, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2c, 0x2b, 0x06, 0x01, 0x08, 0x0f, 0x1a, 0x1d, 0x14, 0x13,
-	0xae, 0xa9, 0xa0, 0xa7, 0xb2, 0xb5, 0xbc, 0xbb, 0x96, 0x91, 0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83,
-	0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
-};
+#include "uavtalk_codec.h"
+
+/*
+ * The F3 and F4 CRC unit computes the same CRC-32, a word at a time, so only
+ * the byte table is needed for the odd bytes and for when it's busy.
+ */
+#if (defined(STM32F4XX) || defined(STM32F30X)) && !defined(PIOS_CRC32_NO_HW)
+#define PIOS_CRC32_HW
+#define PIOS_CRC32_SLICE_BY 1
+
+#if defined(STM32F4XX)
+#include <stm32f4xx.h>
+#else
+#include <stm32f30x.h>
+#endif
+
+//! Below this the software is quicker than setting up the hardware
+#define CRC32_HW_MIN_LENGTH 16
+#else
+#define PIOS_CRC32_SLICE_BY PIOS_CRC_SLICE_BY
+#endif
+
+#include "pios_crc_tables.h"
 
 static const uint8_t crc_d5_tab[256] = {
 	0x00, 0xd5, 0x7f, 0xaa, 0xfe, 0x2b, 0x81, 0x54, 0x29, 0xfc, 0x56, 0x83, 0xd7, 0x02, 0xa8, 0x7d,
@@ -50,76 +55,6 @@ static const uint8_t crc_d5_tab[256] = {
 	0x84, 0x51, 0xfb, 0x2e, 0x7a, 0xaf, 0x05, 0xd0, 0xad, 0x78, 0xd2, 0x07, 0x53, 0x86, 0x2c, 0xf9
 };
 
-static const uint16_t CRC_Table16[] = {	// HDLC polynomial
-	 0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
-	 0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
-	 0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
-	 0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
-	 0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
-	 0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
-	 0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
-	 0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
-	 0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
-	 0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
-	 0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
-	 0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
-	 0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
-	 0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
-	 0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
-	 0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
-	 0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
-	 0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
-	 0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
-	 0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
-	 0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
-	 0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
-	 0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
-	 0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
-	 0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
-	 0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
-	 0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
-	 0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
-	 0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
-	 0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
-	 0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
-	 0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
-};
-
-static const uint32_t CRC_Table32[]	= {
-	    0x00000000, 0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b, 0x1a864db2, 0x1e475005,
-	    0x2608edb8, 0x22c9f00f, 0x2f8ad6d6, 0x2b4bcb61, 0x350c9b64, 0x31cd86d3, 0x3c8ea00a, 0x384fbdbd,
-	    0x4c11db70, 0x48d0c6c7, 0x4593e01e, 0x4152fda9, 0x5f15adac, 0x5bd4b01b, 0x569796c2, 0x52568b75,
-	    0x6a1936c8, 0x6ed82b7f, 0x639b0da6, 0x675a1011, 0x791d4014, 0x7ddc5da3, 0x709f7b7a, 0x745e66cd,
-	    0x9823b6e0, 0x9ce2ab57, 0x91a18d8e, 0x95609039, 0x8b27c03c, 0x8fe6dd8b, 0x82a5fb52, 0x8664e6e5,
-	    0xbe2b5b58, 0xbaea46ef, 0xb7a96036, 0xb3687d81, 0xad2f2d84, 0xa9ee3033, 0xa4ad16ea, 0xa06c0b5d,
-	    0xd4326d90, 0xd0f37027, 0xddb056fe, 0xd9714b49, 0xc7361b4c, 0xc3f706fb, 0xceb42022, 0xca753d95,
-	    0xf23a8028, 0xf6fb9d9f, 0xfbb8bb46, 0xff79a6f1, 0xe13ef6f4, 0xe5ffeb43, 0xe8bccd9a, 0xec7dd02d,
-	    0x34867077, 0x30476dc0, 0x3d044b19, 0x39c556ae, 0x278206ab, 0x23431b1c, 0x2e003dc5, 0x2ac12072,
-	    0x128e9dcf, 0x164f8078, 0x1b0ca6a1, 0x1fcdbb16, 0x018aeb13, 0x054bf6a4, 0x0808d07d, 0x0cc9cdca,
-	    0x7897ab07, 0x7c56b6b0, 0x71159069, 0x75d48dde, 0x6b93dddb, 0x6f52c06c, 0x6211e6b5, 0x66d0fb02,
-	    0x5e9f46bf, 0x5a5e5b08, 0x571d7dd1, 0x53dc6066, 0x4d9b3063, 0x495a2dd4, 0x44190b0d, 0x40d816ba,
-	    0xaca5c697, 0xa864db20, 0xa527fdf9, 0xa1e6e04e, 0xbfa1b04b, 0xbb60adfc, 0xb6238b25, 0xb2e29692,
-	    0x8aad2b2f, 0x8e6c3698, 0x832f1041, 0x87ee0df6, 0x99a95df3, 0x9d684044, 0x902b669d, 0x94ea7b2a,
-	    0xe0b41de7, 0xe4750050, 0xe9362689, 0xedf73b3e, 0xf3b06b3b, 0xf771768c, 0xfa325055, 0xfef34de2,
-	    0xc6bcf05f, 0xc27dede8, 0xcf3ecb31, 0xcbffd686, 0xd5b88683, 0xd1799b34, 0xdc3abded, 0xd8fba05a,
-	    0x690ce0ee, 0x6dcdfd59, 0x608edb80, 0x644fc637, 0x7a089632, 0x7ec98b85, 0x738aad5c, 0x774bb0eb,
-	    0x4f040d56, 0x4bc510e1, 0x46863638, 0x42472b8f, 0x5c007b8a, 0x58c1663d, 0x558240e4, 0x51435d53,
-	    0x251d3b9e, 0x21dc2629, 0x2c9f00f0, 0x285e1d47, 0x36194d42, 0x32d850f5, 0x3f9b762c, 0x3b5a6b9b,
-	    0x0315d626, 0x07d4cb91, 0x0a97ed48, 0x0e56f0ff, 0x1011a0fa, 0x14d0bd4d, 0x19939b94, 0x1d528623,
-	    0xf12f560e, 0xf5ee4bb9, 0xf8ad6d60, 0xfc6c70d7, 0xe22b20d2, 0xe6ea3d65, 0xeba91bbc, 0xef68060b,
-	    0xd727bbb6, 0xd3e6a601, 0xdea580d8, 0xda649d6f, 0xc423cd6a, 0xc0e2d0dd, 0xcda1f604, 0xc960ebb3,
-	    0xbd3e8d7e, 0xb9ff90c9, 0xb4bcb610, 0xb07daba7, 0xae3afba2, 0xaafbe615, 0xa7b8c0cc, 0xa379dd7b,
-	    0x9b3660c6, 0x9ff77d71, 0x92b45ba8, 0x9675461f, 0x8832161a, 0x8cf30bad, 0x81b02d74, 0x857130c3,
-	    0x5d8a9099, 0x594b8d2e, 0x5408abf7, 0x50c9b640, 0x4e8ee645, 0x4a4ffbf2, 0x470cdd2b, 0x43cdc09c,
-	    0x7b827d21, 0x7f436096, 0x7200464f, 0x76c15bf8, 0x68860bfd, 0x6c47164a, 0x61043093, 0x65c52d24,
-	    0x119b4be9, 0x155a565e, 0x18197087, 0x1cd86d30, 0x029f3d35, 0x065e2082, 0x0b1d065b, 0x0fdc1bec,
-	    0x3793a651, 0x3352bbe6, 0x3e119d3f, 0x3ad08088, 0x2497d08d, 0x2056cd3a, 0x2d15ebe3, 0x29d4f654,
-	    0xc5a92679, 0xc1683bce, 0xcc2b1d17, 0xc8ea00a0, 0xd6ad50a5, 0xd26c4d12, 0xdf2f6bcb, 0xdbee767c,
-	    0xe3a1cbc1, 0xe760d676, 0xea23f0af, 0xeee2ed18, 0xf0a5bd1d, 0xf464a0aa, 0xf9278673, 0xfde69bc4,
-	    0x89b8fd09, 0x8d79e0be, 0x803ac667, 0x84fbdbd0, 0x9abc8bd5, 0x9e7d9662, 0x933eb0bb, 0x97ffad0c,
-	    0xafb010b1, 0xab710d06, 0xa6322bdf, 0xa2f33668, 0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
-	};
-
 /**
  * Update the crc value with new data.
  *
@@ -140,7 +75,7 @@ static const uint32_t CRC_Table32[]	= {
  */
 uint8_t PIOS_CRC_updateByte(uint8_t crc, const uint8_t data)
 {
-	return crc_table[crc ^ data];
+	return uavtalk_crc8_tables[0][crc ^ data];
 }
 
 /**
@@ -152,15 +87,11 @@ uint8_t PIOS_CRC_updateByte(uint8_t crc, const uint8_t data)
  */
 uint8_t PIOS_CRC_updateCRC(uint8_t crc, const uint8_t* data, int32_t length)
 {
-	// use registers for speed
-	register int32_t len = length;
-	register uint8_t crc8 = crc;
-	register const uint8_t *p = data;
-	
-	while (len--)
-		crc8 = crc_table[crc8 ^ *p++];
-	
-	return crc8;
+	/* Same CRC as the UAVTalk checksum, which already slices by four */
+	if (length <= 0)
+		return crc;
+
+	return uavtalk_crc8(crc, data, length);
 }
 
 /**
@@ -197,7 +128,7 @@ uint8_t PIOS_CRC_updateCRC_TBS(uint8_t crc, const uint8_t *data, int32_t length)
  */
 uint16_t PIOS_CRC16_updateByte(uint16_t crc, const uint8_t data)
 {
-	return ((crc >> 8) ^ CRC_Table16[(crc & 0xff) ^ data]);
+	return ((crc >> 8) ^ CRC_Table16[0][(crc & 0xff) ^ data]);
 }
 
 /**
@@ -209,11 +140,31 @@ uint16_t PIOS_CRC16_updateByte(uint16_t crc, const uint8_t data)
  */
 uint16_t PIOS_CRC16_updateCRC(uint16_t crc, const uint8_t* data, int32_t length)
 {
-	register uint8_t *p = (uint8_t *)data;
-	register uint16_t _crc = crc;
-	for (register uint32_t i = length; i > 0; i--)
-		_crc = (_crc >> 8) ^ CRC_Table16[(_crc ^ *p++) & 0xff];
-	return _crc;
+	const uint8_t *p = data;
+
+	/* The CRC is reflected, so it lines up with the first two bytes */
+#if PIOS_CRC_SLICE_BY == 8
+	for (; length >= 8; length -= 8, p += 8) {
+		uint16_t x = crc ^ (p[0] | (p[1] << 8));
+
+		crc = CRC_Table16[7][x & 0xff] ^ CRC_Table16[6][x >> 8] ^
+			CRC_Table16[5][p[2]] ^ CRC_Table16[4][p[3]] ^
+			CRC_Table16[3][p[4]] ^ CRC_Table16[2][p[5]] ^
+			CRC_Table16[1][p[6]] ^ CRC_Table16[0][p[7]];
+	}
+#elif PIOS_CRC_SLICE_BY == 4
+	for (; length >= 4; length -= 4, p += 4) {
+		uint16_t x = crc ^ (p[0] | (p[1] << 8));
+
+		crc = CRC_Table16[3][x & 0xff] ^ CRC_Table16[2][x >> 8] ^
+			CRC_Table16[1][p[2]] ^ CRC_Table16[0][p[3]];
+	}
+#endif
+
+	while (length-- > 0)
+		crc = (crc >> 8) ^ CRC_Table16[0][(crc ^ *p++) & 0xff];
+
+	return crc;
 }
 
 /* Based on code generated by pycrc v0.9, https://pycrc.org
@@ -264,9 +215,95 @@ uint16_t PIOS_CRC16_CCITT_updateCRC(uint16_t crc, const uint8_t *data, uint32_t
  */
 uint32_t PIOS_CRC32_updateByte(uint32_t crc, const uint8_t data)
 {
-	return ((crc << 8) ^ CRC_Table32[(crc >> 24) ^ data]);
+	return ((crc << 8) ^ CRC_Table32[0][(crc >> 24) ^ data]);
+}
+
+//! Set while the CRC unit is in use; anyone else uses the tables
+static volatile bool crc32_hw_busy;
+
+/**
+ * @brief Take the CRC unit for exclusive use.  Anything else that programs
+ * it directly must hold it, and leave INIT at its reset value.
+ * @returns true if taken, false if it's in use
+ */
+bool PIOS_CRC32_HW_Claim(void)
+{
+	return !__atomic_test_and_set(&crc32_hw_busy, __ATOMIC_ACQUIRE);
 }
 
+/**
+ * @brief Give back the CRC unit taken with PIOS_CRC32_HW_Claim
+ */
+void PIOS_CRC32_HW_Release(void)
+{
+	__atomic_clear(&crc32_hw_busy, __ATOMIC_RELEASE);
+}
+
+#if defined(PIOS_CRC32_HW)
+
+#if defined(STM32F4XX)
+/**
+ * @brief Undo 32 shifts of the CRC-32 register, so that the CRC unit can be
+ * made to continue from any value
+ */
+static uint32_t crc32_unshift(uint32_t crc)
+{
+	for (int i = 0; i < 32; i++) {
+		if (crc & 1)
+			crc = ((crc ^ 0x04c11db7) >> 1) | 0x80000000;
+		else
+			crc >>= 1;
+	}
+
+	return crc;
+}
+#endif
+
+/**
+ * @brief Have the CRC unit process the whole words of a buffer
+ * @param[in,out] crc The CRC so far, updated
+ * @param[in] data Data buffer
+ * @param[in] length Number of bytes available
+ * @returns Number of bytes processed; 0 if the unit is busy
+ */
+static int32_t crc32_hw_update(uint32_t *crc, const uint8_t *data, int32_t length)
+{
+	if (!PIOS_CRC32_HW_Claim())
+		return 0;
+
+#if defined(STM32F30X)
+	CRC->INIT = *crc;
+	CRC->CR = CRC_CR_RESET;
+#else
+	/* The F4 always resets to all ones, so feed it the word that takes
+	 * it from there to our CRC */
+	CRC->CR = CRC_CR_RESET;
+	CRC->DR = crc32_unshift(*crc) ^ 0xffffffff;
+#endif
+
+	int32_t words = length / 4;
+
+	for (int32_t i = 0; i < words; i++, data += 4) {
+		uint32_t word;
+
+		/* It takes the most significant byte first */
+		memcpy(&word, data, sizeof(word));
+		CRC->DR = __builtin_bswap32(word);
+	}
+
+	*crc = CRC->DR;
+
+#if defined(STM32F30X)
+	/* Others expect the unit to reset to all ones */
+	CRC->INIT = 0xffffffff;
+#endif
+
+	PIOS_CRC32_HW_Release();
+
+	return words * 4;
+}
+#endif /* PIOS_CRC32_HW */
+
 /**
  * @brief Update a CRC with a data buffer
  * @param[in] crc Starting CRC value
@@ -276,9 +313,38 @@ uint32_t PIOS_CRC32_updateByte(uint32_t crc, const uint8_t data)
  */
 uint32_t PIOS_CRC32_updateCRC(uint32_t crc, const uint8_t* data, int32_t length)
 {
-	register uint8_t *p = (uint8_t *)data;
-	register uint32_t _crc = crc;
-	for (register uint32_t i = length; i > 0; i--)
-		_crc = (_crc << 8) ^ CRC_Table32[(_crc >> 24) ^ *p++];
-	return _crc;
+	const uint8_t *p = data;
+
+#if defined(PIOS_CRC32_HW)
+	if (length >= CRC32_HW_MIN_LENGTH) {
+		int32_t done = crc32_hw_update(&crc, p, length);
+
+		p += done;
+		length -= done;
+	}
+#endif
+
+	/* The CRC is MSB first, so the first four bytes line up with it */
+#if PIOS_CRC32_SLICE_BY == 8
+	for (; length >= 8; length -= 8, p += 8) {
+		uint32_t x = crc ^ ((uint32_t) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]);
+
+		crc = CRC_Table32[7][x >> 24] ^ CRC_Table32[6][(x >> 16) & 0xff] ^
+			CRC_Table32[5][(x >> 8) & 0xff] ^ CRC_Table32[4][x & 0xff] ^
+			CRC_Table32[3][p[4]] ^ CRC_Table32[2][p[5]] ^
+			CRC_Table32[1][p[6]] ^ CRC_Table32[0][p[7]];
+	}
+#elif PIOS_CRC32_SLICE_BY == 4
+	for (; length >= 4; length -= 4, p += 4) {
+		uint32_t x = crc ^ ((uint32_t) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]);
+
+		crc = CRC_Table32[3][x >> 24] ^ CRC_Table32[2][(x >> 16) & 0xff] ^
+			CRC_Table32[1][(x >> 8) & 0xff] ^ CRC_Table32[0][x & 0xff];
+	}
+#endif
+
+	while (length-- > 0)
+		crc = (crc << 8) ^ CRC_Table32[0][(crc >> 24) ^ *p++];
+
+	return crc;
 }
@@ -57,6 +57,7 @@ struct pios_crossfire_dev {
 	uint8_t bytes_expected;
 
 	uint16_t channel_data[PIOS_CROSSFIRE_CHANNELS];
+	struct pios_rcvr_frame_buf frames;
 
 	union {
 		struct crsf_frame_t frame;
@@ -94,12 +95,23 @@ static bool PIOS_Crossfire_Validate(const struct pios_crossfire_dev *dev);
  * @retval raw channel value, or error value (see pios_rcvr.h)
  */
 static int32_t PIOS_Crossfire_Read(uintptr_t id, uint8_t channel);
+/**
+ * @brief Get the frames published by a driver instance
+ * @param[in] id Driver instance
+ * @retval frame buffer of the instance
+ */
+static const struct pios_rcvr_frame_buf *PIOS_Crossfire_GetFrameBuf(uintptr_t id);
 /**
  * @brief Set all channels in the last frame buffer to a given value
  * @param[in] dev Driver instance
  * @param[in] value channel value
  */
 static void PIOS_Crossfire_SetAllChannels(struct pios_crossfire_dev *dev, uint16_t value);
+/**
+ * @brief Publish the channel buffer as a complete frame
+ * @param[in] dev Driver instance
+ */
+static void PIOS_Crossfire_PublishChannels(struct pios_crossfire_dev *dev);
 /**
  * @brief Serial receive callback
  * @param[in] context Driver instance handle
@@ -130,6 +142,7 @@ static void PIOS_Crossfire_Supervisor(uintptr_t context);
 // public
 const struct pios_rcvr_driver pios_crossfire_rcvr_driver = {
 	.read = PIOS_Crossfire_Read,
+	.get_frame_buf = PIOS_Crossfire_GetFrameBuf,
 };
 
 
@@ -190,7 +203,7 @@ int PIOS_Crossfire_InitTelemetry(uintptr_t crsf_id)
 
 static int32_t PIOS_Crossfire_Read(uintptr_t context, uint8_t channel)
 {
-	if (channel > PIOS_CROSSFIRE_CHANNELS)
+	if (channel >= PIOS_CROSSFIRE_CHANNELS)
 		return PIOS_RCVR_INVALID;
 
 	struct pios_crossfire_dev *dev = (struct pios_crossfire_dev *)context;
@@ -200,12 +213,26 @@ static int32_t PIOS_Crossfire_Read(uintptr_t context, uint8_t channel)
 	return dev->channel_data[channel];
 }
 
+static const struct pios_rcvr_frame_buf *PIOS_Crossfire_GetFrameBuf(uintptr_t context)
+{
+	struct pios_crossfire_dev *dev = (struct pios_crossfire_dev *)context;
+	PIOS_Assert(PIOS_Crossfire_Validate(dev));
+
+	return &dev->frames;
+}
+
 static void PIOS_Crossfire_SetAllChannels(struct pios_crossfire_dev *dev, uint16_t value)
 {
 	for (int i = 0; i < PIOS_CROSSFIRE_CHANNELS; i++)
 		dev->channel_data[i] = value;
 }
 
+static void PIOS_Crossfire_PublishChannels(struct pios_crossfire_dev *dev)
+{
+	PIOS_RCVR_PublishFrame(&dev->frames, dev->channel_data,
+			PIOS_CROSSFIRE_CHANNELS);
+}
+
 static uint16_t PIOS_Crossfire_Receive(uintptr_t context, uint8_t *buf, uint16_t buf_len,
 		uint16_t *headroom, bool *task_woken)
 {
@@ -237,14 +264,10 @@ static uint16_t PIOS_Crossfire_Receive(uintptr_t context, uint8_t *buf, uint16_t
 		}
 
 		if (dev->buf_pos == dev->bytes_expected) {
-			// Frame complete, decode.
-			if(PIOS_Crossfire_UnpackFrame(dev)) {
-				// Frame is valid, trigger semaphore.
-				PIOS_RCVR_ActiveFromISR();
-				// Ignore any stuff that might be left in the buffer.
-				// There shouldn't be anything.
-				break;
-			}
+			// Frame complete, decode. A valid frame is published
+			// right away; anything after it starts the next one.
+			if(PIOS_Crossfire_UnpackFrame(dev))
+				PIOS_Crossfire_PublishChannels(dev);
 		}
 	}
 
@@ -332,9 +355,11 @@ static void PIOS_Crossfire_Supervisor(uintptr_t context)
 	if (++dev->rx_timer > 1)
 		PIOS_Crossfire_ResetBuffer(dev);
 
-	// Failsafe after 250ms.
-	if (++dev->failsafe_timer > 156)
+	// Failsafe after 250ms. The timer stops there so it can't wrap.
+	if (dev->failsafe_timer <= 156 && ++dev->failsafe_timer > 156) {
 		PIOS_Crossfire_SetAllChannels(dev, PIOS_RCVR_TIMEOUT);
+		PIOS_Crossfire_PublishChannels(dev);
+	}
 }
 
 int PIOS_Crossfire_SendTelemetry(uintptr_t crsf_id, uint8_t *buf, uint8_t bytes)
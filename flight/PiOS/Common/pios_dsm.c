@@ -47,9 +47,11 @@ static void PIOS_DSM_Supervisor(uintptr_t dsm_id);
 
 #if defined(PIOS_INCLUDE_RCVR)
 static int32_t PIOS_DSM_Get(uintptr_t rcvr_id, uint8_t channel);
+static const struct pios_rcvr_frame_buf *PIOS_DSM_GetFrameBuf(uintptr_t rcvr_id);
 
 const struct pios_rcvr_driver pios_dsm_rcvr_driver = {
 	.read = PIOS_DSM_Get,
+	.get_frame_buf = PIOS_DSM_GetFrameBuf,
 };
 #endif
 
@@ -68,6 +70,11 @@ struct pios_dsm_state {
 	uint8_t failsafe_timer;
 	uint8_t frame_found;
 	uint8_t byte_count;
+#if defined(PIOS_INCLUDE_RCVR)
+	bool two_packet_frames;
+	bool last_was_first_packet;
+	struct pios_rcvr_frame_buf frames;
+#endif
 #ifdef DSM_LOST_FRAME_COUNTER
 	uint8_t	frames_lost_last;
 	uint16_t frames_lost;
@@ -90,6 +97,7 @@ static struct pios_dsm_dev *PIOS_DSM_Alloc(void)
 	if (!dsm_dev)
 		return NULL;
 
+	memset(dsm_dev, 0, sizeof(*dsm_dev));
 	dsm_dev->resolution = DSM_UNKNOWN;
 	dsm_dev->magic = PIOS_DSM_DEV_MAGIC;
 	return dsm_dev;
@@ -146,6 +154,41 @@ static void PIOS_DSM_ResetChannels(struct pios_dsm_dev *dsm_dev)
 	}
 }
 
+#if defined(PIOS_INCLUDE_RCVR)
+/* Publish the channels as a complete frame */
+static void PIOS_DSM_PublishChannels(struct pios_dsm_dev *dsm_dev)
+{
+	struct pios_dsm_state *state = &(dsm_dev->state);
+	PIOS_RCVR_PublishFrame(&state->frames, state->channel_data,
+			PIOS_DSM_NUM_INPUTS);
+}
+
+/**
+ * Whether the packet just unrolled completes a set of channels.  When the
+ * transmitter sends more channels than fit one packet, they come in pairs
+ * of packets and the second is flagged in its first channel word.  Either
+ * way a set is only complete when the packet before it was a first one:
+ * the other half of the pair, or a whole set of the same kind.
+ */
+static bool PIOS_DSM_PacketCompletesFrame(struct pios_dsm_state *state)
+{
+	uint16_t word0 = ((uint16_t)state->received_data[2] << 8) |
+		state->received_data[3];
+	bool follows_first_packet = state->last_was_first_packet;
+
+	if (word0 != 0xffff && (word0 & DSM_2ND_FRAME_MASK)) {
+		state->two_packet_frames = true;
+		state->last_was_first_packet = false;
+
+		return follows_first_packet;
+	}
+
+	state->last_was_first_packet = true;
+
+	return follows_first_packet && !state->two_packet_frames;
+}
+#endif
+
 /* Reset DSM receiver state */
 static void PIOS_DSM_ResetState(struct pios_dsm_dev *dsm_dev)
 {
@@ -261,7 +304,8 @@ int PIOS_DSM_UnrollChannels(struct pios_dsm_dev *dsm_dev)
 
 		/* extract and save the channel value */
 		uint8_t channel_num = (word >> resolution) & 0x0f;
-		state->channel_data[channel_num] = (word & mask);
+		if (channel_num < PIOS_DSM_NUM_INPUTS)
+			state->channel_data[channel_num] = (word & mask);
 	}
 
 #ifdef DSM_LOST_FRAME_COUNTER
@@ -292,7 +336,8 @@ static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
 					/* data looking good */
 					state->failsafe_timer = 0;
 #ifdef PIOS_INCLUDE_RCVR
-					PIOS_RCVR_ActiveFromISR();
+					if (PIOS_DSM_PacketCompletesFrame(state))
+						PIOS_DSM_PublishChannels(dsm_dev);
 #endif
 				}
 
@@ -359,6 +404,9 @@ int32_t PIOS_DSM_Init(uintptr_t *dsm_id,
 		PIOS_DSM_Bind(dsm_dev, num_pulses);
 
 	PIOS_DSM_ResetState(dsm_dev);
+#if defined(PIOS_INCLUDE_RCVR)
+	PIOS_DSM_PublishChannels(dsm_dev);
+#endif
 
 	*dsm_id = (uintptr_t)dsm_dev;
 
@@ -423,6 +471,17 @@ static int32_t PIOS_DSM_Get(uintptr_t rcvr_id, uint8_t channel)
 	/* may also be PIOS_RCVR_TIMEOUT set by other function */
 	return dsm_dev->state.channel_data[channel];
 }
+
+/* Get the frames published from the DSM stream */
+static const struct pios_rcvr_frame_buf *PIOS_DSM_GetFrameBuf(uintptr_t rcvr_id)
+{
+	struct pios_dsm_dev *dsm_dev = (struct pios_dsm_dev *)rcvr_id;
+
+	bool valid = PIOS_DSM_Validate(dsm_dev);
+	PIOS_Assert(valid);
+
+	return &dsm_dev->state.frames;
+}
 #endif
 
 /**
@@ -456,6 +515,9 @@ static void PIOS_DSM_Supervisor(uintptr_t dsm_id)
 	/* activate failsafe if no frames have arrived in ~250ms */
 	if (++state->failsafe_timer > 156) {
 		PIOS_DSM_ResetChannels(dsm_dev);
+#if defined(PIOS_INCLUDE_RCVR)
+		PIOS_DSM_PublishChannels(dsm_dev);
+#endif
 		state->failsafe_timer = 0;
 	}
 }
@@ -140,7 +140,8 @@ uintptr_t pios_com_debug_id;
 #endif
 
 #ifndef PIOS_COM_GPS_RX_BUF_LEN
-#define PIOS_COM_GPS_RX_BUF_LEN 32
+// Several ms at 230400 baud, so the GPS task can read in batches
+#define PIOS_COM_GPS_RX_BUF_LEN 128
 #endif
 
 #ifndef PIOS_COM_GPS_TX_BUF_LEN
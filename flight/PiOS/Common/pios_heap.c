@@ -1,6 +1,7 @@
 /**
  ******************************************************************************
  * @file       pios_heap.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
  * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2014
  * @addtogroup PIOS PIOS Core hardware abstraction layer
  * @{
@@ -51,12 +52,27 @@ bool PIOS_heap_malloc_failed_p(void)
 
 #if defined(PIOS_INCLUDE_RTOS)
 #include "pios_thread.h"
+
+/*
+ * Firmware that can spare the RAM opts in to TLSF pools, so freed memory
+ * is reused.  The pool header and per block overhead cost more than the
+ * F1 and F3 boards have to give, and bootloaders only ever allocate and
+ * are short of flash, so those keep the simple allocator below.
+ */
+#if defined(PIOS_INCLUDE_TLSF)
+#include "pios_tlsf.h"
+#define PIOS_HEAP_TLSF
+#endif
 #endif
 
 struct pios_heap {
 	const uintptr_t start_addr;
 	uintptr_t end_addr;
+#if defined(PIOS_HEAP_TLSF)
+	struct pios_tlsf *tlsf;
+#else
 	uintptr_t free_addr;
+#endif
 };
 
 static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
@@ -66,15 +82,100 @@ static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
 	return ((buf_addr >= heap->start_addr) && (buf_addr <= heap->end_addr));
 }
 
-static void * simple_malloc(struct pios_heap *heap, size_t size)
+#if defined(PIOS_HEAP_TLSF)
+
+/* Must be called with the scheduler suspended */
+static struct pios_tlsf *heap_tlsf(struct pios_heap *heap)
 {
-	if (heap == NULL)
-		return NULL;
+	if (heap->tlsf == NULL) {
+		heap->tlsf = PIOS_TLSF_Create((void *)heap->start_addr,
+				heap->end_addr - heap->start_addr);
+	}
+
+	return heap->tlsf;
+}
 
+static void * heap_malloc(struct pios_heap *heap, size_t size)
+{
+	void * buf = NULL;
+
+	PIOS_Thread_Scheduler_Suspend();
+
+	struct pios_tlsf *tlsf = heap_tlsf(heap);
+	if (tlsf != NULL)
+		buf = PIOS_TLSF_Malloc(tlsf, size);
+
+	PIOS_Thread_Scheduler_Resume();
+
+	return buf;
+}
+
+static void heap_free(struct pios_heap *heap, void *buf)
+{
+	PIOS_Thread_Scheduler_Suspend();
+
+	/* Nothing can have come from a heap that was never set up */
+	if (heap->tlsf != NULL)
+		PIOS_TLSF_Free(heap->tlsf, buf);
+
+	PIOS_Thread_Scheduler_Resume();
+}
+
+static size_t heap_get_free_bytes(struct pios_heap *heap)
+{
+	size_t free_bytes = 0;
+
+	PIOS_Thread_Scheduler_Suspend();
+
+	struct pios_tlsf *tlsf = heap_tlsf(heap);
+	if (tlsf != NULL)
+		free_bytes = PIOS_TLSF_GetFreeSize(tlsf);
+
+	PIOS_Thread_Scheduler_Resume();
+
+	return free_bytes;
+}
+
+static void heap_get_stats(struct pios_heap *heap, struct pios_heap_stats *stats)
+{
+	struct pios_tlsf_stats tlsf_stats = { 0 };
+
+	PIOS_Thread_Scheduler_Suspend();
+
+	struct pios_tlsf *tlsf = heap_tlsf(heap);
+	if (tlsf != NULL)
+		PIOS_TLSF_GetStats(tlsf, &tlsf_stats);
+
+	PIOS_Thread_Scheduler_Resume();
+
+	stats->total_bytes = tlsf_stats.total_bytes;
+	stats->free_bytes = tlsf_stats.free_bytes;
+	stats->min_free_bytes = tlsf_stats.min_free_bytes;
+	stats->largest_free = tlsf_stats.largest_free;
+	stats->allocations = tlsf_stats.allocations;
+	stats->failures = tlsf_stats.failures;
+}
+
+static void heap_extend(struct pios_heap *heap, size_t bytes)
+{
+	PIOS_Thread_Scheduler_Suspend();
+
+	/* The new memory follows the heap, but is added as its own pool */
+	struct pios_tlsf *tlsf = heap_tlsf(heap);
+	if (tlsf != NULL && PIOS_TLSF_AddPool(tlsf, (void *)heap->end_addr, bytes))
+		heap->end_addr += bytes;
+
+	PIOS_Thread_Scheduler_Resume();
+}
+
+#else	/* PIOS_HEAP_TLSF */
+
+static void * heap_malloc(struct pios_heap *heap, size_t size)
+{
 	void * buf = NULL;
 	uint32_t align_pad = (sizeof(uintptr_t) - (size & (sizeof(uintptr_t) - 1))) % sizeof(uintptr_t);
 
-#if defined(PIOS_INCLUDE_RTOS) 
+#if defined(PIOS_INCLUDE_RTOS)
 	PIOS_Thread_Scheduler_Suspend();
 #endif	/* PIOS_INCLUDE_RTOS */
 
@@ -90,12 +191,12 @@ static void * simple_malloc(struct pios_heap *heap, size_t size)
 	return buf;
 }
 
-static void simple_free(struct pios_heap *heap, void *buf)
+static void heap_free(struct pios_heap *heap, void *buf)
 {
 	/* This allocator doesn't support free */
 }
 
-static size_t simple_get_free_bytes(struct pios_heap *heap)
+static size_t heap_get_free_bytes(struct pios_heap *heap)
 {
 	if (heap->free_addr > heap->end_addr)
 		return 0;
@@ -103,11 +204,25 @@ static size_t simple_get_free_bytes(struct pios_heap *heap)
 	return heap->end_addr - heap->free_addr;
 }
 
-static void simple_extend_heap(struct pios_heap *heap, size_t bytes)
+static void heap_get_stats(struct pios_heap *heap, struct pios_heap_stats *stats)
+{
+	size_t free_bytes = heap_get_free_bytes(heap);
+
+	*stats = (struct pios_heap_stats) {
+		.total_bytes = heap->end_addr - heap->start_addr,
+		.free_bytes = free_bytes,
+		.min_free_bytes = free_bytes,
+		.largest_free = free_bytes,
+	};
+}
+
+static void heap_extend(struct pios_heap *heap, size_t bytes)
 {
 	heap->end_addr += bytes;
 }
 
+#endif	/* PIOS_HEAP_TLSF */
+
 /*
  * Standard heap.  All memory in this heap is DMA-safe.
  */
@@ -117,14 +232,16 @@ extern const void * _sheap;	/* defined in linker script */
 static struct pios_heap pios_standard_heap = {
 	.start_addr = (const uintptr_t)&_sheap,
 	.end_addr   = (const uintptr_t)&_eheap,
+#if !defined(PIOS_HEAP_TLSF)
 	.free_addr  = (uintptr_t)&_sheap,
+#endif
 };
 
 
 void * pvPortMalloc(size_t size) __attribute__((alias ("PIOS_malloc"), weak));
 void * PIOS_malloc(size_t size)
 {
-	void *buf = simple_malloc(&pios_standard_heap, size);
+	void *buf = heap_malloc(&pios_standard_heap, size);
 
 	if (buf == NULL)
 		malloc_failed_hook();
@@ -145,11 +262,13 @@ extern const void * _sfastheap;	/* defined in linker script */
 static struct pios_heap pios_nodma_heap = {
 	.start_addr = (const uintptr_t)&_sfastheap,
 	.end_addr   = (const uintptr_t)&_efastheap,
+#if !defined(PIOS_HEAP_TLSF)
 	.free_addr  = (uintptr_t)&_sfastheap,
+#endif
 };
 void * PIOS_malloc_no_dma(size_t size)
 {
-	void * buf = simple_malloc(&pios_nodma_heap, size);
+	void * buf = heap_malloc(&pios_nodma_heap, size);
 
 	if (buf == NULL)
 		buf = PIOS_malloc(size);
@@ -175,45 +294,34 @@ void PIOS_free(void * buf)
 {
 #if defined(PIOS_INCLUDE_FASTHEAP)
 	if (is_ptr_in_heap_p(&pios_nodma_heap, buf))
-		return simple_free(&pios_nodma_heap, buf);
+		return heap_free(&pios_nodma_heap, buf);
 #endif	/* PIOS_INCLUDE_FASTHEAP */
 
 	if (is_ptr_in_heap_p(&pios_standard_heap, buf))
-		return simple_free(&pios_standard_heap, buf);
+		return heap_free(&pios_standard_heap, buf);
 }
 
 size_t xPortGetFreeHeapSize(void) __attribute__((alias ("PIOS_heap_get_free_size")));
 size_t PIOS_heap_get_free_size(void)
 {
-#if defined(PIOS_INCLUDE_RTOS)
-	PIOS_Thread_Scheduler_Suspend();
-#endif	/* PIOS_INCLUDE_RTOS */
-
-	size_t free_bytes = simple_get_free_bytes(&pios_standard_heap);
-
-#if defined(PIOS_INCLUDE_RTOS)
-	PIOS_Thread_Scheduler_Resume();
-#endif	/* PIOS_INCLUDE_RTOS */
-
-	return free_bytes;
+	return heap_get_free_bytes(&pios_standard_heap);
 }
 
+void PIOS_heap_get_stats(struct pios_heap_stats *stats)
+{
+	heap_get_stats(&pios_standard_heap, stats);
+}
 
 #if defined(PIOS_INCLUDE_FASTHEAP)
 
 size_t PIOS_fastheap_get_free_size(void)
 {
-#if defined(PIOS_INCLUDE_RTOS)
-	PIOS_Thread_Scheduler_Suspend();
-#endif	/* PIOS_INCLUDE_RTOS */
-
-	size_t free_bytes = simple_get_free_bytes(&pios_nodma_heap);
-
-#if defined(PIOS_INCLUDE_RTOS)
-	PIOS_Thread_Scheduler_Resume();
-#endif	/* PIOS_INCLUDE_RTOS */
+	return heap_get_free_bytes(&pios_nodma_heap);
+}
 
-	return free_bytes;
+void PIOS_fastheap_get_stats(struct pios_heap_stats *stats)
+{
+	heap_get_stats(&pios_nodma_heap, stats);
 }
 
 #else
@@ -223,24 +331,28 @@ size_t PIOS_fastheap_get_free_size(void)
 	return 0;
 }
 
+void PIOS_fastheap_get_stats(struct pios_heap_stats *stats)
+{
+	*stats = (struct pios_heap_stats) { 0 };
+}
+
 #endif // PIOS_INCLUDE_FASTHEAP
 
 void PIOS_heap_initialize_blocks(void)
 {
-	/* NOP for the simple allocator */
+#if defined(PIOS_HEAP_TLSF)
+	/* Set the pools up before anything allocates; the heaps would do it
+	 * on first use otherwise */
+	heap_get_free_bytes(&pios_standard_heap);
+#if defined(PIOS_INCLUDE_FASTHEAP)
+	heap_get_free_bytes(&pios_nodma_heap);
+#endif	/* PIOS_INCLUDE_FASTHEAP */
+#endif	/* PIOS_HEAP_TLSF */
 }
 
 void PIOS_heap_increase_size(size_t bytes)
 {
-#if defined(PIOS_INCLUDE_RTOS)
-	PIOS_Thread_Scheduler_Suspend();
-#endif	/* PIOS_INCLUDE_RTOS */
-
-	simple_extend_heap(&pios_standard_heap, bytes);
-
-#if defined(PIOS_INCLUDE_RTOS)
-	PIOS_Thread_Scheduler_Resume();
-#endif	/* PIOS_INCLUDE_RTOS */
+	heap_extend(&pios_standard_heap, bytes);
 }
 
 
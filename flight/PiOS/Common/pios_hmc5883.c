@@ -36,7 +36,7 @@
 
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
+#include "pios_spscqueue.h"
 
 /* Private constants */
 #define HMC5883_TASK_PRIORITY        PIOS_THREAD_PRIO_HIGHEST
@@ -53,7 +53,7 @@ enum pios_hmc5883_dev_magic {
 struct hmc5883_dev {
 	pios_i2c_t i2c_id;
 	const struct pios_hmc5883_cfg *cfg;
-	struct pios_queue *queue;
+	struct pios_spscqueue *queue;
 	struct pios_thread *task;
 	struct pios_semaphore *data_ready_sema;
 	enum pios_hmc5883_dev_magic magic;
@@ -80,7 +80,7 @@ static struct hmc5883_dev * PIOS_HMC5883_alloc(void)
 	
 	hmc5883_dev->magic = PIOS_HMC5883_DEV_MAGIC;
 	
-	hmc5883_dev->queue = PIOS_Queue_Create(PIOS_HMC5883_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_mag_data));
+	hmc5883_dev->queue = PIOS_SPSCQueue_Create(PIOS_HMC5883_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_mag_data));
 	if (hmc5883_dev->queue == NULL) {
 		PIOS_free(hmc5883_dev);
 		return NULL;
@@ -134,7 +134,7 @@ int32_t PIOS_HMC5883_Init(pios_i2c_t i2c_id, const struct pios_hmc5883_cfg *cfg)
 	if (PIOS_HMC5883_Config(cfg) != 0)
 		return -2;
 
-	PIOS_SENSORS_Register(PIOS_SENSOR_MAG, dev->queue);
+	PIOS_SENSORS_RegisterSPSCQueue(PIOS_SENSOR_MAG, dev->queue);
 
 	dev->task = PIOS_Thread_Create(PIOS_HMC5883_Task, "pios_hmc5883", HMC5883_TASK_STACK_BYTES, NULL, HMC5883_TASK_PRIORITY);
 
@@ -531,7 +531,7 @@ static void PIOS_HMC5883_Task(void *parameters)
 
 		struct pios_sensor_mag_data mag_data;
 		if (PIOS_HMC5883_ReadMag(&mag_data) == 0)
-			PIOS_Queue_Send(dev->queue, &mag_data, 0);
+			PIOS_SPSCQueue_Send(dev->queue, &mag_data, 0);
 	}
 }
 
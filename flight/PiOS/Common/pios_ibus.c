@@ -49,6 +49,7 @@ struct pios_ibus_dev {
 	uint16_t checksum;
 	uint16_t channel_data[PIOS_IBUS_CHANNELS];
 	uint8_t rx_buf[PIOS_IBUS_BUFLEN];
+	struct pios_rcvr_frame_buf frames;
 };
 
 /**
@@ -69,12 +70,23 @@ static bool PIOS_IBus_Validate(const struct pios_ibus_dev *dev);
  * @retval raw channel value, or error value (see pios_rcvr.h)
  */
 static int32_t PIOS_IBus_Read(uintptr_t id, uint8_t channel);
+/**
+ * @brief Get the frames published by a driver instance
+ * @param[in] id Driver instance
+ * @retval frame buffer of the instance
+ */
+static const struct pios_rcvr_frame_buf *PIOS_IBus_GetFrameBuf(uintptr_t id);
 /**
  * @brief Set all channels in the last frame buffer to a given value
  * @param[in] dev Driver instance
  * @param[in] value channel value
  */
 static void PIOS_IBus_SetAllChannels(struct pios_ibus_dev *dev, uint16_t value);
+/**
+ * @brief Publish the channel buffer as a complete frame
+ * @param[in] dev Driver instance
+ */
+static void PIOS_IBus_PublishChannels(struct pios_ibus_dev *dev);
 /**
  * @brief Serial receive callback
  * @param[in] context Driver instance handle
@@ -105,6 +117,7 @@ static void PIOS_IBus_Supervisor(uintptr_t context);
 // public
 const struct pios_rcvr_driver pios_ibus_rcvr_driver = {
 	.read = PIOS_IBus_Read,
+	.get_frame_buf = PIOS_IBus_GetFrameBuf,
 };
 
 
@@ -135,6 +148,7 @@ int PIOS_IBus_Init(uintptr_t *ibus_id, const struct pios_com_driver *driver,
 
 	*ibus_id = (uintptr_t)dev;
 
+	PIOS_IBus_ResetBuffer(dev);
 	PIOS_IBus_SetAllChannels(dev, PIOS_RCVR_INVALID);
 
 	if (!PIOS_RTC_RegisterTickCallback(PIOS_IBus_Supervisor, *ibus_id))
@@ -147,7 +161,7 @@ int PIOS_IBus_Init(uintptr_t *ibus_id, const struct pios_com_driver *driver,
 
 static int32_t PIOS_IBus_Read(uintptr_t context, uint8_t channel)
 {
-	if (channel > PIOS_IBUS_CHANNELS)
+	if (channel >= PIOS_IBUS_CHANNELS)
 		return PIOS_RCVR_INVALID;
 
 	struct pios_ibus_dev *dev = (struct pios_ibus_dev *)context;
@@ -157,12 +171,26 @@ static int32_t PIOS_IBus_Read(uintptr_t context, uint8_t channel)
 	return dev->channel_data[channel];
 }
 
+static const struct pios_rcvr_frame_buf *PIOS_IBus_GetFrameBuf(uintptr_t context)
+{
+	struct pios_ibus_dev *dev = (struct pios_ibus_dev *)context;
+	PIOS_Assert(PIOS_IBus_Validate(dev));
+
+	return &dev->frames;
+}
+
 static void PIOS_IBus_SetAllChannels(struct pios_ibus_dev *dev, uint16_t value)
 {
 	for (int i = 0; i < PIOS_IBUS_CHANNELS; i++)
 		dev->channel_data[i] = value;
 }
 
+static void PIOS_IBus_PublishChannels(struct pios_ibus_dev *dev)
+{
+	PIOS_RCVR_PublishFrame(&dev->frames, dev->channel_data,
+			PIOS_IBUS_CHANNELS);
+}
+
 static uint16_t PIOS_IBus_Receive(uintptr_t context, uint8_t *buf, uint16_t buf_len,
 		uint16_t *headroom, bool *task_woken)
 {
@@ -224,6 +252,8 @@ static void PIOS_IBus_UnpackFrame(struct pios_ibus_dev *dev)
 
 	dev->failsafe_timer = 0;
 
+	PIOS_IBus_PublishChannels(dev);
+
 out_fail:
 	PIOS_IBus_ResetBuffer(dev);
 }
@@ -237,8 +267,10 @@ static void PIOS_IBus_Supervisor(uintptr_t context)
 		PIOS_IBus_ResetBuffer(dev);
 
 	/* ~250ms to failsafe. */
-	if (++dev->failsafe_timer > 156)
+	if (dev->failsafe_timer <= 156 && ++dev->failsafe_timer > 156) {
 		PIOS_IBus_SetAllChannels(dev, PIOS_RCVR_TIMEOUT);
+		PIOS_IBus_PublishChannels(dev);
+	}
 }
 
 #endif // PIOS_INCLUDE_IBUS
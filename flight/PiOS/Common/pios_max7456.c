@@ -69,6 +69,15 @@
 #define SYNC_INTERVAL_NTSC 33366
 #define SYNC_INTERVAL_PAL  40000
 
+/* Display memory is linear, row * 30 + col; PAL is the larger of the two. */
+#define MAX7456_CELLS (MAX7456_PAL_ROWS * MAX7456_COLUMNS)
+
+/* Starting a new auto-increment burst costs 8 bytes on the wire (DMAH,
+ * DMAL, DMM, stop); rewriting an unchanged cell inside a burst costs 2.
+ * Bridge gaps of up to this many clean cells rather than restarting.
+ */
+#define MAX7456_FLUSH_MAX_GAP 3
+
 ///////////////////////////////////////////////////////////////////////////////
 
 struct max7456_dev_s {
@@ -80,15 +89,27 @@ struct max7456_dev_s {
 	uint8_t mode, right, bottom, hcenter, vcenter;
 
 	uint8_t mask;
-	bool opened;
 
 	bool force_mode;
 	uint8_t det_mode_fallback;
 
 	uint32_t next_sync_expected;
+
+	/* put/puts/clear only touch the shadow.  shown holds what display
+	 * memory on the chip contains, and a bit is set in dirty for every
+	 * cell where the two differ.  PIOS_MAX7456_flush pushes those.
+	 */
+	uint8_t shadow_chr[MAX7456_CELLS];
+	uint8_t shadow_attr[MAX7456_CELLS];
+	uint8_t shown_chr[MAX7456_CELLS];
+	uint8_t shown_attr[MAX7456_CELLS];
+	uint32_t dirty[MAX7456_PAL_ROWS];
+
+	uint32_t flush_bytes;
 };
 
 static bool poll_vsync_spi (max7456_dev_t dev);
+static void clear_display_memory(max7456_dev_t dev);
 
 /* Max7456 says 100ns period (10MHz) is OK.  But it may be off-board in
  * some circumstances, so let's not push our luck.
@@ -249,6 +270,8 @@ void PIOS_MAX7456_wait_vsync(max7456_dev_t dev)
 	}
 
 	dev->next_sync_expected = now + sync_interval;
+
+	PIOS_MAX7456_flush(dev);
 }
 
 static void reset_hard(max7456_dev_t dev)
@@ -283,7 +306,7 @@ static void reset_hard(max7456_dev_t dev)
 		write_register_sel(dev, r, brightness);
 	}
 
-	PIOS_MAX7456_clear(dev);
+	clear_display_memory(dev);
 }
 
 int PIOS_MAX7456_init(max7456_dev_t *dev_out,
@@ -314,11 +337,39 @@ void PIOS_MAX7456_set_mode(max7456_dev_t dev, bool force, uint8_t fallback)
 	detect_mode(dev);
 }
 
-void PIOS_MAX7456_clear(max7456_dev_t dev)
+static inline void update_dirty(max7456_dev_t dev, uint16_t pos)
 {
-	PIOS_Assert(dev->magic == MAX7456_MAGIC);
-	PIOS_Assert(!dev->opened);
+	uint32_t bit = 1UL << (pos % MAX7456_COLUMNS);
+	uint32_t *row_dirty = &dev->dirty[pos / MAX7456_COLUMNS];
+
+	if (dev->shadow_chr[pos] != dev->shown_chr[pos] ||
+			dev->shadow_attr[pos] != dev->shown_attr[pos]) {
+		*row_dirty |= bit;
+	} else {
+		*row_dirty &= ~bit;
+	}
+}
 
+static inline bool is_dirty(max7456_dev_t dev, uint16_t pos)
+{
+	return dev->dirty[pos / MAX7456_COLUMNS] &
+		(1UL << (pos % MAX7456_COLUMNS));
+}
+
+static inline void set_cell(max7456_dev_t dev, uint16_t pos, uint8_t chr,
+		uint8_t attr)
+{
+	dev->shadow_chr[pos] = chr;
+	dev->shadow_attr[pos] = attr & 0x07;
+
+	update_dirty(dev, pos);
+}
+
+/* Clears display memory on the chip itself; the shadow is left alone, so
+ * whatever it holds gets redrawn on the next flush.
+ */
+static void clear_display_memory(max7456_dev_t dev)
+{
 	uint8_t dmm;
 	dmm = read_register_sel(dev, MAX7456_REG_DMM);
 
@@ -330,6 +381,25 @@ void PIOS_MAX7456_clear(max7456_dev_t dev)
 	while (MAX7456_DMM_CLR_R(dmm) != MAX7456_DMM_CLR_READY) {
 		dmm = read_register_sel(dev, MAX7456_REG_DMM);
 	}
+
+	memset(dev->shown_chr, 0, sizeof(dev->shown_chr));
+	memset(dev->shown_attr, 0, sizeof(dev->shown_attr));
+
+	for (uint16_t pos = 0; pos < MAX7456_CELLS; pos++) {
+		update_dirty(dev, pos);
+	}
+}
+
+void PIOS_MAX7456_clear(max7456_dev_t dev)
+{
+	PIOS_Assert(dev->magic == MAX7456_MAGIC);
+
+	memset(dev->shadow_chr, 0, sizeof(dev->shadow_chr));
+	memset(dev->shadow_attr, 0, sizeof(dev->shadow_attr));
+
+	for (uint16_t pos = 0; pos < MAX7456_CELLS; pos++) {
+		update_dirty(dev, pos);
+	}
 }
 
 void PIOS_MAX7456_upload_char (max7456_dev_t dev, uint8_t char_index,
@@ -408,18 +478,11 @@ void PIOS_MAX7456_download_char (max7456_dev_t dev, uint8_t char_index,
 }
 
 /* Assumes you have already selected */
-static inline void set_offset (max7456_dev_t dev, uint8_t col, uint8_t row)
+static inline void set_offset(max7456_dev_t dev, uint16_t offset)
 {
-	PIOS_Assert(dev->magic == MAX7456_MAGIC);
-
-	if (col > 29) {
-		// Still will wrap to next line...
-		col = 29;
-	}
-
-	uint16_t offset = (row * 30 + col) & 0x1ff;
+	offset &= 0x1ff;
 	write_register(dev, MAX7456_REG_DMAH, offset >> 8);
-	write_register(dev, MAX7456_REG_DMAL,(uint8_t) offset);
+	write_register(dev, MAX7456_REG_DMAL, (uint8_t) offset);
 }
 
 static bool poll_vsync_spi (max7456_dev_t dev)
@@ -434,59 +497,151 @@ void PIOS_MAX7456_put (max7456_dev_t dev,
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
 
-	PIOS_Assert(!dev->opened);
+	if (col > 29) {
+		// Still will wrap to next line...
+		col = 29;
+	}
+
+	uint16_t pos = row * MAX7456_COLUMNS + col;
 
-	chip_select(dev);
-	set_offset(dev, col, row);
-	write_register(dev, MAX7456_REG_DMM,(attr & 0x07) << 3);
-	write_register(dev, MAX7456_REG_DMDI, chr);
-	chip_unselect(dev);
+	if (pos >= MAX7456_CELLS) {
+		return;
+	}
+
+	set_cell(dev, pos, chr, attr);
 }
 
-static void PIOS_MAX7456_open (max7456_dev_t dev, uint8_t col, uint8_t row,
-		uint8_t attr)
+#define valid_char(c) (c == MAX7456_DMDI_AUTOINCREMENT_STOP ? 0x00 : c)
+void PIOS_MAX7456_puts(max7456_dev_t dev, uint8_t col, uint8_t row, const char *s, uint8_t attr)
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
 
-	PIOS_Assert(!dev->opened);
+	if (col == MAX7456_FMT_H_CENTER) {
+		col = ((MAX7456_COLUMNS - strlen(s)) / 2);
+	}
 
-	dev->opened = true;
+	if (col > dev->right) {
+		col = 0;
+	}
 
-	chip_select(dev);
-	set_offset(dev, col > dev->right ? 0 : col, row > dev->bottom ? 0 : row);
+	if (row > dev->bottom) {
+		row = 0;
+	}
 
-	// 16 bits operating mode, char attributes, autoincrement
-	write_register(dev, MAX7456_REG_DMM, ((attr & 0x07) << 3) | 0x01);
+	/* Like auto-increment on the chip, long strings run on into the
+	 * next row. */
+	for (uint16_t pos = row * MAX7456_COLUMNS + col;
+			*s && pos < MAX7456_CELLS; s++, pos++) {
+		set_cell(dev, pos, valid_char((uint8_t) *s), attr);
+	}
 }
 
-static void PIOS_MAX7456_close (max7456_dev_t dev)
+/**
+ * Writes shadow cells [start, end) in one auto-increment burst.  All cells
+ * in the range must share the attribute of the first, and none may hold
+ * the auto-increment stop character.
+ */
+static void flush_run(max7456_dev_t dev, uint16_t start, uint16_t end)
 {
-	PIOS_Assert(dev->magic == MAX7456_MAGIC);
+	uint8_t attr = dev->shadow_attr[start];
 
-	PIOS_Assert(dev->opened);
+	set_offset(dev, start);
+
+	if (dev->shadow_chr[start] == MAX7456_DMDI_AUTOINCREMENT_STOP) {
+		/* Can't be sent in auto-increment mode; write it alone. */
+		write_register(dev, MAX7456_REG_DMM, attr << 3);
+		write_register(dev, MAX7456_REG_DMDI, dev->shadow_chr[start]);
+
+		dev->shown_chr[start] = dev->shadow_chr[start];
+		dev->shown_attr[start] = attr;
+
+		dev->flush_bytes += 8;
+		return;
+	}
+
+	// 16 bits operating mode, char attributes, autoincrement
+	write_register(dev, MAX7456_REG_DMM, (attr << 3) | 0x01);
+
+	for (uint16_t pos = start; pos < end; pos++) {
+		write_register(dev, MAX7456_REG_DMDI, dev->shadow_chr[pos]);
+
+		dev->shown_chr[pos] = dev->shadow_chr[pos];
+		dev->shown_attr[pos] = attr;
+	}
 
 	// terminate autoincrement mode
 	write_register(dev, MAX7456_REG_DMDI, MAX7456_DMDI_AUTOINCREMENT_STOP);
 
-	chip_unselect(dev);
-	dev->opened = false;
+	dev->flush_bytes += 8 + 2 * (end - start);
 }
 
-#define valid_char(c) (c == MAX7456_DMDI_AUTOINCREMENT_STOP ? 0x00 : c)
-void PIOS_MAX7456_puts(max7456_dev_t dev, uint8_t col, uint8_t row, const char *s, uint8_t attr)
+uint32_t PIOS_MAX7456_flush(max7456_dev_t dev)
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
 
-	if (col == MAX7456_FMT_H_CENTER) {
-		col = ((MAX7456_COLUMNS - strlen(s)) / 2);
+	bool any_dirty = false;
+
+	for (uint8_t row = 0; row < MAX7456_PAL_ROWS; row++) {
+		if (dev->dirty[row]) {
+			any_dirty = true;
+			break;
+		}
 	}
-	PIOS_MAX7456_open(dev, col, row, attr);
-	while (*s)
-	{
-		write_register(dev, MAX7456_REG_DMDI, valid_char(*s));
-		s++;
+
+	if (!any_dirty) {
+		return 0;
 	}
-	PIOS_MAX7456_close(dev);
+
+	dev->flush_bytes = 0;
+
+	chip_select(dev);
+
+	uint16_t pos = 0;
+
+	while (pos < MAX7456_CELLS) {
+		if (!dev->dirty[pos / MAX7456_COLUMNS]) {
+			/* Skip to the start of the next row */
+			pos += MAX7456_COLUMNS - (pos % MAX7456_COLUMNS);
+			continue;
+		}
+
+		if (!is_dirty(dev, pos)) {
+			pos++;
+			continue;
+		}
+
+		uint8_t attr = dev->shadow_attr[pos];
+		uint16_t start = pos;
+		uint16_t end = pos + 1;
+
+		/* Grow the run while cells share the attribute, bridging short
+		 * stretches of clean cells; end is one past the last dirty
+		 * cell taken.
+		 */
+		for (uint16_t next = end; next < MAX7456_CELLS &&
+				next - end <= MAX7456_FLUSH_MAX_GAP &&
+				dev->shadow_attr[next] == attr &&
+				dev->shadow_chr[start] != MAX7456_DMDI_AUTOINCREMENT_STOP &&
+				dev->shadow_chr[next] != MAX7456_DMDI_AUTOINCREMENT_STOP;
+				next++) {
+			if (is_dirty(dev, next)) {
+				end = next + 1;
+			}
+		}
+
+		flush_run(dev, start, end);
+
+		for (uint16_t p = start; p < end; p++) {
+			dev->dirty[p / MAX7456_COLUMNS] &=
+				~(1UL << (p % MAX7456_COLUMNS));
+		}
+
+		pos = end;
+	}
+
+	chip_unselect(dev);
+
+	return dev->flush_bytes;
 }
 
 void PIOS_MAX7456_get_extents(max7456_dev_t dev, 
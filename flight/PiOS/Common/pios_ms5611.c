@@ -36,7 +36,7 @@
 #include "pios_ms5611_priv.h"
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
+#include "pios_spscqueue.h"
 
 /* Private constants */
 #define PIOS_MS5611_OVERSAMPLING oversampling
@@ -80,7 +80,7 @@ struct ms5611_dev {
 	const struct pios_ms5611_cfg * cfg;
 	pios_i2c_t i2c_id;
 	struct pios_thread *task;
-	struct pios_queue *queue;
+	struct pios_spscqueue *queue;
 
 	int64_t pressure_unscaled;
 	int64_t temperature_unscaled;
@@ -106,7 +106,7 @@ static struct ms5611_dev * PIOS_MS5611_alloc(void)
 
 	memset(ms5611_dev, 0, sizeof(*ms5611_dev));
 
-	ms5611_dev->queue = PIOS_Queue_Create(1, sizeof(struct pios_sensor_baro_data));
+	ms5611_dev->queue = PIOS_SPSCQueue_Create(1, sizeof(struct pios_sensor_baro_data));
 	if (ms5611_dev->queue == NULL) {
 		PIOS_free(ms5611_dev);
 		return NULL;
@@ -166,7 +166,7 @@ int32_t PIOS_MS5611_Init(const struct pios_ms5611_cfg *cfg, pios_i2c_t i2c_devic
 		dev->calibration[i] = (data[0] << 8) | data[1];
 	}
 
-	PIOS_SENSORS_Register(PIOS_SENSOR_BARO, dev->queue);
+	PIOS_SENSORS_RegisterSPSCQueue(PIOS_SENSOR_BARO, dev->queue);
 
 	dev->task = PIOS_Thread_Create(
 			PIOS_MS5611_Task, "pios_ms5611", MS5611_TASK_STACK_BYTES, NULL, MS5611_TASK_PRIORITY);
@@ -443,7 +443,7 @@ static void PIOS_MS5611_Task(void *parameters)
 		data.altitude = 44330.0f * (1.0f - powf(data.pressure / MS5611_P0, (1.0f / 5.255f)));
 
 		if (read_adc_result == 0) {
-			PIOS_Queue_Send(dev->queue, &data, 0);
+			PIOS_SPSCQueue_Send(dev->queue, &data, 0);
 		}
 	}
 }
@@ -0,0 +1,298 @@
+/**
+ ******************************************************************************
+ * @file       pios_profiler.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Profiler Sampling profiler
+ * @{
+ * @brief Statistical profiler that samples the interrupted program counter
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * Samples are taken from interrupt context (ChibiOS) or a SIGPROF handler
+ * (posix) into a ring that one thread drains.  The sampling context only
+ * ever advances the head and the reader only the tail, so no locking is
+ * needed; when the ring is full new samples are counted and discarded.
+ *
+ * On ChibiOS the sampler runs from the system tick.  Threads that wake on
+ * tick boundaries start running right after a sample is taken, so short
+ * tick-driven work is undercounted; work paced by sensor interrupts, such
+ * as the stabilization and attitude loops, is sampled fairly.
+ */
+
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_PROFILER)
+
+#include "pios_profiler.h"
+#include "pios_thread.h"
+
+#if defined(FLIGHT_POSIX)
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
+
+#if !defined(PIOS_PROFILER_SAMPLES)
+#define PIOS_PROFILER_SAMPLES 256	/* Must be a power of 2 */
+#endif
+
+DONT_BUILD_IF((PIOS_PROFILER_SAMPLES & (PIOS_PROFILER_SAMPLES - 1)) != 0,
+		ProfilerRingPowerOf2);
+
+static struct pios_profiler_sample ring[PIOS_PROFILER_SAMPLES];
+static volatile uint32_t ring_head;	/* Written by the sampler only */
+static volatile uint32_t ring_tail;	/* Written by the reader only */
+static volatile uint32_t dropped;
+static volatile bool sampling;
+
+static void sample_push(uint32_t pc, uintptr_t thread)
+{
+	uint32_t head = ring_head;
+
+	if (head - ring_tail >= PIOS_PROFILER_SAMPLES) {
+		dropped++;
+		return;
+	}
+
+	struct pios_profiler_sample *s = &ring[head % PIOS_PROFILER_SAMPLES];
+
+	s->pc = pc;
+	s->thread = thread;
+
+	/* Publish the sample only once it is complete */
+	__sync_synchronize();
+
+	ring_head = head + 1;
+}
+
+#if defined(PIOS_INCLUDE_CHIBIOS)
+
+static uint16_t tick_divider;
+static uint16_t tick_countdown;
+
+/**
+ * Called from the ChibiOS system tick hook.
+ */
+void PIOS_Profiler_Tick_FromISR(void)
+{
+	if (!sampling || --tick_countdown) {
+		return;
+	}
+
+	tick_countdown = tick_divider;
+
+	uint32_t pc = 0;
+	uintptr_t thread = 0;
+
+	/* Only the thread's exception frame is in a known place: on the
+	 * process stack, with the return address 6 words in.  If another
+	 * handler was interrupted, just record that. */
+	if (SCB->ICSR & SCB_ICSR_RETTOBASE_Msk) {
+		const uint32_t *frame = (const uint32_t *) __get_PSP();
+
+		pc = frame[6];
+		thread = PIOS_Thread_Current_Id();
+	}
+
+	sample_push(pc, thread);
+}
+
+/**
+ * Start sampling.
+ * @param[in] rate_hz samples per second; rounded to a whole number of
+ * system ticks
+ * @returns 0 on success, -1 if the rate is not possible
+ */
+int32_t PIOS_Profiler_Start(uint16_t rate_hz)
+{
+	if (rate_hz == 0 || rate_hz > CH_FREQUENCY) {
+		return -1;
+	}
+
+	sampling = false;
+
+	tick_divider = CH_FREQUENCY / rate_hz;
+	tick_countdown = tick_divider;
+
+	sampling = true;
+
+	return 0;
+}
+
+/**
+ * Stop sampling.  Samples already taken can still be read.
+ */
+void PIOS_Profiler_Stop(void)
+{
+	sampling = false;
+}
+
+#elif defined(FLIGHT_POSIX)
+
+/* Provided by the linker: the lowest address of the executable image */
+extern const char __executable_start[];
+
+static volatile uint8_t handler_busy;
+
+static uintptr_t context_pc(const ucontext_t *uc)
+{
+#if defined(__linux__) && defined(__x86_64__)
+	return uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__linux__) && defined(__i386__)
+	return uc->uc_mcontext.gregs[REG_EIP];
+#elif defined(__linux__) && defined(__aarch64__)
+	return uc->uc_mcontext.pc;
+#elif defined(__linux__) && defined(__arm__)
+	return uc->uc_mcontext.arm_pc;
+#else
+	(void) uc;
+	return 0;
+#endif
+}
+
+static void sigprof_handler(int sig, siginfo_t *info, void *context)
+{
+	(void) sig;
+	(void) info;
+
+	if (!sampling) {
+		return;
+	}
+
+	/* SIGPROF can land on several threads at once; the ring has
+	 * room for one writer. */
+	if (__atomic_test_and_set(&handler_busy, __ATOMIC_ACQUIRE)) {
+		__atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	uintptr_t pc = context_pc(context);
+	uintptr_t thread = PIOS_Thread_Current_Id();
+
+	/* There are no interrupts here; don't make threads that were not
+	 * started through PiOS look like one. */
+	if (thread == 0) {
+		thread = UINTPTR_MAX;
+	}
+
+	sample_push(pc - (uintptr_t) __executable_start, thread);
+
+	__atomic_clear(&handler_busy, __ATOMIC_RELEASE);
+}
+
+/**
+ * Start sampling.  Samples are taken per unit of CPU time used by the
+ * process, so idle time does not appear in the profile.
+ * @param[in] rate_hz samples per second of CPU time
+ * @returns 0 on success, -1 on failure
+ */
+int32_t PIOS_Profiler_Start(uint16_t rate_hz)
+{
+	if (rate_hz == 0) {
+		return -1;
+	}
+
+	struct sigaction sa = {
+		.sa_sigaction = sigprof_handler,
+		.sa_flags = SA_SIGINFO | SA_RESTART,
+	};
+
+	sigemptyset(&sa.sa_mask);
+
+	if (sigaction(SIGPROF, &sa, NULL)) {
+		return -1;
+	}
+
+	/* tv_usec must stay below a second */
+	uint32_t period_us = 1000000 / rate_hz;
+	struct timeval period = {
+		.tv_sec = period_us / 1000000,
+		.tv_usec = period_us % 1000000,
+	};
+	struct itimerval timer = {
+		.it_interval = period,
+		.it_value = period,
+	};
+
+	sampling = true;
+
+	if (setitimer(ITIMER_PROF, &timer, NULL)) {
+		sampling = false;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Stop sampling.  Samples already taken can still be read.
+ */
+void PIOS_Profiler_Stop(void)
+{
+	struct itimerval timer = { };
+
+	setitimer(ITIMER_PROF, &timer, NULL);
+
+	sampling = false;
+}
+
+#endif /* FLIGHT_POSIX */
+
+/**
+ * Take samples out of the ring.  Must only be called from one thread.
+ * @param[out] samples where to put the samples, oldest first
+ * @param[in] max_samples room in samples
+ * @returns the number of samples read
+ */
+uint16_t PIOS_Profiler_Read(struct pios_profiler_sample *samples,
+		uint16_t max_samples)
+{
+	uint32_t tail = ring_tail;
+	uint32_t avail = ring_head - tail;
+	uint16_t count = (avail < max_samples) ? avail : max_samples;
+
+	/* Don't read slots before the sampler published them */
+	__sync_synchronize();
+
+	for (uint16_t i = 0; i < count; i++) {
+		samples[i] = ring[(tail + i) % PIOS_PROFILER_SAMPLES];
+	}
+
+	/* Don't free slots before they are copied */
+	__sync_synchronize();
+
+	ring_tail = tail + count;
+
+	return count;
+}
+
+/**
+ * @returns the number of samples discarded because the ring was full
+ */
+uint32_t PIOS_Profiler_GetDropped(void)
+{
+	return dropped;
+}
+
+#endif /* PIOS_INCLUDE_PROFILER */
+
+/**
+  * @}
+  * @}
+  */
@@ -39,12 +39,29 @@ struct pios_queue
 	Mailbox mb;
 	MemoryPool mp;
 	void *mpb;
+
+	struct pios_queue *next;
+	uintptr_t creator;
+	uint16_t high_water;
+	uint32_t failures;	/* Senders on other threads run unlocked */
 };
 
+/* All queues, in order of creation */
+static struct pios_queue *queue_list;
+
 #if !defined(PIOS_QUEUE_MAX_WAITERS)
 #define PIOS_QUEUE_MAX_WAITERS 2
 #endif /* !defined(PIOS_QUEUE_MAX_WAITERS) */
 
+/* Must be called with the system locked */
+static void update_high_water(struct pios_queue *queuep)
+{
+	cnt_t depth = chMBGetUsedCountI(&queuep->mb);
+
+	if (depth > queuep->high_water)
+		queuep->high_water = depth;
+}
+
 /**
  *
  * @brief   Creates a queue.
@@ -71,6 +88,20 @@ struct pios_queue *PIOS_Queue_Create(size_t queue_length, size_t item_size)
 	msg_t *mb_buf = PIOS_malloc_no_dma(sizeof(msg_t) * queue_length);
 	chMBInit(&queuep->mb, mb_buf, queue_length);
 
+	queuep->next = NULL;
+	queuep->creator = (uintptr_t) __builtin_return_address(0);
+	queuep->high_water = 0;
+	queuep->failures = 0;
+
+	chSysLock();
+
+	struct pios_queue **tail = &queue_list;
+	while (*tail != NULL)
+		tail = &(*tail)->next;
+	*tail = queuep;
+
+	chSysUnlock();
+
 	return queuep;
 }
 
@@ -83,6 +114,17 @@ struct pios_queue *PIOS_Queue_Create(size_t queue_length, size_t item_size)
  */
 void PIOS_Queue_Delete(struct pios_queue *queuep)
 {
+	chSysLock();
+
+	for (struct pios_queue **link = &queue_list; *link != NULL; link = &(*link)->next) {
+		if (*link == queuep) {
+			*link = queuep->next;
+			break;
+		}
+	}
+
+	chSysUnlock();
+
 	PIOS_free(queuep->mpb);
 	PIOS_free(queuep);
 }
@@ -101,8 +143,10 @@ void PIOS_Queue_Delete(struct pios_queue *queuep)
 bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t timeout_ms)
 {
 	void *buf = chPoolAlloc(&queuep->mp);
-	if (buf == NULL)
+	if (buf == NULL) {
+		__atomic_fetch_add(&queuep->failures, 1, __ATOMIC_RELAXED);
 		return false;
+	}
 
 	memcpy(buf, itemp, queuep->mp.mp_object_size);
 
@@ -119,9 +163,14 @@ bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t time
 	if (result != RDY_OK)
 	{
 		chPoolFree(&queuep->mp, buf);
+		__atomic_fetch_add(&queuep->failures, 1, __ATOMIC_RELAXED);
 		return false;
 	}
 
+	chSysLock();
+	update_high_water(queuep);
+	chSysUnlock();
+
 	return true;
 }
 
@@ -142,6 +191,7 @@ bool PIOS_Queue_Send_FromISR(struct pios_queue *queuep, const void *itemp, bool
 	void *buf = chPoolAllocI(&queuep->mp);
 	if (buf == NULL)
 	{
+		__atomic_fetch_add(&queuep->failures, 1, __ATOMIC_RELAXED);
 		chSysUnlockFromIsr();
 		return false;
 	}
@@ -153,10 +203,13 @@ bool PIOS_Queue_Send_FromISR(struct pios_queue *queuep, const void *itemp, bool
 	if (result != RDY_OK)
 	{
 		chPoolFreeI(&queuep->mp, buf);
+		__atomic_fetch_add(&queuep->failures, 1, __ATOMIC_RELAXED);
 		chSysUnlockFromIsr();
 		return false;
 	}
 
+	update_high_water(queuep);
+
 	chSysUnlockFromIsr();
 
 	return true;
@@ -211,4 +264,45 @@ size_t PIOS_Queue_GetItemSize(struct pios_queue *queuep)
 	return queuep->mp.mp_object_size;
 }
 
+/**
+ *
+ * @brief   Iterates over all queues in order of creation.
+ *
+ * @param[in] queuep       the previous queue, or NULL to get the first one
+ *
+ * @returns the next queue or NULL after the last one
+ *
+ */
+struct pios_queue *PIOS_Queue_Next(struct pios_queue *queuep)
+{
+	if (queuep == NULL)
+		return queue_list;
+
+	return queuep->next;
+}
+
+/**
+ *
+ * @brief   Gets the occupancy statistics of a queue.
+ *
+ * @param[in] queuep       pointer to instance of @p struct pios_queue
+ * @param[out] stats       the statistics
+ *
+ */
+void PIOS_Queue_Get_Stats(struct pios_queue *queuep, struct pios_queue_stats *stats)
+{
+	PIOS_Assert(queuep);
+
+	chSysLock();
+
+	stats->creator = queuep->creator;
+	stats->length = chMBSizeI(&queuep->mb);
+	stats->item_size = queuep->mp.mp_object_size;
+	stats->depth = chMBGetUsedCountI(&queuep->mb);
+	stats->high_water = queuep->high_water;
+	stats->failures = queuep->failures;
+
+	chSysUnlock();
+}
+
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
@@ -118,6 +118,77 @@ int32_t PIOS_RCVR_Read(uintptr_t rcvr_id, uint8_t channel)
   return rcvr_dev->driver->read(rcvr_dev->lower_id, channel);
 }
 
+/**
+ * @brief Copies the latest frame out of a driver's frame buffer
+ * @param[in] buf frame buffer the driver publishes to
+ * @param[out] frame where to put the frame
+ */
+static void PIOS_RCVR_CopyFrame(const struct pios_rcvr_frame_buf *buf,
+		struct pios_rcvr_frame *frame)
+{
+	uint32_t seq;
+
+	/* Retry if a frame was published while we copied */
+	do {
+		seq = __atomic_load_n(&buf->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1) {
+			continue;
+		}
+
+		*frame = buf->frame;
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((seq & 1) || seq != __atomic_load_n(&buf->seq, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Reads all the channels of the latest frame from a receiver
+ * @param[in] rcvr_id driver to read from
+ * @param[in] max_channel highest channel, counting from 1, the caller uses
+ * @param[out] frame channel values, their count and when they were decoded
+ * @returns 0 on success
+ *  @retval PIOS_RCVR_NODRIVER driver was not initialized
+ *
+ * Drivers that don't publish frames are read channel by channel, up to
+ * max_channel, stamped with the current time and a sequence of 0.
+ */
+int32_t PIOS_RCVR_ReadFrame(uintptr_t rcvr_id, uint8_t max_channel,
+		struct pios_rcvr_frame *frame)
+{
+	if (rcvr_id == 0)
+		return PIOS_RCVR_NODRIVER;
+
+	struct pios_rcvr_dev *rcvr_dev = (struct pios_rcvr_dev *)rcvr_id;
+
+	if (!PIOS_RCVR_validate(rcvr_dev)) {
+		/* Undefined RCVR port for this board (see pios_board.c) */
+		PIOS_Assert(0);
+	}
+
+	const struct pios_rcvr_driver *driver = rcvr_dev->driver;
+
+	if (driver->get_frame_buf) {
+		PIOS_RCVR_CopyFrame(driver->get_frame_buf(rcvr_dev->lower_id),
+				frame);
+		return 0;
+	}
+
+	PIOS_DEBUG_Assert(driver->read);
+
+	frame->timestamp = PIOS_DELAY_GetRaw();
+	frame->sequence = 0;
+	if (max_channel > PIOS_RCVR_FRAME_CHANNELS)
+		max_channel = PIOS_RCVR_FRAME_CHANNELS;
+
+	frame->num_channels = max_channel;
+
+	for (int i = 0; i < frame->num_channels; i++) {
+		frame->channels[i] = driver->read(rcvr_dev->lower_id, i);
+	}
+
+	return 0;
+}
+
 #define MIN_WAKE_INTERVAL_uS 4000	/* 250Hz ought to be enough for anyone*/
 
 bool PIOS_RCVR_WaitActivity(uint32_t timeout_ms) {
@@ -162,6 +233,49 @@ void PIOS_RCVR_ActiveFromISR() {
   }
 }
 
+/**
+ * @brief Publishes a decoded frame and wakes whoever waits for activity
+ * @param[in] buf the driver's frame buffer
+ * @param[in] channels channel values, or PIOS_RCVR_TIMEOUT on failsafe
+ * @param[in] num_channels how many channels the frame carries
+ *
+ * Meant for receive interrupts and RTC tick callbacks.  Frames wake the
+ * waiter every time, without the rate limit of PIOS_RCVR_ActiveFromISR.
+ */
+void PIOS_RCVR_PublishFrame(struct pios_rcvr_frame_buf *buf,
+		const uint16_t *channels, uint8_t num_channels)
+{
+	if (num_channels > PIOS_RCVR_FRAME_CHANNELS)
+		num_channels = PIOS_RCVR_FRAME_CHANNELS;
+
+	uint32_t timestamp = PIOS_DELAY_GetRaw();
+
+	/* The receive interrupt and tick callback may both publish */
+	PIOS_IRQ_Disable();
+
+	uint32_t seq = buf->seq;
+
+	__atomic_store_n(&buf->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	buf->frame.timestamp = timestamp;
+	buf->frame.sequence = seq / 2 + 1;
+	buf->frame.num_channels = num_channels;
+	memcpy(buf->frame.channels, channels,
+			num_channels * sizeof(*channels));
+
+	__atomic_store_n(&buf->seq, seq + 2, __ATOMIC_RELEASE);
+
+	PIOS_IRQ_Enable();
+
+	if (rcvr_activity) {
+		bool dont_care;
+
+		rcvr_last_wake = timestamp;
+		PIOS_Semaphore_Give_FromISR(rcvr_activity, &dont_care);
+	}
+}
+
 #endif
 
 /**
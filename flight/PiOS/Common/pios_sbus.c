@@ -36,6 +36,7 @@
 
 /* Forward Declarations */
 static int32_t PIOS_SBus_Get(uintptr_t rcvr_id, uint8_t channel);
+static const struct pios_rcvr_frame_buf *PIOS_SBus_GetFrameBuf(uintptr_t rcvr_id);
 static uint16_t PIOS_SBus_RxInCallback(uintptr_t context,
 				       uint8_t *buf,
 				       uint16_t buf_len,
@@ -47,6 +48,7 @@ static void PIOS_SBus_Supervisor(uintptr_t sbus_id);
 /* Local Variables */
 const struct pios_rcvr_driver pios_sbus_rcvr_driver = {
 	.read = PIOS_SBus_Get,
+	.get_frame_buf = PIOS_SBus_GetFrameBuf,
 };
 
 enum pios_sbus_dev_magic {
@@ -55,6 +57,7 @@ enum pios_sbus_dev_magic {
 
 struct pios_sbus_state {
 	uint16_t channel_data[PIOS_SBUS_NUM_INPUTS];
+	struct pios_rcvr_frame_buf frames;
 	uint8_t received_data[SBUS_FRAME_LENGTH - 2];
 	uint8_t receive_timer;
 	uint8_t failsafe_timer;
@@ -74,6 +77,7 @@ static struct pios_sbus_dev *PIOS_SBus_Alloc(void)
 	sbus_dev = (struct pios_sbus_dev *)PIOS_malloc(sizeof(*sbus_dev));
 	if (!sbus_dev) return(NULL);
 
+	memset(sbus_dev, 0, sizeof(*sbus_dev));
 	sbus_dev->magic = PIOS_SBUS_DEV_MAGIC;
 	return(sbus_dev);
 }
@@ -92,6 +96,13 @@ static void PIOS_SBus_ResetChannels(struct pios_sbus_state *state)
 	}
 }
 
+/* Publish the channels as a complete frame */
+static void PIOS_SBus_PublishChannels(struct pios_sbus_state *state)
+{
+	PIOS_RCVR_PublishFrame(&state->frames, state->channel_data,
+			PIOS_SBUS_NUM_INPUTS);
+}
+
 /* Reset S.Bus receiver state */
 static void PIOS_SBus_ResetState(struct pios_sbus_state *state)
 {
@@ -116,6 +127,7 @@ int32_t PIOS_SBus_Init(uintptr_t *sbus_id,
 	if (!sbus_dev) return -1;
 
 	PIOS_SBus_ResetState(&(sbus_dev->state));
+	PIOS_SBus_PublishChannels(&(sbus_dev->state));
 
 	*sbus_id = (uintptr_t)sbus_dev;
 
@@ -150,6 +162,17 @@ static int32_t PIOS_SBus_Get(uintptr_t rcvr_id, uint8_t channel)
 	return sbus_dev->state.channel_data[channel];
 }
 
+/* Get the frames published from the S.Bus stream */
+static const struct pios_rcvr_frame_buf *PIOS_SBus_GetFrameBuf(uintptr_t rcvr_id)
+{
+	struct pios_sbus_dev *sbus_dev = (struct pios_sbus_dev *)rcvr_id;
+
+	bool valid = PIOS_SBus_Validate(sbus_dev);
+	PIOS_Assert(valid);
+
+	return &sbus_dev->state.frames;
+}
+
 /**
  * Compute channel_data[] from received_data[].
  * For efficiency it unrolls first 8 channels without loops and does the
@@ -213,11 +236,12 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
 			} else if (flags & SBUS_FLAG_FS) {
 				/* failsafe flag active */
 				PIOS_SBus_ResetChannels(state);
+				PIOS_SBus_PublishChannels(state);
 			} else {
 				/* data looking good */
 				PIOS_SBus_UnrollChannels(state);
 				state->failsafe_timer = 0;
-				PIOS_RCVR_ActiveFromISR();
+				PIOS_SBus_PublishChannels(state);
 			}
 		} else {
 			/* discard whole frame */
@@ -290,6 +314,7 @@ static void PIOS_SBus_Supervisor(uintptr_t sbus_id)
 	/* Activate failsafe if no frames have arrived in ~250ms. */
 	if (++state->failsafe_timer > 156) {
 		PIOS_SBus_ResetChannels(state);
+		PIOS_SBus_PublishChannels(state);
 		state->failsafe_timer = 0;
 	}
 }
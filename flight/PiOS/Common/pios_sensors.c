@@ -65,6 +65,16 @@ static bool PIOS_SENSORS_QueueCallback(void *ctx, void *buf,
 	return PIOS_Queue_Receive(q, buf, ms_to_wait);
 }
 
+static bool PIOS_SENSORS_SPSCQueueCallback(void *ctx, void *buf,
+		int ms_to_wait, int *next_call)
+{
+	struct pios_spscqueue *q = ctx;
+
+	*next_call = 0;		/* May immediately have data on next call */
+
+	return PIOS_SPSCQueue_Receive(q, buf, ms_to_wait);
+}
+
 int32_t PIOS_SENSORS_RegisterCallback(enum pios_sensor_type type,
 		PIOS_SENSOR_Callback_t callback, void *ctx)
 {
@@ -85,6 +95,12 @@ int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *que
 			PIOS_SENSORS_QueueCallback, queue);
 }
 
+int32_t PIOS_SENSORS_RegisterSPSCQueue(enum pios_sensor_type type, struct pios_spscqueue *queue)
+{
+	return PIOS_SENSORS_RegisterCallback(type,
+			PIOS_SENSORS_SPSCQueueCallback, queue);
+}
+
 bool PIOS_SENSORS_IsRegistered(enum pios_sensor_type type)
 {
 	if (type >= PIOS_SENSOR_NUM) {
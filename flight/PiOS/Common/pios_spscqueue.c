@@ -0,0 +1,370 @@
+/**
+ ******************************************************************************
+ * @file       pios_spscqueue.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SPSCQueue Single producer / single consumer queue
+ * @{
+ * @brief Lock-free queue for exactly one sending and one receiving context
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "pios.h"
+#include "pios_semaphore.h"
+#include "pios_spscqueue.h"
+#include "pios_thread.h"
+
+#include <circqueue.h>
+
+/* Full barrier: orders the "I am waiting" flag against the emptiness /
+ * fullness re-check.
+ */
+#define SPSC_BARRIER() __sync_synchronize()
+
+/* Order the payload copy against the index update.  Only the other side's
+ * index has to be seen before the copy, and the copy before our own index
+ * moves, so these needn't be full barriers.
+ */
+#define SPSC_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define SPSC_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+
+struct pios_spscqueue {
+#define SPSCQUEUE_MAGIC 0x63737053	/* 'Spsc' */
+	uint32_t magic;
+
+	uint16_t item_size;
+
+	circ_queue_t queue;
+
+	/* Signalled by the producer when the consumer is blocked */
+	struct pios_semaphore *rx_sema;
+	/* Signalled by the consumer when the producer is blocked */
+	struct pios_semaphore *tx_sema;
+
+	volatile bool rx_waiting;
+	volatile bool tx_waiting;
+};
+
+/**
+ * @brief Creates a single producer / single consumer queue.
+ *
+ * @param[in] queue_length  number of items the queue can hold
+ * @param[in] item_size     size of each item in bytes
+ *
+ * @returns the new queue or NULL on failure
+ */
+struct pios_spscqueue *PIOS_SPSCQueue_Create(uint16_t queue_length, uint16_t item_size)
+{
+	struct pios_spscqueue *q = PIOS_malloc_no_dma(sizeof(*q));
+
+	if (!q) {
+		return NULL;
+	}
+
+	memset(q, 0, sizeof(*q));
+
+	q->item_size = item_size;
+
+	q->queue = circ_queue_new(item_size, queue_length + 1);
+	if (!q->queue) goto out_free_q;
+
+	q->rx_sema = PIOS_Semaphore_Create();
+	if (!q->rx_sema) goto out_free_queue;
+
+	q->tx_sema = PIOS_Semaphore_Create();
+	if (!q->tx_sema) goto out_free_rx_sema;
+
+	/* Binary semaphores are created in the given state. */
+	PIOS_Semaphore_Take(q->rx_sema, 0);
+	PIOS_Semaphore_Take(q->tx_sema, 0);
+
+	q->magic = SPSCQUEUE_MAGIC;
+
+	return q;
+
+out_free_rx_sema:
+	PIOS_Semaphore_Delete(q->rx_sema);
+out_free_queue:
+	circ_queue_delete(q->queue);
+out_free_q:
+	PIOS_free(q);
+	return NULL;
+}
+
+/* Copies as many items as fit into the ring; producer side only. */
+static uint16_t spsc_write(struct pios_spscqueue *q, const uint8_t *items,
+		uint16_t num)
+{
+	uint16_t total = 0;
+
+	while (total < num) {
+		uint16_t contig;
+		void *pos = circ_queue_write_pos(q->queue, &contig, NULL);
+
+		if (!contig) {
+			break;
+		}
+
+		if (contig > num - total) {
+			contig = num - total;
+		}
+
+		memcpy(pos, items + total * q->item_size,
+				contig * q->item_size);
+
+		SPSC_RELEASE();
+
+		circ_queue_advance_write_multi(q->queue, contig);
+
+		total += contig;
+	}
+
+	return total;
+}
+
+/* Copies as many items as are available out of the ring; consumer only. */
+static uint16_t spsc_read(struct pios_spscqueue *q, uint8_t *items,
+		uint16_t num)
+{
+	uint16_t total = 0;
+
+	while (total < num) {
+		uint16_t contig;
+		void *pos = circ_queue_read_pos(q->queue, &contig, NULL);
+
+		if (!pos) {
+			break;
+		}
+
+		if (contig > num - total) {
+			contig = num - total;
+		}
+
+		SPSC_ACQUIRE();
+
+		memcpy(items + total * q->item_size, pos,
+				contig * q->item_size);
+
+		SPSC_RELEASE();
+
+		circ_queue_read_completed_multi(q->queue, contig);
+
+		total += contig;
+	}
+
+	return total;
+}
+
+/* Wakes the other side if it announced that it is blocked. */
+static void spsc_notify(struct pios_semaphore *sema, volatile bool *waiting)
+{
+	SPSC_BARRIER();
+
+	if (*waiting) {
+		*waiting = false;
+		PIOS_Semaphore_Give(sema);
+	}
+}
+
+/**
+ * Moves up to num items in or out of the queue, blocking until at least
+ * one item could be moved or the timeout expires.
+ */
+static uint16_t spsc_transfer(struct pios_spscqueue *q, void *items,
+		uint16_t num, uint32_t timeout_ms, bool send)
+{
+	PIOS_Assert(q->magic == SPSCQUEUE_MAGIC);
+
+	struct pios_semaphore *own_sema = send ? q->tx_sema : q->rx_sema;
+	struct pios_semaphore *peer_sema = send ? q->rx_sema : q->tx_sema;
+	volatile bool *own_waiting = send ? &q->tx_waiting : &q->rx_waiting;
+	volatile bool *peer_waiting = send ? &q->rx_waiting : &q->tx_waiting;
+
+	uint16_t done = send ? spsc_write(q, items, num) :
+		spsc_read(q, items, num);
+
+	if (done) {
+		spsc_notify(peer_sema, peer_waiting);
+		return done;
+	}
+
+	if (timeout_ms == 0) {
+		return 0;
+	}
+
+	/* Only read the clock once it's clear we have to wait; on posix it
+	 * costs more than the whole transfer */
+	uint32_t start = PIOS_Thread_Systime();
+
+	while (true) {
+		uint32_t wait_ms = timeout_ms;
+
+		if (timeout_ms != PIOS_SPSCQUEUE_TIMEOUT_MAX) {
+			uint32_t elapsed = PIOS_Thread_Systime() - start;
+
+			if (elapsed >= timeout_ms) {
+				return 0;
+			}
+
+			wait_ms = timeout_ms - elapsed;
+		}
+
+#ifdef FLIGHT_POSIX
+		/* Semaphores wait in real time; poll the fake clock instead */
+		if (PIOS_Thread_FakeClock_IsActive()) {
+			wait_ms = 1;
+		}
+#endif
+
+		/* Announce we are about to block, then re-check so that a
+		 * transfer by the other side in between is not missed.
+		 */
+		*own_waiting = true;
+
+		SPSC_BARRIER();
+
+		done = send ? spsc_write(q, items, num) :
+			spsc_read(q, items, num);
+
+		if (done) {
+			*own_waiting = false;
+			spsc_notify(peer_sema, peer_waiting);
+			return done;
+		}
+
+		PIOS_Semaphore_Take(own_sema, wait_ms);
+
+		*own_waiting = false;
+
+		done = send ? spsc_write(q, items, num) :
+			spsc_read(q, items, num);
+
+		if (done) {
+			spsc_notify(peer_sema, peer_waiting);
+			return done;
+		}
+	}
+}
+
+/**
+ * @brief Appends an item to the queue.
+ *
+ * @param[in] q            the queue
+ * @param[in] itemp        item to append
+ * @param[in] timeout_ms   how long to wait for room
+ *
+ * @returns true on success or false on timeout
+ */
+bool PIOS_SPSCQueue_Send(struct pios_spscqueue *q, const void *itemp, uint32_t timeout_ms)
+{
+	return spsc_transfer(q, (void *) itemp, 1, timeout_ms, true) == 1;
+}
+
+/**
+ * @brief Appends several items to the queue at once.
+ *
+ * Waits up to timeout_ms for room for at least one item, then appends as
+ * many as currently fit.
+ *
+ * @param[in] q            the queue
+ * @param[in] itemsp       array of num items
+ * @param[in] num          number of items to append
+ * @param[in] timeout_ms   how long to wait for room
+ *
+ * @returns the number of items appended
+ */
+uint16_t PIOS_SPSCQueue_SendMulti(struct pios_spscqueue *q, const void *itemsp, uint16_t num, uint32_t timeout_ms)
+{
+	return spsc_transfer(q, (void *) itemsp, num, timeout_ms, true);
+}
+
+/**
+ * @brief Appends an item to the queue from ISR context.  Never blocks.
+ *
+ * @param[in] q            the queue
+ * @param[in] itemp        item to append
+ * @param[out] wokenp      set true if a higher priority task was woken
+ *
+ * @returns true on success or false if the queue is full
+ */
+bool PIOS_SPSCQueue_Send_FromISR(struct pios_spscqueue *q, const void *itemp, bool *wokenp)
+{
+	PIOS_Assert(q->magic == SPSCQUEUE_MAGIC);
+
+	if (!spsc_write(q, itemp, 1)) {
+		return false;
+	}
+
+	SPSC_BARRIER();
+
+	if (q->rx_waiting) {
+		q->rx_waiting = false;
+		PIOS_Semaphore_Give_FromISR(q->rx_sema, wokenp);
+	}
+
+	return true;
+}
+
+/**
+ * @brief Retrieves the item at the front of the queue.
+ *
+ * @param[in] q            the queue
+ * @param[out] itemp       where to store the item
+ * @param[in] timeout_ms   how long to wait for an item
+ *
+ * @returns true on success or false on timeout
+ */
+bool PIOS_SPSCQueue_Receive(struct pios_spscqueue *q, void *itemp, uint32_t timeout_ms)
+{
+	return spsc_transfer(q, itemp, 1, timeout_ms, false) == 1;
+}
+
+/**
+ * @brief Retrieves several items from the front of the queue at once.
+ *
+ * Waits up to timeout_ms for at least one item, then returns as many as
+ * are available, up to num.
+ *
+ * @param[in] q            the queue
+ * @param[out] itemsp      room for num items
+ * @param[in] num          maximum number of items to retrieve
+ * @param[in] timeout_ms   how long to wait for an item
+ *
+ * @returns the number of items retrieved
+ */
+uint16_t PIOS_SPSCQueue_ReceiveMulti(struct pios_spscqueue *q, void *itemsp, uint16_t num, uint32_t timeout_ms)
+{
+	return spsc_transfer(q, itemsp, num, timeout_ms, false);
+}
+
+/**
+ * @brief Gets the item size of a queue.
+ *
+ * @param[in] q the queue
+ *
+ * @returns Size of item
+ */
+uint16_t PIOS_SPSCQueue_GetItemSize(struct pios_spscqueue *q)
+{
+	PIOS_Assert(q);
+	return q->item_size;
+}
+
+/**
+  * @}
+  * @}
+  */
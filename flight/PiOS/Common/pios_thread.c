@@ -34,6 +34,7 @@
 struct pios_thread
 {
 	Thread *threadp;
+	uint8_t *stack;		/* As allocated, for freeing */
 };
 
 DONT_BUILD_IF(CH_FREQUENCY != 1000, ChFreqMs);
@@ -59,15 +60,17 @@ static uint32_t ceil_size(uint32_t size)
  * ChibiOS stack expects alignment (both start and end)
  * to 8 byte boundaries. This makes sure to allocate enough
  * memory and return an address that has the requested size
- * or more with these constraints.
+ * or more with these constraints.  The allocation itself is returned
+ * through base, as that is what has to be freed.
  */
-static uint8_t * align8_alloc(uint32_t size)
+static uint8_t * align8_alloc(uint32_t size, uint8_t **base)
 {
 	// round size up to at nearest multiple of 8 + 4 bytes to guarantee
 	// sufficient size within. This is because PIOS_malloc only guarantees
 	// uintptr_t alignment which is 4 bytes.
 	size = size + sizeof(uintptr_t);
 	uint8_t *wap = PIOS_malloc(size);
+	*base = wap;
 
 	// shift start point to nearest 8 byte boundary.
 	uint32_t pad = ((uint32_t) wap) % sizeof(stkalign_t);
@@ -89,6 +92,7 @@ struct pios_thread *PIOS_Thread_WrapCurrentThread(const char *namep)
 
 	if (thread) {
 		thread->threadp = chThdSelf();
+		thread->stack = NULL;
 #if CH_USE_REGISTRY
 		thread->threadp->p_name = namep;
 #endif /* CH_USE_REGISTRY */
@@ -128,7 +132,7 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 
 	// Use special functions to ensure ChibiOS stack requirements
 	stack_bytes = ceil_size(stack_bytes);
-	uint8_t *wap = align8_alloc(stack_bytes);
+	uint8_t *wap = align8_alloc(stack_bytes, &thread->stack);
 	if (wap == NULL)
 	{
 		PIOS_free(thread);
@@ -138,8 +142,8 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 	thread->threadp = chThdCreateStatic(wap, stack_bytes, prio, (msg_t (*)(void *))fp, argp);
 	if (thread->threadp == NULL)
 	{
+		PIOS_free(thread->stack);
 		PIOS_free(thread);
-		PIOS_free(wap);
 		return NULL;
 	}
 
@@ -155,6 +159,8 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
  *
  * @brief   Destroys an instance of @p struct pios_thread.
  *
+ * Waits for the thread to exit, then frees its stack and handle.
+ *
  * @param[in] threadp      pointer to instance of @p struct pios_thread
  *
  */
@@ -168,6 +174,9 @@ void PIOS_Thread_Delete(struct pios_thread *threadp)
 	{
 		chThdTerminate(threadp->threadp);
 		chThdWait(threadp->threadp);
+
+		PIOS_free(threadp->stack);
+		PIOS_free(threadp);
 	}
 }
 #else
@@ -296,6 +305,69 @@ uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 	return result;
 }
 
+/**
+ *
+ * @brief   Returns the scheduling statistics of a thread and starts a new
+ *          accumulation interval.  Shares the runtime accumulator with
+ *          @p PIOS_Thread_Get_Runtime, so only one of the two should be used.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ * @param[out] stats       statistics since the previous call
+ *
+ * @returns true on success or false if not supported
+ *
+ */
+bool PIOS_Thread_Get_Stats(struct pios_thread *threadp, struct pios_thread_stats *stats)
+{
+	chSysLock();
+
+	Thread *tp = threadp->threadp;
+
+	uint32_t total = tp->ticks_total;
+	uint32_t blocked_max = tp->ticks_blocked_max;
+
+	stats->wakeups = tp->wakeups;
+
+	tp->ticks_total = 0;
+	tp->ticks_blocked_max = 0;
+	tp->wakeups = 0;
+
+	chSysUnlock();
+
+	/* The thread ticks are core cycles, the same as the delay timer */
+	stats->runtime_us = PIOS_DELAY_DiffuS2(0, total);
+	stats->max_blocked_us = PIOS_DELAY_DiffuS2(0, blocked_max);
+
+	return true;
+}
+
+/**
+ *
+ * @brief   Returns a number that identifies a thread.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ *
+ * @returns the same value @p PIOS_Thread_Current_Id returns in that thread
+ *
+ */
+uintptr_t PIOS_Thread_Get_Id(struct pios_thread *threadp)
+{
+	return (uintptr_t) threadp->threadp;
+}
+
+/**
+ *
+ * @brief   Identifies the running thread.  Can be used from interrupt
+ *          handlers, where it gives the interrupted thread.
+ *
+ * @returns the thread identifier
+ *
+ */
+uintptr_t PIOS_Thread_Current_Id(void)
+{
+	return (uintptr_t) chThdSelf();
+}
+
 /**
  *
  * @brief   Suspends execution of all threads.
@@ -0,0 +1,551 @@
+/**
+ ******************************************************************************
+ * @file       pios_tlsf.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_TLSF Two-level segregated fit allocator
+ * @{
+ * @brief Constant time allocator behind the PiOS heaps
+ *
+ * After M. Masmano et al., "TLSF: a New Dynamic Memory Allocator for
+ * Real-Time Systems".
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "pios_tlsf.h"
+
+#include <string.h>
+
+/* Each power of two size range is split into 2^SL_INDEX_COUNT_LOG2 lists */
+#define SL_INDEX_COUNT_LOG2	3
+#define SL_INDEX_COUNT		(1 << SL_INDEX_COUNT_LOG2)
+
+/* Blocks and allocations are aligned to a machine word */
+#if UINTPTR_MAX > 0xffffffff
+#define ALIGN_SIZE_LOG2		3
+#else
+#define ALIGN_SIZE_LOG2		2
+#endif
+#define ALIGN_SIZE		(1 << ALIGN_SIZE_LOG2)
+
+/*
+ * Blocks are kept under 2^FL_INDEX_MAX bytes; bigger pools are added as
+ * several.  Sizes under SMALL_BLOCK_SIZE share the first range.
+ */
+#define FL_INDEX_MAX		18
+#define FL_INDEX_SHIFT		(SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define FL_INDEX_COUNT		(FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE	(1 << FL_INDEX_SHIFT)
+
+/*
+ * A block is a size word followed by the memory handed out.  The pointer to
+ * the previous block sits at the end of that block's memory, and is only
+ * kept while it is free; so is the free list linkage, which takes up the
+ * block's own memory.  A block in use costs one word.
+ */
+struct tlsf_block {
+	struct tlsf_block *prev_phys;
+	size_t size;
+	struct tlsf_block *next_free;
+	struct tlsf_block *prev_free;
+};
+
+/* The size is a multiple of the alignment, which leaves room for flags */
+#define BLOCK_FREE		((size_t) 1)
+#define BLOCK_PREV_FREE		((size_t) 2)
+
+#define BLOCK_OVERHEAD		sizeof(size_t)
+#define BLOCK_START_OFFSET	(offsetof(struct tlsf_block, size) + sizeof(size_t))
+#define BLOCK_SIZE_MIN		(sizeof(struct tlsf_block) - sizeof(struct tlsf_block *))
+#define BLOCK_SIZE_MAX		(((size_t) 1 << FL_INDEX_MAX) - ALIGN_SIZE)
+
+/* A pool is a free block plus the empty block that ends it */
+#define POOL_OVERHEAD		(2 * BLOCK_OVERHEAD)
+
+struct pios_tlsf {
+	/* Empty lists point here rather than at NULL */
+	struct tlsf_block null_block;
+
+	uint32_t fl_bitmap;
+	uint8_t sl_bitmap[FL_INDEX_COUNT];
+	struct tlsf_block *blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+	size_t total_bytes;
+	size_t used_bytes;
+	size_t max_used_bytes;
+	uint32_t allocations;
+	uint32_t failures;
+};
+
+/* Index of the most significant bit set; x must not be 0 */
+static inline int tlsf_fls(size_t x)
+{
+	return (int) (sizeof(unsigned long) * 8) - 1 - __builtin_clzl(x);
+}
+
+/* Index of the least significant bit set; x must not be 0 */
+static inline int tlsf_ffs(uint32_t x)
+{
+	return __builtin_ctz(x);
+}
+
+static inline size_t align_up(size_t x)
+{
+	return (x + (ALIGN_SIZE - 1)) & ~((size_t) ALIGN_SIZE - 1);
+}
+
+static inline size_t block_size(const struct tlsf_block *block)
+{
+	return block->size & ~(BLOCK_FREE | BLOCK_PREV_FREE);
+}
+
+static inline void *block_to_ptr(struct tlsf_block *block)
+{
+	return (char *) block + BLOCK_START_OFFSET;
+}
+
+static inline struct tlsf_block *block_from_ptr(void *ptr)
+{
+	return (struct tlsf_block *) ((char *) ptr - BLOCK_START_OFFSET);
+}
+
+static inline struct tlsf_block *block_next(struct tlsf_block *block)
+{
+	return (struct tlsf_block *) ((char *) block_to_ptr(block) +
+			block_size(block) - BLOCK_OVERHEAD);
+}
+
+/* Get the next block, and point it back at this one */
+static inline struct tlsf_block *block_link_next(struct tlsf_block *block)
+{
+	struct tlsf_block *next = block_next(block);
+
+	next->prev_phys = block;
+
+	return next;
+}
+
+static inline void block_mark_free(struct tlsf_block *block)
+{
+	struct tlsf_block *next = block_link_next(block);
+
+	next->size |= BLOCK_PREV_FREE;
+	block->size |= BLOCK_FREE;
+}
+
+static inline void block_mark_used(struct tlsf_block *block)
+{
+	struct tlsf_block *next = block_next(block);
+
+	next->size &= ~BLOCK_PREV_FREE;
+	block->size &= ~BLOCK_FREE;
+}
+
+/* The list a free block of this size belongs on */
+static inline void mapping_insert(size_t size, int *fl, int *sl)
+{
+	if (size < SMALL_BLOCK_SIZE) {
+		*fl = 0;
+		*sl = size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+	} else {
+		int bit = tlsf_fls(size);
+
+		*sl = (size >> (bit - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+		*fl = bit - (FL_INDEX_SHIFT - 1);
+	}
+}
+
+/* The first list whose blocks are all big enough for this size */
+static inline void mapping_search(size_t size, int *fl, int *sl)
+{
+	if (size >= SMALL_BLOCK_SIZE) {
+		size += ((size_t) 1 << (tlsf_fls(size) - SL_INDEX_COUNT_LOG2)) - 1;
+	}
+
+	mapping_insert(size, fl, sl);
+}
+
+static struct tlsf_block *search_suitable_block(struct pios_tlsf *tlsf,
+		int *fl, int *sl)
+{
+	uint32_t sl_map = tlsf->sl_bitmap[*fl] & (~0U << *sl);
+
+	if (!sl_map) {
+		uint32_t fl_map = tlsf->fl_bitmap & (~0U << (*fl + 1));
+
+		if (!fl_map) {
+			return NULL;
+		}
+
+		*fl = tlsf_ffs(fl_map);
+		sl_map = tlsf->sl_bitmap[*fl];
+	}
+
+	*sl = tlsf_ffs(sl_map);
+
+	return tlsf->blocks[*fl][*sl];
+}
+
+static void remove_free_block(struct pios_tlsf *tlsf, struct tlsf_block *block,
+		int fl, int sl)
+{
+	struct tlsf_block *prev = block->prev_free;
+	struct tlsf_block *next = block->next_free;
+
+	next->prev_free = prev;
+	prev->next_free = next;
+
+	if (tlsf->blocks[fl][sl] == block) {
+		tlsf->blocks[fl][sl] = next;
+
+		if (next == &tlsf->null_block) {
+			tlsf->sl_bitmap[fl] &= ~(1U << sl);
+
+			if (!tlsf->sl_bitmap[fl]) {
+				tlsf->fl_bitmap &= ~(1U << fl);
+			}
+		}
+	}
+}
+
+static void insert_free_block(struct pios_tlsf *tlsf, struct tlsf_block *block,
+		int fl, int sl)
+{
+	struct tlsf_block *current = tlsf->blocks[fl][sl];
+
+	block->next_free = current;
+	block->prev_free = &tlsf->null_block;
+	current->prev_free = block;
+
+	tlsf->blocks[fl][sl] = block;
+	tlsf->fl_bitmap |= 1U << fl;
+	tlsf->sl_bitmap[fl] |= 1U << sl;
+}
+
+static void block_remove(struct pios_tlsf *tlsf, struct tlsf_block *block)
+{
+	int fl, sl;
+
+	mapping_insert(block_size(block), &fl, &sl);
+	remove_free_block(tlsf, block, fl, sl);
+}
+
+static void block_insert(struct pios_tlsf *tlsf, struct tlsf_block *block)
+{
+	int fl, sl;
+
+	mapping_insert(block_size(block), &fl, &sl);
+	insert_free_block(tlsf, block, fl, sl);
+}
+
+/* Absorb a free previous neighbour */
+static struct tlsf_block *block_merge_prev(struct pios_tlsf *tlsf,
+		struct tlsf_block *block)
+{
+	if (block->size & BLOCK_PREV_FREE) {
+		struct tlsf_block *prev = block->prev_phys;
+
+		block_remove(tlsf, prev);
+		prev->size += block_size(block) + BLOCK_OVERHEAD;
+		block_link_next(prev);
+		block = prev;
+	}
+
+	return block;
+}
+
+/* Absorb a free next neighbour */
+static void block_merge_next(struct pios_tlsf *tlsf, struct tlsf_block *block)
+{
+	struct tlsf_block *next = block_next(block);
+
+	if (next->size & BLOCK_FREE) {
+		block_remove(tlsf, next);
+		block->size += block_size(next) + BLOCK_OVERHEAD;
+		block_link_next(block);
+	}
+}
+
+/* Give back whatever a free block has beyond size */
+static void block_trim(struct pios_tlsf *tlsf, struct tlsf_block *block,
+		size_t size)
+{
+	if (block_size(block) < size + sizeof(struct tlsf_block)) {
+		return;
+	}
+
+	struct tlsf_block *remaining = (struct tlsf_block *)
+		((char *) block_to_ptr(block) + size - BLOCK_OVERHEAD);
+
+	remaining->size = block_size(block) - size - BLOCK_OVERHEAD;
+	block->size = size | (block->size & (BLOCK_FREE | BLOCK_PREV_FREE));
+
+	block_link_next(block);
+	block_mark_free(remaining);
+	remaining->size |= BLOCK_PREV_FREE;
+	block_insert(tlsf, remaining);
+}
+
+/**
+ * @brief Create an allocator, keeping its state at the start of the memory
+ * and giving it the rest
+ * @param[in] mem The memory
+ * @param[in] bytes Size of the memory
+ * @returns The allocator, or NULL if the memory is too small
+ */
+struct pios_tlsf *PIOS_TLSF_Create(void *mem, size_t bytes)
+{
+	uintptr_t start = align_up((uintptr_t) mem);
+	size_t control = align_up(sizeof(struct pios_tlsf));
+
+	if (bytes < (start - (uintptr_t) mem) + control) {
+		return NULL;
+	}
+
+	bytes -= (start - (uintptr_t) mem) + control;
+
+	struct pios_tlsf *tlsf = (struct pios_tlsf *) start;
+
+	memset(tlsf, 0, sizeof(*tlsf));
+
+	tlsf->null_block.next_free = &tlsf->null_block;
+	tlsf->null_block.prev_free = &tlsf->null_block;
+
+	for (int fl = 0; fl < FL_INDEX_COUNT; fl++) {
+		for (int sl = 0; sl < SL_INDEX_COUNT; sl++) {
+			tlsf->blocks[fl][sl] = &tlsf->null_block;
+		}
+	}
+
+	if (!PIOS_TLSF_AddPool(tlsf, (char *) tlsf + control, bytes)) {
+		return NULL;
+	}
+
+	return tlsf;
+}
+
+/**
+ * @brief Give an allocator more memory
+ * @param[in] tlsf The allocator
+ * @param[in] mem The memory, which needn't be next to its other pools
+ * @param[in] bytes Size of the memory
+ * @returns True if any of it could be used
+ */
+bool PIOS_TLSF_AddPool(struct pios_tlsf *tlsf, void *mem, size_t bytes)
+{
+	uintptr_t start = align_up((uintptr_t) mem);
+
+	if (bytes < start - (uintptr_t) mem) {
+		return false;
+	}
+
+	bytes = (bytes - (start - (uintptr_t) mem)) & ~((size_t) ALIGN_SIZE - 1);
+
+	bool added = false;
+
+	while (bytes >= POOL_OVERHEAD + BLOCK_SIZE_MIN) {
+		size_t size = bytes - POOL_OVERHEAD;
+
+		if (size > BLOCK_SIZE_MAX) {
+			size = BLOCK_SIZE_MAX;
+		}
+
+		/* The first block's size is the pool's first word; it never
+		 * has a free block before it, so nothing touches the
+		 * previous block pointer which would sit before the pool */
+		struct tlsf_block *block = (struct tlsf_block *)
+			(start - offsetof(struct tlsf_block, size));
+
+		block->size = size;
+		block_mark_free(block);
+		block_insert(tlsf, block);
+
+		/* An empty block in use, so nothing merges past the end */
+		struct tlsf_block *end = block_next(block);
+		end->size = BLOCK_PREV_FREE;
+
+		tlsf->total_bytes += size + BLOCK_OVERHEAD;
+
+		start += size + POOL_OVERHEAD;
+		bytes -= size + POOL_OVERHEAD;
+		added = true;
+	}
+
+	return added;
+}
+
+/**
+ * @brief Allocate memory, in constant time
+ * @param[in] tlsf The allocator
+ * @param[in] size Bytes wanted
+ * @returns The memory, aligned to a machine word, or NULL
+ */
+void *PIOS_TLSF_Malloc(struct pios_tlsf *tlsf, size_t size)
+{
+	if (size > BLOCK_SIZE_MAX) {
+		tlsf->failures++;
+		return NULL;
+	}
+
+	size = align_up(size);
+	if (size < BLOCK_SIZE_MIN) {
+		size = BLOCK_SIZE_MIN;
+	}
+
+	int fl, sl;
+	mapping_search(size, &fl, &sl);
+
+	struct tlsf_block *block = NULL;
+
+	if (fl < FL_INDEX_COUNT) {
+		block = search_suitable_block(tlsf, &fl, &sl);
+	}
+
+	if (!block) {
+		tlsf->failures++;
+		return NULL;
+	}
+
+	remove_free_block(tlsf, block, fl, sl);
+	block_trim(tlsf, block, size);
+	block_mark_used(block);
+
+	tlsf->used_bytes += block_size(block) + BLOCK_OVERHEAD;
+	if (tlsf->used_bytes > tlsf->max_used_bytes) {
+		tlsf->max_used_bytes = tlsf->used_bytes;
+	}
+	tlsf->allocations++;
+
+	return block_to_ptr(block);
+}
+
+/**
+ * @brief Free memory, in constant time
+ * @param[in] tlsf The allocator
+ * @param[in] ptr Memory from PIOS_TLSF_Malloc on this allocator, or NULL
+ */
+void PIOS_TLSF_Free(struct pios_tlsf *tlsf, void *ptr)
+{
+	if (!ptr) {
+		return;
+	}
+
+	struct tlsf_block *block = block_from_ptr(ptr);
+
+	if (block->size & BLOCK_FREE) {
+		/* Already free */
+		return;
+	}
+
+	tlsf->used_bytes -= block_size(block) + BLOCK_OVERHEAD;
+	tlsf->allocations--;
+
+	block_mark_free(block);
+	block = block_merge_prev(tlsf, block);
+	block_merge_next(tlsf, block);
+	block_insert(tlsf, block);
+}
+
+/**
+ * @brief Get the number of bytes not in use, including the headers of the
+ * free blocks
+ */
+size_t PIOS_TLSF_GetFreeSize(struct pios_tlsf *tlsf)
+{
+	return tlsf->total_bytes - tlsf->used_bytes;
+}
+
+/**
+ * @brief Get the state of the heap.  The largest free block is found by
+ * walking one free list, so this isn't constant time.
+ * @param[in] tlsf The allocator
+ * @param[out] stats The state
+ */
+void PIOS_TLSF_GetStats(struct pios_tlsf *tlsf, struct pios_tlsf_stats *stats)
+{
+	stats->total_bytes = tlsf->total_bytes;
+	stats->free_bytes = tlsf->total_bytes - tlsf->used_bytes;
+	stats->min_free_bytes = tlsf->total_bytes - tlsf->max_used_bytes;
+	stats->allocations = tlsf->allocations;
+	stats->failures = tlsf->failures;
+	stats->largest_free = 0;
+
+	if (tlsf->fl_bitmap) {
+		int fl = tlsf_fls(tlsf->fl_bitmap);
+		int sl = tlsf_fls(tlsf->sl_bitmap[fl]);
+
+		for (struct tlsf_block *block = tlsf->blocks[fl][sl];
+				block != &tlsf->null_block;
+				block = block->next_free) {
+			if (block_size(block) > stats->largest_free) {
+				stats->largest_free = block_size(block);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Check the free lists are consistent: every block on them is free,
+ * on the right list, fully merged and accounted for.  For tests.
+ * @returns True if all is well
+ */
+bool PIOS_TLSF_Check(struct pios_tlsf *tlsf)
+{
+	size_t free_bytes = 0;
+
+	for (int fl = 0; fl < FL_INDEX_COUNT; fl++) {
+		bool fl_set = tlsf->fl_bitmap & (1U << fl);
+
+		if (fl_set != (tlsf->sl_bitmap[fl] != 0)) {
+			return false;
+		}
+
+		for (int sl = 0; sl < SL_INDEX_COUNT; sl++) {
+			struct tlsf_block *block = tlsf->blocks[fl][sl];
+			bool sl_set = tlsf->sl_bitmap[fl] & (1U << sl);
+
+			if (sl_set != (block != &tlsf->null_block)) {
+				return false;
+			}
+
+			for (; block != &tlsf->null_block; block = block->next_free) {
+				struct tlsf_block *next = block_next(block);
+				int block_fl, block_sl;
+
+				mapping_insert(block_size(block), &block_fl, &block_sl);
+
+				if (!(block->size & BLOCK_FREE) ||
+						(block->size & BLOCK_PREV_FREE) ||
+						(next->size & BLOCK_FREE) ||
+						!(next->size & BLOCK_PREV_FREE) ||
+						next->prev_phys != block ||
+						block_fl != fl || block_sl != sl) {
+					return false;
+				}
+
+				free_bytes += block_size(block) + BLOCK_OVERHEAD;
+			}
+		}
+	}
+
+	return free_bytes == tlsf->total_bytes - tlsf->used_bytes;
+}
+
+/**
+  * @}
+  * @}
+  */
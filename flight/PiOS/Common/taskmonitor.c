@@ -27,20 +27,50 @@
 #include "openpilot.h"
 #include "taskmonitor.h"
 #include "pios_mutex.h"
+#include "pios_queue.h"
+
+#if defined(DIAG_TASKS)
+#include "threadstats.h"
+#include "queuestats.h"
+#endif
 
 // Private constants
 
+/* Number of updates CPUAverage is taken over */
+#define TASKMONITOR_WINDOWS 8
+
+/* ThreadStats Task of an instance whose task has stopped */
+#define THREADSTATS_NO_TASK 0xff
+
+/* Most ThreadStats and QueueStats instances to create.  On an F3 an
+ * instance takes 28 or 24 bytes of heap, so together they stay under
+ * 1 KiB; tasks and queues past the limit aren't published. */
+#define TASKMONITOR_MAX_THREADSTATS 16
+#define TASKMONITOR_MAX_QUEUESTATS 16
+
 // Private types
 
+/* Runtime of one task in each of the last few update intervals */
+struct task_history {
+	uint32_t runtime_us[TASKMONITOR_WINDOWS];
+};
+
 // Private variables
 static struct pios_mutex *lock;
 static struct pios_thread *handles[TASKINFO_RUNNING_NUMELEM];
 static uint32_t lastMonitorTime;
 
+#if defined(DIAG_TASKS)
+static struct task_history *history[TASKINFO_RUNNING_NUMELEM];
+static uint32_t window_us[TASKMONITOR_WINDOWS];
+static uint8_t window_idx;
+#endif
+
 DONT_BUILD_IF(TASKINFO_RUNNING_NUMELEM != TASKINFO_STACKREMAINING_NUMELEM,
 		taskelems1);
 DONT_BUILD_IF(TASKINFO_RUNNING_NUMELEM != TASKINFO_RUNNINGTIME_NUMELEM,
 		taskelems2);
+DONT_BUILD_IF(TASKINFO_RUNNING_NUMELEM > THREADSTATS_NO_TASK, taskelems3);
 
 // Private functions
 
@@ -54,9 +84,7 @@ int32_t TaskMonitorInitialize(void)
 	memset(handles, 0, sizeof(struct pios_thread *) * TASKINFO_RUNNING_NUMELEM);
 	lastMonitorTime = 0;
 #if defined(DIAG_TASKS)
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	lastMonitorTime = halGetCounterValue();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	lastMonitorTime = PIOS_DELAY_GetRaw();
 #endif
 	return 0;
 }
@@ -73,6 +101,14 @@ int32_t TaskMonitorAdd(TaskInfoRunningElem task, struct pios_thread *threadp)
 	if (task_idx < TASKINFO_RUNNING_NUMELEM) {
 		PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
 		handles[task_idx] = threadp;
+#if defined(DIAG_TASKS)
+		/* Kept if the task is removed, for when it comes back */
+		if (history[task_idx] == NULL)
+			history[task_idx] = PIOS_malloc_no_dma(sizeof(struct task_history));
+
+		if (history[task_idx] != NULL)
+			memset(history[task_idx], 0, sizeof(struct task_history));
+#endif
 		PIOS_Mutex_Unlock(lock);
 		return 0;
 	} else {
@@ -110,6 +146,111 @@ bool TaskMonitorQueryRunning(TaskInfoRunningElem task)
 	return false;
 }
 
+/**
+ * Find the task a thread belongs to
+ * @param[in] thread_id thread as from PIOS_Thread_Get_Id()
+ * @returns the task index, or TASKINFO_RUNNING_NUMELEM if the thread
+ * isn't monitored
+ */
+uint8_t TaskMonitorLookupThread(uintptr_t thread_id)
+{
+	for (uint8_t n = 0; n < TASKINFO_RUNNING_NUMELEM; n++) {
+		if (handles[n] && PIOS_Thread_Get_Id(handles[n]) == thread_id)
+			return n;
+	}
+
+	return TASKINFO_RUNNING_NUMELEM;
+}
+
+#if defined(DIAG_TASKS)
+/**
+ * Publish the statistics of one task as the given ThreadStats instance
+ */
+static void updateThreadStats(uint16_t inst, int task,
+		const struct pios_thread_stats *stats, uint16_t stack,
+		uint32_t elapsed_us)
+{
+	ThreadStatsData data;
+
+	data.Task = task;
+	data.CPU = 100.0f * stats->runtime_us / elapsed_us;
+	data.MaxBlocked = stats->max_blocked_us;
+	uint64_t wakeups = (uint64_t) stats->wakeups * 1000000 / elapsed_us;
+	data.Wakeups = (wakeups < UINT16_MAX) ? wakeups : UINT16_MAX;
+	data.StackRemaining = stack;
+
+	struct task_history *h = history[task];
+
+	if (h != NULL) {
+		uint32_t runtime = 0, window = 0;
+
+		h->runtime_us[window_idx] = stats->runtime_us;
+
+		for (int i = 0; i < TASKMONITOR_WINDOWS; i++) {
+			runtime += h->runtime_us[i];
+			window += window_us[i];
+		}
+
+		data.CPUAverage = 100.0f * runtime / window;
+	} else {
+		data.CPUAverage = data.CPU;
+	}
+
+	if (inst >= ThreadStatsGetNumInstances() &&
+			(inst >= TASKMONITOR_MAX_THREADSTATS ||
+			 ThreadStatsCreateInstance() == 0))
+		return;
+
+	ThreadStatsInstSet(inst, &data);
+}
+
+/**
+ * Clear the ThreadStats instances from the given one on, which are left
+ * over from tasks that have stopped
+ */
+static void clearThreadStats(uint16_t inst)
+{
+	ThreadStatsData data;
+
+	memset(&data, 0, sizeof(data));
+	data.Task = THREADSTATS_NO_TASK;
+
+	for (; inst < ThreadStatsGetNumInstances(); inst++)
+		ThreadStatsInstSet(inst, &data);
+}
+
+/**
+ * Publish the occupancy of the queues, one QueueStats instance each, up
+ * to TASKMONITOR_MAX_QUEUESTATS of them
+ */
+static void updateQueueStats(void)
+{
+	struct pios_queue *queuep = NULL;
+	uint16_t inst = 0;
+
+	while ((queuep = PIOS_Queue_Next(queuep)) != NULL) {
+		struct pios_queue_stats stats;
+		QueueStatsData data;
+
+		PIOS_Queue_Get_Stats(queuep, &stats);
+
+		data.Creator = stats.creator;
+		data.Failures = stats.failures;
+		data.Length = stats.length;
+		data.ItemSize = stats.item_size;
+		data.Depth = stats.depth;
+		data.HighWater = stats.high_water;
+
+		if (inst >= QueueStatsGetNumInstances() &&
+				(inst >= TASKMONITOR_MAX_QUEUESTATS ||
+				 QueueStatsCreateInstance() == 0))
+			return;
+
+		QueueStatsInstSet(inst++, &data);
+	}
+}
+#endif /* DIAG_TASKS */
+
 /**
  * Update the status of all tasks
  */
@@ -122,41 +263,55 @@ void TaskMonitorUpdateAll(void)
 	// Lock
 	PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
 
-	uint32_t currentTime = 0;
-	uint32_t deltaTime;
-	
 	/*
 	 * Calculate the amount of elapsed run time between the last time we
-	 * measured and now. Scale so that we can convert task run times
-	 * directly to percentages.
+	 * measured and now, on the same clock the thread runtimes use.
 	 */
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	currentTime = hal_lld_get_counter_value();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
-	deltaTime = ((currentTime - lastMonitorTime) / 100) ? : 1; /* avoid divide-by-zero if the interval is too small */
+	uint32_t currentTime = PIOS_DELAY_GetRaw();
+	uint32_t elapsed_us = PIOS_DELAY_DiffuS2(lastMonitorTime, currentTime) ? : 1; /* avoid divide-by-zero if the interval is too small */
 	lastMonitorTime = currentTime;
-	
+
+	window_idx = (window_idx + 1) % TASKMONITOR_WINDOWS;
+	window_us[window_idx] = elapsed_us;
+
+	uint16_t inst = 0;
+
 	// Update all task information
 	for (n = 0; n < TASKINFO_RUNNING_NUMELEM; ++n)
 	{
 		if (handles[n] != 0)
 		{
+			struct pios_thread_stats stats;
+
+			PIOS_Thread_Get_Stats(handles[n], &stats);
+
 			data.Running[n] = TASKINFO_RUNNING_TRUE;
 			data.StackRemaining[n] = PIOS_Thread_Get_Stack_Usage(handles[n]);
 			/* Generate run time stats */
-			data.RunningTime[n] = PIOS_Thread_Get_Runtime(handles[n]) / deltaTime;
+			uint64_t percent = (uint64_t) stats.runtime_us * 100 / elapsed_us;
+			data.RunningTime[n] = (percent < 100) ? percent : 100;
+
+			updateThreadStats(inst++, n, &stats,
+					data.StackRemaining[n], elapsed_us);
 		}
 		else
 		{
 			data.Running[n] = TASKINFO_RUNNING_FALSE;
 			data.StackRemaining[n] = 0;
 			data.RunningTime[n] = 0;
+
+			if (history[n] != NULL)
+				history[n]->runtime_us[window_idx] = 0;
 		}
 	}
 
+	clearThreadStats(inst);
+
 	// Update object
 	TaskInfoSet(&data);
 
+	updateQueueStats();
+
 	// Done
 	PIOS_Mutex_Unlock(lock);
 #endif
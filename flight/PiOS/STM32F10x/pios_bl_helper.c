@@ -31,6 +31,9 @@
 #include "pios.h"
 #if defined(PIOS_INCLUDE_BL_HELPER)
 #include <pios_board_info.h>
+#if defined(PIOS_INCLUDE_RTOS)
+#include "pios_thread.h"
+#endif
 #include "stm32f10x_flash.h"
 
 uint8_t *PIOS_BL_HELPER_FLASH_If_Read(uint32_t SectorAddress)
@@ -76,10 +79,22 @@ uint32_t PIOS_BL_HELPER_CRC_Memory_Calc()
 {
 	const struct pios_board_info * bdinfo = &pios_board_info_blob;
 
+#if defined(PIOS_INCLUDE_RTOS)
+	/* PIOS_CRC32_updateCRC borrows the unit from other threads */
+	while (!PIOS_CRC32_HW_Claim())
+		PIOS_Thread_Sleep(1);
+#endif
+
 	PIOS_BL_HELPER_CRC_Ini();
 	CRC_ResetDR();
 	CRC_CalcBlockCRC((uint32_t *) bdinfo->fw_base, (bdinfo->fw_size) >> 2);
-	return CRC_GetCRC();
+	uint32_t crc = CRC_GetCRC();
+
+#if defined(PIOS_INCLUDE_RTOS)
+	PIOS_CRC32_HW_Release();
+#endif
+
+	return crc;
 }
 
 void PIOS_BL_HELPER_FLASH_Read_Description(uint8_t * array, uint8_t size)
@@ -49,6 +49,12 @@ struct pios_com_driver {
 	bool (*available)(uintptr_t id);
 };
 
+/** A fragment of a frame to send; see PIOS_COM_SendVector */
+struct pios_com_iovec {
+	const void *base;
+	uint16_t len;
+};
+
 /* Public Functions */
 extern uintptr_t PIOS_COM_GetDriverCtx(uintptr_t com_id);
 extern int32_t PIOS_COM_ChangeBaud(uintptr_t com_id, uint32_t baud);
@@ -57,6 +63,9 @@ extern int32_t PIOS_COM_SendChar(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
 extern int32_t PIOS_COM_SendBufferStallTimeout(uintptr_t com_id, const uint8_t *buffer, uint16_t len, uint32_t max_ms);
 extern int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
+extern int32_t PIOS_COM_SendVectorNonBlocking(uintptr_t com_id, const struct pios_com_iovec *iov, uint8_t iovcnt);
+extern int32_t PIOS_COM_SendVectorStallTimeout(uintptr_t com_id, const struct pios_com_iovec *iov, uint8_t iovcnt, uint32_t max_ms);
+extern int32_t PIOS_COM_SendVector(uintptr_t com_id, const struct pios_com_iovec *iov, uint8_t iovcnt);
 extern int32_t PIOS_COM_SendStringNonBlocking(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendString(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendFormattedStringNonBlocking(uintptr_t com_id, const char *format, ...);
@@ -26,8 +26,35 @@
  * with this program; if not, see <http://www.gnu.org/licenses/>
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 
+/*
+ * PIOS_CRC_SLICE_BY picks how many bytes the CRC-16 and CRC-32 buffer
+ * functions fold in per step: 1, 4 or 8.  Wider steps break the dependency
+ * on the previous lookup but each one costs another set of tables in flash.
+ * It can be set from the build; by default only the bigger parts slice.
+ */
+#ifndef PIOS_CRC_SLICE_BY
+#if defined(FLIGHT_POSIX)
+#define PIOS_CRC_SLICE_BY 8
+#elif defined(STM32F4XX) || defined(STM32F30X)
+#define PIOS_CRC_SLICE_BY 4
+#else
+#define PIOS_CRC_SLICE_BY 1
+#endif
+#endif
+
+#if PIOS_CRC_SLICE_BY != 1 && PIOS_CRC_SLICE_BY != 4 && PIOS_CRC_SLICE_BY != 8
+#error PIOS_CRC_SLICE_BY must be 1, 4 or 8
+#endif
+
+/* The CRC-8 is the UAVTalk checksum and uses the codec's tables, so the
+ * parts that don't slice keep to one table there too */
+#if PIOS_CRC_SLICE_BY == 1 && !defined(UAVTALK_CODEC_CRC8_SLICE_BY)
+#define UAVTALK_CODEC_CRC8_SLICE_BY 1
+#endif
+
 uint8_t PIOS_CRC_updateByte(uint8_t crc, const uint8_t data);
 uint8_t PIOS_CRC_updateCRC(uint8_t crc, const uint8_t* data, int32_t length);
 uint8_t PIOS_CRC_updateCRC_TBS(uint8_t crc, const uint8_t *data, int32_t length);
@@ -38,3 +65,6 @@ uint16_t PIOS_CRC16_CCITT_updateCRC(uint16_t crc, const uint8_t *data, uint32_t
 
 uint32_t PIOS_CRC32_updateByte(uint32_t crc, const uint8_t data);
 uint32_t PIOS_CRC32_updateCRC(uint32_t crc, const uint8_t* data, int32_t length);
+
+bool PIOS_CRC32_HW_Claim(void);
+void PIOS_CRC32_HW_Release(void);
@@ -141,7 +141,7 @@ int PIOS_Crossfire_InitTelemetry(uintptr_t crsf_id);
 
 int PIOS_Crossfire_SendTelemetry(uintptr_t crsf_id, uint8_t *buf, uint8_t bytes);
 
-bool PIOS_Crossfire_IsFailsafed();
+bool PIOS_Crossfire_IsFailsafed(uintptr_t crsf_id);
 
 #endif // PIOS_CROSSFIRE_H
 
@@ -29,6 +29,16 @@
 
 #include <stdlib.h>		/* size_t */
 #include <stdbool.h>		/* bool */
+#include <stdint.h>		/* uint32_t */
+
+struct pios_heap_stats {
+	size_t total_bytes;	/**< Usable bytes in the heap */
+	size_t free_bytes;	/**< Bytes not allocated */
+	size_t min_free_bytes;	/**< Lowest free_bytes has been */
+	size_t largest_free;	/**< Largest allocation that can succeed */
+	uint32_t allocations;	/**< Blocks in use */
+	uint32_t failures;	/**< Allocations that couldn't be satisfied */
+};
 
 extern bool PIOS_heap_malloc_failed_p(void);
 
@@ -39,6 +49,8 @@ extern void PIOS_free(void * buf);
 
 extern size_t PIOS_heap_get_free_size(void);
 extern size_t PIOS_fastheap_get_free_size(void);
+extern void PIOS_heap_get_stats(struct pios_heap_stats *stats);
+extern void PIOS_fastheap_get_stats(struct pios_heap_stats *stats);
 extern void PIOS_heap_initialize_blocks(void);
 extern void PIOS_heap_increase_size(size_t bytes);
 
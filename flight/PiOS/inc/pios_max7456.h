@@ -64,8 +64,6 @@
 
 typedef struct max7456_dev_s *max7456_dev_t;
 
-void PIOS_MAX7456_wait_vsync ();
-
 /**
  * @brief Allocate and initialise MAX7456 device
  * @param[out] dev_out Device handle, only valid when return value is success
@@ -122,6 +120,18 @@ void PIOS_MAX7456_put (max7456_dev_t dev, uint8_t col, uint8_t row,
 void PIOS_MAX7456_puts (max7456_dev_t dev, uint8_t col, uint8_t row,
 		const char *s, uint8_t attr);
 
+/**
+ * @brief Pushes changed character cells to the device.
+ *
+ * put, puts and clear only update a shadow of display memory; this writes
+ * the cells that differ from what the chip shows, in auto-increment bursts.
+ * It is called by PIOS_MAX7456_wait_vsync, so that updates land during
+ * vertical blanking; call it directly to show something without waiting.
+ * @param[in] dev The max7456 device handle
+ * @return The number of bytes sent over SPI
+ */
+uint32_t PIOS_MAX7456_flush(max7456_dev_t dev);
+
 /**
  * @brief Gets the extents of the screen.
  * @param[in] dev The max7456 device handle
@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ * @file       pios_profiler.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Profiler Sampling profiler
+ * @{
+ * @brief Statistical profiler that samples the interrupted program counter
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_PROFILER_H_
+#define PIOS_PROFILER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * One sample of what the CPU was doing.
+ */
+struct pios_profiler_sample {
+	/**
+	 * Interrupted code address.  On the host this is relative to the
+	 * start of the executable so that position independent builds can
+	 * be symbolized.  0 if an interrupt handler was interrupted.
+	 */
+	uint32_t pc;
+
+	/**
+	 * The running thread, as from PIOS_Thread_Get_Id(), or 0 if an
+	 * interrupt handler was interrupted.
+	 */
+	uintptr_t thread;
+};
+
+int32_t PIOS_Profiler_Start(uint16_t rate_hz);
+void PIOS_Profiler_Stop(void);
+uint16_t PIOS_Profiler_Read(struct pios_profiler_sample *samples, uint16_t max_samples);
+uint32_t PIOS_Profiler_GetDropped(void);
+
+#endif /* PIOS_PROFILER_H_ */
+
+/**
+  * @}
+  * @}
+  */
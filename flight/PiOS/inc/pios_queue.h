@@ -50,6 +50,21 @@ bool PIOS_Queue_Send_FromISR(struct pios_queue *queuep, const void *itemp, bool
 bool PIOS_Queue_Receive(struct pios_queue *queuep, void *itemp, uint32_t timeout_ms);
 size_t PIOS_Queue_GetItemSize(struct pios_queue *queuep);
 
+/**
+ * Occupancy statistics of a queue.
+ */
+struct pios_queue_stats {
+	uintptr_t creator;	/**< Return address of the PIOS_Queue_Create() call */
+	uint16_t length;	/**< Capacity in items */
+	uint16_t item_size;
+	uint16_t depth;		/**< Items waiting right now */
+	uint16_t high_water;	/**< Most items ever waiting at once */
+	uint32_t failures;	/**< Sends that failed because the queue was full */
+};
+
+struct pios_queue *PIOS_Queue_Next(struct pios_queue *queuep);
+void PIOS_Queue_Get_Stats(struct pios_queue *queuep, struct pios_queue_stats *stats);
+
 #endif /* PIOS_QUEUE_H_ */
 
 /**
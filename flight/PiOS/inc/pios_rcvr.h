@@ -30,13 +30,41 @@
 #ifndef PIOS_RCVR_H
 #define PIOS_RCVR_H
 
+/* Most channels a receiver frame carries */
+#define PIOS_RCVR_FRAME_CHANNELS 32
+
+/**
+ * All the channels decoded from one receiver frame.  Channel values are as
+ * PIOS_RCVR_Read returns them, truncated to 16 bits like the error codes are
+ * in ManualControlCommand.
+ */
+struct pios_rcvr_frame {
+	uint32_t timestamp;	/**< PIOS_DELAY_GetRaw() when the frame was decoded */
+	uint32_t sequence;	/**< Frames published before and including this one; 0 if untracked */
+	uint8_t num_channels;
+	uint16_t channels[PIOS_RCVR_FRAME_CHANNELS];
+};
+
+/**
+ * The latest frame of a driver.  Drivers publish to it from interrupt
+ * context with PIOS_RCVR_PublishFrame; tasks copy it out without locking.
+ */
+struct pios_rcvr_frame_buf {
+	uint32_t seq;		/**< Odd while a frame is being written */
+	struct pios_rcvr_frame frame;
+};
+
 struct pios_rcvr_driver {
 	void    (*init)(uintptr_t id);
 	int32_t (*read)(uintptr_t id, uint8_t channel);
+	/* Optional: the frames the driver publishes */
+	const struct pios_rcvr_frame_buf *(*get_frame_buf)(uintptr_t id);
 };
 
 /* Public Functions */
 int32_t PIOS_RCVR_Read(uintptr_t rcvr_id, uint8_t channel);
+int32_t PIOS_RCVR_ReadFrame(uintptr_t rcvr_id, uint8_t max_channel, struct pios_rcvr_frame *frame);
+void PIOS_RCVR_PublishFrame(struct pios_rcvr_frame_buf *buf, const uint16_t *channels, uint8_t num_channels);
 bool PIOS_RCVR_WaitActivity(uint32_t timeout_ms);
 void PIOS_RCVR_Active();
 void PIOS_RCVR_ActiveFromISR();
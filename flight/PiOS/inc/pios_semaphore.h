@@ -48,6 +48,7 @@ struct pios_semaphore;
  */
 
 struct pios_semaphore *PIOS_Semaphore_Create(void);
+void PIOS_Semaphore_Delete(struct pios_semaphore *sema);
 bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms);
 bool PIOS_Semaphore_Give(struct pios_semaphore *sema);
 
@@ -33,6 +33,7 @@
 #include "pios.h"
 #include "stdint.h"
 #include "pios_queue.h"
+#include "pios_spscqueue.h"
 
 //! Pios sensor structure for generic gyro data
 struct pios_sensor_gyro_data {
@@ -103,6 +104,9 @@ int32_t PIOS_SENSORS_Init();
 //! Register a queue-based sensor with the PIOS_SENSORS interface
 int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *queue);
 
+//! Register a sensor that delivers through a single producer/consumer queue
+int32_t PIOS_SENSORS_RegisterSPSCQueue(enum pios_sensor_type type, struct pios_spscqueue *queue);
+
 //! Register a callback-based sensor with the PIOS_SENSORS interface
 int32_t PIOS_SENSORS_RegisterCallback(enum pios_sensor_type type,
 		PIOS_SENSOR_Callback_t callback, void *ctx);
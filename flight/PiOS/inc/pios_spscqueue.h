@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ * @file       pios_spscqueue.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SPSCQueue Single producer / single consumer queue
+ * @{
+ * @brief Lock-free queue for exactly one sending and one receiving context
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_SPSCQUEUE_H_
+#define PIOS_SPSCQUEUE_H_
+
+#define PIOS_SPSCQUEUE_TIMEOUT_MAX 0xffffffff
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * A queue with the same semantics as struct pios_queue, restricted to a
+ * single producer and a single consumer.  Sending and receiving do not take
+ * any lock; a semaphore is only touched when the other side is (or is about
+ * to be) blocked waiting for data or for room.
+ *
+ * The producer may be an ISR (use PIOS_SPSCQueue_Send_FromISR), but there
+ * must never be two concurrent senders or two concurrent receivers.
+ */
+
+struct pios_spscqueue;
+
+struct pios_spscqueue *PIOS_SPSCQueue_Create(uint16_t queue_length, uint16_t item_size);
+bool PIOS_SPSCQueue_Send(struct pios_spscqueue *q, const void *itemp, uint32_t timeout_ms);
+uint16_t PIOS_SPSCQueue_SendMulti(struct pios_spscqueue *q, const void *itemsp, uint16_t num, uint32_t timeout_ms);
+bool PIOS_SPSCQueue_Send_FromISR(struct pios_spscqueue *q, const void *itemp, bool *wokenp);
+bool PIOS_SPSCQueue_Receive(struct pios_spscqueue *q, void *itemp, uint32_t timeout_ms);
+uint16_t PIOS_SPSCQueue_ReceiveMulti(struct pios_spscqueue *q, void *itemsp, uint16_t num, uint32_t timeout_ms);
+uint16_t PIOS_SPSCQueue_GetItemSize(struct pios_spscqueue *q);
+
+#endif /* PIOS_SPSCQUEUE_H_ */
+
+/**
+  * @}
+  * @}
+  */
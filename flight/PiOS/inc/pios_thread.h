@@ -33,6 +33,16 @@
 
 struct pios_thread;
 
+/**
+ * Scheduling statistics of a thread, accumulated since the previous call
+ * to PIOS_Thread_Get_Stats() on it.
+ */
+struct pios_thread_stats {
+	uint32_t runtime_us;		/**< CPU time used */
+	uint32_t wakeups;		/**< Times the thread was resumed */
+	uint32_t max_blocked_us;	/**< Longest stretch spent off the CPU */
+};
+
 #include <taskmonitor.h>
 
 #if defined(PIOS_INCLUDE_CHIBIOS)
@@ -75,6 +85,9 @@ void PIOS_Thread_Sleep(uint32_t time_ms);
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms);
 uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp);
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp);
+bool PIOS_Thread_Get_Stats(struct pios_thread *threadp, struct pios_thread_stats *stats);
+uintptr_t PIOS_Thread_Get_Id(struct pios_thread *threadp);
+uintptr_t PIOS_Thread_Current_Id(void);
 void PIOS_Thread_Scheduler_Suspend(void);
 void PIOS_Thread_Scheduler_Resume(void);
 
@@ -95,6 +108,10 @@ void PIOS_Thread_ChangePriority(enum pios_thread_prio_e prio);
 void PIOS_Thread_FakeClock_Tick(void);
 bool PIOS_Thread_FakeClock_IsActive(void);
 void PIOS_Thread_FakeClock_UpdateBarrier(uint32_t increment);
+
+/* Bracket a blocking wait so it is counted in the thread statistics */
+uint32_t PIOS_Thread_Block_Begin(void);
+void PIOS_Thread_Block_End(uint32_t begin);
 #endif
 
 #endif /* PIOS_THREAD_H_ */
@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ * @file       pios_tlsf.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_TLSF Two-level segregated fit allocator
+ * @{
+ * @brief Constant time allocator behind the PiOS heaps
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_TLSF_H_
+#define PIOS_TLSF_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Free blocks are kept in lists by size class: a power of two range, split
+ * linearly into 8.  Two bitmaps record which lists have blocks, so both
+ * allocating and freeing take a fixed number of steps whatever the state of
+ * the heap, and freed blocks are merged with free neighbours right away.
+ *
+ * An allocation is served from a list whose blocks are all big enough, so
+ * it may fail while a block it would fit in, less than one size class
+ * bigger, is free.  Anything up to seven eighths of the largest free block
+ * is sure to succeed.  What a block has beyond the allocation is split off
+ * and stays free.
+ *
+ * The allocator does no locking of its own.
+ */
+
+struct pios_tlsf;
+
+struct pios_tlsf_stats {
+	size_t total_bytes;	/**< Usable bytes in all the pools */
+	size_t free_bytes;	/**< Bytes in free blocks */
+	size_t min_free_bytes;	/**< Lowest free_bytes has been */
+	size_t largest_free;	/**< Largest free block */
+	uint32_t allocations;	/**< Blocks in use */
+	uint32_t failures;	/**< Allocations that couldn't be satisfied */
+};
+
+struct pios_tlsf *PIOS_TLSF_Create(void *mem, size_t bytes);
+bool PIOS_TLSF_AddPool(struct pios_tlsf *tlsf, void *mem, size_t bytes);
+void *PIOS_TLSF_Malloc(struct pios_tlsf *tlsf, size_t size);
+void PIOS_TLSF_Free(struct pios_tlsf *tlsf, void *ptr);
+size_t PIOS_TLSF_GetFreeSize(struct pios_tlsf *tlsf);
+void PIOS_TLSF_GetStats(struct pios_tlsf *tlsf, struct pios_tlsf_stats *stats);
+bool PIOS_TLSF_Check(struct pios_tlsf *tlsf);
+
+#endif /* PIOS_TLSF_H_ */
+
+/**
+  * @}
+  * @}
+  */
@@ -33,6 +33,7 @@ int32_t TaskMonitorInitialize(void);
 int32_t TaskMonitorAdd(TaskInfoRunningElem task, struct pios_thread *handlep);
 int32_t TaskMonitorRemove(TaskInfoRunningElem task);
 bool TaskMonitorQueryRunning(TaskInfoRunningElem task);
+uint8_t TaskMonitorLookupThread(uintptr_t thread_id);
 void TaskMonitorUpdateAll(void);
 
 #endif // TASKMONITOR_H
@@ -16,10 +16,13 @@ SRC += pios_usb_desc_hid_only.c
 SRC += pios_usb_util.c
 SRC += pios_adc.c
 SRC += pios_heap.c
+SRC += pios_tlsf.c
 SRC += pios_semaphore.c
 SRC += pios_mutex.c
 SRC += pios_queue.c
+SRC += pios_spscqueue.c
 SRC += pios_thread.c
+SRC += pios_profiler.c
 SRC += pios_streamfs.c
 SRC += pios_hal.c
 SRC += pios_servo.c
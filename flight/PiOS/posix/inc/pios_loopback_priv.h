@@ -0,0 +1,52 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_loopback_priv.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      LOOPBACK private definitions.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef PIOS_LOOPBACK_PRIV_H
+#define PIOS_LOOPBACK_PRIV_H
+
+#include <pios.h>
+
+#ifndef PIOS_LOOPBACK_MAX_CHUNK
+#define PIOS_LOOPBACK_MAX_CHUNK 256
+#endif
+
+extern const struct pios_com_driver pios_loopback_com_driver;
+
+/* Counted by the line thread since init */
+struct pios_loopback_stats {
+	uint32_t tx_bytes;	/**< Bytes taken from the transmitter */
+	uint32_t tx_calls;	/**< Transmit callbacks that returned bytes */
+	uint32_t tx_starts;	/**< Calls to tx_start */
+	uint32_t rx_dropped;	/**< Bytes the receiver had no room for */
+};
+
+extern int32_t PIOS_LOOPBACK_Init(uintptr_t *loopback_id, uint16_t chunk);
+extern void PIOS_LOOPBACK_GetStats(uintptr_t loopback_id,
+		struct pios_loopback_stats *stats);
+
+#endif /* PIOS_LOOPBACK_PRIV_H */
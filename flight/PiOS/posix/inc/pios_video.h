@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_VIDEO Code for OSD video generator
+ * @{
+ *
+ * @file       pios_video.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Frame buffers of the OSD video generator, without the hardware
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_VIDEO_H
+#define PIOS_VIDEO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// PAL/NTSC specific boundary values
+struct pios_video_type_boundary {
+	uint16_t graphics_right;
+	uint16_t graphics_bottom;
+};
+
+// 3D Mode
+enum pios_video_3d_mode {
+	PIOS_VIDEO_3D_DISABLED,
+	PIOS_VIDEO_3D_SBS3D,
+};
+
+enum pios_video_system {
+	PIOS_VIDEO_SYSTEM_NONE,
+	PIOS_VIDEO_SYSTEM_PAL,
+	PIOS_VIDEO_SYSTEM_NTSC,
+};
+
+void PIOS_Video_SetSystem(enum pios_video_system system);
+enum pios_video_system PIOS_Video_GetSystem(void);
+
+void PIOS_Video_SwapBuffers(void);
+int32_t PIOS_Video_DumpFrame(const char *path);
+
+// video boundary values
+extern const struct pios_video_type_boundary *pios_video_type_boundary_act;
+#define GRAPHICS_LEFT        0
+#define GRAPHICS_TOP         0
+#define GRAPHICS_RIGHT       pios_video_type_boundary_act->graphics_right
+#define GRAPHICS_BOTTOM      pios_video_type_boundary_act->graphics_bottom
+
+#define GRAPHICS_X_MIDDLE	((GRAPHICS_RIGHT + 1) / 2)
+#define GRAPHICS_Y_MIDDLE	((GRAPHICS_BOTTOM + 1) / 2)
+
+// Same buffer geometry as the STM32F4 video generator
+#define GRAPHICS_WIDTH_REAL  376                            // max columns
+#define GRAPHICS_HEIGHT_REAL 266                            // max lines
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+#define BUFFER_WIDTH         (GRAPHICS_WIDTH_REAL / 8  + 1)
+#define BUFFER_HEIGHT        (GRAPHICS_HEIGHT_REAL)
+#else
+#define BUFFER_WIDTH_TMP     (GRAPHICS_WIDTH_REAL / (8 / PIOS_VIDEO_BITS_PER_PIXEL))
+#define BUFFER_WIDTH (BUFFER_WIDTH_TMP + BUFFER_WIDTH_TMP % 4)
+#define BUFFER_HEIGHT        (GRAPHICS_HEIGHT_REAL)
+#endif /* PIOS_VIDEO_SPLITBUFFER */
+
+// Macro to swap buffers given a temporary pointer.
+#define SWAP_BUFFS(tmp, a, b) { tmp = a; a = b; b = tmp; }
+
+#endif /* PIOS_VIDEO_H */
+
+/**
+ * @}
+ * @}
+ */
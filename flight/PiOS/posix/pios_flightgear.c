@@ -56,7 +56,7 @@
 struct flightgear_dev {
 	int socket;
 
-	struct pios_queue *accel_queue, *gyro_queue;
+	struct pios_spscqueue *accel_queue, *gyro_queue;
 
 	struct sockaddr_in send_addr;
 };
@@ -131,8 +131,8 @@ static void PIOS_FLIGHTGEAR_RxTask(void *param)
 			gyro_data.y = gyro_data.y * 0.3 + rates[1] * 0.7;
 			gyro_data.z = gyro_data.z * 0.3 + rates[2] * 0.7;
 
-			PIOS_Queue_Send(fg_dev->accel_queue, &accel_data, 0);
-			PIOS_Queue_Send(fg_dev->gyro_queue, &gyro_data, 0);
+			PIOS_SPSCQueue_Send(fg_dev->accel_queue, &accel_data, 0);
+			PIOS_SPSCQueue_Send(fg_dev->gyro_queue, &gyro_data, 0);
 
 			fd_set r;
 
@@ -204,12 +204,12 @@ int32_t PIOS_FLIGHTGEAR_Init(flightgear_dev_t *dev, uint16_t port)
 		exit(EXIT_FAILURE);
 	}
 
-	fg_dev->accel_queue = PIOS_Queue_Create(2, sizeof(struct pios_sensor_accel_data));
+	fg_dev->accel_queue = PIOS_SPSCQueue_Create(2, sizeof(struct pios_sensor_accel_data));
 	if (fg_dev->accel_queue == NULL) {
 		exit(1);
 	}
 
-	fg_dev->gyro_queue = PIOS_Queue_Create(2, sizeof(struct pios_sensor_gyro_data));
+	fg_dev->gyro_queue = PIOS_SPSCQueue_Create(2, sizeof(struct pios_sensor_gyro_data));
 	if (fg_dev->gyro_queue == NULL) {
 		exit(1);
 	}
@@ -217,8 +217,8 @@ int32_t PIOS_FLIGHTGEAR_Init(flightgear_dev_t *dev, uint16_t port)
 	PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_ACCEL, 333);
 	PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_GYRO, 333);
 
-	PIOS_SENSORS_Register(PIOS_SENSOR_ACCEL, fg_dev->accel_queue);
-	PIOS_SENSORS_Register(PIOS_SENSOR_GYRO, fg_dev->gyro_queue);
+	PIOS_SENSORS_RegisterSPSCQueue(PIOS_SENSOR_ACCEL, fg_dev->accel_queue);
+	PIOS_SENSORS_RegisterSPSCQueue(PIOS_SENSOR_GYRO, fg_dev->gyro_queue);
 
 	PIOS_SENSORS_SetMaxGyro(2000);
 
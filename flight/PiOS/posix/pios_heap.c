@@ -81,6 +81,19 @@ size_t PIOS_fastheap_get_free_size(void)
 	return 0;
 }
 
+void PIOS_heap_get_stats(struct pios_heap_stats *stats)
+{
+	/* libc doesn't say */
+	*stats = (struct pios_heap_stats) {
+		.free_bytes = PIOS_heap_get_free_size(),
+	};
+}
+
+void PIOS_fastheap_get_stats(struct pios_heap_stats *stats)
+{
+	*stats = (struct pios_heap_stats) { 0 };
+}
+
 /**
  * @}
  * @}
@@ -0,0 +1,207 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_loopback.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Pios COM driver that hands what it's sent back to its receiver.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_LOOPBACK Loopback Driver
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+/*
+ * A line thread stands in for the transmit interrupt: each tx_start wakes
+ * it, and it pulls from the COM layer a chunk at a time until there's
+ * nothing left, just as a uart (a byte a call) or a usb endpoint (a packet
+ * a call) would.  What it pulls is fed to the receive side, if one is
+ * bound.  It's there to measure what the COM layer costs per byte.
+ */
+
+#include <pios.h>
+
+#include <pios_loopback_priv.h>
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+
+static void PIOS_LOOPBACK_RegisterRxCallback(uintptr_t loopback_id, pios_com_callback rx_in_cb, uintptr_t context);
+static void PIOS_LOOPBACK_RegisterTxCallback(uintptr_t loopback_id, pios_com_callback tx_out_cb, uintptr_t context);
+static void PIOS_LOOPBACK_TxStart(uintptr_t loopback_id, uint16_t tx_bytes_avail);
+
+typedef struct {
+	pios_com_callback tx_out_cb;
+	uintptr_t tx_out_context;
+	pios_com_callback rx_in_cb;
+	uintptr_t rx_in_context;
+
+	struct pios_semaphore *tx_sem;
+
+	uint16_t chunk;
+
+	struct pios_loopback_stats stats;
+
+	uint8_t line[PIOS_LOOPBACK_MAX_CHUNK];
+} pios_loopback_dev;
+
+const struct pios_com_driver pios_loopback_com_driver = {
+	.tx_start   = PIOS_LOOPBACK_TxStart,
+	.bind_tx_cb = PIOS_LOOPBACK_RegisterTxCallback,
+	.bind_rx_cb = PIOS_LOOPBACK_RegisterRxCallback,
+};
+
+static pios_loopback_dev *find_loopback_dev_by_id(uintptr_t loopback)
+{
+	return (pios_loopback_dev *) loopback;
+}
+
+/**
+ * LineTask
+ */
+static void PIOS_LOOPBACK_LineTask(void *loopback_dev_n)
+{
+	pios_loopback_dev *loopback_dev = (pios_loopback_dev *)loopback_dev_n;
+
+	while (1) {
+		PIOS_Semaphore_Take(loopback_dev->tx_sem,
+				PIOS_SEMAPHORE_TIMEOUT_MAX);
+
+		if (!loopback_dev->tx_out_cb) {
+			continue;
+		}
+
+		uint16_t len;
+
+		do {
+			bool tx_need_yield = false;
+
+			len = loopback_dev->tx_out_cb(loopback_dev->tx_out_context,
+					loopback_dev->line, loopback_dev->chunk,
+					NULL, &tx_need_yield);
+
+			if (!len) {
+				break;
+			}
+
+			loopback_dev->stats.tx_bytes += len;
+			loopback_dev->stats.tx_calls++;
+
+			uint16_t delivered = 0;
+
+			if (loopback_dev->rx_in_cb) {
+				bool rx_need_yield = false;
+
+				delivered = loopback_dev->rx_in_cb(
+						loopback_dev->rx_in_context,
+						loopback_dev->line, len, NULL,
+						&rx_need_yield);
+			}
+
+			/* Like an overrun uart, what doesn't fit is lost */
+			loopback_dev->stats.rx_dropped += len - delivered;
+		} while (1);
+	}
+}
+
+/**
+ * Create a loopback device
+ * \param[out] loopback_id
+ * \param[in] chunk most bytes to take from the transmitter per callback
+ * \return < 0 if initialisation failed
+ */
+int32_t PIOS_LOOPBACK_Init(uintptr_t *loopback_id, uint16_t chunk)
+{
+	PIOS_Assert(chunk && chunk <= PIOS_LOOPBACK_MAX_CHUNK);
+
+	pios_loopback_dev *loopback_dev = PIOS_malloc(sizeof(pios_loopback_dev));
+
+	if (!loopback_dev) {
+		return -1;
+	}
+
+	memset(loopback_dev, 0, sizeof(*loopback_dev));
+
+	loopback_dev->chunk = chunk;
+
+	loopback_dev->tx_sem = PIOS_Semaphore_Create();
+
+	if (!loopback_dev->tx_sem) {
+		return -1;
+	}
+
+	PIOS_Thread_Create(PIOS_LOOPBACK_LineTask, "pios_loopback",
+		PIOS_THREAD_STACK_SIZE_MIN, loopback_dev, PIOS_THREAD_PRIO_HIGHEST);
+
+	*loopback_id = (uintptr_t) loopback_dev;
+
+	return 0;
+}
+
+/**
+ * Get what the line thread has counted so far
+ * \param[in] loopback_id
+ * \param[out] stats
+ */
+void PIOS_LOOPBACK_GetStats(uintptr_t loopback_id,
+		struct pios_loopback_stats *stats)
+{
+	pios_loopback_dev *loopback_dev = find_loopback_dev_by_id(loopback_id);
+
+	*stats = loopback_dev->stats;
+}
+
+static void PIOS_LOOPBACK_TxStart(uintptr_t loopback_id, uint16_t tx_bytes_avail)
+{
+	pios_loopback_dev *loopback_dev = find_loopback_dev_by_id(loopback_id);
+
+	(void) tx_bytes_avail;
+
+	loopback_dev->stats.tx_starts++;
+
+	PIOS_Semaphore_Give(loopback_dev->tx_sem);
+}
+
+static void PIOS_LOOPBACK_RegisterRxCallback(uintptr_t loopback_id, pios_com_callback rx_in_cb, uintptr_t context)
+{
+	pios_loopback_dev *loopback_dev = find_loopback_dev_by_id(loopback_id);
+
+	/*
+	 * Order is important in these assignments since the line thread
+	 * may be running at any time.  Set the context first, then the
+	 * callback.
+	 */
+	loopback_dev->rx_in_context = context;
+	loopback_dev->rx_in_cb = rx_in_cb;
+}
+
+static void PIOS_LOOPBACK_RegisterTxCallback(uintptr_t loopback_id, pios_com_callback tx_out_cb, uintptr_t context)
+{
+	pios_loopback_dev *loopback_dev = find_loopback_dev_by_id(loopback_id);
+
+	loopback_dev->tx_out_context = context;
+	loopback_dev->tx_out_cb = tx_out_cb;
+}
+
+/**
+ * @}
+ * @}
+ */
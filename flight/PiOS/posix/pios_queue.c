@@ -42,8 +42,37 @@ struct pios_queue {
 	uint16_t q_len;
 
 	circ_queue_t queue;
+
+	struct pios_queue *next;
+	uintptr_t creator;
+	uint16_t depth;
+	uint16_t high_water;
+	uint32_t failures;
 };
 
+/* All queues, in order of creation */
+static struct pios_queue *queue_list;
+static pthread_mutex_t queue_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Waits on the queue condition, counted in the thread statistics */
+static int queue_wait(struct pios_queue *queuep, uint32_t timeout_ms,
+		const struct timespec *abstime)
+{
+	uint32_t block = PIOS_Thread_Block_Begin();
+	int ret;
+
+	if (timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) {
+		ret = pthread_cond_timedwait(&queuep->cond, &queuep->mutex,
+				abstime);
+	} else {
+		ret = pthread_cond_wait(&queuep->cond, &queuep->mutex);
+	}
+
+	PIOS_Thread_Block_End(block);
+
+	return ret;
+}
+
 struct pios_queue *PIOS_Queue_Create(size_t queue_length, size_t item_size)
 {
 	struct pios_queue *q = PIOS_malloc(sizeof(*q));
@@ -81,8 +110,26 @@ struct pios_queue *PIOS_Queue_Create(size_t queue_length, size_t item_size)
 		return NULL;
 	}
 
+	q->next = NULL;
+	q->creator = (uintptr_t) __builtin_return_address(0);
+	q->depth = 0;
+	q->high_water = 0;
+	q->failures = 0;
+
 	q->magic = QUEUE_MAGIC;
 
+	pthread_mutex_lock(&queue_list_mutex);
+
+	struct pios_queue **tail = &queue_list;
+
+	while (*tail) {
+		tail = &(*tail)->next;
+	}
+
+	*tail = q;
+
+	pthread_mutex_unlock(&queue_list_mutex);
+
 	return q;
 }
 
@@ -90,6 +137,18 @@ void PIOS_Queue_Delete(struct pios_queue *queuep)
 {
 	PIOS_Assert(queuep->magic == QUEUE_MAGIC);
 
+	pthread_mutex_lock(&queue_list_mutex);
+
+	for (struct pios_queue **link = &queue_list; *link;
+			link = &(*link)->next) {
+		if (*link == queuep) {
+			*link = queuep->next;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&queue_list_mutex);
+
 	pthread_mutex_destroy(&queuep->mutex);
 	pthread_cond_destroy(&queuep->cond);
 
@@ -120,17 +179,18 @@ static bool PIOS_Queue_Send_Impl(struct pios_queue *queuep,
 	pthread_mutex_lock(&queuep->mutex);
 
 	while (!circ_queue_write_data(queuep->queue, itemp, 1)) {
-		if (timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) {
-			if (pthread_cond_timedwait(&queuep->cond,
-					&queuep->mutex, &abstime)) {
-				pthread_mutex_unlock(&queuep->mutex);
-				return false;
-			}
-		} else {
-			pthread_cond_wait(&queuep->cond, &queuep->mutex);
+		if (queue_wait(queuep, timeout_ms, &abstime)) {
+			pthread_mutex_unlock(&queuep->mutex);
+			return false;
 		}
 	}
 
+	queuep->depth++;
+
+	if (queuep->depth > queuep->high_water) {
+		queuep->high_water = queuep->depth;
+	}
+
 	pthread_cond_broadcast(&queuep->cond);
 
 	pthread_mutex_unlock(&queuep->mutex);
@@ -153,11 +213,13 @@ bool PIOS_Queue_Send(struct pios_queue *queuep,
 		} while ((timeout_ms == PIOS_QUEUE_TIMEOUT_MAX) ||
 				(!PIOS_Thread_Period_Elapsed(start,
 							     timeout_ms)));
-
-		return false;
+	} else if (PIOS_Queue_Send_Impl(queuep, itemp, timeout_ms)) {
+		return true;
 	}
 
-	return PIOS_Queue_Send_Impl(queuep, itemp, timeout_ms);
+	__atomic_fetch_add(&queuep->failures, 1, __ATOMIC_RELAXED);
+
+	return false;
 }
 
 bool PIOS_Queue_Send_FromISR(struct pios_queue *queuep,
@@ -192,17 +254,14 @@ static bool PIOS_Queue_Receive_Impl(struct pios_queue *queuep,
 	pthread_mutex_lock(&queuep->mutex);
 
 	while (!circ_queue_read_data(queuep->queue, itemp, 1)) {
-		if (timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) {
-			if (pthread_cond_timedwait(&queuep->cond,
-					&queuep->mutex, &abstime)) {
-				pthread_mutex_unlock(&queuep->mutex);
-				return false;
-			}
-		} else {
-			pthread_cond_wait(&queuep->cond, &queuep->mutex);
+		if (queue_wait(queuep, timeout_ms, &abstime)) {
+			pthread_mutex_unlock(&queuep->mutex);
+			return false;
 		}
 	}
 
+	queuep->depth--;
+
 	pthread_cond_broadcast(&queuep->cond);
 
 	pthread_mutex_unlock(&queuep->mutex);
@@ -238,6 +297,36 @@ size_t PIOS_Queue_GetItemSize(struct pios_queue *queuep)
 	return queuep->item_size;
 }
 
+struct pios_queue *PIOS_Queue_Next(struct pios_queue *queuep)
+{
+	struct pios_queue *next;
+
+	pthread_mutex_lock(&queue_list_mutex);
+
+	next = queuep ? queuep->next : queue_list;
+
+	pthread_mutex_unlock(&queue_list_mutex);
+
+	return next;
+}
+
+void PIOS_Queue_Get_Stats(struct pios_queue *queuep,
+		struct pios_queue_stats *stats)
+{
+	PIOS_Assert(queuep->magic == QUEUE_MAGIC);
+
+	pthread_mutex_lock(&queuep->mutex);
+
+	stats->creator = queuep->creator;
+	stats->length = queuep->q_len;
+	stats->item_size = queuep->item_size;
+	stats->depth = queuep->depth;
+	stats->high_water = queuep->high_water;
+	stats->failures = queuep->failures;
+
+	pthread_mutex_unlock(&queuep->mutex);
+}
+
 /**
   * @}
   * @}
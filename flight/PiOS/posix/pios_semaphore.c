@@ -69,6 +69,16 @@ struct pios_semaphore *PIOS_Semaphore_Create(void)
 	return s;
 }
 
+void PIOS_Semaphore_Delete(struct pios_semaphore *sema)
+{
+	PIOS_Assert(sema->magic == SEMAPHORE_MAGIC);
+
+	pthread_mutex_destroy(&sema->mutex);
+	pthread_cond_destroy(&sema->cond);
+
+	PIOS_free(sema);
+}
+
 bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
 {
 	PIOS_Assert(sema->magic == SEMAPHORE_MAGIC);
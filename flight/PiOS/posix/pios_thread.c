@@ -24,7 +24,9 @@
  */
 
 
+#include <errno.h>
 #include <pthread.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <pios.h>
@@ -39,8 +41,61 @@ struct pios_thread
 	pthread_t thread;
 
 	const char *name;
+
+	void (*fp)(void *);
+	void *argp;
+
+	clockid_t cpu_clock;
+	uint64_t cpu_ns_last;
+
+	/* Updated by the thread itself, read and cleared by the monitor */
+	uint32_t wakeups;
+	uint32_t max_blocked_us;
 };
 
+/* The handle of the calling thread, for the blocking-call statistics */
+static __thread struct pios_thread *current_thread;
+
+static uint64_t thread_cpu_ns(struct pios_thread *threadp)
+{
+	struct timespec ts;
+
+	if (clock_gettime(threadp->cpu_clock, &ts)) {
+		return threadp->cpu_ns_last;
+	}
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void thread_cpu_clock_init(struct pios_thread *threadp)
+{
+	threadp->cpu_ns_last = 0;
+
+#ifdef __linux__
+	/* Own CPU clock, readable from other threads unlike
+	 * CLOCK_THREAD_CPUTIME_ID */
+	if (pthread_getcpuclockid(threadp->thread, &threadp->cpu_clock)) {
+		threadp->cpu_clock = CLOCK_THREAD_CPUTIME_ID;
+	}
+#else
+	/* No per-thread CPU clocks; runtime reads as zero */
+	threadp->cpu_clock = (clockid_t) -1;
+#endif
+
+	threadp->cpu_ns_last = thread_cpu_ns(threadp);
+}
+
+static void *thread_trampoline(void *arg)
+{
+	struct pios_thread *thread = arg;
+
+	current_thread = thread;
+
+	thread->fp(thread->argp);
+
+	return NULL;
+}
+
 /**
  * @brief   Creates a handle for the current thread.
  *
@@ -60,6 +115,12 @@ struct pios_thread *PIOS_Thread_WrapCurrentThread(const char *namep)
 
 	thread->name = namep;
 
+	thread->wakeups = 0;
+	thread->max_blocked_us = 0;
+	thread_cpu_clock_init(thread);
+
+	current_thread = thread;
+
 	if (are_realtime) {
 		struct sched_param param = {
 			.sched_priority = 30 + PIOS_THREAD_PRIO_HIGHEST * 5
@@ -108,10 +169,13 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 	}
 
 	thread->name = namep;
+	thread->fp = fp;
+	thread->argp = argp;
+	thread->wakeups = 0;
+	thread->max_blocked_us = 0;
 
-	void *(*thr_func)(void *) = (void *) fp;
-
-	int ret = pthread_create(&thread->thread, &attr, thr_func, argp);
+	int ret = pthread_create(&thread->thread, &attr, thread_trampoline,
+			thread);
 
 	if (ret) {
 		printf("Couldn't start thr (%s) ret=%d\n", namep, ret);
@@ -120,6 +184,8 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 		return NULL;
 	}
 
+	thread_cpu_clock_init(thread);
+
 #ifdef __linux__
 	pthread_setname_np(thread->thread, thread->name);
 #endif
@@ -234,6 +300,8 @@ void PIOS_Thread_Sleep(uint32_t time_ms)
 		}
 	}
 
+	uint32_t block = PIOS_Thread_Block_Begin();
+
 	if (fake_clock) {
 		pthread_mutex_lock(&fake_clock_mutex);
 
@@ -245,11 +313,17 @@ void PIOS_Thread_Sleep(uint32_t time_ms)
 		}
 
 		pthread_mutex_unlock(&fake_clock_mutex);
+	} else {
+		struct timespec remaining = {
+			.tv_sec = time_ms / 1000,
+			.tv_nsec = (time_ms % 1000) * 1000000,
+		};
 
-		return;
+		/* Profiling signals interrupt the sleep; finish it */
+		while (nanosleep(&remaining, &remaining) && (errno == EINTR));
 	}
 
-	usleep(1000 * time_ms);
+	PIOS_Thread_Block_End(block);
 }
 
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms)
@@ -273,9 +347,82 @@ uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 	return 0;	/* XXX */
 }
 
+/**
+ * Returns the CPU time used by a thread since the previous call, in
+ * microseconds; the same unit as PIOS_DELAY_GetRaw() here.
+ */
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp)
 {
-	return 0;	/* XXX */
+	uint64_t now = thread_cpu_ns(threadp);
+	uint32_t result = (now - threadp->cpu_ns_last) / 1000;
+
+	threadp->cpu_ns_last = now;
+
+	return result;
+}
+
+bool PIOS_Thread_Get_Stats(struct pios_thread *threadp,
+		struct pios_thread_stats *stats)
+{
+	stats->runtime_us = PIOS_Thread_Get_Runtime(threadp);
+	stats->wakeups = __atomic_exchange_n(&threadp->wakeups, 0,
+			__ATOMIC_RELAXED);
+	stats->max_blocked_us = __atomic_exchange_n(&threadp->max_blocked_us,
+			0, __ATOMIC_RELAXED);
+
+	return true;
+}
+
+uintptr_t PIOS_Thread_Get_Id(struct pios_thread *threadp)
+{
+	return (uintptr_t) threadp;
+}
+
+/**
+ * Identifies the calling thread; safe to use from signal handlers.  Threads
+ * not created or wrapped by PiOS give 0.
+ */
+uintptr_t PIOS_Thread_Current_Id(void)
+{
+	return (uintptr_t) current_thread;
+}
+
+/**
+ * Mark the start of a wait of the calling thread.
+ * @returns timestamp to pass to PIOS_Thread_Block_End()
+ */
+uint32_t PIOS_Thread_Block_Begin(void)
+{
+	struct timespec monotime;
+
+	clock_gettime(CLOCK_MONOTONIC, &monotime);
+
+	return monotime.tv_sec * 1000000 + monotime.tv_nsec / 1000;
+}
+
+/**
+ * Account a finished wait of the calling thread as a wakeup.  Threads not
+ * created or wrapped by PiOS are not tracked.
+ * @param[in] begin timestamp from PIOS_Thread_Block_Begin()
+ */
+void PIOS_Thread_Block_End(uint32_t begin)
+{
+	struct pios_thread *thread = current_thread;
+
+	if (!thread) {
+		return;
+	}
+
+	uint32_t blocked = PIOS_Thread_Block_Begin() - begin;
+	uint32_t prev = __atomic_load_n(&thread->max_blocked_us,
+			__ATOMIC_RELAXED);
+
+	while (blocked > prev &&
+			!__atomic_compare_exchange_n(&thread->max_blocked_us,
+				&prev, blocked, true, __ATOMIC_RELAXED,
+				__ATOMIC_RELAXED));
+
+	__atomic_fetch_add(&thread->wakeups, 1, __ATOMIC_RELAXED);
 }
 
 bool PIOS_Thread_Period_Elapsed(const uint32_t prev_systime,
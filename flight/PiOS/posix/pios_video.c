@@ -0,0 +1,161 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_VIDEO Code for OSD video generator
+ * @{
+ *
+ * @file       pios_video.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      OSD frame buffers for rendering on the host.  Frames can be
+ *             written out as images instead of being clocked out to video.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "pios_config.h"
+
+#if defined(PIOS_INCLUDE_VIDEO)
+
+#include "pios.h"
+#include "pios_video.h"
+
+#include <stdio.h>
+
+static const struct pios_video_type_boundary pios_video_type_boundary_ntsc = {
+	.graphics_right  = 351,         // must be: graphics_width_real - 1
+	.graphics_bottom = 239,         // must be: graphics_height_real - 1
+};
+
+static const struct pios_video_type_boundary pios_video_type_boundary_pal = {
+	.graphics_right  = 359,         // must be: graphics_width_real - 1
+	.graphics_bottom = 265,         // must be: graphics_height_real - 1
+};
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+static uint8_t buffer0_level[BUFFER_HEIGHT * BUFFER_WIDTH];
+static uint8_t buffer0_mask[BUFFER_HEIGHT * BUFFER_WIDTH];
+static uint8_t buffer1_level[BUFFER_HEIGHT * BUFFER_WIDTH];
+static uint8_t buffer1_mask[BUFFER_HEIGHT * BUFFER_WIDTH];
+
+uint8_t *draw_buffer_level = buffer0_level;
+uint8_t *draw_buffer_mask = buffer0_mask;
+uint8_t *disp_buffer_level = buffer1_level;
+uint8_t *disp_buffer_mask = buffer1_mask;
+#else
+static uint8_t buffer0[BUFFER_HEIGHT * BUFFER_WIDTH];
+static uint8_t buffer1[BUFFER_HEIGHT * BUFFER_WIDTH];
+
+uint8_t *draw_buffer = buffer0;
+uint8_t *disp_buffer = buffer1;
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
+const struct pios_video_type_boundary *pios_video_type_boundary_act = &pios_video_type_boundary_pal;
+
+static enum pios_video_system video_system_act = PIOS_VIDEO_SYSTEM_PAL;
+
+void PIOS_Video_SetSystem(enum pios_video_system system)
+{
+	video_system_act = system;
+
+	if (system == PIOS_VIDEO_SYSTEM_NTSC) {
+		pios_video_type_boundary_act = &pios_video_type_boundary_ntsc;
+	} else {
+		pios_video_type_boundary_act = &pios_video_type_boundary_pal;
+	}
+}
+
+enum pios_video_system PIOS_Video_GetSystem(void)
+{
+	return video_system_act;
+}
+
+/**
+ * Make the draw buffer the one being displayed, as happens at vsync.
+ */
+void PIOS_Video_SwapBuffers(void)
+{
+	uint8_t *tmp;
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+	SWAP_BUFFS(tmp, disp_buffer_mask, draw_buffer_mask);
+	SWAP_BUFFS(tmp, disp_buffer_level, draw_buffer_level);
+#else
+	SWAP_BUFFS(tmp, disp_buffer, draw_buffer);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+}
+
+/* Returns 0 for transparent, 1 for black and 3 for white */
+static uint8_t get_pixel(int x, int y)
+{
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+	int addr = y * BUFFER_WIDTH + x / 8;
+	uint8_t bit = 1 << (7 - (x & 7));
+
+	return ((disp_buffer_level[addr] & bit) ? 2 : 0) |
+		((disp_buffer_mask[addr] & bit) ? 1 : 0);
+#else
+	int addr = y * BUFFER_WIDTH + x / (8 / PIOS_VIDEO_BITS_PER_PIXEL);
+
+	return (disp_buffer[addr] >> (6 - 2 * (x & 3))) & 3;
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+}
+
+/**
+ * Write the displayed frame to a binary PGM file.  Transparent pixels are
+ * mid gray.
+ * @param[in] path File to write
+ * @return 0 on success, -1 on failure
+ */
+int32_t PIOS_Video_DumpFrame(const char *path)
+{
+	FILE *f = fopen(path, "wb");
+
+	if (!f) {
+		return -1;
+	}
+
+	int width = GRAPHICS_RIGHT + 1;
+	int height = GRAPHICS_BOTTOM + 1;
+
+	fprintf(f, "P5\n%d %d\n255\n", width, height);
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			uint8_t pixel = get_pixel(x, y);
+
+			if (!(pixel & 1)) {
+				fputc(128, f);
+			} else {
+				fputc((pixel & 2) ? 255 : 0, f);
+			}
+		}
+	}
+
+	if (fclose(f)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+#endif /* PIOS_INCLUDE_VIDEO */
+
+/**
+ * @}
+ * @}
+ */
@@ -41,6 +41,11 @@
 typedef struct {
 	uint32_t lastErrorID;
 	uint32_t eventErrors;
+	uint32_t dispatched;      /** Periodic events dispatched */
+	uint32_t missedPeriods;   /** Whole periods skipped by late periodic events */
+	uint32_t latenessTotalMs; /** Sum of the lateness of periodic events */
+	uint32_t latenessMaxMs;   /** Worst lateness of a periodic event */
+	uint32_t latenessMaxID;   /** Object of the periodic event with the worst lateness, or 0 */
 } EventStats;
 
 // Public functions
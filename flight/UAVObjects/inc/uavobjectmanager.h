@@ -214,6 +214,7 @@ void UAVObjIterate(void (*iterator)(UAVObjHandle obj));
 int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue);
 uint8_t UAVObjCount();
 uint32_t UAVObjIDByIndex(uint8_t index);
+uint32_t UAVObjGetContentCRC(UAVObjHandle obj_handle);
 void UAVObjCbSetFlag(const UAVObjEvent *objEv, void *ctx, void *obj, int len);
 void UAVObjCbCopyData(const UAVObjEvent *objEv, void *ctx, void *obj, int len);
 
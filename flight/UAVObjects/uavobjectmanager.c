@@ -2177,6 +2177,42 @@ uint32_t UAVObjIDByIndex(uint8_t index)
 	return 0;
 }
 
+/**
+ * Checksum the data of all instances of an object, in instance order and in
+ * the packed form UAVTalk sends.
+ * \param[in] obj_handle The object handle
+ * \return CRC32 of the data, starting from 0xFFFFFFFF
+ */
+uint32_t UAVObjGetContentCRC(UAVObjHandle obj_handle)
+{
+	PIOS_Assert(obj_handle);
+
+	uint32_t crc = 0xFFFFFFFF;
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		crc = PIOS_CRC32_updateCRC(crc,
+				(const uint8_t *) MetaDataPtr((struct UAVOMeta *)obj_handle),
+				MetaNumBytes);
+	} else {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		InstanceHandle instEntry;
+
+		for (uint16_t instId = 0;
+				(instEntry = getInstance(obj, instId)) != NULL;
+				instId++) {
+			crc = PIOS_CRC32_updateCRC(crc, InstanceData(instEntry),
+					obj->instance_size);
+		}
+	}
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	return crc;
+}
+
 /**
  * Unblocks a throttled event-- allows it to be inserted into queues once
  * again.
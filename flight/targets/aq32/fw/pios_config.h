@@ -39,6 +39,7 @@
 #define PIOS_INCLUDE_I2C
 #define PIOS_INCLUDE_SPI
 #define PIOS_INCLUDE_FASTHEAP
+#define PIOS_INCLUDE_TLSF
 #define PIOS_INCLUDE_MAX7456
 #define PIOS_INCLUDE_WS2811
 #define PIOS_INCLUDE_DAC
@@ -48,6 +48,9 @@ enum bl_commands {
 	BL_MSG_STATUS_REQ,
 	BL_MSG_STATUS_REP,
 	BL_MSG_WIPE_PARTITION,
+	BL_MSG_SECTOR_CRC_REQ,
+	BL_MSG_SECTOR_CRC_REP,
+	BL_MSG_WRITE_SPARSE_START,
 
 	BL_MSG_WRITE_START = 0x27,
 };
@@ -74,85 +77,117 @@ enum dfu_partition_label {
 #pragma pack(push)  /* push current alignment to stack */
 #pragma pack(1)     /* set alignment to 1 byte boundary */
 
-struct bl_messages {
-	uint8_t flags_command;
+struct msg_capabilities_req {
+	uint8_t unused[4];
+	uint8_t device_number;
+};
 
-	union {
-		struct msg_capabilities_req {
-			uint8_t unused[4];
-			uint8_t device_number;
-		} cap_req;
-
-		struct msg_capabilities_rep_all {
-			uint8_t unused[4];
-			uint16_t number_of_devices;
-			uint16_t wrflags;
-		} cap_rep_all;
-
-		struct msg_capabilities_rep_specific {
-			uint32_t fw_size;
-			uint8_t device_number;
-			uint8_t bl_version;
-			uint8_t desc_size;
-			uint8_t board_rev;
-			uint32_t fw_crc;
-			uint16_t device_id;
+struct msg_capabilities_rep_all {
+	uint8_t unused[4];
+	uint16_t number_of_devices;
+	uint16_t wrflags;
+};
+
+struct msg_capabilities_rep_specific {
+	uint32_t fw_size;
+	uint8_t device_number;
+	uint8_t bl_version;
+	uint8_t desc_size;
+	uint8_t board_rev;
+	uint32_t fw_crc;
+	uint16_t device_id;
 #if defined(BL_INCLUDE_CAP_EXTENSIONS)
-			/* Extensions to original protocol */
+	/* Extensions to original protocol */
 #define BL_CAP_EXTENSION_MAGIC 0x3456
-			uint16_t cap_extension_magic;
-			uint32_t partition_sizes[10];
+	uint16_t cap_extension_magic;
+	uint32_t partition_sizes[10];
 #endif	/* BL_INCLUDE_CAP_EXTENSIONS */
-		} cap_rep_specific;
-
-		struct msg_enter_dfu {
-			uint8_t unused[4];
-			uint8_t device_number;
-		} enter_dfu;
-
-		struct msg_jump_fw {
-			uint8_t unused[4];
-			uint8_t unused2[2];
-			uint16_t safe_word;
-		} jump_fw;
-
-		struct msg_reset {
-			/* No subfields */
-		} reset;
-
-		struct msg_op_abort {
-			/* No subfields */
-		} op_abort;
-
-		struct msg_op_end {
-			/* No subfields */
-		} op_end;
-
-		struct msg_xfer_start {
-			uint32_t packets_in_transfer;
-			enum dfu_partition_label label;
-			uint8_t words_in_last_packet;
-			uint32_t expected_crc; /* only used in writes */
-		} xfer_start;
+};
+
+struct msg_enter_dfu {
+	uint8_t unused[4];
+	uint8_t device_number;
+};
+
+struct msg_jump_fw {
+	uint8_t unused[4];
+	uint8_t unused2[2];
+	uint16_t safe_word;
+};
+
+struct msg_reset {
+	/* No subfields */
+};
+
+struct msg_op_abort {
+	/* No subfields */
+};
+
+struct msg_op_end {
+	/* No subfields */
+};
+
+struct msg_xfer_start {
+	uint32_t packets_in_transfer;
+	enum dfu_partition_label label;
+	uint8_t words_in_last_packet;
+	uint32_t expected_crc; /* only used in writes */
+};
 
 #define XFER_BYTES_PER_PACKET 56
-		struct msg_xfer_cont {
-			uint32_t current_packet_number;
-			uint8_t data[XFER_BYTES_PER_PACKET];
-		} xfer_cont;
-
-		struct msg_status_req {
-			/* No subfields */
-		} status_req;
-
-		struct msg_status_rep {
-			uint32_t unused;
-			uint8_t current_state;
-		} status_rep;
-
-		struct msg_wipe_partition {
-			enum dfu_partition_label label;
-		} wipe_partition;
+struct msg_xfer_cont {
+	uint32_t current_packet_number; /* byte offset in sparse writes */
+	uint8_t data[XFER_BYTES_PER_PACKET];
+};
+
+struct msg_status_req {
+	/* No subfields */
+};
+
+struct msg_status_rep {
+	uint32_t unused;
+	uint8_t current_state;
+};
+
+struct msg_wipe_partition {
+	enum dfu_partition_label label;
+};
+
+struct msg_sector_crc_req {
+	enum dfu_partition_label label;
+};
+
+#define SECTOR_CRCS_PER_PACKET 7
+struct msg_sector_crc_rep {
+	enum dfu_partition_label label;
+	uint8_t num_sectors;	/* entries used in this packet */
+	uint16_t first_sector;	/* sector of the first entry */
+	uint16_t total_sectors;	/* sectors in the partition */
+	struct {
+		uint32_t size;
+		uint32_t crc;
+	} sectors[SECTOR_CRCS_PER_PACKET];
+};
+
+struct bl_messages {
+	uint8_t flags_command;
+
+	union {
+		struct msg_capabilities_req cap_req;
+		struct msg_capabilities_rep_all cap_rep_all;
+		struct msg_capabilities_rep_specific cap_rep_specific;
+		struct msg_enter_dfu enter_dfu;
+		struct msg_jump_fw jump_fw;
+		struct msg_reset reset;
+		struct msg_op_abort op_abort;
+		struct msg_op_end op_end;
+		struct msg_xfer_start xfer_start;
+		struct msg_xfer_cont xfer_cont;
+		struct msg_status_req status_req;
+		struct msg_status_rep status_rep;
+		struct msg_wipe_partition wipe_partition;
+		struct msg_sector_crc_req sector_crc_req;
+		struct msg_sector_crc_rep sector_crc_rep;
 
 		uint8_t pad[62];
 	} __attribute__((aligned(1)))v;
@@ -65,6 +65,12 @@ static uint32_t bl_compute_partition_crc(uintptr_t partition_id, uint32_t partit
 
 bool bl_xfer_completed_p(const struct xfer_state * xfer)
 {
+	if (xfer->in_progress && xfer->sparse) {
+		/* Only the host knows which packets it meant to send; the CRC
+		 * check covers the whole range. */
+		return true;
+	}
+
 	return (xfer->in_progress && (xfer->bytes_to_xfer == 0));
 }
 
@@ -138,6 +144,7 @@ bool bl_xfer_read_start(struct xfer_state * xfer, const struct msg_xfer_start *x
 	if (bytes_to_xfer > (xfer->partition_size - xfer->original_partition_offset))
 		bytes_to_xfer = xfer->partition_size - xfer->original_partition_offset;
 
+	xfer->sparse = false;
 	xfer->current_partition_offset = xfer->original_partition_offset;
 	xfer->bytes_to_xfer = bytes_to_xfer;
 	xfer->next_packet_number = 0;
@@ -186,22 +193,24 @@ bool bl_xfer_send_next_read_packet(struct xfer_state * xfer)
 	return true;
 }
 
-bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start)
+/**
+ * Select the flash range that a write to a DFU partition covers.
+ * @param[out] xfer transfer state; the partition, range and CRC check are filled in
+ * @param[in] label DFU partition to write
+ * @param[out] needs_erase whether the range is erased before it is written
+ * @returns false if the partition can't be written
+ */
+static bool bl_xfer_select_write_partition(struct xfer_state * xfer, enum dfu_partition_label label, bool *needs_erase)
 {
-	/* Disable any previous transfer */
-	xfer->in_progress = false;
-
 	/* Recover a pointer to the bootloader board info blob */
 	const struct pios_board_info * bdinfo = &pios_board_info_blob;
 
-	/* Set up the transfer */
-	bool partition_needs_erase = true;
+	*needs_erase = true;
 
 	xfer->check_crc = true;
-	xfer->crc  = BE32_TO_CPU(xfer_start->expected_crc);
 	xfer->original_partition_offset = 0;
 
-	switch (xfer_start->label) {
+	switch (label) {
 #ifdef F1_UPGRADER
 	case DFU_PARTITION_BL:
 		PIOS_FLASH_find_partition_id(FLASH_PARTITION_LABEL_BL, &xfer->partition_id);
@@ -219,7 +228,7 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 		PIOS_FLASH_get_partition_size(xfer->partition_id, &xfer->partition_size);
 		xfer->original_partition_offset = bdinfo->desc_base - bdinfo->fw_base;
 		xfer->check_crc        = false;
-		partition_needs_erase  = false;
+		*needs_erase           = false;
 		break;
 	case DFU_PARTITION_SETTINGS:
 		PIOS_FLASH_find_partition_id(FLASH_PARTITION_LABEL_SETTINGS, &xfer->partition_id);
@@ -241,6 +250,29 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 		return false;
 	}
 
+	return true;
+}
+
+static bool bl_xfer_start_write(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start, bool sparse)
+{
+	/* Disable any previous transfer */
+	xfer->in_progress = false;
+
+	/* Set up the transfer */
+	bool partition_needs_erase;
+
+	if (!bl_xfer_select_write_partition(xfer, xfer_start->label, &partition_needs_erase)) {
+		return false;
+	}
+
+	xfer->crc  = BE32_TO_CPU(xfer_start->expected_crc);
+
+	/* Sparse writes erase sector by sector, so they only make sense
+	 * where the whole range would otherwise be erased */
+	if (sparse && !partition_needs_erase) {
+		return false;
+	}
+
 	/* How many bytes is the host trying to transfer? */
 	uint32_t bytes_to_xfer = (BE32_TO_CPU(xfer_start->packets_in_transfer) - 1) * XFER_BYTES_PER_PACKET +
 		xfer_start->words_in_last_packet * sizeof(uint32_t);
@@ -251,7 +283,7 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 	}
 
 	/* Figure out if we need to erase the *selected* partition before writing to it */
-	if (partition_needs_erase) {
+	if (partition_needs_erase && !sparse) {
 		PIOS_FLASH_start_transaction(xfer->partition_id);
 		int32_t ret = PIOS_FLASH_erase_partition(xfer->partition_id);
 		PIOS_FLASH_end_transaction(xfer->partition_id);
@@ -259,6 +291,8 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 			return false;
 	}
 
+	xfer->sparse = sparse;
+	xfer->erased_offset = xfer->original_partition_offset;
 	xfer->current_partition_offset = xfer->original_partition_offset;
 	xfer->bytes_to_xfer = bytes_to_xfer;
 	xfer->next_packet_number = 0;
@@ -267,6 +301,67 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 	return true;
 }
 
+bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start)
+{
+	return bl_xfer_start_write(xfer, xfer_start, false);
+}
+
+/**
+ * Start a write that only touches some sectors.  Each packet carries its
+ * offset in the transfer instead of a sequence number; offsets must
+ * increase.  The first packet in a sector must start at the beginning of
+ * the sector, which is erased before it is written.  Sectors that get no
+ * packets keep their contents, and bytes that get no packets in an erased
+ * sector are left erased.
+ */
+bool bl_xfer_write_sparse_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start)
+{
+	return bl_xfer_start_write(xfer, xfer_start, true);
+}
+
+/**
+ * Move a sparse write to the offset of the next packet, erasing the sector
+ * if this is the first packet in it.
+ */
+static bool bl_xfer_sparse_seek(struct xfer_state * xfer, uint32_t xfer_offset)
+{
+	uint32_t end_offset = xfer->current_partition_offset + xfer->bytes_to_xfer;
+	uint32_t offset = xfer->original_partition_offset + xfer_offset;
+
+	if ((offset < xfer->current_partition_offset) || (offset >= end_offset) ||
+			(offset % sizeof(uint32_t))) {
+		/* packet is out of sequence or out of range */
+		return false;
+	}
+
+	if (offset >= xfer->erased_offset) {
+		uint32_t sector_offset;
+		uint32_t sector_size;
+
+		if (PIOS_FLASH_get_sector(xfer->partition_id, offset, &sector_offset, &sector_size) != 0) {
+			return false;
+		}
+
+		if (sector_offset != offset) {
+			/* Rest of the sector would be lost in the erase */
+			return false;
+		}
+
+		PIOS_FLASH_start_transaction(xfer->partition_id);
+		int32_t ret = PIOS_FLASH_erase_range(xfer->partition_id, sector_offset, sector_size);
+		PIOS_FLASH_end_transaction(xfer->partition_id);
+		if (ret != 0)
+			return false;
+
+		xfer->erased_offset = sector_offset + sector_size;
+	}
+
+	xfer->current_partition_offset = offset;
+	xfer->bytes_to_xfer            = end_offset - offset;
+
+	return true;
+}
+
 bool bl_xfer_write_cont(struct xfer_state * xfer, const struct msg_xfer_cont *xfer_cont)
 {
 	if (!xfer->in_progress) {
@@ -274,13 +369,22 @@ bool bl_xfer_write_cont(struct xfer_state * xfer, const struct msg_xfer_cont *xf
 		return false;
 	}
 
-	if (BE32_TO_CPU(xfer_cont->current_packet_number) != xfer->next_packet_number) {
+	if (xfer->sparse) {
+		if (!bl_xfer_sparse_seek(xfer, BE32_TO_CPU(xfer_cont->current_packet_number))) {
+			return false;
+		}
+	} else if (BE32_TO_CPU(xfer_cont->current_packet_number) != xfer->next_packet_number) {
 		/* packet is out of sequence */
 		return false;
 	}
 
 	uint32_t bytes_this_xfer = MIN(XFER_BYTES_PER_PACKET, xfer->bytes_to_xfer);
 
+	if (xfer->sparse) {
+		/* Packets don't cross into sectors that haven't been erased */
+		bytes_this_xfer = MIN(bytes_this_xfer, xfer->erased_offset - xfer->current_partition_offset);
+	}
+
 	if (bytes_this_xfer == 0) {
 		/* Not expecting any more bytes. We shouldn't be in this function at all */
 		return false;
@@ -351,6 +455,70 @@ bool bl_xfer_wipe_partition(const struct msg_wipe_partition *wipe_partition)
 	return true;
 }
 
+/**
+ * Send the CRC of each sector that a write to a partition covers, several
+ * sectors per packet.  Sectors are CRCed separately, the same way as a whole
+ * transfer, over the part of the sector inside the write range.
+ */
+bool bl_xfer_send_sector_crcs(const struct msg_sector_crc_req *sector_crc_req)
+{
+	struct xfer_state xfer;
+	bool needs_erase;
+
+	if (!bl_xfer_select_write_partition(&xfer, sector_crc_req->label, &needs_erase) ||
+			!needs_erase) {
+		return false;
+	}
+
+	uint32_t end_offset = xfer.partition_size;
+	uint32_t sector_offset;
+	uint32_t sector_size;
+
+	/* Count the sectors first; every packet carries the total */
+	uint16_t total_sectors = 0;
+	for (uint32_t offset = xfer.original_partition_offset; offset < end_offset;
+			offset = sector_offset + sector_size) {
+		if (PIOS_FLASH_get_sector(xfer.partition_id, offset, &sector_offset, &sector_size) != 0) {
+			return false;
+		}
+
+		total_sectors++;
+	}
+
+	struct bl_messages msg = {
+		.flags_command = BL_MSG_SECTOR_CRC_REP,
+		.v.sector_crc_rep = {
+			.label         = sector_crc_req->label,
+			.total_sectors = CPU_TO_BE16(total_sectors),
+		},
+	};
+
+	uint16_t sector = 0;
+	for (uint32_t offset = xfer.original_partition_offset; offset < end_offset;
+			offset = sector_offset + sector_size) {
+		PIOS_FLASH_get_sector(xfer.partition_id, offset, &sector_offset, &sector_size);
+
+		uint32_t crc = bl_compute_partition_crc(xfer.partition_id, sector_offset,
+				MIN(sector_size, end_offset - sector_offset));
+
+		uint8_t entry = sector % SECTOR_CRCS_PER_PACKET;
+
+		msg.v.sector_crc_rep.sectors[entry].size = CPU_TO_BE32(sector_size);
+		msg.v.sector_crc_rep.sectors[entry].crc  = CPU_TO_BE32(crc);
+
+		sector++;
+
+		if ((entry == SECTOR_CRCS_PER_PACKET - 1) || (sector == total_sectors)) {
+			msg.v.sector_crc_rep.first_sector = CPU_TO_BE16(sector - entry - 1);
+			msg.v.sector_crc_rep.num_sectors  = entry + 1;
+
+			PIOS_COM_MSG_Send(PIOS_COM_TELEM_USB, (uint8_t *)&msg, sizeof(msg));
+		}
+	}
+
+	return true;
+}
+
 bool bl_xfer_send_capabilities_self(void)
 {
 	/* Return capabilities of the specific device */
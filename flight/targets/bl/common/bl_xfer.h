@@ -43,6 +43,9 @@ struct xfer_state {
 	bool     check_crc;
 	uint32_t crc;
 
+	bool     sparse;
+	uint32_t erased_offset;
+
 	uint32_t bytes_to_xfer;
 };
 
@@ -51,8 +54,10 @@ extern bool bl_xfer_crc_ok_p(const struct xfer_state * xfer);
 extern bool bl_xfer_read_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start);
 extern bool bl_xfer_send_next_read_packet(struct xfer_state * xfer);
 extern bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start);
+extern bool bl_xfer_write_sparse_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start);
 extern bool bl_xfer_write_cont(struct xfer_state * xfer, const struct msg_xfer_cont *xfer_cont);
 extern bool bl_xfer_wipe_partition(const struct msg_wipe_partition *wipe_partition);
+extern bool bl_xfer_send_sector_crcs(const struct msg_sector_crc_req *sector_crc_req);
 extern bool bl_xfer_send_capabilities_self(void);
 
 #endif	/* BL_XFER_H_ */
@@ -45,6 +45,7 @@
 #define PIOS_INCLUDE_SPI
 #define PIOS_INCLUDE_HPWM
 #define PIOS_INCLUDE_TBSVTXCONFIG
+#define PIOS_INCLUDE_TLSF
 
 /* Select the sensors to include */
 #define PIOS_INCLUDE_BMI160
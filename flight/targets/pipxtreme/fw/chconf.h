@@ -485,7 +485,10 @@ typedef uint32_t halrtcnt_t;
 #if !defined(THREAD_EXT_FIELDS) || defined(__DOXYGEN__)
 #define THREAD_EXT_FIELDS                                                   \
   halrtcnt_t ticks_switched_in;                                             \
+  halrtcnt_t ticks_switched_out;                                            \
   halrtcnt_t ticks_total;                                                   \
+  halrtcnt_t ticks_blocked_max;                                             \
+  uint32_t wakeups;                                                         \
   /* Add threads custom fields here.*/
 #endif
 
@@ -498,7 +501,11 @@ typedef uint32_t halrtcnt_t;
  */
 #if !defined(THREAD_EXT_INIT_HOOK) || defined(__DOXYGEN__)
 #define THREAD_EXT_INIT_HOOK(tp) {                                          \
-  /* Add threads initialization code here.*/                                \
+  tp->ticks_switched_in = halGetCounterValue();                             \
+  tp->ticks_switched_out = tp->ticks_switched_in;                           \
+  tp->ticks_total = 0;                                                      \
+  tp->ticks_blocked_max = 0;                                                \
+  tp->wakeups = 0;                                                          \
 }
 #endif
 
@@ -524,6 +531,12 @@ typedef uint32_t halrtcnt_t;
 #define THREAD_CONTEXT_SWITCH_HOOK(ntp, otp) {                              \
   ntp->ticks_switched_in = halGetCounterValue();                            \
   otp->ticks_total += ntp->ticks_switched_in - otp->ticks_switched_in;      \
+  otp->ticks_switched_out = ntp->ticks_switched_in;                         \
+  if (ntp->ticks_switched_in - ntp->ticks_switched_out >                    \
+      ntp->ticks_blocked_max)                                               \
+    ntp->ticks_blocked_max = ntp->ticks_switched_in -                       \
+      ntp->ticks_switched_out;                                              \
+  ntp->wakeups++;                                                           \
   /* System halt code here.*/                                               \
 }
 #endif
@@ -546,7 +559,10 @@ typedef uint32_t halrtcnt_t;
  */
 #if !defined(SYSTEM_TICK_EVENT_HOOK) || defined(__DOXYGEN__)
 #define SYSTEM_TICK_EVENT_HOOK() {                                          \
-  /* System tick event code here.*/                                         \
+  /* Only linked in when the sampling profiler is built */                  \
+  extern void PIOS_Profiler_Tick_FromISR(void) __attribute__((weak));       \
+  if (PIOS_Profiler_Tick_FromISR)                                           \
+    PIOS_Profiler_Tick_FromISR();                                           \
 }
 #endif
 
@@ -50,6 +50,7 @@
 #define PIOS_INCLUDE_WDG
 #define PIOS_INCLUDE_SPI
 #define PIOS_INCLUDE_FASTHEAP
+#define PIOS_INCLUDE_TLSF
 #define PIOS_INCLUDE_TBSVTXCONFIG
 
 /* Com systems to include */
@@ -41,6 +41,7 @@
 #define PIOS_INCLUDE_SPI
 #define PIOS_INCLUDE_CAN
 #define PIOS_INCLUDE_FASTHEAP
+#define PIOS_INCLUDE_TLSF
 
 /* Variables related to the RFM22B functionality */
 #define PIOS_INCLUDE_OPENLRS
@@ -0,0 +1,3 @@
+/* Stand-in for openpilot.h; the alarms library only needs PiOS. */
+#include <pios.h>
+#include "alarms.h"
@@ -0,0 +1,32 @@
+/* Stand-in for the generated UAVO header, with what the alarms library uses. */
+#ifndef SYSTEMALARMS_H
+#define SYSTEMALARMS_H
+
+#include <stdint.h>
+
+typedef enum { SYSTEMALARMS_ALARM_UNINITIALISED=0, SYSTEMALARMS_ALARM_OK=1, SYSTEMALARMS_ALARM_WARNING=2, SYSTEMALARMS_ALARM_ERROR=3, SYSTEMALARMS_ALARM_CRITICAL=4 } __attribute__((packed)) SystemAlarmsAlarmOptions;
+/* The options come from SharedDefs.AlarmLevels, which has two more */
+#define SYSTEMALARMS_ALARM_GLOBAL_MAXOPTVAL 6
+typedef enum { SYSTEMALARMS_ALARM_OUTOFMEMORY=0, SYSTEMALARMS_ALARM_CPUOVERLOAD=1, SYSTEMALARMS_ALARM_STACKOVERFLOW=2, SYSTEMALARMS_ALARM_SYSTEMCONFIGURATION=3, SYSTEMALARMS_ALARM_EVENTSYSTEM=4, SYSTEMALARMS_ALARM_TELEMETRY=5, SYSTEMALARMS_ALARM_MANUALCONTROL=6, SYSTEMALARMS_ALARM_ACTUATOR=7, SYSTEMALARMS_ALARM_ATTITUDE=8, SYSTEMALARMS_ALARM_SENSORS=9, SYSTEMALARMS_ALARM_STABILIZATION=10, SYSTEMALARMS_ALARM_GEOFENCE=11, SYSTEMALARMS_ALARM_PATHFOLLOWER=12, SYSTEMALARMS_ALARM_PATHPLANNER=13, SYSTEMALARMS_ALARM_BATTERY=14, SYSTEMALARMS_ALARM_FLIGHTTIME=15, SYSTEMALARMS_ALARM_I2C=16, SYSTEMALARMS_ALARM_GPS=17, SYSTEMALARMS_ALARM_ALTITUDEHOLD=18, SYSTEMALARMS_ALARM_BOOTFAULT=19, SYSTEMALARMS_ALARM_TEMPBARO=20, SYSTEMALARMS_ALARM_GYROBIAS=21, SYSTEMALARMS_ALARM_ADC=22, SYSTEMALARMS_ALARM_GIMBAL=23 } __attribute__((packed)) SystemAlarmsAlarmElem;
+#define SYSTEMALARMS_ALARM_NUMELEM 24
+
+typedef enum { SYSTEMALARMS_CONFIGERROR_STABILIZATION=0, SYSTEMALARMS_CONFIGERROR_MULTIROTOR=1, SYSTEMALARMS_CONFIGERROR_AUTOTUNE=2, SYSTEMALARMS_CONFIGERROR_ALTITUDEHOLD=3, SYSTEMALARMS_CONFIGERROR_POSITIONHOLD=4, SYSTEMALARMS_CONFIGERROR_PATHPLANNER=5, SYSTEMALARMS_CONFIGERROR_DUPLICATEPORTCFG=6, SYSTEMALARMS_CONFIGERROR_NAVFILTER=7, SYSTEMALARMS_CONFIGERROR_UNSAFETOARM=8, SYSTEMALARMS_CONFIGERROR_LQG=9, SYSTEMALARMS_CONFIGERROR_UNDEFINED=10, SYSTEMALARMS_CONFIGERROR_NONE=11 } __attribute__((packed)) SystemAlarmsConfigErrorOptions;
+typedef enum { SYSTEMALARMS_MANUALCONTROL_SETTINGS=0, SYSTEMALARMS_MANUALCONTROL_NORX=1, SYSTEMALARMS_MANUALCONTROL_ACCESSORY=2, SYSTEMALARMS_MANUALCONTROL_ALTITUDEHOLD=3, SYSTEMALARMS_MANUALCONTROL_PATHFOLLOWER=4, SYSTEMALARMS_MANUALCONTROL_CHANNELCONFIGURATION=5, SYSTEMALARMS_MANUALCONTROL_UNDEFINED=6, SYSTEMALARMS_MANUALCONTROL_NONE=7 } __attribute__((packed)) SystemAlarmsManualControlOptions;
+typedef enum { SYSTEMALARMS_STATEESTIMATION_GYROQUEUENOTUPDATING=0, SYSTEMALARMS_STATEESTIMATION_ACCELEROMETERQUEUENOTUPDATING=1, SYSTEMALARMS_STATEESTIMATION_NOGPS=2, SYSTEMALARMS_STATEESTIMATION_NOMAGNETOMETER=3, SYSTEMALARMS_STATEESTIMATION_NOBAROMETER=4, SYSTEMALARMS_STATEESTIMATION_NOHOME=5, SYSTEMALARMS_STATEESTIMATION_TOOFEWSATELLITES=6, SYSTEMALARMS_STATEESTIMATION_PDOPTOOHIGH=7, SYSTEMALARMS_STATEESTIMATION_UNDEFINED=8, SYSTEMALARMS_STATEESTIMATION_NONE=9 } __attribute__((packed)) SystemAlarmsStateEstimationOptions;
+typedef enum { SYSTEMALARMS_REBOOTCAUSE_BROWNOUT=0, SYSTEMALARMS_REBOOTCAUSE_PINRESET=1, SYSTEMALARMS_REBOOTCAUSE_POWERONRESET=2, SYSTEMALARMS_REBOOTCAUSE_SOFTWARERESET=3, SYSTEMALARMS_REBOOTCAUSE_INDEPENDENTWATCHDOG=4, SYSTEMALARMS_REBOOTCAUSE_WINDOWWATCHDOG=5, SYSTEMALARMS_REBOOTCAUSE_LOWPOWER=6, SYSTEMALARMS_REBOOTCAUSE_UNDEFINED=7 } __attribute__((packed)) SystemAlarmsRebootCauseOptions;
+
+typedef struct {
+	uint8_t Alarm[SYSTEMALARMS_ALARM_NUMELEM];
+	uint8_t ConfigError;
+	uint8_t ManualControl;
+	uint8_t StateEstimation;
+	uint8_t RebootCause;
+} SystemAlarmsData;
+
+int32_t SystemAlarmsInitialize(void);
+int32_t SystemAlarmsGet(SystemAlarmsData *data);
+int32_t SystemAlarmsSet(SystemAlarmsData *data);
+void SystemAlarmsAlarmSet(uint8_t *NewAlarm);
+void SystemAlarmsRebootCauseSet(uint8_t *NewRebootCause);
+
+#endif /* SYSTEMALARMS_H */
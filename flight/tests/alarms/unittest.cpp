@@ -0,0 +1,301 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <pthread.h>		/* pthread_* */
+
+extern "C" {
+#include "openpilot.h"
+#include "unittest_mocks.h"
+}
+
+/* Calls per benchmark */
+#define BENCH_CALLS 1000000
+
+/* How AlarmsSet and AlarmsHasErrors used to work, for comparison */
+static pthread_mutex_t legacy_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int32_t legacy_set(SystemAlarmsAlarmElem alarm,
+		SystemAlarmsAlarmOptions severity)
+{
+	SystemAlarmsData alarms;
+
+	pthread_mutex_lock(&legacy_lock);
+
+	SystemAlarmsGet(&alarms);
+	if (alarms.Alarm[alarm] != severity) {
+		alarms.Alarm[alarm] = severity;
+		SystemAlarmsSet(&alarms);
+	}
+
+	pthread_mutex_unlock(&legacy_lock);
+
+	return 0;
+}
+
+static int32_t legacy_has_errors()
+{
+	SystemAlarmsData alarms;
+
+	pthread_mutex_lock(&legacy_lock);
+	SystemAlarmsGet(&alarms);
+	pthread_mutex_unlock(&legacy_lock);
+
+	for (int n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; n++) {
+		if (alarms.Alarm[n] >= SYSTEMALARMS_ALARM_ERROR) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Check the counters behind AlarmsHas* against the alarms themselves */
+static void expect_counts_consistent()
+{
+	int worst = 0;
+
+	for (int n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; n++) {
+		worst = std::max(worst, (int) AlarmsGet((SystemAlarmsAlarmElem) n));
+	}
+
+	EXPECT_EQ(worst >= SYSTEMALARMS_ALARM_WARNING, AlarmsHasWarnings());
+	EXPECT_EQ(worst >= SYSTEMALARMS_ALARM_ERROR, AlarmsHasErrors());
+	EXPECT_EQ(worst >= SYSTEMALARMS_ALARM_CRITICAL, AlarmsHasCritical());
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class Alarms : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+    AlarmsInitialize();
+    AlarmsClearAll();
+    AlarmsPublish();
+    mock_uavos_reset();
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(Alarms, Initialize) {
+  SystemAlarmsData alarms;
+
+  AlarmsInitialize();
+  SystemAlarmsGet(&alarms);
+
+  /* The posix reset reason */
+  EXPECT_EQ(SYSTEMALARMS_REBOOTCAUSE_SOFTWARERESET, alarms.RebootCause);
+}
+
+TEST_F(Alarms, SetIsDeferred) {
+  EXPECT_EQ(0, AlarmsSet(SYSTEMALARMS_ALARM_GPS, SYSTEMALARMS_ALARM_WARNING));
+
+  /* Readers through the library see it at once */
+  EXPECT_EQ(SYSTEMALARMS_ALARM_WARNING, AlarmsGet(SYSTEMALARMS_ALARM_GPS));
+  EXPECT_EQ(1, AlarmsHasWarnings());
+  EXPECT_EQ(0, AlarmsHasErrors());
+
+  /* SystemAlarms only when published */
+  EXPECT_EQ(0u, mock_systemalarms_sets);
+
+  AlarmsPublish();
+  EXPECT_EQ(1u, mock_systemalarms_sets);
+  EXPECT_EQ(SYSTEMALARMS_ALARM_WARNING,
+      mock_systemalarms.Alarm[SYSTEMALARMS_ALARM_GPS]);
+  EXPECT_EQ(SYSTEMALARMS_ALARM_OK,
+      mock_systemalarms.Alarm[SYSTEMALARMS_ALARM_SENSORS]);
+
+  /* Nothing changed, nothing published */
+  AlarmsPublish();
+  AlarmsSet(SYSTEMALARMS_ALARM_GPS, SYSTEMALARMS_ALARM_WARNING);
+  AlarmsPublish();
+  EXPECT_EQ(1u, mock_systemalarms_sets);
+}
+
+TEST_F(Alarms, Coalesces) {
+  for (int i = 0; i < 1000; i++) {
+    AlarmsSet(SYSTEMALARMS_ALARM_ATTITUDE,
+        (i & 1) ? SYSTEMALARMS_ALARM_ERROR : SYSTEMALARMS_ALARM_WARNING);
+    AlarmsSet(SYSTEMALARMS_ALARM_SENSORS, SYSTEMALARMS_ALARM_CRITICAL);
+  }
+
+  AlarmsPublish();
+  EXPECT_EQ(1u, mock_systemalarms_sets);
+  EXPECT_EQ(SYSTEMALARMS_ALARM_ERROR,
+      mock_systemalarms.Alarm[SYSTEMALARMS_ALARM_ATTITUDE]);
+  EXPECT_EQ(SYSTEMALARMS_ALARM_CRITICAL,
+      mock_systemalarms.Alarm[SYSTEMALARMS_ALARM_SENSORS]);
+}
+
+TEST_F(Alarms, Invalid) {
+  EXPECT_EQ(-1, AlarmsSet((SystemAlarmsAlarmElem) SYSTEMALARMS_ALARM_NUMELEM, SYSTEMALARMS_ALARM_OK));
+  EXPECT_EQ(-1, AlarmsSet(SYSTEMALARMS_ALARM_GPS,
+        (SystemAlarmsAlarmOptions) (SYSTEMALARMS_ALARM_GLOBAL_MAXOPTVAL + 1)));
+  EXPECT_EQ(0, AlarmsGet((SystemAlarmsAlarmElem) SYSTEMALARMS_ALARM_NUMELEM));
+
+  AlarmsPublish();
+  EXPECT_EQ(0u, mock_systemalarms_sets);
+}
+
+TEST_F(Alarms, SeverityCounts) {
+  expect_counts_consistent();
+
+  AlarmsSet(SYSTEMALARMS_ALARM_GPS, SYSTEMALARMS_ALARM_WARNING);
+  AlarmsSet(SYSTEMALARMS_ALARM_BATTERY, SYSTEMALARMS_ALARM_CRITICAL);
+  expect_counts_consistent();
+
+  AlarmsClear(SYSTEMALARMS_ALARM_BATTERY);
+  expect_counts_consistent();
+  EXPECT_EQ(1, AlarmsHasWarnings());
+  EXPECT_EQ(0, AlarmsHasCritical());
+
+  AlarmsDefaultAll();
+  expect_counts_consistent();
+  EXPECT_EQ(0, AlarmsHasWarnings());
+
+  for (int i = 0; i < 10000; i++) {
+    AlarmsSet((SystemAlarmsAlarmElem) (rand() % SYSTEMALARMS_ALARM_NUMELEM),
+        (SystemAlarmsAlarmOptions) (rand() % (SYSTEMALARMS_ALARM_CRITICAL + 1)));
+
+    if (i % 100 == 0) {
+      expect_counts_consistent();
+    }
+  }
+}
+
+static void *hammer(void *arg)
+{
+  unsigned int seed = (uintptr_t) arg;
+
+  for (int i = 0; i < 100000; i++) {
+    AlarmsSet((SystemAlarmsAlarmElem) (rand_r(&seed) % SYSTEMALARMS_ALARM_NUMELEM),
+        (SystemAlarmsAlarmOptions) (rand_r(&seed) % (SYSTEMALARMS_ALARM_CRITICAL + 1)));
+
+    if (i % 1000 == 0) {
+      AlarmsPublish();
+    }
+  }
+
+  return NULL;
+}
+
+TEST_F(Alarms, Concurrent) {
+  pthread_t threads[4];
+
+  for (uintptr_t i = 0; i < 4; i++) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, hammer, (void *) (i + 1)));
+  }
+
+  for (int i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  /* Once the dust settles, the counters and SystemAlarms agree */
+  expect_counts_consistent();
+
+  AlarmsPublish();
+
+  for (int n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; n++) {
+    EXPECT_EQ(AlarmsGet((SystemAlarmsAlarmElem) n), mock_systemalarms.Alarm[n]);
+  }
+}
+
+TEST_F(Alarms, PerCallCost) {
+  volatile int32_t sink = 0;
+
+  /* A fast loop reasserting its alarm, as most calls do */
+  double start = ut_seconds();
+  for (int i = 0; i < BENCH_CALLS; i++) {
+    sink += AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION, SYSTEMALARMS_ALARM_OK);
+  }
+  double set_same = ut_seconds() - start;
+
+  start = ut_seconds();
+  for (int i = 0; i < BENCH_CALLS; i++) {
+    sink += legacy_set(SYSTEMALARMS_ALARM_STABILIZATION, SYSTEMALARMS_ALARM_OK);
+  }
+  double legacy_same = ut_seconds() - start;
+
+  /* An alarm flapping every call */
+  uint32_t sets = mock_systemalarms_sets;
+
+  start = ut_seconds();
+  for (int i = 0; i < BENCH_CALLS; i++) {
+    sink += AlarmsSet(SYSTEMALARMS_ALARM_SENSORS,
+        (i & 1) ? SYSTEMALARMS_ALARM_WARNING : SYSTEMALARMS_ALARM_OK);
+  }
+  double set_flap = ut_seconds() - start;
+
+  /* The changes wait for AlarmsPublish instead of each writing the object */
+  EXPECT_EQ(sets, mock_systemalarms_sets);
+
+  start = ut_seconds();
+  for (int i = 0; i < BENCH_CALLS; i++) {
+    sink += legacy_set(SYSTEMALARMS_ALARM_SENSORS,
+        (i & 1) ? SYSTEMALARMS_ALARM_WARNING : SYSTEMALARMS_ALARM_OK);
+  }
+  double legacy_flap = ut_seconds() - start;
+
+  start = ut_seconds();
+  for (int i = 0; i < BENCH_CALLS; i++) {
+    sink += AlarmsHasErrors();
+  }
+  double has = ut_seconds() - start;
+
+  start = ut_seconds();
+  for (int i = 0; i < BENCH_CALLS; i++) {
+    sink += legacy_has_errors();
+  }
+  double legacy_has = ut_seconds() - start;
+
+  /* Timings vary with the machine's load, so they are only printed */
+  printf("ns per call, now against mutex + whole object copies:\n"
+      "  AlarmsSet unchanged %.1f vs %.1f\n"
+      "  AlarmsSet changed   %.1f vs %.1f\n"
+      "  AlarmsHasErrors     %.1f vs %.1f\n",
+      set_same * 1e9 / BENCH_CALLS, legacy_same * 1e9 / BENCH_CALLS,
+      set_flap * 1e9 / BENCH_CALLS, legacy_flap * 1e9 / BENCH_CALLS,
+      has * 1e9 / BENCH_CALLS, legacy_has * 1e9 / BENCH_CALLS);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,62 @@
+/*
+ * Stand-ins for the UAVO accessors the alarms library calls.  Like the
+ * object manager, they take a lock around every access.
+ */
+
+#include "pios.h"
+
+#include <pthread.h>
+
+#include "systemalarms.h"
+
+#include "unittest_mocks.h"
+
+SystemAlarmsData mock_systemalarms;
+uint32_t mock_systemalarms_sets;
+
+static pthread_mutex_t uavo_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void mock_uavos_reset(void)
+{
+	pthread_mutex_lock(&uavo_lock);
+	memset(&mock_systemalarms, 0, sizeof(mock_systemalarms));
+	mock_systemalarms_sets = 0;
+	pthread_mutex_unlock(&uavo_lock);
+}
+
+int32_t SystemAlarmsInitialize(void)
+{
+	return 0;
+}
+
+int32_t SystemAlarmsGet(SystemAlarmsData *data)
+{
+	pthread_mutex_lock(&uavo_lock);
+	*data = mock_systemalarms;
+	pthread_mutex_unlock(&uavo_lock);
+	return 0;
+}
+
+int32_t SystemAlarmsSet(SystemAlarmsData *data)
+{
+	pthread_mutex_lock(&uavo_lock);
+	mock_systemalarms = *data;
+	mock_systemalarms_sets++;
+	pthread_mutex_unlock(&uavo_lock);
+	return 0;
+}
+
+void SystemAlarmsAlarmSet(uint8_t *NewAlarm)
+{
+	pthread_mutex_lock(&uavo_lock);
+	memcpy(mock_systemalarms.Alarm, NewAlarm, sizeof(mock_systemalarms.Alarm));
+	mock_systemalarms_sets++;
+	pthread_mutex_unlock(&uavo_lock);
+}
+
+void SystemAlarmsRebootCauseSet(uint8_t *NewRebootCause)
+{
+	pthread_mutex_lock(&uavo_lock);
+	mock_systemalarms.RebootCause = *NewRebootCause;
+	pthread_mutex_unlock(&uavo_lock);
+}
@@ -0,0 +1,18 @@
+/*
+ * Shared between the UAVO stand-ins and the test driver.
+ */
+
+#ifndef UNITTEST_MOCKS_H
+#define UNITTEST_MOCKS_H
+
+#include <stdint.h>
+
+#include "systemalarms.h"
+
+/* Last value published to SystemAlarms, and how many times it was set */
+extern SystemAlarmsData mock_systemalarms;
+extern uint32_t mock_systemalarms_sets;
+
+void mock_uavos_reset(void);
+
+#endif /* UNITTEST_MOCKS_H */
@@ -0,0 +1,12 @@
+/*
+ * The bootloader transfer code runs against a simulated flash and reply
+ * channel, provided by unittest_mocks.c.
+ */
+
+extern uintptr_t pios_com_telem_usb_id;
+#define PIOS_COM_TELEM_USB (pios_com_telem_usb_id)
+
+/* Software model of the STM32 CRC unit */
+void CRC_ResetDR(void);
+uint32_t CRC_CalcBlockCRC(uint32_t *buffer, uint32_t length);
+uint32_t CRC_GetCRC(void);
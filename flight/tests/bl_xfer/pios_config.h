@@ -0,0 +1,3 @@
+#define PIOS_INCLUDE_FLASH
+#define PIOS_NO_HW
+#define FLIGHT_POSIX
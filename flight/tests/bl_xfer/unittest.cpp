@@ -0,0 +1,383 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>		/* uint*_t */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+
+#include <vector>
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_flash.h"		/* PIOS_FLASH_* API */
+
+#include "bl_xfer.h"		/* bl_xfer_* */
+
+#include "unittest_mocks.h"
+
+}
+
+/* Bytes of the firmware partition a write may cover; the rest is the descriptor */
+#define FW_RANGE (SIM_FLASH_SIZE - SIM_DESC_SIZE)
+
+struct sector_crc {
+	uint32_t size;
+	uint32_t crc;
+};
+
+class BlXferTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+    memset(sim_flash_erases, 0, sizeof(sim_flash_erases));
+    sim_flash_bad_writes = 0;
+    num_sent_msgs = 0;
+
+    PIOS_FLASH_register_partition_table(sim_flash_partition_table,
+        sim_flash_partition_table_size);
+
+    memset(&xfer, 0, sizeof(xfer));
+  }
+
+  virtual void TearDown() {
+    EXPECT_EQ(0U, sim_flash_bad_writes);
+  }
+
+  static void fill_random(uint8_t *buf, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+      buf[i] = rand();
+    }
+  }
+
+  static uint32_t image_crc(const uint8_t *image, uint32_t len) {
+    return sim_crc_words(0xFFFFFFFF, (const uint32_t *)image, len / 4);
+  }
+
+  /* Same layout as the uploader's CalculatePadding */
+  static struct msg_xfer_start xfer_start_msg(enum dfu_partition_label label,
+      uint32_t bytes, uint32_t crc) {
+    struct msg_xfer_start start;
+
+    memset(&start, 0, sizeof(start));
+
+    uint32_t packets = bytes / XFER_BYTES_PER_PACKET;
+    uint32_t last_words = (bytes % XFER_BYTES_PER_PACKET) / 4;
+
+    if (last_words) {
+      packets++;
+    } else {
+      last_words = XFER_BYTES_PER_PACKET / 4;
+    }
+
+    start.packets_in_transfer = CPU_TO_BE32(packets);
+    start.label = label;
+    start.words_in_last_packet = last_words;
+    start.expected_crc = CPU_TO_BE32(crc);
+
+    return start;
+  }
+
+  bool send_packet(uint32_t number, const uint8_t *data, uint32_t len) {
+    struct msg_xfer_cont cont;
+
+    memset(&cont, 0xFF, sizeof(cont));
+
+    cont.current_packet_number = CPU_TO_BE32(number);
+    memcpy(cont.data, data, len);
+
+    /* Data words travel big endian */
+    for (uint32_t i = 0; i < XFER_BYTES_PER_PACKET / 4; i++) {
+      uint32_t *word = &((uint32_t *)cont.data)[i];
+      *word = CPU_TO_BE32(*word);
+    }
+
+    return bl_xfer_write_cont(&xfer, &cont);
+  }
+
+  void write_full(const uint8_t *image, uint32_t len) {
+    struct msg_xfer_start start = xfer_start_msg(DFU_PARTITION_FW, len,
+        image_crc(image, FW_RANGE));
+
+    ASSERT_TRUE(bl_xfer_write_start(&xfer, &start));
+
+    for (uint32_t offset = 0, n = 0; offset < len; offset += XFER_BYTES_PER_PACKET, n++) {
+      uint32_t chunk = len - offset;
+
+      if (chunk > XFER_BYTES_PER_PACKET) {
+        chunk = XFER_BYTES_PER_PACKET;
+      }
+
+      ASSERT_TRUE(send_packet(n, &image[offset], chunk));
+    }
+
+    EXPECT_TRUE(bl_xfer_completed_p(&xfer));
+    EXPECT_TRUE(bl_xfer_crc_ok_p(&xfer));
+  }
+
+  std::vector<struct sector_crc> get_sector_crcs(enum dfu_partition_label label) {
+    std::vector<struct sector_crc> crcs;
+
+    struct msg_sector_crc_req req;
+    req.label = label;
+
+    num_sent_msgs = 0;
+
+    EXPECT_TRUE(bl_xfer_send_sector_crcs(&req));
+
+    for (uint32_t i = 0; i < num_sent_msgs; i++) {
+      const struct msg_sector_crc_rep *rep = &sent_msgs[i].v.sector_crc_rep;
+
+      EXPECT_EQ(BL_MSG_SECTOR_CRC_REP, sent_msgs[i].flags_command);
+      EXPECT_EQ(label, rep->label);
+      EXPECT_EQ(crcs.size(), (size_t) BE16_TO_CPU(rep->first_sector));
+      EXPECT_EQ(SIM_FLASH_SECTORS, BE16_TO_CPU(rep->total_sectors));
+
+      for (uint8_t j = 0; j < rep->num_sectors; j++) {
+        struct sector_crc s = {
+          BE32_TO_CPU(rep->sectors[j].size),
+          BE32_TO_CPU(rep->sectors[j].crc),
+        };
+
+        crcs.push_back(s);
+      }
+    }
+
+    return crcs;
+  }
+
+  /* Mirrors the uploader: rewrite sectors whose CRC differs, and the
+   * sector that also holds the descriptor.  Packets that are all erased
+   * bytes are skipped, except the first in each sector. */
+  void write_sparse(const uint8_t *image) {
+    std::vector<struct sector_crc> crcs = get_sector_crcs(DFU_PARTITION_FW);
+
+    ASSERT_EQ((size_t) SIM_FLASH_SECTORS, crcs.size());
+
+    struct msg_xfer_start start = xfer_start_msg(DFU_PARTITION_FW, FW_RANGE,
+        image_crc(image, FW_RANGE));
+
+    ASSERT_TRUE(bl_xfer_write_sparse_start(&xfer, &start));
+
+    uint32_t sector_offset = 0;
+
+    for (size_t i = 0; i < crcs.size(); i++) {
+      uint32_t sector_end = sector_offset + crcs[i].size;
+      uint32_t end = (sector_end < FW_RANGE) ? sector_end : FW_RANGE;
+
+      if (sector_end <= FW_RANGE &&
+          image_crc(&image[sector_offset], end - sector_offset) == crcs[i].crc) {
+        sector_offset = sector_end;
+        continue;
+      }
+
+      for (uint32_t offset = sector_offset; offset < end; offset += XFER_BYTES_PER_PACKET) {
+        uint32_t chunk = end - offset;
+
+        if (chunk > XFER_BYTES_PER_PACKET) {
+          chunk = XFER_BYTES_PER_PACKET;
+        }
+
+        bool erased = true;
+        for (uint32_t j = 0; j < chunk; j++) {
+          erased &= (image[offset + j] == 0xFF);
+        }
+
+        if (erased && offset != sector_offset) {
+          continue;
+        }
+
+        ASSERT_TRUE(send_packet(offset, &image[offset], chunk));
+      }
+
+      sector_offset = sector_end;
+    }
+
+    EXPECT_TRUE(bl_xfer_completed_p(&xfer));
+    EXPECT_TRUE(bl_xfer_crc_ok_p(&xfer));
+  }
+
+  struct xfer_state xfer;
+};
+
+TEST_F(BlXferTest, SectorCrcs) {
+  uint8_t image[FW_RANGE];
+
+  fill_random(image, sizeof(image));
+  write_full(image, sizeof(image));
+
+  std::vector<struct sector_crc> crcs = get_sector_crcs(DFU_PARTITION_FW);
+
+  /* Seven sectors to a packet */
+  EXPECT_EQ(2U, num_sent_msgs);
+  EXPECT_EQ(SECTOR_CRCS_PER_PACKET, sent_msgs[0].v.sector_crc_rep.num_sectors);
+  EXPECT_EQ(SIM_FLASH_SECTORS - SECTOR_CRCS_PER_PACKET,
+      sent_msgs[1].v.sector_crc_rep.num_sectors);
+
+  ASSERT_EQ((size_t) SIM_FLASH_SECTORS, crcs.size());
+
+  uint32_t offset = 0;
+  for (size_t i = 0; i < crcs.size(); i++) {
+    uint32_t size = (i < SIM_FLASH_SMALL_SECTORS) ?
+        SIM_FLASH_SMALL_SECTOR_SIZE : SIM_FLASH_LARGE_SECTOR_SIZE;
+
+    EXPECT_EQ(size, crcs[i].size);
+
+    /* The last sector is only CRCed up to the descriptor */
+    uint32_t len = (offset + size > FW_RANGE) ? FW_RANGE - offset : size;
+
+    EXPECT_EQ(image_crc(&image[offset], len), crcs[i].crc);
+
+    offset += size;
+  }
+
+  EXPECT_EQ((uint32_t) SIM_FLASH_SIZE, offset);
+
+  /* The descriptor is never written sector by sector */
+  struct msg_sector_crc_req req;
+  req.label = DFU_PARTITION_DESC;
+
+  EXPECT_FALSE(bl_xfer_send_sector_crcs(&req));
+}
+
+TEST_F(BlXferTest, FullWrite) {
+  uint8_t image[FW_RANGE];
+
+  fill_random(image, sizeof(image));
+  write_full(image, sizeof(image));
+
+  EXPECT_EQ(0, memcmp(image, sim_flash, sizeof(image)));
+
+  for (int i = 0; i < SIM_FLASH_SECTORS; i++) {
+    EXPECT_EQ(1U, sim_flash_erases[i]);
+  }
+}
+
+TEST_F(BlXferTest, SparseWriteOnlyChangedSectors) {
+  uint8_t image[FW_RANGE];
+
+  fill_random(image, sizeof(image));
+  write_full(image, sizeof(image));
+
+  memset(sim_flash_erases, 0, sizeof(sim_flash_erases));
+
+  /* Change a word in the third sector and one straddling the fifth and
+   * sixth; packets don't line up with sector boundaries */
+  image[2 * SIM_FLASH_SMALL_SECTOR_SIZE + 100] ^= 0x55;
+  image[6 * SIM_FLASH_SMALL_SECTOR_SIZE - 2] ^= 0x55;
+  image[6 * SIM_FLASH_SMALL_SECTOR_SIZE + 1] ^= 0x55;
+
+  write_sparse(image);
+
+  EXPECT_EQ(0, memcmp(image, sim_flash, sizeof(image)));
+
+  for (int i = 0; i < SIM_FLASH_SECTORS; i++) {
+    bool changed = (i == 2) || (i == 5) || (i == 6) ||
+        (i == SIM_FLASH_SECTORS - 1);
+
+    EXPECT_EQ(changed ? 1U : 0U, sim_flash_erases[i]) << "sector " << i;
+  }
+
+  /* Nothing changed: only the descriptor's sector is rewritten */
+  memset(sim_flash_erases, 0, sizeof(sim_flash_erases));
+
+  write_sparse(image);
+
+  EXPECT_EQ(0, memcmp(image, sim_flash, sizeof(image)));
+
+  for (int i = 0; i < SIM_FLASH_SECTORS - 1; i++) {
+    EXPECT_EQ(0U, sim_flash_erases[i]) << "sector " << i;
+  }
+}
+
+TEST_F(BlXferTest, SparseWriteShrinkingImage) {
+  uint8_t image[FW_RANGE];
+
+  fill_random(image, sizeof(image));
+  write_full(image, sizeof(image));
+
+  /* A smaller firmware; the old tail has to be erased */
+  memset(&image[3000], 0xFF, sizeof(image) - 3000);
+
+  write_sparse(image);
+
+  EXPECT_EQ(0, memcmp(image, sim_flash, sizeof(image)));
+}
+
+TEST_F(BlXferTest, SparseWriteRejectsBadPackets) {
+  uint8_t data[XFER_BYTES_PER_PACKET];
+
+  memset(data, 0x12, sizeof(data));
+
+  struct msg_xfer_start start = xfer_start_msg(DFU_PARTITION_FW, FW_RANGE, 0);
+
+  /* Has to start at the beginning of a sector */
+  ASSERT_TRUE(bl_xfer_write_sparse_start(&xfer, &start));
+  EXPECT_FALSE(send_packet(XFER_BYTES_PER_PACKET, data, sizeof(data)));
+
+  /* Has to move forward */
+  ASSERT_TRUE(bl_xfer_write_sparse_start(&xfer, &start));
+  EXPECT_TRUE(send_packet(0, data, sizeof(data)));
+  EXPECT_FALSE(send_packet(0, data, sizeof(data)));
+
+  /* Has to be word aligned */
+  ASSERT_TRUE(bl_xfer_write_sparse_start(&xfer, &start));
+  EXPECT_TRUE(send_packet(0, data, sizeof(data)));
+  EXPECT_FALSE(send_packet(XFER_BYTES_PER_PACKET + 2, data, sizeof(data)));
+
+  /* Has to stay inside the transfer */
+  ASSERT_TRUE(bl_xfer_write_sparse_start(&xfer, &start));
+  EXPECT_FALSE(send_packet(FW_RANGE, data, sizeof(data)));
+
+  /* The descriptor isn't erased before it's written */
+  start.label = DFU_PARTITION_DESC;
+  start.packets_in_transfer = CPU_TO_BE32(1);
+  EXPECT_FALSE(bl_xfer_write_sparse_start(&xfer, &start));
+}
+
+TEST_F(BlXferTest, SparseWriteBadCrc) {
+  uint8_t image[FW_RANGE];
+
+  fill_random(image, sizeof(image));
+  write_full(image, sizeof(image));
+
+  struct msg_xfer_start start = xfer_start_msg(DFU_PARTITION_FW, FW_RANGE,
+      image_crc(image, FW_RANGE) ^ 1);
+
+  ASSERT_TRUE(bl_xfer_write_sparse_start(&xfer, &start));
+  EXPECT_TRUE(send_packet(0, image, XFER_BYTES_PER_PACKET));
+
+  EXPECT_TRUE(bl_xfer_completed_p(&xfer));
+  EXPECT_FALSE(bl_xfer_crc_ok_p(&xfer));
+}
@@ -0,0 +1,187 @@
+/*
+ * Stand-ins for the hardware the bootloader transfer code talks to: a
+ * simulated internal flash with mixed sector sizes, the board info blob,
+ * the message channel back to the host and the STM32 CRC unit.
+ */
+
+#include <string.h>
+
+#include "pios.h"
+#include "pios_flash_priv.h"
+#include "pios_board_info.h"
+#include "pios_com_msg.h"
+
+#include "unittest_mocks.h"
+
+uint8_t sim_flash[SIM_FLASH_SIZE];
+uint32_t sim_flash_erases[SIM_FLASH_SECTORS];
+uint32_t sim_flash_bad_writes;
+
+static const struct pios_flash_sector_range sim_flash_sectors[] = {
+	{
+		.base_sector = 0,
+		.last_sector = SIM_FLASH_SMALL_SECTORS - 1,
+		.sector_size = SIM_FLASH_SMALL_SECTOR_SIZE,
+	},
+	{
+		.base_sector = SIM_FLASH_SMALL_SECTORS,
+		.last_sector = SIM_FLASH_SECTORS - 1,
+		.sector_size = SIM_FLASH_LARGE_SECTOR_SIZE,
+	},
+};
+
+static uint32_t sim_flash_sector_size(uint32_t chip_sector)
+{
+	for (uint32_t i = 0; i < NELEMENTS(sim_flash_sectors); i++) {
+		if (chip_sector <= sim_flash_sectors[i].last_sector) {
+			return sim_flash_sectors[i].sector_size;
+		}
+	}
+
+	return 0;
+}
+
+static int32_t sim_flash_erase_sector(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset)
+{
+	(void) chip_id;
+
+	uint32_t size = sim_flash_sector_size(chip_sector);
+
+	if (!size || chip_offset + size > SIM_FLASH_SIZE) {
+		return -1;
+	}
+
+	memset(&sim_flash[chip_offset], 0xFF, size);
+	sim_flash_erases[chip_sector]++;
+
+	return 0;
+}
+
+static int32_t sim_flash_write_data(uintptr_t chip_id, uint32_t chip_offset, const uint8_t *data, uint16_t len)
+{
+	(void) chip_id;
+
+	if (chip_offset + len > SIM_FLASH_SIZE) {
+		return -1;
+	}
+
+	/* Like NOR flash, only erased bytes can be programmed */
+	for (uint16_t i = 0; i < len; i++) {
+		if (sim_flash[chip_offset + i] != 0xFF) {
+			sim_flash_bad_writes++;
+			return -2;
+		}
+	}
+
+	memcpy(&sim_flash[chip_offset], data, len);
+
+	return 0;
+}
+
+static int32_t sim_flash_read_data(uintptr_t chip_id, uint32_t chip_offset, uint8_t *data, uint16_t len)
+{
+	(void) chip_id;
+
+	if (chip_offset + len > SIM_FLASH_SIZE) {
+		return -1;
+	}
+
+	memcpy(data, &sim_flash[chip_offset], len);
+
+	return 0;
+}
+
+static const struct pios_flash_driver sim_flash_driver = {
+	.erase_sector = sim_flash_erase_sector,
+	.write_data   = sim_flash_write_data,
+	.read_data    = sim_flash_read_data,
+};
+
+static uintptr_t sim_flash_id;
+
+static const struct pios_flash_chip sim_flash_chip = {
+	.driver        = &sim_flash_driver,
+	.chip_id       = &sim_flash_id,
+	.page_size     = 256,
+	.sector_blocks = sim_flash_sectors,
+	.num_blocks    = NELEMENTS(sim_flash_sectors),
+};
+
+const struct pios_flash_partition sim_flash_partition_table[] = {
+	{
+		.label        = FLASH_PARTITION_LABEL_FW,
+		.chip_desc    = &sim_flash_chip,
+		.first_sector = 0,
+		.last_sector  = SIM_FLASH_SECTORS - 1,
+		.chip_offset  = 0,
+		.size         = SIM_FLASH_SIZE,
+	},
+};
+
+const uint32_t sim_flash_partition_table_size = NELEMENTS(sim_flash_partition_table);
+
+const struct pios_board_info pios_board_info_blob = {
+	.magic      = PIOS_BOARD_INFO_BLOB_MAGIC,
+	.board_type = 0x7F,
+	.board_rev  = 1,
+	.bl_rev     = 1,
+	.fw_base    = SIM_FW_BASE,
+	.fw_size    = SIM_FLASH_SIZE - SIM_DESC_SIZE,
+	.desc_base  = SIM_FW_BASE + SIM_FLASH_SIZE - SIM_DESC_SIZE,
+	.desc_size  = SIM_DESC_SIZE,
+};
+
+uintptr_t pios_com_telem_usb_id;
+
+struct bl_messages sent_msgs[MAX_SENT_MSGS];
+uint32_t num_sent_msgs;
+
+int32_t PIOS_COM_MSG_Send(uintptr_t com_id, const uint8_t *msg, uint16_t msg_len)
+{
+	(void) com_id;
+
+	if (num_sent_msgs >= MAX_SENT_MSGS || msg_len != sizeof(sent_msgs[0])) {
+		return -1;
+	}
+
+	memcpy(&sent_msgs[num_sent_msgs++], msg, msg_len);
+
+	return 0;
+}
+
+static uint32_t crc_dr;
+
+void CRC_ResetDR(void)
+{
+	crc_dr = 0xFFFFFFFF;
+}
+
+uint32_t CRC_CalcBlockCRC(uint32_t *buffer, uint32_t length)
+{
+	crc_dr = sim_crc_words(crc_dr, buffer, length);
+
+	return crc_dr;
+}
+
+uint32_t CRC_GetCRC(void)
+{
+	return crc_dr;
+}
+
+uint32_t sim_crc_words(uint32_t crc, const uint32_t *words, uint32_t length)
+{
+	/* Whole words, most significant bit first, polynomial 0x04C11DB7 */
+	while (length--) {
+		crc ^= *words++;
+
+		for (uint8_t bit = 0; bit < 32; bit++) {
+			if (crc & 0x80000000) {
+				crc = (crc << 1) ^ 0x04C11DB7;
+			} else {
+				crc <<= 1;
+			}
+		}
+	}
+
+	return crc;
+}
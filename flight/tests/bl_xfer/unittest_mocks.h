@@ -0,0 +1,36 @@
+#ifndef UNITTEST_MOCKS_H
+#define UNITTEST_MOCKS_H
+
+#include <stdint.h>
+
+#include "pios_flash_priv.h"
+#include "bl_messages.h"
+
+/* Eight small sectors followed by two large ones, like the front of an F4 */
+#define SIM_FLASH_SMALL_SECTORS     8
+#define SIM_FLASH_SMALL_SECTOR_SIZE 1024
+#define SIM_FLASH_LARGE_SECTORS     2
+#define SIM_FLASH_LARGE_SECTOR_SIZE 4096
+
+#define SIM_FLASH_SECTORS (SIM_FLASH_SMALL_SECTORS + SIM_FLASH_LARGE_SECTORS)
+#define SIM_FLASH_SIZE (SIM_FLASH_SMALL_SECTORS * SIM_FLASH_SMALL_SECTOR_SIZE + \
+		SIM_FLASH_LARGE_SECTORS * SIM_FLASH_LARGE_SECTOR_SIZE)
+
+#define SIM_FW_BASE   0x08000000
+#define SIM_DESC_SIZE 100
+
+extern uint8_t sim_flash[SIM_FLASH_SIZE];
+extern uint32_t sim_flash_erases[SIM_FLASH_SECTORS];
+extern uint32_t sim_flash_bad_writes;
+
+extern const struct pios_flash_partition sim_flash_partition_table[];
+extern const uint32_t sim_flash_partition_table_size;
+
+#define MAX_SENT_MSGS 16
+
+extern struct bl_messages sent_msgs[MAX_SENT_MSGS];
+extern uint32_t num_sent_msgs;
+
+uint32_t sim_crc_words(uint32_t crc, const uint32_t *words, uint32_t length);
+
+#endif /* UNITTEST_MOCKS_H */
@@ -0,0 +1 @@
+/* Stand-in for a board's pios_board.h; the test makes its own ports. */
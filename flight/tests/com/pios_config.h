@@ -0,0 +1,5 @@
+#define PIOS_NO_HW
+#define FLIGHT_POSIX
+
+#define PIOS_INCLUDE_RTOS
+#define PIOS_INCLUDE_COM
@@ -0,0 +1,544 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memcmp */
+#include <stdint.h>		/* uint*_t */
+#include <unistd.h>		/* usleep */
+#include <pthread.h>		/* pthread_* */
+
+extern "C" {
+#include "pios.h"
+#include "pios_com_priv.h"
+#include "pios_loopback_priv.h"
+#include "unittest_mocks.h"
+}
+
+/*
+ * A port whose transmitter only moves when the test pulls from it, the way
+ * the tx interrupt would.
+ */
+static pios_com_callback stalled_tx_out_cb;
+static uintptr_t stalled_tx_out_context;
+static uint32_t stalled_tx_starts;
+static bool stalled_up;
+
+static void stalled_tx_start(uintptr_t id, uint16_t tx_bytes_avail)
+{
+	(void) id; (void) tx_bytes_avail;
+
+	stalled_tx_starts++;
+}
+
+static void stalled_bind_tx_cb(uintptr_t id, pios_com_callback tx_out_cb,
+		uintptr_t context)
+{
+	(void) id;
+
+	stalled_tx_out_context = context;
+	stalled_tx_out_cb = tx_out_cb;
+}
+
+static bool stalled_available(uintptr_t id)
+{
+	(void) id;
+
+	return stalled_up;
+}
+
+static const struct pios_com_driver stalled_com_driver = {
+	NULL,			/* set_baud */
+	stalled_tx_start,
+	NULL,			/* rx_start */
+	NULL,			/* bind_rx_cb */
+	stalled_bind_tx_cb,
+	stalled_available,
+};
+
+/* Takes what the port would put on the line, up to len bytes a call */
+static uint16_t stalled_pull(uint8_t *buf, uint16_t len)
+{
+	bool need_yield = false;
+
+	return stalled_tx_out_cb(stalled_tx_out_context, buf, len, NULL,
+			&need_yield);
+}
+
+/* Pulls a byte a call, as a uart does, until want bytes have gone */
+static int stalled_pull_bytes(uint8_t *buf, int want)
+{
+	int got = 0;
+	double give_up = ut_seconds() + 5;
+
+	while (got < want && ut_seconds() < give_up) {
+		if (stalled_pull(buf + got, 1)) {
+			got++;
+		} else {
+			usleep(100);
+		}
+	}
+
+	return got;
+}
+
+class ComTest : public testing::Test {
+protected:
+	virtual void SetUp() {
+		stalled_tx_out_cb = NULL;
+		stalled_tx_starts = 0;
+		stalled_up = true;
+	}
+
+	uintptr_t stalled_port(uint16_t tx_len) {
+		uintptr_t com_id;
+
+		EXPECT_EQ(0, PIOS_COM_Init(&com_id, &stalled_com_driver, 0,
+					0, tx_len));
+
+		return com_id;
+	}
+};
+
+TEST_F(ComTest, VectorGoesOutWhole) {
+	uintptr_t com = stalled_port(64);
+
+	const uint8_t hdr[] = { '$', 'M', '>', 20, 101 };
+	uint8_t payload[20];
+	const uint8_t cs = 0x5a;
+
+	for (unsigned i = 0; i < sizeof(payload); i++) {
+		payload[i] = i * 7;
+	}
+
+	const struct pios_com_iovec frame[] = {
+		{ hdr, sizeof(hdr) },
+		{ payload, sizeof(payload) },
+		{ &cs, 1 },
+	};
+
+	EXPECT_EQ(26, PIOS_COM_SendVectorNonBlocking(com, frame, 3));
+
+	/* The transmitter is started once for the frame, not per fragment */
+	EXPECT_EQ(1u, stalled_tx_starts);
+
+	uint8_t out[64];
+	ASSERT_EQ(26, stalled_pull(out, sizeof(out)));
+
+	EXPECT_EQ(0, memcmp(out, hdr, sizeof(hdr)));
+	EXPECT_EQ(0, memcmp(out + 5, payload, sizeof(payload)));
+	EXPECT_EQ(cs, out[25]);
+
+	/* Empty fragments are fine */
+	const struct pios_com_iovec sparse[] = {
+		{ NULL, 0 },
+		{ hdr, sizeof(hdr) },
+		{ NULL, 0 },
+	};
+
+	EXPECT_EQ(5, PIOS_COM_SendVector(com, sparse, 3));
+	ASSERT_EQ(5, stalled_pull(out, sizeof(out)));
+	EXPECT_EQ(0, memcmp(out, hdr, sizeof(hdr)));
+}
+
+TEST_F(ComTest, NonBlockingIsAllOrNothing) {
+	/* Holds 63 */
+	uintptr_t com = stalled_port(64);
+
+	uint8_t fill[50];
+	memset(fill, 0xee, sizeof(fill));
+
+	EXPECT_EQ(50, PIOS_COM_SendBufferNonBlocking(com, fill, sizeof(fill)));
+
+	uint8_t hdr[5] = { 1, 2, 3, 4, 5 };
+	uint8_t payload[10] = { 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+	uint8_t cs = 16;
+
+	const struct pios_com_iovec frame[] = {
+		{ hdr, sizeof(hdr) },
+		{ payload, sizeof(payload) },
+		{ &cs, 1 },
+	};
+
+	EXPECT_EQ(-2, PIOS_COM_SendVectorNonBlocking(com, frame, 3));
+
+	/* Nothing of the frame went in */
+	uint8_t out[64];
+	EXPECT_EQ(50, stalled_pull(out, sizeof(out)));
+	EXPECT_EQ(0, stalled_pull(out, sizeof(out)));
+
+	EXPECT_EQ(16, PIOS_COM_SendVectorNonBlocking(com, frame, 3));
+	ASSERT_EQ(16, stalled_pull(out, sizeof(out)));
+
+	for (int i = 0; i < 16; i++) {
+		EXPECT_EQ(i + 1, out[i]);
+	}
+}
+
+TEST_F(ComTest, DownPortSinksEverything) {
+	uintptr_t com = stalled_port(16);
+
+	stalled_up = false;
+
+	uint8_t payload[100] = { 0 };
+	const struct pios_com_iovec frame[] = {
+		{ payload, sizeof(payload) },
+		{ payload, 20 },
+	};
+
+	EXPECT_EQ(120, PIOS_COM_SendVector(com, frame, 2));
+	EXPECT_EQ(120, PIOS_COM_SendVectorNonBlocking(com, frame, 2));
+
+	uint8_t out[16];
+	EXPECT_EQ(0, stalled_pull(out, sizeof(out)));
+}
+
+struct writer {
+	uintptr_t com;
+	const struct pios_com_iovec *iov;
+	uint8_t iovcnt;
+	int32_t ret;
+};
+
+static void *vector_writer(void *arg)
+{
+	struct writer *w = (struct writer *) arg;
+
+	w->ret = PIOS_COM_SendVector(w->com, w->iov, w->iovcnt);
+
+	return NULL;
+}
+
+static void *buffer_writer(void *arg)
+{
+	struct writer *w = (struct writer *) arg;
+
+	w->ret = PIOS_COM_SendBuffer(w->com, (const uint8_t *) w->iov->base,
+			w->iov->len);
+
+	return NULL;
+}
+
+TEST_F(ComTest, FramesLargerThanTheFifoGoInPieces) {
+	/* Holds 15 */
+	uintptr_t com = stalled_port(16);
+
+	uint8_t data[40];
+	for (unsigned i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+
+	/* Fragment boundaries fall all over the fifo's */
+	const struct pios_com_iovec frame[] = {
+		{ data, 7 },
+		{ data + 7, 20 },
+		{ data + 27, 13 },
+	};
+
+	struct writer w = { com, frame, 3, 0 };
+	pthread_t thread;
+
+	ASSERT_EQ(0, pthread_create(&thread, NULL, vector_writer, &w));
+
+	uint8_t out[40];
+	EXPECT_EQ(40, stalled_pull_bytes(out, sizeof(out)));
+
+	pthread_join(thread, NULL);
+
+	EXPECT_EQ(40, w.ret);
+	EXPECT_EQ(0, memcmp(out, data, sizeof(data)));
+}
+
+TEST_F(ComTest, NobodyWokenWhenNobodyWaits) {
+	uintptr_t com = stalled_port(256);
+
+	uint8_t data[200] = { 0 };
+
+	EXPECT_EQ(200, PIOS_COM_SendBufferNonBlocking(com, data, sizeof(data)));
+
+	uint32_t gives = mock_semaphore_gives;
+
+	uint8_t out[200];
+	EXPECT_EQ(200, stalled_pull_bytes(out, sizeof(out)));
+
+	/* This used to be a give per byte */
+	EXPECT_EQ(gives, mock_semaphore_gives);
+}
+
+TEST_F(ComTest, BlockedFrameWokenOnce) {
+	/* Holds 63 */
+	uintptr_t com = stalled_port(64);
+
+	uint8_t fill[60];
+	memset(fill, 0xee, sizeof(fill));
+
+	EXPECT_EQ(60, PIOS_COM_SendBufferNonBlocking(com, fill, sizeof(fill)));
+
+	uint8_t payload[40];
+	for (unsigned i = 0; i < sizeof(payload); i++) {
+		payload[i] = i;
+	}
+
+	const struct pios_com_iovec frame[] = {
+		{ payload, 4 },
+		{ payload + 4, 36 },
+	};
+
+	struct writer w = { com, frame, 2, 0 };
+	pthread_t thread;
+
+	ASSERT_EQ(0, pthread_create(&thread, NULL, vector_writer, &w));
+
+	/* Let the writer block */
+	usleep(20000);
+
+	uint32_t gives = mock_semaphore_gives;
+
+	uint8_t out[100];
+	EXPECT_EQ(100, stalled_pull_bytes(out, sizeof(out)));
+
+	pthread_join(thread, NULL);
+
+	EXPECT_EQ(40, w.ret);
+	EXPECT_EQ(0, memcmp(out + 60, payload, sizeof(payload)));
+
+	/* Woken once there was room for the whole frame, and not before */
+	EXPECT_EQ(gives + 1, mock_semaphore_gives);
+}
+
+TEST_F(ComTest, LongWritesWokenByTheHalfFifo) {
+	/* Holds 255 */
+	uintptr_t com = stalled_port(256);
+
+	static uint8_t data[8000];
+	for (unsigned i = 0; i < sizeof(data); i++) {
+		data[i] = i * 13;
+	}
+
+	const struct pios_com_iovec iov = { data, sizeof(data) };
+	struct writer w = { com, &iov, 1, 0 };
+	pthread_t thread;
+
+	uint32_t gives = mock_semaphore_gives;
+
+	ASSERT_EQ(0, pthread_create(&thread, NULL, buffer_writer, &w));
+
+	static uint8_t out[8000];
+	EXPECT_EQ(8000, stalled_pull_bytes(out, sizeof(out)));
+
+	pthread_join(thread, NULL);
+
+	EXPECT_EQ(8000, w.ret);
+	EXPECT_EQ(0, memcmp(out, data, sizeof(data)));
+
+	/* About one per 128 bytes, not one per byte */
+	EXPECT_LE(mock_semaphore_gives - gives, sizeof(data) / 128 + 2);
+}
+
+#define FRAMES_PER_WRITER 300
+
+static void *frame_writer(void *arg)
+{
+	struct writer *w = (struct writer *) arg;
+	uint8_t id = w->iovcnt;
+
+	for (int seq = 0; seq < FRAMES_PER_WRITER; seq++) {
+		uint8_t len = seq % 40;
+		uint8_t hdr[4] = { '$', id, (uint8_t) seq, len };
+		uint8_t payload[40];
+		uint8_t cs = id ^ seq;
+
+		memset(payload, id ^ seq, len);
+
+		const struct pios_com_iovec frame[] = {
+			{ hdr, sizeof(hdr) },
+			{ payload, len },
+			{ &cs, 1 },
+		};
+
+		int32_t frame_len = sizeof(hdr) + len + 1;
+
+		if (PIOS_COM_SendVector(w->com, frame, 3) != frame_len) {
+			w->ret = -1;
+			return NULL;
+		}
+
+		w->ret += frame_len;
+	}
+
+	return NULL;
+}
+
+TEST_F(ComTest, FramesFromTwoWritersDontInterleave) {
+	uintptr_t loopback_id, com;
+
+	ASSERT_EQ(0, PIOS_LOOPBACK_Init(&loopback_id, 1));
+	ASSERT_EQ(0, PIOS_COM_Init(&com, &pios_loopback_com_driver,
+				loopback_id, 32768, 128));
+
+	struct writer w[2] = {
+		{ com, NULL, 1, 0 },
+		{ com, NULL, 2, 0 },
+	};
+	pthread_t threads[2];
+
+	for (int i = 0; i < 2; i++) {
+		ASSERT_EQ(0, pthread_create(&threads[i], NULL, frame_writer, &w[i]));
+	}
+
+	for (int i = 0; i < 2; i++) {
+		pthread_join(threads[i], NULL);
+		ASSERT_GT(w[i].ret, 0);
+	}
+
+	uint32_t total = w[0].ret + w[1].ret;
+	static uint8_t in[32768];
+
+	ASSERT_LT(total, sizeof(in));
+
+	uint32_t got = 0;
+	while (got < total) {
+		uint16_t len = PIOS_COM_ReceiveBuffer(com, in + got,
+				sizeof(in) - got, 1000);
+
+		ASSERT_GT(len, 0);
+		got += len;
+	}
+
+	struct pios_loopback_stats stats;
+	PIOS_LOOPBACK_GetStats(loopback_id, &stats);
+
+	EXPECT_EQ(total, stats.tx_bytes);
+	EXPECT_EQ(total, stats.tx_calls);
+	EXPECT_EQ(0u, stats.rx_dropped);
+
+	int next_seq[3] = { 0, 0, 0 };
+
+	for (uint32_t pos = 0; pos < total; ) {
+		ASSERT_EQ('$', in[pos]);
+
+		uint8_t id = in[pos + 1];
+		uint8_t seq = in[pos + 2];
+		uint8_t len = in[pos + 3];
+
+		ASSERT_TRUE(id == 1 || id == 2);
+		ASSERT_EQ((uint8_t) next_seq[id], seq);
+		ASSERT_EQ(next_seq[id] % 40, len);
+
+		for (int i = 0; i < len; i++) {
+			ASSERT_EQ(id ^ seq, in[pos + 4 + i]);
+		}
+
+		ASSERT_EQ(id ^ seq, in[pos + 4 + len]);
+
+		next_seq[id]++;
+		pos += 4 + len + 1;
+	}
+
+	EXPECT_EQ(FRAMES_PER_WRITER, next_seq[1]);
+	EXPECT_EQ(FRAMES_PER_WRITER, next_seq[2]);
+}
+
+/*
+ * Throughput and cpu per byte through a loopback port, sending msp sized
+ * frames as three separate buffers as the encoders used to, and as one
+ * vector.  A chunk of 1 is a uart taking a byte an interrupt.
+ */
+static void bench(uint16_t chunk, bool vector)
+{
+	const int frames = 20000;
+	uintptr_t loopback_id, com;
+
+	ASSERT_EQ(0, PIOS_LOOPBACK_Init(&loopback_id, chunk));
+	ASSERT_EQ(0, PIOS_COM_Init(&com, &pios_loopback_com_driver,
+				loopback_id, 0, 256));
+
+	uint8_t hdr[5] = { '$', 'M', '>', 32, 108 };
+	uint8_t payload[32] = { 0 };
+	uint8_t cs = 0;
+
+	const struct pios_com_iovec frame[] = {
+		{ hdr, sizeof(hdr) },
+		{ payload, sizeof(payload) },
+		{ &cs, 1 },
+	};
+	const uint32_t frame_len = sizeof(hdr) + sizeof(payload) + 1;
+
+	uint32_t gives = mock_semaphore_gives;
+	double start = ut_seconds();
+	double start_cpu = ut_cpu_seconds();
+
+	for (int i = 0; i < frames; i++) {
+		if (vector) {
+			ASSERT_EQ((int32_t) frame_len, PIOS_COM_SendVector(com, frame, 3));
+		} else {
+			ASSERT_EQ(5, PIOS_COM_SendBuffer(com, hdr, sizeof(hdr)));
+			ASSERT_EQ(32, PIOS_COM_SendBuffer(com, payload, sizeof(payload)));
+			ASSERT_EQ(1, PIOS_COM_SendBuffer(com, &cs, 1));
+		}
+	}
+
+	struct pios_loopback_stats stats;
+	double give_up = ut_seconds() + 5;
+
+	while (PIOS_LOOPBACK_GetStats(loopback_id, &stats),
+			stats.tx_bytes < frames * frame_len &&
+			ut_seconds() < give_up) {
+		usleep(100);
+	}
+
+	double wall = ut_seconds() - start;
+	double cpu = ut_cpu_seconds() - start_cpu;
+	uint32_t bytes = frames * frame_len;
+
+	EXPECT_EQ(bytes, stats.tx_bytes);
+
+	printf("chunk %3d, %s: %6.1f MB/s, %5.1f ns cpu/byte, "
+			"%u tx starts, %u semaphore gives\n",
+			chunk, vector ? "vector     " : "three sends",
+			bytes / wall / 1e6, cpu / bytes * 1e9,
+			stats.tx_starts, mock_semaphore_gives - gives);
+}
+
+TEST_F(ComTest, Throughput) {
+	bench(1, false);
+	bench(1, true);
+	bench(64, false);
+	bench(64, true);
+}
+
+/**
+ * @}
+ * @}
+ */
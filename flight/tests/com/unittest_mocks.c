@@ -0,0 +1,146 @@
+/*
+ * Stand-ins for the PiOS thread and semaphore services: threads are plain
+ * pthreads, and semaphores count how often they're given, so the test can
+ * see who gets woken.
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pios.h"
+
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+
+#include "unittest_mocks.h"
+
+volatile uint32_t mock_semaphore_gives;
+
+struct pios_semaphore {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+
+	bool given;
+};
+
+struct pios_thread {
+	pthread_t thread;
+
+	void (*fp)(void *);
+	void *argp;
+};
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+	struct pios_semaphore *s = PIOS_malloc(sizeof(*s));
+
+	if (!s) {
+		return NULL;
+	}
+
+	pthread_mutex_init(&s->mutex, NULL);
+	pthread_cond_init(&s->cond, NULL);
+
+	/* Created given, as on the flight side */
+	s->given = true;
+
+	return s;
+}
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+	struct timespec abstime;
+
+	clock_gettime(CLOCK_REALTIME, &abstime);
+
+	if (timeout_ms != PIOS_SEMAPHORE_TIMEOUT_MAX) {
+		abstime.tv_sec += timeout_ms / 1000;
+		abstime.tv_nsec += (timeout_ms % 1000) * 1000000;
+
+		if (abstime.tv_nsec >= 1000000000) {
+			abstime.tv_nsec -= 1000000000;
+			abstime.tv_sec += 1;
+		}
+	}
+
+	pthread_mutex_lock(&sema->mutex);
+
+	while (!sema->given) {
+		if (timeout_ms == PIOS_SEMAPHORE_TIMEOUT_MAX) {
+			pthread_cond_wait(&sema->cond, &sema->mutex);
+		} else if (pthread_cond_timedwait(&sema->cond, &sema->mutex,
+					&abstime)) {
+			pthread_mutex_unlock(&sema->mutex);
+			return false;
+		}
+	}
+
+	sema->given = false;
+
+	pthread_mutex_unlock(&sema->mutex);
+
+	return true;
+}
+
+bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
+{
+	__atomic_add_fetch(&mock_semaphore_gives, 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_lock(&sema->mutex);
+
+	bool old = sema->given;
+
+	sema->given = true;
+	pthread_cond_signal(&sema->cond);
+
+	pthread_mutex_unlock(&sema->mutex);
+
+	return !old;
+}
+
+bool PIOS_Semaphore_Give_FromISR(struct pios_semaphore *sema, bool *woken)
+{
+	bool ret = PIOS_Semaphore_Give(sema);
+
+	if (ret && woken) {
+		*woken = true;
+	}
+
+	return ret;
+}
+
+static void *thread_trampoline(void *arg)
+{
+	struct pios_thread *thread = arg;
+
+	thread->fp(thread->argp);
+
+	return NULL;
+}
+
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep,
+		size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+	(void) namep; (void) stack_bytes; (void) prio;
+
+	struct pios_thread *thread = PIOS_malloc(sizeof(*thread));
+
+	PIOS_Assert(thread);
+
+	thread->fp = fp;
+	thread->argp = argp;
+
+	if (pthread_create(&thread->thread, NULL, thread_trampoline, thread)) {
+		abort();
+	}
+
+	pthread_detach(thread->thread);
+
+	return thread;
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+	usleep(time_ms * 1000);
+}
@@ -0,0 +1,13 @@
+/*
+ * Shared between the PiOS stand-ins and the test driver.
+ */
+
+#ifndef UNITTEST_MOCKS_H
+#define UNITTEST_MOCKS_H
+
+#include <stdint.h>
+
+/* Semaphore gives, from any thread, since the start of the program */
+extern volatile uint32_t mock_semaphore_gives;
+
+#endif /* UNITTEST_MOCKS_H */
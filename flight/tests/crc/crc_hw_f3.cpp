@@ -0,0 +1,12 @@
+/* pios_crc.c as built for the F3, against the mock CRC unit */
+
+#define CRC_VARIANT crc_hw_f3
+#define STM32F30X
+
+#include "crc_variant.h"
+
+crc_mock_f3 crc_mock_f3_unit = {
+	{ 0, 0 },
+	{ &crc_mock_f3_unit.DR, &crc_mock_f3_unit.INIT },
+	0xffffffff,
+};
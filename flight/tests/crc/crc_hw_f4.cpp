@@ -0,0 +1,13 @@
+/* pios_crc.c as built for the F4, against the mock CRC unit */
+
+#define CRC_VARIANT crc_hw_f4
+#define STM32F4XX
+
+#include "crc_variant.h"
+
+static const uint32_t f4_reset_value = 0xffffffff;
+
+crc_mock_f4 crc_mock_f4_unit = {
+	{ 0, 0 },
+	{ &crc_mock_f4_unit.DR, &f4_reset_value },
+};
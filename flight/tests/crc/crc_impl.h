@@ -0,0 +1,40 @@
+/*
+ * One build of pios_crc.c, reached through pointers so that several
+ * configurations can be linked into the same test.
+ */
+
+#ifndef CRC_IMPL_H
+#define CRC_IMPL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct crc_impl {
+	const char *name;
+	uint8_t (*crc8)(uint8_t crc, const uint8_t *data, int32_t length);
+	uint8_t (*crc8_byte)(uint8_t crc, const uint8_t data);
+	uint8_t (*crc8_tbs)(uint8_t crc, const uint8_t *data, int32_t length);
+	uint16_t (*crc16)(uint16_t crc, const uint8_t *data, int32_t length);
+	uint16_t (*crc16_byte)(uint16_t crc, const uint8_t data);
+	uint16_t (*crc16_ccitt)(uint16_t crc, const uint8_t *data, uint32_t data_len);
+	uint32_t (*crc32)(uint32_t crc, const uint8_t *data, int32_t length);
+	uint32_t (*crc32_byte)(uint32_t crc, const uint8_t data);
+	bool (*crc32_hw_claim)(void);
+	void (*crc32_hw_release)(void);
+};
+
+extern const struct crc_impl crc_slice1;
+extern const struct crc_impl crc_slice4;
+extern const struct crc_impl crc_slice8;
+extern const struct crc_impl crc_hw_f3;
+extern const struct crc_impl crc_hw_f4;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC_IMPL_H */
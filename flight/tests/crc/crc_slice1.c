@@ -0,0 +1,4 @@
+#define CRC_VARIANT crc_slice1
+#define PIOS_CRC_SLICE_BY 1
+
+#include "crc_variant.h"
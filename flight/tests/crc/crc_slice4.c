@@ -0,0 +1,4 @@
+#define CRC_VARIANT crc_slice4
+#define PIOS_CRC_SLICE_BY 4
+
+#include "crc_variant.h"
@@ -0,0 +1,4 @@
+#define CRC_VARIANT crc_slice8
+#define PIOS_CRC_SLICE_BY 8
+
+#include "crc_variant.h"
@@ -0,0 +1,65 @@
+/*
+ * Stand-in for the STM32 CRC unit: CRC-32, polynomial 0x04C11DB7, a word at
+ * a time, most significant bit first.  The F4 always resets to all ones;
+ * the F3 resets to its INIT register.
+ */
+
+#ifndef CRC_UNIT_MOCK_H
+#define CRC_UNIT_MOCK_H
+
+#include <stdint.h>
+
+#define CRC_CR_RESET ((uint32_t) 0x01)
+
+struct crc_mock_dr {
+	crc_mock_dr &operator=(uint32_t word)
+	{
+		value ^= word;
+
+		for (int i = 0; i < 32; i++) {
+			value = (value & 0x80000000) ? (value << 1) ^ 0x04c11db7 : value << 1;
+		}
+
+		words++;
+
+		return *this;
+	}
+
+	operator uint32_t() const
+	{
+		return value;
+	}
+
+	uint32_t value;
+	uint32_t words;		/* Words processed, for the tests */
+};
+
+struct crc_mock_cr {
+	crc_mock_cr &operator=(uint32_t cr)
+	{
+		if (cr & CRC_CR_RESET) {
+			dr->value = *init;
+		}
+
+		return *this;
+	}
+
+	crc_mock_dr *dr;
+	const uint32_t *init;
+};
+
+struct crc_mock_f4 {
+	crc_mock_dr DR;
+	crc_mock_cr CR;
+};
+
+struct crc_mock_f3 {
+	crc_mock_dr DR;
+	crc_mock_cr CR;
+	uint32_t INIT;
+};
+
+extern crc_mock_f4 crc_mock_f4_unit;
+extern crc_mock_f3 crc_mock_f3_unit;
+
+#endif /* CRC_UNIT_MOCK_H */
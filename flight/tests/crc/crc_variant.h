@@ -0,0 +1,38 @@
+/*
+ * Builds pios_crc.c under names of its own.  Define CRC_VARIANT, and
+ * whatever configuration pios_crc.c should see, before including this.
+ */
+
+#include "crc_impl.h"
+
+#define CRC_CAT2(a, b) a ## _ ## b
+#define CRC_CAT(a, b) CRC_CAT2(a, b)
+#define CRC_STR2(a) #a
+#define CRC_STR(a) CRC_STR2(a)
+
+#define PIOS_CRC_updateByte CRC_CAT(CRC_VARIANT, crc8_byte)
+#define PIOS_CRC_updateCRC CRC_CAT(CRC_VARIANT, crc8)
+#define PIOS_CRC_updateCRC_TBS CRC_CAT(CRC_VARIANT, crc8_tbs)
+#define PIOS_CRC16_updateByte CRC_CAT(CRC_VARIANT, crc16_byte)
+#define PIOS_CRC16_updateCRC CRC_CAT(CRC_VARIANT, crc16)
+#define PIOS_CRC16_CCITT_updateCRC CRC_CAT(CRC_VARIANT, crc16_ccitt)
+#define PIOS_CRC32_updateByte CRC_CAT(CRC_VARIANT, crc32_byte)
+#define PIOS_CRC32_updateCRC CRC_CAT(CRC_VARIANT, crc32)
+#define PIOS_CRC32_HW_Claim CRC_CAT(CRC_VARIANT, crc32_hw_claim)
+#define PIOS_CRC32_HW_Release CRC_CAT(CRC_VARIANT, crc32_hw_release)
+
+#include "pios_crc.c"
+
+const struct crc_impl CRC_VARIANT = {
+	.name = CRC_STR(CRC_VARIANT),
+	.crc8 = PIOS_CRC_updateCRC,
+	.crc8_byte = PIOS_CRC_updateByte,
+	.crc8_tbs = PIOS_CRC_updateCRC_TBS,
+	.crc16 = PIOS_CRC16_updateCRC,
+	.crc16_byte = PIOS_CRC16_updateByte,
+	.crc16_ccitt = PIOS_CRC16_CCITT_updateCRC,
+	.crc32 = PIOS_CRC32_updateCRC,
+	.crc32_byte = PIOS_CRC32_updateByte,
+	.crc32_hw_claim = PIOS_CRC32_HW_Claim,
+	.crc32_hw_release = PIOS_CRC32_HW_Release,
+};
@@ -0,0 +1,5 @@
+/* Just enough of the F3 device header for pios_crc.c */
+
+#include "crc_unit_mock.h"
+
+#define CRC (&crc_mock_f3_unit)
@@ -0,0 +1,247 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* strlen */
+#include <stdint.h>		/* uint*_t */
+
+#include <vector>
+
+#include "crc_impl.h"
+#include "crc_unit_mock.h"
+
+/* Buffer size for the throughput comparison */
+#define BENCH_BYTES (1024 * 1024)
+#define BENCH_ROUNDS 32
+
+static const struct crc_impl *const sw_impls[] = {
+  &crc_slice1, &crc_slice4, &crc_slice8,
+};
+
+static const struct crc_impl *const all_impls[] = {
+  &crc_slice1, &crc_slice4, &crc_slice8, &crc_hw_f3, &crc_hw_f4,
+};
+
+static const uint8_t check_string[] = "123456789";
+
+/* Reference CRCs, a bit at a time straight from the polynomials */
+static uint8_t ref_crc8(uint8_t crc, uint8_t poly, const uint8_t *data, size_t len)
+{
+  while (len--) {
+    crc ^= *data++;
+
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ poly : crc << 1;
+    }
+  }
+
+  return crc;
+}
+
+static uint16_t ref_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+  while (len--) {
+    crc ^= *data++;
+
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+    }
+  }
+
+  return crc;
+}
+
+static uint32_t ref_crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+  while (len--) {
+    crc ^= (uint32_t) *data++ << 24;
+
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+    }
+  }
+
+  return crc;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class CrcTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+
+    data.resize(1024);
+    for (size_t i = 0; i < data.size(); i++) {
+      data[i] = rand();
+    }
+  }
+
+  virtual void TearDown() {
+  }
+
+  std::vector<uint8_t> data;
+};
+
+// Standard check values of "123456789", for every configuration
+TEST_F(CrcTest, CheckValues) {
+  const uint8_t *s = check_string;
+  int32_t len = strlen((const char *) check_string);
+
+  for (const struct crc_impl *impl : all_impls) {
+    SCOPED_TRACE(impl->name);
+
+    EXPECT_EQ(0xF4, impl->crc8(0, s, len));                   /* CRC-8 */
+    EXPECT_EQ(0xBC, impl->crc8_tbs(0, s, len));               /* CRC-8/DVB-S2 */
+    EXPECT_EQ(0x2189, impl->crc16(0, s, len));                /* CRC-16/KERMIT */
+    EXPECT_EQ(0x31C3, impl->crc16_ccitt(0, s, len));          /* CRC-16/XMODEM */
+    EXPECT_EQ(0x0376E6E7u, impl->crc32(0xFFFFFFFF, s, len));  /* CRC-32/MPEG-2 */
+  }
+}
+
+// Every length, offset and starting value matches the bitwise reference
+TEST_F(CrcTest, MatchesReference) {
+  for (const struct crc_impl *impl : all_impls) {
+    SCOPED_TRACE(impl->name);
+
+    for (int32_t len = 0; len <= 100; len++) {
+      for (int offset = 0; offset < 4; offset++) {
+        const uint8_t *p = data.data() + offset;
+        uint8_t seed8 = rand();
+        uint16_t seed16 = rand();
+        uint32_t seed32 = rand() ^ ((uint32_t) rand() << 16);
+
+        ASSERT_EQ(ref_crc8(seed8, 0x07, p, len), impl->crc8(seed8, p, len)) << len;
+        ASSERT_EQ(ref_crc8(seed8, 0xd5, p, len), impl->crc8_tbs(seed8, p, len)) << len;
+        ASSERT_EQ(ref_crc16(seed16, p, len), impl->crc16(seed16, p, len)) << len;
+        ASSERT_EQ(ref_crc32(seed32, p, len), impl->crc32(seed32, p, len)) << len;
+      }
+    }
+
+    /* Single byte updates are the same thing */
+    uint8_t crc8 = 0;
+    uint16_t crc16 = 0;
+    uint32_t crc32 = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < data.size(); i++) {
+      crc8 = impl->crc8_byte(crc8, data[i]);
+      crc16 = impl->crc16_byte(crc16, data[i]);
+      crc32 = impl->crc32_byte(crc32, data[i]);
+    }
+
+    EXPECT_EQ(impl->crc8(0, data.data(), data.size()), crc8);
+    EXPECT_EQ(impl->crc16(0, data.data(), data.size()), crc16);
+    EXPECT_EQ(impl->crc32(0xFFFFFFFF, data.data(), data.size()), crc32);
+  }
+}
+
+// The F3/F4 builds hand whole words to the CRC unit
+TEST_F(CrcTest, HardwareCrc32) {
+  crc_mock_f3_unit.DR.words = 0;
+  crc_mock_f4_unit.DR.words = 0;
+
+  /* Short buffers stay in software */
+  crc_hw_f4.crc32(0xFFFFFFFF, data.data(), 8);
+  EXPECT_EQ(0u, crc_mock_f4_unit.DR.words);
+
+  /* Longer ones use the unit, continuing from any CRC; the F4 needs an
+   * extra word to get there from its reset value */
+  uint32_t seed = 0x12345678;
+  EXPECT_EQ(ref_crc32(seed, data.data() + 1, 1001),
+      crc_hw_f4.crc32(seed, data.data() + 1, 1001));
+  EXPECT_EQ(1000u / 4 + 1, crc_mock_f4_unit.DR.words);
+
+  EXPECT_EQ(ref_crc32(seed, data.data() + 1, 1001),
+      crc_hw_f3.crc32(seed, data.data() + 1, 1001));
+  EXPECT_EQ(1000u / 4, crc_mock_f3_unit.DR.words);
+
+  /* The F3 is left resetting to all ones, as the bootloader helper and
+   * everything else using the unit expects */
+  EXPECT_EQ(0xFFFFFFFFu, crc_mock_f3_unit.INIT);
+
+  /* While someone else holds the unit, the tables are used */
+  ASSERT_TRUE(crc_hw_f4.crc32_hw_claim());
+  EXPECT_FALSE(crc_hw_f4.crc32_hw_claim());
+
+  crc_mock_f4_unit.DR.words = 0;
+  EXPECT_EQ(ref_crc32(seed, data.data(), 1000),
+      crc_hw_f4.crc32(seed, data.data(), 1000));
+  EXPECT_EQ(0u, crc_mock_f4_unit.DR.words);
+
+  crc_hw_f4.crc32_hw_release();
+  EXPECT_TRUE(crc_hw_f4.crc32_hw_claim());
+  crc_hw_f4.crc32_hw_release();
+}
+
+TEST_F(CrcTest, ThroughputVersusBytewise) {
+  std::vector<uint8_t> buf(BENCH_BYTES);
+
+  for (size_t i = 0; i < buf.size(); i++) {
+    buf[i] = rand();
+  }
+
+  for (const struct crc_impl *impl : sw_impls) {
+    double times[3];
+    volatile uint32_t sink = 0;
+    double start = ut_seconds();
+
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+      sink += impl->crc8(sink, buf.data(), buf.size());
+    }
+    times[0] = ut_seconds() - start;
+
+    start = ut_seconds();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+      sink += impl->crc16(sink, buf.data(), buf.size());
+    }
+    times[1] = ut_seconds() - start;
+
+    start = ut_seconds();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+      sink += impl->crc32(sink, buf.data(), buf.size());
+    }
+    times[2] = ut_seconds() - start;
+
+    double mb = (double) BENCH_BYTES * BENCH_ROUNDS / (1024 * 1024);
+
+    printf("%-10s CRC-8 %5.0f MB/s, CRC-16 %5.0f MB/s, CRC-32 %5.0f MB/s\n",
+        impl->name, mb / times[0], mb / times[1], mb / times[2]);
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,237 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "pios.h"
+#include "deadlineheap.h"
+
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class DeadlineHeap : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(&heap, 0, sizeof(heap));
+    memset(entries, 0, sizeof(entries));
+    srand(1234);
+  }
+
+  virtual void TearDown() {
+    for (int i = 0; i < DEADLINE_HEAP_MAX_BLOCKS; i++) {
+      free(heap.blocks[i]);
+    }
+  }
+
+  struct deadline_heap heap;
+  struct deadline_entry entries[DEADLINE_HEAP_MAX_LEN + 1];
+};
+
+TEST_F(DeadlineHeap, Empty) {
+  uint32_t lateness, missed;
+
+  EXPECT_TRUE(deadline_heap_pop_due(&heap, 1000, &lateness, &missed) == NULL);
+  EXPECT_EQ(350u, deadline_heap_time_to_next(&heap, 1000, 350));
+}
+
+TEST_F(DeadlineHeap, MissedPeriodsKeepPhase) {
+  uint32_t lateness, missed;
+
+  /* The first entry has no phase offset */
+  entries[0].period_ms = 10;
+  ASSERT_EQ(0, deadline_heap_add(&heap, &entries[0], 0));
+  EXPECT_EQ(10u, entries[0].next_ms);
+  EXPECT_EQ(10u, deadline_heap_time_to_next(&heap, 0, 350));
+
+  EXPECT_TRUE(deadline_heap_pop_due(&heap, 9, &lateness, &missed) == NULL);
+
+  ASSERT_TRUE(deadline_heap_pop_due(&heap, 45, &lateness, &missed) == &entries[0]);
+  EXPECT_EQ(35u, lateness);
+  EXPECT_EQ(3u, missed);
+  EXPECT_EQ(50u, entries[0].next_ms);
+
+  /* Dispatched once per call, however late */
+  EXPECT_TRUE(deadline_heap_pop_due(&heap, 45, &lateness, &missed) == NULL);
+  EXPECT_EQ(5u, deadline_heap_time_to_next(&heap, 45, 350));
+  EXPECT_EQ(0u, deadline_heap_time_to_next(&heap, 60, 350));
+}
+
+TEST_F(DeadlineHeap, DisabledSortLast) {
+  uint32_t lateness, missed;
+
+  for (int i = 0; i < 5; i++) {
+    entries[i].period_ms = 0;
+    ASSERT_EQ(0, deadline_heap_add(&heap, &entries[i], 0));
+  }
+
+  /* Nothing enabled: nothing is due, and the wait is the most allowed */
+  EXPECT_TRUE(deadline_heap_pop_due(&heap, 100000, &lateness, &missed) == NULL);
+  EXPECT_EQ(350u, deadline_heap_time_to_next(&heap, 0, 350));
+
+  entries[3].period_ms = 20;
+  deadline_heap_reschedule(&heap, &entries[3], 0);
+
+  EXPECT_TRUE(deadline_heap_at(&heap, 0) == &entries[3]);
+  ASSERT_TRUE(deadline_heap_pop_due(&heap, 100, &lateness, &missed) == &entries[3]);
+  EXPECT_TRUE(deadline_heap_pop_due(&heap, 100, &lateness, &missed) == NULL);
+
+  /* Disabling it again puts it back behind everything */
+  entries[3].period_ms = 0;
+  deadline_heap_reschedule(&heap, &entries[3], 100);
+  EXPECT_TRUE(deadline_heap_pop_due(&heap, 100000, &lateness, &missed) == NULL);
+}
+
+TEST_F(DeadlineHeap, PhasesSpread) {
+  const int count = 8;
+  const uint16_t period = 100;
+  bool used[period];
+
+  memset(used, 0, sizeof(used));
+
+  for (int i = 0; i < count; i++) {
+    entries[i].period_ms = period;
+    ASSERT_EQ(0, deadline_heap_add(&heap, &entries[i], 1000));
+
+    uint32_t phase = entries[i].next_ms % period;
+
+    /* Strictly in the future, within a period */
+    EXPECT_GT(entries[i].next_ms, 1000u);
+    EXPECT_LE(entries[i].next_ms, 1000u + period);
+
+    /* No two events share a tick */
+    EXPECT_FALSE(used[phase]);
+    used[phase] = true;
+  }
+
+  /* Adding more never moves the events already scheduled */
+  uint32_t first = entries[0].next_ms;
+
+  entries[count].period_ms = period;
+  ASSERT_EQ(0, deadline_heap_add(&heap, &entries[count], 1000));
+  EXPECT_EQ(first, entries[0].next_ms);
+}
+
+TEST_F(DeadlineHeap, Full) {
+  for (int i = 0; i < DEADLINE_HEAP_MAX_LEN; i++) {
+    entries[i].period_ms = 1 + i % 50;
+    ASSERT_EQ(0, deadline_heap_add(&heap, &entries[i], 0));
+  }
+
+  entries[DEADLINE_HEAP_MAX_LEN].period_ms = 10;
+  EXPECT_EQ(-1, deadline_heap_add(&heap, &entries[DEADLINE_HEAP_MAX_LEN], 0));
+  EXPECT_EQ(DEADLINE_HEAP_MAX_LEN, (int) heap.len);
+}
+
+/* Step the clock a millisecond at a time across the systime wrap, changing
+ * periods at random, and check every dispatch against a brute force search
+ * of the entries. */
+TEST_F(DeadlineHeap, MatchesBruteForce) {
+  const int count = 100;
+  const uint32_t start = 0xffffffff - 2000;
+  uint32_t expected[count];
+  uint32_t lateness, missed;
+
+  for (int i = 0; i < count; i++) {
+    entries[i].period_ms = (rand() % 8 == 0) ? 0 : 1 + rand() % 500;
+    ASSERT_EQ(0, deadline_heap_add(&heap, &entries[i], start));
+    expected[i] = entries[i].next_ms;
+  }
+
+  int dispatched = 0;
+
+  for (uint32_t now = start; now != start + 5000; now++) {
+    struct deadline_entry *prev = NULL;
+    struct deadline_entry *entry;
+
+    while ((entry = deadline_heap_pop_due(&heap, now, &lateness, &missed))) {
+      int i = entry - entries;
+
+      ASSERT_GE(i, 0);
+      ASSERT_LT(i, count);
+      ASSERT_NE(0u, entry->period_ms);
+
+      /* Due now, as the clock never skips */
+      EXPECT_EQ(now, expected[i]);
+      EXPECT_EQ(0u, lateness);
+      EXPECT_EQ(0u, missed);
+
+      /* An entry is dispatched at most once per call */
+      ASSERT_TRUE(entry != prev);
+      prev = entry;
+
+      expected[i] += entry->period_ms;
+      EXPECT_EQ(expected[i], entry->next_ms);
+      dispatched++;
+    }
+
+    /* Nothing else is due */
+    for (int i = 0; i < count; i++) {
+      if (entries[i].period_ms) {
+        ASSERT_GT((int32_t)(expected[i] - now), 0);
+      }
+    }
+
+    /* The wait matches the earliest deadline */
+    uint32_t until = 350;
+
+    for (int i = 0; i < count; i++) {
+      if (entries[i].period_ms && expected[i] - now < until) {
+        until = expected[i] - now;
+      }
+    }
+
+    EXPECT_EQ(until, deadline_heap_time_to_next(&heap, now, 350));
+
+    if (rand() % 20 == 0) {
+      int i = rand() % count;
+
+      entries[i].period_ms = (rand() % 8 == 0) ? 0 : 1 + rand() % 500;
+      deadline_heap_reschedule(&heap, &entries[i], now);
+
+      if (entries[i].period_ms) {
+        EXPECT_GT((int32_t)(entries[i].next_ms - now), 0);
+        EXPECT_LE(entries[i].next_ms - now, (uint32_t) entries[i].period_ms);
+      }
+
+      expected[i] = entries[i].next_ms;
+    }
+  }
+
+  EXPECT_GT(dispatched, count * 10);
+}
@@ -0,0 +1,362 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <stdint.h>		/* uint*_t */
+
+#include <vector>
+
+extern "C" {
+
+#include "geofence_index.h"	/* API for the geofence index */
+
+}
+
+#include <math.h>		/* sqrtf() */
+#include <float.h>		/* FLT_MAX */
+
+typedef std::vector<struct geofence_vertex> fence_t;
+
+static void get_vertex(uint16_t idx, struct geofence_vertex *vertex, void *ctx)
+{
+  *vertex = (*(const fence_t *) ctx)[idx];
+}
+
+static void add_polygon(fence_t &fence, uint8_t polygon, uint8_t type,
+    const float (*pts)[2], int num)
+{
+  for (int i = 0; i < num; i++) {
+    struct geofence_vertex v = { pts[i][0], pts[i][1], polygon, type };
+    fence.push_back(v);
+  }
+}
+
+/* An irregular star around a center, like a survey boundary */
+static void add_star(fence_t &fence, uint8_t polygon, uint8_t type,
+    float cn, float ce, float radius, int num)
+{
+  for (int i = 0; i < num; i++) {
+    float angle = 2 * M_PI * i / num;
+    float r = radius * (0.6f + 0.4f * (rand() / (float) RAND_MAX));
+    struct geofence_vertex v = { cn + r * cosf(angle), ce + r * sinf(angle), polygon, type };
+    fence.push_back(v);
+  }
+}
+
+/* Reference: even-odd ray cast per polygon, over every edge */
+static bool brute_allowed(const fence_t &fence, float pn, float pe)
+{
+  bool any_inclusion = false, included = false, excluded = false;
+  size_t start = 0;
+
+  while (start < fence.size()) {
+    size_t end = start;
+    while (end < fence.size() && fence[end].polygon == fence[start].polygon)
+      end++;
+
+    bool inside = false;
+    for (size_t i = start, j = end - 1; i < end; j = i++) {
+      const struct geofence_vertex &a = fence[i], &b = fence[j];
+      if ((a.north > pn) != (b.north > pn) &&
+          pe < (b.east - a.east) * (pn - a.north) / (b.north - a.north) + a.east)
+        inside = !inside;
+    }
+
+    if (fence[start].type == GEOFENCE_EXCLUSION) {
+      excluded |= inside;
+    } else {
+      any_inclusion = true;
+      included |= inside;
+    }
+
+    start = end;
+  }
+
+  return (!any_inclusion || included) && !excluded;
+}
+
+static float seg_distance(const struct geofence_vertex &a, const struct geofence_vertex &b,
+    float pn, float pe)
+{
+  float dn = b.north - a.north, de = b.east - a.east;
+  float len2 = dn * dn + de * de;
+  float t = len2 > 0 ? ((pn - a.north) * dn + (pe - a.east) * de) / len2 : 0;
+
+  t = fminf(fmaxf(t, 0), 1);
+
+  float rn = a.north + t * dn - pn, re = a.east + t * de - pe;
+
+  return sqrtf(rn * rn + re * re);
+}
+
+static float brute_distance(const fence_t &fence, float pn, float pe)
+{
+  float best = FLT_MAX;
+  size_t start = 0;
+
+  while (start < fence.size()) {
+    size_t end = start;
+    while (end < fence.size() && fence[end].polygon == fence[start].polygon)
+      end++;
+
+    for (size_t i = start, j = end - 1; i < end; j = i++)
+      best = fminf(best, seg_distance(fence[j], fence[i], pn, pe));
+
+    start = end;
+  }
+
+  return best;
+}
+
+class GeofenceIndex : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(42);
+    mem = NULL;
+  }
+
+  virtual void TearDown() {
+    free(mem);
+  }
+
+  int32_t build(const fence_t &fence) {
+    int32_t ret = geofence_index_layout(&idx, fence.size(), get_vertex, (void *) &fence);
+    if (ret == 0) {
+      free(mem);
+      mem = malloc(idx.mem_needed);
+      ret = geofence_index_build(&idx, get_vertex, (void *) &fence, mem);
+    }
+    return ret;
+  }
+
+  /* Compare against the reference at random points around the fence */
+  void check_random(const fence_t &fence, float extent, int points) {
+    int mismatches = 0;
+
+    for (int i = 0; i < points; i++) {
+      float pn = extent * (2 * (rand() / (float) RAND_MAX) - 1);
+      float pe = extent * (2 * (rand() / (float) RAND_MAX) - 1);
+
+      if (geofence_index_allowed(&idx, pn, pe) != brute_allowed(fence, pn, pe))
+        mismatches++;
+
+      float d = brute_distance(fence, pn, pe);
+      EXPECT_NEAR(d, geofence_index_distance(&idx, pn, pe), 1e-3f + d * 1e-5f) << pn << ", " << pe;
+    }
+
+    EXPECT_EQ(0, mismatches);
+  }
+
+  struct geofence_index idx;
+  void *mem;
+};
+
+static const float square[][2] = {
+  { -100, -100 }, { -100, 100 }, { 100, 100 }, { 100, -100 },
+};
+
+static const float hole[][2] = {
+  { -20, -20 }, { -20, 20 }, { 20, 20 }, { 20, -20 },
+};
+
+TEST_F(GeofenceIndex, Square) {
+  fence_t fence;
+
+  add_polygon(fence, 0, GEOFENCE_INCLUSION, square, 4);
+  ASSERT_EQ(0, build(fence));
+
+  EXPECT_EQ(1, idx.num_polygons);
+  EXPECT_TRUE(geofence_index_allowed(&idx, 0, 0));
+  EXPECT_TRUE(geofence_index_allowed(&idx, 99, -99));
+  EXPECT_FALSE(geofence_index_allowed(&idx, 101, 0));
+  EXPECT_FALSE(geofence_index_allowed(&idx, 0, -500));
+
+  EXPECT_NEAR(100, geofence_index_distance(&idx, 0, 0), 1e-3);
+  EXPECT_NEAR(10, geofence_index_distance(&idx, 90, 0), 1e-3);
+  EXPECT_NEAR(10, geofence_index_distance(&idx, 110, 0), 1e-3);
+  EXPECT_NEAR(400, geofence_index_distance(&idx, 0, 500), 1e-3);
+}
+
+TEST_F(GeofenceIndex, ExclusionInsideInclusion) {
+  fence_t fence;
+
+  add_polygon(fence, 3, GEOFENCE_INCLUSION, square, 4);
+  add_polygon(fence, 7, GEOFENCE_EXCLUSION, hole, 4);
+  ASSERT_EQ(0, build(fence));
+
+  EXPECT_EQ(2, idx.num_polygons);
+  EXPECT_FALSE(geofence_index_allowed(&idx, 0, 0));
+  EXPECT_TRUE(geofence_index_allowed(&idx, 50, 50));
+  EXPECT_FALSE(geofence_index_allowed(&idx, 150, 0));
+  EXPECT_NEAR(20, geofence_index_distance(&idx, 0, 0), 1e-3);
+  EXPECT_NEAR(10, geofence_index_distance(&idx, 30, 0), 1e-3);
+
+  check_random(fence, 150, 5000);
+}
+
+TEST_F(GeofenceIndex, ExclusionOnly) {
+  fence_t fence;
+
+  add_polygon(fence, 0, GEOFENCE_EXCLUSION, hole, 4);
+  ASSERT_EQ(0, build(fence));
+
+  EXPECT_FALSE(geofence_index_allowed(&idx, 0, 0));
+  EXPECT_TRUE(geofence_index_allowed(&idx, 50, 0));
+  EXPECT_TRUE(geofence_index_allowed(&idx, 5000, 5000));
+}
+
+TEST_F(GeofenceIndex, InvalidFences) {
+  fence_t fence;
+
+  // Too few vertices
+  add_polygon(fence, 0, GEOFENCE_INCLUSION, square, 2);
+  EXPECT_EQ(-1, build(fence));
+
+  // A polygon of two vertices after a good one
+  fence.clear();
+  add_polygon(fence, 0, GEOFENCE_INCLUSION, square, 4);
+  add_polygon(fence, 1, GEOFENCE_EXCLUSION, hole, 2);
+  EXPECT_EQ(-1, build(fence));
+
+  // A polygon split in two
+  fence.clear();
+  add_polygon(fence, 0, GEOFENCE_INCLUSION, square, 4);
+  add_polygon(fence, 1, GEOFENCE_EXCLUSION, hole, 4);
+  add_polygon(fence, 0, GEOFENCE_INCLUSION, square, 4);
+  EXPECT_EQ(-1, build(fence));
+
+  // Not a number
+  fence.clear();
+  add_polygon(fence, 0, GEOFENCE_INCLUSION, square, 4);
+  fence[2].east = NAN;
+  EXPECT_EQ(-1, build(fence));
+
+  // Too many polygons
+  fence.clear();
+  for (int i = 0; i <= GEOFENCE_MAX_POLYGONS; i++)
+    add_star(fence, i, GEOFENCE_EXCLUSION, 0, i * 100.0f, 40, 5);
+  EXPECT_EQ(-1, build(fence));
+}
+
+TEST_F(GeofenceIndex, ChangedAfterLayout) {
+  fence_t fence;
+
+  add_polygon(fence, 0, GEOFENCE_INCLUSION, square, 4);
+  ASSERT_EQ(0, geofence_index_layout(&idx, fence.size(), get_vertex, &fence));
+  mem = malloc(idx.mem_needed);
+
+  // A longer edge is in more cells than were laid out
+  fence_t moved = fence;
+  moved[2].north = 5000;
+  EXPECT_EQ(-1, geofence_index_build(&idx, get_vertex, &moved, mem));
+
+  // One polygon became two
+  fence_t split = fence;
+  split[3].polygon = 1;
+  EXPECT_EQ(-1, geofence_index_build(&idx, get_vertex, &split, mem));
+
+  EXPECT_EQ(0, geofence_index_build(&idx, get_vertex, &fence, mem));
+}
+
+TEST_F(GeofenceIndex, AxisAlignedEdges) {
+  fence_t fence;
+
+  // A staircase, with runs of vertices on the same row and column
+  for (int i = 0; i < 20; i++) {
+    struct geofence_vertex a = { (float) i * 10, (float) i * 10, 0, GEOFENCE_INCLUSION };
+    struct geofence_vertex b = { (float) i * 10, (float) (i + 1) * 10, 0, GEOFENCE_INCLUSION };
+    fence.push_back(a);
+    fence.push_back(b);
+  }
+  struct geofence_vertex corner = { 200, 0, 0, GEOFENCE_INCLUSION };
+  fence.push_back(corner);
+
+  ASSERT_EQ(0, build(fence));
+  check_random(fence, 220, 5000);
+}
+
+TEST_F(GeofenceIndex, ManyVertices) {
+  fence_t fence;
+
+  add_star(fence, 0, GEOFENCE_INCLUSION, 0, 0, 1000, 1000);
+  add_star(fence, 1, GEOFENCE_EXCLUSION, 200, -100, 150, 200);
+  add_star(fence, 2, GEOFENCE_EXCLUSION, -300, 250, 100, 100);
+  ASSERT_EQ(0, build(fence));
+
+  EXPECT_LE(idx.rows * idx.cols, GEOFENCE_MAX_CELLS);
+  check_random(fence, 1100, 20000);
+}
+
+TEST_F(GeofenceIndex, Benchmark) {
+  const int iterations = 20000;
+  fence_t fence;
+  std::vector<float> pts;
+
+  add_star(fence, 0, GEOFENCE_INCLUSION, 0, 0, 1000, 1000);
+  add_star(fence, 1, GEOFENCE_EXCLUSION, 200, -100, 150, 200);
+
+  double start = ut_seconds();
+  ASSERT_EQ(0, build(fence));
+  double build_time = ut_seconds() - start;
+
+  for (int i = 0; i < 2 * iterations; i++)
+    pts.push_back(1100 * (2 * (rand() / (float) RAND_MAX) - 1));
+
+  int sink = 0;
+  float dsink = 0;
+
+  start = ut_seconds();
+  for (int i = 0; i < iterations; i++) {
+    sink += brute_allowed(fence, pts[2 * i], pts[2 * i + 1]);
+    dsink += brute_distance(fence, pts[2 * i], pts[2 * i + 1]);
+  }
+  double brute = ut_seconds() - start;
+
+  start = ut_seconds();
+  for (int i = 0; i < iterations; i++) {
+    sink -= geofence_index_allowed(&idx, pts[2 * i], pts[2 * i + 1]);
+    dsink -= geofence_index_distance(&idx, pts[2 * i], pts[2 * i + 1]);
+  }
+  double indexed = ut_seconds() - start;
+
+  EXPECT_EQ(0, sink);
+  EXPECT_NEAR(0, dsink, 1);
+
+  printf("1200 vertices, %dx%d cells, %u edge references, %u bytes\n",
+      idx.cols, idx.rows, (unsigned) idx.num_refs, (unsigned) idx.mem_needed);
+  printf("build %.2f ms; check and distance: brute force %.2f us, indexed %.2f us\n",
+      build_time * 1e3, brute / iterations * 1e6, indexed / iterations * 1e6);
+}
@@ -0,0 +1,17 @@
+/* Stand-in for the generated UAVO header, with the fields the parsers use. */
+#ifndef GPSTIME_H
+#define GPSTIME_H
+
+typedef struct {
+	int16_t Year;
+	int8_t Month;
+	int8_t Day;
+	int8_t Hour;
+	int8_t Minute;
+	int8_t Second;
+} GPSTimeData;
+
+int32_t GPSTimeSet(GPSTimeData *data);
+int32_t GPSTimeGet(GPSTimeData *data);
+
+#endif /* GPSTIME_H */
@@ -0,0 +1,14 @@
+/* Stand-in for the generated UAVO header, with the fields the parsers use. */
+#ifndef GPSVELOCITY_H
+#define GPSVELOCITY_H
+
+typedef struct {
+	float North;
+	float East;
+	float Down;
+	float Accuracy;
+} GPSVelocityData;
+
+int32_t GPSVelocitySet(GPSVelocityData *data);
+
+#endif /* GPSVELOCITY_H */
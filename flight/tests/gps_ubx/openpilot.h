@@ -0,0 +1,2 @@
+/* Stand-in for openpilot.h; the parsers only need PiOS. */
+#include <pios.h>
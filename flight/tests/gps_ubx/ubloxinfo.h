@@ -0,0 +1,15 @@
+/* Stand-in for the generated UAVO header, with the fields the parsers use. */
+#ifndef UBLOXINFO_H
+#define UBLOXINFO_H
+
+typedef struct {
+	uint32_t swVersion;
+	uint32_t ParseErrors;
+	uint16_t hwVersion;
+} UBloxInfoData;
+
+int32_t UBloxInfoSet(UBloxInfoData *data);
+int32_t UBloxInfoGet(UBloxInfoData *data);
+int32_t UBloxInfoParseErrorsSet(uint32_t *value);
+
+#endif /* UBLOXINFO_H */
@@ -0,0 +1,547 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+#include <vector>
+
+extern "C" {
+
+#include "unittest_mocks.h"
+#include "NMEA.h"
+
+/* UBX.h uses C++ keywords as field names, so only the entry point is declared */
+int parse_ubx_stream(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+
+}
+
+#define UBX_CLASS_NAV	0x01
+#define UBX_ID_POSLLH	0x02
+#define UBX_ID_DOP	0x04
+#define UBX_ID_SOL	0x06
+#define UBX_ID_PVT	0x07
+#define UBX_ID_VELNED	0x12
+
+#define NAV_PVT_LEN	92
+
+static void put_u8(std::vector<uint8_t> &p, size_t off, uint8_t v)
+{
+	p[off] = v;
+}
+
+static void put_u16(std::vector<uint8_t> &p, size_t off, uint16_t v)
+{
+	p[off] = v & 0xff;
+	p[off + 1] = v >> 8;
+}
+
+static void put_u32(std::vector<uint8_t> &p, size_t off, uint32_t v)
+{
+	for (int i = 0; i < 4; i++) {
+		p[off + i] = (v >> (8 * i)) & 0xff;
+	}
+}
+
+/* Frame a payload with the sync characters, header and Fletcher checksum */
+static void ubx_append(std::vector<uint8_t> &out, uint8_t cls, uint8_t id,
+		const std::vector<uint8_t> &payload)
+{
+	std::vector<uint8_t> body;
+
+	body.push_back(cls);
+	body.push_back(id);
+	body.push_back(payload.size() & 0xff);
+	body.push_back(payload.size() >> 8);
+	body.insert(body.end(), payload.begin(), payload.end());
+
+	uint8_t ck_a = 0, ck_b = 0;
+
+	for (uint8_t c : body) {
+		ck_a += c;
+		ck_b += ck_a;
+	}
+
+	out.push_back(0xb5);
+	out.push_back(0x62);
+	out.insert(out.end(), body.begin(), body.end());
+	out.push_back(ck_a);
+	out.push_back(ck_b);
+}
+
+struct fix {
+	uint32_t tow;
+	int32_t lat, lon;
+	int32_t height, hmsl;
+	int32_t vel_n, vel_e, vel_d;	/* mm/s */
+	uint8_t num_sv;
+};
+
+static struct fix make_fix(uint32_t tow, int i)
+{
+	struct fix f;
+
+	f.tow = tow;
+	f.lat = 474000000 + i * 37;
+	f.lon = 85000000 - i * 53;
+	f.hmsl = 450000 + i * 10;
+	f.height = f.hmsl + 48000;
+	f.vel_n = 5000 + (i % 7) * 100;
+	f.vel_e = -3000 + (i % 5) * 100;
+	f.vel_d = -(i % 3) * 100;
+	f.num_sv = 8 + i % 6;
+
+	return f;
+}
+
+static void append_pvt(std::vector<uint8_t> &out, const struct fix &f)
+{
+	std::vector<uint8_t> p(NAV_PVT_LEN, 0);
+
+	put_u32(p, 0, f.tow);
+	put_u16(p, 4, 2017);
+	put_u8(p, 6, 5);
+	put_u8(p, 7, 14);
+	put_u8(p, 8, 12);
+	put_u8(p, 9, 34);
+	put_u8(p, 10, (f.tow / 1000) % 60);
+	put_u8(p, 11, 0x03);			/* valid date and time */
+	put_u8(p, 20, 3);			/* 3D fix */
+	put_u8(p, 21, 0x01);			/* gnssFixOK */
+	put_u8(p, 23, f.num_sv);
+	put_u32(p, 24, f.lon);
+	put_u32(p, 28, f.lat);
+	put_u32(p, 32, f.height);
+	put_u32(p, 36, f.hmsl);
+	put_u32(p, 40, 1500);			/* hAcc */
+	put_u32(p, 44, 2000);			/* vAcc */
+	put_u32(p, 48, f.vel_n);
+	put_u32(p, 52, f.vel_e);
+	put_u32(p, 56, f.vel_d);
+	put_u32(p, 60, 5831);			/* gSpeed */
+	put_u32(p, 64, 32000000);		/* headMot, 320 deg */
+	put_u32(p, 68, 250);			/* sAcc */
+	put_u16(p, 76, 145);			/* pDOP */
+
+	ubx_append(out, UBX_CLASS_NAV, UBX_ID_PVT, p);
+}
+
+/* The message set sent by u-blox 6 and earlier for one solution */
+static void append_legacy(std::vector<uint8_t> &out, const struct fix &f)
+{
+	std::vector<uint8_t> posllh(28, 0);
+
+	put_u32(posllh, 0, f.tow);
+	put_u32(posllh, 4, f.lon);
+	put_u32(posllh, 8, f.lat);
+	put_u32(posllh, 12, f.height);
+	put_u32(posllh, 16, f.hmsl);
+	ubx_append(out, UBX_CLASS_NAV, UBX_ID_POSLLH, posllh);
+
+	std::vector<uint8_t> sol(52, 0);
+
+	put_u32(sol, 0, f.tow);
+	put_u8(sol, 10, 3);
+	put_u8(sol, 11, 0x01);
+	put_u32(sol, 24, 250);
+	put_u16(sol, 44, 145);
+	put_u8(sol, 47, f.num_sv);
+	ubx_append(out, UBX_CLASS_NAV, UBX_ID_SOL, sol);
+
+	std::vector<uint8_t> velned(36, 0);
+
+	put_u32(velned, 0, f.tow);
+	put_u32(velned, 4, f.vel_n / 10);
+	put_u32(velned, 8, f.vel_e / 10);
+	put_u32(velned, 12, f.vel_d / 10);
+	put_u32(velned, 20, 583);
+	put_u32(velned, 24, 32000000);
+	ubx_append(out, UBX_CLASS_NAV, UBX_ID_VELNED, velned);
+
+	std::vector<uint8_t> dop(18, 0);
+
+	put_u32(dop, 0, f.tow);
+	put_u16(dop, 10, 90);
+	put_u16(dop, 12, 120);
+	ubx_append(out, UBX_CLASS_NAV, UBX_ID_DOP, dop);
+}
+
+/*
+ * Several seconds of receiver output: alternating legacy sets and NAV-PVT,
+ * with line noise between some frames and one frame damaged in transit.
+ */
+static std::vector<uint8_t> make_stream(uint32_t tow, int seconds)
+{
+	std::vector<uint8_t> out;
+
+	for (int i = 0; i < seconds; i++, tow += 200) {
+		struct fix f = make_fix(tow, i);
+
+		if (i % 2)
+			append_pvt(out, f);
+		else
+			append_legacy(out, f);
+
+		if (i % 10 == 3) {
+			for (int j = 0; j < 17; j++)
+				out.push_back(0x20 + j);
+		}
+
+		if (i == seconds / 2) {
+			size_t start = out.size();
+
+			append_pvt(out, make_fix(tow + 100, i));
+			out[start + 30] ^= 0x40;
+		}
+	}
+
+	return out;
+}
+
+struct feed_result {
+	struct GPS_RX_STATS stats;
+	uint32_t position_sets;
+	uint32_t velocity_sets;
+	uint32_t time_sets;
+	GPSPositionData position;
+	GPSVelocityData velocity;
+};
+
+static char rx_buffer[1024] __attribute__((aligned(4)));
+
+/* Feed the stream in chunks of up to max_chunk bytes (1 means per byte) */
+static struct feed_result feed_ubx(const std::vector<uint8_t> &stream, int max_chunk)
+{
+	struct feed_result r;
+	GPSPositionData position;
+
+	memset(&r, 0, sizeof(r));
+	memset(&position, 0, sizeof(position));
+	mock_uavos_reset();
+
+	for (size_t i = 0; i < stream.size(); ) {
+		size_t n = (max_chunk > 1) ? 1 + rand() % max_chunk : 1;
+
+		if (n > stream.size() - i)
+			n = stream.size() - i;
+
+		parse_ubx_stream(&stream[i], n, rx_buffer, &position, &r.stats);
+		i += n;
+	}
+
+	r.position_sets = mock_gpsposition_sets;
+	r.velocity_sets = mock_gpsvelocity_sets;
+	r.time_sets = mock_gpstime_sets;
+	r.position = mock_gpsposition;
+	r.velocity = mock_gpsvelocity;
+
+	return r;
+}
+
+/*
+ * The parser keeps the time of week of the last message set, so every
+ * stream must start after the end of the previous one.
+ */
+static uint32_t next_tow = 1000;
+
+static std::vector<uint8_t> next_stream(int seconds)
+{
+	std::vector<uint8_t> s = make_stream(next_tow, seconds);
+
+	next_tow += seconds * 200 + 1000;
+
+	return s;
+}
+
+class GpsUbxTest : public testing::Test {
+protected:
+	virtual void SetUp() {
+		srand(17);
+	}
+};
+
+TEST_F(GpsUbxTest, PvtDecode) {
+	std::vector<uint8_t> stream;
+	struct fix f = make_fix(next_tow, 3);
+
+	next_tow += 1000;
+	append_pvt(stream, f);
+
+	struct feed_result r = feed_ubx(stream, 512);
+
+	EXPECT_EQ(1, r.stats.gpsRxReceived);
+	EXPECT_EQ(0, r.stats.gpsRxChkSumError);
+	EXPECT_EQ(1U, r.position_sets);
+	EXPECT_EQ(1U, r.velocity_sets);
+	EXPECT_EQ(1U, r.time_sets);
+
+	EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, r.position.Status);
+	EXPECT_EQ(f.lat, r.position.Latitude);
+	EXPECT_EQ(f.lon, r.position.Longitude);
+	EXPECT_EQ(f.num_sv, r.position.Satellites);
+	EXPECT_NEAR(f.hmsl * 0.001f, r.position.Altitude, 1e-3);
+	EXPECT_NEAR(48.0f, r.position.GeoidSeparation, 1e-3);
+	EXPECT_NEAR(5.831f, r.position.Groundspeed, 1e-4);
+	EXPECT_NEAR(320.0f, r.position.Heading, 1e-3);
+	EXPECT_NEAR(2.5f, r.position.Accuracy, 1e-4);
+	EXPECT_NEAR(1.45f, r.position.PDOP, 1e-4);
+
+	EXPECT_NEAR(f.vel_n * 0.001f, r.velocity.North, 1e-4);
+	EXPECT_NEAR(f.vel_e * 0.001f, r.velocity.East, 1e-4);
+	EXPECT_NEAR(f.vel_d * 0.001f, r.velocity.Down, 1e-4);
+	EXPECT_NEAR(0.25f, r.velocity.Accuracy, 1e-4);
+
+	EXPECT_EQ(2017, mock_gpstime.Year);
+	EXPECT_EQ(5, mock_gpstime.Month);
+	EXPECT_EQ(14, mock_gpstime.Day);
+	EXPECT_EQ(12, mock_gpstime.Hour);
+	EXPECT_EQ(34, mock_gpstime.Minute);
+}
+
+TEST_F(GpsUbxTest, PvtWithoutFix) {
+	std::vector<uint8_t> stream;
+	struct fix f = make_fix(next_tow, 0);
+
+	next_tow += 1000;
+	append_pvt(stream, f);
+
+	/* Clear gnssFixOK and the time validity, then fix up the checksum */
+	std::vector<uint8_t> payload(stream.begin() + 6, stream.end() - 2);
+
+	payload[11] = 0;
+	payload[21] = 0;
+	stream.clear();
+	ubx_append(stream, UBX_CLASS_NAV, UBX_ID_PVT, payload);
+
+	struct feed_result r = feed_ubx(stream, 1);
+
+	EXPECT_EQ(1U, r.position_sets);
+	EXPECT_EQ(0U, r.velocity_sets);
+	EXPECT_EQ(0U, r.time_sets);
+	EXPECT_EQ(GPSPOSITION_STATUS_NOFIX, r.position.Status);
+	EXPECT_EQ(f.num_sv, r.position.Satellites);
+}
+
+TEST_F(GpsUbxTest, LegacySetPublishesOnce) {
+	std::vector<uint8_t> stream;
+	struct fix f = make_fix(next_tow, 2);
+
+	next_tow += 1000;
+	append_legacy(stream, f);
+
+	struct feed_result r = feed_ubx(stream, 64);
+
+	EXPECT_EQ(4, r.stats.gpsRxReceived);
+	EXPECT_EQ(1U, r.position_sets);
+	EXPECT_EQ(1U, r.velocity_sets);
+	EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, r.position.Status);
+	EXPECT_EQ(f.lat, r.position.Latitude);
+	EXPECT_EQ(f.lon, r.position.Longitude);
+	EXPECT_NEAR(1.2f, r.position.HDOP, 1e-4);
+	EXPECT_NEAR(0.9f, r.position.VDOP, 1e-4);
+}
+
+TEST_F(GpsUbxTest, ReturnValues) {
+	std::vector<uint8_t> stream;
+
+	append_pvt(stream, make_fix(next_tow, 0));
+	next_tow += 1000;
+
+	GPSPositionData position;
+	struct GPS_RX_STATS stats;
+
+	memset(&position, 0, sizeof(position));
+	memset(&stats, 0, sizeof(stats));
+
+	const uint8_t noise[] = { 0x00, 0x11, 0x22 };
+
+	EXPECT_EQ(PARSER_ERROR, parse_ubx_stream(noise, sizeof(noise), rx_buffer, &position, &stats));
+
+	/* Everything but the last checksum byte is still incomplete */
+	EXPECT_EQ(PARSER_INCOMPLETE, parse_ubx_stream(&stream[0], 1, rx_buffer, &position, &stats));
+	EXPECT_EQ(PARSER_INCOMPLETE, parse_ubx_stream(&stream[1], stream.size() - 2, rx_buffer, &position, &stats));
+	EXPECT_EQ(PARSER_COMPLETE, parse_ubx_stream(&stream[stream.size() - 1], 1, rx_buffer, &position, &stats));
+	EXPECT_EQ(1, stats.gpsRxReceived);
+}
+
+TEST_F(GpsUbxTest, ResyncAfterBadFrames) {
+	std::vector<uint8_t> stream;
+
+	/* A repeated sync character */
+	stream.push_back(0xb5);
+
+	/* A frame longer than any message the parser knows */
+	stream.push_back(0xb5);
+	stream.push_back(0x62);
+	stream.push_back(UBX_CLASS_NAV);
+	stream.push_back(UBX_ID_PVT);
+	stream.push_back(0xe8);
+	stream.push_back(0x03);
+
+	/* A frame with a bad checksum */
+	size_t bad = stream.size();
+
+	append_pvt(stream, make_fix(next_tow, 0));
+	stream[bad + 40] ^= 0x01;
+
+	append_pvt(stream, make_fix(next_tow + 200, 1));
+	next_tow += 1000;
+
+	struct feed_result r = feed_ubx(stream, 1);
+
+	EXPECT_EQ(1, r.stats.gpsRxOverflow);
+	EXPECT_EQ(1, r.stats.gpsRxChkSumError);
+	EXPECT_EQ(1, r.stats.gpsRxReceived);
+	EXPECT_EQ(1U, r.position_sets);
+	EXPECT_EQ(make_fix(0, 1).lat, r.position.Latitude);
+}
+
+TEST_F(GpsUbxTest, ChunkingDoesNotMatter) {
+	const int seconds = 200;
+
+	struct feed_result bytewise = feed_ubx(next_stream(seconds), 1);
+
+	/* 100 PVT fixes plus 100 legacy sets, one PVT frame corrupted */
+	EXPECT_EQ((uint32_t) seconds, bytewise.position_sets);
+	EXPECT_EQ(1, bytewise.stats.gpsRxChkSumError);
+	EXPECT_EQ(0, bytewise.stats.gpsRxOverflow);
+
+	const int chunks[] = { 2, 7, 64, 128, 1000 };
+
+	for (int max_chunk : chunks) {
+		struct feed_result r = feed_ubx(next_stream(seconds), max_chunk);
+
+		EXPECT_EQ(bytewise.stats.gpsRxReceived, r.stats.gpsRxReceived) << max_chunk;
+		EXPECT_EQ(bytewise.stats.gpsRxChkSumError, r.stats.gpsRxChkSumError) << max_chunk;
+		EXPECT_EQ(bytewise.stats.gpsRxOverflow, r.stats.gpsRxOverflow) << max_chunk;
+		EXPECT_EQ(bytewise.position_sets, r.position_sets) << max_chunk;
+		EXPECT_EQ(bytewise.velocity_sets, r.velocity_sets) << max_chunk;
+		EXPECT_EQ(bytewise.time_sets, r.time_sets) << max_chunk;
+		EXPECT_EQ(bytewise.position.Latitude, r.position.Latitude) << max_chunk;
+		EXPECT_EQ(bytewise.position.Longitude, r.position.Longitude) << max_chunk;
+		EXPECT_EQ(bytewise.velocity.North, r.velocity.North) << max_chunk;
+	}
+}
+
+TEST_F(GpsUbxTest, Benchmark) {
+	const int chunks[] = { 1, 64 };
+	const int reps = 5;
+
+	for (int chunk : chunks) {
+		/* Fresh times of week for each pass, generated outside the timing */
+		std::vector<std::vector<uint8_t> > streams;
+
+		for (int rep = 0; rep < reps; rep++)
+			streams.push_back(next_stream(2000));
+
+		size_t bytes = 0;
+		double start = ut_seconds();
+
+		for (const std::vector<uint8_t> &stream : streams) {
+			struct feed_result r = feed_ubx(stream, chunk);
+
+			EXPECT_EQ(2000U, r.position_sets);
+			bytes += stream.size();
+		}
+
+		double elapsed = ut_seconds() - start;
+
+		printf("%d byte reads: %.1f MB/s\n", chunk, bytes / elapsed / 1e6);
+	}
+}
+
+static std::string nmea_sentence(const char *body)
+{
+	uint8_t sum = 0;
+	char tail[8];
+
+	for (const char *p = body; *p; p++)
+		sum ^= *p;
+
+	snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+
+	return std::string("$") + body + tail;
+}
+
+TEST_F(GpsUbxTest, NmeaSplitAcrossChunks) {
+	std::string s = nmea_sentence("GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+	const uint8_t *p = (const uint8_t *) s.data();
+
+	GPSPositionData position;
+	struct GPS_RX_STATS stats;
+
+	memset(&position, 0, sizeof(position));
+	memset(&stats, 0, sizeof(stats));
+	mock_uavos_reset();
+
+	/* Garbage before the start, then a sentence split mid-way and at the \r\n */
+	const uint8_t junk[] = "\xb5\x62xyz";
+
+	EXPECT_EQ(PARSER_ERROR, parse_nmea_stream(junk, sizeof(junk) - 1, rx_buffer, &position, &stats));
+	EXPECT_EQ(PARSER_INCOMPLETE, parse_nmea_stream(p, 20, rx_buffer, &position, &stats));
+	EXPECT_EQ(PARSER_INCOMPLETE, parse_nmea_stream(p + 20, s.size() - 21, rx_buffer, &position, &stats));
+	EXPECT_EQ(PARSER_COMPLETE, parse_nmea_stream(p + s.size() - 1, 1, rx_buffer, &position, &stats));
+
+	EXPECT_EQ(1, stats.gpsRxReceived);
+	EXPECT_EQ(0, stats.gpsRxChkSumError);
+	EXPECT_EQ(1U, mock_gpsposition_sets);
+	EXPECT_EQ(8, mock_gpsposition.Satellites);
+	EXPECT_NEAR(545.4f, mock_gpsposition.Altitude, 1e-3);
+
+	/* Two sentences in one read, the first damaged */
+	std::string two = s + s;
+
+	two[10] = '9';
+	EXPECT_EQ(PARSER_COMPLETE, parse_nmea_stream((const uint8_t *) two.data(), two.size(), rx_buffer, &position, &stats));
+	EXPECT_EQ(2, stats.gpsRxReceived);
+	EXPECT_EQ(1, stats.gpsRxChkSumError);
+}
+
+TEST_F(GpsUbxTest, NmeaOverflow) {
+	GPSPositionData position;
+	struct GPS_RX_STATS stats;
+
+	memset(&position, 0, sizeof(position));
+	memset(&stats, 0, sizeof(stats));
+
+	std::string s = "$" + std::string(NMEA_MAX_PACKET_LENGTH + 10, 'A') +
+		nmea_sentence("GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+
+	parse_nmea_stream((const uint8_t *) s.data(), s.size(), rx_buffer, &position, &stats);
+
+	EXPECT_EQ(1, stats.gpsRxOverflow);
+	EXPECT_EQ(1, stats.gpsRxReceived);
+}
@@ -0,0 +1,87 @@
+/*
+ * Stand-ins for the UAVO accessors the GPS parsers call, recording what
+ * gets published.
+ */
+
+#include "pios.h"
+
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "gpstime.h"
+#include "gpssatellites.h"
+#include "ubloxinfo.h"
+
+#include "unittest_mocks.h"
+
+GPSPositionData mock_gpsposition;
+GPSVelocityData mock_gpsvelocity;
+GPSTimeData mock_gpstime;
+
+uint32_t mock_gpsposition_sets;
+uint32_t mock_gpsvelocity_sets;
+uint32_t mock_gpstime_sets;
+
+static UBloxInfoData ubloxinfo;
+
+void mock_uavos_reset(void)
+{
+	memset(&mock_gpsposition, 0, sizeof(mock_gpsposition));
+	memset(&mock_gpsvelocity, 0, sizeof(mock_gpsvelocity));
+	memset(&mock_gpstime, 0, sizeof(mock_gpstime));
+	memset(&ubloxinfo, 0, sizeof(ubloxinfo));
+
+	mock_gpsposition_sets = 0;
+	mock_gpsvelocity_sets = 0;
+	mock_gpstime_sets = 0;
+}
+
+int32_t GPSPositionSet(GPSPositionData *data)
+{
+	mock_gpsposition = *data;
+	mock_gpsposition_sets++;
+	return 0;
+}
+
+int32_t GPSVelocitySet(GPSVelocityData *data)
+{
+	mock_gpsvelocity = *data;
+	mock_gpsvelocity_sets++;
+	return 0;
+}
+
+int32_t GPSTimeSet(GPSTimeData *data)
+{
+	mock_gpstime = *data;
+	mock_gpstime_sets++;
+	return 0;
+}
+
+int32_t GPSTimeGet(GPSTimeData *data)
+{
+	*data = mock_gpstime;
+	return 0;
+}
+
+int32_t GPSSatellitesSet(GPSSatellitesData *data)
+{
+	(void) data;
+	return 0;
+}
+
+int32_t UBloxInfoSet(UBloxInfoData *data)
+{
+	ubloxinfo = *data;
+	return 0;
+}
+
+int32_t UBloxInfoGet(UBloxInfoData *data)
+{
+	*data = ubloxinfo;
+	return 0;
+}
+
+int32_t UBloxInfoParseErrorsSet(uint32_t *value)
+{
+	ubloxinfo.ParseErrors = *value;
+	return 0;
+}
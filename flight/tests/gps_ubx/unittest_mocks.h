@@ -0,0 +1,25 @@
+/*
+ * Shared between the UAVO stand-ins and the test driver.
+ */
+
+#ifndef UNITTEST_MOCKS_H
+#define UNITTEST_MOCKS_H
+
+#include <stdint.h>
+
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "gpstime.h"
+
+/* Last value published to each object, and how many times it was set */
+extern GPSPositionData mock_gpsposition;
+extern GPSVelocityData mock_gpsvelocity;
+extern GPSTimeData mock_gpstime;
+
+extern uint32_t mock_gpsposition_sets;
+extern uint32_t mock_gpsvelocity_sets;
+extern uint32_t mock_gpstime_sets;
+
+void mock_uavos_reset(void);
+
+#endif /* UNITTEST_MOCKS_H */
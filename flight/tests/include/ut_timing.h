@@ -0,0 +1,63 @@
+/**
+ ******************************************************************************
+ * @file       ut_timing.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Clocks for the timings the unit tests print
+ *
+ * Timings are printed for reference only.  Test machines are shared and
+ * loaded, so never assert on them; count the work done instead.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef UT_TIMING_H
+#define UT_TIMING_H
+
+#include <time.h>		/* clock_gettime */
+
+/**
+ * Wall time, in seconds from an arbitrary start
+ */
+static inline double ut_seconds()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * CPU time used by the process, in seconds
+ */
+static inline double ut_cpu_seconds()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#endif /* UT_TIMING_H */
+
+/**
+ * @}
+ * @}
+ */
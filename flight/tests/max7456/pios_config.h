@@ -0,0 +1,3 @@
+#define PIOS_NO_HW
+#define FLIGHT_POSIX
+#define PIOS_INCLUDE_MAX7456
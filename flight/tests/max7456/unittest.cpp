@@ -0,0 +1,277 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_max7456.h"
+
+#include "unittest_mocks.h"
+
+}
+
+#define COLS MAX7456_PAL_COLUMNS
+#define ROWS MAX7456_PAL_ROWS
+
+// To use a test fixture, derive a class from testing::Test.
+class Max7456Shadow : public testing::Test {
+protected:
+  virtual void SetUp() {
+    mock_max7456_reset();
+
+    ASSERT_EQ(0, PIOS_MAX7456_init(&dev, NULL, 0));
+
+    memset(ref_chr, 0, sizeof(ref_chr));
+    memset(ref_attr, 0, sizeof(ref_attr));
+  }
+
+  /* Mirrors what the driver should draw, for comparison with the chip */
+  void ref_puts(uint8_t col, uint8_t row, const char *s, uint8_t attr) {
+    for (int pos = row * COLS + col; *s && pos < ROWS * COLS; s++, pos++) {
+      ref_chr[pos] = (uint8_t) *s;
+      ref_attr[pos] = attr;
+    }
+  }
+
+  void puts(uint8_t col, uint8_t row, const char *s, uint8_t attr) {
+    PIOS_MAX7456_puts(dev, col, row, s, attr);
+    ref_puts(col, row, s, attr);
+  }
+
+  void put(uint8_t col, uint8_t row, uint8_t chr, uint8_t attr) {
+    PIOS_MAX7456_put(dev, col, row, chr, attr);
+    ref_chr[row * COLS + col] = chr;
+    ref_attr[row * COLS + col] = attr;
+  }
+
+  void clear() {
+    PIOS_MAX7456_clear(dev);
+    memset(ref_chr, 0, sizeof(ref_chr));
+    memset(ref_attr, 0, sizeof(ref_attr));
+  }
+
+  void expect_chip_matches() {
+    for (int pos = 0; pos < ROWS * COLS; pos++) {
+      EXPECT_EQ(ref_chr[pos], mock_max7456_chr[pos]) << "cell " << pos;
+      EXPECT_EQ(ref_attr[pos], mock_max7456_attr[pos]) << "cell " << pos;
+    }
+  }
+
+  max7456_dev_t dev;
+
+  uint8_t ref_chr[ROWS * COLS];
+  uint8_t ref_attr[ROWS * COLS];
+};
+
+TEST_F(Max7456Shadow, NothingSentUntilFlush) {
+  mock_spi_bytes = 0;
+
+  puts(3, 2, "HELLO", 0);
+  put(0, 0, 'X', MAX7456_ATTR_INVERT);
+
+  EXPECT_EQ(0u, mock_spi_bytes);
+  EXPECT_EQ(0, mock_max7456_chr[2 * COLS + 3]);
+
+  uint32_t sent = PIOS_MAX7456_flush(dev);
+
+  EXPECT_EQ(sent, mock_spi_bytes);
+  expect_chip_matches();
+}
+
+TEST_F(Max7456Shadow, UnchangedFrameSendsNothing) {
+  clear();
+  puts(1, 1, "ALT 123", 0);
+  puts(MAX7456_FMT_H_CENTER - 10, 12, "12.6V", MAX7456_ATTR_BLINK);
+  PIOS_MAX7456_flush(dev);
+  expect_chip_matches();
+
+  /* The OSD task clears and redraws every frame */
+  clear();
+  puts(1, 1, "ALT 123", 0);
+  puts(MAX7456_FMT_H_CENTER - 10, 12, "12.6V", MAX7456_ATTR_BLINK);
+
+  EXPECT_EQ(0u, PIOS_MAX7456_flush(dev));
+}
+
+TEST_F(Max7456Shadow, OnlyChangedCellsSent) {
+  puts(1, 1, "ALT 123", 0);
+  PIOS_MAX7456_flush(dev);
+
+  puts(1, 1, "ALT 124", 0);
+
+  /* One burst: offset, mode, one character, stop */
+  EXPECT_EQ(10u, PIOS_MAX7456_flush(dev));
+  expect_chip_matches();
+}
+
+TEST_F(Max7456Shadow, ClearedCellsAreBlanked) {
+  puts(0, 5, "SOMETHING LONG", 0);
+  PIOS_MAX7456_flush(dev);
+
+  clear();
+  puts(0, 5, "SHORT", 0);
+  PIOS_MAX7456_flush(dev);
+
+  expect_chip_matches();
+}
+
+TEST_F(Max7456Shadow, AttributesAndStopCharacter) {
+  puts(0, 0, "AB", MAX7456_ATTR_INVERT);
+  put(2, 0, 0xff, 0);
+  puts(3, 0, "CD", MAX7456_ATTR_LBC);
+  put(29, 15, 0xff, MAX7456_ATTR_BLINK);
+  PIOS_MAX7456_flush(dev);
+
+  expect_chip_matches();
+}
+
+TEST_F(Max7456Shadow, StringsRunIntoNextRow) {
+  puts(26, 3, "ABCDEFGH", 0);
+  PIOS_MAX7456_flush(dev);
+
+  expect_chip_matches();
+  EXPECT_EQ('E', mock_max7456_chr[4 * COLS]);
+}
+
+TEST_F(Max7456Shadow, RandomFramesMatch) {
+  srand(7456);
+
+  for (int frame = 0; frame < 500; frame++) {
+    if (rand() % 4 == 0) {
+      clear();
+    }
+
+    int n = rand() % 40;
+
+    for (int i = 0; i < n; i++) {
+      uint8_t col = rand() % COLS;
+      uint8_t row = rand() % ROWS;
+      uint8_t attr = rand() % 8;
+
+      if (rand() % 2) {
+        put(col, row, rand() % 256, attr);
+      } else {
+        char s[8];
+        int len = rand() % (sizeof(s) - 1);
+
+        for (int j = 0; j < len; j++) {
+          s[j] = 'A' + rand() % 26;
+        }
+        s[len] = 0;
+
+        puts(col, row, s, attr);
+      }
+    }
+
+    PIOS_MAX7456_flush(dev);
+    expect_chip_matches();
+
+    if (HasFailure()) {
+      FAIL() << "frame " << frame;
+    }
+  }
+}
+
+/* A representative CharacterOSD page: a dozen panels, most of them static
+ * between frames, a few numbers ticking.
+ */
+static void draw_page(void (*drawer)(uint8_t, uint8_t, const char *, uint8_t),
+    int frame)
+{
+  char buf[16];
+
+  drawer(1, 1, "RSSI 87", 0);
+  snprintf(buf, sizeof(buf), "%2d:%02d", frame / 3000, frame / 50 % 60);
+  drawer(23, 1, buf, 0);
+  drawer(MAX7456_FMT_H_CENTER, 2, "ACRO", 0);
+  snprintf(buf, sizeof(buf), "ALT %4dM", 120 + frame / 25 % 8);
+  drawer(1, 7, buf, 0);
+  snprintf(buf, sizeof(buf), "SPD %3dK", 40 + frame / 10 % 5);
+  drawer(21, 7, buf, 0);
+  drawer(13, 8, "-+-", 0);
+  drawer(1, 12, "SATS 11", 0);
+  drawer(1, 13, "47.3978 8.5456", 0);
+  snprintf(buf, sizeof(buf), "%4.1fV", 16.4 - frame / 500 * 0.1);
+  drawer(23, 13, buf, 0);
+  snprintf(buf, sizeof(buf), "%3dMAH", frame / 10);
+  drawer(23, 14, buf, 0);
+  drawer(1, 15, "THR 43%", 0);
+  drawer(12, 15, "DRONIN", MAX7456_ATTR_INVERT);
+}
+
+static max7456_dev_t bench_dev;
+
+static void shadow_puts(uint8_t col, uint8_t row, const char *s, uint8_t attr)
+{
+  PIOS_MAX7456_puts(bench_dev, col, row, s, attr);
+}
+
+static uint32_t legacy_bytes;
+
+/* What the driver used to send for a direct puts: offset, mode, the
+ * characters, stop. */
+static void legacy_puts(uint8_t col, uint8_t row, const char *s, uint8_t attr)
+{
+  (void) col; (void) row; (void) attr;
+
+  legacy_bytes += 8 + 2 * strlen(s);
+}
+
+TEST_F(Max7456Shadow, Benchmark) {
+  const int frames = 1500;
+
+  bench_dev = dev;
+
+  uint32_t shadow_bytes = 0;
+  legacy_bytes = 0;
+
+  for (int frame = 0; frame < frames; frame++) {
+    /* Clearing used to take a DMM read-modify-write and a poll */
+    legacy_bytes += 6;
+    draw_page(legacy_puts, frame);
+
+    PIOS_MAX7456_clear(dev);
+    draw_page(shadow_puts, frame);
+    shadow_bytes += PIOS_MAX7456_flush(dev);
+  }
+
+  printf("SPI bytes per frame: direct %.1f, shadow %.1f\n",
+      (double) legacy_bytes / frames, (double) shadow_bytes / frames);
+
+  EXPECT_LT(shadow_bytes * 4, legacy_bytes);
+}
@@ -0,0 +1,154 @@
+/*
+ * A small emulation of the MAX7456 register interface, enough for the
+ * display memory path of the driver, plus stand-ins for the delay and
+ * thread calls it makes.
+ */
+
+#include "pios.h"
+#include "pios_thread.h"
+#include "pios_max7456_priv.h"
+
+#include "unittest_mocks.h"
+
+uint8_t mock_max7456_chr[MOCK_MAX7456_CELLS];
+uint8_t mock_max7456_attr[MOCK_MAX7456_CELLS];
+
+uint32_t mock_spi_bytes;
+
+static bool selected;
+static bool have_reg;
+static uint8_t reg;
+
+static uint8_t vm0, dmm;
+static uint16_t addr;
+
+void mock_max7456_reset(void)
+{
+	memset(mock_max7456_chr, 0, sizeof(mock_max7456_chr));
+	memset(mock_max7456_attr, 0, sizeof(mock_max7456_attr));
+
+	vm0 = dmm = 0;
+	addr = 0;
+
+	mock_spi_bytes = 0;
+}
+
+static uint8_t read_reg(uint8_t r)
+{
+	switch (r) {
+	case MAX7456_REG_VM0:
+		return vm0;
+	case MAX7456_REG_DMM:
+		return dmm;
+	case MAX7456_REG_STAT:
+		/* PAL detected, in vertical sync */
+		return 0x01;
+	default:
+		return 0;
+	}
+}
+
+static void write_reg(uint8_t r, uint8_t val)
+{
+	switch (r) {
+	case MAX7456_REG_VM0:
+		/* Software reset completes immediately */
+		vm0 = val & ~MAX7456_VM0_SRB_MASK;
+		break;
+	case MAX7456_REG_DMM:
+		dmm = val;
+
+		if (MAX7456_DMM_CLR_R(dmm) == MAX7456_DMM_CLR_CLEAR) {
+			memset(mock_max7456_chr, 0, sizeof(mock_max7456_chr));
+			memset(mock_max7456_attr, 0,
+					sizeof(mock_max7456_attr));
+			dmm = MAX7456_DMM_CLR_W(dmm, MAX7456_DMM_CLR_READY);
+		}
+		break;
+	case MAX7456_REG_DMAH:
+		addr = (addr & 0xff) | ((val & 1) << 8);
+		break;
+	case MAX7456_REG_DMAL:
+		addr = (addr & 0x100) | val;
+		break;
+	case MAX7456_REG_DMDI:
+		if (dmm & 0x01) {
+			if (val == MAX7456_DMDI_AUTOINCREMENT_STOP) {
+				dmm &= ~0x01;
+				break;
+			}
+
+			mock_max7456_chr[addr] = val;
+			mock_max7456_attr[addr] = (dmm >> 3) & 0x07;
+			addr = (addr + 1) % MOCK_MAX7456_CELLS;
+		} else {
+			mock_max7456_chr[addr] = val;
+			mock_max7456_attr[addr] = (dmm >> 3) & 0x07;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+int32_t PIOS_SPI_ClaimBus(pios_spi_t spi_dev)
+{
+	return 0;
+}
+
+int32_t PIOS_SPI_ReleaseBus(pios_spi_t spi_dev)
+{
+	return 0;
+}
+
+int32_t PIOS_SPI_SetClockSpeed(pios_spi_t spi_dev, uint32_t speed)
+{
+	return 0;
+}
+
+int32_t PIOS_SPI_RC_PinSet(pios_spi_t spi_dev, uint32_t slave_id,
+		bool pin_value)
+{
+	selected = !pin_value;
+	have_reg = false;
+
+	return 0;
+}
+
+uint8_t PIOS_SPI_TransferByte(pios_spi_t spi_dev, uint8_t b)
+{
+	PIOS_Assert(selected);
+
+	mock_spi_bytes++;
+
+	if (!have_reg) {
+		reg = b;
+		have_reg = true;
+
+		return 0;
+	}
+
+	have_reg = false;
+
+	if (reg & 0x80) {
+		return read_reg(reg & 0x7f);
+	}
+
+	write_reg(reg, b);
+
+	return 0;
+}
+
+uint32_t PIOS_DELAY_GetuS(void)
+{
+	return 0;
+}
+
+int32_t PIOS_DELAY_WaituS(uint32_t uS)
+{
+	return 0;
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+}
@@ -0,0 +1,21 @@
+/*
+ * Shared between the mock MAX7456 and the test driver.
+ */
+
+#ifndef UNITTEST_MOCKS_H
+#define UNITTEST_MOCKS_H
+
+#include <stdint.h>
+
+#define MOCK_MAX7456_CELLS 512
+
+/* Display memory as the emulated chip holds it */
+extern uint8_t mock_max7456_chr[MOCK_MAX7456_CELLS];
+extern uint8_t mock_max7456_attr[MOCK_MAX7456_CELLS];
+
+/* Bytes clocked over SPI since the last reset */
+extern uint32_t mock_spi_bytes;
+
+void mock_max7456_reset(void);
+
+#endif /* UNITTEST_MOCKS_H */
@@ -0,0 +1,317 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+#define restrict		/* neuter restrict keyword since it's not in C++ */
+
+#include "misc_math.h"		/* API for misc_math functions */
+#include "mixer_plan.h"		/* API for the mixer plan */
+
+}
+
+#include <math.h>		/* fabs() */
+
+#define ROWS 10
+#define COLS 8
+
+/* A quad X on outputs 0-3, a camera servo on 6, and nothing else.  Only
+ * throttle, roll, pitch, yaw and accessory0 are used.
+ */
+static const float quad_mixer[ROWS * COLS] = {
+	1, 0,  0.5f,  0.5f, -0.5f, 0, 0, 0,
+	1, 0, -0.5f,  0.5f,  0.5f, 0, 0, 0,
+	1, 0, -0.5f, -0.5f, -0.5f, 0, 0, 0,
+	1, 0,  0.5f, -0.5f,  0.5f, 0, 0, 0,
+	0, 0,  0,     0,     0,    0, 0, 0,
+	0, 0,  0,     0,     0,    0, 0, 0,
+	0, 0,  0,     0,     0,    1, 0, 0,
+	0, 0,  0,     0,     0,    0, 0, 0,
+	0, 0,  0,     0,     0,    0, 0, 0,
+	0, 0,  0,     0,     0,    0, 0, 0,
+};
+
+/* The classic per-channel scaling that channel_scale replaces */
+static float reference_scale(float value, float min, float neutral, float max,
+		float full_deadband)
+{
+	float deadband = full_deadband / 2.0f;
+	float valueScaled;
+
+	if (!isfinite(value)) {
+		return deadband ? neutral : min;
+	}
+
+	if (min > max) {
+		deadband = -deadband;
+	}
+
+	if (value >= 0.0f) {
+		valueScaled = value * (max - neutral - deadband)
+			+ neutral + deadband;
+	} else {
+		valueScaled = value * (neutral - min - deadband)
+			+ neutral - deadband;
+	}
+
+	if (max > min) {
+		if (valueScaled > max) valueScaled = max;
+		if (valueScaled < min) valueScaled = min;
+	} else {
+		if (valueScaled < max) valueScaled = max;
+		if (valueScaled > min) valueScaled = min;
+	}
+
+	return valueScaled;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class MixerPlan : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(MixerPlan, PacksZeroRowsAndColumns) {
+  struct mixer_plan plan;
+
+  ASSERT_TRUE(mixer_plan_compile(&plan, quad_mixer, ROWS, COLS));
+
+  EXPECT_EQ(5, plan.rows);
+  EXPECT_EQ(5, plan.cols);
+  EXPECT_EQ(ROWS, plan.out_rows);
+
+  EXPECT_EQ(6, plan.row_idx[4]);
+  EXPECT_EQ(0, plan.col_idx[0]);
+  EXPECT_EQ(5, plan.col_idx[4]);
+}
+
+TEST_F(MixerPlan, RejectsOversizeMatrix) {
+  struct mixer_plan plan;
+
+  EXPECT_FALSE(mixer_plan_compile(&plan, quad_mixer,
+        MIXER_PLAN_MAX_ROWS + 1, COLS));
+}
+
+TEST_F(MixerPlan, MatchesFullMultiply) {
+  struct mixer_plan plan;
+
+  mixer_plan_compile(&plan, quad_mixer, ROWS, COLS);
+
+  srand(42);
+
+  for (int i = 0; i < 10000; i++) {
+    float desired[COLS];
+    float expected[ROWS];
+    float actual[ROWS];
+
+    for (int j = 0; j < COLS; j++) {
+      desired[j] = (rand() / (float) RAND_MAX) * 2 - 1;
+    }
+
+    memset(actual, 0x55, sizeof(actual));
+
+    matrix_mul(quad_mixer, desired, expected, ROWS, COLS, 1);
+    mixer_plan_execute(&plan, desired, actual);
+
+    for (int j = 0; j < ROWS; j++) {
+      EXPECT_NEAR(expected[j], actual[j], 1e-6f);
+    }
+  }
+}
+
+TEST_F(MixerPlan, EmptyMixerZeroesOutputs) {
+  struct mixer_plan plan;
+  const float empty[ROWS * COLS] = { 0 };
+  const float desired[COLS] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+  float out[ROWS];
+
+  mixer_plan_compile(&plan, empty, ROWS, COLS);
+
+  memset(out, 0x55, sizeof(out));
+  mixer_plan_execute(&plan, desired, out);
+
+  for (int j = 0; j < ROWS; j++) {
+    EXPECT_EQ(0.0f, out[j]);
+  }
+}
+
+TEST_F(MixerPlan, ChannelScaleMatchesReference) {
+  /* min, neutral, max, deadband */
+  const float ranges[][4] = {
+    { 1000, 1050, 2000, 0 },	/* normal motor */
+    { 1000, 1500, 2000, 0 },	/* servo */
+    { 2000, 1500, 1000, 0 },	/* reversed servo */
+    { 1000, 1500, 2000, 20 },	/* 3D motor */
+    { 2000, 1500, 1000, 20 },	/* reversed 3D motor */
+    { 1500, 1500, 1500, 0 },	/* degenerate */
+  };
+
+  for (unsigned int r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+    struct channel_scale scale;
+
+    channel_scale_compute(&scale, ranges[r][0], ranges[r][1],
+        ranges[r][2], ranges[r][3]);
+
+    EXPECT_EQ(reference_scale(NAN, ranges[r][0], ranges[r][1],
+          ranges[r][2], ranges[r][3]),
+        channel_scale_apply(&scale, NAN));
+
+    for (float v = -1.5f; v <= 1.5f; v += 0.01f) {
+      EXPECT_NEAR(reference_scale(v, ranges[r][0], ranges[r][1],
+            ranges[r][2], ranges[r][3]),
+          channel_scale_apply(&scale, v), 1e-3f);
+    }
+  }
+}
+
+/* What the actuator task takes from ActuatorDesired each cycle */
+struct desired {
+  float roll, pitch, yaw, thrust, accessory0;
+};
+
+/* The arithmetic of normalize_input_data for an armed multirotor: the
+ * secondary throttle curve and the fill of the desired vector */
+static void normalize_desired(const struct desired *d, const float *curve2,
+    float *desired_vect)
+{
+  float throttle_val = d->thrust;
+
+  desired_vect[0] = throttle_val;
+  desired_vect[1] = linear_interpolate(throttle_val, curve2, 5, -1.0f, 1.0f);
+  desired_vect[2] = d->roll;
+  desired_vect[3] = d->pitch;
+  desired_vect[4] = d->yaw;
+  desired_vect[5] = d->accessory0;
+}
+
+static void benchmark_input(int i, struct desired *d)
+{
+  d->roll = (i & 255) / 256.0f - 0.5f;
+  d->pitch = 0.1f;
+  d->yaw = -0.1f;
+  d->thrust = ((i >> 3) & 63) / 64.0f;
+  d->accessory0 = 0.3f;
+}
+
+TEST_F(MixerPlan, Benchmark) {
+  const int iterations = 2000000;
+  const int inputs = 256 * 8;
+  const float curve2[5] = { 0, 0.25f, 0.5f, 0.75f, 1 };
+  struct mixer_plan plan;
+  struct channel_scale scales[ROWS];
+  float desired_vect[COLS] = { 0 };
+  float out[ROWS];
+  static float reference[inputs][ROWS];
+  int full_mismatches = 0, plan_mismatches = 0;
+
+  mixer_plan_compile(&plan, quad_mixer, ROWS, COLS);
+
+  for (int j = 0; j < ROWS; j++) {
+    channel_scale_compute(&scales[j], 1000, 1050, 2000, 0);
+  }
+
+  /* What every input should come out as, from the classic path */
+  for (int i = 0; i < inputs; i++) {
+    struct desired d;
+
+    benchmark_input(i, &d);
+    normalize_desired(&d, curve2, desired_vect);
+    matrix_mul(quad_mixer, desired_vect, out, ROWS, COLS, 1);
+
+    for (int j = 0; j < ROWS; j++) {
+      reference[i][j] = reference_scale(out[j], 1000, 1050, 2000, 0);
+    }
+  }
+
+  /* normalize -> mix -> scale, both ways, checking each output */
+  double start = ut_seconds();
+
+  for (int i = 0; i < iterations; i++) {
+    struct desired d;
+
+    benchmark_input(i, &d);
+    normalize_desired(&d, curve2, desired_vect);
+    matrix_mul(quad_mixer, desired_vect, out, ROWS, COLS, 1);
+
+    for (int j = 0; j < ROWS; j++) {
+      float v = reference_scale(out[j], 1000, 1050, 2000, 0);
+
+      if (fabsf(v - reference[i % inputs][j]) > 1e-3f) {
+        full_mismatches++;
+      }
+    }
+  }
+
+  double full = ut_seconds() - start;
+
+  start = ut_seconds();
+
+  for (int i = 0; i < iterations; i++) {
+    struct desired d;
+
+    benchmark_input(i, &d);
+    normalize_desired(&d, curve2, desired_vect);
+    mixer_plan_execute(&plan, desired_vect, out);
+
+    for (int j = 0; j < ROWS; j++) {
+      float v = channel_scale_apply(&scales[j], out[j]);
+
+      if (fabsf(v - reference[i % inputs][j]) > 1e-3f) {
+        plan_mismatches++;
+      }
+    }
+  }
+
+  double planned = ut_seconds() - start;
+
+  printf("normalize+mix+scale: full matrix %.1f ns/iter, plan %.1f ns/iter\n",
+      full * 1e9 / iterations, planned * 1e9 / iterations);
+
+  EXPECT_EQ(0, full_mismatches);
+  EXPECT_EQ(0, plan_mismatches);
+}
+
+/**
+ * @}
+ * @}
+ */
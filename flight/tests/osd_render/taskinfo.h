@@ -0,0 +1,2 @@
+/* Stand-in for the generated UAVO header; only the type is needed here. */
+typedef int TaskInfoRunningElem;
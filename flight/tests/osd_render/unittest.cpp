@@ -0,0 +1,418 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* getenv */
+#include <string.h>		/* memcmp */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* sinf */
+
+#define restrict		/* neuter restrict keyword since it's not in C++ */
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_video.h"
+#include "osd_utils.h"
+#include "osd_retained.h"
+
+extern uint8_t *draw_buffer_level;
+extern uint8_t *draw_buffer_mask;
+
+}
+
+#define NUM_WIDGETS 11	/* including the unnamed one */
+
+/* Values shown on the test page */
+struct page_state {
+  int altitude;
+  int speed;
+  int roll;
+  int pitch;
+  int battery;
+  int heading;
+  int rssi;
+  bool warning;
+};
+
+static struct page_state state;
+
+/* A cut-down HUD page; the horizon crosses the centre mark and, when it
+ * tilts far enough, the speed and altitude readouts. */
+static void draw_page(void *ctx)
+{
+  (void) ctx;
+  char tmp[32];
+
+  write_pixel_lm(2, 2, 1, 1);
+
+  osd_widget(1);
+  sprintf(tmp, "%dm", state.altitude);
+  write_string(tmp, GRAPHICS_RIGHT - 30, GRAPHICS_Y_MIDDLE, 0, 0,
+      TEXT_VA_MIDDLE, TEXT_HA_RIGHT, 0, 3);
+
+  osd_widget(2);
+  float angle = state.roll * (float) M_PI / 180.0f;
+  int dx = (int) (100 * cosf(angle));
+  int dy = (int) (100 * sinf(angle));
+  int cy = GRAPHICS_Y_MIDDLE + state.pitch;
+  write_line_outlined(GRAPHICS_X_MIDDLE - dx, cy - dy,
+      GRAPHICS_X_MIDDLE + dx, cy + dy, 2, 2, 0, 1);
+
+  osd_widget(3);
+  write_hline_outlined(GRAPHICS_X_MIDDLE - 10, GRAPHICS_X_MIDDLE + 10,
+      GRAPHICS_Y_MIDDLE, 2, 2, 0, 1);
+  write_circle_outlined(GRAPHICS_X_MIDDLE, GRAPHICS_Y_MIDDLE, 4, 0, 1, 0, 1);
+
+  osd_widget(4);
+  write_rectangle_outlined(20, 20, 40, 12, 0, 0);
+  write_filled_rectangle_lm(21, 21, state.battery * 38 / 100, 10, 1, 1);
+
+  osd_widget(5);
+  if (state.warning) {
+    write_string((char *) "LOW BATTERY", GRAPHICS_X_MIDDLE, 40, 0, 0,
+        TEXT_VA_TOP, TEXT_HA_CENTER, 0, 3);
+  }
+
+  osd_widget(6);
+  sprintf(tmp, "%d", state.speed);
+  write_string(tmp, 30, GRAPHICS_Y_MIDDLE, 0, 0,
+      TEXT_VA_MIDDLE, TEXT_HA_LEFT, 0, 3);
+  write_vline_outlined(25, GRAPHICS_Y_MIDDLE - 50, GRAPHICS_Y_MIDDLE + 50,
+      2, 2, 0, 1);
+
+  osd_widget(7);
+  for (int i = -2; i <= 2; i++) {
+    int x = GRAPHICS_X_MIDDLE + i * 20 - state.heading % 20;
+    write_vline_lm(x, GRAPHICS_BOTTOM - 30, GRAPHICS_BOTTOM - 22, 1, 1);
+  }
+  write_pixel_lm(GRAPHICS_X_MIDDLE, GRAPHICS_BOTTOM - 34, 1, 1);
+
+  osd_widget(8);
+  draw_image(GRAPHICS_RIGHT - 80, 10, &image_rssi);
+  sprintf(tmp, "%d", state.rssi);
+  write_string(tmp, GRAPHICS_RIGHT - 60, 10, 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, 3);
+
+  osd_widget(9);
+  write_string((char *) "ACRO", 20, GRAPHICS_BOTTOM - 40, 0, 0,
+      TEXT_VA_TOP, TEXT_HA_LEFT, 0, 3);
+  write_string((char *) "00:42", 20, GRAPHICS_BOTTOM - 25, 0, 0,
+      TEXT_VA_TOP, TEXT_HA_LEFT, 0, 3);
+
+  osd_widget(10);
+  draw_image(GRAPHICS_RIGHT - 120, GRAPHICS_BOTTOM - 30, &image_gps);
+  write_string((char *) "48.123456 11.654321", GRAPHICS_RIGHT - 10,
+      GRAPHICS_BOTTOM - 12, 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 2);
+}
+
+static void step_state(int frame)
+{
+  state.altitude = 100 + frame / 3;
+  state.speed = 20 + (frame / 7) % 15;
+  state.roll = (frame / 2) % 90 - 45;
+  state.pitch = (frame / 11) % 20 - 10;
+  state.battery = 100 - (frame / 17) % 100;
+  state.heading = frame / 5;
+  state.rssi = 90 - (frame / 23) % 40;
+  state.warning = (frame / 13) % 2;
+}
+
+class OsdRetained : public testing::Test {
+protected:
+  virtual void SetUp() {
+    PIOS_Video_SetSystem(PIOS_VIDEO_SYSTEM_PAL);
+    osd_retained_invalidate();
+    memset(&state, 0, sizeof(state));
+  }
+
+  /* Draw the page from scratch into a scratch buffer */
+  void render_reference() {
+    uint8_t *level = draw_buffer_level;
+    uint8_t *mask = draw_buffer_mask;
+
+    draw_buffer_level = ref_level;
+    draw_buffer_mask = ref_mask;
+
+    clearGraphics();
+    draw_page(NULL);
+
+    draw_buffer_level = level;
+    draw_buffer_mask = mask;
+  }
+
+  void expect_matches_reference(int frame) {
+    render_reference();
+
+    EXPECT_EQ(0, memcmp(ref_level, draw_buffer_level, sizeof(ref_level)))
+      << "level differs in frame " << frame;
+    EXPECT_EQ(0, memcmp(ref_mask, draw_buffer_mask, sizeof(ref_mask)))
+      << "mask differs in frame " << frame;
+  }
+
+  /* Write the frame out when OSD_RENDER_DUMP_DIR is set */
+  void dump_frame(int frame) {
+    const char *dir = getenv("OSD_RENDER_DUMP_DIR");
+
+    if (dir) {
+      char path[256];
+      snprintf(path, sizeof(path), "%s/frame%04d.pgm", dir, frame);
+      EXPECT_EQ(0, PIOS_Video_DumpFrame(path));
+    }
+  }
+
+  uint8_t ref_level[BUFFER_HEIGHT * BUFFER_WIDTH];
+  uint8_t ref_mask[BUFFER_HEIGHT * BUFFER_WIDTH];
+};
+
+TEST_F(OsdRetained, MatchesFullRedraw) {
+  for (int frame = 0; frame < 2000; frame++) {
+    step_state(frame);
+
+    osd_retained_render(draw_page, NULL);
+    expect_matches_reference(frame);
+
+    if (HasFailure()) {
+      break;
+    }
+
+    PIOS_Video_SwapBuffers();
+    dump_frame(frame);
+  }
+}
+
+TEST_F(OsdRetained, UnchangedWidgetsAreLeftAlone) {
+  struct osd_retained_stats stats;
+
+  step_state(13);
+
+  /* Both buffers start empty, so everything is drawn in each */
+  osd_retained_render(draw_page, NULL);
+  osd_retained_get_stats(&stats);
+  EXPECT_EQ(NUM_WIDGETS, stats.rendered);
+  PIOS_Video_SwapBuffers();
+
+  /* Isolated widgets are copied from the first buffer */
+  osd_retained_render(draw_page, NULL);
+  osd_retained_get_stats(&stats);
+  EXPECT_EQ(NUM_WIDGETS, stats.rendered + stats.copied);
+  EXPECT_LT(0, stats.copied);
+  PIOS_Video_SwapBuffers();
+
+  osd_retained_render(draw_page, NULL);
+  osd_retained_get_stats(&stats);
+  EXPECT_EQ(0, stats.rendered);
+  EXPECT_EQ(0, stats.copied);
+  EXPECT_EQ(NUM_WIDGETS, stats.retained);
+  expect_matches_reference(0);
+}
+
+TEST_F(OsdRetained, IsolatedWidgetCopiedFromDisplay) {
+  struct osd_retained_stats stats;
+
+  step_state(13);
+
+  for (int i = 0; i < 2; i++) {
+    osd_retained_render(draw_page, NULL);
+    PIOS_Video_SwapBuffers();
+  }
+
+  state.battery = 50;
+  osd_retained_render(draw_page, NULL);
+  osd_retained_get_stats(&stats);
+  EXPECT_EQ(1, stats.rendered);
+  expect_matches_reference(0);
+  PIOS_Video_SwapBuffers();
+
+  /* The other buffer catches up by copying the bar across */
+  osd_retained_render(draw_page, NULL);
+  osd_retained_get_stats(&stats);
+  EXPECT_EQ(0, stats.rendered);
+  EXPECT_EQ(1, stats.copied);
+  expect_matches_reference(1);
+}
+
+TEST_F(OsdRetained, OverlappingWidgetsRedrawn) {
+  struct osd_retained_stats stats;
+
+  step_state(13);
+
+  for (int i = 0; i < 2; i++) {
+    osd_retained_render(draw_page, NULL);
+    PIOS_Video_SwapBuffers();
+  }
+
+  /* The horizon crosses the centre mark */
+  state.roll = 10;
+  osd_retained_render(draw_page, NULL);
+  osd_retained_get_stats(&stats);
+  EXPECT_EQ(2, stats.rendered);
+  expect_matches_reference(0);
+}
+
+TEST_F(OsdRetained, InvalidateRedrawsEverything) {
+  struct osd_retained_stats stats;
+
+  step_state(13);
+
+  for (int i = 0; i < 2; i++) {
+    osd_retained_render(draw_page, NULL);
+    PIOS_Video_SwapBuffers();
+  }
+
+  /* Something else drew over the page */
+  write_filled_rectangle_lm(0, 0, 100, 100, 1, 1);
+
+  osd_retained_invalidate();
+  osd_retained_render(draw_page, NULL);
+  osd_retained_get_stats(&stats);
+  EXPECT_EQ(NUM_WIDGETS, stats.rendered);
+  expect_matches_reference(0);
+}
+
+TEST_F(OsdRetained, VideoSystemChange) {
+  for (int frame = 0; frame < 200; frame++) {
+    if (frame == 100) {
+      PIOS_Video_SetSystem(PIOS_VIDEO_SYSTEM_NTSC);
+      osd_retained_invalidate();
+    }
+
+    step_state(frame);
+
+    osd_retained_render(draw_page, NULL);
+    expect_matches_reference(frame);
+    PIOS_Video_SwapBuffers();
+  }
+}
+
+static int draw_calls;
+
+static void counting_draw(void *ctx)
+{
+  draw_calls++;
+  draw_page(ctx);
+}
+
+TEST_F(OsdRetained, DrawsPageOnce) {
+  for (int frame = 0; frame < 200; frame++) {
+    step_state(frame);
+
+    draw_calls = 0;
+    osd_retained_render(counting_draw, NULL);
+    EXPECT_EQ(1, draw_calls) << "in frame " << frame;
+    expect_matches_reference(frame);
+    PIOS_Video_SwapBuffers();
+  }
+}
+
+/* More drawing calls than the retained renderer can record */
+static void busy_page(void *ctx)
+{
+  draw_calls++;
+  draw_page(ctx);
+
+  osd_widget(NUM_WIDGETS);
+  for (int i = 0; i < 600; i++) {
+    write_pixel_lm(80 + i % 200, GRAPHICS_Y_MIDDLE + 80 + i / 200, 1, 1);
+  }
+}
+
+TEST_F(OsdRetained, OperationListOverflow) {
+  struct osd_retained_stats stats;
+
+  step_state(13);
+
+  for (int i = 0; i < 2; i++) {
+    osd_retained_render(busy_page, NULL);
+    PIOS_Video_SwapBuffers();
+  }
+
+  /* The busy widget is drawn by running the page again, and as what it
+   * drew can't be vouched for, it is drawn every frame. */
+  for (int frame = 0; frame < 4; frame++) {
+    draw_calls = 0;
+    osd_retained_render(busy_page, NULL);
+    osd_retained_get_stats(&stats);
+    EXPECT_EQ(2, draw_calls);
+    EXPECT_EQ(1, stats.rendered);
+
+    uint8_t *level = draw_buffer_level;
+    uint8_t *mask = draw_buffer_mask;
+
+    draw_buffer_level = ref_level;
+    draw_buffer_mask = ref_mask;
+    clearGraphics();
+    busy_page(NULL);
+    draw_buffer_level = level;
+    draw_buffer_mask = mask;
+
+    EXPECT_EQ(0, memcmp(ref_level, draw_buffer_level, sizeof(ref_level)));
+    EXPECT_EQ(0, memcmp(ref_mask, draw_buffer_mask, sizeof(ref_mask)));
+    PIOS_Video_SwapBuffers();
+  }
+}
+
+/* Cruising: the altitude and heading tick over, everything else holds */
+static void step_cruise(int frame)
+{
+  step_state(13);
+  state.altitude = 100 + frame / 2;
+  state.heading = frame / 10;
+  state.roll = 0;
+}
+
+/* Not a pass/fail test; prints frame rates for a typical flight, where a
+ * couple of values change every frame. */
+TEST_F(OsdRetained, Benchmark) {
+  const int frames = 2000;
+
+  double start = ut_seconds();
+  for (int frame = 0; frame < frames; frame++) {
+    step_cruise(frame);
+    clearGraphics();
+    draw_page(NULL);
+    PIOS_Video_SwapBuffers();
+  }
+  double full = ut_seconds() - start;
+
+  start = ut_seconds();
+  for (int frame = 0; frame < frames; frame++) {
+    step_cruise(frame);
+    osd_retained_render(draw_page, NULL);
+    PIOS_Video_SwapBuffers();
+  }
+  double retained = ut_seconds() - start;
+
+  printf("full redraw: %.0f fps, retained: %.0f fps\n",
+      frames / full, frames / retained);
+}
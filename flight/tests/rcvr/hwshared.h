@@ -0,0 +1,20 @@
+/* Stand-in for the generated hwshared.h, with what the DSM driver uses. */
+
+#ifndef HWSHARED_H
+#define HWSHARED_H
+
+typedef enum {
+	HWSHARED_DSMXMODE_AUTODETECT = 0,
+	HWSHARED_DSMXMODE_FORCE10BIT = 1,
+	HWSHARED_DSMXMODE_FORCE11BIT = 2,
+	HWSHARED_DSMXMODE_BIND3PULSES = 3,
+	HWSHARED_DSMXMODE_BIND4PULSES = 4,
+	HWSHARED_DSMXMODE_BIND5PULSES = 5,
+	HWSHARED_DSMXMODE_BIND6PULSES = 6,
+	HWSHARED_DSMXMODE_BIND7PULSES = 7,
+	HWSHARED_DSMXMODE_BIND8PULSES = 8,
+	HWSHARED_DSMXMODE_BIND9PULSES = 9,
+	HWSHARED_DSMXMODE_BIND10PULSES = 10
+} HwSharedDSMxModeOptions;
+
+#endif /* HWSHARED_H */
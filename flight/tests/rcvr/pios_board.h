@@ -0,0 +1,2 @@
+#define PIOS_SBUS_NUM_INPUTS (16+2)
+#define PIOS_DSM_NUM_INPUTS 12
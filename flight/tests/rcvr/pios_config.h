@@ -0,0 +1,9 @@
+#define PIOS_NO_HW
+#define FLIGHT_POSIX
+
+#define PIOS_INCLUDE_RCVR
+#define PIOS_INCLUDE_RTC
+#define PIOS_INCLUDE_SBUS
+#define PIOS_INCLUDE_DSM
+#define PIOS_INCLUDE_IBUS
+#define PIOS_INCLUDE_CROSSFIRE
@@ -0,0 +1,10 @@
+/* Stand-in for the generated taskinfo.h, for taskmonitor.h. */
+
+#ifndef TASKINFO_H
+#define TASKINFO_H
+
+typedef enum {
+	TASKINFO_RUNNING_SYSTEM = 0
+} TaskInfoRunningElem;
+
+#endif /* TASKINFO_H */
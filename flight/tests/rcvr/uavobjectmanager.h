@@ -0,0 +1 @@
+/* Stand-in for uavobjectmanager.h; hwshared.h needs nothing from it. */
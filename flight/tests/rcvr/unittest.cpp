@@ -0,0 +1,761 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* fopen */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <pthread.h>		/* pthread_* */
+
+extern "C" {
+#include "pios.h"
+#include "pios_rcvr_priv.h"
+#include "pios_sbus_priv.h"
+#include "pios_dsm_priv.h"
+#include "unittest_mocks.h"
+}
+
+#define SBUS_PORT 0
+#define DSM_PORT 1
+#define IBUS_PORT 2
+#define CRSF_PORT 3
+
+/* Channel values as ManualControlCommand holds them */
+#define TIMEOUT_VALUE ((uint16_t) PIOS_RCVR_TIMEOUT)
+#define INVALID_VALUE ((uint16_t) PIOS_RCVR_INVALID)
+
+class RcvrTest : public testing::Test {
+protected:
+	virtual void SetUp() {
+		mock_reset();
+		srand(1);
+	}
+
+	/* Hands bytes to a driver in chunks of random size, as DMA and
+	 * interrupt driven ports both may */
+	void feed(uintptr_t port, const uint8_t *buf, int len) {
+		while (len > 0) {
+			int chunk = 1 + rand() % 8;
+
+			if (chunk > len)
+				chunk = len;
+
+			EXPECT_EQ(chunk, mock_com_receive(port, buf, chunk));
+
+			buf += chunk;
+			len -= chunk;
+		}
+	}
+
+	void feed_noise(uintptr_t port, int len) {
+		uint8_t noise[64];
+
+		for (int i = 0; i < len; i++)
+			noise[i] = rand();
+
+		feed(port, noise, len);
+	}
+
+	struct pios_rcvr_frame read_frame() {
+		struct pios_rcvr_frame frame;
+
+		memset(&frame, 0x5a, sizeof(frame));
+		EXPECT_EQ(0, PIOS_RCVR_ReadFrame(rcvr_id,
+					PIOS_RCVR_FRAME_CHANNELS, &frame));
+
+		return frame;
+	}
+
+	uintptr_t rcvr_id;
+};
+
+/* Packs 16 channels of 11 bits, LSB first, as S.Bus and Crossfire do */
+static void pack_11bit_channels(const uint16_t *channels, uint8_t *out)
+{
+	uint32_t bits = 0;
+	int num_bits = 0;
+
+	for (int i = 0; i < 16; i++) {
+		bits |= (uint32_t)(channels[i] & 0x7ff) << num_bits;
+		num_bits += 11;
+
+		while (num_bits >= 8) {
+			*out++ = bits;
+			bits >>= 8;
+			num_bits -= 8;
+		}
+	}
+}
+
+/* Channel values for the n-th frame of a test stream */
+static uint16_t test_channel(int frame, int channel)
+{
+	return (172 + frame * 13 + channel * 97) % 1811;
+}
+
+/* Test the receiver layer itself, with a driver that doesn't publish frames */
+
+static int legacy_reads;
+
+static int32_t legacy_read(uintptr_t id, uint8_t channel)
+{
+	(void) id;
+
+	legacy_reads++;
+
+	if (channel >= 4)
+		return PIOS_RCVR_INVALID;
+
+	return 1000 + channel;
+}
+
+static const struct pios_rcvr_driver legacy_driver = {
+	.init = NULL,
+	.read = legacy_read,
+	.get_frame_buf = NULL,
+};
+
+TEST_F(RcvrTest, NoDriver) {
+	struct pios_rcvr_frame frame;
+
+	EXPECT_EQ(PIOS_RCVR_NODRIVER, PIOS_RCVR_ReadFrame(0, 8, &frame));
+}
+
+TEST_F(RcvrTest, FallbackReadsChannelByChannel) {
+	ASSERT_EQ(0, PIOS_RCVR_Init(&rcvr_id, &legacy_driver, 0));
+
+	mock_advance_to(12345);
+
+	struct pios_rcvr_frame frame = read_frame();
+
+	EXPECT_EQ(0u, frame.sequence);
+	EXPECT_EQ(12345u, frame.timestamp);
+	EXPECT_EQ(PIOS_RCVR_FRAME_CHANNELS, frame.num_channels);
+
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(1000 + i, frame.channels[i]);
+
+	for (int i = 4; i < PIOS_RCVR_FRAME_CHANNELS; i++)
+		EXPECT_EQ(INVALID_VALUE, frame.channels[i]);
+}
+
+TEST_F(RcvrTest, FallbackReadsOnlyChannelsUsed) {
+	struct pios_rcvr_frame frame;
+
+	ASSERT_EQ(0, PIOS_RCVR_Init(&rcvr_id, &legacy_driver, 0));
+
+	legacy_reads = 0;
+	EXPECT_EQ(0, PIOS_RCVR_ReadFrame(rcvr_id, 3, &frame));
+	EXPECT_EQ(3, legacy_reads);
+	EXPECT_EQ(3, frame.num_channels);
+	EXPECT_EQ(1002, frame.channels[2]);
+
+	/* No more than a frame holds */
+	legacy_reads = 0;
+	EXPECT_EQ(0, PIOS_RCVR_ReadFrame(rcvr_id, 255, &frame));
+	EXPECT_EQ(PIOS_RCVR_FRAME_CHANNELS, legacy_reads);
+	EXPECT_EQ(PIOS_RCVR_FRAME_CHANNELS, frame.num_channels);
+}
+
+/* A driver whose frames the test publishes directly */
+
+static struct pios_rcvr_frame_buf direct_frames;
+
+static const struct pios_rcvr_frame_buf *direct_get_frame_buf(uintptr_t id)
+{
+	(void) id;
+
+	return &direct_frames;
+}
+
+static const struct pios_rcvr_driver direct_driver = {
+	.init = NULL,
+	.read = legacy_read,
+	.get_frame_buf = direct_get_frame_buf,
+};
+
+TEST_F(RcvrTest, EveryFrameWakes) {
+	uint16_t channels[4] = { 1, 2, 3, 4 };
+
+	memset(&direct_frames, 0, sizeof(direct_frames));
+	ASSERT_EQ(0, PIOS_RCVR_Init(&rcvr_id, &direct_driver, 0));
+
+	/* Well within the 4ms PIOS_RCVR_ActiveFromISR waits between wakes */
+	for (uint32_t i = 1; i <= 10; i++) {
+		mock_advance_to(i * 100);
+		PIOS_RCVR_PublishFrame(&direct_frames, channels, 4);
+
+		struct pios_rcvr_frame frame = read_frame();
+		EXPECT_EQ(i, frame.sequence);
+		EXPECT_EQ(i * 100, frame.timestamp);
+		EXPECT_EQ(4, frame.num_channels);
+	}
+
+	EXPECT_EQ(10u, mock_rcvr_wakes);
+}
+
+#define CONCURRENT_FRAMES 1000000
+
+/* Frame n carries 1 in every channel when n is odd, 2 when it's even */
+static void *publish_frames(void *arg)
+{
+	(void) arg;
+
+	uint16_t odd[PIOS_RCVR_FRAME_CHANNELS];
+	uint16_t even[PIOS_RCVR_FRAME_CHANNELS];
+
+	for (int i = 0; i < PIOS_RCVR_FRAME_CHANNELS; i++) {
+		odd[i] = 1;
+		even[i] = 2;
+	}
+
+	for (int n = 1; n <= CONCURRENT_FRAMES; n++) {
+		PIOS_RCVR_PublishFrame(&direct_frames, (n & 1) ? odd : even,
+				PIOS_RCVR_FRAME_CHANNELS);
+	}
+
+	return NULL;
+}
+
+TEST_F(RcvrTest, ReadersNeverSeeTornFrames) {
+	memset(&direct_frames, 0, sizeof(direct_frames));
+	ASSERT_EQ(0, PIOS_RCVR_Init(&rcvr_id, &direct_driver, 0));
+
+	pthread_t writer;
+	ASSERT_EQ(0, pthread_create(&writer, NULL, publish_frames, NULL));
+
+	uint32_t last_sequence = 0;
+	int torn = 0;
+
+	while (last_sequence < CONCURRENT_FRAMES) {
+		struct pios_rcvr_frame frame = read_frame();
+
+		if (frame.sequence == 0)
+			continue;
+
+		EXPECT_GE(frame.sequence, last_sequence);
+		last_sequence = frame.sequence;
+
+		for (int i = 0; i < frame.num_channels; i++) {
+			if (frame.channels[i] != ((frame.sequence & 1) ? 1 : 2))
+				torn++;
+		}
+	}
+
+	pthread_join(writer, NULL);
+
+	EXPECT_EQ(0, torn);
+}
+
+/* S.Bus: 25 byte frames every 7ms */
+
+static void sbus_frame(const uint16_t *channels, uint8_t flags, uint8_t *out)
+{
+	out[0] = SBUS_SOF_BYTE;
+	pack_11bit_channels(channels, &out[1]);
+	out[23] = flags;
+	out[24] = SBUS_EOF_BYTE;
+}
+
+class SBusTest : public RcvrTest {
+protected:
+	virtual void SetUp() {
+		RcvrTest::SetUp();
+
+		uintptr_t sbus_id;
+		ASSERT_EQ(0, PIOS_SBus_Init(&sbus_id, &mock_com_driver, SBUS_PORT));
+		ASSERT_EQ(0, PIOS_RCVR_Init(&rcvr_id, &pios_sbus_rcvr_driver, sbus_id));
+	}
+};
+
+TEST_F(SBusTest, StartsFailsafed) {
+	struct pios_rcvr_frame frame = read_frame();
+
+	EXPECT_EQ(1u, frame.sequence);
+	EXPECT_EQ(PIOS_SBUS_NUM_INPUTS, frame.num_channels);
+
+	for (int i = 0; i < PIOS_SBUS_NUM_INPUTS; i++)
+		EXPECT_EQ(TIMEOUT_VALUE, frame.channels[i]);
+}
+
+TEST_F(SBusTest, FramesCarryAllChannels) {
+	uint8_t buf[SBUS_FRAME_LENGTH];
+	uint16_t channels[16];
+	uint32_t wakes = mock_rcvr_wakes;
+
+	for (int n = 0; n < 100; n++) {
+		for (int i = 0; i < 16; i++)
+			channels[i] = test_channel(n, i);
+
+		uint8_t flags = n & (SBUS_FLAG_DC1 | SBUS_FLAG_DC2);
+
+		/* Line noise, then the gap that resyncs the decoder */
+		if (n % 10 == 5) {
+			feed_noise(SBUS_PORT, 40);
+			mock_advance_to(mock_time_us + 5000);
+		}
+
+		mock_advance_to(mock_time_us + 7000);
+		sbus_frame(channels, flags, buf);
+		feed(SBUS_PORT, buf, sizeof(buf));
+
+		struct pios_rcvr_frame frame = read_frame();
+
+		EXPECT_EQ(2u + n, frame.sequence);
+		EXPECT_EQ(mock_time_us, frame.timestamp);
+		ASSERT_EQ(PIOS_SBUS_NUM_INPUTS, frame.num_channels);
+
+		for (int i = 0; i < 16; i++)
+			EXPECT_EQ(channels[i], frame.channels[i]);
+
+		EXPECT_EQ((flags & SBUS_FLAG_DC1) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN,
+				frame.channels[16]);
+		EXPECT_EQ((flags & SBUS_FLAG_DC2) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN,
+				frame.channels[17]);
+	}
+
+	EXPECT_EQ(100u, mock_rcvr_wakes - wakes);
+}
+
+TEST_F(SBusTest, ReceiverFlags) {
+	uint8_t buf[SBUS_FRAME_LENGTH];
+	uint16_t channels[16];
+
+	for (int i = 0; i < 16; i++)
+		channels[i] = test_channel(0, i);
+
+	mock_advance_to(7000);
+	sbus_frame(channels, 0, buf);
+	feed(SBUS_PORT, buf, sizeof(buf));
+	EXPECT_EQ(2u, read_frame().sequence);
+
+	/* A lost frame leaves the last one in place */
+	mock_advance_to(14000);
+	sbus_frame(channels, SBUS_FLAG_FL, buf);
+	feed(SBUS_PORT, buf, sizeof(buf));
+
+	struct pios_rcvr_frame frame = read_frame();
+	EXPECT_EQ(2u, frame.sequence);
+	EXPECT_EQ(7000u, frame.timestamp);
+
+	/* The receiver's own failsafe is a frame of timeouts */
+	mock_advance_to(21000);
+	sbus_frame(channels, SBUS_FLAG_FS, buf);
+	feed(SBUS_PORT, buf, sizeof(buf));
+
+	frame = read_frame();
+	EXPECT_EQ(3u, frame.sequence);
+	EXPECT_EQ(21000u, frame.timestamp);
+	for (int i = 0; i < PIOS_SBUS_NUM_INPUTS; i++)
+		EXPECT_EQ(TIMEOUT_VALUE, frame.channels[i]);
+}
+
+TEST_F(SBusTest, FailsafeWithoutFrames) {
+	uint8_t buf[SBUS_FRAME_LENGTH];
+	uint16_t channels[16] = { 0 };
+
+	mock_advance_to(7000);
+	sbus_frame(channels, 0, buf);
+	feed(SBUS_PORT, buf, sizeof(buf));
+	EXPECT_EQ(2u, read_frame().sequence);
+
+	mock_advance_to(200000);
+	EXPECT_EQ(2u, read_frame().sequence);
+
+	mock_advance_to(300000);
+
+	struct pios_rcvr_frame frame = read_frame();
+	EXPECT_EQ(3u, frame.sequence);
+	for (int i = 0; i < PIOS_SBUS_NUM_INPUTS; i++)
+		EXPECT_EQ(TIMEOUT_VALUE, frame.channels[i]);
+}
+
+/* DSM: replay recordings of real satellites, byte by byte at the times
+ * they were captured */
+
+class DsmTest : public RcvrTest {
+protected:
+	virtual void SetUp() {
+		RcvrTest::SetUp();
+
+		static const struct pios_dsm_cfg cfg = { 0 };
+		uintptr_t dsm_id;
+
+		ASSERT_EQ(0, PIOS_DSM_Init(&dsm_id, &cfg, &mock_com_driver,
+					DSM_PORT, HWSHARED_DSMXMODE_AUTODETECT));
+		ASSERT_EQ(0, PIOS_RCVR_Init(&rcvr_id, &pios_dsm_rcvr_driver, dsm_id));
+	}
+
+	void replay(const char *fn, int channels, uint32_t frame_period_us);
+};
+
+void DsmTest::replay(const char *fn, int channels, uint32_t frame_period_us)
+{
+	FILE *fid = fopen(fn, "r");
+	ASSERT_TRUE(fid != NULL);
+
+	char *line = NULL;
+	size_t len = 0;
+
+	// throwaway intro line
+	ASSERT_GT(getline(&line, &len, fid), 0);
+	free(line);
+
+	double t;
+	uint8_t val;
+	double start = -1;
+	int bytes = 0;
+
+	uint32_t last_sequence = read_frame().sequence;
+	uint32_t last_timestamp = 0;
+	int frames = 0;
+	int failsafes = 0;
+
+	while (fscanf(fid, "%lf,%hhx,,", &t, &val) == 2) {
+		if (start < 0)
+			start = t;
+
+		mock_advance_to((t - start) * 1e6);
+		EXPECT_EQ(1, mock_com_receive(DSM_PORT, &val, 1));
+		bytes++;
+
+		struct pios_rcvr_frame frame = read_frame();
+
+		if (frame.sequence == last_sequence)
+			continue;
+
+		ASSERT_EQ(PIOS_DSM_NUM_INPUTS, frame.num_channels);
+
+		/* The recordings have gaps long enough for failsafe to
+		 * trigger, maybe more than once */
+		if (frame.channels[0] == TIMEOUT_VALUE) {
+			for (int i = 0; i < PIOS_DSM_NUM_INPUTS; i++)
+				EXPECT_EQ(TIMEOUT_VALUE, frame.channels[i]);
+
+			EXPECT_GT(frame.sequence, last_sequence);
+			last_sequence = frame.sequence;
+			last_timestamp = 0;
+			failsafes++;
+			continue;
+		}
+
+		EXPECT_EQ(last_sequence + 1, frame.sequence);
+		EXPECT_EQ(mock_time_us, frame.timestamp);
+
+		/* Every channel the transmitter sends is in every frame */
+		for (int i = 0; i < channels; i++) {
+			EXPECT_GT(frame.channels[i], 340);
+			EXPECT_LE(frame.channels[i], 2048);
+		}
+
+		if (last_timestamp) {
+			EXPECT_NEAR(frame_period_us, frame.timestamp - last_timestamp, 100);
+		}
+
+		last_sequence = frame.sequence;
+		last_timestamp = frame.timestamp;
+		frames++;
+	}
+
+	fclose(fid);
+
+	/* All but the packets before the decoder found its feet after
+	 * starting and after each gap */
+	int packets = bytes / DSM_FRAME_LENGTH;
+	int packets_per_frame = (channels > DSM_CHANNELS_PER_FRAME) ? 2 : 1;
+	int lost = 2 * (1 + (failsafes > 0));
+
+	EXPECT_GE(frames, packets / packets_per_frame - lost);
+	EXPECT_LE(frames, packets / packets_per_frame);
+}
+
+TEST_F(DsmTest, DX7_DSM2_11ms) {
+	replay("../dsm/DX7_11msDSM2.txt", 8, 22000);
+}
+
+TEST_F(DsmTest, DX7_DSM2_22ms) {
+	replay("../dsm/DX7_22msDSM2.txt", 8, 22000);
+}
+
+TEST_F(DsmTest, DX7_DSMX_11ms) {
+	replay("../dsm/DX7_11msDSMX.txt", 8, 22000);
+}
+
+TEST_F(DsmTest, DX7_DSMX_22ms) {
+	replay("../dsm/DX7_22msDSMX.txt", 8, 22000);
+}
+
+TEST_F(DsmTest, DX18_DSM2_2048) {
+	replay("../dsm/DX18_11msDSM2_2048res.txt", 10, 22000);
+}
+
+TEST_F(DsmTest, DX18_DSMX_11ms) {
+	replay("../dsm/DX18_11msDSMX.txt", 10, 22000);
+}
+
+TEST_F(DsmTest, DX18_DSMX_22ms) {
+	replay("../dsm/DX18_22msDSMX.txt", 12, 22000);
+}
+
+/* IBus: 32 byte frames every 7ms, with 10 channels */
+
+#define IBUS_FRAME_LENGTH 32
+#define IBUS_CHANNELS 10
+
+static void ibus_frame(const uint16_t *channels, uint8_t *out)
+{
+	uint16_t checksum = 0xffff;
+
+	memset(out, 0, IBUS_FRAME_LENGTH);
+	out[0] = 0x20;
+	out[1] = 0x40;
+
+	for (int i = 0; i < IBUS_CHANNELS; i++) {
+		out[2 + i * 2] = channels[i] & 0xff;
+		out[3 + i * 2] = channels[i] >> 8;
+	}
+
+	for (int i = 0; i < IBUS_FRAME_LENGTH - 2; i++)
+		checksum -= out[i];
+
+	out[IBUS_FRAME_LENGTH - 2] = checksum & 0xff;
+	out[IBUS_FRAME_LENGTH - 1] = checksum >> 8;
+}
+
+class IBusTest : public RcvrTest {
+protected:
+	virtual void SetUp() {
+		RcvrTest::SetUp();
+
+		uintptr_t ibus_id;
+		ASSERT_EQ(0, PIOS_IBus_Init(&ibus_id, &mock_com_driver, IBUS_PORT));
+		ASSERT_EQ(0, PIOS_RCVR_Init(&rcvr_id, &pios_ibus_rcvr_driver, ibus_id));
+	}
+};
+
+TEST_F(IBusTest, FramesCarryAllChannels) {
+	uint8_t buf[IBUS_FRAME_LENGTH];
+	uint16_t channels[IBUS_CHANNELS];
+
+	/* Nothing decoded yet */
+	EXPECT_EQ(0, read_frame().num_channels);
+
+	for (int n = 0; n < 100; n++) {
+		for (int i = 0; i < IBUS_CHANNELS; i++)
+			channels[i] = 1000 + test_channel(n, i) / 2;
+
+		if (n % 10 == 5) {
+			feed_noise(IBUS_PORT, 40);
+			mock_advance_to(mock_time_us + 7000);
+		}
+
+		mock_advance_to(mock_time_us + 7000);
+		ibus_frame(channels, buf);
+		feed(IBUS_PORT, buf, sizeof(buf));
+
+		struct pios_rcvr_frame frame = read_frame();
+
+		EXPECT_EQ(1u + n, frame.sequence);
+		EXPECT_EQ(mock_time_us, frame.timestamp);
+		ASSERT_EQ(IBUS_CHANNELS, frame.num_channels);
+
+		for (int i = 0; i < IBUS_CHANNELS; i++)
+			EXPECT_EQ(channels[i], frame.channels[i]);
+	}
+
+	/* One past the last channel */
+	EXPECT_EQ(PIOS_RCVR_INVALID, PIOS_RCVR_Read(rcvr_id, IBUS_CHANNELS + 1));
+}
+
+TEST_F(IBusTest, BadChecksum) {
+	uint8_t buf[IBUS_FRAME_LENGTH];
+	uint16_t channels[IBUS_CHANNELS] = { 1500 };
+
+	mock_advance_to(7000);
+	ibus_frame(channels, buf);
+	buf[5] ^= 0x10;
+	feed(IBUS_PORT, buf, sizeof(buf));
+
+	EXPECT_EQ(0u, read_frame().sequence);
+
+	mock_advance_to(14000);
+	ibus_frame(channels, buf);
+	feed(IBUS_PORT, buf, sizeof(buf));
+
+	EXPECT_EQ(1u, read_frame().sequence);
+}
+
+TEST_F(IBusTest, FailsafeOnce) {
+	uint8_t buf[IBUS_FRAME_LENGTH];
+	uint16_t channels[IBUS_CHANNELS] = { 1500 };
+
+	mock_advance_to(7000);
+	ibus_frame(channels, buf);
+	feed(IBUS_PORT, buf, sizeof(buf));
+
+	uint32_t wakes = mock_rcvr_wakes;
+
+	mock_advance_to(2000000);
+
+	struct pios_rcvr_frame frame = read_frame();
+	EXPECT_EQ(2u, frame.sequence);
+	EXPECT_NEAR(7000 + 250000, frame.timestamp, 2000);
+	for (int i = 0; i < IBUS_CHANNELS; i++)
+		EXPECT_EQ(TIMEOUT_VALUE, frame.channels[i]);
+
+	EXPECT_EQ(1u, mock_rcvr_wakes - wakes);
+}
+
+/* Crossfire: 26 byte RC channel frames among telemetry frames */
+
+#define CRSF_RC_FRAME_LENGTH (CRSF_ADDRESS_LEN + CRSF_LENGTH_LEN + \
+		CRSF_TYPE_LEN + CRSF_PAYLOAD_RCCHANNELS + CRSF_CRC_LEN)
+
+static int crsf_frame(uint8_t type, const uint8_t *payload, int payload_len,
+		uint8_t *out)
+{
+	out[0] = 0xc8;
+	out[1] = CRSF_TYPE_LEN + payload_len + CRSF_CRC_LEN;
+	out[2] = type;
+	memcpy(&out[3], payload, payload_len);
+	out[3 + payload_len] = PIOS_CRC_updateCRC_TBS(0, &out[2],
+			CRSF_TYPE_LEN + payload_len);
+
+	return 4 + payload_len;
+}
+
+static int crsf_rc_frame(const uint16_t *channels, uint8_t *out)
+{
+	uint8_t payload[CRSF_PAYLOAD_RCCHANNELS];
+
+	pack_11bit_channels(channels, payload);
+
+	return crsf_frame(CRSF_FRAME_RCCHANNELS, payload, sizeof(payload), out);
+}
+
+class CrossfireTest : public RcvrTest {
+protected:
+	virtual void SetUp() {
+		RcvrTest::SetUp();
+
+		ASSERT_EQ(0, PIOS_Crossfire_Init(&crsf_id, &mock_com_driver, CRSF_PORT));
+		ASSERT_EQ(0, PIOS_RCVR_Init(&rcvr_id, &pios_crossfire_rcvr_driver, crsf_id));
+	}
+
+	uintptr_t crsf_id;
+};
+
+TEST_F(CrossfireTest, FramesCarryAllChannels) {
+	uint8_t buf[2 * CRSF_MAX_FRAMELEN];
+	uint16_t channels[PIOS_CROSSFIRE_CHANNELS];
+	uint8_t battery[CRSF_PAYLOAD_BATTERY] = { 0 };
+
+	EXPECT_EQ(0, read_frame().num_channels);
+
+	for (int n = 0; n < 100; n++) {
+		for (int i = 0; i < PIOS_CROSSFIRE_CHANNELS; i++)
+			channels[i] = test_channel(n, i);
+
+		if (n % 10 == 5) {
+			feed_noise(CRSF_PORT, 40);
+			mock_advance_to(mock_time_us + 4000);
+		}
+
+		/* Other frame types may come first, back to back */
+		int len = 0;
+		if (n % 3 == 0)
+			len = crsf_frame(CRSF_FRAME_BATTERY, battery, sizeof(battery), buf);
+
+		len += crsf_rc_frame(channels, &buf[len]);
+		ASSERT_EQ(n % 3 ? CRSF_RC_FRAME_LENGTH : CRSF_RC_FRAME_LENGTH + 12, len);
+
+		mock_advance_to(mock_time_us + 6667);
+		feed(CRSF_PORT, buf, len);
+
+		struct pios_rcvr_frame frame = read_frame();
+
+		EXPECT_EQ(1u + n, frame.sequence);
+		EXPECT_EQ(mock_time_us, frame.timestamp);
+		ASSERT_EQ(PIOS_CROSSFIRE_CHANNELS, frame.num_channels);
+
+		for (int i = 0; i < PIOS_CROSSFIRE_CHANNELS; i++)
+			EXPECT_EQ(channels[i], frame.channels[i]);
+	}
+
+	EXPECT_FALSE(PIOS_Crossfire_IsFailsafed(crsf_id));
+
+	/* One past the last channel */
+	EXPECT_EQ(PIOS_RCVR_INVALID,
+			PIOS_RCVR_Read(rcvr_id, PIOS_CROSSFIRE_CHANNELS + 1));
+}
+
+TEST_F(CrossfireTest, BadCrc) {
+	uint8_t buf[CRSF_MAX_FRAMELEN];
+	uint16_t channels[PIOS_CROSSFIRE_CHANNELS] = { 992 };
+
+	int len = crsf_rc_frame(channels, buf);
+	buf[len - 1] ^= 0x01;
+
+	mock_advance_to(6667);
+	feed(CRSF_PORT, buf, len);
+	EXPECT_EQ(0u, read_frame().sequence);
+
+	len = crsf_rc_frame(channels, buf);
+
+	mock_advance_to(13333);
+	feed(CRSF_PORT, buf, len);
+	EXPECT_EQ(1u, read_frame().sequence);
+}
+
+TEST_F(CrossfireTest, FailsafeOnce) {
+	uint8_t buf[CRSF_MAX_FRAMELEN];
+	uint16_t channels[PIOS_CROSSFIRE_CHANNELS] = { 992 };
+
+	mock_advance_to(6667);
+	feed(CRSF_PORT, buf, crsf_rc_frame(channels, buf));
+
+	uint32_t wakes = mock_rcvr_wakes;
+
+	/* Long enough for the old 16 bit failsafe timer to wrap */
+	mock_advance_to(120000000);
+
+	EXPECT_TRUE(PIOS_Crossfire_IsFailsafed(crsf_id));
+
+	struct pios_rcvr_frame frame = read_frame();
+	EXPECT_EQ(2u, frame.sequence);
+	for (int i = 0; i < PIOS_CROSSFIRE_CHANNELS; i++)
+		EXPECT_EQ(TIMEOUT_VALUE, frame.channels[i]);
+
+	EXPECT_EQ(1u, mock_rcvr_wakes - wakes);
+}
@@ -0,0 +1,195 @@
+/*
+ * Stand-ins for the PiOS services the receiver drivers use: a clock that
+ * only moves when the test says so, an RTC ticked by hand and serial ports
+ * fed from the test.
+ */
+
+#include "pios.h"
+
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+
+#include "unittest_mocks.h"
+
+#define RTC_TICK_US 1600
+#define MAX_TICK_CALLBACKS 8
+#define MAX_PORTS 8
+
+uint32_t mock_time_us;
+uint32_t mock_rcvr_wakes;
+
+static uint32_t next_tick_us;
+
+static struct {
+	void (*fn)(uintptr_t id);
+	uintptr_t data;
+} tick_callbacks[MAX_TICK_CALLBACKS];
+static int num_tick_callbacks;
+
+static struct {
+	pios_com_callback rx_in_cb;
+	uintptr_t context;
+} ports[MAX_PORTS];
+
+static void mock_bind_rx_cb(uintptr_t id, pios_com_callback rx_in_cb,
+		uintptr_t context)
+{
+	PIOS_Assert(id < MAX_PORTS);
+
+	ports[id].rx_in_cb = rx_in_cb;
+	ports[id].context = context;
+}
+
+const struct pios_com_driver mock_com_driver = {
+	.bind_rx_cb = mock_bind_rx_cb,
+};
+
+void mock_reset(void)
+{
+	mock_time_us = 0;
+	next_tick_us = RTC_TICK_US;
+	mock_rcvr_wakes = 0;
+	num_tick_callbacks = 0;
+	memset(ports, 0, sizeof(ports));
+}
+
+void mock_rtc_tick(void)
+{
+	mock_time_us = next_tick_us;
+	next_tick_us += RTC_TICK_US;
+
+	for (int i = 0; i < num_tick_callbacks; i++) {
+		tick_callbacks[i].fn(tick_callbacks[i].data);
+	}
+}
+
+void mock_advance_to(uint32_t time_us)
+{
+	while ((int32_t)(time_us - next_tick_us) >= 0) {
+		mock_rtc_tick();
+	}
+
+	mock_time_us = time_us;
+}
+
+uint16_t mock_com_receive(uintptr_t lower_id, const uint8_t *buf, uint16_t len)
+{
+	PIOS_Assert(lower_id < MAX_PORTS && ports[lower_id].rx_in_cb);
+
+	uint16_t headroom;
+	bool need_yield;
+
+	return ports[lower_id].rx_in_cb(ports[lower_id].context,
+			(uint8_t *)buf, len, &headroom, &need_yield);
+}
+
+bool PIOS_RTC_RegisterTickCallback(void (*fn)(uintptr_t id), uintptr_t data)
+{
+	if (num_tick_callbacks >= MAX_TICK_CALLBACKS)
+		return false;
+
+	tick_callbacks[num_tick_callbacks].fn = fn;
+	tick_callbacks[num_tick_callbacks].data = data;
+	num_tick_callbacks++;
+
+	return true;
+}
+
+uint32_t PIOS_DELAY_GetRaw()
+{
+	return mock_time_us;
+}
+
+uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
+{
+	return mock_time_us - raw;
+}
+
+int32_t PIOS_DELAY_WaituS(uint32_t uS)
+{
+	mock_advance_to(mock_time_us + uS);
+	return 0;
+}
+
+int32_t PIOS_IRQ_Disable(void)
+{
+	return 0;
+}
+
+int32_t PIOS_IRQ_Enable(void)
+{
+	return 0;
+}
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void *PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_DEBUG_Panic(const char *msg)
+{
+	(void) msg;
+	abort();
+}
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+	static uint8_t sema;
+
+	return (struct pios_semaphore *)&sema;
+}
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+	(void) sema;
+	(void) timeout_ms;
+	return false;
+}
+
+bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
+{
+	(void) sema;
+	__atomic_fetch_add(&mock_rcvr_wakes, 1, __ATOMIC_RELAXED);
+	return true;
+}
+
+bool PIOS_Semaphore_Give_FromISR(struct pios_semaphore *sema, bool *woken)
+{
+	*woken = false;
+	return PIOS_Semaphore_Give(sema);
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+	(void) time_ms;
+}
+
+bool PIOS_Thread_FakeClock_IsActive(void)
+{
+	return false;
+}
+
+void PIOS_Thread_FakeClock_UpdateBarrier(uint32_t increment)
+{
+	(void) increment;
+}
+
+int32_t PIOS_COM_Init(uintptr_t *com_id, const struct pios_com_driver *driver,
+		uintptr_t lower_id, uint16_t rx_buffer_len, uint16_t tx_buffer_len)
+{
+	(void) driver; (void) rx_buffer_len; (void) tx_buffer_len;
+
+	*com_id = lower_id + 1;
+	return 0;
+}
+
+int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len)
+{
+	(void) com_id; (void) buffer;
+	return len;
+}
@@ -0,0 +1,33 @@
+/*
+ * Shared between the PiOS stand-ins and the test driver.
+ */
+
+#ifndef UNITTEST_MOCKS_H
+#define UNITTEST_MOCKS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pios_com.h"
+
+/* Microseconds, as PIOS_DELAY_GetRaw() returns them */
+extern uint32_t mock_time_us;
+
+/* Times the receiver layer gave its activity semaphore */
+extern uint32_t mock_rcvr_wakes;
+
+/* Serial port whose receive callback the drivers bind to */
+extern const struct pios_com_driver mock_com_driver;
+
+void mock_reset(void);
+
+/* Advances the clock by one RTC tick and runs the tick callbacks */
+void mock_rtc_tick(void);
+
+/* Advances the clock to a time, ticking the RTC on the way */
+void mock_advance_to(uint32_t time_us);
+
+/* Hands bytes to the receive callback bound to a port */
+uint16_t mock_com_receive(uintptr_t lower_id, const uint8_t *buf, uint16_t len);
+
+#endif /* UNITTEST_MOCKS_H */
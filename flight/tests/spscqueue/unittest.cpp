@@ -0,0 +1,268 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <pthread.h>		/* pthread_create */
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_queue.h"
+#include "pios_spscqueue.h"
+
+}
+
+#define BENCH_ITEMS 1000000
+
+struct sample {
+	uint32_t seq;
+	float x, y, z;
+};
+
+// To use a test fixture, derive a class from testing::Test.
+class SPSCQueue : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(SPSCQueue, FillAndDrain) {
+  struct pios_spscqueue *q = PIOS_SPSCQueue_Create(4, sizeof(struct sample));
+  ASSERT_TRUE(q != NULL);
+
+  EXPECT_EQ(sizeof(struct sample), PIOS_SPSCQueue_GetItemSize(q));
+
+  struct sample s = { 0, 1.0f, 2.0f, 3.0f };
+
+  for (uint32_t i = 0; i < 4; i++) {
+    s.seq = i;
+    EXPECT_TRUE(PIOS_SPSCQueue_Send(q, &s, 0));
+  }
+
+  /* Full */
+  EXPECT_FALSE(PIOS_SPSCQueue_Send(q, &s, 0));
+  EXPECT_FALSE(PIOS_SPSCQueue_Send(q, &s, 5));
+
+  for (uint32_t i = 0; i < 4; i++) {
+    EXPECT_TRUE(PIOS_SPSCQueue_Receive(q, &s, 0));
+    EXPECT_EQ(i, s.seq);
+    EXPECT_EQ(2.0f, s.y);
+  }
+
+  /* Empty */
+  EXPECT_FALSE(PIOS_SPSCQueue_Receive(q, &s, 0));
+  EXPECT_FALSE(PIOS_SPSCQueue_Receive(q, &s, 5));
+}
+
+TEST_F(SPSCQueue, BatchWraps) {
+  struct pios_spscqueue *q = PIOS_SPSCQueue_Create(5, sizeof(uint32_t));
+  ASSERT_TRUE(q != NULL);
+
+  uint32_t next_in = 0, next_out = 0;
+
+  for (int round = 0; round < 100; round++) {
+    uint32_t in[3] = { next_in, next_in + 1, next_in + 2 };
+
+    ASSERT_EQ(3, PIOS_SPSCQueue_SendMulti(q, in, 3, 0));
+    next_in += 3;
+
+    uint32_t out[8];
+
+    ASSERT_EQ(3, PIOS_SPSCQueue_ReceiveMulti(q, out, 8, 0));
+
+    for (int i = 0; i < 3; i++) {
+      EXPECT_EQ(next_out++, out[i]);
+    }
+  }
+
+  /* Only as many as fit are accepted */
+  uint32_t many[8] = { 0 };
+  EXPECT_EQ(5, PIOS_SPSCQueue_SendMulti(q, many, 8, 0));
+}
+
+static void *spsc_producer(void *ctx)
+{
+  struct pios_spscqueue *q = (struct pios_spscqueue *) ctx;
+  struct sample s = { 0, 0, 0, 0 };
+
+  for (uint32_t i = 0; i < BENCH_ITEMS; i++) {
+    s.seq = i;
+    PIOS_SPSCQueue_Send(q, &s, PIOS_SPSCQUEUE_TIMEOUT_MAX);
+  }
+
+  return NULL;
+}
+
+static void *spsc_batch_producer(void *ctx)
+{
+  struct pios_spscqueue *q = (struct pios_spscqueue *) ctx;
+  struct sample s[16];
+  uint32_t i = 0;
+
+  while (i < BENCH_ITEMS) {
+    uint16_t n = 0;
+
+    while ((n < 16) && (i + n < BENCH_ITEMS)) {
+      s[n].seq = i + n;
+      n++;
+    }
+
+    i += PIOS_SPSCQueue_SendMulti(q, s, n, PIOS_SPSCQUEUE_TIMEOUT_MAX);
+  }
+
+  return NULL;
+}
+
+static void *queue_producer(void *ctx)
+{
+  struct pios_queue *q = (struct pios_queue *) ctx;
+  struct sample s = { 0, 0, 0, 0 };
+
+  for (uint32_t i = 0; i < BENCH_ITEMS; i++) {
+    s.seq = i;
+    PIOS_Queue_Send(q, &s, PIOS_QUEUE_TIMEOUT_MAX);
+  }
+
+  return NULL;
+}
+
+TEST_F(SPSCQueue, UncontendedCostVersusQueue) {
+  struct pios_spscqueue *spsc = PIOS_SPSCQueue_Create(64, sizeof(struct sample));
+  struct pios_queue *queue = PIOS_Queue_Create(64, sizeof(struct sample));
+  struct sample s = { 0, 0, 0, 0 };
+
+  ASSERT_TRUE(spsc != NULL);
+  ASSERT_TRUE(queue != NULL);
+
+  /* One thread sending and receiving, so nobody ever blocks: what each
+   * queue costs per item, without the scheduler */
+  double start = ut_seconds();
+
+  for (uint32_t i = 0; i < BENCH_ITEMS; i++) {
+    s.seq = i;
+    PIOS_SPSCQueue_Send(spsc, &s, 0);
+    ASSERT_TRUE(PIOS_SPSCQueue_Receive(spsc, &s, 0));
+    ASSERT_EQ(i, s.seq);
+  }
+
+  double spsc_time = ut_seconds() - start;
+
+  start = ut_seconds();
+
+  for (uint32_t i = 0; i < BENCH_ITEMS; i++) {
+    s.seq = i;
+    PIOS_Queue_Send(queue, &s, 0);
+    ASSERT_TRUE(PIOS_Queue_Receive(queue, &s, 0));
+    ASSERT_EQ(i, s.seq);
+  }
+
+  double queue_time = ut_seconds() - start;
+
+  printf("%d items uncontended: spsc %.0f ns/item, pios_queue %.0f ns/item\n",
+      BENCH_ITEMS, spsc_time * 1e9 / BENCH_ITEMS,
+      queue_time * 1e9 / BENCH_ITEMS);
+}
+
+TEST_F(SPSCQueue, ThroughputVersusQueue) {
+  struct pios_spscqueue *spsc = PIOS_SPSCQueue_Create(64, sizeof(struct sample));
+  struct pios_queue *queue = PIOS_Queue_Create(64, sizeof(struct sample));
+  struct sample s;
+  pthread_t producer;
+
+  ASSERT_TRUE(spsc != NULL);
+  ASSERT_TRUE(queue != NULL);
+
+  /* Single items through the lock-free queue */
+  double start = ut_seconds();
+  pthread_create(&producer, NULL, spsc_producer, spsc);
+
+  for (uint32_t i = 0; i < BENCH_ITEMS; i++) {
+    ASSERT_TRUE(PIOS_SPSCQueue_Receive(spsc, &s, 1000));
+    ASSERT_EQ(i, s.seq);
+  }
+
+  pthread_join(producer, NULL);
+  double spsc_time = ut_seconds() - start;
+
+  /* Batches through the lock-free queue */
+  start = ut_seconds();
+  pthread_create(&producer, NULL, spsc_batch_producer, spsc);
+
+  uint32_t received = 0;
+
+  while (received < BENCH_ITEMS) {
+    struct sample batch[16];
+    uint16_t n = PIOS_SPSCQueue_ReceiveMulti(spsc, batch, 16, 1000);
+
+    ASSERT_NE(0, n);
+
+    for (uint16_t i = 0; i < n; i++) {
+      ASSERT_EQ(received + i, batch[i].seq);
+    }
+
+    received += n;
+  }
+
+  pthread_join(producer, NULL);
+  double batch_time = ut_seconds() - start;
+
+  /* The mutex/condvar based PIOS_Queue, for comparison */
+  start = ut_seconds();
+  pthread_create(&producer, NULL, queue_producer, queue);
+
+  for (uint32_t i = 0; i < BENCH_ITEMS; i++) {
+    ASSERT_TRUE(PIOS_Queue_Receive(queue, &s, 1000));
+    ASSERT_EQ(i, s.seq);
+  }
+
+  pthread_join(producer, NULL);
+  double queue_time = ut_seconds() - start;
+
+  printf("%d items: spsc %.0f ns/item, spsc batch %.0f ns/item, "
+      "pios_queue %.0f ns/item\n", BENCH_ITEMS,
+      spsc_time * 1e9 / BENCH_ITEMS, batch_time * 1e9 / BENCH_ITEMS,
+      queue_time * 1e9 / BENCH_ITEMS);
+}
+
+/**
+ * @}
+ * @}
+ */
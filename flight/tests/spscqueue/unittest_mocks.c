@@ -0,0 +1,39 @@
+/*
+ * Minimal stand-ins for the pios_thread API, so that the queue code can be
+ * exercised without the rest of the flight posix environment.
+ */
+
+#include <time.h>
+
+#include "pios.h"
+#include "pios_thread.h"
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+bool PIOS_Thread_Period_Elapsed(const uint32_t prev_systime,
+		const uint32_t increment_ms)
+{
+	return (PIOS_Thread_Systime() - prev_systime) >= increment_ms;
+}
+
+bool PIOS_Thread_FakeClock_IsActive(void)
+{
+	return false;
+}
+
+uint32_t PIOS_Thread_Block_Begin(void)
+{
+	return 0;
+}
+
+void PIOS_Thread_Block_End(uint32_t begin)
+{
+	(void) begin;
+}
@@ -0,0 +1,346 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <stdint.h>		/* uint*_t */
+
+#include <vector>
+
+extern "C" {
+
+#include "sysident.h"		/* API for the recursive identification */
+
+}
+
+#include <math.h>		/* expf() */
+
+/* 500Hz, the usual autotune loop rate */
+static const float Ts = 0.002f;
+
+/* Forgetting factor used by the Autotune module */
+static const float lambda = 0.9998f;
+
+struct plant {
+  float tau;
+  float beta;
+  float bias;
+  int delay;		/* samples of dead time */
+  float noise;		/* gyro noise, deg/s RMS */
+};
+
+struct sample {
+  float y;
+  float u;
+};
+
+static float gaussian()
+{
+  /* Irwin-Hall; plenty for sensor noise */
+  float sum = 0;
+
+  for (int i = 0; i < 12; i++) {
+    sum += rand() / (float) RAND_MAX;
+  }
+
+  return sum - 6;
+}
+
+/*
+ * Fly a simulated axis through the autotune wiggle: a rate P loop plus
+ * the +/- square wave that stabilization injects on roll.  The plant is
+ * integrated on a fine time grid rather than with the model the
+ * estimator assumes.
+ */
+static std::vector<sample> fly(const plant &p, int n, float effort = 0.1f,
+    int phase_shift = 6)
+{
+  std::vector<sample> log;
+  std::vector<float> pending(p.delay, 0.0f);
+
+  const int substeps = 20;
+  const float h = Ts / substeps;
+  const float Beta = expf(p.beta);
+
+  /* Rate loop tuned for a 60 rad/s crossover, as a sane PID would be */
+  const float kp = 60 / Beta;
+
+  float w = 0, a = 0;
+
+  for (int k = 0; k < n; k++) {
+    float y = w + p.noise * gaussian();
+
+    float u = -kp * y;
+
+    switch ((k >> phase_shift) & 0x07) {
+      case 1:
+        u += effort;
+        break;
+      case 3:
+        u -= effort;
+        break;
+    }
+
+    log.push_back({ y, u });
+
+    pending.push_back(u);
+    float applied = pending.front();
+    pending.erase(pending.begin());
+
+    for (int s = 0; s < substeps; s++) {
+      float a_next = a + (applied - p.bias - a) * (1 - expf(-h / p.tau));
+
+      w += Beta * (a + a_next) / 2 * h;
+      a = a_next;
+    }
+  }
+
+  return log;
+}
+
+static sysident_estimate run_rls(const std::vector<sample> &log,
+    sysident_axis *axis, bool *ok)
+{
+  sysident_estimate est = { };
+
+  for (const sample &s : log) {
+    sysident_axis_update(axis, s.y, s.u, lambda);
+  }
+
+  *ok = sysident_axis_estimate(axis, Ts, &est);
+
+  return est;
+}
+
+/*
+ * Offline reference: what the save-and-analyse path does.  Autotune
+ * averages the log over wiggle cycles; the analysis then fits the
+ * plant to the averaged cycle.  This fits by output error, in double
+ * precision: for each delay and each tau on a fine grid the actuator
+ * state is simulated from the averaged command, the gain and offset come
+ * from linear least squares against the averaged rate steps, and the
+ * best residual wins.
+ */
+static sysident_estimate offline_fit(const std::vector<sample> &log,
+    int phase_shift = 6)
+{
+  const int points = 8 << phase_shift;
+
+  std::vector<double> y(points, 0), u(points, 0);
+
+  for (size_t k = 0; k < log.size(); k++) {
+    y[k % points] += log[k].y;
+    u[k % points] += log[k].u;
+  }
+
+  double cycles = log.size() / (double) points;
+
+  for (int k = 0; k < points; k++) {
+    y[k] /= cycles;
+    u[k] /= cycles;
+  }
+
+  sysident_estimate best = { };
+  double best_res = INFINITY;
+
+  for (int d = 0; d < SYSIDENT_DELAYS; d++) {
+    for (double tau = 0.005; tau < 0.1; tau += 0.0001) {
+      double e = exp(-Ts / tau);
+      double a = 0;
+
+      std::vector<double> r(points);
+
+      /* Two cycles so the actuator state is periodic */
+      for (int k = 0; k < 2 * points; k++) {
+        double applied = u[(k - d + points) % points];
+
+        r[k % points] = tau * (1 - e) * a + (Ts - tau * (1 - e)) * applied;
+        a = e * a + (1 - e) * applied;
+      }
+
+      double srr = 0, sr = 0, sry = 0, sy = 0;
+
+      for (int k = 0; k < points; k++) {
+        double dy = y[(k + 1) % points] - y[k];
+
+        srr += r[k] * r[k];
+        sr += r[k];
+        sry += r[k] * dy;
+        sy += dy;
+      }
+
+      double Beta = (points * sry - sr * sy) / (points * srr - sr * sr);
+      double c = (sy - Beta * sr) / points;
+      double res = 0;
+
+      for (int k = 0; k < points; k++) {
+        double err = y[(k + 1) % points] - y[k] - (Beta * r[k] + c);
+
+        res += err * err;
+      }
+
+      if (res < best_res && Beta > 0) {
+        best_res = res;
+        best.tau = tau;
+        best.beta = ::log(Beta);
+        best.bias = -c / (Beta * Ts);
+        best.delay = d * Ts;
+      }
+    }
+  }
+
+  return best;
+}
+
+class SysIdentTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1234);
+    sysident_axis_init(&axis);
+  }
+
+  sysident_axis axis;
+};
+
+TEST_F(SysIdentTest, NoDataNoEstimate) {
+  sysident_estimate est;
+
+  EXPECT_FALSE(sysident_axis_estimate(&axis, Ts, &est));
+
+  for (int i = 0; i < 100; i++) {
+    sysident_axis_update(&axis, 0, 0, lambda);
+  }
+
+  EXPECT_FALSE(sysident_axis_estimate(&axis, Ts, &est));
+}
+
+TEST_F(SysIdentTest, NoiseFree) {
+  plant p = { 0.030f, 10.0f, 0.02f, 2, 0.0f };
+  bool ok;
+
+  sysident_estimate est = run_rls(fly(p, 6000), &axis, &ok);
+
+  ASSERT_TRUE(ok);
+  EXPECT_NEAR(p.tau, est.tau, 0.0003f);
+  EXPECT_NEAR(p.beta, est.beta, 0.01f);
+  EXPECT_NEAR(p.bias, est.bias, 0.001f);
+  EXPECT_FLOAT_EQ(p.delay * Ts, est.delay);
+  EXPECT_GT(est.confidence, 0.99f);
+}
+
+TEST_F(SysIdentTest, PicksDelay) {
+  for (int d = 0; d < SYSIDENT_DELAYS; d++) {
+    plant p = { 0.025f, 9.5f, 0.0f, d, 0.05f };
+    bool ok;
+
+    sysident_axis_init(&axis);
+    sysident_estimate est = run_rls(fly(p, 6000), &axis, &ok);
+
+    ASSERT_TRUE(ok);
+    EXPECT_FLOAT_EQ(d * Ts, est.delay) << "delay " << d;
+  }
+}
+
+TEST_F(SysIdentTest, MatchesOfflineFit) {
+  /* A full autotune run: 24 seconds of noisy gyro data */
+  const plant quads[] = {
+    { 0.020f, 10.5f, 0.01f, 1, 1.0f },
+    { 0.045f, 9.0f, -0.03f, 2, 0.3f },
+    { 0.030f, 11.0f, 0.0f, 0, 2.0f },
+  };
+
+  for (const plant &p : quads) {
+    std::vector<sample> log = fly(p, 12000);
+    bool ok;
+
+    sysident_axis_init(&axis);
+    sysident_estimate est = run_rls(log, &axis, &ok);
+    sysident_estimate ref = offline_fit(log);
+
+    printf("tau %.4f/%.4f/%.4f beta %.3f/%.3f/%.3f "
+        "delay %.3f/%.3f conf %.3f (true/offline/online)\n",
+        p.tau, ref.tau, est.tau, p.beta, ref.beta, est.beta,
+        ref.delay, est.delay, est.confidence);
+
+    ASSERT_TRUE(ok);
+
+    /* Lag and dead time trade off against each other in noise; their
+     * sum, the effective response time, is what is well determined. */
+    float ref_resp = ref.tau + ref.delay;
+    float est_resp = est.tau + est.delay;
+
+    EXPECT_NEAR(ref_resp, est_resp, 0.15f * ref_resp);
+    EXPECT_NEAR(ref.beta, est.beta, 0.15f);
+    EXPECT_NEAR(ref.delay, est.delay, 1.5f * Ts);
+
+    EXPECT_NEAR(p.tau + p.delay * Ts, est_resp, 0.15f * ref_resp);
+    EXPECT_NEAR(p.beta, est.beta, 0.15f);
+    EXPECT_GT(est.confidence, 0.2f);
+  }
+}
+
+TEST_F(SysIdentTest, TracksChange) {
+  /* Battery sag midway through: less torque per unit of command */
+  plant fresh = { 0.030f, 10.0f, 0.0f, 1, 0.3f };
+  plant sagged = { 0.030f, 9.6f, 0.0f, 1, 0.3f };
+  bool ok;
+
+  run_rls(fly(fresh, 6000), &axis, &ok);
+  sysident_estimate est = run_rls(fly(sagged, 15000), &axis, &ok);
+
+  ASSERT_TRUE(ok);
+  EXPECT_NEAR(sagged.beta, est.beta, 0.1f);
+}
+
+TEST_F(SysIdentTest, Benchmark) {
+  plant p = { 0.030f, 10.0f, 0.0f, 1, 0.5f };
+  std::vector<sample> log = fly(p, 20000);
+
+  double start = ut_seconds();
+
+  for (const sample &s : log) {
+    sysident_axis_update(&axis, s.y, s.u, lambda);
+  }
+
+  double ns = (ut_seconds() - start) * 1e9;
+
+  printf("%.0f ns per axis update, %u bytes of state per axis\n",
+      ns / log.size(), (unsigned) sizeof(axis));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,15 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef ACTUATORDESIRED_H
+#define ACTUATORDESIRED_H
+
+#include "uavobjectmanager.h"
+
+typedef struct {
+	float Thrust;
+	float UpdateTime;
+} ActuatorDesiredData;
+
+UAVObjHandle ActuatorDesiredHandle(void);
+int32_t ActuatorDesiredGet(ActuatorDesiredData *data);
+
+#endif /* ACTUATORDESIRED_H */
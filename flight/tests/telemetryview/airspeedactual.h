@@ -0,0 +1,15 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef AIRSPEEDACTUAL_H
+#define AIRSPEEDACTUAL_H
+
+#include "uavobjectmanager.h"
+
+typedef struct {
+	float TrueAirspeed;
+} AirspeedActualData;
+
+UAVObjHandle AirspeedActualHandle(void);
+int32_t AirspeedActualGet(AirspeedActualData *data);
+int32_t AirspeedActualTrueAirspeedGet(float *value);
+
+#endif /* AIRSPEEDACTUAL_H */
@@ -0,0 +1,16 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef ATTITUDEACTUAL_H
+#define ATTITUDEACTUAL_H
+
+#include "uavobjectmanager.h"
+
+typedef struct {
+	float Roll;
+	float Pitch;
+	float Yaw;
+} AttitudeActualData;
+
+UAVObjHandle AttitudeActualHandle(void);
+int32_t AttitudeActualGet(AttitudeActualData *data);
+
+#endif /* ATTITUDEACTUAL_H */
@@ -0,0 +1,15 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef BAROALTITUDE_H
+#define BAROALTITUDE_H
+
+#include "uavobjectmanager.h"
+
+typedef struct {
+	float Altitude;
+} BaroAltitudeData;
+
+UAVObjHandle BaroAltitudeHandle(void);
+int32_t BaroAltitudeGet(BaroAltitudeData *data);
+int32_t BaroAltitudeAltitudeGet(float *value);
+
+#endif /* BAROALTITUDE_H */
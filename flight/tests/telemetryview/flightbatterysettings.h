@@ -0,0 +1,42 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef FLIGHTBATTERYSETTINGS_H
+#define FLIGHTBATTERYSETTINGS_H
+
+#include "uavobjectmanager.h"
+
+enum {
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_ADC0 = 0,
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_ADC1 = 1,
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_ADC2 = 2,
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_ADC3 = 3,
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_ADC4 = 4,
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_ADC5 = 5,
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_ADC6 = 6,
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_ADC7 = 7,
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_ADC8 = 8,
+	FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE = 9,
+};
+
+enum {
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_ADC0 = 0,
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_ADC1 = 1,
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_ADC2 = 2,
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_ADC3 = 3,
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_ADC4 = 4,
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_ADC5 = 5,
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_ADC6 = 6,
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_ADC7 = 7,
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_ADC8 = 8,
+	FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE = 9,
+};
+
+typedef struct {
+	uint32_t Capacity;
+	uint8_t CurrentPin;
+	uint8_t VoltagePin;
+} FlightBatterySettingsData;
+
+UAVObjHandle FlightBatterySettingsHandle(void);
+int32_t FlightBatterySettingsGet(FlightBatterySettingsData *data);
+
+#endif /* FLIGHTBATTERYSETTINGS_H */
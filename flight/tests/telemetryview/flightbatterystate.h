@@ -0,0 +1,16 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef FLIGHTBATTERYSTATE_H
+#define FLIGHTBATTERYSTATE_H
+
+#include "uavobjectmanager.h"
+
+typedef struct {
+	float Voltage;
+	float Current;
+	float ConsumedEnergy;
+} FlightBatteryStateData;
+
+UAVObjHandle FlightBatteryStateHandle(void);
+int32_t FlightBatteryStateGet(FlightBatteryStateData *data);
+
+#endif /* FLIGHTBATTERYSTATE_H */
@@ -0,0 +1,53 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef FLIGHTSTATUS_H
+#define FLIGHTSTATUS_H
+
+#include "uavobjectmanager.h"
+
+enum {
+	FLIGHTSTATUS_ARMED_DISARMED = 0,
+	FLIGHTSTATUS_ARMED_ARMING = 1,
+	FLIGHTSTATUS_ARMED_ARMED = 2,
+};
+
+enum {
+	FLIGHTSTATUS_FLIGHTMODE_MANUAL = 0,
+	FLIGHTSTATUS_FLIGHTMODE_ACRO = 1,
+	FLIGHTSTATUS_FLIGHTMODE_LEVELING = 2,
+	FLIGHTSTATUS_FLIGHTMODE_HORIZON = 3,
+	FLIGHTSTATUS_FLIGHTMODE_AXISLOCK = 4,
+	FLIGHTSTATUS_FLIGHTMODE_VIRTUALBAR = 5,
+	FLIGHTSTATUS_FLIGHTMODE_STABILIZED1 = 6,
+	FLIGHTSTATUS_FLIGHTMODE_STABILIZED2 = 7,
+	FLIGHTSTATUS_FLIGHTMODE_STABILIZED3 = 8,
+	FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE = 9,
+	FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD = 10,
+	FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD = 11,
+	FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME = 12,
+	FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER = 13,
+	FLIGHTSTATUS_FLIGHTMODE_TABLETCONTROL = 14,
+	FLIGHTSTATUS_FLIGHTMODE_ACROPLUS = 15,
+	FLIGHTSTATUS_FLIGHTMODE_ACRODYNE = 16,
+	FLIGHTSTATUS_FLIGHTMODE_LQG = 17,
+	FLIGHTSTATUS_FLIGHTMODE_LQGLEVELING = 18,
+	FLIGHTSTATUS_FLIGHTMODE_FLIPREVERSED = 19,
+	FLIGHTSTATUS_FLIGHTMODE_FAILSAFE = 20,
+};
+
+enum {
+	FLIGHTSTATUS_CONTROLSOURCE_GEOFENCE = 0,
+	FLIGHTSTATUS_CONTROLSOURCE_FAILSAFE = 1,
+	FLIGHTSTATUS_CONTROLSOURCE_TRANSMITTER = 2,
+	FLIGHTSTATUS_CONTROLSOURCE_TABLET = 3,
+};
+
+typedef struct {
+	uint8_t Armed;
+	uint8_t FlightMode;
+	uint8_t ControlSource;
+} FlightStatusData;
+
+UAVObjHandle FlightStatusHandle(void);
+int32_t FlightStatusGet(FlightStatusData *data);
+
+#endif /* FLIGHTSTATUS_H */
@@ -0,0 +1,30 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef GPSPOSITION_H
+#define GPSPOSITION_H
+
+#include "uavobjectmanager.h"
+
+enum {
+	GPSPOSITION_STATUS_NOGPS = 0,
+	GPSPOSITION_STATUS_NOFIX = 1,
+	GPSPOSITION_STATUS_FIX2D = 2,
+	GPSPOSITION_STATUS_FIX3D = 3,
+	GPSPOSITION_STATUS_DIFF3D = 4,
+};
+
+typedef struct {
+	int32_t Latitude;
+	int32_t Longitude;
+	float Altitude;
+	float Heading;
+	float Groundspeed;
+	float HDOP;
+	float VDOP;
+	uint8_t Status;
+	uint8_t Satellites;
+} GPSPositionData;
+
+UAVObjHandle GPSPositionHandle(void);
+int32_t GPSPositionGet(GPSPositionData *data);
+
+#endif /* GPSPOSITION_H */
@@ -0,0 +1,22 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef HOMELOCATION_H
+#define HOMELOCATION_H
+
+#include "uavobjectmanager.h"
+
+enum {
+	HOMELOCATION_SET_FALSE = 0,
+	HOMELOCATION_SET_TRUE = 1,
+};
+
+typedef struct {
+	int32_t Latitude;
+	int32_t Longitude;
+	float Altitude;
+	uint8_t Set;
+} HomeLocationData;
+
+UAVObjHandle HomeLocationHandle(void);
+int32_t HomeLocationGet(HomeLocationData *data);
+
+#endif /* HOMELOCATION_H */
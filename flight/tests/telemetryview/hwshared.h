@@ -0,0 +1,16 @@
+/* Stand-in for the generated hwshared.h, with the serial speeds. */
+#ifndef HWSHARED_H
+#define HWSHARED_H
+
+typedef enum {
+	HWSHARED_SPEEDBPS_1200 = 0,
+	HWSHARED_SPEEDBPS_2400 = 1,
+	HWSHARED_SPEEDBPS_4800 = 2,
+	HWSHARED_SPEEDBPS_9600 = 3,
+	HWSHARED_SPEEDBPS_19200 = 4,
+	HWSHARED_SPEEDBPS_38400 = 5,
+	HWSHARED_SPEEDBPS_57600 = 6,
+	HWSHARED_SPEEDBPS_115200 = 7,
+} HwSharedSpeedBpsOptions;
+
+#endif /* HWSHARED_H */
@@ -0,0 +1,17 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef MANUALCONTROLCOMMAND_H
+#define MANUALCONTROLCOMMAND_H
+
+#include "uavobjectmanager.h"
+
+#define MANUALCONTROLCOMMAND_CHANNEL_NUMELEM 12
+
+typedef struct {
+	int16_t Rssi;
+	uint16_t Channel[MANUALCONTROLCOMMAND_CHANNEL_NUMELEM];
+} ManualControlCommandData;
+
+UAVObjHandle ManualControlCommandHandle(void);
+int32_t ManualControlCommandGet(ManualControlCommandData *data);
+
+#endif /* MANUALCONTROLCOMMAND_H */
@@ -0,0 +1,9 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef MANUALCONTROLSETTINGS_H
+#define MANUALCONTROLSETTINGS_H
+
+enum {
+	MANUALCONTROLSETTINGS_CHANNELGROUPS_TBSCROSSFIRE = 9,
+};
+
+#endif /* MANUALCONTROLSETTINGS_H */
@@ -0,0 +1,15 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef MODULESETTINGS_H
+#define MODULESETTINGS_H
+
+#include "uavobjectmanager.h"
+#include "hwshared.h"
+
+enum {
+	MODULESETTINGS_LIGHTTELEMETRYSPEED_1200 = HWSHARED_SPEEDBPS_1200,
+};
+
+int32_t ModuleSettingsMavlinkSpeedGet(uint8_t *value);
+int32_t ModuleSettingsLightTelemetrySpeedGet(uint8_t *value);
+
+#endif /* MODULESETTINGS_H */
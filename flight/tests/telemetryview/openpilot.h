@@ -0,0 +1,5 @@
+/* Stand-in for openpilot.h; the bridges only need PiOS, objects and the task monitor. */
+#include <pios.h>
+#include "uavobjectmanager.h"
+#include "taskmonitor.h"
+#include "taskinfo.h"
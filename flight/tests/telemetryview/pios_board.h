@@ -0,0 +1,5 @@
+extern uintptr_t pios_com_mavlink_id;
+extern uintptr_t pios_com_lighttelemetry_id;
+
+#define PIOS_COM_MAVLINK (pios_com_mavlink_id)
+#define PIOS_COM_LIGHTTELEMETRY (pios_com_lighttelemetry_id)
@@ -0,0 +1,8 @@
+#define PIOS_NO_HW
+#define FLIGHT_POSIX
+
+#define PIOS_INCLUDE_LIGHTTELEMETRY
+#define PIOS_INCLUDE_CROSSFIRE
+#define PIOS_INCLUDE_INITCALL
+#define PIOS_INCLUDE_COM
+#define PIOS_INCLUDE_RCVR
@@ -0,0 +1,11 @@
+/* Stand-in for pios_hal.h, with what the bridges use of it. */
+#ifndef PIOS_HAL_H
+#define PIOS_HAL_H
+
+#include "hwshared.h"
+
+void PIOS_HAL_ConfigureSerialSpeed(uintptr_t com_id,
+		HwSharedSpeedBpsOptions speed);
+uintptr_t PIOS_HAL_GetReceiver(int receiver_type);
+
+#endif /* PIOS_HAL_H */
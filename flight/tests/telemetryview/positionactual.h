@@ -0,0 +1,17 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef POSITIONACTUAL_H
+#define POSITIONACTUAL_H
+
+#include "uavobjectmanager.h"
+
+typedef struct {
+	float North;
+	float East;
+	float Down;
+} PositionActualData;
+
+UAVObjHandle PositionActualHandle(void);
+int32_t PositionActualGet(PositionActualData *data);
+int32_t PositionActualDownGet(float *value);
+
+#endif /* POSITIONACTUAL_H */
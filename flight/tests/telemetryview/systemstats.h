@@ -0,0 +1,15 @@
+/* Stand-in for the generated UAVO header, with the fields the bridges use. */
+#ifndef SYSTEMSTATS_H
+#define SYSTEMSTATS_H
+
+#include "uavobjectmanager.h"
+
+typedef struct {
+	uint32_t FlightTime;
+	uint8_t CPULoad;
+} SystemStatsData;
+
+UAVObjHandle SystemStatsHandle(void);
+int32_t SystemStatsGet(SystemStatsData *data);
+
+#endif /* SYSTEMSTATS_H */
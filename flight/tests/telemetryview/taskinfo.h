@@ -0,0 +1,13 @@
+/* Stand-in for the generated taskinfo.h, with the bridges' tasks. */
+
+#ifndef TASKINFO_H
+#define TASKINFO_H
+
+typedef enum {
+	TASKINFO_RUNNING_SYSTEM = 0,
+	TASKINFO_RUNNING_UAVOMAVLINKBRIDGE,
+	TASKINFO_RUNNING_UAVOLIGHTTELEMETRYBRIDGE,
+	TASKINFO_RUNNING_UAVOCROSSFIRETELEMETRY,
+} TaskInfoRunningElem;
+
+#endif /* TASKINFO_H */
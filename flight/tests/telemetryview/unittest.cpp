@@ -0,0 +1,829 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* fopen */
+#include <stdlib.h>		/* strtof */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* roundf */
+#include <pthread.h>		/* pthread_* */
+
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "pios.h"
+#include "pios_crc.h"
+#include "pios_modules.h"
+#include "physical_constants.h"
+#include "telemetryview.h"
+#include "mavlink.h"
+#include "unittest_mocks.h"
+}
+
+/* Where a field of the recording goes */
+enum field_type {
+	FIELD_FLOAT,
+	FIELD_UINT8,
+	FIELD_INT16,
+	FIELD_INT32,
+	FIELD_UINT32,
+	FIELD_CHANNELS,
+};
+
+static const struct {
+	const char *object;
+	const char *field;
+	enum field_type type;
+	void *ptr;
+} recording_fields[] = {
+#define FIELD(obj, member, name, type) \
+	{ #obj, #name, type, &mock_objects.member.name }
+	FIELD(ActuatorDesired, actuator_desired, Thrust, FIELD_FLOAT),
+	FIELD(ActuatorDesired, actuator_desired, UpdateTime, FIELD_FLOAT),
+	FIELD(AttitudeActual, attitude_actual, Roll, FIELD_FLOAT),
+	FIELD(AttitudeActual, attitude_actual, Pitch, FIELD_FLOAT),
+	FIELD(AttitudeActual, attitude_actual, Yaw, FIELD_FLOAT),
+	FIELD(BaroAltitude, baro_altitude, Altitude, FIELD_FLOAT),
+	FIELD(FlightBatterySettings, flight_battery_settings, Capacity, FIELD_UINT32),
+	FIELD(FlightBatterySettings, flight_battery_settings, VoltagePin, FIELD_UINT8),
+	FIELD(FlightBatterySettings, flight_battery_settings, CurrentPin, FIELD_UINT8),
+	FIELD(FlightBatteryState, flight_battery_state, Voltage, FIELD_FLOAT),
+	FIELD(FlightBatteryState, flight_battery_state, Current, FIELD_FLOAT),
+	FIELD(FlightBatteryState, flight_battery_state, ConsumedEnergy, FIELD_FLOAT),
+	FIELD(FlightStatus, flight_status, Armed, FIELD_UINT8),
+	FIELD(FlightStatus, flight_status, FlightMode, FIELD_UINT8),
+	FIELD(FlightStatus, flight_status, ControlSource, FIELD_UINT8),
+	FIELD(GPSPosition, gps_position, Status, FIELD_UINT8),
+	FIELD(GPSPosition, gps_position, Satellites, FIELD_UINT8),
+	FIELD(GPSPosition, gps_position, Latitude, FIELD_INT32),
+	FIELD(GPSPosition, gps_position, Longitude, FIELD_INT32),
+	FIELD(GPSPosition, gps_position, Altitude, FIELD_FLOAT),
+	FIELD(GPSPosition, gps_position, Heading, FIELD_FLOAT),
+	FIELD(GPSPosition, gps_position, Groundspeed, FIELD_FLOAT),
+	FIELD(GPSPosition, gps_position, HDOP, FIELD_FLOAT),
+	FIELD(GPSPosition, gps_position, VDOP, FIELD_FLOAT),
+	FIELD(HomeLocation, home_location, Set, FIELD_UINT8),
+	FIELD(HomeLocation, home_location, Latitude, FIELD_INT32),
+	FIELD(HomeLocation, home_location, Longitude, FIELD_INT32),
+	FIELD(HomeLocation, home_location, Altitude, FIELD_FLOAT),
+	FIELD(ManualControlCommand, manual_control_command, Rssi, FIELD_INT16),
+	FIELD(ManualControlCommand, manual_control_command, Channel, FIELD_CHANNELS),
+	FIELD(PositionActual, position_actual, North, FIELD_FLOAT),
+	FIELD(PositionActual, position_actual, East, FIELD_FLOAT),
+	FIELD(PositionActual, position_actual, Down, FIELD_FLOAT),
+	FIELD(SystemStats, system_stats, FlightTime, FIELD_UINT32),
+	FIELD(SystemStats, system_stats, CPULoad, FIELD_UINT8),
+#undef FIELD
+};
+
+/* One line of the recording: an object update */
+struct sample {
+	uint32_t time_ms;
+	std::vector<std::pair<int, std::string> > fields;
+};
+
+static std::vector<struct sample> recording;
+static uint32_t recording_length_ms;
+
+static void load_recording(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	ASSERT_TRUE(f != NULL);
+
+	char line[512];
+
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#')
+			continue;
+
+		struct sample s;
+		char *save;
+		char *tok = strtok_r(line, " \n", &save);
+		if (!tok)
+			continue;
+
+		s.time_ms = strtoul(tok, NULL, 10);
+
+		const char *object = strtok_r(NULL, " \n", &save);
+		ASSERT_TRUE(object != NULL);
+
+		while ((tok = strtok_r(NULL, " \n", &save))) {
+			char *value = strchr(tok, '=');
+			ASSERT_TRUE(value != NULL);
+			*value++ = 0;
+
+			int i;
+			for (i = 0; i < (int)NELEMENTS(recording_fields); i++) {
+				if (!strcmp(recording_fields[i].object, object) &&
+						!strcmp(recording_fields[i].field, tok))
+					break;
+			}
+
+			ASSERT_LT(i, (int)NELEMENTS(recording_fields)) <<
+				object << "." << tok;
+
+			s.fields.push_back(std::make_pair(i, std::string(value)));
+		}
+
+		recording.push_back(s);
+		recording_length_ms = s.time_ms;
+	}
+
+	fclose(f);
+
+	ASSERT_FALSE(recording.empty());
+}
+
+static void apply_sample(const struct sample &s)
+{
+	for (size_t i = 0; i < s.fields.size(); i++) {
+		void *ptr = recording_fields[s.fields[i].first].ptr;
+		const char *value = s.fields[i].second.c_str();
+
+		switch (recording_fields[s.fields[i].first].type) {
+		case FIELD_FLOAT:
+			*(float *)ptr = strtof(value, NULL);
+			break;
+		case FIELD_UINT8:
+			*(uint8_t *)ptr = strtoul(value, NULL, 10);
+			break;
+		case FIELD_INT16:
+			*(int16_t *)ptr = strtol(value, NULL, 10);
+			break;
+		case FIELD_INT32:
+			*(int32_t *)ptr = strtol(value, NULL, 10);
+			break;
+		case FIELD_UINT32:
+			*(uint32_t *)ptr = strtoul(value, NULL, 10);
+			break;
+		case FIELD_CHANNELS:
+		{
+			uint16_t *channels = (uint16_t *)ptr;
+			char *end = (char *)value;
+
+			for (int c = 0; c < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM; c++) {
+				channels[c] = strtoul(end, &end, 10);
+				if (*end == ',')
+					end++;
+			}
+			break;
+		}
+		}
+	}
+}
+
+/* Replay position: the recording starts over at replay_base_ms */
+static uint32_t replay_base_ms;
+static size_t replay_next;
+
+static void replay_time_hook(uint32_t time_ms)
+{
+	while (replay_next < recording.size() &&
+			replay_base_ms + recording[replay_next].time_ms <= time_ms) {
+		apply_sample(recording[replay_next]);
+		replay_next++;
+	}
+}
+
+static const uint16_t section_periods[TELEMETRYVIEW_NUM_SECTIONS] = {
+	[TELEMETRYVIEW_ATTITUDE] = 50,
+	[TELEMETRYVIEW_STATUS] = 100,
+	[TELEMETRYVIEW_BATTERY] = 500,
+	[TELEMETRYVIEW_GPS] = 200,
+	[TELEMETRYVIEW_NAVIGATION] = 200,
+};
+
+/* The test's own reader of the view */
+static struct telemetryview current;
+
+static void read_view(void)
+{
+	for (int i = 0; i < TELEMETRYVIEW_NUM_SECTIONS; i++)
+		TelemetryViewRead(&current, (enum telemetryview_section) i);
+}
+
+/* When each version of each section was refreshed */
+static std::map<uint16_t, uint32_t> refreshed_at[TELEMETRYVIEW_NUM_SECTIONS];
+
+/* Every refresh has to match the objects as they were right then */
+static void check_refresh(uint16_t inst_id)
+{
+	const struct mock_objects *o = &mock_objects;
+
+	ASSERT_LT(inst_id, TELEMETRYVIEW_NUM_SECTIONS);
+
+	enum telemetryview_section section = (enum telemetryview_section) inst_id;
+	uint16_t version = current.version[section];
+
+	ASSERT_TRUE(TelemetryViewRead(&current, section));
+	EXPECT_NE(version, current.version[section]);
+	EXPECT_NE(0, current.version[section]);
+
+	refreshed_at[section][current.version[section]] = mock_time_ms;
+
+	switch (section) {
+	case TELEMETRYVIEW_ATTITUDE:
+		EXPECT_EQ(o->attitude_actual.Roll, current.attitude.roll);
+		EXPECT_EQ(o->attitude_actual.Pitch, current.attitude.pitch);
+		EXPECT_EQ(o->attitude_actual.Yaw, current.attitude.yaw);
+		break;
+	case TELEMETRYVIEW_STATUS:
+		EXPECT_EQ(o->flight_status.Armed, current.status.armed);
+		EXPECT_EQ(o->flight_status.FlightMode, current.status.flight_mode);
+		EXPECT_EQ(o->flight_status.ControlSource, current.status.control_source);
+		EXPECT_EQ(o->system_stats.FlightTime, current.status.flight_time);
+		EXPECT_EQ(o->system_stats.CPULoad, current.status.cpu_load);
+		EXPECT_EQ(o->manual_control_command.Rssi, current.status.rssi);
+		for (int i = 0; i < TELEMETRYVIEW_CHANNELS; i++)
+			EXPECT_EQ(o->manual_control_command.Channel[i],
+					current.status.channels[i]);
+		EXPECT_EQ(o->actuator_desired.Thrust, current.status.thrust);
+		EXPECT_EQ(o->actuator_desired.UpdateTime, current.status.cycle_time);
+		break;
+	case TELEMETRYVIEW_BATTERY:
+		EXPECT_TRUE(current.battery.present);
+		EXPECT_TRUE(current.battery.has_settings);
+		EXPECT_EQ(o->flight_battery_state.Voltage, current.battery.voltage);
+		EXPECT_EQ(o->flight_battery_state.Current, current.battery.current);
+		EXPECT_EQ(o->flight_battery_state.ConsumedEnergy,
+				current.battery.consumed_energy);
+		EXPECT_EQ(o->flight_battery_settings.Capacity, current.battery.capacity);
+		EXPECT_TRUE(current.battery.has_voltage);
+		EXPECT_TRUE(current.battery.has_current);
+		break;
+	case TELEMETRYVIEW_GPS:
+		EXPECT_TRUE(current.gps.present);
+		EXPECT_EQ(o->gps_position.Status, current.gps.status);
+		EXPECT_EQ(o->gps_position.Satellites, current.gps.satellites);
+		EXPECT_EQ(o->gps_position.Latitude, current.gps.latitude);
+		EXPECT_EQ(o->gps_position.Longitude, current.gps.longitude);
+		EXPECT_EQ(o->gps_position.Altitude, current.gps.altitude);
+		EXPECT_EQ(o->gps_position.Heading, current.gps.heading);
+		EXPECT_EQ(o->gps_position.Groundspeed, current.gps.groundspeed);
+		EXPECT_EQ(o->gps_position.HDOP, current.gps.hdop);
+		EXPECT_EQ(o->gps_position.VDOP, current.gps.vdop);
+		break;
+	case TELEMETRYVIEW_NAVIGATION:
+		EXPECT_TRUE(current.navigation.has_home);
+		EXPECT_EQ(o->home_location.Set == HOMELOCATION_SET_TRUE,
+				current.navigation.home_set);
+		EXPECT_EQ(o->home_location.Latitude, current.navigation.home_latitude);
+		EXPECT_EQ(o->home_location.Longitude, current.navigation.home_longitude);
+		EXPECT_EQ(o->home_location.Altitude, current.navigation.home_altitude);
+		EXPECT_TRUE(current.navigation.has_baro);
+		EXPECT_EQ(o->baro_altitude.Altitude, current.navigation.baro_altitude);
+		EXPECT_TRUE(current.navigation.has_position);
+		EXPECT_EQ(o->position_actual.Down, current.navigation.down);
+		EXPECT_FALSE(current.navigation.has_airspeed);
+		break;
+	default:
+		break;
+	}
+}
+
+/* What a bridge sent, with the view as the bridge saw it */
+struct sent {
+	uint32_t time_ms;
+	std::vector<uint8_t> bytes;
+	struct telemetryview view;
+};
+
+static std::map<uintptr_t, std::vector<struct sent> > sent;
+
+static void record_send(uintptr_t port, const uint8_t *buf, uint16_t len)
+{
+	struct sent s;
+
+	/* The bridges read the view and send in one go, without sleeping
+	 * between, so what the view holds now is what they sent from */
+	read_view();
+
+	s.time_ms = mock_time_ms;
+	s.bytes.assign(buf, buf + len);
+	s.view = current;
+
+	sent[port].push_back(s);
+}
+
+class TelemetryViewTest : public testing::Test {
+protected:
+	static void SetUpTestCase() {
+		static bool started;
+
+		if (started)
+			return;
+
+		load_recording("flight.txt");
+
+		mock_objects.has_baro = true;
+		mock_objects.has_battery = true;
+		mock_objects.has_gps = true;
+		mock_objects.has_position = true;
+		mock_objects.has_airspeed = false;
+
+		mock_enable_module(PIOS_MODULE_UAVOMAVLINKBRIDGE, true);
+		mock_enable_module(PIOS_MODULE_UAVOLIGHTTELEMETRYBRIDGE, true);
+		mock_enable_module(PIOS_MODULE_UAVOCROSSFIRETELEMETRY, true);
+
+		mock_start_modules();
+		started = true;
+	}
+
+	virtual void SetUp() {
+		sent.clear();
+		mock_tx_full = false;
+		mock_task_object_reads = 0;
+		read_view();
+		mock_event_hook = check_refresh;
+		mock_send_hook = record_send;
+	}
+
+	virtual void TearDown() {
+		mock_time_hook = NULL;
+		mock_event_hook = NULL;
+		mock_send_hook = NULL;
+	}
+
+	/* Plays the recording from the start while a bridge runs */
+	void replay(const char *task, uint32_t duration_ms) {
+		replay_base_ms = mock_time_ms;
+		replay_next = 0;
+		replay_time_hook(mock_time_ms);
+		mock_time_hook = replay_time_hook;
+
+		mock_run_task(task, replay_base_ms + duration_ms);
+
+		/* The bridge never reads an object itself */
+		EXPECT_EQ(0u, mock_task_object_reads);
+	}
+
+	/* The view a message was encoded from was current */
+	void expect_fresh(const struct sent &s, enum telemetryview_section section) {
+		uint16_t version = s.view.version[section];
+
+		ASSERT_TRUE(refreshed_at[section].count(version)) <<
+			"section " << section << " version " << version;
+
+		EXPECT_LE(s.time_ms - refreshed_at[section][version],
+				section_periods[section]);
+	}
+};
+
+TEST_F(TelemetryViewTest, SubscribeSchedulesRefreshes) {
+	for (int i = 0; i < TELEMETRYVIEW_NUM_SECTIONS; i++) {
+		EXPECT_EQ(section_periods[i], mock_event_period(i));
+
+		/* Every bridge subscribes; only one refresh gets scheduled */
+		EXPECT_EQ(0, TelemetryViewSubscribe((enum telemetryview_section) i));
+	}
+
+	/* Start filled everything in before the first period */
+	struct telemetryview copy;
+	memset(&copy, 0, sizeof(copy));
+
+	for (int i = 0; i < TELEMETRYVIEW_NUM_SECTIONS; i++) {
+		EXPECT_TRUE(TelemetryViewRead(&copy, (enum telemetryview_section) i));
+		EXPECT_NE(0, copy.version[i]);
+	}
+}
+
+TEST_F(TelemetryViewTest, ReadOnlyCopiesNewVersions) {
+	struct telemetryview copy;
+	memset(&copy, 0, sizeof(copy));
+
+	for (int i = 0; i < TELEMETRYVIEW_NUM_SECTIONS; i++)
+		EXPECT_TRUE(TelemetryViewRead(&copy, (enum telemetryview_section) i));
+
+	for (int i = 0; i < TELEMETRYVIEW_NUM_SECTIONS; i++)
+		EXPECT_FALSE(TelemetryViewRead(&copy, (enum telemetryview_section) i));
+
+	mock_objects.attitude_actual.Roll = 12.5f;
+	TelemetryViewRefresh(TELEMETRYVIEW_ATTITUDE);
+
+	/* A refresh touches its own section only */
+	uint16_t version = copy.version[TELEMETRYVIEW_ATTITUDE];
+	EXPECT_TRUE(TelemetryViewRead(&copy, TELEMETRYVIEW_ATTITUDE));
+	EXPECT_NE(version, copy.version[TELEMETRYVIEW_ATTITUDE]);
+	EXPECT_EQ(12.5f, copy.attitude.roll);
+
+	for (int i = 0; i < TELEMETRYVIEW_NUM_SECTIONS; i++)
+		EXPECT_FALSE(TelemetryViewRead(&copy, (enum telemetryview_section) i));
+
+	/* Nothing moved, but a refresh is still news */
+	TelemetryViewRefresh(TELEMETRYVIEW_ATTITUDE);
+	EXPECT_TRUE(TelemetryViewRead(&copy, TELEMETRYVIEW_ATTITUDE));
+}
+
+TEST_F(TelemetryViewTest, VersionSkipsZero) {
+	struct telemetryview copy;
+	memset(&copy, 0, sizeof(copy));
+
+	/* More refreshes than versions, so the count wraps */
+	for (int i = 0; i < 70000; i++) {
+		TelemetryViewRefresh(TELEMETRYVIEW_BATTERY);
+
+		ASSERT_TRUE(TelemetryViewRead(&copy, TELEMETRYVIEW_BATTERY));
+		ASSERT_NE(0, copy.version[TELEMETRYVIEW_BATTERY]);
+	}
+}
+
+static volatile bool writer_done;
+
+static void *status_writer(void *arg)
+{
+	int refreshes = *(int *)arg;
+
+	for (int i = 1; i <= refreshes; i++) {
+		mock_objects.system_stats.FlightTime = i;
+
+		for (int j = 0; j < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM; j++)
+			mock_objects.manual_control_command.Channel[j] = i;
+
+		TelemetryViewRefresh(TELEMETRYVIEW_STATUS);
+	}
+
+	writer_done = true;
+
+	return NULL;
+}
+
+/* Only catches anything with the threads on different cores */
+TEST_F(TelemetryViewTest, ReadersNeverSeeTornSections) {
+	int refreshes = 200000;
+	pthread_t writer;
+
+	struct telemetryview copy;
+	memset(&copy, 0, sizeof(copy));
+
+	/* Start from a refresh the writer's all come after */
+	mock_objects.system_stats.FlightTime = 0;
+	memset(mock_objects.manual_control_command.Channel, 0,
+			sizeof(mock_objects.manual_control_command.Channel));
+	TelemetryViewRefresh(TELEMETRYVIEW_STATUS);
+	ASSERT_TRUE(TelemetryViewRead(&copy, TELEMETRYVIEW_STATUS));
+
+	writer_done = false;
+	ASSERT_EQ(0, pthread_create(&writer, NULL, status_writer, &refreshes));
+
+	uint32_t last = 0;
+
+	while (!writer_done) {
+		if (!TelemetryViewRead(&copy, TELEMETRYVIEW_STATUS))
+			continue;
+
+		/* Everything comes from the same refresh */
+		for (int i = 0; i < TELEMETRYVIEW_CHANNELS; i++)
+			ASSERT_EQ((uint16_t)copy.status.flight_time,
+					copy.status.channels[i]);
+
+		/* ... and refreshes only go forwards */
+		ASSERT_GE(copy.status.flight_time, last);
+		last = copy.status.flight_time;
+	}
+
+	pthread_join(writer, NULL);
+
+	TelemetryViewRead(&copy, TELEMETRYVIEW_STATUS);
+	EXPECT_EQ((uint32_t)refreshes, copy.status.flight_time);
+}
+
+/* Checks each message of a type went out for a version of its section
+ * that the last one of that type hadn't, and returns how many there were */
+static int count_messages(const std::vector<struct sent> &msgs,
+		const std::vector<int> &types, int type,
+		enum telemetryview_section section)
+{
+	int count = 0;
+	uint16_t last = 0;
+
+	for (size_t i = 0; i < msgs.size(); i++) {
+		if (types[i] != type)
+			continue;
+
+		EXPECT_NE(last, msgs[i].view.version[section]) <<
+			"type " << type << " at " << msgs[i].time_ms;
+		last = msgs[i].view.version[section];
+		count++;
+	}
+
+	return count;
+}
+
+TEST_F(TelemetryViewTest, MavlinkStreamsFromTheView) {
+	replay("uavoMavlinkBridge", recording_length_ms);
+
+	const std::vector<struct sent> &msgs = sent[MOCK_MAVLINK_PORT];
+	std::vector<int> types;
+
+	ASSERT_FALSE(msgs.empty());
+
+	for (size_t i = 0; i < msgs.size(); i++) {
+		const struct sent &s = msgs[i];
+		const struct telemetryview &v = s.view;
+		mavlink_message_t msg;
+		mavlink_status_t status;
+		int parsed = 0;
+
+		/* One message per send */
+		for (size_t j = 0; j < s.bytes.size(); j++)
+			parsed += mavlink_parse_char(MAVLINK_COMM_0, s.bytes[j],
+					&msg, &status);
+
+		ASSERT_EQ(1, parsed);
+		types.push_back(msg.msgid);
+
+		switch (msg.msgid) {
+		case MAVLINK_MSG_ID_SYS_STATUS:
+			expect_fresh(s, TELEMETRYVIEW_BATTERY);
+			EXPECT_EQ(lroundf(v.battery.voltage * 1000),
+					mavlink_msg_sys_status_get_voltage_battery(&msg));
+			EXPECT_EQ(lroundf(v.battery.current * 100),
+					mavlink_msg_sys_status_get_current_battery(&msg));
+			EXPECT_EQ(v.status.cpu_load * 10,
+					mavlink_msg_sys_status_get_load(&msg));
+			break;
+		case MAVLINK_MSG_ID_RC_CHANNELS_RAW:
+			expect_fresh(s, TELEMETRYVIEW_STATUS);
+			EXPECT_EQ(v.status.channels[0],
+					mavlink_msg_rc_channels_raw_get_chan1_raw(&msg));
+			EXPECT_EQ(v.status.channels[3],
+					mavlink_msg_rc_channels_raw_get_chan4_raw(&msg));
+			EXPECT_EQ(v.status.channels[7],
+					mavlink_msg_rc_channels_raw_get_chan8_raw(&msg));
+			EXPECT_EQ((uint8_t)v.status.rssi,
+					mavlink_msg_rc_channels_raw_get_rssi(&msg));
+			break;
+		case MAVLINK_MSG_ID_GPS_RAW_INT:
+			expect_fresh(s, TELEMETRYVIEW_GPS);
+			EXPECT_EQ(v.gps.latitude, mavlink_msg_gps_raw_int_get_lat(&msg));
+			EXPECT_EQ(v.gps.longitude, mavlink_msg_gps_raw_int_get_lon(&msg));
+			EXPECT_EQ(v.gps.satellites,
+					mavlink_msg_gps_raw_int_get_satellites_visible(&msg));
+			EXPECT_EQ(v.gps.status >= GPSPOSITION_STATUS_FIX3D ? 3 : 1,
+					mavlink_msg_gps_raw_int_get_fix_type(&msg));
+			break;
+		case MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN:
+			EXPECT_EQ(v.navigation.home_latitude,
+					mavlink_msg_gps_global_origin_get_latitude(&msg));
+			EXPECT_EQ(v.navigation.home_longitude,
+					mavlink_msg_gps_global_origin_get_longitude(&msg));
+			break;
+		case MAVLINK_MSG_ID_ATTITUDE:
+			expect_fresh(s, TELEMETRYVIEW_ATTITUDE);
+			EXPECT_FLOAT_EQ(v.attitude.roll * DEG2RAD,
+					mavlink_msg_attitude_get_roll(&msg));
+			EXPECT_FLOAT_EQ(v.attitude.pitch * DEG2RAD,
+					mavlink_msg_attitude_get_pitch(&msg));
+			EXPECT_FLOAT_EQ(v.attitude.yaw * DEG2RAD,
+					mavlink_msg_attitude_get_yaw(&msg));
+			break;
+		case MAVLINK_MSG_ID_VFR_HUD:
+			expect_fresh(s, TELEMETRYVIEW_STATUS);
+			EXPECT_FLOAT_EQ(v.navigation.baro_altitude,
+					mavlink_msg_vfr_hud_get_alt(&msg));
+			EXPECT_FLOAT_EQ(v.gps.groundspeed,
+					mavlink_msg_vfr_hud_get_groundspeed(&msg));
+			break;
+		case MAVLINK_MSG_ID_HEARTBEAT:
+			EXPECT_EQ(v.status.armed == FLIGHTSTATUS_ARMED_ARMED,
+					!!(mavlink_msg_heartbeat_get_base_mode(&msg) &
+						MAV_MODE_FLAG_SAFETY_ARMED));
+			break;
+		default:
+			ADD_FAILURE() << "unexpected message " << (int)msg.msgid;
+			break;
+		}
+	}
+
+	/* Each stream fires every (10 / rate + 1) task ticks of 100ms, and
+	 * every section refreshes faster than its streams */
+	int duration = recording_length_ms;
+
+	EXPECT_NEAR(duration / 600, count_messages(msgs, types,
+				MAVLINK_MSG_ID_SYS_STATUS, TELEMETRYVIEW_BATTERY), 1);
+	EXPECT_NEAR(duration / 300, count_messages(msgs, types,
+				MAVLINK_MSG_ID_RC_CHANNELS_RAW, TELEMETRYVIEW_STATUS), 1);
+	EXPECT_NEAR(duration / 600, count_messages(msgs, types,
+				MAVLINK_MSG_ID_GPS_RAW_INT, TELEMETRYVIEW_GPS), 1);
+	EXPECT_NEAR(duration / 200, count_messages(msgs, types,
+				MAVLINK_MSG_ID_ATTITUDE, TELEMETRYVIEW_ATTITUDE), 1);
+	EXPECT_NEAR(duration / 600, count_messages(msgs, types,
+				MAVLINK_MSG_ID_VFR_HUD, TELEMETRYVIEW_STATUS), 1);
+	EXPECT_NEAR(duration / 600, count_messages(msgs, types,
+				MAVLINK_MSG_ID_HEARTBEAT, TELEMETRYVIEW_STATUS), 1);
+}
+
+static int32_t ltm_int(const std::vector<uint8_t> &b, int pos, int len)
+{
+	uint32_t v = 0;
+
+	for (int i = len - 1; i >= 0; i--)
+		v = (v << 8) | b[pos + i];
+
+	/* Sign extend the 16 bit fields */
+	if (len == 2)
+		return (int16_t)v;
+
+	return v;
+}
+
+TEST_F(TelemetryViewTest, LighttelemetryFramesFromTheView) {
+	replay("uavoLighttelemetryBridge", recording_length_ms);
+
+	const std::vector<struct sent> &frames = sent[MOCK_LTM_PORT];
+	std::vector<int> types;
+
+	ASSERT_FALSE(frames.empty());
+
+	for (size_t i = 0; i < frames.size(); i++) {
+		const struct sent &s = frames[i];
+		const std::vector<uint8_t> &b = s.bytes;
+		const struct telemetryview &v = s.view;
+
+		ASSERT_GE(b.size(), 4u);
+		ASSERT_EQ('$', b[0]);
+		ASSERT_EQ('T', b[1]);
+
+		uint8_t crc = 0;
+		for (size_t j = 3; j < b.size() - 1; j++)
+			crc ^= b[j];
+		EXPECT_EQ(crc, b[b.size() - 1]);
+
+		types.push_back(b[2]);
+
+		switch (b[2]) {
+		case 'A':
+			ASSERT_EQ(10u, b.size());
+			expect_fresh(s, TELEMETRYVIEW_ATTITUDE);
+			EXPECT_EQ(roundf(v.attitude.pitch), ltm_int(b, 3, 2));
+			EXPECT_EQ(roundf(v.attitude.roll), ltm_int(b, 5, 2));
+			EXPECT_EQ(roundf(v.attitude.yaw), ltm_int(b, 7, 2));
+			break;
+		case 'G':
+			ASSERT_EQ(18u, b.size());
+			expect_fresh(s, TELEMETRYVIEW_GPS);
+			EXPECT_EQ(v.gps.latitude, ltm_int(b, 3, 4));
+			EXPECT_EQ(v.gps.longitude, ltm_int(b, 7, 4));
+			EXPECT_EQ(roundf(v.gps.groundspeed), b[11]);
+			EXPECT_EQ(roundf(v.navigation.down * -100.0f), ltm_int(b, 12, 4));
+			EXPECT_EQ(v.gps.satellites, b[16] >> 2);
+			break;
+		case 'S':
+			ASSERT_EQ(11u, b.size());
+			expect_fresh(s, TELEMETRYVIEW_STATUS);
+			EXPECT_EQ(roundf(v.battery.voltage * 1000),
+					(uint16_t)ltm_int(b, 3, 2));
+			EXPECT_EQ((uint8_t)v.status.rssi, b[7]);
+			EXPECT_EQ(roundf(v.gps.groundspeed), b[8]);
+			EXPECT_EQ(v.status.armed == FLIGHTSTATUS_ARMED_ARMED, b[9] & 1);
+			break;
+		default:
+			ADD_FAILURE() << "unexpected frame " << b[2];
+			break;
+		}
+	}
+
+	/* Frame slots come around faster than the sections refresh, so the
+	 * frames go out once per refresh at most */
+	int duration = recording_length_ms;
+	int attitude = count_messages(frames, types, 'A', TELEMETRYVIEW_ATTITUDE);
+	int gps = count_messages(frames, types, 'G', TELEMETRYVIEW_GPS);
+	int status = count_messages(frames, types, 'S', TELEMETRYVIEW_STATUS);
+
+	EXPECT_LE(attitude, duration / 50 + 1);
+	EXPECT_GE(attitude, duration / 100);
+	EXPECT_LE(gps, duration / 200 + 1);
+	EXPECT_GE(gps, duration / 400);
+	EXPECT_LE(status, duration / 100 + 1);
+	EXPECT_GE(status, duration / 200);
+}
+
+TEST_F(TelemetryViewTest, LighttelemetryRetriesWhenFull) {
+	mock_tx_full = true;
+	replay("uavoLighttelemetryBridge", 1000);
+
+	EXPECT_TRUE(sent[MOCK_LTM_PORT].empty());
+
+	/* The frame that couldn't go out is still owed once there's room */
+	mock_tx_full = false;
+	replay("uavoLighttelemetryBridge", 1000);
+
+	ASSERT_FALSE(sent[MOCK_LTM_PORT].empty());
+}
+
+static int32_t crsf_int(const std::vector<uint8_t> &b, int pos, int len)
+{
+	uint32_t v = 0;
+
+	for (int i = 0; i < len; i++)
+		v = (v << 8) | b[pos + i];
+
+	if (len == 2)
+		return (int16_t)v;
+
+	return v;
+}
+
+static int16_t crsf_angle(float degrees)
+{
+	return (int16_t)(degrees * (float)M_PI / 180.0f * 10000.0f);
+}
+
+TEST_F(TelemetryViewTest, CrossfireFramesFromTheView) {
+	replay("uavoCrossfireTelemetry", recording_length_ms);
+
+	const std::vector<struct sent> &frames = sent[MOCK_CRSF_PORT];
+	std::vector<int> types;
+
+	ASSERT_FALSE(frames.empty());
+
+	for (size_t i = 0; i < frames.size(); i++) {
+		const struct sent &s = frames[i];
+		const std::vector<uint8_t> &b = s.bytes;
+		const struct telemetryview &v = s.view;
+
+		ASSERT_GE(b.size(), 4u);
+		ASSERT_EQ(b.size(), b[1] + 2u);
+		EXPECT_EQ(PIOS_CRC_updateCRC_TBS(0, &b[2], b[1] - CRSF_CRC_LEN),
+				b[b.size() - 1]);
+
+		types.push_back(b[2]);
+
+		switch (b[2]) {
+		case CRSF_FRAME_ATTITUDE:
+			expect_fresh(s, TELEMETRYVIEW_ATTITUDE);
+			EXPECT_EQ(crsf_angle(v.attitude.pitch), crsf_int(b, 3, 2));
+			EXPECT_EQ(crsf_angle(v.attitude.roll), crsf_int(b, 5, 2));
+			EXPECT_EQ(crsf_angle(v.attitude.yaw), crsf_int(b, 7, 2));
+			break;
+		case CRSF_FRAME_BATTERY:
+			expect_fresh(s, TELEMETRYVIEW_BATTERY);
+			EXPECT_EQ((uint16_t)(v.battery.voltage * 10.0f),
+					(uint16_t)crsf_int(b, 3, 2));
+			EXPECT_EQ((uint16_t)(v.battery.current * 10.0f),
+					(uint16_t)crsf_int(b, 5, 2));
+			EXPECT_EQ(v.battery.capacity, (uint32_t)crsf_int(b, 7, 3));
+			break;
+		case CRSF_FRAME_GPS:
+			expect_fresh(s, TELEMETRYVIEW_GPS);
+			EXPECT_LE(GPSPOSITION_STATUS_FIX2D, v.gps.status);
+			EXPECT_EQ(v.gps.latitude, crsf_int(b, 3, 4));
+			EXPECT_EQ(v.gps.longitude, crsf_int(b, 7, 4));
+			EXPECT_EQ(v.gps.satellites, b[17]);
+			break;
+		default:
+			ADD_FAILURE() << "unexpected frame " << (int)b[2];
+			break;
+		}
+	}
+
+	/* After a second's wait, each frame has a slot every 333ms; the
+	 * battery refreshes slower than that, and skips slots */
+	int slots = (recording_length_ms - 1000) / 333 + 1;
+	int battery = count_messages(frames, types, CRSF_FRAME_BATTERY,
+			TELEMETRYVIEW_BATTERY);
+
+	EXPECT_NEAR(slots, count_messages(frames, types, CRSF_FRAME_ATTITUDE,
+				TELEMETRYVIEW_ATTITUDE), 1);
+	EXPECT_LE(battery, (int)recording_length_ms / 500 + 1);
+	EXPECT_LT(battery, slots);
+	EXPECT_GE(battery, slots / 2);
+
+	/* No fix for the first second of the recording */
+	int gps = count_messages(frames, types, CRSF_FRAME_GPS, TELEMETRYVIEW_GPS);
+	EXPECT_LE(gps, slots);
+	EXPECT_GE(gps, slots - 4);
+}
@@ -0,0 +1,380 @@
+/*
+ * Stand-ins for the PiOS services and objects the bridges use: a clock that
+ * only moves when a task sleeps, the event dispatcher's periodic callbacks
+ * run off that clock, serial ports that hand what they're sent to the test,
+ * and objects the test fills in.
+ */
+
+#include <setjmp.h>
+
+#include "openpilot.h"
+#include "eventdispatcher.h"
+#include "pios_thread.h"
+#include "pios_modules.h"
+#include "pios_hal.h"
+#include "pios_crossfire.h"
+#include "modulesettings.h"
+
+#include "unittest_mocks.h"
+
+#define MAX_EVENTS 16
+#define MAX_TASKS 8
+
+MODULE_INITSYSTEM_DECLS;
+
+struct mock_objects mock_objects;
+
+uint32_t mock_time_ms;
+
+void (*mock_time_hook)(uint32_t time_ms);
+void (*mock_event_hook)(uint16_t inst_id);
+void (*mock_send_hook)(uintptr_t port, const uint8_t *buf, uint16_t len);
+
+bool mock_tx_full;
+
+uint32_t mock_task_object_reads;
+
+uintptr_t pios_com_mavlink_id = MOCK_MAVLINK_PORT;
+uintptr_t pios_com_lighttelemetry_id = MOCK_LTM_PORT;
+
+static bool modules_enabled[PIOS_MODULE_NUM];
+
+static struct {
+	UAVObjEvent ev;
+	UAVObjEventCallback cb;
+	uint16_t period_ms;
+	uint32_t due_ms;
+} events[MAX_EVENTS];
+static int num_events;
+
+static struct {
+	void (*fn)(void *);
+	const char *name;
+	void *arg;
+} tasks[MAX_TASKS];
+static int num_tasks;
+
+static jmp_buf task_exit;
+static uint32_t task_end_ms;
+static bool task_running;
+static bool in_event;
+
+void mock_enable_module(int module, bool enabled)
+{
+	PIOS_Assert(module < PIOS_MODULE_NUM);
+
+	modules_enabled[module] = enabled;
+}
+
+void mock_start_modules(void)
+{
+	for (initmodule_t *fn = __module_initcall_start;
+			fn < __module_initcall_end; fn++) {
+		if (fn->fn_minit)
+			(fn->fn_minit)();
+	}
+
+	for (initmodule_t *fn = __module_initcall_start;
+			fn < __module_initcall_end; fn++) {
+		if (fn->fn_tinit)
+			(fn->fn_tinit)();
+	}
+}
+
+void mock_advance_to(uint32_t time_ms)
+{
+	while (true) {
+		int next = -1;
+
+		for (int i = 0; i < num_events; i++) {
+			if ((int32_t)(events[i].due_ms - time_ms) > 0)
+				continue;
+
+			if (next < 0 ||
+					(int32_t)(events[i].due_ms - events[next].due_ms) < 0)
+				next = i;
+		}
+
+		if (next < 0)
+			break;
+
+		/* The system task outranks the bridges, so events due by the
+		 * time a bridge wakes have all run by then */
+		mock_time_ms = events[next].due_ms;
+		if (mock_time_hook)
+			mock_time_hook(mock_time_ms);
+
+		events[next].due_ms += events[next].period_ms;
+
+		in_event = true;
+		events[next].cb(&events[next].ev, NULL, NULL, 0);
+		in_event = false;
+
+		if (mock_event_hook)
+			mock_event_hook(events[next].ev.instId);
+	}
+
+	mock_time_ms = time_ms;
+	if (mock_time_hook)
+		mock_time_hook(mock_time_ms);
+}
+
+uint16_t mock_event_period(uint16_t inst_id)
+{
+	for (int i = 0; i < num_events; i++) {
+		if (events[i].ev.instId == inst_id)
+			return events[i].period_ms;
+	}
+
+	return 0;
+}
+
+void mock_run_task(const char *name, uint32_t end_ms)
+{
+	for (int i = 0; i < num_tasks; i++) {
+		if (strcmp(tasks[i].name, name))
+			continue;
+
+		task_end_ms = end_ms;
+		task_running = true;
+
+		if (!setjmp(task_exit))
+			tasks[i].fn(tasks[i].arg);
+
+		task_running = false;
+		return;
+	}
+
+	PIOS_Assert(0);
+}
+
+static void sleep_to(uint32_t time_ms)
+{
+	if ((int32_t)(time_ms - task_end_ms) >= 0) {
+		mock_advance_to(task_end_ms);
+		longjmp(task_exit, 1);
+	}
+
+	mock_advance_to(time_ms);
+}
+
+int32_t EventPeriodicCallbackCreate(UAVObjEvent *ev, UAVObjEventCallback cb,
+		uint16_t periodMs)
+{
+	for (int i = 0; i < num_events; i++) {
+		if (events[i].cb == cb && events[i].ev.obj == ev->obj &&
+				events[i].ev.instId == ev->instId &&
+				events[i].ev.event == ev->event)
+			return 0;
+	}
+
+	if (num_events >= MAX_EVENTS)
+		return -1;
+
+	events[num_events].ev = *ev;
+	events[num_events].cb = cb;
+	events[num_events].period_ms = periodMs;
+	events[num_events].due_ms = mock_time_ms + periodMs;
+	num_events++;
+
+	return 0;
+}
+
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep,
+		size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+	(void) stack_bytes; (void) prio;
+
+	PIOS_Assert(num_tasks < MAX_TASKS);
+
+	tasks[num_tasks].fn = fp;
+	tasks[num_tasks].name = namep;
+	tasks[num_tasks].arg = argp;
+	num_tasks++;
+
+	return (struct pios_thread *)&tasks[num_tasks - 1];
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	return mock_time_ms;
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+	sleep_to(mock_time_ms + time_ms);
+}
+
+void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms)
+{
+	*previous_ms += increment_ms;
+
+	if ((int32_t)(*previous_ms - mock_time_ms) > 0)
+		sleep_to(*previous_ms);
+}
+
+int32_t TaskMonitorAdd(TaskInfoRunningElem task, struct pios_thread *handlep)
+{
+	(void) task; (void) handlep;
+	return 0;
+}
+
+bool PIOS_Modules_IsEnabled(enum pios_modules module)
+{
+	return modules_enabled[module];
+}
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void *PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_DEBUG_Panic(const char *msg)
+{
+	(void) msg;
+	abort();
+}
+
+void PIOS_HAL_ConfigureSerialSpeed(uintptr_t com_id,
+		HwSharedSpeedBpsOptions speed)
+{
+	(void) com_id; (void) speed;
+}
+
+uintptr_t PIOS_HAL_GetReceiver(int receiver_type)
+{
+	(void) receiver_type;
+	return 1;
+}
+
+uintptr_t PIOS_RCVR_GetLowerDevice(uintptr_t rcvr_id)
+{
+	(void) rcvr_id;
+	return MOCK_CRSF_PORT;
+}
+
+int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer,
+		uint16_t len)
+{
+	if (mock_send_hook)
+		mock_send_hook(com_id, buffer, len);
+
+	return len;
+}
+
+int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer,
+		uint16_t len)
+{
+	if (mock_tx_full)
+		return -2;
+
+	return PIOS_COM_SendBuffer(com_id, buffer, len);
+}
+
+int PIOS_Crossfire_InitTelemetry(uintptr_t crsf_id)
+{
+	(void) crsf_id;
+	return 0;
+}
+
+int PIOS_Crossfire_SendTelemetry(uintptr_t crsf_id, uint8_t *buf, uint8_t bytes)
+{
+	if (mock_send_hook)
+		mock_send_hook(crsf_id, buf, bytes);
+
+	return 0;
+}
+
+bool PIOS_Crossfire_IsFailsafed(uintptr_t crsf_id)
+{
+	(void) crsf_id;
+	return false;
+}
+
+int32_t ModuleSettingsMavlinkSpeedGet(uint8_t *value)
+{
+	*value = HWSHARED_SPEEDBPS_57600;
+	return 0;
+}
+
+int32_t ModuleSettingsLightTelemetrySpeedGet(uint8_t *value)
+{
+	*value = HWSHARED_SPEEDBPS_9600;
+	return 0;
+}
+
+static void object_read(void)
+{
+	if (task_running && !in_event)
+		mock_task_object_reads++;
+}
+
+/* Objects that always exist */
+#define MOCK_OBJECT(name, member) \
+	UAVObjHandle name##Handle(void) \
+	{ \
+		return (UAVObjHandle)&mock_objects.member; \
+	} \
+	int32_t name##Get(name##Data *data) \
+	{ \
+		object_read(); \
+		*data = mock_objects.member; \
+		return 0; \
+	}
+
+/* Objects only some firmware registers */
+#define MOCK_OPTIONAL_OBJECT(name, member, present) \
+	UAVObjHandle name##Handle(void) \
+	{ \
+		return mock_objects.present ? \
+			(UAVObjHandle)&mock_objects.member : NULL; \
+	} \
+	int32_t name##Get(name##Data *data) \
+	{ \
+		PIOS_Assert(mock_objects.present); \
+		object_read(); \
+		*data = mock_objects.member; \
+		return 0; \
+	}
+
+MOCK_OBJECT(ActuatorDesired, actuator_desired)
+MOCK_OBJECT(AttitudeActual, attitude_actual)
+MOCK_OBJECT(FlightStatus, flight_status)
+MOCK_OBJECT(HomeLocation, home_location)
+MOCK_OBJECT(ManualControlCommand, manual_control_command)
+MOCK_OBJECT(SystemStats, system_stats)
+MOCK_OPTIONAL_OBJECT(AirspeedActual, airspeed_actual, has_airspeed)
+MOCK_OPTIONAL_OBJECT(BaroAltitude, baro_altitude, has_baro)
+MOCK_OPTIONAL_OBJECT(FlightBatterySettings, flight_battery_settings, has_battery)
+MOCK_OPTIONAL_OBJECT(FlightBatteryState, flight_battery_state, has_battery)
+MOCK_OPTIONAL_OBJECT(GPSPosition, gps_position, has_gps)
+MOCK_OPTIONAL_OBJECT(PositionActual, position_actual, has_position)
+
+int32_t AirspeedActualTrueAirspeedGet(float *value)
+{
+	PIOS_Assert(mock_objects.has_airspeed);
+	object_read();
+	*value = mock_objects.airspeed_actual.TrueAirspeed;
+	return 0;
+}
+
+int32_t BaroAltitudeAltitudeGet(float *value)
+{
+	PIOS_Assert(mock_objects.has_baro);
+	object_read();
+	*value = mock_objects.baro_altitude.Altitude;
+	return 0;
+}
+
+int32_t PositionActualDownGet(float *value)
+{
+	PIOS_Assert(mock_objects.has_position);
+	object_read();
+	*value = mock_objects.position_actual.Down;
+	return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * Shared between the PiOS and UAVO stand-ins and the test driver.
+ */
+
+#ifndef UNITTEST_MOCKS_H
+#define UNITTEST_MOCKS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "actuatordesired.h"
+#include "airspeedactual.h"
+#include "attitudeactual.h"
+#include "baroaltitude.h"
+#include "flightbatterysettings.h"
+#include "flightbatterystate.h"
+#include "flightstatus.h"
+#include "gpsposition.h"
+#include "homelocation.h"
+#include "manualcontrolcommand.h"
+#include "positionactual.h"
+#include "systemstats.h"
+
+/* What the object stand-ins hand out */
+struct mock_objects {
+	ActuatorDesiredData actuator_desired;
+	AirspeedActualData airspeed_actual;
+	AttitudeActualData attitude_actual;
+	BaroAltitudeData baro_altitude;
+	FlightBatterySettingsData flight_battery_settings;
+	FlightBatteryStateData flight_battery_state;
+	FlightStatusData flight_status;
+	GPSPositionData gps_position;
+	HomeLocationData home_location;
+	ManualControlCommandData manual_control_command;
+	PositionActualData position_actual;
+	SystemStatsData system_stats;
+
+	/* Objects the firmware may not have registered */
+	bool has_airspeed;
+	bool has_baro;
+	bool has_battery;
+	bool has_gps;
+	bool has_position;
+};
+
+extern struct mock_objects mock_objects;
+
+/* Milliseconds, as PIOS_Thread_Systime() returns them */
+extern uint32_t mock_time_ms;
+
+/* Serial ports the bridges are given; crossfire telemetry goes to its own */
+#define MOCK_MAVLINK_PORT 1
+#define MOCK_LTM_PORT 2
+#define MOCK_CRSF_PORT 3
+
+/* Called with the clock at each time something happens, before it does */
+extern void (*mock_time_hook)(uint32_t time_ms);
+
+/* Called after each periodic event */
+extern void (*mock_event_hook)(uint16_t inst_id);
+
+/* Called with everything a bridge sends */
+extern void (*mock_send_hook)(uintptr_t port, const uint8_t *buf, uint16_t len);
+
+/* Object reads a task made itself, rather than through an event */
+extern uint32_t mock_task_object_reads;
+
+/* Makes PIOS_COM_SendBufferNonBlocking fail, as a full buffer does */
+extern bool mock_tx_full;
+
+void mock_enable_module(int module, bool enabled);
+
+/* Runs module init and start functions, as the firmware does at boot */
+void mock_start_modules(void);
+
+/* Runs the task created with this name until the clock reaches end_ms */
+void mock_run_task(const char *name, uint32_t end_ms);
+
+/* Advances the clock, running the periodic events on the way */
+void mock_advance_to(uint32_t time_ms);
+
+/* Periods of the periodic events registered, by instance id */
+uint16_t mock_event_period(uint16_t inst_id);
+
+#endif /* UNITTEST_MOCKS_H */
@@ -0,0 +1,361 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include "pios_tlsf.h"
+}
+
+/* About the size of an F4's main heap */
+#define HEAP_BYTES (96 * 1024)
+
+/* Bigger than a single TLSF block may be */
+#define BIG_HEAP_BYTES (1024 * 1024)
+
+struct allocation {
+	uint8_t *ptr;
+	size_t size;
+	uint8_t fill;
+};
+
+static void fill(struct allocation *a)
+{
+	memset(a->ptr, a->fill, a->size);
+}
+
+static bool intact(const struct allocation *a)
+{
+	for (size_t i = 0; i < a->size; i++) {
+		if (a->ptr[i] != a->fill) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class TLSF : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+    memory.assign(HEAP_BYTES, 0);
+    tlsf = PIOS_TLSF_Create(memory.data(), memory.size());
+    ASSERT_TRUE(tlsf != NULL);
+  }
+
+  virtual void TearDown() {
+  }
+
+  std::vector<uint8_t> memory;
+  struct pios_tlsf *tlsf;
+};
+
+TEST_F(TLSF, TooSmall) {
+  uint8_t tiny[16];
+
+  EXPECT_TRUE(PIOS_TLSF_Create(tiny, sizeof(tiny)) == NULL);
+}
+
+TEST_F(TLSF, ExhaustAndRecover) {
+  struct pios_tlsf_stats initial;
+  PIOS_TLSF_GetStats(tlsf, &initial);
+
+  /* The control structure shouldn't cost more than a few hundred bytes */
+  EXPECT_GT(initial.total_bytes, HEAP_BYTES - 1024u);
+  EXPECT_EQ(initial.total_bytes, initial.free_bytes);
+  EXPECT_EQ(0u, initial.allocations);
+
+  std::vector<void *> ptrs;
+  void *ptr;
+
+  while ((ptr = PIOS_TLSF_Malloc(tlsf, 100)) != NULL) {
+    ASSERT_GE((uint8_t *) ptr, memory.data());
+    ASSERT_LE((uint8_t *) ptr + 100, memory.data() + memory.size());
+    ptrs.push_back(ptr);
+  }
+
+  struct pios_tlsf_stats stats;
+  PIOS_TLSF_GetStats(tlsf, &stats);
+
+  /* One word of overhead each; the last may not be found */
+  size_t each = (100 + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t) +
+    sizeof(size_t);
+  EXPECT_LE(initial.total_bytes / each - 1, ptrs.size());
+  EXPECT_GE(initial.total_bytes / each, ptrs.size());
+  EXPECT_EQ(ptrs.size(), stats.allocations);
+  EXPECT_LT(stats.free_bytes, 2 * each);
+  EXPECT_EQ(stats.free_bytes, stats.min_free_bytes);
+  EXPECT_EQ(1u, stats.failures);
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+
+  /* Free in an order that exercises merging both ways */
+  for (size_t i = 0; i < ptrs.size(); i += 2) {
+    PIOS_TLSF_Free(tlsf, ptrs[i]);
+  }
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+
+  for (size_t i = 1; i < ptrs.size(); i += 2) {
+    PIOS_TLSF_Free(tlsf, ptrs[i]);
+  }
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+
+  PIOS_TLSF_GetStats(tlsf, &stats);
+  EXPECT_EQ(initial.free_bytes, stats.free_bytes);
+  EXPECT_EQ(initial.largest_free, stats.largest_free);
+  EXPECT_EQ(0u, stats.allocations);
+
+  /* Most of it can be had in one piece again */
+  EXPECT_TRUE(PIOS_TLSF_Malloc(tlsf, stats.largest_free * 7 / 8) != NULL);
+}
+
+TEST_F(TLSF, Alignment) {
+  for (size_t size = 0; size < 100; size++) {
+    void *ptr = PIOS_TLSF_Malloc(tlsf, size);
+
+    ASSERT_TRUE(ptr != NULL);
+    EXPECT_EQ(0u, (uintptr_t) ptr % sizeof(void *)) << size;
+  }
+
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+
+  /* A misaligned pool still hands out aligned memory */
+  std::vector<uint8_t> other(4096 + 1);
+  struct pios_tlsf *misaligned = PIOS_TLSF_Create(other.data() + 1, 4096);
+  ASSERT_TRUE(misaligned != NULL);
+
+  void *ptr = PIOS_TLSF_Malloc(misaligned, 13);
+  ASSERT_TRUE(ptr != NULL);
+  EXPECT_EQ(0u, (uintptr_t) ptr % sizeof(void *));
+}
+
+TEST_F(TLSF, Coalescing) {
+  struct pios_tlsf_stats initial;
+  PIOS_TLSF_GetStats(tlsf, &initial);
+
+  void *a = PIOS_TLSF_Malloc(tlsf, 1000);
+  void *b = PIOS_TLSF_Malloc(tlsf, 1000);
+  void *c = PIOS_TLSF_Malloc(tlsf, 1000);
+  void *d = PIOS_TLSF_Malloc(tlsf, 1000);
+
+  PIOS_TLSF_Free(tlsf, a);
+  PIOS_TLSF_Free(tlsf, c);
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+
+  /* b joins a and c into a hole just over 3000 bytes, which serves
+   * requests up to the bottom of its size class */
+  PIOS_TLSF_Free(tlsf, b);
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+
+  void *big = PIOS_TLSF_Malloc(tlsf, 2800);
+  EXPECT_EQ(a, big);
+
+  PIOS_TLSF_Free(tlsf, big);
+  PIOS_TLSF_Free(tlsf, d);
+
+  struct pios_tlsf_stats stats;
+  PIOS_TLSF_GetStats(tlsf, &stats);
+  EXPECT_EQ(initial.largest_free, stats.largest_free);
+
+  /* Freeing NULL or twice does nothing */
+  PIOS_TLSF_Free(tlsf, NULL);
+  PIOS_TLSF_Free(tlsf, d);
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+}
+
+TEST_F(TLSF, TooBig) {
+  EXPECT_TRUE(PIOS_TLSF_Malloc(tlsf, HEAP_BYTES) == NULL);
+  EXPECT_TRUE(PIOS_TLSF_Malloc(tlsf, SIZE_MAX) == NULL);
+  EXPECT_TRUE(PIOS_TLSF_Malloc(tlsf, SIZE_MAX / 2) == NULL);
+
+  struct pios_tlsf_stats stats;
+  PIOS_TLSF_GetStats(tlsf, &stats);
+  EXPECT_EQ(3u, stats.failures);
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+}
+
+TEST_F(TLSF, AddPool) {
+  struct pios_tlsf_stats before;
+  PIOS_TLSF_GetStats(tlsf, &before);
+
+  /* Bigger than a block can be, so it goes in as several */
+  std::vector<uint8_t> big(BIG_HEAP_BYTES);
+  ASSERT_TRUE(PIOS_TLSF_AddPool(tlsf, big.data(), big.size()));
+
+  struct pios_tlsf_stats after;
+  PIOS_TLSF_GetStats(tlsf, &after);
+  EXPECT_GT(after.total_bytes, before.total_bytes + BIG_HEAP_BYTES - 1024);
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+
+  /* Fill it all up with blocks too big for the first pool */
+  std::vector<void *> ptrs;
+  void *ptr;
+
+  while ((ptr = PIOS_TLSF_Malloc(tlsf, 200 * 1024)) != NULL) {
+    ptrs.push_back(ptr);
+  }
+
+  EXPECT_EQ(BIG_HEAP_BYTES / (256 * 1024u), ptrs.size());
+
+  for (void *p : ptrs) {
+    PIOS_TLSF_Free(tlsf, p);
+  }
+
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+  EXPECT_FALSE(PIOS_TLSF_AddPool(tlsf, big.data(), 4));
+}
+
+TEST_F(TLSF, RandomStress) {
+  std::vector<struct allocation> live;
+  uint32_t failures = 0;
+
+  for (int i = 0; i < 200000; i++) {
+    /* Lean towards allocating until the heap is busy, then hover */
+    bool alloc = live.empty() || (rand() % 100) < (live.size() < 200 ? 70 : 45);
+
+    if (alloc) {
+      struct allocation a;
+
+      /* Mostly small, sometimes big */
+      a.size = (rand() % 8) ? rand() % 256 : rand() % 8192;
+      a.ptr = (uint8_t *) PIOS_TLSF_Malloc(tlsf, a.size);
+      a.fill = rand();
+
+      if (!a.ptr) {
+        failures++;
+        continue;
+      }
+
+      fill(&a);
+      live.push_back(a);
+    } else {
+      size_t victim = rand() % live.size();
+
+      ASSERT_TRUE(intact(&live[victim])) << i;
+      PIOS_TLSF_Free(tlsf, live[victim].ptr);
+
+      live[victim] = live.back();
+      live.pop_back();
+    }
+
+    if (i % 1000 == 0) {
+      ASSERT_TRUE(PIOS_TLSF_Check(tlsf)) << i;
+    }
+  }
+
+  struct pios_tlsf_stats stats;
+  PIOS_TLSF_GetStats(tlsf, &stats);
+  EXPECT_EQ(live.size(), stats.allocations);
+  EXPECT_EQ(failures, stats.failures);
+
+  for (struct allocation &a : live) {
+    ASSERT_TRUE(intact(&a));
+    PIOS_TLSF_Free(tlsf, a.ptr);
+  }
+
+  EXPECT_TRUE(PIOS_TLSF_Check(tlsf));
+
+  PIOS_TLSF_GetStats(tlsf, &stats);
+  EXPECT_EQ(stats.total_bytes, stats.free_bytes);
+  EXPECT_LT(stats.min_free_bytes, stats.total_bytes / 2);
+
+  printf("%u allocation failures, low water %u of %u bytes free\n",
+      failures, (unsigned) stats.min_free_bytes, (unsigned) stats.total_bytes);
+}
+
+/*
+ * Time malloc/free pairs against heaps holding a handful of free blocks and
+ * thousands of them: the cost shouldn't depend on the number.  The times
+ * are printed to compare by hand; they vary too much with the host's load
+ * to assert on.
+ */
+static double worst_pair_time(struct pios_tlsf *tlsf, int rounds)
+{
+  std::vector<double> times;
+
+  for (int i = 0; i < rounds; i++) {
+    size_t size = 1 + rand() % 2048;
+
+    double start = ut_seconds();
+    void *ptr = PIOS_TLSF_Malloc(tlsf, size);
+    PIOS_TLSF_Free(tlsf, ptr);
+    times.push_back(ut_seconds() - start);
+  }
+
+  /* The very worst is at the mercy of the host's scheduler */
+  std::sort(times.begin(), times.end());
+  return times[times.size() * 999 / 1000];
+}
+
+TEST_F(TLSF, WorstCaseTiming) {
+  const int rounds = 100000;
+
+  double empty = worst_pair_time(tlsf, rounds);
+
+  /* Riddle the heap with holes of every size class */
+  std::vector<void *> ptrs;
+  void *ptr;
+
+  while ((ptr = PIOS_TLSF_Malloc(tlsf, 8 + rand() % 120)) != NULL) {
+    ptrs.push_back(ptr);
+  }
+
+  for (size_t i = 0; i < ptrs.size(); i += 2) {
+    PIOS_TLSF_Free(tlsf, ptrs[i]);
+  }
+
+  ASSERT_TRUE(PIOS_TLSF_Check(tlsf));
+
+  struct pios_tlsf_stats stats;
+  PIOS_TLSF_GetStats(tlsf, &stats);
+
+  double fragmented = worst_pair_time(tlsf, rounds);
+
+  printf("%u free fragments: 99.9th percentile malloc+free %.0f ns, "
+      "against %.0f ns unfragmented\n", (unsigned) (ptrs.size() + 1) / 2,
+      fragmented * 1e9, empty * 1e9);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ * @file       fuzz_uavtalk_codec.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief libFuzzer target for the UAVTalk frame parser
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <assert.h>
+
+#include "uavtalk_codec.h"
+
+/*
+ * The first input byte picks the chunk size the rest is fed in, so split
+ * frames get exercised too.  Every frame found must lie inside the data
+ * and check out, and everything must eventually be consumed.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size < 1) {
+		return 0;
+	}
+
+	size_t chunk = data[0] + 1;
+	data++;
+	size--;
+
+	size_t start = 0;	/* Oldest byte not consumed */
+	size_t end = 0;		/* Bytes received so far */
+
+	while (end < size) {
+		end += (size - end < chunk) ? size - end : chunk;
+
+		struct uavtalk_frame frame;
+		size_t consumed;
+		uint32_t errors = 0;
+
+		while (uavtalk_codec_next(data + start, end - start, 0xFFFF,
+					&frame, &consumed, &errors) ==
+				UAVTALK_CODEC_FRAME) {
+			assert(consumed <= end - start);
+			assert(frame.body >= data + start);
+			assert(frame.body + frame.body_len + 1 <= data + end);
+			assert(uavtalk_crc8(0, frame.body - UAVTALK_CODEC_HEADER_LENGTH,
+						frame.size) == frame.body[frame.body_len]);
+
+			start += consumed;
+		}
+
+		assert(consumed <= end - start);
+		start += consumed;
+	}
+
+	return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,310 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+#include <vector>
+
+#include "uavtalk_codec.h"
+
+#define MAX_FRAME_SIZE 255
+
+/* Stream size for the throughput comparison */
+#define BENCH_BYTES (32 * 1024 * 1024)
+
+/* Reference CRC-8, straight from the polynomial */
+static uint8_t crc8_bitwise(uint8_t crc, const uint8_t *data, size_t len)
+{
+	while (len--) {
+		crc ^= *data++;
+
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+		}
+	}
+
+	return crc;
+}
+
+/* Table driven, a byte at a time, as the parsers used to do it */
+static uint8_t crc8_bytewise(uint8_t crc, const uint8_t *data, size_t len)
+{
+	while (len--) {
+		crc = uavtalk_crc8_tables[0][crc ^ *data++];
+	}
+
+	return crc;
+}
+
+static void append_frame(std::vector<uint8_t> &stream, uint32_t obj_id,
+		const uint16_t *inst_id, uint16_t len)
+{
+	uint8_t data[MAX_FRAME_SIZE];
+	uint8_t frame[MAX_FRAME_SIZE + 1];
+
+	for (int i = 0; i < len; i++) {
+		data[i] = rand();
+	}
+
+	size_t frame_len = uavtalk_codec_encode(frame, sizeof(frame),
+			UAVTALK_CODEC_TYPE_VER, obj_id, inst_id, data, len);
+	ASSERT_NE(0u, frame_len);
+
+	stream.insert(stream.end(), frame, frame + frame_len);
+}
+
+/* Count the frames in a stream, fed in chunks like a serial port would */
+static int count_frames(const std::vector<uint8_t> &stream, size_t chunk,
+		uint32_t *errors)
+{
+	std::vector<uint8_t> pending;
+	int frames = 0;
+
+	for (size_t off = 0; off < stream.size(); off += chunk) {
+		size_t n = std::min(chunk, stream.size() - off);
+		pending.insert(pending.end(), stream.begin() + off,
+				stream.begin() + off + n);
+
+		struct uavtalk_frame frame;
+		size_t consumed;
+		size_t pos = 0;
+
+		while (uavtalk_codec_next(pending.data() + pos, pending.size() - pos,
+					MAX_FRAME_SIZE, &frame, &consumed, errors) ==
+				UAVTALK_CODEC_FRAME) {
+			frames++;
+			pos += consumed;
+		}
+
+		pos += consumed;
+		pending.erase(pending.begin(), pending.begin() + pos);
+	}
+
+	return frames;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVTalkCodec : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(UAVTalkCodec, CrcMatchesBitwise) {
+  uint8_t data[300];
+
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = rand();
+  }
+
+  for (size_t len = 0; len <= sizeof(data); len++) {
+    ASSERT_EQ(crc8_bitwise(0, data, len), uavtalk_crc8(0, data, len)) << len;
+  }
+
+  /* Incremental updates of odd sizes give the same result */
+  uint8_t crc = uavtalk_crc8(0, data, 7);
+  crc = uavtalk_crc8(crc, data + 7, 13);
+  crc = uavtalk_crc8(crc, data + 20, 280);
+  EXPECT_EQ(crc8_bitwise(0, data, 300), crc);
+}
+
+TEST_F(UAVTalkCodec, RoundTrip) {
+  uint8_t data[] = { 1, 2, 3, 4, 5 };
+  uint8_t buf[64];
+  uint16_t inst = 0x1234;
+
+  size_t len = uavtalk_codec_encode(buf, sizeof(buf), UAVTALK_CODEC_TYPE_VER,
+      0xDEADBEEF, &inst, data, sizeof(data));
+  ASSERT_EQ(UAVTALK_CODEC_HEADER_LENGTH + 2 + sizeof(data) + 1, len);
+
+  struct uavtalk_frame frame;
+  size_t consumed;
+  uint32_t errors = 0;
+
+  ASSERT_EQ(UAVTALK_CODEC_FRAME, uavtalk_codec_next(buf, len, MAX_FRAME_SIZE,
+        &frame, &consumed, &errors));
+  EXPECT_EQ(len, consumed);
+  EXPECT_EQ(0u, errors);
+  EXPECT_EQ(UAVTALK_CODEC_TYPE_VER, frame.type);
+  EXPECT_EQ(0xDEADBEEFu, frame.obj_id);
+  EXPECT_EQ(2 + sizeof(data), frame.body_len);
+
+  /* Zero copy: the body points into the buffer */
+  EXPECT_EQ(buf + UAVTALK_CODEC_HEADER_LENGTH, frame.body);
+
+  uint16_t got_inst;
+  ASSERT_EQ(0, uavtalk_frame_instance(&frame, &got_inst));
+  EXPECT_EQ(inst, got_inst);
+  EXPECT_EQ(0, memcmp(frame.body + 2, data, sizeof(data)));
+
+  /* Doesn't fit */
+  EXPECT_EQ(0u, uavtalk_codec_encode(buf, len - 1, UAVTALK_CODEC_TYPE_VER,
+        0xDEADBEEF, &inst, data, sizeof(data)));
+}
+
+TEST_F(UAVTalkCodec, PartialFrame) {
+  std::vector<uint8_t> stream;
+  append_frame(stream, 0x1000, NULL, 40);
+
+  struct uavtalk_frame frame;
+  size_t consumed;
+
+  /* Every prefix asks for more without dropping the frame start */
+  for (size_t len = 0; len < stream.size(); len++) {
+    ASSERT_EQ(UAVTALK_CODEC_NEED_MORE, uavtalk_codec_next(stream.data(), len,
+          MAX_FRAME_SIZE, &frame, &consumed, NULL));
+    ASSERT_EQ(0u, consumed);
+  }
+
+  ASSERT_EQ(UAVTALK_CODEC_FRAME, uavtalk_codec_next(stream.data(),
+        stream.size(), MAX_FRAME_SIZE, &frame, &consumed, NULL));
+  EXPECT_EQ(0x1000u, frame.obj_id);
+}
+
+TEST_F(UAVTalkCodec, ResyncAfterGarbage) {
+  std::vector<uint8_t> stream;
+  uint32_t errors = 0;
+
+  /* Garbage full of sync bytes, a corrupted frame and an oversized one */
+  for (int i = 0; i < 100; i++) {
+    stream.push_back(i & 1 ? UAVTALK_CODEC_SYNC_VAL : rand());
+  }
+
+  append_frame(stream, 0x2000, NULL, 30);
+  stream[stream.size() - 5] ^= 0x55;
+
+  append_frame(stream, 0x3000, NULL, 10);
+  size_t big = stream.size();
+  append_frame(stream, 0x4000, NULL, 200);
+  stream[big + 3] = 1;
+
+  append_frame(stream, 0x5000, NULL, 20);
+
+  std::vector<uint8_t> pending(stream);
+  struct uavtalk_frame frame;
+  size_t consumed;
+  std::vector<uint32_t> ids;
+  size_t pos = 0;
+
+  while (uavtalk_codec_next(pending.data() + pos, pending.size() - pos,
+        MAX_FRAME_SIZE, &frame, &consumed, &errors) == UAVTALK_CODEC_FRAME) {
+    ids.push_back(frame.obj_id);
+    pos += consumed;
+  }
+
+  ASSERT_EQ(2u, ids.size());
+  EXPECT_EQ(0x3000u, ids[0]);
+  EXPECT_EQ(0x5000u, ids[1]);
+  EXPECT_NE(0u, errors);
+  EXPECT_EQ(pending.size(), pos + consumed);
+}
+
+TEST_F(UAVTalkCodec, ChunkedStream) {
+  std::vector<uint8_t> stream;
+  uint16_t inst = 3;
+
+  for (int i = 0; i < 1000; i++) {
+    append_frame(stream, i, (i % 3) ? NULL : &inst, rand() % 200);
+  }
+
+  for (size_t chunk = 1; chunk < 300; chunk += 37) {
+    uint32_t errors = 0;
+
+    EXPECT_EQ(1000, count_frames(stream, chunk, &errors)) << chunk;
+    EXPECT_EQ(0u, errors);
+  }
+}
+
+TEST_F(UAVTalkCodec, ThroughputVersusBytewise) {
+  std::vector<uint8_t> stream;
+
+  stream.reserve(BENCH_BYTES + MAX_FRAME_SIZE * 2);
+
+  for (int i = 0; stream.size() < BENCH_BYTES; i++) {
+    /* A little line noise now and then */
+    if (i % 100 == 0) {
+      stream.push_back(UAVTALK_CODEC_SYNC_VAL);
+      stream.push_back(rand());
+    }
+
+    append_frame(stream, rand(), NULL, rand() % 200);
+  }
+
+  double start = ut_seconds();
+  int frames = count_frames(stream, 4096, NULL);
+  double codec_time = ut_seconds() - start;
+
+  /* The old way: check for sync at every byte, and CRC a byte at a time */
+  start = ut_seconds();
+  int bytewise_frames = 0;
+
+  for (size_t pos = 0; pos + UAVTALK_CODEC_HEADER_LENGTH <= stream.size(); ) {
+    const uint8_t *hdr = stream.data() + pos;
+    uint16_t size = hdr[2] | (hdr[3] << 8);
+
+    if (hdr[0] != UAVTALK_CODEC_SYNC_VAL ||
+        (hdr[1] & UAVTALK_CODEC_VER_MASK) != UAVTALK_CODEC_TYPE_VER ||
+        size < UAVTALK_CODEC_HEADER_LENGTH || size > MAX_FRAME_SIZE ||
+        pos + size + 1 > stream.size() ||
+        crc8_bytewise(0, hdr, size) != hdr[size]) {
+      pos++;
+      continue;
+    }
+
+    bytewise_frames++;
+    pos += size + 1;
+  }
+
+  double bytewise_time = ut_seconds() - start;
+
+  EXPECT_EQ(bytewise_frames, frames);
+
+  printf("%d frames, %d MB: codec %.0f MB/s, bytewise %.0f MB/s\n",
+      frames, BENCH_BYTES / (1024 * 1024),
+      BENCH_BYTES / codec_time / (1024 * 1024),
+      BENCH_BYTES / bytewise_time / (1024 * 1024));
+}
+
+/**
+ * @}
+ * @}
+ */
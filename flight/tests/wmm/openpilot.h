@@ -0,0 +1,7 @@
+/* Stand-in for openpilot.h; the magnetic model only needs the C library. */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Count full model evaluations, to check how often the local field needs one */
+extern uint32_t wmm_full_evaluations;
+#define WMM_COUNT_EVALUATION() (wmm_full_evaluations++)
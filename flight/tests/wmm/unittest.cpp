@@ -0,0 +1,478 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include "ut_timing.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* sin, cos, sqrt */
+
+extern "C" {
+#include "physical_constants.h"
+#include "WorldMagModel.h"
+
+/* Incremented by the model on each full evaluation */
+uint32_t wmm_full_evaluations;
+}
+
+/* Field components come back in units of 100 nT */
+#define NT 0.01f
+
+/*
+ * The model as it was evaluated before the coefficient table, in double
+ * precision: Gauss-normalised Legendre functions into tables, converted to
+ * Schmidt quasi-normalised, then summed with the coefficients moved to the
+ * date.  Away from the poles only.
+ */
+static void reference_field(double lat, double lon, double alt,
+		int month, int day, int year, double B[3])
+{
+	static const double coeffs[91][6] = COEFFS_FROM_NASA;
+	static const int days[13] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	const int nmax = 12;
+
+	bool leap = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+	int day_of_year = day;
+	for (int i = 1; i < month; i++)
+		day_of_year += days[i] + (i == 2 && leap);
+	double date = year + (day_of_year - 1) / (365.0 + leap);
+	double dt = date - MAGNETIC_MODEL_EPOCH;
+
+	/* Geodetic to spherical */
+	double a = WGS84_A, epssq = WGS84_EPS2, re = WGS84_RADIUS_EARTH_KM;
+	double h = alt / 1000;
+	double sin_lat = sin(lat * M_PI / 180), cos_lat = cos(lat * M_PI / 180);
+	double rc = a / sqrt(1 - epssq * sin_lat * sin_lat);
+	double xp = (rc + h) * cos_lat;
+	double zp = (rc * (1 - epssq) + h) * sin_lat;
+	double r = sqrt(xp * xp + zp * zp);
+	double phig = asin(zp / r);
+
+	double x = sin(phig), z = cos(phig);
+	double P[91], dP[91], norm[91];
+
+	P[0] = 1;
+	dP[0] = 0;
+	norm[0] = 1;
+
+	for (int n = 1; n <= nmax; n++) {
+		for (int m = 0; m <= n; m++) {
+			int i = n * (n + 1) / 2 + m;
+
+			if (n == m) {
+				int i1 = (n - 1) * n / 2 + m - 1;
+				P[i] = z * P[i1];
+				dP[i] = z * dP[i1] + x * P[i1];
+			} else {
+				int i2 = (n - 1) * n / 2 + m;
+				double k = 0;
+
+				if (m <= n - 2) {
+					int i1 = (n - 2) * (n - 1) / 2 + m;
+					k = (double)((n - 1) * (n - 1) - m * m) /
+						((2 * n - 1) * (2 * n - 3));
+					P[i] = x * P[i2] - k * P[i1];
+					dP[i] = x * dP[i2] - z * P[i2] - k * dP[i1];
+				} else {
+					P[i] = x * P[i2];
+					dP[i] = x * dP[i2] - z * P[i2];
+				}
+			}
+
+			if (m == 0)
+				norm[i] = norm[(n - 1) * n / 2] * (2 * n - 1) / n;
+			else
+				norm[i] = norm[i - 1] *
+					sqrt((double)((n - m + 1) * (m == 1 ? 2 : 1)) / (n + m));
+		}
+	}
+
+	double Bx = 0, By = 0, Bz = 0;
+
+	for (int n = 1; n <= nmax; n++) {
+		double rr = pow(re / r, n + 2);
+
+		for (int m = 0; m <= n; m++) {
+			int i = n * (n + 1) / 2 + m;
+			double g = coeffs[i][2] + dt * coeffs[i][4];
+			double hh = coeffs[i][3] + dt * coeffs[i][5];
+			double cm = cos(m * lon * M_PI / 180), sm = sin(m * lon * M_PI / 180);
+			double p = P[i] * norm[i], dp = -dP[i] * norm[i];
+
+			Bz -= rr * (g * cm + hh * sm) * (n + 1) * p;
+			By += rr * (g * sm - hh * cm) * m * p;
+			Bx -= rr * (g * cm + hh * sm) * dp;
+		}
+	}
+
+	By /= z;
+
+	/* Spherical to geodetic */
+	double psi = phig - lat * M_PI / 180;
+
+	B[0] = (Bx * cos(psi) - Bz * sin(psi)) * 1e-2;
+	B[1] = By * 1e-2;
+	B[2] = (Bx * sin(psi) + Bz * cos(psi)) * 1e-2;
+}
+
+static float distance(const float a[3], const float b[3])
+{
+	return sqrtf((a[0] - b[0]) * (a[0] - b[0]) +
+			(a[1] - b[1]) * (a[1] - b[1]) +
+			(a[2] - b[2]) * (a[2] - b[2]));
+}
+
+/* Spreads points evenly through a ball, for sampling around a reference */
+static void ball_point(int i, int count, float radius, float NED[3])
+{
+	/* Golden angle spiral over the sphere, cube root spaced in radius */
+	float u = 1 - 2 * (i + 0.5f) / count;
+	float theta = i * 2.39996323f;
+	float s = sqrtf(1 - u * u);
+	float d = radius * cbrtf((i % 7 + 1) / 7.0f);
+
+	NED[0] = d * s * cosf(theta);
+	NED[1] = d * s * sinf(theta);
+	NED[2] = d * u;
+}
+
+static void offset_point(const WMMtype_LocalField *local, const float NED[3],
+		float *lat, float *lon, float *alt)
+{
+	*lat = local->Lat + NED[0] / local->Scale[0];
+	*lon = local->Lon + NED[1] / local->Scale[1];
+	*alt = local->AltEllipsoid - NED[2];
+
+	if (*lon > 180)
+		*lon -= 360;
+	else if (*lon < -180)
+		*lon += 360;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class WorldMagModel : public testing::Test {
+protected:
+	virtual void SetUp() {
+		WMM_Initialize();
+	}
+
+	virtual void TearDown() {
+	}
+};
+
+/* Test values published with WMM2015, at the start and middle of the model */
+TEST_F(WorldMagModel, PublishedValues) {
+	static const struct {
+		uint16_t month, day, year;
+		float alt, lat, lon;
+		float X, Y, Z;		/* nT */
+	} points[] = {
+		{ 1, 1, 2015,      0,  80,   0,  6627.1,  -445.9,  54432.3 },
+		{ 1, 1, 2015,      0,   0, 120, 39518.2,   392.9, -11252.4 },
+		{ 1, 1, 2015,      0, -80, -120,  5797.3, 15761.1, -52919.1 },
+		{ 1, 1, 2015, 100000,  80,   0,  6314.3,  -471.6,  52269.8 },
+		{ 1, 1, 2015, 100000,   0, 120, 37535.6,   364.4, -10773.4 },
+		{ 1, 1, 2015, 100000, -80, -120,  5613.1, 14791.5, -50378.6 },
+		{ 7, 2, 2017,      0,  80,   0,  6599.4,  -317.1,  54459.2 },
+		{ 7, 2, 2017,      0,   0, 120, 39571.4,   222.5, -11030.1 },
+		{ 7, 2, 2017,      0, -80, -120,  5873.8, 15781.4, -52687.9 },
+		{ 7, 2, 2017, 100000,  80,   0,  6290.5,  -348.5,  52292.7 },
+		{ 7, 2, 2017, 100000,   0, 120, 37585.5,   209.5, -10564.2 },
+		{ 7, 2, 2017, 100000, -80, -120,  5683.5, 14808.8, -50163.0 },
+	};
+
+	for (unsigned i = 0; i < sizeof(points) / sizeof(points[0]); i++) {
+		float B[3];
+
+		ASSERT_EQ(0, WMM_GetMagVector(points[i].lat, points[i].lon,
+				points[i].alt, points[i].month, points[i].day,
+				points[i].year, B));
+
+		/* The coefficients here land a few nT from these, so this
+		 * only catches a wrong table, date or units; the grid test
+		 * below is the close check of the arithmetic */
+		EXPECT_NEAR(points[i].X * NT, B[0], 10 * NT) << "point " << i;
+		EXPECT_NEAR(points[i].Y * NT, B[1], 10 * NT) << "point " << i;
+		EXPECT_NEAR(points[i].Z * NT, B[2], 10 * NT) << "point " << i;
+	}
+}
+
+/* The single precision evaluation against the reference over the globe, at
+ * several altitudes and dates, swapping dates so the table is rebuilt */
+TEST_F(WorldMagModel, MatchesReferenceOnGrid) {
+	static const uint16_t dates[][3] = {
+		{ 1, 1, 2015 }, { 7, 2, 2017 }, { 12, 31, 2019 }, { 2, 29, 2016 },
+	};
+	static const float alts[] = { -500, 0, 3000, 20000 };
+
+	float worst = 0;
+
+	for (float lat = -89; lat <= 89; lat += 4) {
+		for (float lon = -180; lon <= 180; lon += 12) {
+			for (unsigned a = 0; a < sizeof(alts) / sizeof(alts[0]); a++) {
+				for (unsigned d = 0; d < sizeof(dates) / sizeof(dates[0]); d++) {
+					float B[3];
+					double ref[3];
+
+					ASSERT_EQ(0, WMM_GetMagVector(lat, lon, alts[a],
+							dates[d][0], dates[d][1], dates[d][2], B));
+					reference_field(lat, lon, alts[a],
+							dates[d][0], dates[d][1], dates[d][2], ref);
+
+					for (int c = 0; c < 3; c++) {
+						float err = fabsf(B[c] - (float)ref[c]);
+
+						worst = fmaxf(worst, err);
+						ASSERT_LT(err, 1.0f * NT) << lat << " " << lon
+							<< " " << alts[a] << " component " << c;
+					}
+				}
+			}
+		}
+	}
+
+	printf("Largest difference from reference: %f nT\n", worst / NT);
+}
+
+TEST_F(WorldMagModel, RangeChecks) {
+	float B[3];
+
+	EXPECT_EQ(-1, WMM_GetMagVector(-91, 0, 0, 1, 1, 2017, B));
+	EXPECT_EQ(-2, WMM_GetMagVector(91, 0, 0, 1, 1, 2017, B));
+	EXPECT_EQ(-3, WMM_GetMagVector(0, -181, 0, 1, 1, 2017, B));
+	EXPECT_EQ(-4, WMM_GetMagVector(0, 181, 0, 1, 1, 2017, B));
+	EXPECT_EQ(-8, WMM_GetMagVector(0, 0, 0, 13, 1, 2017, B));
+	EXPECT_EQ(-8, WMM_GetMagVector(0, 0, 0, 2, 29, 2017, B));
+}
+
+/* Exactly at the poles By needs its special summation */
+TEST_F(WorldMagModel, Poles) {
+	for (float lat = -90; lat <= 90; lat += 180) {
+		float B[3], near[3];
+
+		ASSERT_EQ(0, WMM_GetMagVector(lat, 30, 0, 7, 2, 2017, B));
+		ASSERT_EQ(0, WMM_GetMagVector(lat - copysignf(0.01f, lat), 30, 0,
+				7, 2, 2017, near));
+
+		/* A kilometre away; the field moves tens of nT per km */
+		EXPECT_LT(distance(B, near), 100 * NT);
+	}
+}
+
+/* Everywhere within the radius, the linear field is within its bound of the
+ * full model, and the bound is small next to the field */
+TEST_F(WorldMagModel, LocalFieldWithinBound) {
+	static const float radii[] = { 2000, 20000, 100000 };
+	float worst_ratio = 0;
+
+	for (float lat = -80; lat <= 80; lat += 20) {
+		for (float lon = -180; lon < 180; lon += 40) {
+			for (unsigned r = 0; r < sizeof(radii) / sizeof(radii[0]); r++) {
+				WMMtype_LocalField local;
+				float alt = (lon + 180) * 20;
+
+				ASSERT_EQ(0, WMM_InitLocalField(&local, lat, lon, alt,
+						7, 2, 2017, radii[r]));
+				ASSERT_TRUE(local.Linearised);
+
+				float field = sqrtf(local.B[0] * local.B[0] +
+						local.B[1] * local.B[1] + local.B[2] * local.B[2]);
+				EXPECT_LT(local.ErrorBound, 0.005f * field);
+
+				for (int i = 0; i < 40; i++) {
+					float NED[3], qlat, qlon, qalt, B[3], full[3];
+
+					ball_point(i, 40, radii[r] * 0.999f, NED);
+					offset_point(&local, NED, &qlat, &qlon, &qalt);
+
+					ASSERT_EQ(0, WMM_GetLocalMagVector(&local, qlat, qlon,
+							qalt, B));
+					ASSERT_EQ(0, WMM_GetMagVector(qlat, qlon, qalt,
+							7, 2, 2017, full));
+
+					float err = distance(B, full);
+
+					worst_ratio = fmaxf(worst_ratio, err / local.ErrorBound);
+					ASSERT_LE(err, local.ErrorBound) << lat << " " << lon
+						<< " radius " << radii[r];
+				}
+			}
+		}
+	}
+
+	printf("Largest error as a fraction of the bound: %f\n", worst_ratio);
+}
+
+/* Leaving the radius moves the reference to where the vehicle is */
+TEST_F(WorldMagModel, LocalFieldRecentres) {
+	WMMtype_LocalField local;
+	float B[3], full[3];
+
+	ASSERT_EQ(0, WMM_InitLocalField(&local, 47.0f, 8.0f, 400, 7, 2, 2017, 10000));
+
+	/* 5 km north */
+	ASSERT_EQ(0, WMM_GetLocalMagVector(&local, 47.045f, 8.0f, 400, B));
+	EXPECT_EQ(47.0f, local.Lat);
+
+	/* 15 km north */
+	ASSERT_EQ(1, WMM_GetLocalMagVector(&local, 47.135f, 8.0f, 400, B));
+	ASSERT_EQ(0, WMM_GetMagVector(47.135f, 8.0f, 400, 7, 2, 2017, full));
+	EXPECT_EQ(47.135f, local.Lat);
+	EXPECT_EQ(0, memcmp(B, full, sizeof(B)));
+
+	/* The date goes with it */
+	EXPECT_EQ(7, local.Month);
+	EXPECT_EQ(2, local.Day);
+	EXPECT_EQ(2017, local.Year);
+	EXPECT_TRUE(local.Linearised);
+
+	/* And nearby is linear again */
+	ASSERT_EQ(0, WMM_GetLocalMagVector(&local, 47.14f, 8.01f, 450, B));
+	ASSERT_EQ(0, WMM_GetMagVector(47.14f, 8.01f, 450, 7, 2, 2017, full));
+	EXPECT_LE(distance(B, full), local.ErrorBound);
+}
+
+TEST_F(WorldMagModel, LocalFieldAcrossDateLine) {
+	WMMtype_LocalField local;
+	float B[3], full[3];
+
+	ASSERT_EQ(0, WMM_InitLocalField(&local, -40.0f, 179.95f, 0, 7, 2, 2017, 20000));
+
+	ASSERT_EQ(0, WMM_GetLocalMagVector(&local, -40.0f, -179.95f, 0, B));
+	ASSERT_EQ(0, WMM_GetMagVector(-40.0f, -179.95f, 0, 7, 2, 2017, full));
+	EXPECT_LE(distance(B, full), local.ErrorBound);
+}
+
+/* Too near a pole to step north and south, each point is evaluated in full */
+TEST_F(WorldMagModel, LocalFieldNearPole) {
+	WMMtype_LocalField local;
+	float B[3], full[3];
+
+	ASSERT_EQ(0, WMM_InitLocalField(&local, 89.9f, 0, 0, 7, 2, 2017, 20000));
+	EXPECT_FALSE(local.Linearised);
+
+	ASSERT_EQ(1, WMM_GetLocalMagVector(&local, 89.92f, 10, 0, B));
+	ASSERT_EQ(0, WMM_GetMagVector(89.92f, 10, 0, 7, 2, 2017, full));
+	EXPECT_EQ(0, memcmp(B, full, sizeof(B)));
+	EXPECT_EQ(89.9f, local.Lat);
+
+	/* Leaving the radius southward linearises again */
+	ASSERT_EQ(1, WMM_GetLocalMagVector(&local, 89.0f, 0, 0, B));
+	EXPECT_TRUE(local.Linearised);
+}
+
+/* The linear lookup never evaluates the model, and leaves moving the
+ * reference to the caller */
+TEST_F(WorldMagModel, LinearFieldOnly) {
+	WMMtype_LocalField local;
+	float B[3], expected[3];
+
+	ASSERT_EQ(0, WMM_InitLocalField(&local, 47.0f, 8.0f, 400, 7, 2, 2017, 10000));
+
+	uint32_t evaluations = wmm_full_evaluations;
+
+	/* 5 km north, the same as the local lookup */
+	ASSERT_EQ(0, WMM_GetLinearMagVector(&local, 47.045f, 8.0f, 400, B));
+	ASSERT_EQ(0, WMM_GetLocalMagVector(&local, 47.045f, 8.0f, 400, expected));
+	EXPECT_EQ(0, memcmp(B, expected, sizeof(B)));
+
+	/* 15 km north, extrapolated */
+	ASSERT_EQ(1, WMM_GetLinearMagVector(&local, 47.135f, 8.0f, 400, B));
+	EXPECT_EQ(47.0f, local.Lat);
+
+	for (int c = 0; c < 3; c++) {
+		EXPECT_FLOAT_EQ(local.B[c] + local.dB[c][0] * 0.135f * local.Scale[0], B[c]);
+	}
+
+	EXPECT_EQ(0u, wmm_full_evaluations - evaluations);
+
+	/* Near a pole, the reference's field throughout */
+	ASSERT_EQ(0, WMM_InitLocalField(&local, 89.9f, 0, 0, 7, 2, 2017, 20000));
+	evaluations = wmm_full_evaluations;
+	ASSERT_EQ(0, WMM_GetLinearMagVector(&local, 89.92f, 10, 0, B));
+	EXPECT_EQ(0, memcmp(B, local.B, sizeof(B)));
+	EXPECT_EQ(0u, wmm_full_evaluations - evaluations);
+}
+
+/* A failed move keeps the old reference */
+TEST_F(WorldMagModel, LocalFieldErrors) {
+	WMMtype_LocalField local;
+	float B[3];
+
+	ASSERT_EQ(0, WMM_InitLocalField(&local, 10.0f, 10.0f, 0, 7, 2, 2017, 20000));
+	EXPECT_EQ(-2, WMM_GetLocalMagVector(&local, 95.0f, 10.0f, 0, B));
+	EXPECT_EQ(10.0f, local.Lat);
+
+	EXPECT_EQ(-8, WMM_InitLocalField(&local, 20.0f, 10.0f, 0, 2, 30, 2017, 20000));
+	EXPECT_EQ(10.0f, local.Lat);
+}
+
+TEST_F(WorldMagModel, Speed) {
+	WMMtype_LocalField local;
+	float B[3], sum = 0;
+	const int count = 20000;
+
+	/* Linearising takes the point and nine offsets from it */
+	uint32_t evaluations = wmm_full_evaluations;
+	ASSERT_EQ(0, WMM_InitLocalField(&local, 47.0f, 8.0f, 400, 7, 2, 2017, 20000));
+	EXPECT_EQ(10u, wmm_full_evaluations - evaluations);
+
+	evaluations = wmm_full_evaluations;
+	double start = ut_seconds();
+	for (int i = 0; i < count; i++) {
+		WMM_GetMagVector(47.0f + i * 1e-6f, 8.0f, 400, 7, 2, 2017, B);
+		sum += B[0];
+	}
+	double full = ut_seconds() - start;
+	EXPECT_EQ((uint32_t) count, wmm_full_evaluations - evaluations);
+
+	/* 2 km of travel, all within the radius: no full evaluations at all */
+	evaluations = wmm_full_evaluations;
+	start = ut_seconds();
+	for (int i = 0; i < count; i++) {
+		WMM_GetLocalMagVector(&local, 47.0f + i * 1e-6f, 8.0f, 400, B);
+		sum += B[0];
+	}
+	double linear = ut_seconds() - start;
+	EXPECT_EQ(0u, wmm_full_evaluations - evaluations);
+	EXPECT_TRUE(local.Linearised);
+
+	/* The timings depend on the host's load, so are only printed */
+	printf("Full model %.2f us, linearised %.3f us per call (%g)\n",
+			full / count * 1e6, linear / count * 1e6, sum);
+}
+
+/**
+ * @}
+ * @}
+ */
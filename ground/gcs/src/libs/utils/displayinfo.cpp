@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @file       displayinfo.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup libs GCS Libraries
+ * @{
+ * @addtogroup utils Utilities
+ * @{
+ * @brief Properties of the display the GCS is shown on
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "displayinfo.h"
+
+#include <QGuiApplication>
+#include <QScreen>
+
+//! Refresh rate assumed when the screen doesn't report one
+#define DEFAULT_REFRESH_RATE_HZ 60
+
+namespace Utils {
+
+int DisplayInfo::framePeriod()
+{
+    qreal refreshRate = DEFAULT_REFRESH_RATE_HZ;
+    if (QScreen *screen = QGuiApplication::primaryScreen()) {
+        if (screen->refreshRate() > 0)
+            refreshRate = screen->refreshRate();
+    }
+
+    return qMax(1, qRound(1000 / refreshRate));
+}
+}
+
+/**
+ * @}
+ * @}
+ */
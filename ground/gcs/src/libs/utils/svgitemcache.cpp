@@ -0,0 +1,74 @@
+/**
+ ******************************************************************************
+ * @file       svgitemcache.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup libs GCS Libraries
+ * @{
+ * @addtogroup utils Utilities
+ * @{
+ * @brief Rasterize SVG graphics items once per size instead of on every repaint
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "svgitemcache.h"
+
+#include <QGraphicsView>
+#include <QtMath>
+#include <QtSvg/QGraphicsSvgItem>
+
+namespace Utils {
+
+void SvgItemCache::cacheItems(QGraphicsView *view)
+{
+    if (!view->scene())
+        return;
+
+    foreach (QGraphicsItem *item, view->scene()->items()) {
+        if (qgraphicsitem_cast<QGraphicsSvgItem *>(item))
+            cacheItem(view, item);
+    }
+}
+
+void SvgItemCache::cacheItem(QGraphicsView *view, QGraphicsItem *item)
+{
+    // Scale of the item on screen, ignoring rotation so that spinning a
+    // needle doesn't change the cache size and force a re-render
+    QTransform t = item->deviceTransform(view->viewportTransform());
+    qreal scaleX = qSqrt(t.m11() * t.m11() + t.m12() * t.m12());
+    qreal scaleY = qSqrt(t.m21() * t.m21() + t.m22() * t.m22());
+    qreal ratio = view->devicePixelRatioF();
+
+    QRectF bounds = item->boundingRect();
+    QSize size(qCeil(bounds.width() * scaleX * ratio), qCeil(bounds.height() * scaleY * ratio));
+
+    if (size.isEmpty()) {
+        item->setCacheMode(QGraphicsItem::NoCache);
+        return;
+    }
+
+    // Setting the same mode and size again keeps the existing pixmap
+    item->setCacheMode(QGraphicsItem::ItemCoordinateCache, size);
+}
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,66 @@
+/**
+ ******************************************************************************
+ * @file       svgitemcache.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup libs GCS Libraries
+ * @{
+ * @addtogroup utils Utilities
+ * @{
+ * @brief Rasterize SVG graphics items once per size instead of on every repaint
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef SVGITEMCACHE_H
+#define SVGITEMCACHE_H
+
+#include "utils_global.h"
+
+class QGraphicsItem;
+class QGraphicsView;
+
+namespace Utils {
+
+class QTCREATOR_UTILS_EXPORT SvgItemCache
+{
+public:
+    /**
+     * @brief cacheItems Give every SVG item in the view's scene a pixmap cache
+     * sized for the view's current scale and device pixel ratio. The SVG is then
+     * rendered once and moving, rotating or hiding an item only blits the pixmap.
+     * Call again whenever the view is rescaled or items are added.
+     * @param view View the scene is displayed in
+     */
+    static void cacheItems(QGraphicsView *view);
+
+    /**
+     * @brief cacheItem Size the pixmap cache of a single item for the view
+     * @param view View the item is displayed in
+     * @param item Item to cache
+     */
+    static void cacheItem(QGraphicsView *view, QGraphicsItem *item);
+};
+}
+
+#endif // SVGITEMCACHE_H
+
+/**
+ * @}
+ * @}
+ */
@@ -32,7 +32,9 @@ SOURCES += \
     mytabwidget.cpp \
     svgimageprovider.cpp \
     scaledpixmaplabel.cpp \
-    longlongspinbox.cpp
+    longlongspinbox.cpp \
+    svgitemcache.cpp \
+    displayinfo.cpp
 
 SOURCES += xmlconfig.cpp
 
@@ -59,7 +61,9 @@ HEADERS += utils_global.h \
     mytabwidget.h \
     svgimageprovider.h \
     scaledpixmaplabel.h \
-    longlongspinbox.h
+    longlongspinbox.h \
+    svgitemcache.h \
+    displayinfo.h
 
 
 HEADERS += xmlconfig.h
@@ -29,6 +29,8 @@
 #include <math.h>
 
 #include "dialgadgetwidget.h"
+#include <utils/displayinfo.h>
+#include <utils/svgitemcache.h>
 #include <iostream>
 #include <QDebug>
 
@@ -41,7 +43,9 @@ DialGadgetWidget::DialGadgetWidget(QWidget *parent)
     setMinimumSize(64, 64);
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
     setScene(new QGraphicsScene(this));
-    setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+    // The SVG layers are cached as pixmaps which the needles then rotate
+    setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing
+                   | QPainter::SmoothPixmapTransform);
 
     m_renderer = new QSvgRenderer();
 
@@ -60,7 +64,9 @@ DialGadgetWidget::DialGadgetWidget(QWidget *parent)
     //	beSmooth = true;
     beSmooth = false;
 
-    // This timer mechanism makes needles rotate smoothly
+    // This timer mechanism makes needles rotate smoothly, and moves them at
+    // most once per displayed frame however fast the telemetry arrives
+    dialTimer.setInterval(Utils::DisplayInfo::framePeriod());
     connect(&dialTimer, &QTimer::timeout, this, &DialGadgetWidget::rotateNeedles);
 }
 
@@ -406,6 +412,8 @@ void DialGadgetWidget::setDialFile(QString dfn, QString bg, QString fg, QString
         needle1Value = 0;
         needle2Value = 0;
         needle3Value = 0;
+        fitInView(m_background, Qt::KeepAspectRatio);
+        Utils::SvgItemCache::cacheItems(this);
         if (!dialTimer.isActive())
             dialTimer.start();
         dialError = false;
@@ -448,6 +456,7 @@ void DialGadgetWidget::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event);
     fitInView(m_background, Qt::KeepAspectRatio);
+    Utils::SvgItemCache::cacheItems(this);
 }
 
 void DialGadgetWidget::setDialFont(QString fontProps)
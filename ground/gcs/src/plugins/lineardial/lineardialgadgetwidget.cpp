@@ -28,6 +28,8 @@
 #include <math.h>
 
 #include "lineardialgadgetwidget.h"
+#include <utils/displayinfo.h>
+#include <utils/svgitemcache.h>
 #include <QFileDialog>
 #include <QDebug>
 
@@ -51,9 +53,10 @@ LineardialGadgetWidget::LineardialGadgetWidget(QWidget *parent)
     places = 0;
     factor = 1;
 
-    // This timer mechanism makes the index rotate smoothly
+    // This timer mechanism makes the index rotate smoothly, and moves it at
+    // most once per displayed frame however fast the telemetry arrives
     connect(&dialTimer, SIGNAL(timeout()), this, SLOT(moveIndex()));
-    dialTimer.start(30);
+    dialTimer.start(Utils::DisplayInfo::framePeriod());
 }
 
 LineardialGadgetWidget::~LineardialGadgetWidget()
@@ -125,15 +128,18 @@ void LineardialGadgetWidget::updateIndex(UAVObject *object1)
             if (fieldSymbol) {
                 // If we defined a symbol, we will look for a matching
                 // SVG element to display:
-                if (m_renderer->elementExists("symbol-" + s)) {
-                    fieldSymbol->setElementId("symbol-" + s);
-                } else {
-                    fieldSymbol->setElementId("symbol");
+                QString symbol = "symbol";
+                if (m_renderer->elementExists("symbol-" + s))
+                    symbol += "-" + s;
+                // Switching element throws away the cached rendering
+                if (fieldSymbol->elementId() != symbol) {
+                    fieldSymbol->setElementId(symbol);
+                    Utils::SvgItemCache::cacheItem(this, fieldSymbol);
                 }
             }
         }
 
-        if (fieldValue)
+        if (fieldValue && fieldValue->toPlainText() != s)
             fieldValue->setPlainText(s);
 
         if (index && !dialTimer.isActive())
@@ -330,6 +336,8 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
         }
 
         l_scene->setSceneRect(background->boundingRect());
+        fitInView(background, Qt::KeepAspectRatio);
+        Utils::SvgItemCache::cacheItems(this);
 
         // Reset the current index value:
         indexValue = 0;
@@ -389,6 +397,7 @@ void LineardialGadgetWidget::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event);
     fitInView(background, Qt::KeepAspectRatio);
+    Utils::SvgItemCache::cacheItems(this);
 }
 
 // Converts the value into an percentage:
@@ -426,6 +435,4 @@ void LineardialGadgetWidget::moveIndex()
         matrix.translate(trans + startX, startY);
     }
     index->setTransform(matrix, false);
-
-    update();
 }
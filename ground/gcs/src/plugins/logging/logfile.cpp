@@ -30,17 +30,35 @@
 #include <QTextStream>
 #include <QMainWindow>
 #include <QMessageBox>
+#include <QScopedPointer>
 
 #include <coreplugin/icore.h>
 #include <coreplugin/coreconstants.h>
+#include <extensionsystem/pluginmanager.h>
+#include "uavobjects/uavobjecthistory.h"
+
+#include <algorithm>
+
+//! Packets per timer tick when replaying as fast as possible
+#define FAST_REPLAY_BATCH 500
 
 LogFile::LogFile(QObject *parent)
     : QIODevice(parent)
+    , decoder(nullptr)
+    , indexer(nullptr)
+    , pendingSeek(0)
+    , hasPendingSeek(false)
     , timestampBufferIdx(0)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
 
+LogFile::~LogFile()
+{
+    stopIndexer();
+    delete decoder;
+}
+
 /**
  * Opens the logfile QIODevice and the underlying logfile. In case
  * we want to save the logfile, we open in WriteOnly. In case we
@@ -163,6 +181,7 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+    stopIndexer();
     file.close();
     QIODevice::close();
 }
@@ -200,56 +219,80 @@ qint64 LogFile::bytesAvailable() const
 
 void LogFile::timerFired()
 {
-    qint64 dataSize;
+    if (file.bytesAvailable() <= 4) {
+        stopReplay();
+        return;
+    }
 
-    if (file.bytesAvailable() > 4) {
+    int time = myTime.elapsed();
 
-        int time;
-        time = myTime.elapsed();
-
-        // Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset) * playbackSpeed)
-                > (lastTimeStamp - firstTimestamp))) {
-            lastPlayTime += ((time - lastPlayTimeOffset) * playbackSpeed);
-            if (file.bytesAvailable() < 4) {
-                stopReplay();
+    if (playbackSpeed <= 0) {
+        // As fast as possible, in batches so the GUI stays responsive
+        for (int i = 0; i < FAST_REPLAY_BATCH; i++) {
+            if (!replayNextPacket())
                 return;
-            }
+        }
 
-            file.seek(lastTimeStampPos + sizeof(lastTimeStamp));
+        lastPlayTime = lastTimeStamp - firstTimestamp;
+        lastPlayTimeOffset = time;
+        return;
+    }
 
-            file.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
+    // Read packets
+    while ((lastPlayTime + ((time - lastPlayTimeOffset) * playbackSpeed)
+            > (lastTimeStamp - firstTimestamp))) {
+        lastPlayTime += ((time - lastPlayTimeOffset) * playbackSpeed);
 
-            if (dataSize < 1 || dataSize > (1024 * 1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if (file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
+        if (!replayNextPacket())
+            return;
 
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
+        lastPlayTimeOffset = time;
+        time = myTime.elapsed();
+    }
+}
 
-            if (file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+/**
+ * @brief LogFile::replayNextPacket Pass the next packet on to the reader
+ * @return false if the replay has stopped
+ */
+bool LogFile::replayNextPacket()
+{
+    qint64 dataSize;
 
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
+    if (file.bytesAvailable() < 4) {
+        stopReplay();
+        return false;
+    }
 
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
-        }
-    } else {
+    file.seek(lastTimeStampPos + sizeof(lastTimeStamp));
+
+    file.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
+
+    if (dataSize < 1 || dataSize > (1024 * 1024)) {
+        qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
         stopReplay();
+        return false;
+    }
+    if (file.bytesAvailable() < dataSize) {
+        stopReplay();
+        return false;
     }
+
+    mutex.lock();
+    dataBuffer.append(file.read(dataSize));
+    mutex.unlock();
+    emit readyRead();
+
+    if (file.bytesAvailable() < 4 || timestampBufferIdx >= (quint32)timestampPos.size()) {
+        stopReplay();
+        return false;
+    }
+
+    lastTimeStampPos = timestampPos[timestampBufferIdx];
+    lastTimeStamp = timestampBuffer[timestampBufferIdx];
+    timestampBufferIdx++;
+
+    return true;
 }
 
 bool LogFile::startReplay()
@@ -320,11 +363,31 @@ bool LogFile::startReplay()
         return false;
     }
 
+    firstTimestamp = timestampBuffer[0];
+
+    // Build the seek keyframes in the background
+    stopIndexer();
+    indexer = new LogIndexer(file.fileName(), timestampBuffer, timestampPos, this);
+
+    // The indexer also puts the whole log in the history so gadgets can look
+    // at it all, the replayed updates themselves must not be recorded a
+    // second time
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectHistory *history = pm->getObject<UAVObjectHistory>();
+    if (history) {
+        history->clear();
+        history->setRecording(false);
+        indexer->collectHistory(UAVObjectHistory::now(), history->memoryBudget());
+    }
+
+    // Queued to the GUI thread; dropped if the indexer is deleted first
+    connect(indexer, &QThread::finished, indexer, [this]() { indexFinished(); });
+    indexer->start(QThread::LowPriorityThread);
+
     // Reset to log beginning.
     file.seek(logFileStartIdx + sizeof(lastTimeStamp));
     lastTimeStampPos = timestampPos[0];
     lastTimeStamp = timestampBuffer[0];
-    firstTimestamp = timestampBuffer[0];
     timestampBufferIdx = 1;
 
     timer.setInterval(10);
@@ -336,6 +399,12 @@ bool LogFile::startReplay()
 bool LogFile::stopReplay()
 {
     close();
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectHistory *history = pm->getObject<UAVObjectHistory>();
+    if (history)
+        history->setRecording(true);
+
     emit replayFinished();
     return true;
 }
@@ -352,21 +421,152 @@ void LogFile::resumeReplay()
 }
 
 /**
- * @brief LogFile::setReplayTime, sets the playback time
- * @param val, the time in
+ * @brief LogFile::setReplayTime, sets the playback time. The objects are brought to the state
+ * they had at that time in the log, with a single update per object.
+ * @param val, the time in seconds from the start of the log
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx = 0;
-    while (timestampBuffer[tmpIdx++] <= val * 1000 && tmpIdx <= timestampBufferIdx) {
+    if (timestampBuffer.isEmpty() || !file.isOpen())
+        return;
+
+    quint32 target = firstTimestamp + static_cast<quint32>(qMax(0.0, val * 1000));
+
+    // The first record after the target is the next one to play
+    int record = std::upper_bound(timestampBuffer.constBegin(), timestampBuffer.constEnd(), target)
+        - timestampBuffer.constBegin();
+
+    // Without the keyframes a seek would decode from the start of the log,
+    // so any past the first keyframe waits for the indexer
+    if (indexer && !indexer->isFinished()
+        && target - firstTimestamp >= LogIndexer::KEYFRAME_INTERVAL_MS) {
+        pendingSeek = val;
+        hasPendingSeek = true;
+        return;
     }
+    hasPendingSeek = false;
+
+    restoreState(record);
+
+    // Past the end, replay the last record again rather than run off the end
+    record = qMin(record, timestampBuffer.size() - 1);
 
-    lastTimeStampPos = timestampPos[tmpIdx];
-    lastTimeStamp = timestampBuffer[tmpIdx];
-    timestampBufferIdx = tmpIdx;
+    mutex.lock();
+    dataBuffer.clear();
+    mutex.unlock();
+
+    lastTimeStampPos = timestampPos[record];
+    lastTimeStamp = timestampBuffer[record];
+    timestampBufferIdx = record + 1;
+    file.seek(lastTimeStampPos + sizeof(lastTimeStamp));
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime = lastTimeStamp;
+    lastPlayTime = qMin(target, lastTimeStamp) - firstTimestamp;
 
     qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val * 1000;
 }
+
+/**
+ * @brief LogFile::restoreState Set the objects to how they were just before a record. Starts
+ * from the nearest keyframe, or the start of the log for records before the first one, and
+ * decodes the records since then into private objects so nothing is signalled until the end.
+ * @param record The record
+ */
+void LogFile::restoreState(int record)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objMngr = pm->getObject<UAVObjectManager>();
+    if (!objMngr)
+        return;
+
+    LogObjectState state;
+    int from = 0;
+
+    const LogIndexer::Keyframe *keyframe = indexer ? indexer->keyframeFor(record) : nullptr;
+    if (keyframe) {
+        state = keyframe->state;
+        from = keyframe->record;
+    }
+
+    if (!decoder)
+        decoder = new LogPacketDecoder;
+
+    decoder->setHandler([&state](UAVObject *obj) {
+        state.insert(LogIndexer::key(obj), LogIndexer::snapshot(obj));
+    });
+    for (int i = from; i < record; i++)
+        decoder->decode(file, timestampPos[i]);
+    decoder->setHandler(nullptr);
+
+    for (LogObjectState::const_iterator it = state.constBegin(); it != state.constEnd(); ++it) {
+        quint32 objId = it.key() >> 32;
+        quint32 instId = it.key() & 0xFFFFFFFF;
+
+        UAVObject *obj = objMngr->getObject(objId, instId);
+        if (!obj) {
+            // Create the instance, like UAVTalk does when one first arrives
+            UAVDataObject *type = qobject_cast<UAVDataObject *>(objMngr->getObject(objId));
+            if (!type)
+                continue;
+            UAVDataObject *instance = type->clone(instId);
+            if (!objMngr->registerObject(instance)) {
+                delete instance;
+                continue;
+            }
+            obj = instance;
+        }
+
+        if (it.value().size() == static_cast<int>(obj->getNumBytes()))
+            obj->unpack(reinterpret_cast<const quint8 *>(it.value().constData()));
+    }
+}
+
+void LogFile::setReplaySpeed(double val)
+{
+    playbackSpeed = val;
+
+    // Flat out replay runs a batch on every pass of the event loop
+    timer.setInterval(playbackSpeed > 0 ? 10 : 0);
+
+    qDebug() << "New playback speed: " << playbackSpeed;
+}
+
+void LogFile::waitForIndex()
+{
+    if (indexer) {
+        indexer->wait();
+        indexFinished();
+    }
+}
+
+/**
+ * @brief LogFile::indexFinished Once the indexer is done, move the samples it collected into
+ * the history and make any seek which was waiting for the keyframes
+ */
+void LogFile::indexFinished()
+{
+    if (!indexer || !indexer->isFinished())
+        return;
+
+    QScopedPointer<UAVObjectHistory> collected(indexer->takeHistory());
+    if (collected) {
+        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+        UAVObjectHistory *history = pm->getObject<UAVObjectHistory>();
+        if (history)
+            history->takeSamples(collected.data());
+    }
+
+    if (hasPendingSeek)
+        setReplayTime(pendingSeek);
+}
+
+void LogFile::stopIndexer()
+{
+    if (indexer) {
+        indexer->requestInterruption();
+        indexer->wait();
+        delete indexer;
+        indexer = nullptr;
+    }
+    hasPendingSeek = false;
+}
@@ -34,13 +34,17 @@
 #include <QDebug>
 #include <QBuffer>
 #include "uavobjects/uavobjectmanager.h"
+#include "logindexer.h"
 #include <math.h>
 
+class UAVObjectHistory;
+
 class LogFile : public QIODevice
 {
     Q_OBJECT
 public:
     explicit LogFile(QObject *parent = nullptr);
+    ~LogFile();
     qint64 bytesAvailable() const;
     qint64 bytesToWrite() const { return file.bytesToWrite(); }
     bool open(OpenMode mode);
@@ -52,12 +56,15 @@ public:
     bool startReplay();
     bool stopReplay();
 
+    //! Wait until the seek keyframes are built and the history is loaded
+    void waitForIndex();
+
 public slots:
-    void setReplaySpeed(double val)
-    {
-        playbackSpeed = val;
-        qDebug() << "New playback speed: " << playbackSpeed;
-    }
+    /**
+     * @brief setReplaySpeed Set the replay speed
+     * @param val Multiple of real time, or 0 for as fast as possible
+     */
+    void setReplaySpeed(double val);
     void setReplayTime(double val);
     void pauseReplay();
     void resumeReplay();
@@ -83,6 +90,19 @@ protected:
     double playbackSpeed;
 
 private:
+    bool replayNextPacket();
+    void restoreState(int record);
+    void stopIndexer();
+    void indexFinished();
+
+    // Decodes the records since a keyframe on the GUI thread for seeks
+    LogPacketDecoder *decoder;
+    LogIndexer *indexer;
+
+    // Seek waiting for the indexer, in seconds
+    double pendingSeek;
+    bool hasPendingSeek;
+
     QList<quint32> timestampBuffer;
     QList<quint32> timestampPos;
     quint32 timestampBufferIdx;
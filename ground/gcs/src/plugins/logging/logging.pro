@@ -17,7 +17,8 @@ HEADERS += loggingplugin.h \
     logginggadget.h \
     logginggadgetfactory.h \
     loggingdevice.h \
-    flightlogdownload.h
+    flightlogdownload.h \
+    logindexer.h
 
 SOURCES += loggingplugin.cpp \
     logfile.cpp \
@@ -25,7 +26,12 @@ SOURCES += loggingplugin.cpp \
     logginggadget.cpp \
     logginggadgetfactory.cpp \
     loggingdevice.cpp \
-    flightlogdownload.cpp
+    flightlogdownload.cpp \
+    logindexer.cpp
+
+contains(DEFINES, WITH_TESTS) {
+    SOURCES += loggingtests.cpp
+}
 
 OTHER_FILES += LoggingGadget.pluginspec
 
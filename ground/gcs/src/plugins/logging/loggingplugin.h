@@ -134,6 +134,11 @@ protected:
     // These are used for replay, logging in its own thread
     LoggingConnection *logConnection;
 
+#ifdef WITH_TESTS
+private Q_SLOTS:
+    void benchmarkSeek();
+#endif
+
 private slots:
     void downloadLog();
     void toggleLogging();
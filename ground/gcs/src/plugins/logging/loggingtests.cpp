@@ -0,0 +1,129 @@
+/**
+ ******************************************************************************
+ * @file       loggingtests.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup loggingplugin
+ * @{
+ * @brief Log replay tests
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "loggingplugin.h"
+#include "uavobjects/uavobjecthistory.h"
+#include "uavobjects/uavobjectsinit.h"
+
+#include <QBuffer>
+#include <QTemporaryFile>
+#include <QTest>
+
+#include <limits>
+
+//! Two hours of attitude at 20 Hz
+#define TEST_LOG_RECORDS (2 * 60 * 60 * 20)
+#define TEST_LOG_PERIOD_MS 50
+
+/**
+ * @brief writeTestLog Write a log whose AttitudeActual.Yaw is the record number
+ * @param fileName File to write
+ */
+static void writeTestLog(const QString &fileName)
+{
+    // The header, written the normal way
+    LogFile log;
+    log.setFileName(fileName);
+    log.open(QIODevice::WriteOnly);
+    log.close();
+
+    UAVObjectManager objMngr;
+    UAVObjectsInitialize(&objMngr);
+    UAVObject *attitude = objMngr.getObject("AttitudeActual");
+
+    QBuffer packet;
+    packet.open(QIODevice::WriteOnly);
+    UAVTalk talk(&packet, &objMngr, false);
+
+    QFile file(fileName);
+    file.open(QIODevice::Append);
+    for (quint32 i = 0; i < TEST_LOG_RECORDS; i++) {
+        attitude->getField("Yaw")->setDouble(i);
+
+        packet.seek(0);
+        packet.buffer().clear();
+        talk.sendObject(attitude, false, false);
+
+        quint32 timestamp = i * TEST_LOG_PERIOD_MS;
+        qint64 dataSize = packet.buffer().size();
+        file.write(reinterpret_cast<char *>(&timestamp), sizeof(timestamp));
+        file.write(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
+        file.write(packet.buffer());
+    }
+}
+
+void LoggingPlugin::benchmarkSeek()
+{
+    QTemporaryFile tmp;
+    QVERIFY(tmp.open());
+    tmp.close();
+    writeTestLog(tmp.fileName());
+
+    LogFile log;
+    log.setFileName(tmp.fileName());
+    QVERIFY(log.open(QIODevice::ReadOnly));
+    QVERIFY(log.startReplay());
+    log.pauseReplay();
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObject *attitude = pm->getObject<UAVObjectManager>()->getObject("AttitudeActual");
+    UAVObjectField *yaw = attitude->getField("Yaw");
+
+    // A seek while indexing is made once the keyframes are there
+    log.setReplayTime(1800);
+    log.waitForIndex();
+    QCOMPARE(yaw->getDouble(), 36000.0);
+
+    // The history collected by the indexer ends with the log
+    UAVObjectHistory *history = pm->getObject<UAVObjectHistory>();
+    UAVObjectHistory::Window window =
+        history->query(yaw, 0, 0, std::numeric_limits<qint64>::max());
+    QVERIFY(!window.isEmpty());
+    QCOMPARE(window.value(window.size() - 1), TEST_LOG_RECORDS - 1.0);
+
+    // Seeks land on the last record at or before the time, both ways
+    log.setReplayTime(3600.02);
+    QCOMPARE(yaw->getDouble(), 72000.0);
+    log.setReplayTime(10);
+    QCOMPARE(yaw->getDouble(), 200.0);
+    log.setReplayTime(7199.99);
+    QCOMPARE(yaw->getDouble(), TEST_LOG_RECORDS - 1.0);
+
+    qsrand(42);
+    QBENCHMARK {
+        log.setReplayTime(qrand() % (TEST_LOG_RECORDS * TEST_LOG_PERIOD_MS / 1000));
+    }
+
+    log.stopReplay();
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,192 @@
+/**
+ ******************************************************************************
+ * @file       logindexer.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup loggingplugin
+ * @{
+ * @brief Decodes log files off the GUI path and indexes them for seeking
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "logindexer.h"
+#include "uavobjects/uavobjecthistory.h"
+#include "uavobjects/uavobjectmanager.h"
+#include "uavobjects/uavobjectsinit.h"
+#include "uavtalk/uavtalk.h"
+
+#include <algorithm>
+
+LogPacketDecoder::LogPacketDecoder()
+{
+    objMngr = new UAVObjectManager;
+    UAVObjectsInitialize(objMngr);
+
+    foreach (QVector<UAVDataObject *> instances, objMngr->getDataObjectsVector()) {
+        foreach (UAVDataObject *obj, instances)
+            watch(obj);
+    }
+    QObject::connect(objMngr, &UAVObjectManager::newInstance, [this](UAVObject *obj) { watch(obj); });
+
+    buffer.open(QIODevice::ReadOnly);
+    talk = new UAVTalk(&buffer, objMngr, false);
+}
+
+LogPacketDecoder::~LogPacketDecoder()
+{
+    delete talk;
+
+    // The manager doesn't own its objects
+    foreach (QVector<UAVObject *> instances, objMngr->getObjectsVector())
+        qDeleteAll(instances);
+    delete objMngr;
+}
+
+void LogPacketDecoder::watch(UAVObject *obj)
+{
+    if (!qobject_cast<UAVDataObject *>(obj))
+        return;
+
+    QObject::connect(obj, &UAVObject::objectUpdated, [this](UAVObject *updated) {
+        if (handler)
+            handler(updated);
+    });
+}
+
+bool LogPacketDecoder::decode(QFile &file, qint64 pos)
+{
+    qint64 dataSize;
+
+    if (!file.seek(pos + sizeof(quint32))
+        || file.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize)) != sizeof(dataSize)
+        || dataSize < 1 || dataSize > (1024 * 1024))
+        return false;
+
+    // UAVTalk reads the record from the buffer and updates the objects right away
+    buffer.buffer() = file.read(dataSize);
+    buffer.seek(0);
+    emit buffer.readyRead();
+
+    return true;
+}
+
+LogIndexer::LogIndexer(const QString &fileName, const QList<quint32> &timestamps,
+                       const QList<quint32> &positions, QObject *parent)
+    : QThread(parent)
+    , fileName(fileName)
+    , timestamps(timestamps)
+    , positions(positions)
+    , wantHistory(false)
+    , historyStart(0)
+    , historyBudget(0)
+    , history(nullptr)
+{
+}
+
+LogIndexer::~LogIndexer()
+{
+    delete history;
+}
+
+void LogIndexer::collectHistory(qint64 start, qint64 budget)
+{
+    wantHistory = true;
+    historyStart = start;
+    historyBudget = budget;
+}
+
+UAVObjectHistory *LogIndexer::takeHistory()
+{
+    if (!isFinished())
+        return nullptr;
+
+    UAVObjectHistory *taken = history;
+    history = nullptr;
+    return taken;
+}
+
+const LogIndexer::Keyframe *LogIndexer::keyframeFor(int record) const
+{
+    if (!isFinished())
+        return nullptr;
+
+    auto it = std::upper_bound(keyframes.constBegin(), keyframes.constEnd(), record,
+                               [](int rec, const Keyframe &kf) { return rec < kf.record; });
+    if (it == keyframes.constBegin())
+        return nullptr;
+
+    return &*(it - 1);
+}
+
+quint64 LogIndexer::key(UAVObject *obj)
+{
+    return key(obj->getObjID(), obj->getInstID());
+}
+
+QByteArray LogIndexer::snapshot(UAVObject *obj)
+{
+    QByteArray data(obj->getNumBytes(), Qt::Uninitialized);
+    obj->pack(reinterpret_cast<quint8 *>(data.data()));
+    return data;
+}
+
+void LogIndexer::run()
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    // Keyframes share the packed objects with the running state, so each
+    // one only costs the objects which changed since the last
+    LogObjectState state;
+    LogPacketDecoder decoder;
+    qint64 timestamp = 0;
+
+    if (wantHistory) {
+        history = new UAVObjectHistory;
+        history->setMemoryBudget(historyBudget);
+    }
+
+    decoder.setHandler([this, &state, &timestamp](UAVObject *obj) {
+        state.insert(key(obj), snapshot(obj));
+        if (history)
+            history->record(obj, timestamp);
+    });
+
+    quint32 nextKeyframe = timestamps.isEmpty() ? 0 : timestamps.first() + KEYFRAME_INTERVAL_MS;
+
+    for (int i = 0; i < positions.size() && !isInterruptionRequested(); i++) {
+        timestamp = historyStart + timestamps[i] - timestamps.first();
+
+        if (timestamps[i] >= nextKeyframe) {
+            Keyframe keyframe = { i, state };
+            keyframes.append(keyframe);
+            nextKeyframe = timestamps[i] + KEYFRAME_INTERVAL_MS;
+        }
+
+        decoder.decode(file, positions[i]);
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
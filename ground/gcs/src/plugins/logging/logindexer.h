@@ -0,0 +1,160 @@
+/**
+ ******************************************************************************
+ * @file       logindexer.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup loggingplugin
+ * @{
+ * @brief Decodes log files off the GUI path and indexes them for seeking
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef LOGINDEXER_H
+#define LOGINDEXER_H
+
+#include <QBuffer>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QThread>
+#include <QVector>
+
+#include <functional>
+
+class UAVObject;
+class UAVObjectHistory;
+class UAVObjectManager;
+class UAVTalk;
+
+//! Packed contents of object instances, by LogIndexer::key()
+typedef QHash<quint64, QByteArray> LogObjectState;
+
+/**
+ * @brief Decodes log records into a private set of objects, so the live
+ * objects and everything connected to them are left alone.
+ *
+ * Each instance lives in the thread that creates it and must only be used
+ * from there.
+ */
+class LogPacketDecoder
+{
+public:
+    LogPacketDecoder();
+    ~LogPacketDecoder();
+
+    //! Called with every data object a decoded record updates
+    void setHandler(std::function<void(UAVObject *)> handler) { this->handler = handler; }
+
+    /**
+     * @brief decode Decode one log record
+     * @param file The log
+     * @param pos Position of the record's timestamp
+     * @return false if the record is unreadable
+     */
+    bool decode(QFile &file, qint64 pos);
+
+private:
+    void watch(UAVObject *obj);
+
+    UAVObjectManager *objMngr;
+    QBuffer buffer;
+    UAVTalk *talk;
+    std::function<void(UAVObject *)> handler;
+};
+
+/**
+ * @brief Builds state keyframes of a log on a worker thread. A keyframe is
+ * the packed contents of every object instance seen before a record, so a
+ * seek only has to decode the records since the nearest one. Optionally
+ * the samples are recorded into a history as well, so the whole log is
+ * decoded once, away from the GUI thread.
+ *
+ * The keyframes and history can be used once the thread has finished.
+ */
+class LogIndexer : public QThread
+{
+    Q_OBJECT
+
+public:
+    //! Log time between keyframes
+    static const quint32 KEYFRAME_INTERVAL_MS = 10000;
+
+    struct Keyframe
+    {
+        //! The state is from before this record
+        int record;
+        LogObjectState state;
+    };
+
+    LogIndexer(const QString &fileName, const QList<quint32> &timestamps,
+               const QList<quint32> &positions, QObject *parent = nullptr);
+    ~LogIndexer();
+
+    /**
+     * @brief collectHistory Also record every sample, timestamped with when
+     * it will be replayed at normal speed. Call before starting the thread.
+     * @param start When the first record will be replayed, in milliseconds
+     * @param budget Memory budget of the history
+     */
+    void collectHistory(qint64 start, qint64 budget);
+
+    /**
+     * @brief takeHistory Get the samples once the thread has finished
+     * @return The history, which the caller then owns, or nullptr if none
+     * was collected or it has been taken already
+     */
+    UAVObjectHistory *takeHistory();
+
+    /**
+     * @brief keyframeFor Find the latest keyframe at or before a record
+     * @return The keyframe, or nullptr if there is none or indexing hasn't
+     * finished
+     */
+    const Keyframe *keyframeFor(int record) const;
+
+    static quint64 key(quint32 objId, quint32 instId)
+    {
+        return (static_cast<quint64>(objId) << 32) | instId;
+    }
+    static quint64 key(UAVObject *obj);
+    static QByteArray snapshot(UAVObject *obj);
+
+protected:
+    void run();
+
+private:
+    QString fileName;
+    QList<quint32> timestamps;
+    QList<quint32> positions;
+    QVector<Keyframe> keyframes;
+
+    bool wantHistory;
+    qint64 historyStart;
+    qint64 historyBudget;
+    UAVObjectHistory *history;
+};
+
+#endif // LOGINDEXER_H
+
+/**
+ * @}
+ * @}
+ */
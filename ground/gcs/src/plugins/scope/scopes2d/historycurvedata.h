@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ *
+ * @file       historycurvedata.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Curve samples read straight out of the UAVObject history
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef HISTORYCURVEDATA_H
+#define HISTORYCURVEDATA_H
+
+#include "uavobjects/uavobjecthistory.h"
+#include "qwt/src/qwt_series_data.h"
+
+#include <math.h>
+
+/**
+ * @brief The HistoryCurveData class Presents a history window to a curve
+ * without copying it. x is in seconds, y is scaled by 10^scalePower.
+ */
+class HistoryCurveData : public QwtSeriesData<QPointF>
+{
+public:
+    HistoryCurveData(const UAVObjectHistory::Window &window, int scalePower)
+        : window(window)
+        , scale(pow(10, scalePower))
+    {
+    }
+
+    size_t size() const { return window.size(); }
+
+    QPointF sample(size_t i) const
+    {
+        return QPointF(window.timestamp(i) / 1000.0, window.value(i) * scale);
+    }
+
+    QRectF boundingRect() const
+    {
+        if (d_boundingRect.width() < 0)
+            d_boundingRect = qwtBoundingRect(*this);
+
+        return d_boundingRect;
+    }
+
+private:
+    UAVObjectHistory::Window window;
+    double scale;
+};
+
+#endif // HISTORYCURVEDATA_H
+
+/**
+ * @}
+ * @}
+ */
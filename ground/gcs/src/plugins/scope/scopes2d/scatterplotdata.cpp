@@ -30,6 +30,7 @@
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjects/uavobjectmanager.h"
 #include "scopes2d/scatterplotdata.h"
+#include "scopes2d/historycurvedata.h"
 #include "scopes2d/scatterplotscopeconfig.h"
 #include "scopegadgetwidget.h"
 
@@ -37,6 +38,27 @@
 #include "qwt/src/qwt_plot.h"
 #include "qwt/src/qwt_plot_curve.h"
 
+TimeSeriesPlotData::TimeSeriesPlotData(QString uavObject, QString uavField)
+    : ScatterplotData(uavObject, uavField)
+    , historyField(nullptr)
+    , historyElement(0)
+    , clearedAt(0)
+{
+    scalePower = 1;
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    history = pm->getObject<UAVObjectHistory>();
+}
+
+/**
+ * @brief TimeSeriesPlotData::usesHistory Raw values can be plotted straight from the history,
+ * scope math needs its own buffer
+ */
+bool TimeSeriesPlotData::usesHistory() const
+{
+    return history && mathFunction != "Boxcar average" && mathFunction != "Standard deviation";
+}
+
 /**
  * @brief Scatterplot2dScopeConfig::plotNewData Update plot with new data
  * @param scopeGadgetWidget
@@ -48,13 +70,20 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
     Q_UNUSED(scopeConfig);
     Q_UNUSED(scopeGadgetWidget);
 
+    qint64 now = UAVObjectHistory::now();
+
     // Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+    if (readAndResetUpdatedFlag() == true) {
+        if (usesHistory() && historyField) {
+            qint64 from = qMax(clearedAt, now - static_cast<qint64>(m_xWindowSize * 1000));
+            curve->setSamples(new HistoryCurveData(
+                history->query(historyField, historyElement, from, now), scalePower));
+        } else {
+            curve->setSamples(*xData, *yData);
+        }
+    }
 
-    QDateTime NOW = QDateTime::currentDateTime();
-    double toTime = NOW.toTime_t();
-    toTime += NOW.time().msec() / 1000.0;
+    double toTime = now / 1000.0;
 
     scopeGadgetWidget->setAxisScale(QwtPlot::xBottom, toTime - m_xWindowSize, toTime);
 }
@@ -153,7 +182,15 @@ bool TimeSeriesPlotData::append(UAVObject *obj)
         // Get the field of interest
         UAVObjectField *field = obj->getField(uavFieldName);
 
-        if (field) {
+        if (field && usesHistory()) {
+            // The history already has the sample, just note what to plot
+            historyField = field;
+            historyElement = haveSubField ? field->getElementNames().indexOf(QRegExp(
+                                                uavSubFieldName, Qt::CaseSensitive,
+                                                QRegExp::FixedString))
+                                          : 0;
+            return true;
+        } else if (field) {
             QDateTime NOW = QDateTime::currentDateTime(); // THINK ABOUT REIMPLEMENTING THIS TO SHOW
                                                           // UAVO TIME, NOT SYSTEM TIME
             double currentValue =
@@ -259,3 +296,14 @@ void ScatterplotData::clearPlots()
     yData->clear();
     xData->clear();
 }
+
+/**
+ * @brief TimeSeriesPlotData::clearPlots Clear all plot data, hiding what the history holds so far
+ */
+void TimeSeriesPlotData::clearPlots()
+{
+    ScatterplotData::clearPlots();
+
+    clearedAt = UAVObjectHistory::now() + 1;
+    setUpdatedFlagToTrue();
+}
@@ -29,6 +29,7 @@
 
 #include "scopes2d/plotdata2d.h"
 #include "uavobjects/uavobject.h"
+#include "uavobjects/uavobjecthistory.h"
 #include "qwt/src/qwt_plot_curve.h"
 
 #include <QTimer>
@@ -85,27 +86,35 @@ public:
 };
 
 /**
- * @brief The TimeSeriesPlotData class The chrono plot has a variable sized buffer of data,
- * where the data is for a specified time period.
+ * @brief The TimeSeriesPlotData class The chrono plot shows the data for a specified time period.
+ * Raw values are read from the shared UAVObject history, only the results of scope math are
+ * kept in a buffer of their own.
  */
 class TimeSeriesPlotData : public ScatterplotData
 {
     Q_OBJECT
 public:
-    TimeSeriesPlotData(QString uavObject, QString uavField)
-        : ScatterplotData(uavObject, uavField)
-    {
-        scalePower = 1;
-    }
+    TimeSeriesPlotData(QString uavObject, QString uavField);
     ~TimeSeriesPlotData() {}
 
     bool append(UAVObject *obj);
 
     virtual void removeStaleData();
     virtual void plotNewData(PlotData *, ScopeConfig *, ScopeGadgetWidget *);
+    void clearPlots();
 
 private slots:
     void removeStaleDataTimeout();
+
+private:
+    bool usesHistory() const;
+
+    UAVObjectHistory *history;
+    // The element last appended, which is what gets plotted
+    UAVObjectField *historyField;
+    int historyElement;
+    //! Samples before this time (ms) were cleared by the user
+    qint64 clearedAt;
 };
 
 #endif // SCATTERPLOTDATA_H
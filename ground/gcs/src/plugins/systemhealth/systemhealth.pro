@@ -16,6 +16,7 @@ HEADERS += systemhealthgadgetwidget.h
 HEADERS += systemhealthgadgetfactory.h
 HEADERS += systemhealthgadgetconfiguration.h
 HEADERS += systemhealthgadgetoptionspage.h
+HEADERS += threadstatswidget.h
 
 SOURCES += systemhealthplugin.cpp
 SOURCES += systemhealthgadget.cpp
@@ -23,6 +24,11 @@ SOURCES += systemhealthgadgetfactory.cpp
 SOURCES += systemhealthgadgetwidget.cpp
 SOURCES += systemhealthgadgetconfiguration.cpp
 SOURCES += systemhealthgadgetoptionspage.cpp
+SOURCES += threadstatswidget.cpp
+
+contains(DEFINES, WITH_TESTS) {
+    SOURCES += systemhealthtests.cpp
+}
 
 OTHER_FILES += SystemHealthGadget.pluginspec
 
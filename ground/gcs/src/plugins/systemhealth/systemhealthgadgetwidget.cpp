@@ -26,11 +26,14 @@
  */
 
 #include "systemhealthgadgetwidget.h"
+#include "threadstatswidget.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjects/uavobjectmanager.h"
 #include "systemalarms.h"
 #include <coreplugin/icore.h>
+#include <utils/svgitemcache.h>
 #include <QDebug>
+#include <QAction>
 #include <QWhatsThis>
 
 /*
@@ -64,7 +67,13 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent)
     connect(telMngr, &TelemetryManager::disconnected, this,
             &SystemHealthGadgetWidget::onAutopilotDisconnect);
 
-    setToolTip(tr("Displays flight system errors. Click on an alarm for more information."));
+    QAction *action = new QAction(tr("Task Profile..."), this);
+    connect(action, &QAction::triggered, this, &SystemHealthGadgetWidget::showThreadStats);
+    addAction(action);
+    setContextMenuPolicy(Qt::ActionsContextMenu);
+
+    setToolTip(tr("Displays flight system errors. Click on an alarm for more information, "
+                  "right-click for the task profile."));
 }
 
 /**
@@ -94,15 +103,6 @@ void SystemHealthGadgetWidget::onAutopilotDisconnect()
 void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
 {
     static QList<QString> warningClean;
-    // This code does not know anything about alarms beforehand, and
-    // I found no efficient way to locate items inside the scene by
-    // name, so it's just as simple to reset the scene:
-    // And add the one with the right name.
-    QGraphicsScene *m_scene = scene();
-    foreach (QGraphicsItem *item, background->childItems()) {
-        m_scene->removeItem(item);
-        delete item; // removeItem does _not_ delete the item.
-    }
 
     UAVObjectField *field = systemAlarm->getField("Alarm");
     Q_ASSERT(field);
@@ -113,19 +113,30 @@ void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
         QString element = field->getElementNames()[i];
         QString value = field->getValue(i).toString();
         if (m_renderer->elementExists(element)) {
-            QMatrix blockMatrix = m_renderer->matrixForElement(element);
-            qreal startX = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).x();
-            qreal startY = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).y();
             QString element2 = element + "-" + value;
+            QGraphicsSvgItem *ind = alarmItems.value(element);
             if (m_renderer->elementExists(element2)) {
-                QGraphicsSvgItem *ind = new QGraphicsSvgItem();
-                ind->setSharedRenderer(m_renderer);
-                ind->setElementId(element2);
-                ind->setParentItem(background);
-                QTransform matrix;
-                matrix.translate(startX, startY);
-                ind->setTransform(matrix, false);
+                if (!ind) {
+                    QMatrix blockMatrix = m_renderer->matrixForElement(element);
+                    QRectF blockRect = blockMatrix.mapRect(m_renderer->boundsOnElement(element));
+                    ind = new QGraphicsSvgItem();
+                    ind->setSharedRenderer(m_renderer);
+                    ind->setElementId(element2);
+                    ind->setParentItem(background);
+                    QTransform matrix;
+                    matrix.translate(blockRect.x(), blockRect.y());
+                    ind->setTransform(matrix, false);
+                    alarmItems.insert(element, ind);
+                    Utils::SvgItemCache::cacheItem(this, ind);
+                } else if (ind->elementId() != element2) {
+                    // Only a change of state costs a new rendering
+                    ind->setElementId(element2);
+                    Utils::SvgItemCache::cacheItem(this, ind);
+                }
+                ind->setVisible(true);
             } else {
+                if (ind)
+                    ind->setVisible(false);
                 if ((value.compare("Uninitialised") != 0) && !warningClean.contains(element2)) {
                     qDebug() << "[SystemHealth] Warning: The SystemHealth SVG does not contain a "
                                 "graphical element for the "
@@ -147,9 +158,28 @@ SystemHealthGadgetWidget::~SystemHealthGadgetWidget()
     // Do nothing
 }
 
+/**
+  * Remove the alarm indicators, they are placed for one particular SVG file
+  */
+void SystemHealthGadgetWidget::clearAlarmItems()
+{
+    foreach (QGraphicsSvgItem *item, alarmItems) {
+        scene()->removeItem(item);
+        delete item; // removeItem does _not_ delete the item.
+    }
+    alarmItems.clear();
+}
+
+bool SystemHealthGadgetWidget::isAlarmItem(QGraphicsSvgItem *item) const
+{
+    return item && item->isVisible() && (item != foreground) && (item != background)
+        && (item != nolink);
+}
+
 void SystemHealthGadgetWidget::setSystemFile(QString dfn)
 {
     if (QFile::exists(dfn)) {
+        clearAlarmItems();
         m_renderer->load(dfn);
         if (m_renderer->isValid()) {
             fgenabled = false;
@@ -171,6 +201,7 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
             QGraphicsScene *l_scene = scene();
             l_scene->setSceneRect(background->boundingRect());
             fitInView(background, Qt::KeepAspectRatio);
+            Utils::SvgItemCache::cacheItems(this);
 
             // Check whether the autopilot is connected already, by the way:
             ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -214,10 +245,17 @@ void SystemHealthGadgetWidget::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event);
     fitInView(background, Qt::KeepAspectRatio);
+    Utils::SvgItemCache::cacheItems(this);
 }
 
 void SystemHealthGadgetWidget::mousePressEvent(QMouseEvent *event)
 {
+    // Right button brings up the context menu instead
+    if (event->button() == Qt::RightButton) {
+        QGraphicsView::mousePressEvent(event);
+        return;
+    }
+
     QGraphicsScene *graphicsScene = scene();
     if (graphicsScene) {
         QPoint point = event->pos();
@@ -226,7 +264,7 @@ void SystemHealthGadgetWidget::mousePressEvent(QMouseEvent *event)
             QGraphicsSvgItem *clickedItem = dynamic_cast<QGraphicsSvgItem *>(sceneItem);
 
             if (clickedItem) {
-                if ((clickedItem != foreground) && (clickedItem != background)) {
+                if (isAlarmItem(clickedItem)) {
                     // Clicked an actual alarm. We need to set haveAlarmItem to true
                     // as two of the items in this loop will always be foreground and
                     // background. Without this flag, at some point in the loop we
@@ -250,6 +288,15 @@ void SystemHealthGadgetWidget::mousePressEvent(QMouseEvent *event)
     }
 }
 
+/**
+  * Open the per-task CPU, wakeup and queue statistics
+  */
+void SystemHealthGadgetWidget::showThreadStats()
+{
+    ThreadStatsWidget *stats = new ThreadStatsWidget(this);
+    stats->show();
+}
+
 void SystemHealthGadgetWidget::showAlarmDescriptionForItemId(const QString itemId,
                                                              const QPoint &location)
 {
@@ -268,7 +315,7 @@ void SystemHealthGadgetWidget::showAllAlarmDescriptions(const QPoint &location)
         // Loop through all items in the scene looking for svg items that represent alarms
         foreach (QGraphicsItem *curItem, graphicsScene->items()) {
             QGraphicsSvgItem *curSvgItem = dynamic_cast<QGraphicsSvgItem *>(curItem);
-            if (curSvgItem && (curSvgItem != foreground) && (curSvgItem != background)) {
+            if (isAlarmItem(curSvgItem)) {
                 QString elementId = curSvgItem->elementId();
                 if (!elementId.contains("OK")) {
                     // Found an alarm, get its corresponding alarm html file contents
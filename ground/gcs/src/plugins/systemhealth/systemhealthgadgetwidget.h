@@ -58,18 +58,24 @@ private slots:
     void updateAlarms(UAVObject *systemAlarm); // Called by the systemalarms UAVObject
     void onAutopilotConnect();
     void onAutopilotDisconnect();
+    void showThreadStats();
 
 private:
     QSvgRenderer *m_renderer;
     QGraphicsSvgItem *background;
     QGraphicsSvgItem *foreground;
     QGraphicsSvgItem *nolink;
+    // One indicator per alarm, created on first use and then only switched
+    // between the element's states so its cached rendering can be reused
+    QMap<QString, QGraphicsSvgItem *> alarmItems;
 
     // Simple flag to skip rendering if the
     bool fgenabled; // layer does not exist.
 
     void showAlarmDescriptionForItemId(const QString itemId, const QPoint &location);
     void showAllAlarmDescriptions(const QPoint &location);
+    void clearAlarmItems();
+    bool isAlarmItem(QGraphicsSvgItem *item) const;
     QString getAlarmDescriptionFileName(const QString itemId);
 };
 #endif /* SYSTEMHEALTHGADGETWIDGET_H_ */
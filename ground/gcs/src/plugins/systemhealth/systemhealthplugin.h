@@ -45,5 +45,10 @@ public:
 
 private:
     SystemHealthGadgetFactory *mf;
+
+#ifdef WITH_TESTS
+private Q_SLOTS:
+    void benchmarkAlarmFrameTime();
+#endif
 };
 #endif /* SYSTEMHEALTHPLUGIN_H_ */
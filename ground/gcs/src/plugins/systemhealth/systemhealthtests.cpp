@@ -0,0 +1,85 @@
+/**
+ ******************************************************************************
+ * @file       systemhealthtests.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup SystemHealthPlugin System Health Plugin
+ * @{
+ * @brief The System Health gadget plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "systemhealthplugin.h"
+#include "systemhealthgadgetwidget.h"
+
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjects/uavobjectmanager.h"
+#include "utils/pathutils.h"
+#include "systemalarms.h"
+
+#include <QElapsedTimer>
+#include <QTest>
+
+//! Telemetry rate being simulated
+#define TELEMETRY_RATE_HZ 100
+
+/**
+ * Time one second of SystemAlarms telemetry at 100 Hz, repainting the gadget
+ * after every update. Most updates repeat the previous alarm states, every
+ * tenth one flips the attitude alarm, as a flickering alarm would.
+ */
+void SystemHealthPlugin::benchmarkAlarmFrameTime()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    SystemAlarms *alarms = SystemAlarms::GetInstance(objManager);
+    UAVObjectField *field = alarms->getField("Alarm");
+    QVERIFY(field);
+
+    int attitude = field->getElementNames().indexOf("Attitude");
+    QVERIFY(attitude >= 0);
+
+    SystemHealthGadgetWidget widget;
+    widget.setSystemFile(Utils::PathUtils::GetDataPath() + "diagrams/default/system-health.svg");
+    widget.resize(400, 200);
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+
+    qint64 worstFrame = 0;
+    QElapsedTimer frameTimer;
+
+    QBENCHMARK {
+        for (int i = 0; i < TELEMETRY_RATE_HZ; i++) {
+            frameTimer.start();
+            field->setValue((i % 10) ? "OK" : "Warning", attitude);
+            alarms->updated();
+            widget.viewport()->repaint();
+            worstFrame = qMax(worstFrame, frameTimer.nsecsElapsed());
+        }
+    }
+
+    qDebug() << "SystemHealth worst frame:" << worstFrame / 1000 << "us";
+}
+
+/**
+ * @}
+ * @}
+ */
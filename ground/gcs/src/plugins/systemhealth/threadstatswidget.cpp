@@ -0,0 +1,160 @@
+/**
+ ******************************************************************************
+ *
+ * @file       threadstatswidget.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup SystemHealthPlugin System Health Plugin
+ * @{
+ * @brief Table of the per-task and per-queue flight statistics
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "threadstatswidget.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjects/uavobjectmanager.h"
+#include "taskinfo.h"
+#include "threadstats.h"
+#include "queuestats.h"
+#include <QHeaderView>
+#include <QLabel>
+#include <QVBoxLayout>
+
+ThreadStatsWidget::ThreadStatsWidget(QWidget *parent)
+    : QWidget(parent, Qt::Tool)
+{
+    setWindowTitle(tr("Task Profile"));
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    threadTable = new QTableWidget(0, 6, this);
+    threadTable->setHorizontalHeaderLabels(QStringList() << tr("Task") << tr("CPU %")
+                                                         << tr("Avg CPU %") << tr("Wakeups/s")
+                                                         << tr("Max Blocked (ms)")
+                                                         << tr("Stack Free"));
+
+    queueTable = new QTableWidget(0, 6, this);
+    queueTable->setHorizontalHeaderLabels(QStringList() << tr("Creator") << tr("Length")
+                                                        << tr("Item Size") << tr("Depth")
+                                                        << tr("High Water") << tr("Full"));
+
+    foreach (QTableWidget *table, QList<QTableWidget *>() << threadTable << queueTable) {
+        table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        table->verticalHeader()->hide();
+        table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    }
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(new QLabel(tr("Tasks"), this));
+    layout->addWidget(threadTable, 3);
+    layout->addWidget(new QLabel(tr("Queues"), this));
+    layout->addWidget(queueTable, 2);
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    objManager = pm->getObject<UAVObjectManager>();
+
+    // The flight side creates one instance per task and per queue
+    connect(objManager, &UAVObjectManager::newInstance, this, &ThreadStatsWidget::newInstance);
+
+    foreach (UAVObject *obj, objManager->getObjectInstancesVector(ThreadStats::NAME))
+        watch(obj);
+    foreach (UAVObject *obj, objManager->getObjectInstancesVector(QueueStats::NAME))
+        watch(obj);
+
+    resize(560, 480);
+}
+
+void ThreadStatsWidget::newInstance(UAVObject *obj)
+{
+    if (obj->getObjID() == ThreadStats::OBJID || obj->getObjID() == QueueStats::OBJID)
+        watch(obj);
+}
+
+void ThreadStatsWidget::watch(UAVObject *obj)
+{
+    if (obj->getObjID() == ThreadStats::OBJID) {
+        connect(obj, &UAVObject::objectUpdated, this, &ThreadStatsWidget::updateThread);
+        updateThread(obj);
+    } else {
+        connect(obj, &UAVObject::objectUpdated, this, &ThreadStatsWidget::updateQueue);
+        updateQueue(obj);
+    }
+}
+
+void ThreadStatsWidget::setRow(QTableWidget *table, int row, const QStringList &cells)
+{
+    if (table->rowCount() <= row)
+        table->setRowCount(row + 1);
+
+    for (int i = 0; i < cells.size(); i++) {
+        QTableWidgetItem *item = table->item(row, i);
+
+        if (!item) {
+            item = new QTableWidgetItem();
+            if (i > 0)
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            table->setItem(row, i, item);
+        }
+
+        item->setText(cells.at(i));
+    }
+}
+
+void ThreadStatsWidget::updateThread(UAVObject *obj)
+{
+    ThreadStats *stats = qobject_cast<ThreadStats *>(obj);
+    if (!stats)
+        return;
+
+    ThreadStats::DataFields data = stats->getData();
+
+    // Task indexes the elements of the TaskInfo fields
+    QString task = QString::number(data.Task);
+    UAVObject *taskInfo = objManager->getObject(TaskInfo::NAME);
+    if (taskInfo)
+        task = taskInfo->getField("Running")->getElementNames().value(data.Task, task);
+
+    setRow(threadTable, stats->getInstID(),
+           QStringList() << task
+                         << QString::number(data.CPU, 'f', 1)
+                         << QString::number(data.CPUAverage, 'f', 1)
+                         << QString::number(data.Wakeups)
+                         << QString::number(data.MaxBlocked / 1000.0, 'f', 1)
+                         << QString::number(data.StackRemaining));
+
+    // Instances left over from tasks that have stopped
+    threadTable->setRowHidden(stats->getInstID(), data.Task == NO_TASK);
+}
+
+void ThreadStatsWidget::updateQueue(UAVObject *obj)
+{
+    QueueStats *stats = qobject_cast<QueueStats *>(obj);
+    if (!stats)
+        return;
+
+    QueueStats::DataFields data = stats->getData();
+
+    setRow(queueTable, stats->getInstID(),
+           QStringList() << QString("0x%1").arg(data.Creator, 8, 16, QChar('0'))
+                         << QString::number(data.Length) << QString::number(data.ItemSize)
+                         << QString::number(data.Depth) << QString::number(data.HighWater)
+                         << QString::number(data.Failures));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ *
+ * @file       threadstatswidget.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup SystemHealthPlugin System Health Plugin
+ * @{
+ * @brief Table of the per-task and per-queue flight statistics
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef THREADSTATSWIDGET_H_
+#define THREADSTATSWIDGET_H_
+
+#include "uavobjects/uavobject.h"
+#include <QWidget>
+#include <QTableWidget>
+
+class UAVObjectManager;
+
+/**
+ * Shows the ThreadStats and QueueStats instances as two tables, updated as
+ * the instances arrive.
+ */
+class ThreadStatsWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    ThreadStatsWidget(QWidget *parent = nullptr);
+
+private slots:
+    void newInstance(UAVObject *obj);
+    void updateThread(UAVObject *obj);
+    void updateQueue(UAVObject *obj);
+
+private:
+    //! ThreadStats Task of an instance whose task has stopped
+    static const quint8 NO_TASK = 255;
+
+    void watch(UAVObject *obj);
+    void setRow(QTableWidget *table, int row, const QStringList &cells);
+
+    UAVObjectManager *objManager;
+    QTableWidget *threadTable;
+    QTableWidget *queueTable;
+};
+
+#endif /* THREADSTATSWIDGET_H_ */
+
+/**
+ * @}
+ * @}
+ */
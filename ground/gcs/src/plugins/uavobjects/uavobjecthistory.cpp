@@ -0,0 +1,410 @@
+/**
+ ******************************************************************************
+ * @file       uavobjecthistory.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief Columnar store of recent UAVObject samples
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "uavobjecthistory.h"
+#include "uavobjectmanager.h"
+
+#include <QDateTime>
+#include <QtEndian>
+
+#include <algorithm>
+#include <string.h>
+
+//! Default memory budget for all samples
+#define DEFAULT_BUDGET (64 * 1024 * 1024)
+
+UAVObjectHistory::Window::Window()
+    : type(UAVObjectField::FLOAT32)
+    , m_elementSize(0)
+    , total(0)
+{
+}
+
+int UAVObjectHistory::Window::locate(int i, int *offset) const
+{
+    Q_ASSERT(i >= 0 && i < total);
+
+    // The last span whose start is at or before i
+    int span = std::upper_bound(starts.constBegin(), starts.constEnd(), i) - starts.constBegin() - 1;
+    *offset = i - starts[span];
+    return span;
+}
+
+qint64 UAVObjectHistory::Window::timestamp(int i) const
+{
+    int offset;
+    const Span &span = m_spans[locate(i, &offset)];
+    return span.timestamps[offset];
+}
+
+double UAVObjectHistory::Window::value(int i) const
+{
+    int offset;
+    const Span &span = m_spans[locate(i, &offset)];
+    return decode(span.values + offset * m_elementSize);
+}
+
+double UAVObjectHistory::Window::decode(const char *value) const
+{
+    const uchar *src = reinterpret_cast<const uchar *>(value);
+
+    switch (type) {
+    case UAVObjectField::INT8:
+        return static_cast<qint8>(*src);
+    case UAVObjectField::INT16:
+        return qFromLittleEndian<qint16>(src);
+    case UAVObjectField::INT32:
+        return qFromLittleEndian<qint32>(src);
+    case UAVObjectField::UINT8:
+    case UAVObjectField::ENUM:
+        return *src;
+    case UAVObjectField::UINT16:
+        return qFromLittleEndian<quint16>(src);
+    case UAVObjectField::UINT32:
+        return qFromLittleEndian<quint32>(src);
+    case UAVObjectField::FLOAT32: {
+        quint32 bits = qFromLittleEndian<quint32>(src);
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+    default:
+        return 0;
+    }
+}
+
+qint64 UAVObjectHistory::Chunk::bytes() const
+{
+    qint64 total = 0;
+    if (isCold()) {
+        total += coldTimestamps.size();
+        foreach (const QByteArray &col, coldColumns)
+            total += col.size();
+    } else {
+        total += timestamps.capacity() * sizeof(qint64);
+        foreach (const QByteArray &col, columns)
+            total += col.size();
+    }
+    return total;
+}
+
+/**
+ * @brief UAVObjectHistory::UAVObjectHistory Create a store
+ * @param objMngr If given, every data object of this manager is recorded as
+ * it is updated
+ * @param parent Parent object
+ */
+UAVObjectHistory::UAVObjectHistory(UAVObjectManager *objMngr, QObject *parent)
+    : QObject(parent)
+    , numCold(0)
+    , budget(DEFAULT_BUDGET)
+    , usage(0)
+    , recording(true)
+{
+    if (!objMngr)
+        return;
+
+    connect(objMngr, &UAVObjectManager::newObject, this, &UAVObjectHistory::objectAdded);
+    connect(objMngr, &UAVObjectManager::newInstance, this, &UAVObjectHistory::objectAdded);
+
+    foreach (QVector<UAVDataObject *> instances, objMngr->getDataObjectsVector()) {
+        foreach (UAVDataObject *obj, instances)
+            objectAdded(obj);
+    }
+}
+
+UAVObjectHistory::~UAVObjectHistory()
+{
+    clear();
+}
+
+qint64 UAVObjectHistory::now()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+void UAVObjectHistory::setMemoryBudget(qint64 bytes)
+{
+    budget = bytes;
+    enforceBudget();
+}
+
+void UAVObjectHistory::objectAdded(UAVObject *obj)
+{
+    // Metadata only changes on request, its history isn't interesting
+    if (!qobject_cast<UAVDataObject *>(obj))
+        return;
+
+    connect(obj, &UAVObject::objectUpdated, this, &UAVObjectHistory::objectUpdated,
+            Qt::UniqueConnection);
+}
+
+void UAVObjectHistory::objectUpdated(UAVObject *obj)
+{
+    if (recording)
+        record(obj, now());
+}
+
+UAVObjectHistory::Series *UAVObjectHistory::seriesFor(UAVObject *obj)
+{
+    quint64 k = key(obj->getObjID(), obj->getInstID());
+    Series *s = series.value(k);
+    if (s)
+        return s;
+
+    // Work out where each numeric element sits in the packed object
+    s = new Series;
+    int offset = 0;
+    foreach (UAVObjectField *field, obj->getFields()) {
+        UAVObjectField::FieldType type = field->getType();
+        int numBytes = static_cast<int>(field->getNumBytes());
+        if (type != UAVObjectField::STRING && type != UAVObjectField::BITFIELD) {
+            int size = numBytes / field->getNumElements();
+            for (int i = 0; i < field->getNumElements(); i++) {
+                Column col = { field->getName(), i, type, size, offset + i * size };
+                s->columns.append(col);
+            }
+        }
+        offset += numBytes;
+    }
+    s->packedSize = offset;
+
+    series.insert(k, s);
+    return s;
+}
+
+void UAVObjectHistory::record(UAVObject *obj, qint64 timestamp)
+{
+    Series *s = seriesFor(obj);
+    if (s->columns.isEmpty())
+        return;
+
+    Chunk *chunk = s->chunks.isEmpty() ? nullptr : s->chunks.last();
+    if (chunk && timestamp < chunk->last)
+        timestamp = chunk->last;
+
+    if (!chunk || chunk->count == CHUNK_SAMPLES) {
+        if (chunk)
+            seal(chunk);
+
+        chunk = new Chunk;
+        chunk->series = s;
+        chunk->count = 0;
+        chunk->first = timestamp;
+        chunk->timestamps.reserve(CHUNK_SAMPLES);
+        chunk->columns.reserve(s->columns.size());
+        foreach (const Column &col, s->columns)
+            chunk->columns.append(QByteArray(CHUNK_SAMPLES * col.size, Qt::Uninitialized));
+        s->chunks.append(chunk);
+        usage += chunk->bytes();
+    }
+
+    packBuffer.resize(s->packedSize);
+    obj->pack(reinterpret_cast<quint8 *>(packBuffer.data()));
+
+    // Scatter the packed object into the columns
+    const char *packed = packBuffer.constData();
+    for (int i = 0; i < s->columns.size(); i++) {
+        const Column &col = s->columns[i];
+        memcpy(chunk->columns[i].data() + chunk->count * col.size, packed + col.offset, col.size);
+    }
+    chunk->timestamps.append(timestamp);
+    chunk->last = timestamp;
+    chunk->count++;
+
+    if (usage > budget)
+        enforceBudget();
+}
+
+void UAVObjectHistory::seal(Chunk *chunk)
+{
+    sealed.append(chunk);
+}
+
+void UAVObjectHistory::compress(Chunk *chunk)
+{
+    usage -= chunk->bytes();
+
+    chunk->coldTimestamps =
+        qCompress(reinterpret_cast<const uchar *>(chunk->timestamps.constData()),
+                  chunk->count * static_cast<int>(sizeof(qint64)));
+    chunk->timestamps = QVector<qint64>();
+
+    chunk->coldColumns.reserve(chunk->columns.size());
+    foreach (const QByteArray &col, chunk->columns)
+        chunk->coldColumns.append(qCompress(col));
+    chunk->columns.clear();
+
+    usage += chunk->bytes();
+}
+
+void UAVObjectHistory::enforceBudget()
+{
+    // First trade CPU for memory on the oldest chunks
+    while (usage > budget && numCold < sealed.size())
+        compress(sealed[numCold++]);
+
+    // Then forget the oldest ones altogether
+    while (usage > budget && numCold > 0) {
+        Chunk *chunk = sealed.takeFirst();
+        numCold--;
+
+        // Chunks of a series are sealed in order, so this is its first one
+        Q_ASSERT(chunk->series->chunks.first() == chunk);
+        chunk->series->chunks.removeFirst();
+
+        usage -= chunk->bytes();
+        delete chunk;
+    }
+}
+
+UAVObjectHistory::Window UAVObjectHistory::query(UAVObjectField *field, int element, qint64 from,
+                                                 qint64 to) const
+{
+    UAVObject *obj = field->getObject();
+    return query(obj->getObjID(), obj->getInstID(), field->getName(), element, from, to);
+}
+
+UAVObjectHistory::Window UAVObjectHistory::query(quint32 objId, quint32 instId,
+                                                 const QString &fieldName, int element,
+                                                 qint64 from, qint64 to) const
+{
+    Window window;
+
+    Series *s = series.value(key(objId, instId));
+    if (!s)
+        return window;
+
+    int column = -1;
+    for (int i = 0; i < s->columns.size(); i++) {
+        if (s->columns[i].element == element && s->columns[i].field == fieldName) {
+            column = i;
+            break;
+        }
+    }
+    if (column < 0)
+        return window;
+
+    window.type = s->columns[column].type;
+    window.m_elementSize = s->columns[column].size;
+
+    foreach (Chunk *chunk, s->chunks) {
+        if (chunk->last < from)
+            continue;
+        if (chunk->first > to)
+            break;
+
+        QVector<qint64> times;
+        QByteArray values;
+        const qint64 *begin;
+        const char *data;
+        if (chunk->isCold()) {
+            QByteArray raw = qUncompress(chunk->coldTimestamps);
+            times.resize(chunk->count);
+            memcpy(times.data(), raw.constData(), chunk->count * sizeof(qint64));
+            values = qUncompress(chunk->coldColumns[column]);
+            begin = times.constData();
+            data = values.constData();
+        } else {
+            begin = chunk->timestamps.constData();
+            data = chunk->columns[column].constData();
+        }
+
+        const qint64 *end = begin + chunk->count;
+        const qint64 *lo = std::lower_bound(begin, end, from);
+        const qint64 *hi = std::upper_bound(lo, end, to);
+        if (lo == hi)
+            continue;
+
+        int first = lo - begin;
+        int count = hi - lo;
+
+        Span span;
+        span.count = count;
+
+        if (chunk->isCold() || chunk->count == CHUNK_SAMPLES) {
+            // Full chunks are never written again, so share their storage
+            if (!chunk->isCold()) {
+                times = chunk->timestamps;
+                values = chunk->columns[column];
+            }
+            span.timestamps = times.constData() + first;
+            span.values = values.constData() + first * window.m_elementSize;
+        } else {
+            // record() writes the open chunk in place, which would detach and
+            // deep copy all of its columns if the window shared them, so
+            // copy just the samples the window covers
+            times.resize(count);
+            memcpy(times.data(), lo, count * sizeof(qint64));
+            values = QByteArray(data + first * window.m_elementSize,
+                                count * window.m_elementSize);
+            span.timestamps = times.constData();
+            span.values = values.constData();
+        }
+
+        window.starts.append(window.total);
+        window.m_spans.append(span);
+        window.total += span.count;
+        window.timeRefs.append(times);
+        window.valueRefs.append(values);
+    }
+
+    return window;
+}
+
+void UAVObjectHistory::takeSamples(UAVObjectHistory *other)
+{
+    clear();
+
+    series.swap(other->series);
+    sealed.swap(other->sealed);
+    std::swap(numCold, other->numCold);
+    std::swap(usage, other->usage);
+
+    enforceBudget();
+}
+
+void UAVObjectHistory::clear()
+{
+    foreach (Series *s, series) {
+        qDeleteAll(s->chunks);
+        delete s;
+    }
+    series.clear();
+    sealed.clear();
+    numCold = 0;
+    usage = 0;
+
+    emit cleared();
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,235 @@
+/**
+ ******************************************************************************
+ * @file       uavobjecthistory.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief Columnar store of recent UAVObject samples
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef UAVOBJECTHISTORY_H
+#define UAVOBJECTHISTORY_H
+
+#include "uavobjects_global.h"
+#include "uavobjectfield.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QVector>
+
+class UAVObject;
+class UAVObjectManager;
+
+/**
+ * @brief Keeps the recent history of every numeric UAVObject field element so
+ * gadgets can ask for "the last N seconds of X" instead of each accumulating
+ * their own copies.
+ *
+ * Samples are stored per object instance in chunks of CHUNK_SAMPLES, with one
+ * timestamp column and one column per field element in the element's packed
+ * (little endian) type. Once the memory budget is exceeded the oldest full
+ * chunks are compressed, and after that the oldest compressed chunks are
+ * dropped.
+ *
+ * Timestamps are milliseconds, see now(). Samples of one object instance must
+ * be recorded in time order, earlier timestamps are clamped to the last one.
+ *
+ * Not thread safe, use from the GUI thread only.
+ */
+class UAVOBJECTS_EXPORT UAVObjectHistory : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Samples of one object instance per chunk
+    static const int CHUNK_SAMPLES = 512;
+
+    //! A contiguous run of samples within one chunk
+    struct Span
+    {
+        const qint64 *timestamps;
+        //! Packed element values, elementSize bytes apart
+        const char *values;
+        int count;
+    };
+
+    /**
+     * @brief The samples of one element over a time range. Spans over full
+     * chunks point directly into them and share their storage, and samples
+     * from the chunk still filling up are copied, so a window stays valid
+     * after the store moves on without slowing down recording.
+     */
+    class UAVOBJECTS_EXPORT Window
+    {
+    public:
+        Window();
+
+        int size() const { return total; }
+        bool isEmpty() const { return total == 0; }
+        qint64 timestamp(int i) const;
+        double value(int i) const;
+
+        const QVector<Span> &spans() const { return m_spans; }
+        UAVObjectField::FieldType fieldType() const { return type; }
+        int elementSize() const { return m_elementSize; }
+
+        //! Decode a single packed value of the window's type
+        double decode(const char *value) const;
+
+    private:
+        friend class UAVObjectHistory;
+
+        int locate(int i, int *offset) const;
+
+        QVector<Span> m_spans;
+        QVector<int> starts;
+        // Shallow copies which keep the chunk data alive
+        QList<QVector<qint64>> timeRefs;
+        QList<QByteArray> valueRefs;
+        UAVObjectField::FieldType type;
+        int m_elementSize;
+        int total;
+    };
+
+    UAVObjectHistory(UAVObjectManager *objMngr = nullptr, QObject *parent = nullptr);
+    ~UAVObjectHistory();
+
+    //! Current time on the history's clock, in milliseconds since the epoch
+    static qint64 now();
+
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const { return budget; }
+    qint64 memoryUsage() const { return usage; }
+
+    /**
+     * @brief setRecording Enable or disable recording of live object updates,
+     * for instance while a log is being replayed from a bulk load
+     */
+    void setRecording(bool enabled) { recording = enabled; }
+    bool isRecording() const { return recording; }
+
+    /**
+     * @brief record Append the current contents of an object
+     * @param obj Data object to sample
+     * @param timestamp Sample time in milliseconds
+     */
+    void record(UAVObject *obj, qint64 timestamp);
+
+    /**
+     * @brief query Get the samples of one field element
+     * @param objId Object ID
+     * @param instId Object instance
+     * @param fieldName Name of the field
+     * @param element Element index within the field
+     * @param from Start of the range, inclusive
+     * @param to End of the range, inclusive
+     * @return Window over the samples, empty if there are none or the field
+     * isn't numeric
+     */
+    Window query(quint32 objId, quint32 instId, const QString &fieldName, int element, qint64 from,
+                 qint64 to) const;
+    Window query(UAVObjectField *field, int element, qint64 from, qint64 to) const;
+
+    //! Drop all samples
+    void clear();
+
+    /**
+     * @brief takeSamples Replace the samples with another store's, leaving
+     * it empty. Lets a store filled on a worker thread be handed over
+     * without copying.
+     * @param other The store to take from, no longer used by its thread
+     */
+    void takeSamples(UAVObjectHistory *other);
+
+signals:
+    void cleared();
+
+private slots:
+    void objectAdded(UAVObject *obj);
+    void objectUpdated(UAVObject *obj);
+
+private:
+    struct Column
+    {
+        QString field;
+        int element;
+        UAVObjectField::FieldType type;
+        int size;
+        int offset;
+    };
+
+    struct Series;
+
+    struct Chunk
+    {
+        Series *series;
+        int count;
+        qint64 first;
+        qint64 last;
+        QVector<qint64> timestamps;
+        QVector<QByteArray> columns;
+        // Cold chunks hold their columns here instead, each one compressed
+        // separately so a query only inflates what it reads
+        QByteArray coldTimestamps;
+        QVector<QByteArray> coldColumns;
+
+        bool isCold() const { return !coldTimestamps.isEmpty(); }
+        qint64 bytes() const;
+    };
+
+    struct Series
+    {
+        QVector<Column> columns;
+        int packedSize;
+        QList<Chunk *> chunks;
+    };
+
+    Series *seriesFor(UAVObject *obj);
+    void seal(Chunk *chunk);
+    void compress(Chunk *chunk);
+    void enforceBudget();
+
+    static quint64 key(quint32 objId, quint32 instId)
+    {
+        return (static_cast<quint64>(objId) << 32) | instId;
+    }
+
+    QHash<quint64, Series *> series;
+    // Full chunks of all series in the order they filled up, which is
+    // oldest first. The first numCold of them are compressed.
+    QList<Chunk *> sealed;
+    int numCold;
+    qint64 budget;
+    qint64 usage;
+    bool recording;
+    QByteArray packBuffer;
+};
+
+#endif // UAVOBJECTHISTORY_H
+
+/**
+ * @}
+ * @}
+ */
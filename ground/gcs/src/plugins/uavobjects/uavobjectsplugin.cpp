@@ -26,6 +26,7 @@
  */
 #include "uavobjectsplugin.h"
 #include "uavobjectsinit.h"
+#include "uavobjecthistory.h"
 
 UAVObjectsPlugin::UAVObjectsPlugin()
 {
@@ -46,6 +47,8 @@ bool UAVObjectsPlugin::initialize(const QStringList &arguments, QString *errorSt
     addAutoReleasedObject(objMngr);
     // Initialize UAVObjects
     UAVObjectsInitialize(objMngr);
+    // Keep the recent history of every object for the gadgets to query
+    addAutoReleasedObject(new UAVObjectHistory(objMngr));
     // Done
     Q_UNUSED(arguments);
     Q_UNUSED(errorString);
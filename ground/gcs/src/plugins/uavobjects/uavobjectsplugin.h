@@ -49,6 +49,8 @@ public:
 private Q_SLOTS:
     void testEnumFields();
     void testIntFields();
+    void testHistoryQuery();
+    void testHistoryBudget();
 #endif
 };
 
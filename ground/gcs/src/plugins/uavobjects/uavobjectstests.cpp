@@ -31,6 +31,9 @@
 
 #include "uavdataobject.h"
 #include "uavobjectfield.h"
+#include "uavobjecthistory.h"
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
 
 #include <QTest>
 #include <memory>
@@ -64,6 +67,86 @@ void UAVObjectsPlugin::testIntFields()
     QVERIFY(field->isDefaultValue(1));
 }
 
+static void recordGyros(UAVObjectHistory &history, UAVObject *obj, int from, int count)
+{
+    UAVObjectField *x = obj->getField("x");
+    for (int i = from; i < from + count; i++) {
+        x->setValue(i * 0.5, 0);
+        history.record(obj, i * 10);
+    }
+}
+
+void UAVObjectsPlugin::testHistoryQuery()
+{
+    UAVObjectManager objMngr;
+    UAVObjectsInitialize(&objMngr);
+    UAVObject *obj = objMngr.getObject("Gyros");
+    QVERIFY(obj);
+
+    UAVObjectHistory history;
+    int samples = UAVObjectHistory::CHUNK_SAMPLES * 2 + 10;
+    recordGyros(history, obj, 0, samples);
+
+    // Everything, across chunk boundaries
+    UAVObjectHistory::Window all = history.query(obj->getField("x"), 0, 0, samples * 10);
+    QCOMPARE(all.size(), samples);
+    QCOMPARE(all.spans().size(), 3);
+    for (int i = 0; i < samples; i++) {
+        QCOMPARE(all.timestamp(i), qint64(i * 10));
+        QCOMPARE(all.value(i), i * 0.5);
+    }
+
+    // Inclusive range in the middle of a chunk
+    UAVObjectHistory::Window part = history.query(obj->getField("x"), 0, 95, 190);
+    QCOMPARE(part.size(), 10);
+    QCOMPARE(part.timestamp(0), qint64(100));
+    QCOMPARE(part.value(9), 19 * 0.5);
+
+    // Recording into the open chunk leaves a window over it alone
+    UAVObjectHistory::Window open = history.query(obj->getField("x"), 0, 0, samples * 10);
+    recordGyros(history, obj, samples, 5);
+    QCOMPARE(open.size(), samples);
+    QCOMPARE(open.value(samples - 1), (samples - 1) * 0.5);
+    QCOMPARE(history.query(obj->getField("x"), 0, 0, (samples + 5) * 10).size(), samples + 5);
+
+    // The window keeps its data after the store is cleared
+    history.clear();
+    QCOMPARE(part.value(0), 10 * 0.5);
+    QVERIFY(history.query(obj->getField("x"), 0, 0, samples * 10).isEmpty());
+
+    // Unknown fields and elements give nothing
+    recordGyros(history, obj, 0, 1);
+    QVERIFY(history.query(obj->getObjID(), 0, "nope", 0, 0, 10).isEmpty());
+    QVERIFY(history.query(obj->getField("x"), 1, 0, 10).isEmpty());
+}
+
+void UAVObjectsPlugin::testHistoryBudget()
+{
+    UAVObjectManager objMngr;
+    UAVObjectsInitialize(&objMngr);
+    UAVObject *obj = objMngr.getObject("Gyros");
+    QVERIFY(obj);
+
+    UAVObjectHistory history;
+    recordGyros(history, obj, 0, UAVObjectHistory::CHUNK_SAMPLES);
+    qint64 hotChunk = history.memoryUsage();
+    QVERIFY(hotChunk > 0);
+
+    // Room for two full chunks; the oldest gets compressed but stays readable
+    history.setMemoryBudget(hotChunk * 2 - 1);
+    recordGyros(history, obj, UAVObjectHistory::CHUNK_SAMPLES, UAVObjectHistory::CHUNK_SAMPLES + 1);
+    QVERIFY(history.memoryUsage() <= history.memoryBudget());
+    UAVObjectHistory::Window all = history.query(obj->getField("x"), 0, 0, Q_INT64_C(1) << 40);
+    QCOMPARE(all.size(), UAVObjectHistory::CHUNK_SAMPLES * 2 + 1);
+    QCOMPARE(all.value(3), 3 * 0.5);
+
+    // Too little room for anything but the open chunk drops the old ones
+    history.setMemoryBudget(hotChunk);
+    all = history.query(obj->getField("x"), 0, 0, Q_INT64_C(1) << 40);
+    QCOMPARE(all.size(), 1);
+    QCOMPARE(all.timestamp(0), qint64(UAVObjectHistory::CHUNK_SAMPLES * 2 * 10));
+}
+
 /**
  * @}
  * @}
@@ -39,10 +39,11 @@
 #include <coreplugin/icore.h>
 #include <uavsettingsimportexport/uavsettingsimportexportmanager.h>
 #include <uavtalk/telemetrymanager.h>
+#include <utils/displayinfo.h>
 #include <utils/longlongspinbox.h>
 
-#include <QWidget>
 #include <QLineEdit>
+#include <QWidget>
 
 /**
  * Constructor
@@ -54,6 +55,8 @@ ConfigTaskWidget::ConfigTaskWidget(QWidget *parent)
     , allowWidgetUpdates(true)
     , smartsave(NULL)
     , dirty(false)
+    , refreshTimer(new QTimer(this))
+    , refreshingWidgets(false)
     , outOfLimitsStyle("background-color: rgb(255, 180, 0);")
     , timeOut(NULL)
 {
@@ -70,6 +73,12 @@ ConfigTaskWidget::ConfigTaskWidget(QWidget *parent)
     UAVSettingsImportExportManager *importexportplugin =
         pm->getObject<UAVSettingsImportExportManager>();
     connect(importexportplugin, SIGNAL(importAboutToBegin()), this, SLOT(invalidateObjects()));
+
+    // Object updates arrive far faster than anyone can read the widgets, so
+    // they are batched and applied at most once per displayed frame
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(Utils::DisplayInfo::framePeriod());
+    connect(refreshTimer, &QTimer::timeout, this, &ConfigTaskWidget::flushPendingRefreshes);
 }
 
 /**
@@ -156,7 +165,7 @@ void ConfigTaskWidget::addUAVObjectToWidgetRelation(QString object, QString fiel
         objectUpdates.insert(obj, true);
         connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)));
         connect(obj, SIGNAL(objectUpdated(UAVObject *)), this,
-                SLOT(refreshWidgetsValues(UAVObject *)), Qt::UniqueConnection);
+                SLOT(scheduleRefresh(UAVObject *)), Qt::UniqueConnection);
         UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
         if (dobj) {
             connect(dobj, SIGNAL(presentOnHardwareChanged(UAVDataObject *)), this,
@@ -373,16 +382,68 @@ void ConfigTaskWidget::refreshWidgetsValues(UAVObject *obj)
     if (!allowWidgetUpdates)
         return;
 
+    // a full refresh covers anything still waiting for the next frame
+    if (!obj)
+        pendingRefreshes.clear();
+
     bool dirtyBack = dirty;
     emit refreshWidgetsValuesRequested();
+    bool wasRefreshing = refreshingWidgets;
+    refreshingWidgets = true;
     foreach (objectToWidget *ow, objOfInterest) {
-        if (ow->object && ow->field && ow->widget && (ow->object == obj || !obj))
-            setWidgetFromField(ow->widget, ow->field, ow->index, ow->scale, ow->isLimited,
-                               ow->useUnits);
+        if (!ow->object || !ow->field || !ow->widget || (obj && ow->object != obj))
+            continue;
+
+        // an update of one object only needs to touch the widgets whose
+        // element actually changed
+        QVariant value = ow->field->getValue(ow->index);
+        if (obj && ow->lastValue.isValid() && ow->lastValue == value)
+            continue;
+
+        if (setWidgetFromField(ow->widget, ow->field, ow->index, ow->scale, ow->isLimited,
+                               ow->useUnits))
+            ow->lastValue = value;
+        else
+            ow->lastValue = QVariant();
     }
+    refreshingWidgets = wasRefreshing;
     setDirty(dirtyBack);
 }
 
+/**
+ * SLOT function called when a bound object is updated, queues the object for
+ * the next frame refresh
+ * @param obj pointer to the object which has just been updated
+ */
+void ConfigTaskWidget::scheduleRefresh(UAVObject *obj)
+{
+    pendingRefreshes.insert(obj);
+
+    // hidden pages are caught up when they are shown
+    if (isVisible() && !refreshTimer->isActive())
+        refreshTimer->start();
+}
+
+void ConfigTaskWidget::flushPendingRefreshes()
+{
+    if (!isVisible() || pendingRefreshes.isEmpty())
+        return;
+
+    QSet<UAVObject *> objs;
+    objs.swap(pendingRefreshes);
+    foreach (UAVObject *obj, objs)
+        refreshWidgetsValues(obj);
+}
+
+bool ConfigTaskWidget::event(QEvent *evt)
+{
+    // subclasses override showEvent without chaining up, so catch it here
+    if (evt->type() == QEvent::Show)
+        flushPendingRefreshes();
+
+    return QWidget::event(evt);
+}
+
 /**
  * SLOT function used to update the uavobject fields from widgets with relation to
  * object field added to the framework pool
@@ -483,6 +544,9 @@ void ConfigTaskWidget::widgetsContentsChanged()
     double scale = 0;
     objectToWidget *oTw = shadowsList.value(dynamic_cast<QWidget *>(sender()), NULL);
     if (oTw) {
+        // the widget no longer shows what the last refresh wrote
+        if (!refreshingWidgets)
+            oTw->lastValue = QVariant();
         if (oTw->widget == dynamic_cast<QWidget *>(sender())) {
             scale = oTw->scale;
             checkWidgetsLimits(static_cast<QWidget *>(sender()), oTw->field, oTw->index,
@@ -570,8 +634,9 @@ void ConfigTaskWidget::disableObjUpdates()
     foreach (objectToWidget *obj, objOfInterest) {
         if (obj->object)
             disconnect(obj->object, SIGNAL(objectUpdated(UAVObject *)), this,
-                       SLOT(refreshWidgetsValues(UAVObject *)));
+                       SLOT(scheduleRefresh(UAVObject *)));
     }
+    pendingRefreshes.clear();
 }
 /**
  * SLOT function used to enable widget contents changes when related object field changes
@@ -582,7 +647,7 @@ void ConfigTaskWidget::enableObjUpdates()
     foreach (objectToWidget *obj, objOfInterest) {
         if (obj->object)
             connect(obj->object, SIGNAL(objectUpdated(UAVObject *)), this,
-                    SLOT(refreshWidgetsValues(UAVObject *)), Qt::UniqueConnection);
+                    SLOT(scheduleRefresh(UAVObject *)), Qt::UniqueConnection);
     }
 }
 /**
@@ -44,6 +44,8 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QEvent>
+#include <QSet>
+#include <QTimer>
 
 class UAVObject;
 class UAVDataObject;
@@ -75,6 +77,9 @@ public:
         bool useUnits;
         bool oneWayBind;
         QList<shadow *> shadowsList;
+        // field value last written to the widget by a refresh, invalid if the
+        // widget has been changed by anything else since
+        QVariant lastValue;
     };
 
     struct temphelper
@@ -208,6 +213,7 @@ signals:
 
 private slots:
     void objectUpdated(UAVObject *);
+    void scheduleRefresh(UAVObject *obj);
     void defaultButtonClicked();
     void reloadButtonClicked();
     void rebootButtonClicked();
@@ -231,6 +237,9 @@ private:
     QList<QPushButton *> rebootButtonList;
     QList<QPushButton *> connectionsButtonList;
     bool dirty;
+    QSet<UAVObject *> pendingRefreshes;
+    QTimer *refreshTimer;
+    bool refreshingWidgets;
     bool setFieldFromWidget(QWidget *widget, UAVObjectField *field, int index, double scale,
                             bool usesUnits = false);
     /**
@@ -297,8 +306,15 @@ protected slots:
     virtual void refreshWidgetsValues(UAVObject *obj = NULL);
     virtual void updateObjectsFromWidgets();
     virtual void helpButtonPressed();
+    /**
+     * @brief flushPendingRefreshes Refresh the widgets of every object updated since the
+     * last frame. Does nothing while the widget is hidden, the objects stay pending until
+     * it is shown again.
+     */
+    void flushPendingRefreshes();
 
 protected:
+    virtual bool event(QEvent *evt);
     virtual void enableControls(bool enable);
     void checkWidgetsLimits(QWidget *widget, UAVObjectField *field, int index, bool hasLimits,
                             bool useUnits, QVariant value, double scale);
@@ -32,6 +32,10 @@ SOURCES += uavobjectwidgetutilsplugin.cpp \
     popupwidget.cpp \
     connectiondiagram.cpp
 
+contains(DEFINES, WITH_TESTS) {
+    SOURCES += uavobjectwidgetutilstests.cpp
+}
+
 OTHER_FILES += UAVObjectWidgetUtils.pluginspec
 
 FORMS += connectiondiagram.ui
@@ -45,6 +45,13 @@ public:
     virtual void extensionsInitialized() override;
     virtual bool initialize(const QStringList &arguments, QString *errorString) override;
     virtual void shutdown() override;
+
+#ifdef WITH_TESTS
+private Q_SLOTS:
+    void testRefreshHiddenWidget();
+    void benchmarkRefreshPerUpdate();
+    void benchmarkRefreshCoalesced();
+#endif
 };
 
 #endif
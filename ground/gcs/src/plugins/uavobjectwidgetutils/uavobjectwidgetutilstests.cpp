@@ -0,0 +1,138 @@
+/**
+ ******************************************************************************
+ * @file       uavobjectwidgetutilstests.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectWidgetUtils Plugin
+ * @{
+ * @brief Utility plugin for UAVObject to Widget relation management
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "uavobjectwidgetutilsplugin.h"
+#include "configtaskwidget.h"
+
+#include "uavobjectmanager.h"
+#include "uavobject.h"
+#include "uavobjectfield.h"
+
+#include <QSpinBox>
+#include <QTest>
+#include <QVBoxLayout>
+
+//! Updates per benchmark iteration, roughly one second of a fast stream
+#define UPDATES_PER_ITERATION 100
+
+namespace {
+
+//! Exposes the refresh entry points so the two paths can be timed directly
+class RefreshTestWidget : public ConfigTaskWidget
+{
+public:
+    RefreshTestWidget()
+        : ConfigTaskWidget()
+    {
+        obj = getObjectManager()->getObject(QStringLiteral("ManualControlCommand"));
+        field = obj->getField(QStringLiteral("Channel"));
+
+        QVBoxLayout *layout = new QVBoxLayout(this);
+        for (int i = 0; i < field->getNumElements(); i++) {
+            QSpinBox *sb = new QSpinBox(this);
+            sb->setMaximum(65535);
+            layout->addWidget(sb);
+            spinBoxes.append(sb);
+            addUAVObjectToWidgetRelation(obj->getName(), field->getName(), sb, i);
+        }
+    }
+
+    using ConfigTaskWidget::flushPendingRefreshes;
+    using ConfigTaskWidget::refreshWidgetsValues;
+
+    //! Simulate a telemetry update in which only the first channel moved
+    void update(int value)
+    {
+        field->setValue(value, 0);
+        obj->updated();
+    }
+
+    UAVObject *obj;
+    UAVObjectField *field;
+    QList<QSpinBox *> spinBoxes;
+};
+}
+
+void UAVObjectWidgetUtilsPlugin::testRefreshHiddenWidget()
+{
+    RefreshTestWidget widget;
+
+    widget.update(1000);
+    QVERIFY(widget.spinBoxes[0]->value() != 1000);
+
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+    QCOMPARE(widget.spinBoxes[0]->value(), 1000);
+
+    widget.update(1500);
+    widget.flushPendingRefreshes();
+    QCOMPARE(widget.spinBoxes[0]->value(), 1500);
+
+    widget.hide();
+    widget.update(2000);
+    widget.flushPendingRefreshes();
+    QCOMPARE(widget.spinBoxes[0]->value(), 1500);
+}
+
+void UAVObjectWidgetUtilsPlugin::benchmarkRefreshPerUpdate()
+{
+    RefreshTestWidget widget;
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+
+    // the old path: every update rewrites every bound widget straight away
+    int value = 0;
+    QBENCHMARK {
+        for (int i = 0; i < UPDATES_PER_ITERATION; i++) {
+            widget.field->setValue(++value % 2000, 0);
+            widget.refreshWidgetsValues();
+        }
+    }
+}
+
+void UAVObjectWidgetUtilsPlugin::benchmarkRefreshCoalesced()
+{
+    RefreshTestWidget widget;
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+
+    // updates are queued and the frame timer writes the changed widgets once
+    int value = 0;
+    QBENCHMARK {
+        for (int i = 0; i < UPDATES_PER_ITERATION; i++)
+            widget.update(++value % 2000);
+        widget.flushPendingRefreshes();
+    }
+    QCOMPARE(widget.spinBoxes[0]->value(), value % 2000);
+}
+
+/**
+ * @}
+ * @}
+ */
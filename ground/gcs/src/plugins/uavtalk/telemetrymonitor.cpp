@@ -4,7 +4,7 @@
  * @file       telemetrymonitor.cpp
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2010.
  * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
- * @author     dRonin, http://dronin.org Copyright (C) 2015-2016
+ * @author     dRonin, http://dronin.org Copyright (C) 2015-2017
  * @addtogroup GCSPlugins GCS Plugins
  * @{
  * @addtogroup UAVTalkPlugin UAVTalk Plugin
@@ -34,12 +34,22 @@
 #include "coreplugin/connectionmanager.h"
 #include "coreplugin/icore.h"
 #include "firmwareiapobj.h"
+#include "objectmanifest.h"
+#include "utils/pathutils.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 
 // Timeout for the object fetching phase, the system will stop fetching objects and emit connected
 // after this
 #define OBJECT_RETRIEVE_TIMEOUT 20000
 // IAP object is very important, retry if not able to get it the first time
 #define IAP_OBJECT_RETRIES 3
+// Identifies the object cache file format
+#define OBJECT_CACHE_MAGIC 0x55414f43
+#define OBJECT_CACHE_VERSION 1
 
 #ifdef TELEMETRYMONITOR_DEBUG
 #define TELEMETRYMONITOR_QXTLOG_DEBUG(...) qDebug() << __VA_ARGS__
@@ -99,6 +109,8 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel)
     , tel(tel)
     , queue(decltype(queue)(queueCompare))
     , requestsInFlight(0)
+    , manifestTotal(0)
+    , objectsFromCache(0)
 {
     this->connectionTimer = new QTime();
     // Get stats objects
@@ -115,6 +127,9 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel)
     connect(statsTimer, &QTimer::timeout, this, &TelemetryMonitor::processStatsUpdates);
     connect(objectRetrieveTimeout, &QTimer::timeout, this,
             &TelemetryMonitor::objectRetrieveTimeoutCB);
+    manifestTimeout = new QTimer(this);
+    manifestTimeout->setSingleShot(true);
+    connect(manifestTimeout, &QTimer::timeout, this, &TelemetryMonitor::manifestTimeoutCB);
     statsTimer->start(STATS_CONNECT_PERIOD_MS);
 
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
@@ -145,7 +160,9 @@ TelemetryMonitor::~TelemetryMonitor()
 }
 
 /**
- * Initiate object retrieval, initialize queue with objects to be retrieved.
+ * Initiate object retrieval.  The board description is fetched first, to
+ * find the cache of this board's objects, then the object manifest, to
+ * tell which objects changed since they were cached.
  */
 void TelemetryMonitor::startRetrievingObjects()
 {
@@ -156,7 +173,28 @@ void TelemetryMonitor::startRetrievingObjects()
     /* Clear the queue */
     queue = decltype(queue)(queueCompare);
 
+    manifest.clear();
+    manifestTotal = 0;
+    cacheFileName.clear();
+    objectsFromCache = 0;
+    retrieveTime.start();
+
     objectRetrieveTimeout->start(OBJECT_RETRIEVE_TIMEOUT);
+
+    FirmwareIAPObj *iapObj = FirmwareIAPObj::GetInstance(objMngr);
+
+    requestsInFlight++;
+
+    connect(iapObj, QOverload<UAVObject *, bool, bool>::of(&UAVObject::transactionCompleted),
+            this, &TelemetryMonitor::firmwareIAPCompleted);
+    iapObj->requestUpdate();
+}
+
+/**
+ * Queue every known object for retrieval, and start retrieving them.
+ */
+void TelemetryMonitor::enqueueAllObjects()
+{
     foreach (UAVObjectManager::ObjectMap map, objMngr->getObjects().values()) {
         UAVObject *obj = map.first();
 
@@ -172,6 +210,251 @@ void TelemetryMonitor::startRetrievingObjects()
     retrieveNextObject();
 }
 
+/**
+ * Called when the board description arrives; names the cache file and asks
+ * for the object manifest.
+ */
+void TelemetryMonitor::firmwareIAPCompleted(UAVObject *obj, bool success, bool nacked)
+{
+    Q_UNUSED(nacked);
+
+    requestsInFlight--;
+    obj->disconnect(this);
+
+    if (connectionStatus != CON_RETRIEVING_OBJECTS)
+        return;
+
+    FirmwareIAPObj *iapObj = qobject_cast<FirmwareIAPObj *>(obj);
+    QByteArray description;
+    QByteArray serial;
+
+    if (success && iapObj) {
+        FirmwareIAPObj::DataFields iapData = iapObj->getData();
+
+        for (unsigned int i = 0; i < FirmwareIAPObj::DESCRIPTION_NUMELEM; i++)
+            description.append(iapData.Description[i]);
+        for (unsigned int i = 0; i < FirmwareIAPObj::CPUSERIAL_NUMELEM; i++)
+            serial.append(iapData.CPUSerial[i]);
+    }
+
+    // Only firmware with a proper description carries the UAVO hash
+    if (!description.startsWith("TlFw") && !description.startsWith("OpFw")) {
+        enqueueAllObjects();
+        return;
+    }
+
+    cacheFileName = Utils::PathUtils().GetStoragePath() + "objectcache" + QDir::separator()
+        + QString("%1-%2.dat").arg(QString(serial.toHex())).arg(QString(description.mid(60, 20).toHex()));
+
+    ObjectManifest *manifestObj = ObjectManifest::GetInstance(objMngr);
+
+    connect(manifestObj, &UAVObject::objectUpdated, this, &TelemetryMonitor::manifestUpdated);
+    connect(manifestObj, QOverload<UAVObject *, bool, bool>::of(&UAVObject::transactionCompleted),
+            this, &TelemetryMonitor::manifestCompleted);
+
+    manifestTimeout->start(MANIFEST_TIMEOUT_MS);
+    manifestObj->requestUpdate();
+}
+
+/**
+ * Called when the manifest request completes.  Firmware without a manifest
+ * nacks it; fall back to fetching everything.
+ */
+void TelemetryMonitor::manifestCompleted(UAVObject *obj, bool success, bool nacked)
+{
+    Q_UNUSED(obj);
+    Q_UNUSED(nacked);
+
+    if (!success && manifestTimeout->isActive()) {
+        stopManifest();
+
+        if (connectionStatus == CON_RETRIEVING_OBJECTS)
+            enqueueAllObjects();
+    }
+}
+
+/**
+ * Collects the entries of the manifest as they stream in.
+ */
+void TelemetryMonitor::manifestUpdated(UAVObject *obj)
+{
+    ObjectManifest *manifestObj = qobject_cast<ObjectManifest *>(obj);
+
+    if (!manifestObj || !manifestTimeout->isActive())
+        return;
+
+    ObjectManifest::DataFields data = manifestObj->getData();
+
+    manifestTotal = data.Total;
+
+    for (int i = 0; i < (int)ObjectManifest::OBJID_NUMELEM; i++) {
+        if (data.Start + i >= data.Total)
+            break;
+
+        ManifestEntry entry = { data.Instances[i], data.CRC[i] };
+
+        manifest.insert(data.ObjID[i], entry);
+    }
+
+    if (manifest.size() >= manifestTotal) {
+        stopManifest();
+        applyManifest();
+    }
+}
+
+void TelemetryMonitor::manifestTimeoutCB()
+{
+    qInfo() << QString("%0 incomplete object manifest, retrieving all objects").arg(Q_FUNC_INFO);
+
+    stopManifest();
+
+    if (connectionStatus == CON_RETRIEVING_OBJECTS)
+        enqueueAllObjects();
+}
+
+void TelemetryMonitor::stopManifest()
+{
+    manifestTimeout->stop();
+    ObjectManifest::GetInstance(objMngr)->disconnect(this);
+}
+
+/**
+ * CRC32 of the packed instances of an object, the same as the flight side
+ * computes for the manifest.
+ */
+quint32 TelemetryMonitor::contentCRC(const QList<QByteArray> &instances)
+{
+    quint32 crc = 0xFFFFFFFF;
+
+    foreach (const QByteArray &data, instances) {
+        for (int i = 0; i < data.size(); i++) {
+            crc ^= ((quint32)(quint8)data.at(i)) << 24;
+
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc & 0x80000000) ? ((crc << 1) ^ 0x04C11DB7) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * Fills in the objects whose cached contents match the manifest, marks the
+ * objects the board doesn't have, and queues the rest for retrieval.
+ */
+void TelemetryMonitor::applyManifest()
+{
+    QHash<quint32, QList<QByteArray>> cache;
+
+    QFile file(cacheFileName);
+    if (file.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&file);
+        quint32 magic, version;
+
+        stream >> magic >> version;
+        if (magic == OBJECT_CACHE_MAGIC && version == OBJECT_CACHE_VERSION)
+            stream >> cache;
+        if (stream.status() != QDataStream::Ok)
+            cache.clear();
+    }
+
+    foreach (UAVObjectManager::ObjectMap map, objMngr->getObjects().values()) {
+        UAVObject *obj = map.first();
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
+        quint32 objId = obj->getObjID();
+
+        // Already fetched, fresh, on this connection
+        if (objId == FirmwareIAPObj::OBJID || objId == ObjectManifest::OBJID)
+            continue;
+
+        if (!manifest.contains(objId)) {
+            if (dobj)
+                dobj->setIsPresentOnHardware(false);
+            continue;
+        }
+
+        const ManifestEntry &entry = manifest[objId];
+        const QList<QByteArray> cached = cache.value(objId);
+
+        if (cached.size() != entry.instances || contentCRC(cached) != entry.crc) {
+            queue.push(obj);
+            continue;
+        }
+
+        for (int instId = 0; instId < cached.size(); instId++) {
+            UAVObject *instObj = objMngr->getObject(objId, instId);
+
+            if (!instObj && dobj) {
+                UAVDataObject *instdObj = dobj->clone(instId);
+                objMngr->registerObject(instdObj);
+                instObj = instdObj;
+            }
+
+            if (instObj && (int)instObj->getNumBytes() == cached.at(instId).size())
+                instObj->unpack(reinterpret_cast<const quint8 *>(cached.at(instId).constData()));
+        }
+
+        if (dobj) {
+            /* Drop instances the board no longer has */
+            int idx = objMngr->getNumInstances(objId);
+
+            while (idx > entry.instances) {
+                idx--;
+                UAVDataObject *dobjR = dynamic_cast<UAVDataObject *>(
+                        objMngr->getObject(objId, idx));
+                if (dobjR)
+                    objMngr->unRegisterObject(dobjR);
+            }
+
+            dobj->setIsPresentOnHardware(true);
+        }
+
+        objectsFromCache++;
+    }
+
+    TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 %1 objects from cache, %2 to retrieve")
+                                      .arg(Q_FUNC_INFO)
+                                      .arg(objectsFromCache)
+                                      .arg(queue.size()));
+
+    retrieveNextObject();
+}
+
+/**
+ * Stores the contents of every object on the board, for the next
+ * connection.
+ */
+void TelemetryMonitor::saveCache()
+{
+    QHash<quint32, QList<QByteArray>> cache;
+
+    foreach (UAVObjectManager::ObjectMap map, objMngr->getObjects().values()) {
+        if (!manifest.contains(map.first()->getObjID()))
+            continue;
+
+        QList<QByteArray> instances;
+
+        foreach (UAVObject *obj, map.values()) {
+            QByteArray data(obj->getNumBytes(), 0);
+            obj->pack(reinterpret_cast<quint8 *>(data.data()));
+            instances.append(data);
+        }
+
+        cache.insert(map.first()->getObjID(), instances);
+    }
+
+    QDir().mkpath(QFileInfo(cacheFileName).absolutePath());
+
+    QFile file(cacheFileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write object cache" << cacheFileName;
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << (quint32)OBJECT_CACHE_MAGIC << (quint32)OBJECT_CACHE_VERSION << cache;
+}
+
 /**
  * Retrieve the next object in the queue
  */
@@ -185,6 +468,14 @@ void TelemetryMonitor::retrieveNextObject()
                 .arg(Q_FUNC_INFO)
                 .arg(connectionStatus));
         connectionStatus = CON_CONNECTED_MANAGED;
+
+        qInfo() << QString("Retrieved objects in %1 ms, %2 from cache")
+                       .arg(retrieveTime.elapsed())
+                       .arg(objectsFromCache);
+
+        if (!manifest.isEmpty())
+            saveCache();
+
         emit connected();
         objectRetrieveTimeout->stop();
         return;
@@ -435,6 +726,7 @@ void TelemetryMonitor::processStatsUpdates()
     } else if (gcsStats.Status == GCSTelemetryStats::STATUS_DISCONNECTED && gcsStats.Status != oldStatus) {
         statsTimer->setInterval(STATS_CONNECT_PERIOD_MS);
         connectionStatus = CON_DISCONNECTED;
+        stopManifest();
         foreach (UAVObjectManager::ObjectMap map, objMngr->getObjects()) {
             foreach (UAVObject *obj, map.values()) {
                 UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
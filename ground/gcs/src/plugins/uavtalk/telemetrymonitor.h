@@ -37,6 +37,8 @@
 
 #include <queue>
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 #include <QTimer>
 #include <QTime>
@@ -74,12 +76,17 @@ public slots:
 private slots:
     void objectRetrieveTimeoutCB();
     void newInstanceSlot(UAVObject *);
+    void firmwareIAPCompleted(UAVObject *obj, bool success, bool nacked);
+    void manifestCompleted(UAVObject *obj, bool success, bool nacked);
+    void manifestUpdated(UAVObject *obj);
+    void manifestTimeoutCB();
 
 private:
     static const int STATS_UPDATE_PERIOD_MS = 1600;
     static const int STATS_CONNECT_PERIOD_MS = 350;
     static const int CONNECTION_TIMEOUT_MS = 8000;
     static const int MAX_REQUESTS_IN_FLIGHT = 3;
+    static const int MANIFEST_TIMEOUT_MS = 5000;
     enum connectionStatusEnum {
         CON_DISCONNECTED,
         CON_INITIALIZING,
@@ -87,6 +94,12 @@ private:
         CON_CONNECTED_MANAGED
     };
 
+    struct ManifestEntry
+    {
+        quint16 instances;
+        quint32 crc;
+    };
+
     typedef bool (*queueCompareFunc)(UAVObject *, UAVObject *);
     static bool queueCompare(UAVObject *left, UAVObject *right);
     connectionStatusEnum connectionStatus;
@@ -100,8 +113,22 @@ private:
     QTimer *objectRetrieveTimeout;
     int requestsInFlight;
 
+    // Object contents from previous connections, to skip fetching
+    // objects that did not change
+    QHash<quint32, ManifestEntry> manifest;
+    int manifestTotal;
+    QTimer *manifestTimeout;
+    QString cacheFileName;
+    int objectsFromCache;
+    QElapsedTimer retrieveTime;
+
     void startRetrievingObjects();
     void retrieveNextObject();
+    void enqueueAllObjects();
+    void stopManifest();
+    void applyManifest();
+    void saveCache();
+    static quint32 contentCRC(const QList<QByteArray> &instances);
 };
 
 #endif // TELEMETRYMONITOR_H
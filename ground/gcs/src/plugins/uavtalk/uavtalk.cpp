@@ -33,6 +33,7 @@
  */
 
 #include "uavtalk.h"
+#include "uavtalk_codec.h"
 #include <QtEndian>
 #include <QDebug>
 #include <extensionsystem/pluginmanager.h>
@@ -45,26 +46,7 @@
 #define UAVTALK_QXTLOG_DEBUG(...)
 #endif // UAVTALK_DEBUG
 
-#define SYNC_VAL 0x3C
-
-const quint8 UAVTalk::crc_table[256] = {
-    0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
-    0x70, 0x77, 0x7e, 0x79, 0x6c, 0x6b, 0x62, 0x65, 0x48, 0x4f, 0x46, 0x41, 0x54, 0x53, 0x5a, 0x5d,
-    0xe0, 0xe7, 0xee, 0xe9, 0xfc, 0xfb, 0xf2, 0xf5, 0xd8, 0xdf, 0xd6, 0xd1, 0xc4, 0xc3, 0xca, 0xcd,
-    0x90, 0x97, 0x9e, 0x99, 0x8c, 0x8b, 0x82, 0x85, 0xa8, 0xaf, 0xa6, 0xa1, 0xb4, 0xb3, 0xba, 0xbd,
-    0xc7, 0xc0, 0xc9, 0xce, 0xdb, 0xdc, 0xd5, 0xd2, 0xff, 0xf8, 0xf1, 0xf6, 0xe3, 0xe4, 0xed, 0xea,
-    0xb7, 0xb0, 0xb9, 0xbe, 0xab, 0xac, 0xa5, 0xa2, 0x8f, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9d, 0x9a,
-    0x27, 0x20, 0x29, 0x2e, 0x3b, 0x3c, 0x35, 0x32, 0x1f, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0d, 0x0a,
-    0x57, 0x50, 0x59, 0x5e, 0x4b, 0x4c, 0x45, 0x42, 0x6f, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7d, 0x7a,
-    0x89, 0x8e, 0x87, 0x80, 0x95, 0x92, 0x9b, 0x9c, 0xb1, 0xb6, 0xbf, 0xb8, 0xad, 0xaa, 0xa3, 0xa4,
-    0xf9, 0xfe, 0xf7, 0xf0, 0xe5, 0xe2, 0xeb, 0xec, 0xc1, 0xc6, 0xcf, 0xc8, 0xdd, 0xda, 0xd3, 0xd4,
-    0x69, 0x6e, 0x67, 0x60, 0x75, 0x72, 0x7b, 0x7c, 0x51, 0x56, 0x5f, 0x58, 0x4d, 0x4a, 0x43, 0x44,
-    0x19, 0x1e, 0x17, 0x10, 0x05, 0x02, 0x0b, 0x0c, 0x21, 0x26, 0x2f, 0x28, 0x3d, 0x3a, 0x33, 0x34,
-    0x4e, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5c, 0x5b, 0x76, 0x71, 0x78, 0x7f, 0x6a, 0x6d, 0x64, 0x63,
-    0x3e, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2c, 0x2b, 0x06, 0x01, 0x08, 0x0f, 0x1a, 0x1d, 0x14, 0x13,
-    0xae, 0xa9, 0xa0, 0xa7, 0xb2, 0xb5, 0xbc, 0xbb, 0x96, 0x91, 0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83,
-    0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
-};
+#define SYNC_VAL UAVTALK_CODEC_SYNC_VAL
 
 /**
  * Constructor
@@ -213,74 +195,33 @@ bool UAVTalk::receiveFileChunk(quint32 fileId, quint8 *data, quint32 length)
  */
 bool UAVTalk::processInput()
 {
-    unsigned int bytesAvail = filledBytes - startOffset;
+    struct uavtalk_frame frame;
+    size_t consumed;
 
-    if (bytesAvail < sizeof(UAVTalkHeader)) {
-        return false;
-    }
-
-    UAVTalkHeader *hdr = reinterpret_cast<UAVTalkHeader *>(rxBuffer + startOffset);
-
-    /* Basic framing checks.  If these fail, skip forward one byte and retry
-     * to capture stream sync.
+    /* The codec skips anything that can't start a frame and rejects frames
+     * that fail the framing checks or the CRC; either way it tells us how
+     * much of the buffer it is done with.
      */
-    if (hdr->sync != SYNC_VAL) {
-        startOffset++;
-        stats.rxErrors++;
-
-        return true;
-    }
-
-    if ((hdr->type & VER_MASK) != TYPE_VER) {
-        startOffset++;
-        stats.rxErrors++;
+    enum uavtalk_codec_result result =
+        uavtalk_codec_next(rxBuffer + startOffset, filledBytes - startOffset,
+                           MAX_PACKET_LENGTH - CHECKSUM_LENGTH, &frame, &consumed,
+                           &stats.rxErrors);
 
-        return true;
-    }
-
-    if (hdr->size < sizeof(UAVTalkHeader)) {
-        startOffset++;
-        stats.rxErrors++;
-
-        return true;
-    }
-
-    /* OK, let's ensure we have enough bytes for the whole frame.
-     * Size doesn't include CRC, so add one.
-     */
+    startOffset += consumed;
 
-    if ((hdr->size + 1u) > bytesAvail) {
+    if (result != UAVTALK_CODEC_FRAME) {
         return false;
     }
 
-    quint8 ourCrc = updateCRC(0, rxBuffer + startOffset, hdr->size);
-    quint8 *theirCrc = rxBuffer + startOffset + hdr->size;
-
-    if (ourCrc != *theirCrc) {
-        /* Since we can't trust hdr->size for sure, we should just skip
-         * forward one byte.
-         */
-
-        startOffset++;
-        stats.rxErrors++;
-
-        return true;
-    }
-
-    quint8 *payload = rxBuffer + startOffset + sizeof(*hdr);
-    unsigned int payloadBytes = hdr->size - sizeof(*hdr);
-
-    /* At this point, we'll advance startOffset for the entire length of
-     * frame, and not touch startOffset again this function!
-     */
-    startOffset += hdr->size + 1;
+    quint8 *payload = const_cast<quint8 *>(frame.body);
+    unsigned int payloadBytes = frame.body_len;
 
     /* OK, we have a complete frame as encoded on the wire.  Time to do things
      * with it.
      */
-    quint8 rxType = hdr->type & TYPE_MASK;
+    quint8 rxType = frame.type & TYPE_MASK;
 
-    quint32 rxObjId = qFromLittleEndian(hdr->objId);
+    quint32 rxObjId = frame.obj_id;
 
     if (rxType == TYPE_FILEDATA) {
         return receiveFileChunk(rxObjId, payload, payloadBytes);
@@ -575,7 +516,7 @@ bool UAVTalk::transmitFrame(quint32 length, bool incrTxObj)
     txBuffer[2] = length;
     txBuffer[3] = 0;
 
-    txBuffer[length] = updateCRC(0, txBuffer, length);
+    txBuffer[length] = uavtalk_crc8(0, txBuffer, length);
 
     // QFileDevice, used for saving logs, has quite a large buffer, we're not worried about it blocking
     bool blocked = canBlock && io->bytesToWrite() >= TX_BACKLOG_SIZE;
@@ -676,29 +617,3 @@ bool UAVTalk::transmitSingleObject(UAVObject *obj, quint8 type, bool allInstance
 
     return transmitFrame(dataOffset + length);
 }
-
-/**
- * Update the crc value with new data.
- *
- * Generated by pycrc v0.7.5, http://www.tty1.net/pycrc/
- * using the configuration:
- *    Width        = 8
- *    Poly         = 0x07
- *    XorIn        = 0x00
- *    ReflectIn    = False
- *    XorOut       = 0x00
- *    ReflectOut   = False
- *    Algorithm    = table-driven
- *
- * \param crc      The current crc value.
- * \param data     Pointer to a buffer of \a data_len bytes.
- * \param length   Number of bytes in the \a data buffer.
- * \return         The updated crc value.
- */
-
-quint8 UAVTalk::updateCRC(quint8 crc, const quint8 *data, qint32 length)
-{
-    while (length--)
-        crc = crc_table[crc ^ *data++];
-    return crc;
-}
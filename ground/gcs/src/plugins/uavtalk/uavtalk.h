@@ -110,18 +110,9 @@ protected:
     static const quint16 OBJID_NOTFOUND = 0x0000;
 
     static const int TX_BACKLOG_SIZE = 2 * 1024;
-    static const quint8 crc_table[256];
 
 #pragma pack(push)
 #pragma pack(1)
-    struct UAVTalkHeader {
-        quint8 sync;
-        quint8 type;
-        quint8 size;
-        quint8 resv;
-        quint32 objId;
-    };
-
     struct UAVTalkFileData {
         quint32 offset;
         quint8 flags;
@@ -157,7 +148,6 @@ protected:
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject *obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject *obj, quint8 type, bool allInstances);
-    quint8 updateCRC(quint8 crc, const quint8 *data, qint32 length);
     bool transmitFrame(quint32 length, bool incrTxObj = true);
 };
 
@@ -62,6 +62,9 @@ enum bl_commands {
     BL_MSG_STATUS_REQ,
     BL_MSG_STATUS_REP,
     BL_MSG_WIPE_PARTITION,
+    BL_MSG_SECTOR_CRC_REQ,
+    BL_MSG_SECTOR_CRC_REP,
+    BL_MSG_WRITE_SPARSE_START,
 
     BL_MSG_WRITE_START =
         0x27, // f1 bl masks with 0b11111 so this looks like BL_MSG_WRITE_CONT there
@@ -176,7 +179,7 @@ PACK(struct msg_xfer_start {
 #define XFER_BYTES_PER_PACKET 56
 struct msg_xfer_cont
 {
-    uint32_t current_packet_number;
+    uint32_t current_packet_number; /* byte offset in sparse writes */
     uint8_t data[XFER_BYTES_PER_PACKET];
 };
 
@@ -196,6 +199,24 @@ struct msg_wipe_partition
     uint8_t label;
 };
 
+struct msg_sector_crc_req
+{
+    uint8_t label;
+};
+
+#define SECTOR_CRCS_PER_PACKET 7
+PACK(struct msg_sector_crc_rep {
+    uint8_t label;
+    uint8_t num_sectors; /* entries used in this packet */
+    uint16_t first_sector; /* sector of the first entry */
+    uint16_t total_sectors; /* sectors in the partition */
+    struct
+    {
+        uint32_t size;
+        uint32_t crc;
+    } sectors[SECTOR_CRCS_PER_PACKET];
+});
+
 PACK(union msg_contents {
     struct msg_capabilities_req cap_req;
     struct msg_capabilities_rep_all cap_rep_all;
@@ -210,6 +231,8 @@ PACK(union msg_contents {
     struct msg_status_req status_req;
     struct msg_status_rep status_rep;
     struct msg_wipe_partition wipe_partition;
+    struct msg_sector_crc_req sector_crc_req;
+    struct msg_sector_crc_rep sector_crc_rep;
     uint8_t pad[62];
 });
 
@@ -76,14 +76,16 @@ bool DFUObject::EnterDFU()
   @param numberOfByte number of bytes of the transfer
   @param label partition where the data will be uploaded to
   @param crc crc value of the data to be uploaded
+  @param sparse whether packets will be addressed by offset and sectors
+  erased as they are reached, rather than erasing everything first
   @returns result of the requested operation
   */
 bool DFUObject::StartUpload(qint32 const &numberOfBytes, dfu_partition_label const &label,
-                            quint32 crc)
+                            quint32 crc, bool sparse)
 {
     messagePackets msg = CalculatePadding(numberOfBytes);
     bl_messages message;
-    message.flags_command = BL_MSG_WRITE_START;
+    message.flags_command = sparse ? BL_MSG_WRITE_SPARSE_START : BL_MSG_WRITE_START;
     message.v.xfer_start.expected_crc = ntohl(crc);
     message.v.xfer_start.packets_in_transfer = ntohl(msg.numberOfPackets);
     message.v.xfer_start.words_in_last_packet = msg.lastPacketCount;
@@ -94,9 +96,11 @@ bool DFUObject::StartUpload(qint32 const &numberOfBytes, dfu_partition_label con
                             .arg(msg.lastPacketCount));
 
     int result = SendData(message);
-    QEventLoop m_eventloop;
-    QTimer::singleShot(500, &m_eventloop, &QEventLoop::quit);
-    m_eventloop.exec();
+    if (!sparse) {
+        QEventLoop m_eventloop;
+        QTimer::singleShot(500, &m_eventloop, &QEventLoop::quit);
+        m_eventloop.exec();
+    }
     TL_DFU_QXTLOG_DEBUG(QString("%0 bytes sent").arg(result));
     if (result > 0)
         return true;
@@ -139,6 +143,129 @@ bool DFUObject::UploadData(qint32 const &numberOfBytes, QByteArray &data)
     return true;
 }
 
+/**
+  Asks the bootloader for the size and CRC of each flash sector that a
+  write to a partition covers. Bootloaders that predate this don't answer.
+  @param label partition to check
+  @param sectors filled with the sectors, in order
+  @returns true if the bootloader reported every sector
+  */
+bool DFUObject::SectorCRCs(dfu_partition_label label, QVector<sectorCRC> &sectors)
+{
+    sectors.clear();
+
+    bl_messages message;
+    memset(&message, 0, sizeof(message));
+    message.flags_command = BL_MSG_SECTOR_CRC_REQ;
+    message.v.sector_crc_req.label = label;
+
+    if (SendData(message) < 1)
+        return false;
+
+    int totalSectors = -1;
+
+    while (sectors.size() != totalSectors) {
+        if ((ReceiveData(message, 1000) < 1) || (message.flags_command != BL_MSG_SECTOR_CRC_REP)
+            || (message.v.sector_crc_rep.label != label)
+            || (ntohs(message.v.sector_crc_rep.first_sector) != sectors.size())
+            || (message.v.sector_crc_rep.num_sectors > SECTOR_CRCS_PER_PACKET)) {
+            TL_DFU_QXTLOG_DEBUG("No sector CRCs, probably using old bootloader");
+
+            // Drain out any replies still on their way
+            for (int i = 0; i < 100; i++) {
+                if (ReceiveData(message, 200) <= 0)
+                    break;
+            }
+
+            sectors.clear();
+            return false;
+        }
+
+        totalSectors = ntohs(message.v.sector_crc_rep.total_sectors);
+
+        for (int i = 0; i < message.v.sector_crc_rep.num_sectors; i++) {
+            sectorCRC sector;
+            sector.size = ntohl(message.v.sector_crc_rep.sectors[i].size);
+            sector.crc = ntohl(message.v.sector_crc_rep.sectors[i].crc);
+            sectors.append(sector);
+        }
+    }
+
+    return true;
+}
+
+/**
+  Writes the sectors of an image that differ from the board, following a
+  sparse StartUpload. The bootloader erases each sector when its first
+  packet arrives, so later packets that are all erased bytes are skipped
+  as well. Packets are streamed without waiting for replies; USB flow
+  control holds them back while the board erases.
+  @param image data to write, padded with 0xFF to the size of the partition
+  @param sectors sector sizes and CRCs from SectorCRCs
+  @returns result of the requested operation
+  */
+bool DFUObject::UploadSectors(QByteArray &image, const QVector<sectorCRC> &sectors)
+{
+    // Work out what to send first, so that progress can be reported
+    QVector<QPair<quint32, quint32>> packets;
+    quint32 rangeEnd = image.length();
+    quint32 sectorOffset = 0;
+    int changedSectors = 0;
+
+    foreach (const sectorCRC &sector, sectors) {
+        if (sectorOffset >= rangeEnd)
+            break;
+
+        quint32 sectorEnd = sectorOffset + sector.size;
+        quint32 end = qMin(sectorEnd, rangeEnd);
+
+        // A sector that runs past the partition also holds something written
+        // separately (the firmware description), which needs it erased.
+        if ((sectorEnd <= rangeEnd)
+            && (CRCFromQBArray(image.mid(sectorOffset, end - sectorOffset), end - sectorOffset)
+                == sector.crc)) {
+            sectorOffset = sectorEnd;
+            continue;
+        }
+
+        changedSectors++;
+
+        for (quint32 offset = sectorOffset; offset < end; offset += XFER_BYTES_PER_PACKET) {
+            quint32 len = qMin(end - offset, (quint32)XFER_BYTES_PER_PACKET);
+
+            if ((offset != sectorOffset) && (image.mid(offset, len).count((char)0xFF) == (int)len))
+                continue;
+
+            packets.append(qMakePair(offset, len));
+        }
+
+        sectorOffset = sectorEnd;
+    }
+
+    TL_DFU_QXTLOG_DEBUG(QString("Writing %0 of %1 sectors, %2 56 byte packets")
+                            .arg(changedSectors)
+                            .arg(sectors.size())
+                            .arg(packets.size()));
+
+    bl_messages message;
+    message.flags_command = BL_MSG_WRITE_CONT;
+    int laspercentage = 0;
+    for (int i = 0; i < packets.size(); i++) {
+        int percentage = (i + 1) * 100 / packets.size();
+        if (laspercentage != percentage)
+            emit operationProgress("", percentage);
+        laspercentage = percentage;
+
+        message.v.xfer_cont.current_packet_number = ntohl(packets[i].first);
+        CopyWords(image.data() + packets[i].first,
+                  reinterpret_cast<char *>(message.v.xfer_cont.data), packets[i].second);
+        int result = SendData(message);
+        if (result < 1)
+            return false;
+    }
+    return true;
+}
+
 /**
   Downloads the description string for the current device.
   You have to call enterDFU before calling this function.
@@ -584,14 +711,25 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
     quint32 crc = DFUObject::CRCFromQBArray(sourceArray, threadJob.partition_size);
     TL_DFU_QXTLOG_DEBUG(QString("NEW FIRMWARE CRC=%0").arg(crc));
 
-    if (!StartUpload(sourceArray.length(), partition, crc)) {
+    // If the bootloader can report what is already in flash, only write
+    // the sectors that differ
+    QVector<sectorCRC> sectors;
+    QByteArray image;
+    bool sparse = (partition != DFU_PARTITION_DESC) && SectorCRCs(partition, sectors);
+    if (sparse) {
+        image = sourceArray;
+        image.append(QByteArray(threadJob.partition_size - image.length(), 255));
+    }
+
+    if (!StartUpload(sparse ? image.length() : sourceArray.length(), partition, crc, sparse)) {
         ret = StatusRequest();
         qDebug() << QString("[tl_dfu] StartUpload failed, status: %1, additional: 0x%2")
                         .arg(StatusToString(ret.status))
                         .arg(ret.additional, 8, 16, QChar('0'));
         return ret.status;
     }
-    emit operationProgress(QString("Erasing, please wait..."), -1);
+    if (!sparse)
+        emit operationProgress(QString("Erasing, please wait..."), -1);
 
     TL_DFU_QXTLOG_DEBUG("Erasing memory");
     if (StatusRequest().status == tl_dfu::abort) {
@@ -614,7 +752,7 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
     emit operationProgress(
         QString(tr("Uploading %0 partition...")).arg(partitionStringFromLabel(partition)), -1);
 
-    if (!UploadData(sourceArray.length(), sourceArray)) {
+    if (sparse ? !UploadSectors(image, sectors) : !UploadData(sourceArray.length(), sourceArray)) {
         ret = StatusRequest();
         qDebug() << QString("[tl_dfu] UploadData failed, status: %1, additional: 0x%2")
                         .arg(StatusToString(ret.status))
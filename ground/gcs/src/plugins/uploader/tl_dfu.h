@@ -73,6 +73,12 @@ struct device
     bool CapExt;
 };
 
+struct sectorCRC
+{
+    quint32 size;
+    quint32 crc;
+};
+
 class DFUObject : public QThread
 {
     Q_OBJECT
@@ -139,8 +145,11 @@ private:
     int ReceiveData(bl_messages &data, int timeoutMS = 10000);
     hid_device *m_hidHandle;
 
-    bool StartUpload(qint32 const &numberOfBytes, const dfu_partition_label &label, quint32 crc);
+    bool StartUpload(qint32 const &numberOfBytes, const dfu_partition_label &label, quint32 crc,
+                     bool sparse = false);
     bool UploadData(qint32 const &numberOfPackets, QByteArray &data);
+    bool SectorCRCs(dfu_partition_label label, QVector<sectorCRC> &sectors);
+    bool UploadSectors(QByteArray &image, const QVector<sectorCRC> &sectors);
 
     typedef struct ThreadJobStruc
     {
@@ -26,6 +26,9 @@
 # Flags passed to the preprocessor.
 CPPFLAGS += -I$(GTEST_DIR)/include
 
+# Helpers shared by the unit tests
+CPPFLAGS += -I$(ROOT_DIR)/flight/tests/include
+
 # Flags passed to the C++ compiler.
 CXXFLAGS += -g -Wall -Wextra -Wno-missing-field-initializers
 
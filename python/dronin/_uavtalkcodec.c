@@ -0,0 +1,96 @@
+/*
+ * Native helpers for the uavtalk module, built from the UAVTalk codec the
+ * firmware and GCS share: the checksum, and finding frames in a stream.
+ *
+ * Copyright (C) 2017 dRonin, http://dronin.org
+ *
+ * Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "uavtalk_codec.h"
+
+static PyObject *codec_crc8(PyObject *self, PyObject *args)
+{
+	Py_buffer data;
+	unsigned char crc = 0;
+
+	if (!PyArg_ParseTuple(args, "y*|b", &data, &crc)) {
+		return NULL;
+	}
+
+	crc = uavtalk_crc8(crc, data.buf, data.len);
+
+	PyBuffer_Release(&data);
+
+	return PyLong_FromLong(crc);
+}
+
+static PyObject *codec_next_frame(PyObject *self, PyObject *args)
+{
+	Py_buffer data;
+	Py_ssize_t offset = 0;
+	unsigned short max_size = 0xffff;
+	struct uavtalk_frame frame;
+	size_t consumed;
+	enum uavtalk_codec_result result;
+
+	if (!PyArg_ParseTuple(args, "y*|nH", &data, &offset, &max_size)) {
+		return NULL;
+	}
+
+	if (offset < 0 || offset > data.len) {
+		PyBuffer_Release(&data);
+		PyErr_SetString(PyExc_ValueError, "offset out of range");
+		return NULL;
+	}
+
+	const uint8_t *start = (const uint8_t *) data.buf + offset;
+
+	Py_BEGIN_ALLOW_THREADS
+	result = uavtalk_codec_next(start, data.len - offset, max_size,
+			&frame, &consumed, NULL);
+	Py_END_ALLOW_THREADS
+
+	PyBuffer_Release(&data);
+
+	if (result != UAVTALK_CODEC_FRAME) {
+		return Py_BuildValue("(nO)", offset + (Py_ssize_t) consumed,
+				Py_None);
+	}
+
+	/* Offsets only: the buffer is released, and the caller has it */
+	Py_ssize_t frame_start = offset + (frame.body - start) -
+		UAVTALK_CODEC_HEADER_LENGTH;
+
+	return Py_BuildValue("(n(nBHk))", offset + (Py_ssize_t) consumed,
+			frame_start, frame.type, frame.size,
+			(unsigned long) frame.obj_id);
+}
+
+static PyMethodDef codec_methods[] = {
+	{ "crc8", codec_crc8, METH_VARARGS,
+		"crc8(data, crc=0)\n\nUpdate a UAVTalk checksum with data." },
+	{ "next_frame", codec_next_frame, METH_VARARGS,
+		"next_frame(data, offset=0, max_size=65535)\n\n"
+		"Find the next frame from offset whose version, size and checksum\n"
+		"check out.  Returns (consumed, frame): consumed is the offset the\n"
+		"caller is done with data up to, and frame is None or\n"
+		"(start, type, size, obj_id), with size excluding the checksum." },
+	{ NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef codec_module = {
+	PyModuleDef_HEAD_INIT,
+	"_uavtalkcodec",
+	"Native UAVTalk codec helpers",
+	-1,
+	codec_methods
+};
+
+PyMODINIT_FUNC PyInit__uavtalkcodec(void)
+{
+	return PyModule_Create(&codec_module);
+}
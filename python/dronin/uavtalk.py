@@ -187,6 +187,17 @@ class process_stream:
 
                     yield None
 
+                if next_frame is not None and self.gcs_timestamps == False:
+                    # Skip straight to the next frame that checks out, or
+                    # to where one might still start.  With gcs timestamps
+                    # the log header before it would be skipped too.
+                    (consumed, frame) = next_frame(self.buf, self.buf_offset,
+                            MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH)
+
+                    self.buf_offset = consumed if frame is None else frame[0]
+
+                    continue
+
                 try:
                     self.buf_offset = self.buf.index(SYNC_VAL, self.buf_offset)
                 except ValueError:
@@ -413,3 +424,10 @@ def calcCRC(s):
         cs = crc_table[cs ^ c]
 
     return cs
+
+try:
+    # Same thing, from the codec the firmware and GCS share
+    from ._uavtalkcodec import crc8 as calcCRC
+    from ._uavtalkcodec import next_frame
+except ImportError:
+    next_frame = None
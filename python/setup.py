@@ -5,7 +5,7 @@ https://github.com/pypa/sampleproject
 """
 
 # Always prefer setuptools over distutils
-from setuptools import setup, find_packages
+from setuptools import setup, find_packages, Extension
 # To use a consistent encoding
 from codecs import open
 from os import path
@@ -74,6 +74,15 @@ setup(
     # simple. Or you can use find_packages().
     packages = ['dronin', 'dronin.logviewer'],
 
+    # The checksum is also available natively, from the codec the firmware
+    # and GCS share.  It's optional: uavtalk falls back to pure python.
+    ext_modules = [
+        Extension('dronin._uavtalkcodec',
+            sources = [ 'dronin/_uavtalkcodec.c' ],
+            include_dirs = [ path.join(here, '..', 'shared', 'api') ],
+            optional = True),
+    ],
+
     # Just requires the base python system to run
     install_requires=[],
 
@@ -85,7 +94,7 @@ setup(
 
     scripts = [ 'dronin-dumplog', 'dronin-halt',
         'dronin-getconfig', 'dronin-logfsimport',
-        'dronin-shell' ],
+        'dronin-shell', 'dronin-profile' ],
 #    package_data={
 #        'sample': ['package_data.dat'],
 #    },